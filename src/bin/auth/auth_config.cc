@@ -16,19 +16,28 @@
 #include <dns/rrclass.h>
 
 #include <cc/data.h>
+#include <acl/dns.h>
+#include <acl/loader.h>
 
 #include <datasrc/factory.h>
 
 #include <auth/auth_srv.h>
 #include <auth/auth_config.h>
 #include <auth/common.h>
+#include <auth/rrl.h>
+#include <auth/answer_cache.h>
+#include <auth/xfrout.h>
 
 #include <server_common/portconfig.h>
 
+#include <util/random/random_number_generator.h>
+
 #include <boost/foreach.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <ctime>
+#include <limits>
 #include <set>
 #include <string>
 #include <utility>
@@ -137,6 +146,180 @@ private:
     size_t timeout_;
 };
 
+/// \brief Configuration for the number of query worker threads
+class QueryThreadsConfig : public AuthConfigParser {
+public:
+    QueryThreadsConfig(AuthSrv& server) : server_(server), threads_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        const int64_t threads = config->intValue();
+        if (threads < 0 || threads > MAX_QUERY_THREADS) {
+            bundy_throw(AuthConfigError, "query_threads must be between 0 and "
+                        << MAX_QUERY_THREADS << ", not " << threads);
+        }
+        threads_ = threads;
+    }
+
+    virtual void commit() {
+        server_.setQueryThreads(threads_);
+    }
+private:
+    // A sanity limit; much more threads than CPU cores wouldn't help anyway.
+    static const int64_t MAX_QUERY_THREADS = 256;
+
+    AuthSrv& server_;
+    size_t threads_;
+};
+
+/// \brief Configuration for response rate limiting
+///
+/// It constructs a new \c ResponseLimiter in build() if it's enabled, and
+/// replaces the server's limiter with it (or disables the limiting) in
+/// commit().  Any missing parameter is set to its default.  Note that
+/// reconfiguration always starts with a new, empty table of responses.
+class ResponseRateLimitingConfig : public AuthConfigParser {
+public:
+    ResponseRateLimitingConfig(AuthSrv& server) : server_(server)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        limiter_.reset();
+        if (!getBool(config, "enable", false)) {
+            return;
+        }
+        bundy::util::random::UniformRandomIntegerGenerator
+            rng(0, std::numeric_limits<int>::max());
+        try {
+            limiter_.reset(new bundy::auth::ResponseLimiter(
+                               getInt(config, "responses_per_second", 5),
+                               getInt(config, "nxdomains_per_second", 5),
+                               getInt(config, "errors_per_second", 5),
+                               getInt(config, "window", 15),
+                               getInt(config, "slip", 2),
+                               getInt(config, "max_table_size", 20000),
+                               getInt(config, "ipv4_prefix_length", 24),
+                               getInt(config, "ipv6_prefix_length", 56),
+                               getBool(config, "log_only", false),
+                               std::time(NULL), rng()));
+        } catch (const bundy::InvalidParameter& ex) {
+            bundy_throw(AuthConfigError, "Invalid response_rate_limiting: "
+                        << ex.what());
+        }
+    }
+
+    virtual void commit() {
+        server_.setResponseLimiter(limiter_);
+    }
+private:
+    static int getInt(ConstElementPtr config, const string& name,
+                      int default_value)
+    {
+        ConstElementPtr value = config->get(name);
+        if (!value) {
+            return (default_value);
+        }
+        const int64_t intvalue = value->intValue();
+        if (intvalue < 0 || intvalue > std::numeric_limits<int>::max()) {
+            bundy_throw(AuthConfigError, "response_rate_limiting/" << name
+                        << " out of range: " << intvalue);
+        }
+        return (intvalue);
+    }
+
+    static bool getBool(ConstElementPtr config, const string& name,
+                        bool default_value)
+    {
+        ConstElementPtr value = config->get(name);
+        return (value ? value->boolValue() : default_value);
+    }
+
+    AuthSrv& server_;
+    boost::shared_ptr<bundy::auth::ResponseLimiter> limiter_;
+};
+
+/// \brief Configuration for the answer cache
+///
+/// A positive value specifies the maximum number of cached answers; 0
+/// disables the cache.  Like RRL, reconfiguration always starts with a
+/// new, empty cache.
+class AnswerCacheSizeConfig : public AuthConfigParser {
+public:
+    AnswerCacheSizeConfig(AuthSrv& server) : server_(server)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        cache_.reset();
+        const int64_t size = config->intValue();
+        if (size < 0 || size > MAX_ANSWER_CACHE_SIZE) {
+            bundy_throw(AuthConfigError, "answer_cache_size must be between "
+                        "0 and " << MAX_ANSWER_CACHE_SIZE << ", not " << size);
+        }
+        if (size > 0) {
+            cache_.reset(new bundy::auth::AnswerCache(size));
+        }
+    }
+
+    virtual void commit() {
+        server_.setAnswerCache(cache_);
+    }
+private:
+    // A sanity limit to catch obvious typos
+    static const int64_t MAX_ANSWER_CACHE_SIZE = 100000000;
+
+    AuthSrv& server_;
+    boost::shared_ptr<bundy::auth::AnswerCache> cache_;
+};
+
+/// \brief Configuration for native outgoing zone transfers
+///
+/// Unless enabled, transfer requests are forwarded to bundy-xfrout as
+/// before.  The parameters have the same meaning as the corresponding
+/// ones of bundy-xfrout.
+class NativeXfroutConfig : public AuthConfigParser {
+public:
+    NativeXfroutConfig(AuthSrv& server) : server_(server)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        config_.reset();
+        ConstElementPtr enable = config->get("enable");
+        if (!enable || !enable->boolValue()) {
+            return;
+        }
+        ConstElementPtr max_transfers = config->get("max_transfers_out");
+        const int64_t max_value = max_transfers ?
+            max_transfers->intValue() : DEFAULT_MAX_TRANSFERS;
+        if (max_value <= 0 || max_value > MAX_MAX_TRANSFERS) {
+            bundy_throw(AuthConfigError, "native_xfrout/max_transfers_out "
+                        "must be between 1 and " << MAX_MAX_TRANSFERS <<
+                        ", not " << max_value);
+        }
+        ConstElementPtr acl_config = config->get("transfer_acl");
+        boost::shared_ptr<const bundy::acl::dns::RequestACL> acl;
+        try {
+            acl = bundy::acl::dns::getRequestLoader().load(
+                acl_config ? acl_config :
+                Element::fromJSON("[{\"action\": \"ACCEPT\"}]"));
+        } catch (const bundy::acl::LoaderError& ex) {
+            bundy_throw(AuthConfigError, "Invalid native_xfrout/transfer_acl: "
+                        << ex.what());
+        }
+        config_.reset(new bundy::auth::XfroutConfig(max_value, acl));
+    }
+
+    virtual void commit() {
+        server_.setXfroutConfig(config_);
+    }
+private:
+    static const int64_t DEFAULT_MAX_TRANSFERS = 10;
+    // A sanity limit; each transfer uses a thread
+    static const int64_t MAX_MAX_TRANSFERS = 1000;
+
+    AuthSrv& server_;
+    boost::shared_ptr<const bundy::auth::XfroutConfig> config_;
+};
+
 } // end of unnamed namespace
 
 AuthConfigParser*
@@ -170,6 +353,14 @@ createAuthConfigParser(AuthSrv& server, const std::string& config_id) {
         return (new VersionConfig());
     } else if (config_id == "tcp_recv_timeout") {
         return (new TCPRecvTimeoutConfig(server));
+    } else if (config_id == "query_threads") {
+        return (new QueryThreadsConfig(server));
+    } else if (config_id == "response_rate_limiting") {
+        return (new ResponseRateLimitingConfig(server));
+    } else if (config_id == "answer_cache_size") {
+        return (new AnswerCacheSizeConfig(server));
+    } else if (config_id == "native_xfrout") {
+        return (new NativeXfroutConfig(server));
     } else {
         bundy_throw(AuthConfigError, "Unknown configuration identifier: " <<
                     config_id);
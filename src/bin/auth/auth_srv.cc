@@ -34,6 +34,7 @@
 #include <dns/name.h>
 #include <dns/question.h>
 #include <dns/opcode.h>
+#include <dns/parsed_query.h>
 #include <dns/rcode.h>
 #include <dns/rrset.h>
 #include <dns/rrttl.h>
@@ -42,8 +43,12 @@
 
 #include <asiodns/dns_service.h>
 
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
 #include <datasrc/exceptions.h>
 #include <datasrc/client_list.h>
+#include <server_common/client.h>
 
 #include <auth/common.h>
 #include <auth/auth_config.h>
@@ -52,19 +57,29 @@
 #include <auth/statistics.h>
 #include <auth/auth_log.h>
 #include <auth/datasrc_clients_mgr.h>
+#include <auth/rrl.h>
+#include <auth/answer_cache.h>
+#include <auth/xfrout.h>
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <ctime>
 #include <iostream>
+#include <list>
 #include <vector>
 #include <memory>
 
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -84,6 +99,8 @@ using namespace bundy::asiodns;
 using namespace bundy::server_common::portconfig;
 using bundy::auth::statistics::Counters;
 using bundy::auth::statistics::MessageAttributes;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
 
 namespace {
 // A helper class for cleaning up message renderer.
@@ -129,6 +146,22 @@ private:
     Message& message_;
 };
 
+// Let the answer cache check the zone generations of the data source
+// clients manager.  The zone IDs are those of DataGenerations.
+class AnswerCacheGenerations : public AnswerCache::Generations {
+public:
+    explicit AnswerCacheGenerations(const DataGenerations& generations) :
+        generations_(generations)
+    {}
+
+    virtual uint64_t getGeneration(size_t zone_id) const {
+        return (generations_.getZoneGeneration(zone_id));
+    }
+
+private:
+    const DataGenerations& generations_;
+};
+
 // A helper container of socket session forwarder.
 //
 // This class provides a simple wrapper interface to SocketSessionForwarder
@@ -229,6 +262,58 @@ private:
         }
     }
 };
+
+// Scratch objects used for processing queries.
+//
+// The main thread and each query worker thread (if any) have their own
+// instance of this class, so the objects can be reused from query to query
+// without locking.  Statistics counters are sharded the same way; the mutex
+// only protects a shard from being read by the main thread (on getstats)
+// while the owner thread updates it, so it's effectively never contended.
+struct QueryContext : boost::noncopyable {
+    MessageRenderer renderer_;
+    auth::Query query_;
+    Counters counters_;
+    Mutex counters_mutex_;
+};
+
+// The list of (fd, address family) pairs of the UDP listening sockets.
+typedef vector<pair<int, int> > UDPSocketList;
+
+// A wrapper of DNSServiceBase to remember the UDP sockets.
+//
+// All requests are delegated to the underlying service, and, in addition,
+// the file descriptors of the UDP sockets are recorded so the query worker
+// threads can create their own UDP servers on the same sockets.
+class UDPSocketRecorder : public DNSServiceBase {
+public:
+    UDPSocketRecorder(DNSServiceBase& base, UDPSocketList& udp_sockets) :
+        base_(base), udp_sockets_(udp_sockets)
+    {}
+    virtual void addServerTCPFromFD(int fd, int af) {
+        base_.addServerTCPFromFD(fd, af);
+    }
+    virtual void addServerUDPFromFD(int fd, int af, ServerFlag options) {
+        base_.addServerUDPFromFD(fd, af, options);
+        udp_sockets_.push_back(pair<int, int>(fd, af));
+    }
+    virtual void clearServers() {
+        base_.clearServers();
+        udp_sockets_.clear();
+    }
+    virtual void setTCPRecvTimeout(size_t timeout) {
+        base_.setTCPRecvTimeout(timeout);
+    }
+    virtual IOService& getIOService() {
+        return (base_.getIOService());
+    }
+private:
+    DNSServiceBase& base_;
+    UDPSocketList& udp_sockets_;
+};
+
+class QueryWorker;
+class XfroutWorker;
 }
 
 class AuthSrvImpl {
@@ -240,24 +325,82 @@ public:
     AuthSrvImpl(BaseSocketSessionForwarder& xfrout_forwarder,
                 BaseSocketSessionForwarder& ddns_forwarder);
 
-    bool processNormalQuery(const IOMessage& io_message,
+    void processMessage(QueryContext& context, const IOMessage& io_message,
+                        Message& message, OutputBuffer& buffer,
+                        DNSServer* server);
+    bool processNormalQuery(QueryContext& context,
+                            const IOMessage& io_message,
                             ConstEDNSPtr remote_edns, Message& message,
                             OutputBuffer& buffer,
                             unique_ptr<TSIGContext> tsig_context,
                             MessageAttributes& stats_attrs);
-    bool processXfrQuery(const IOMessage& io_message, Message& message,
-                         OutputBuffer& buffer,
+    bool processXfrQuery(QueryContext& context, const IOMessage& io_message,
+                         Message& message, OutputBuffer& buffer,
                          unique_ptr<TSIGContext> tsig_context,
                          MessageAttributes& stats_attrs);
-    bool processNotify(const IOMessage& io_message, Message& message,
-                       OutputBuffer& buffer,
+    bool processNotify(QueryContext& context, const IOMessage& io_message,
+                       Message& message, OutputBuffer& buffer,
                        unique_ptr<TSIGContext> tsig_context,
                        MessageAttributes& stats_attrs);
     bool processUpdate(const IOMessage& io_message);
 
+    /// \brief Check the response to a normal query with the response
+    /// rate limiter.
+    ///
+    /// The response type in terms of RRL is determined from the Rcode of
+    /// \c message, so it must have been set.  If RRL is disabled it always
+    /// returns \c RRL_OK.
+    RRLResult limitResponse(const IOMessage& io_message,
+                            const Message& message);
+
+    /// \brief Check a response with the response rate limiter, with the
+    /// RRL parameters given explicitly.
+    RRLResult limitResponse(const IOMessage& io_message,
+                            const RRClass& qclass, const RRType& qtype,
+                            const Name* name,
+                            detail::ResponseType resp_type);
+
+    /// \brief Try to answer a query from the answer cache.
+    ///
+    /// This is the fast path of ordinary queries: the query is examined
+    /// with \c ParsedQuery, without building the question or other
+    /// sections in \c message.  If the answer cache has an answer for it,
+    /// the answer is copied to \c buffer with the header adjusted for the
+    /// query.  \c message and \c stats_attrs are then set up for
+    /// statistics as if the query was processed normally, and the response
+    /// is checked with the response rate limiter.
+    ///
+    /// \return true if the query has been handled, in which case
+    /// \c send_answer indicates whether \c buffer should be sent;
+    /// false if the query needs to be processed normally.
+    bool processCachedQuery(QueryContext& context,
+                            const IOMessage& io_message, Message& message,
+                            OutputBuffer& buffer,
+                            MessageAttributes& stats_attrs,
+                            bool& send_answer);
+
+    /// \brief Start the query worker threads.
+    ///
+    /// It creates \c query_threads_ workers, each serving the currently
+    /// recorded UDP sockets.  If no UDP socket is open, no worker is
+    /// created as it wouldn't have anything to do.  A failure in starting
+    /// a worker is logged and the server keeps running with the workers
+    /// created so far (at worst, only with the main thread).
+    void startWorkers();
+
+    /// \brief Stop and destroy all query worker threads.
+    void stopWorkers();
+
+    /// \brief Destroy the zone transfer workers that have finished.
+    void reapXfroutWorkers();
+
+    /// \brief Schedule \c reapXfroutWorkers() in the main thread.
+    ///
+    /// It's called by each zone transfer worker when it's finished.
+    void xfroutWorkerDone();
+
     IOService io_service_;
 
-    MessageRenderer renderer_;
     /// Currently non-configurable, but will be.
     static const uint16_t DEFAULT_LOCAL_UDPSIZE = 4096;
 
@@ -265,12 +408,15 @@ public:
     ModuleCCSession* config_session_;
     AbstractSession* xfrin_session_;
 
-    /// Query counters for statistics
-    Counters counters_;
+    /// Scratch objects and query counters for the main thread
+    QueryContext main_context_;
 
     /// Addresses we listen on
     AddressList listen_addresses_;
 
+    /// UDP sockets we listen on, shared with the query workers
+    UDPSocketList udp_sockets_;
+
     /// The TSIG keyring
     const boost::shared_ptr<TSIGKeyRing>* keyring_;
 
@@ -287,6 +433,10 @@ public:
     /// bundy-ddns is not running
     boost::scoped_ptr<SocketSessionForwarderHolder> ddns_forwarder_;
 
+    /// Mutex to protect xfrin_session_ and the socket session forwarders,
+    /// which can be used from the query worker threads.
+    Mutex session_mutex_;
+
     /// \brief Resume the server
     ///
     /// This is a wrapper call for DNSServer::resume(done). Query/Response
@@ -294,43 +444,81 @@ public:
     ///
     /// This method is expected to be called by processMessage()
     ///
+    /// \param context The query context of the calling thread
     /// \param server The DNSServer as passed to processMessage()
     /// \param message The response as constructed by processMessage()
     /// \param stats_attrs Object to store message attributes in for use
     ///                    with statistics
     /// \param done If true, it indicates there is a response.
     ///             this value will be passed to server->resume(bool)
-    void resumeServer(bundy::asiodns::DNSServer* server,
+    void resumeServer(QueryContext& context,
+                      bundy::asiodns::DNSServer* server,
                       bundy::dns::Message& message,
                       MessageAttributes& stats_attrs,
                       const bool done);
 
+    /// The response rate limiter; empty if RRL is disabled
+    boost::shared_ptr<ResponseLimiter> response_limiter_;
+
+    /// The cache of rendered answers; empty if it's disabled
+    boost::shared_ptr<AnswerCache> answer_cache_;
+
+    /// The EDNS of responses, without and with the DO bit.  They are
+    /// immutable and shared by all responses to save allocating them.
+    ConstEDNSPtr response_edns_[2];
+
     /// Are we currently subscribed to the SegmentReader group?
     bool readers_group_subscribed_;
-private:
-    auth::Query query_;
+
+    /// The configuration of native outgoing zone transfers; empty if
+    /// transfer requests are forwarded to bundy-xfrout
+    boost::shared_ptr<const XfroutConfig> xfrout_config_;
+
+    /// The outgoing zone transfers in progress (or finished but not yet
+    /// cleaned up), handled by the server itself
+    std::list<boost::shared_ptr<XfroutWorker> > xfrout_workers_;
+
+    /// Mutex to protect xfrout_workers_
+    Mutex xfrout_mutex_;
+
+    /// Number of query worker threads in addition to the main thread
+    size_t query_threads_;
+
+    /// The query worker threads.  This must be the last member so the
+    /// workers are stopped before anything they refer to is destroyed.
+    vector<boost::shared_ptr<QueryWorker> > workers_;
 };
 
 AuthSrvImpl::AuthSrvImpl(BaseSocketSessionForwarder& xfrout_forwarder,
                          BaseSocketSessionForwarder& ddns_forwarder) :
     config_session_(NULL),
     xfrin_session_(NULL),
-    counters_(),
     keyring_(NULL),
     datasrc_clients_mgr_(io_service_),
     xfrout_forwarder_(new SocketSessionForwarderHolder("xfrout",
                                                        xfrout_forwarder)),
     ddns_base_forwarder_(ddns_forwarder),
     ddns_forwarder_(NULL),
-    readers_group_subscribed_(false)
-{}
+    readers_group_subscribed_(false),
+    query_threads_(0)
+{
+    for (int dnssec_ok = 0; dnssec_ok < 2; ++dnssec_ok) {
+        EDNSPtr edns(new EDNS());
+        edns->setDNSSECAwareness(dnssec_ok != 0);
+        edns->setUDPSize(AuthSrvImpl::DEFAULT_LOCAL_UDPSIZE);
+        response_edns_[dnssec_ok] = edns;
+    }
+}
 
 // This is a derived class of \c DNSLookup, to serve as a
 // callback in the asiolink module.  It calls
-// AuthSrv::processMessage() on a single DNS message.
+// AuthSrvImpl::processMessage() on a single DNS message with the query
+// context of the thread running the server.
 class MessageLookup : public DNSLookup {
 public:
-    MessageLookup(AuthSrv* srv) : server_(srv) {}
+    MessageLookup(AuthSrvImpl* impl, QueryContext* context) :
+        impl_(impl), context_(context)
+    {}
     virtual void operator()(const IOMessage& io_message,
                             MessagePtr message,
                             MessagePtr, // Not used here
@@ -342,10 +530,12 @@ public:
         // This is not done in processMessage itself (which would be
         // equivalent), to allow tests to inspect the message handling.
         MessageHolder message_holder(*message);
-        server_->processMessage(io_message, *message, *buffer, server);
+        impl_->processMessage(*context_, io_message, *message, *buffer,
+                              server);
     }
 private:
-    AuthSrv* server_;
+    AuthSrvImpl* impl_;
+    QueryContext* context_;
 };
 
 // This is a derived class of \c DNSAnswer, to serve as a callback in the
@@ -364,12 +554,199 @@ public:
     {}
 };
 
+namespace {
+// A query worker thread.
+//
+// Each worker runs its own event loop with its own set of synchronous UDP
+// servers.  The servers use duplicates of the listening UDP sockets of the
+// main thread, so the kernel distributes incoming queries among all threads
+// waiting on the sockets.  Queries received by a worker are processed with
+// its own query context; the in-memory data is shared with the other
+// threads through the data source clients manager.
+//
+// TCP is still handled only by the main thread; so are zone transfers.
+class QueryWorker : boost::noncopyable {
+public:
+    QueryWorker(AuthSrvImpl* impl, const UDPSocketList& udp_sockets) :
+        lookup_(impl, &context_), answer_(NULL),
+        dns_service_(io_service_, &lookup_, &answer_)
+    {
+        BOOST_FOREACH(const UDPSocketList::value_type& sock, udp_sockets) {
+            const int fd = dup(sock.first);
+            if (fd == -1) {
+                bundy_throw(bundy::Unexpected, "failed to duplicate socket: "
+                            << strerror(errno));
+            }
+            try {
+                dns_service_.addServerUDPFromFD(fd, sock.second,
+                                                DNSService::SERVER_SYNC_OK);
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+        }
+        thread_.reset(new Thread(boost::bind(&IOService::run,
+                                             &io_service_)));
+    }
+
+    ~QueryWorker() {
+        io_service_.stop();
+        try {
+            thread_->wait();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(auth_logger, AUTH_QUERY_WORKER_FAILED).arg(ex.what());
+        }
+    }
+
+    QueryContext& getContext() { return (context_); }
+
+private:
+    QueryContext context_;
+    IOService io_service_;
+    MessageLookup lookup_;
+    MessageAnswer answer_;
+    DNSService dns_service_;
+    boost::scoped_ptr<Thread> thread_;
+};
+
+// An outgoing zone transfer handled by the server itself, in a separate
+// thread.  The response is built and sent a few messages at a time, and
+// the data source clients are held only while building them, so neither
+// a large zone nor a slow client keeps other threads (e.g., the builder
+// installing a new version of a zone) waiting for long.  A zone in memory
+// can be replaced while the clients aren't held, so the transfer of such
+// a zone is aborted if the zone changes in the middle (other zones don't
+// matter); the client will retry.
+//
+// When the transfer is over, the session (and so the connection) is
+// closed right away and the given callback is called, so the owner can
+// clean the worker up without waiting for the next transfer request.
+class XfroutWorker : boost::noncopyable {
+public:
+    XfroutWorker(auth::DataSrcClientsMgr& datasrc_clients_mgr,
+                 unique_ptr<XfroutSession> session,
+                 const boost::function<void()>& done_callback) :
+        datasrc_clients_mgr_(datasrc_clients_mgr),
+        session_(move(session)), done_callback_(done_callback),
+        done_(false)
+    {
+        thread_.reset(new Thread(boost::bind(&XfroutWorker::run, this)));
+    }
+
+    ~XfroutWorker() {
+        {
+            Mutex::Locker locker(mutex_);
+            if (session_) {
+                session_->cancel();
+            }
+        }
+        try {
+            thread_->wait();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(auth_logger, AUTH_XFROUT_WORKER_FAILED).arg(ex.what());
+        }
+    }
+
+    bool isDone() const {
+        Mutex::Locker locker(mutex_);
+        return (done_);
+    }
+
+private:
+    void run() {
+        try {
+            transfer();
+        } catch (...) {
+            setDone();
+            throw;
+        }
+        setDone();
+    }
+
+    void transfer() {
+        const RRClass& zone_class = session_->getZoneClass();
+        const Name& zone_name = session_->getZoneName();
+        uint64_t generation;
+        {
+            auth::DataSrcClientsMgr::Holder
+                datasrc_holder(datasrc_clients_mgr_);
+            session_->start(datasrc_holder.findClientList(zone_class).get());
+            generation = datasrc_clients_mgr_.getZoneGeneration(zone_class,
+                                                                zone_name);
+        }
+        while (session_->send() && !session_->isComplete()) {
+            if (!session_->isFromCache()) {
+                // The zone is read through its own connection to the
+                // data source, independent of the clients.
+                session_->renderNext();
+                continue;
+            }
+            auth::DataSrcClientsMgr::Holder
+                datasrc_holder(datasrc_clients_mgr_);
+            if (datasrc_clients_mgr_.getZoneGeneration(zone_class,
+                                                       zone_name) !=
+                generation) {
+                LOG_INFO(auth_logger, AUTH_XFROUT_DATA_CHANGED)
+                    .arg(session_->getType()).arg(zone_name)
+                    .arg(zone_class);
+                break;
+            }
+            session_->renderNext();
+        }
+    }
+
+    // Close the session and let the owner know the worker can go.
+    void setDone() {
+        {
+            Mutex::Locker locker(mutex_);
+            session_.reset();
+            done_ = true;
+        }
+        done_callback_();
+    }
+
+    auth::DataSrcClientsMgr& datasrc_clients_mgr_;
+    unique_ptr<XfroutSession> session_; // protected by mutex_ once running
+    const boost::function<void()> done_callback_;
+    mutable Mutex mutex_;
+    bool done_;
+    boost::scoped_ptr<Thread> thread_;
+};
+}
+
+void
+AuthSrvImpl::startWorkers() {
+    if (udp_sockets_.empty()) {
+        return;
+    }
+    try {
+        while (workers_.size() < query_threads_) {
+            workers_.push_back(boost::shared_ptr<QueryWorker>(
+                                   new QueryWorker(this, udp_sockets_)));
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR(auth_logger, AUTH_QUERY_WORKER_START_FAIL).
+            arg(workers_.size()).arg(ex.what());
+        return;
+    }
+    LOG_INFO(auth_logger, AUTH_QUERY_WORKERS_STARTED).arg(workers_.size());
+}
+
+void
+AuthSrvImpl::stopWorkers() {
+    if (!workers_.empty()) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_QUERY_WORKERS_STOPPED).
+            arg(workers_.size());
+    }
+    workers_.clear();
+}
+
 AuthSrv::AuthSrv(bundy::util::io::BaseSocketSessionForwarder& xfrout_forwarder,
                  bundy::util::io::BaseSocketSessionForwarder& ddns_forwarder) :
     dnss_(NULL)
 {
     impl_ = new AuthSrvImpl(xfrout_forwarder, ddns_forwarder);
-    dns_lookup_ = new MessageLookup(this);
+    dns_lookup_ = new MessageLookup(impl_, &impl_->main_context_);
     dns_answer_ = new MessageAnswer(this);
 }
 
@@ -467,6 +844,15 @@ AuthSrv::getConfigSession() const {
 void
 AuthSrv::processMessage(const IOMessage& io_message, Message& message,
                         OutputBuffer& buffer, DNSServer* server)
+{
+    impl_->processMessage(impl_->main_context_, io_message, message, buffer,
+                          server);
+}
+
+void
+AuthSrvImpl::processMessage(QueryContext& context,
+                            const IOMessage& io_message, Message& message,
+                            OutputBuffer& buffer, DNSServer* server)
 {
     InputBuffer request_buffer(io_message.getData(), io_message.getDataSize());
     MessageAttributes stats_attrs;
@@ -476,6 +862,16 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     stats_attrs.setRequestTransportProtocol(
         io_message.getRemoteEndpoint().getProtocol());
 
+    // Ordinary queries can be answered from the answer cache without
+    // parsing them into the message.
+    bool send_cached_answer = false;
+    if (processCachedQuery(context, io_message, message, buffer, stats_attrs,
+                           send_cached_answer)) {
+        resumeServer(context, server, message, stats_attrs,
+                     send_cached_answer);
+        return;
+    }
+
     // First, check the header part.  If we fail even for the base header,
     // just drop the message.
     try {
@@ -484,13 +880,13 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
         // Ignore all responses.
         if (message.getHeaderFlag(Message::HEADERFLAG_QR)) {
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_RECEIVED);
-            impl_->resumeServer(server, message, stats_attrs, false);
+            resumeServer(context, server, message, stats_attrs, false);
             return;
         }
     } catch (const bundy::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_HEADER_PARSE_FAIL)
                   .arg(ex.what());
-        impl_->resumeServer(server, message, stats_attrs, false);
+        resumeServer(context, server, message, stats_attrs, false);
         return;
     }
 
@@ -507,16 +903,16 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     } catch (const DNSProtocolError& error) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PROTOCOL_FAILURE)
                   .arg(error.getRcode().toText()).arg(error.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, error.getRcode(),
+        makeErrorMessage(context.renderer_, message, buffer, error.getRcode(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(context, server, message, stats_attrs, true);
         return;
     } catch (const bundy::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PARSE_FAILED)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(context, server, message, stats_attrs, true);
         return;
     } // other exceptions will be handled at a higher layer.
 
@@ -532,20 +928,24 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
     // Do we do TSIG?
     // The keyring can be null if we're in test
-    if (impl_->keyring_ != NULL && tsig_record != NULL) {
+    if (keyring_ != NULL && tsig_record != NULL) {
+        // The keyring can be replaced in the main thread while we are
+        // running in a query worker thread, so we keep our own reference.
+        const boost::shared_ptr<TSIGKeyRing> keyring =
+            boost::atomic_load(keyring_);
         tsig_context.reset(new TSIGContext(tsig_record->getName(),
                                            tsig_record->getRdata().
                                                 getAlgorithm(),
-                                           **impl_->keyring_));
+                                           *keyring));
         tsig_error = tsig_context->verify(tsig_record, io_message.getData(),
                                           io_message.getDataSize());
         stats_attrs.setRequestTSIG(true, tsig_error != TSIGError::NOERROR());
     }
 
     if (tsig_error != TSIGError::NOERROR()) {
-        makeErrorMessage(impl_->renderer_, message, buffer,
+        makeErrorMessage(context.renderer_, message, buffer,
                          tsig_error.toRcode(), stats_attrs, move(tsig_context));
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(context, server, message, stats_attrs, true);
         return;
     }
 
@@ -560,57 +960,59 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
         // note: This can only be reliable after TSIG check succeeds.
         if (opcode == Opcode::NOTIFY()) {
-            send_answer = impl_->processNotify(io_message, message, buffer,
-                                               move(tsig_context), stats_attrs);
+            send_answer = processNotify(context, io_message, message, buffer,
+                                        move(tsig_context), stats_attrs);
         } else if (opcode == Opcode::UPDATE()) {
-            if (impl_->ddns_forwarder_) {
-                send_answer = impl_->processUpdate(io_message);
+            Mutex::Locker locker(session_mutex_);
+            if (ddns_forwarder_) {
+                send_answer = processUpdate(io_message);
             } else {
-                makeErrorMessage(impl_->renderer_, message, buffer,
+                makeErrorMessage(context.renderer_, message, buffer,
                                  Rcode::NOTIMP(), stats_attrs, move(tsig_context));
             }
         } else if (opcode != Opcode::QUERY()) {
             const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_UNSUPPORTED_OPCODE)
                 .arg(message.getOpcode().toText()).arg(remote_ep);
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer_, message, buffer,
                              Rcode::NOTIMP(), stats_attrs, move(tsig_context));
         } else if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer_, message, buffer,
                              Rcode::FORMERR(), stats_attrs, move(tsig_context));
         } else {
             ConstQuestionPtr question = *message.beginQuestion();
             const RRType& qtype = question->getType();
             if (qtype == RRType::AXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, move(tsig_context),
-                                                     stats_attrs);
+                send_answer = processXfrQuery(context, io_message, message,
+                                              buffer, move(tsig_context),
+                                              stats_attrs);
             } else if (qtype == RRType::IXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, move(tsig_context),
-                                                     stats_attrs);
+                send_answer = processXfrQuery(context, io_message, message,
+                                              buffer, move(tsig_context),
+                                              stats_attrs);
             } else {
-                send_answer = impl_->processNormalQuery(io_message, edns,
-                                                        message, buffer,
-                                                        move(tsig_context),
-                                                        stats_attrs);
+                send_answer = processNormalQuery(context, io_message, edns,
+                                                 message, buffer,
+                                                 move(tsig_context),
+                                                 stats_attrs);
             }
         }
     } catch (const std::exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     } catch (...) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE_UNKNOWN);
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     }
-    impl_->resumeServer(server, message, stats_attrs, send_answer);
+    resumeServer(context, server, message, stats_attrs, send_answer);
 }
 
 bool
-AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
+AuthSrvImpl::processNormalQuery(QueryContext& context,
+                                const IOMessage& io_message,
                                 ConstEDNSPtr remote_edns, Message& message,
                                 OutputBuffer& buffer,
                                 unique_ptr<TSIGContext> tsig_context,
@@ -625,10 +1027,7 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
     message.setRcode(Rcode::NOERROR());
 
     if (remote_edns) {
-        EDNSPtr local_edns = EDNSPtr(new EDNS());
-        local_edns->setDNSSECAwareness(dnssec_ok);
-        local_edns->setUDPSize(AuthSrvImpl::DEFAULT_LOCAL_UDPSIZE);
-        message.setEDNS(local_edns);
+        message.setEDNS(response_edns_[dnssec_ok ? 1 : 0]);
     }
 
     // Get access to data source client list through the holder and keep
@@ -636,35 +1035,88 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
     // race with any other thread(s) such as the background loader.
     auth::DataSrcClientsMgr::Holder datasrc_holder(datasrc_clients_mgr_);
 
+    const ConstQuestionPtr question = *message.beginQuestion();
+    const bool udp_buffer =
+        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
+    const size_t length_limit = udp_buffer ? remote_bufsize : 65535;
+
+    // Responses signed with TSIG depend on the key and the time, so they
+    // are never stored in the answer cache.  Cached answers are looked up
+    // in processCachedQuery() before the query is fully parsed.
+    boost::shared_ptr<AnswerCache> answer_cache;
+    if (!tsig_context) {
+        answer_cache = boost::atomic_load(&answer_cache_);
+    }
+    const AnswerCacheKey cache_key(question->getName(), question->getType(),
+                                   question->getClass(),
+                                   remote_edns.get() != NULL, dnssec_ok);
+
     try {
-        const ConstQuestionPtr question = *message.beginQuestion();
         const boost::shared_ptr<datasrc::ClientList>
             list(datasrc_holder.findClientList(question->getClass()));
         if (list) {
             const RRType& qtype = question->getType();
             const Name& qname = question->getName();
-            query_.process(*list, qname, qtype, message, dnssec_ok);
+            context.query_.process(*list, qname, qtype, message, dnssec_ok);
         } else {
-            makeErrorMessage(renderer_, message, buffer, Rcode::REFUSED(),
-                             stats_attrs);
+            message.setRcode(Rcode::REFUSED());
+            if (limitResponse(io_message, message) == RRL_DROP) {
+                LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_DROP)
+                    .arg(io_message.getRemoteEndpoint());
+                return (false);
+            }
+            makeErrorMessage(context.renderer_, message, buffer,
+                             Rcode::REFUSED(), stats_attrs);
             return (true);
         }
     } catch (const bundy::Exception& ex) {
         LOG_ERROR(auth_logger, AUTH_PROCESS_FAIL).arg(ex.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
         return (true);
     }
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    const bool udp_buffer =
-        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
-    renderer_.setLengthLimit(udp_buffer ? remote_bufsize : 65535);
-    message.toWire(renderer_, tsig_context.get());
+    const RRLResult rrl_result = limitResponse(io_message, message);
+    if (rrl_result == RRL_DROP) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_DROP)
+            .arg(io_message.getRemoteEndpoint());
+        return (false);
+    } else if (rrl_result == RRL_SLIP) {
+        // Send an empty truncated response instead, so that a legitimate
+        // client can still get the answer over TCP.
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_SLIP)
+            .arg(io_message.getRemoteEndpoint());
+        message.clearSection(Message::SECTION_ANSWER);
+        message.clearSection(Message::SECTION_AUTHORITY);
+        message.clearSection(Message::SECTION_ADDITIONAL);
+        message.setHeaderFlag(Message::HEADERFLAG_TC);
+    }
+
+    RendererHolder holder(context.renderer_, &buffer, stats_attrs);
+    context.renderer_.setLengthLimit(length_limit);
+    message.toWire(context.renderer_, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
 
+    // Only complete answers from in-memory data are cached; for other
+    // data sources we can't tell when the data change.  The zone
+    // generation is read while still holding the data source clients, so
+    // it's that of the data the answer was built from.
+    if (answer_cache && rrl_result == RRL_OK &&
+        context.query_.isFromMemory() && !context.renderer_.isTruncated() &&
+        (message.getRcode() == Rcode::NOERROR() ||
+         message.getRcode() == Rcode::NXDOMAIN())) {
+        const size_t zone_id =
+            DataGenerations::getZoneID(question->getClass(),
+                                       context.query_.getZoneName());
+        answer_cache->addAnswer(
+            cache_key, zone_id,
+            datasrc_clients_mgr_.getDataGenerations().getZoneGeneration(
+                zone_id),
+            buffer.getData(), buffer.getLength());
+    }
+
     LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_NORMAL_RESPONSE)
-              .arg(renderer_.getLength()).arg(message);
+              .arg(context.renderer_.getLength()).arg(message);
     return (true);
     // The message can contain some data from the locked resource. But outside
     // this method, we touch only the RCode of it, so it should be safe.
@@ -673,25 +1125,282 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
     // released here upon its deletion.
 }
 
+RRLResult
+AuthSrvImpl::limitResponse(const IOMessage& io_message,
+                           const Message& message)
+{
+    const boost::shared_ptr<ResponseLimiter> limiter =
+        boost::atomic_load(&response_limiter_);
+    if (!limiter) {
+        return (RRL_OK);
+    }
+
+    const ConstQuestionPtr question = *message.beginQuestion();
+    const Rcode& rcode = message.getRcode();
+    const Name* name = &question->getName();
+    detail::ResponseType resp_type = detail::RESPONSE_QUERY;
+    if (rcode == Rcode::NXDOMAIN()) {
+        // Account NXDOMAIN responses per zone rather than per query name,
+        // so an attacker can't avoid limiting by using random names.
+        resp_type = detail::RESPONSE_NXDOMAIN;
+        for (RRsetIterator it =
+                 message.beginSection(Message::SECTION_AUTHORITY);
+             it != message.endSection(Message::SECTION_AUTHORITY);
+             ++it) {
+            if ((*it)->getType() == RRType::SOA()) {
+                name = &(*it)->getName();
+                break;
+            }
+        }
+    } else if (rcode != Rcode::NOERROR()) {
+        resp_type = detail::RESPONSE_ERROR;
+    }
+
+    return (limitResponse(io_message, question->getClass(),
+                          question->getType(), name, resp_type));
+}
+
+RRLResult
+AuthSrvImpl::limitResponse(const IOMessage& io_message,
+                           const RRClass& qclass, const RRType& qtype,
+                           const Name* name, detail::ResponseType resp_type)
+{
+    const boost::shared_ptr<ResponseLimiter> limiter =
+        boost::atomic_load(&response_limiter_);
+    if (!limiter) {
+        return (RRL_OK);
+    }
+
+    const bool is_tcp =
+        (io_message.getSocket().getProtocol() == IPPROTO_TCP);
+    return (limiter->check(io_message.getRemoteEndpoint(), is_tcp, qclass,
+                           qtype, name, resp_type, std::time(NULL)));
+}
+
 bool
-AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
+AuthSrvImpl::processCachedQuery(QueryContext& context,
+                                const IOMessage& io_message, Message& message,
+                                OutputBuffer& buffer,
+                                MessageAttributes& stats_attrs,
+                                bool& send_answer)
+{
+    const boost::shared_ptr<AnswerCache> cache =
+        boost::atomic_load(&answer_cache_);
+    if (!cache) {
+        return (false);
+    }
+
+    // Only ordinary queries without TSIG can be answered from the cache.
+    // Anything else, including broken or unsupported queries, is left to
+    // the full parser, which also handles the errors.
+    ParsedQuery query;
+    if (!query.parse(io_message.getData(), io_message.getDataSize()) ||
+        query.hasTSIG() ||
+        (query.hasEDNS() &&
+         query.getEDNSVersion() != EDNS::SUPPORTED_VERSION) ||
+        query.getQType() == RRType::AXFR() ||
+        query.getQType() == RRType::IXFR()) {
+        return (false);
+    }
+
+    const bool edns = query.hasEDNS();
+    const bool dnssec_ok = query.getDNSSECAwareness();
+    const uint16_t remote_bufsize = edns ? query.getUDPSize() :
+        Message::DEFAULT_MAX_UDPSIZE;
+    const size_t length_limit =
+        (io_message.getSocket().getProtocol() == IPPROTO_UDP) ?
+        remote_bufsize : 65535;
+    // The zone generations are checked without holding the data source
+    // clients; an answer from a zone that is just being reloaded may still
+    // be returned a moment after the new data are in place.
+    const AnswerCacheKey key(query.getQName(), query.getQType(),
+                             query.getQClass(), edns, dnssec_ok);
+    const AnswerCacheGenerations generations(
+        datasrc_clients_mgr_.getDataGenerations());
+    if (!cache->getAnswer(key, generations, io_message.getData(),
+                          io_message.getDataSize(), length_limit, buffer)) {
+        return (false);
+    }
+
+    const uint8_t* const data = static_cast<const uint8_t*>(buffer.getData());
+    const uint16_t flags = (data[2] << 8) | data[3];
+    const Rcode rcode(flags & 0x000f);
+    const bool rrl_enabled =
+        boost::atomic_load(&response_limiter_).get() != NULL;
+    // RRL accounts NXDOMAIN responses by the zone name, which is only
+    // known from the full response.  Process the query normally then.
+    if (rcode == Rcode::NXDOMAIN() && rrl_enabled) {
+        buffer.clear();
+        return (false);
+    }
+
+    // Set up the message and the attributes as if the query was processed
+    // normally.  The header has already been validated by ParsedQuery.
+    InputBuffer request_buffer(io_message.getData(),
+                               io_message.getDataSize());
+    message.parseHeader(request_buffer);
+    message.makeResponse();
+    message.setRcode(rcode);
+    message.setHeaderFlag(Message::HEADERFLAG_AA,
+                          (flags & Message::HEADERFLAG_AA) != 0);
+    stats_attrs.setRequestRD(query.getHeaderFlag(Message::HEADERFLAG_RD));
+    stats_attrs.setRequestOpCode(Opcode::QUERY());
+    if (edns) {
+        message.setEDNS(response_edns_[dnssec_ok ? 1 : 0]);
+        stats_attrs.setRequestEDNS0(true);
+        stats_attrs.setRequestDO(dnssec_ok);
+    }
+    stats_attrs.setResponseAnswerCount((data[6] << 8) | data[7]);
+
+    if (!rrl_enabled) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_CACHED_RESPONSE)
+            .arg(buffer.getLength()).arg(query.getQName())
+            .arg(query.getQType());
+        send_answer = true;
+        return (true);
+    }
+
+    // The rate limiter needs a Name object of the query name.
+    request_buffer.setPosition(ParsedQuery::HEADER_LENGTH);
+    const Name qname(request_buffer);
+    const RRLResult rrl_result =
+        limitResponse(io_message, query.getQClass(), query.getQType(),
+                      &qname, detail::RESPONSE_QUERY);
+    if (rrl_result == RRL_DROP) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_DROP)
+            .arg(io_message.getRemoteEndpoint());
+        buffer.clear();
+        send_answer = false;
+    } else if (rrl_result == RRL_SLIP) {
+        // Send an empty truncated response as in processNormalQuery().
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_SLIP)
+            .arg(io_message.getRemoteEndpoint());
+        buffer.clear();
+        message.addQuestion(Question(qname, query.getQClass(),
+                                     query.getQType()));
+        message.setHeaderFlag(Message::HEADERFLAG_TC);
+        stats_attrs.setResponseAnswerCount(0);
+        RendererHolder holder(context.renderer_, &buffer, stats_attrs);
+        context.renderer_.setLengthLimit(length_limit);
+        message.toWire(context.renderer_);
+        send_answer = true;
+    } else {
+        LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_CACHED_RESPONSE)
+            .arg(buffer.getLength()).arg(qname).arg(query.getQType());
+        send_answer = true;
+    }
+    return (true);
+}
+
+bool
+AuthSrvImpl::processXfrQuery(QueryContext& context,
+                             const IOMessage& io_message, Message& message,
                              OutputBuffer& buffer,
                              unique_ptr<TSIGContext> tsig_context,
                              MessageAttributes& stats_attrs)
 {
     if (io_message.getSocket().getProtocol() == IPPROTO_UDP) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_UDP);
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
 
-    xfrout_forwarder_->push(io_message);
+    const boost::shared_ptr<const XfroutConfig> xfrout_config =
+        boost::atomic_load(&xfrout_config_);
+    if (!xfrout_config) {
+        Mutex::Locker locker(session_mutex_);
+        xfrout_forwarder_->push(io_message);
+        return (false);
+    }
+
+    // Handle the transfer natively, with the same checks as bundy-xfrout
+    const ConstQuestionPtr question = *message.beginQuestion();
+    const server_common::Client client(io_message);
+    const acl::dns::RequestContext acl_context(
+        client.getRequestSourceIPAddress(), message.getTSIGRecord());
+    switch (xfrout_config->getACL().execute(acl_context)) {
+    case acl::REJECT:
+        LOG_INFO(auth_logger, AUTH_XFROUT_REJECTED)
+            .arg(question->getType()).arg(client.toText())
+            .arg(question->getName()).arg(question->getClass());
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::REFUSED(),
+                         stats_attrs, move(tsig_context));
+        return (true);
+    case acl::DROP:
+        LOG_INFO(auth_logger, AUTH_XFROUT_DROPPED)
+            .arg(question->getType()).arg(client.toText())
+            .arg(question->getName()).arg(question->getClass());
+        return (false);
+    default:
+        break;
+    }
+
+    reapXfroutWorkers();
+    Mutex::Locker locker(xfrout_mutex_);
+    if (xfrout_workers_.size() >= xfrout_config->getMaxTransfers()) {
+        LOG_INFO(auth_logger, AUTH_XFROUT_QUOTA_EXCEEDED)
+            .arg(question->getType()).arg(client.toText())
+            .arg(question->getName()).arg(question->getClass())
+            .arg(xfrout_workers_.size());
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::REFUSED(),
+                         stats_attrs, move(tsig_context));
+        return (true);
+    }
+
+    // The server closes its socket as we return false, so the session
+    // uses a duplicate of it.
+    const int fd = dup(io_message.getSocket().getNative());
+    if (fd == -1) {
+        bundy_throw(bundy::Unexpected, "failed to duplicate socket: "
+                    << strerror(errno));
+    }
+    unique_ptr<XfroutSession> session(
+        new XfroutSession(fd, client.toText(), io_message.getData(),
+                          io_message.getDataSize(), move(tsig_context)));
+    try {
+        xfrout_workers_.push_back(boost::shared_ptr<XfroutWorker>(
+            new XfroutWorker(datasrc_clients_mgr_, move(session),
+                             boost::bind(&AuthSrvImpl::xfroutWorkerDone,
+                                         this))));
+    } catch (const std::exception& ex) {
+        LOG_ERROR(auth_logger, AUTH_XFROUT_START_FAILED)
+            .arg(question->getType()).arg(client.toText())
+            .arg(question->getName()).arg(question->getClass())
+            .arg(ex.what());
+    }
     return (false);
 }
 
+void
+AuthSrvImpl::xfroutWorkerDone() {
+    // Called in the worker thread, which can't wait for itself.
+    io_service_.post(boost::bind(&AuthSrvImpl::reapXfroutWorkers, this));
+}
+
+void
+AuthSrvImpl::reapXfroutWorkers() {
+    std::list<boost::shared_ptr<XfroutWorker> > done_workers;
+    {
+        Mutex::Locker locker(xfrout_mutex_);
+        for (std::list<boost::shared_ptr<XfroutWorker> >::iterator it =
+                 xfrout_workers_.begin();
+             it != xfrout_workers_.end();) {
+            if ((*it)->isDone()) {
+                done_workers.splice(done_workers.end(), xfrout_workers_,
+                                    it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // The threads are waited for as done_workers goes out of scope,
+    // without holding the lock.
+}
+
 bool
-AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
+AuthSrvImpl::processNotify(QueryContext& context,
+                           const IOMessage& io_message, Message& message,
                            OutputBuffer& buffer,
                            std::unique_ptr<TSIGContext> tsig_context,
                            MessageAttributes& stats_attrs)
@@ -703,7 +1412,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_QUESTIONS)
                   .arg(message.getRRCount(Message::SECTION_QUESTION));
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
@@ -711,7 +1420,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (question->getType() != RRType::SOA()) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_RRTYPE)
                   .arg(question->getType().toText());
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
@@ -733,7 +1442,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (!is_auth) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RECEIVED_NOTIFY_NOTAUTH)
             .arg(question->getName()).arg(question->getClass()).arg(remote_ep);
-        makeErrorMessage(renderer_, message, buffer, Rcode::NOTAUTH(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::NOTAUTH(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
@@ -755,6 +1464,8 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     static const string command_template_end = "\"}]}";
 
     try {
+        // The session is shared with other query threads, if any.
+        Mutex::Locker locker(session_mutex_);
         ConstElementPtr notify_command = Element::fromJSON(
                 command_template_start + question->getName().toText() +
                 command_template_master + remote_ip_address +
@@ -793,8 +1504,8 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     message.setHeaderFlag(Message::HEADERFLAG_AA);
     message.setRcode(Rcode::NOERROR());
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    message.toWire(renderer_, tsig_context.get());
+    RendererHolder holder(context.renderer_, &buffer, stats_attrs);
+    message.toWire(context.renderer_, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
     return (true);
 }
@@ -810,10 +1521,13 @@ AuthSrvImpl::processUpdate(const IOMessage& io_message)
 }
 
 void
-AuthSrvImpl::resumeServer(DNSServer* server, Message& message,
-                          MessageAttributes& stats_attrs,
+AuthSrvImpl::resumeServer(QueryContext& context, DNSServer* server,
+                          Message& message, MessageAttributes& stats_attrs,
                           const bool done) {
-    counters_.inc(stats_attrs, message, done);
+    {
+        Mutex::Locker locker(context.counters_mutex_);
+        context.counters_.inc(stats_attrs, message, done);
+    }
     server->resume(done);
 }
 
@@ -832,8 +1546,73 @@ AuthSrv::updateConfig(ConstElementPtr new_config) {
     }
 }
 
+namespace {
+// Convert memory usage of a zone into the form of statistics items.
+ConstElementPtr
+createMemoryUsageElement(const memory::ZoneDataMemoryUsage& usage) {
+    const ElementPtr memory = Element::createMap();
+    memory->set("nodes", Element::create(
+                    static_cast<long long int>(usage.node_count)));
+    memory->set("node_bytes", Element::create(
+                    static_cast<long long int>(usage.node_bytes)));
+    memory->set("rdatasets", Element::create(
+                    static_cast<long long int>(usage.rdataset_count)));
+    memory->set("rdataset_bytes", Element::create(
+                    static_cast<long long int>(usage.rdataset_bytes)));
+    memory->set("nsec3_bytes", Element::create(
+                    static_cast<long long int>(usage.nsec3_bytes)));
+    memory->set("name_index_bytes", Element::create(
+                    static_cast<long long int>(usage.name_index_bytes)));
+    memory->set("total_bytes", Element::create(
+                    static_cast<long long int>(usage.getTotal())));
+    return (memory);
+}
+}
+
 ConstElementPtr AuthSrv::getStatistics() const {
-    return (impl_->counters_.get());
+    // Sum up the per thread shards.  The worker set is only modified in
+    // the main thread (which is also the caller of this method), so we
+    // don't have to worry about it.
+    Counters total;
+    {
+        Mutex::Locker locker(impl_->main_context_.counters_mutex_);
+        total.add(impl_->main_context_.counters_);
+    }
+    BOOST_FOREACH(const boost::shared_ptr<QueryWorker>& worker,
+                  impl_->workers_) {
+        QueryContext& context = worker->getContext();
+        Mutex::Locker locker(context.counters_mutex_);
+        total.add(context.counters_);
+    }
+    const ConstElementPtr counters = total.get();
+
+    // Add the memory usage of each in-memory zone as the "memory" item of
+    // the zone.  If the same zone is cached in more than one data source,
+    // the one found first (i.e., the one that would be used for queries)
+    // is reported.  The usage is computed when the zones are loaded, so
+    // we don't have to walk the zones (or lock the data sources) here.
+    const ElementPtr zones = Element::createMap();
+    zones->set("_SERVER_", counters->get("zones")->get("_SERVER_"));
+    const ZoneMemoryUsageMap memory_usage =
+        impl_->datasrc_clients_mgr_.getZoneMemoryUsage();
+    for (ZoneMemoryUsageMap::const_iterator it = memory_usage.begin();
+         it != memory_usage.end();
+         ++it)
+    {
+        BOOST_FOREACH(const ZoneMemoryUsage& usage, it->second) {
+            const string zone_name = usage.zone_name.toText();
+            if (zones->contains(zone_name)) {
+                continue;
+            }
+            const ElementPtr zone = Element::createMap();
+            zone->set("memory", createMemoryUsageElement(usage.usage));
+            zones->set(zone_name, zone);
+        }
+    }
+
+    const ElementPtr statistics = Element::createMap();
+    statistics->set("zones", zones);
+    return (statistics);
 }
 
 const AddressList&
@@ -843,10 +1622,68 @@ AuthSrv::getListenAddresses() const {
 
 void
 AuthSrv::setListenAddresses(const AddressList& addresses) {
-    // For UDP servers we specify the "SYNC_OK" option because in our usage
-    // it can act in the synchronous mode.
-    installListenAddresses(addresses, impl_->listen_addresses_, *dnss_,
-                           DNSService::SERVER_SYNC_OK);
+    // The query workers (if any) share the UDP sockets with us, so they
+    // are restarted with the new set of sockets.
+    impl_->stopWorkers();
+    UDPSocketRecorder recorder(*dnss_, impl_->udp_sockets_);
+    try {
+        // For UDP servers we specify the "SYNC_OK" option because in our
+        // usage it can act in the synchronous mode.
+        installListenAddresses(addresses, impl_->listen_addresses_, recorder,
+                               DNSService::SERVER_SYNC_OK);
+    } catch (...) {
+        // The old (or no) addresses have been restored; keep serving them.
+        impl_->startWorkers();
+        throw;
+    }
+    impl_->startWorkers();
+}
+
+void
+AuthSrv::setQueryThreads(size_t threads) {
+    if (threads == impl_->query_threads_) {
+        return;
+    }
+    impl_->stopWorkers();
+    impl_->query_threads_ = threads;
+    impl_->startWorkers();
+}
+
+size_t
+AuthSrv::getQueryThreads() const {
+    return (impl_->query_threads_);
+}
+
+void
+AuthSrv::setResponseLimiter(
+    const boost::shared_ptr<ResponseLimiter>& limiter)
+{
+    boost::atomic_store(&impl_->response_limiter_, limiter);
+}
+
+boost::shared_ptr<ResponseLimiter>
+AuthSrv::getResponseLimiter() const {
+    return (boost::atomic_load(&impl_->response_limiter_));
+}
+
+void
+AuthSrv::setAnswerCache(const boost::shared_ptr<AnswerCache>& cache) {
+    boost::atomic_store(&impl_->answer_cache_, cache);
+}
+
+boost::shared_ptr<AnswerCache>
+AuthSrv::getAnswerCache() const {
+    return (boost::atomic_load(&impl_->answer_cache_));
+}
+
+void
+AuthSrv::setXfroutConfig(const boost::shared_ptr<const XfroutConfig>& config) {
+    boost::atomic_store(&impl_->xfrout_config_, config);
+}
+
+boost::shared_ptr<const XfroutConfig>
+AuthSrv::getXfroutConfig() const {
+    return (boost::atomic_load(&impl_->xfrout_config_));
 }
 
 void
@@ -862,6 +1699,7 @@ AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring) {
 void
 AuthSrv::createDDNSForwarder() {
     LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_START_DDNS_FORWARDER);
+    Mutex::Locker locker(impl_->session_mutex_);
     impl_->ddns_forwarder_.reset(
         new SocketSessionForwarderHolder("update",
                                          impl_->ddns_base_forwarder_));
@@ -869,6 +1707,7 @@ AuthSrv::createDDNSForwarder() {
 
 void
 AuthSrv::destroyDDNSForwarder() {
+    Mutex::Locker locker(impl_->session_mutex_);
     if (impl_->ddns_forwarder_) {
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_STOP_DDNS_FORWARDER);
         impl_->ddns_forwarder_.reset();
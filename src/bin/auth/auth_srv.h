@@ -59,6 +59,11 @@ class AbstractXfroutClient;
 namespace dns {
 class TSIGKeyRing;
 }
+namespace auth {
+class ResponseLimiter;
+class AnswerCache;
+class XfroutConfig;
+}
 }
 
 
@@ -84,6 +89,12 @@ class AuthSrvImpl;
 /// in this current implementation there will only be one object), so the
 /// construction overhead of this approach should be acceptable.
 ///
+/// Queries can optionally be processed by multiple threads (see
+/// \c setQueryThreads()).  Even then, the public methods of this class
+/// must only be called from the thread running the \c IOService of the
+/// server; the worker threads only use the internal query processing
+/// routines.
+///
 /// The design of this class is still in flux.  It's quite likely to change
 /// in future versions.
 ///
@@ -215,6 +226,10 @@ public:
 
     /// \brief Returns statistics data
     ///
+    /// Besides the message counters, which are stored for "_SERVER_",
+    /// the returned data contain the memory usage of each zone cached
+    /// in memory as the "memory" item of the zone.
+    ///
     /// This function can throw an exception from
     /// Counters::get().
     ///
@@ -229,6 +244,114 @@ public:
     const bundy::server_common::portconfig::AddressList& getListenAddresses()
         const;
 
+    /// \brief Set the number of query worker threads.
+    ///
+    /// By default all queries are processed in the thread that runs the
+    /// server's \c IOService.  If \c threads is non 0, that many additional
+    /// threads are started, each of which runs its own event loop and
+    /// handles UDP queries on (duplicates of) the sockets we listen on,
+    /// using its own message renderer, query object and statistics
+    /// counters.  The in-memory data sources are shared among all threads
+    /// via the data source clients manager.  TCP queries and other kinds of
+    /// requests that need interaction with other modules are still handled
+    /// in the main thread (or serialized among the threads).
+    ///
+    /// Any existing workers are stopped and new ones are started.  Workers
+    /// are created only while we have UDP sockets to listen on; they will
+    /// be started on a later call to \c setListenAddresses() otherwise.
+    /// A failure in starting a worker thread is logged and the server
+    /// keeps running with a smaller number of threads.
+    ///
+    /// \param threads The number of worker threads in addition to the
+    /// main thread.
+    void setQueryThreads(size_t threads);
+
+    /// \brief Return the configured number of query worker threads.
+    ///
+    /// \throw None
+    size_t getQueryThreads() const;
+
+    /// \brief Set the response rate limiter.
+    ///
+    /// If a non-empty limiter is set, responses to normal queries (not
+    /// including transfer requests, NOTIFY or UPDATE) are checked by it
+    /// before being rendered, and are dropped or replaced with truncated
+    /// responses as it indicates.  Setting an empty pointer disables
+    /// response rate limiting.
+    ///
+    /// The limiter is shared by all query processing threads; the server
+    /// serializes access to it internally.
+    ///
+    /// \throw None
+    ///
+    /// \param limiter The new limiter, or an empty pointer.
+    void setResponseLimiter(
+        const boost::shared_ptr<bundy::auth::ResponseLimiter>& limiter);
+
+    /// \brief Return the current response rate limiter.
+    ///
+    /// \throw None
+    ///
+    /// \return The limiter set by \c setResponseLimiter(), or an empty
+    /// pointer if response rate limiting is disabled.
+    boost::shared_ptr<bundy::auth::ResponseLimiter>
+    getResponseLimiter() const;
+
+    /// \brief Set the cache of rendered answers.
+    ///
+    /// If a non-empty cache is set, responses to normal queries that are
+    /// answered from in-memory data sources are stored in it in the wire
+    /// format, and later queries for the same question are answered by
+    /// copying the stored data instead of looking up the data sources
+    /// and rendering the response again.  Responses signed with TSIG are
+    /// never cached.  The cached answers are discarded whenever data
+    /// source data is updated.  Setting an empty pointer disables the
+    /// cache.
+    ///
+    /// Like the response rate limiter, the cache is shared by all query
+    /// processing threads and the server serializes access to it
+    /// internally.
+    ///
+    /// \throw None
+    ///
+    /// \param cache The new cache, or an empty pointer.
+    void setAnswerCache(
+        const boost::shared_ptr<bundy::auth::AnswerCache>& cache);
+
+    /// \brief Return the current answer cache.
+    ///
+    /// \throw None
+    ///
+    /// \return The cache set by \c setAnswerCache(), or an empty pointer
+    /// if answer caching is disabled.
+    boost::shared_ptr<bundy::auth::AnswerCache> getAnswerCache() const;
+
+    /// \brief Set the configuration of native outgoing zone transfers.
+    ///
+    /// If a non-empty configuration is set, AXFR and IXFR requests over
+    /// TCP are handled by the server itself, each in a separate thread,
+    /// instead of being forwarded to bundy-xfrout.  Requests are checked
+    /// with the ACL of the configuration, and refused if its maximum
+    /// number of transfers are in progress.  Setting an empty pointer
+    /// restores the forwarding; transfers already in progress are not
+    /// affected.
+    ///
+    /// \throw None
+    ///
+    /// \param config The new configuration, or an empty pointer.
+    void setXfroutConfig(
+        const boost::shared_ptr<const bundy::auth::XfroutConfig>& config);
+
+    /// \brief Return the current configuration of native outgoing zone
+    /// transfers.
+    ///
+    /// \throw None
+    ///
+    /// \return The configuration set by \c setXfroutConfig(), or an empty
+    /// pointer if transfer requests are forwarded to bundy-xfrout.
+    boost::shared_ptr<const bundy::auth::XfroutConfig>
+    getXfroutConfig() const;
+
     /// \brief Assign an ASIO DNS Service queue to this Auth object
     void setDNSService(bundy::asiodns::DNSServiceBase& dnss);
 
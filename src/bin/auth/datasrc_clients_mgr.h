@@ -21,6 +21,8 @@
 #include <log/logger_support.h>
 #include <log/log_dbglevels.h>
 
+#include <dns/labelsequence.h>
+#include <dns/name.h>
 #include <dns/rrclass.h>
 
 #include <cc/data.h>
@@ -38,15 +40,21 @@
 #include <boost/array.hpp>
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <exception>
 #include <cassert>
 #include <cerrno>
 #include <list>
+#include <map>
 #include <utility>
+#include <vector>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -66,6 +74,98 @@ public:
         bundy::Exception(file, line, what) {}
 };
 
+/// \brief Memory usage of the zones in the in-memory caches, per RR class.
+///
+/// The zones of each class are in the order returned by
+/// \c ConfigurableClientList::getZoneMemoryUsage().
+typedef std::map<dns::RRClass, std::vector<datasrc::ZoneMemoryUsage> >
+ZoneMemoryUsageMap;
+
+/// \brief Generations of the data served by the data source clients.
+///
+/// A generation is a number that changes whenever the data that can be
+/// seen through the client lists changes, so that something derived from
+/// the data (e.g., a cached response) can tell whether it's still valid.
+/// There's a global generation, which changes on any change, and a
+/// generation of each zone, which changes only when the zone itself is
+/// (re)loaded or when all data change (on reconfiguration or on resetting
+/// a memory segment).  So reloading one zone doesn't invalidate what was
+/// derived from the other zones.
+///
+/// The zone generations are kept in a fixed number of slots, selected by
+/// a hash of the zone name and class.  Zones sharing a slot share the
+/// generation, which only causes extra invalidation.  All generations are
+/// taken from a single counter, so a zone generation is the larger of the
+/// slot's value and the value at the last change of all data.
+///
+/// The generations are changed only by the builder thread (and tests)
+/// while holding the clients map lock, together with the data.  They can
+/// be read without any lock.
+///
+/// Note that changes made directly to the underlying data sources (e.g.,
+/// a database) aren't covered, so the generations are only meaningful for
+/// data served from memory.
+class DataGenerations : boost::noncopyable {
+public:
+    /// \brief The number of zone generation slots.
+    static const size_t ZONE_SLOTS = 1024;
+
+    /// \brief Constructor.  All generations are 0.
+    DataGenerations() : counter_(0), all_(0) {
+        for (size_t i = 0; i < ZONE_SLOTS; ++i) {
+            zones_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// \brief Record a change of all data.
+    void changeAll() {
+        all_.store(++counter_, std::memory_order_release);
+    }
+
+    /// \brief Record a change of the data of a single zone.
+    void changeZone(const dns::RRClass& rrclass, const dns::Name& zone) {
+        zones_[getZoneID(rrclass, zone)].store(++counter_,
+                                               std::memory_order_release);
+    }
+
+    /// \brief Return the global generation.
+    uint64_t getGeneration() const {
+        return (counter_.load(std::memory_order_acquire));
+    }
+
+    /// \brief Return the generation of a zone.
+    uint64_t getZoneGeneration(const dns::RRClass& rrclass,
+                               const dns::Name& zone) const
+    {
+        return (getZoneGeneration(getZoneID(rrclass, zone)));
+    }
+
+    /// \brief Return the generation of a zone by its ID.
+    ///
+    /// \param zone_id A value returned by \c getZoneID().
+    uint64_t getZoneGeneration(size_t zone_id) const {
+        return (std::max(all_.load(std::memory_order_acquire),
+                         zones_[zone_id].load(std::memory_order_acquire)));
+    }
+
+    /// \brief Return the ID of a zone.
+    ///
+    /// This is the slot of the zone generation; it's less than
+    /// \c ZONE_SLOTS and can be kept in place of the zone name to get its
+    /// generation later with less overhead.
+    static size_t getZoneID(const dns::RRClass& rrclass,
+                            const dns::Name& zone)
+    {
+        return ((dns::LabelSequence(zone).getHash(false) ^
+                 rrclass.getCode()) % ZONE_SLOTS);
+    }
+
+private:
+    std::atomic<uint64_t> counter_;
+    std::atomic<uint64_t> all_;
+    std::atomic<uint64_t> zones_[ZONE_SLOTS];
+};
+
 namespace datasrc_clientmgr_internal {
 // This namespace is essentially private for DataSrcClientsMgr(Base) and
 // DataSrcClientsBuilder(Base).  This is exposed in the public header
@@ -136,6 +236,23 @@ struct Command {
     FinishedCallback callback;
 };
 
+/// \brief Compute the memory usage of the zones in all client lists.
+///
+/// This walks through all the cached zones, so it takes time.  The caller
+/// must make sure the zones aren't modified meanwhile.
+template <typename ClientListsMap>
+ZoneMemoryUsageMap
+getMemoryUsage(const ClientListsMap& clients_map) {
+    ZoneMemoryUsageMap usage;
+    for (typename ClientListsMap::const_iterator it = clients_map.begin();
+         it != clients_map.end();
+         ++it)
+    {
+        usage[it->first] = it->second->getZoneMemoryUsage();
+    }
+    return (usage);
+}
+
 } // namespace datasrc_clientmgr_internal
 
 /// \brief Frontend to the manager object for data source clients.
@@ -156,9 +273,11 @@ struct Command {
 /// This class is templated only so that we can test the class without
 /// involving actual threads or mutex.  Normal applications will only
 /// need one specific specialization that has a typedef of
-/// \c DataSrcClientsMgr.
+/// \c DataSrcClientsMgr.  \c MapMutexType is the type of the lock
+/// protecting the client lists; it must provide a \c ReaderLocker for
+/// shared access in addition to the \c Locker for exclusive access.
 template <typename ThreadType, typename BuilderType, typename MutexType,
-          typename CondVarType>
+          typename CondVarType, typename MapMutexType = MutexType>
 class DataSrcClientsMgrBase : boost::noncopyable {
 private:
     typedef std::map<dns::RRClass,
@@ -197,6 +316,19 @@ public:
     /// It's normally expected to create the holder object on the stack
     /// of a small scope and automatically let it be destroyed at the end
     /// of the scope.
+    ///
+    /// Holders only share the lock of the client lists, so any number of
+    /// threads can have one at the same time; they only wait while the
+    /// builder thread replaces the lists or installs a new version of a
+    /// zone, which it does in a short critical section after the time
+    /// consuming part of the work.  The in-memory data can be searched by
+    /// several threads at once, but other data source clients (e.g., a
+    /// database) can't, so holders that get a client list using such
+    /// clients are serialized (see
+    /// \c datasrc::ConfigurableClientList::isCacheOnly()).
+    ///
+    /// A thread must not have more than one holder of the same manager at
+    /// the same time.
     class Holder {
     public:
         Holder(DataSrcClientsMgrBase& mgr) :
@@ -225,9 +357,12 @@ public:
                 it = mgr_.clients_map_->find(rrclass);
             if (it == mgr_.clients_map_->end()) {
                 return (boost::shared_ptr<datasrc::ConfigurableClientList>());
-            } else {
-                return (it->second);
             }
+            if (!datasrc_locker_ && !it->second->isCacheOnly()) {
+                datasrc_locker_.reset(
+                    new typename MutexType::Locker(mgr_.datasrc_mutex_));
+            }
+            return (it->second);
         }
         /// \brief Return list of classes that are present.
         ///
@@ -247,9 +382,21 @@ public:
             }
             return (result);
         }
+
+        /// \brief Return the generation of the data source data.
+        ///
+        /// The generation is a number that is incremented every time the
+        /// data that can be seen through the client lists changes, i.e.,
+        /// on reconfiguration, on (re)loading a zone into memory and on
+        /// resetting a memory segment.  See \c DataGenerations.
+        uint64_t getDataGeneration() const {
+            return (mgr_.data_generations_.getGeneration());
+        }
     private:
         DataSrcClientsMgrBase& mgr_;
-        typename MutexType::Locker locker_;
+        typename MapMutexType::ReaderLocker locker_;
+        // Held while using data source clients that aren't thread safe.
+        boost::scoped_ptr<typename MutexType::Locker> datasrc_locker_;
     };
 
     /// \brief Constructor.
@@ -269,7 +416,8 @@ public:
         fd_guard_(new FDGuard(this)),
         read_fd_(-1), write_fd_(-1),
         builder_(&command_queue_, &callback_queue_, &cond_, &queue_mutex_,
-                 &clients_map_, &map_mutex_, createFds()),
+                 &clients_map_, &map_mutex_, &data_generations_,
+                 &memory_usage_, createFds()),
         builder_thread_(boost::bind(&BuilderType::run, &builder_)),
         wakeup_socket_(service, read_fd_)
     {
@@ -352,8 +500,50 @@ public:
     /// cleaner way to use faked data source clients.  Non test code or
     /// newer tests must not use this.
     void setDataSrcClientLists(datasrc::ClientListMapPtr new_lists) {
-        typename MutexType::Locker locker(map_mutex_);
+        ZoneMemoryUsageMap usage =
+            datasrc_clientmgr_internal::getMemoryUsage(*new_lists);
+        typename MapMutexType::Locker locker(map_mutex_);
         clients_map_ = new_lists;
+        memory_usage_.swap(usage);
+        data_generations_.changeAll();
+    }
+
+    /// \brief Return the memory usage of the zones in the in-memory caches.
+    ///
+    /// The usage is computed by the builder thread whenever the cached
+    /// zones change (on reconfiguration, on (re)loading a zone and on
+    /// resetting a memory segment), so this method just returns a copy
+    /// of the latest result and is cheap enough to be called on every
+    /// statistics request.
+    ///
+    /// \throw std::bad_alloc
+    ZoneMemoryUsageMap getZoneMemoryUsage() {
+        typename MapMutexType::ReaderLocker locker(map_mutex_);
+        return (memory_usage_);
+    }
+
+    /// \brief Return the generation of the data of a zone.
+    ///
+    /// See \c DataGenerations.  It doesn't need a \c Holder: while a
+    /// holder is alive the returned value matches the data seen through
+    /// it; without one, the new generation of a zone that is just being
+    /// changed may be returned a moment later.
+    ///
+    /// \throw None
+    uint64_t getZoneGeneration(const dns::RRClass& rrclass,
+                               const dns::Name& zone) const
+    {
+        return (data_generations_.getZoneGeneration(rrclass, zone));
+    }
+
+    /// \brief Return the generations of the data.
+    ///
+    /// Like \c getZoneGeneration(), the returned object can be used
+    /// without a \c Holder.
+    ///
+    /// \throw None
+    const DataGenerations& getDataGenerations() const {
+        return (data_generations_);
     }
 
     /// \brief Instruct internal thread to (re)load a zone
@@ -567,7 +757,14 @@ private:
                                 // map of actual data source client objects
     boost::scoped_ptr<FDGuard> fd_guard_; // A guard to close the fds.
     int read_fd_, write_fd_;    // Descriptors for wakeup
-    MutexType map_mutex_;       // mutex to protect the clients map
+    MapMutexType map_mutex_;    // lock to protect the clients map
+    DataGenerations data_generations_; // generations of the data in the
+                                       // clients map, changed under
+                                       // map_mutex_
+    ZoneMemoryUsageMap memory_usage_; // memory usage of the cached zones,
+                                      // protected by map_mutex_
+    MutexType datasrc_mutex_;   // serializes holders using data source
+                                // clients that aren't thread safe
 
     BuilderType builder_;
     ThreadType builder_thread_; // for safety this should be placed last
@@ -593,7 +790,8 @@ namespace datasrc_clientmgr_internal {
 ///
 /// This class is templated so that we can test it without involving actual
 /// threads or locks.
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType,
+          typename MapMutexType = MutexType>
 class DataSrcClientsBuilderBase : boost::noncopyable {
 private:
     typedef std::map<dns::RRClass,
@@ -621,12 +819,16 @@ public:
                               std::list<FinishedCallbackPair>* callback_queue,
                               CondVarType* cond, MutexType* queue_mutex,
                               datasrc::ClientListMapPtr* clients_map,
-                              MutexType* map_mutex,
+                              MapMutexType* map_mutex,
+                              DataGenerations* data_generations,
+                              ZoneMemoryUsageMap* memory_usage,
                               int wake_fd
         ) :
         command_queue_(command_queue), callback_queue_(callback_queue),
         cond_(cond), queue_mutex_(queue_mutex),
-        clients_map_(clients_map), map_mutex_(map_mutex), wake_fd_(wake_fd),
+        clients_map_(clients_map), map_mutex_(map_mutex),
+        data_generations_(data_generations), memory_usage_(memory_usage),
+        wake_fd_(wake_fd),
         gen_id_(-1)
     {}
 
@@ -682,12 +884,19 @@ private:
     // Swap pending clients map with the current when all waiting memory
     // segments are ready.
     void installClientsMap() {
+        // The pending map is only visible to us, so we can walk its zones
+        // without holding the lock.
+        ZoneMemoryUsageMap usage =
+            getMemoryUsage(*pending_map_->clients_map_);
+
         // Define new_clients_map outside of the block that has the lock scope;
         // this way, after the swap, the lock is guaranteed to be released
         // before the old data is destroyed, minimizing the lock duration.
         {
-            typename MutexType::Locker locker(*map_mutex_);
+            typename MapMutexType::Locker locker(*map_mutex_);
             pending_map_->clients_map_.swap(*clients_map_);
+            memory_usage_->swap(usage);
+            data_generations_->changeAll();
         } // lock is released by leaving scope
           // old clients_map_ data is released by leaving scope
 
@@ -807,7 +1016,8 @@ private:
             }
         }
 
-        typename MutexType::Locker locker(*map_mutex_);
+        typename MapMutexType::Locker locker(*map_mutex_);
+        data_generations_->changeAll();
         if (!list->resetMemorySegment(
                 dsrc_name, bundy::datasrc::memory::ZoneTableSegment::READ_ONLY,
                 segment_params)) {
@@ -834,6 +1044,7 @@ private:
                 // normal case: update on the current generation; just apply it.
                 resetSegment(**clients_map_, rrclass, name, segment_params,
                              inuse_only);
+                updateMemoryUsage(rrclass, NULL);
             } else if (pending_map_ && pending_map_->gen_id_ == genid) {
                 // update for a pending generation: apply it, and see if it's
                 // now ready, and if so, perform swap now.
@@ -872,6 +1083,45 @@ private:
         }
     }
 
+    // Recompute the memory usage of the zones of the given class in the
+    // current clients map (only of the given zone if it's non NULL) and
+    // publish it for DataSrcClientsMgr::getZoneMemoryUsage().  We are the
+    // only thread that modifies the zones and the published usage, so both
+    // are read without holding the lock; it's only taken to store the
+    // result.
+    void updateMemoryUsage(const dns::RRClass& rrclass,
+                           const dns::Name* zone_name)
+    {
+        const ClientListsMap::const_iterator found =
+            (*clients_map_)->find(rrclass);
+        if (found == (*clients_map_)->end()) {
+            return;
+        }
+        std::vector<datasrc::ZoneMemoryUsage> usages;
+        if (zone_name) {
+            // Keep the other zones as they are.
+            const ZoneMemoryUsageMap::const_iterator current =
+                memory_usage_->find(rrclass);
+            if (current != memory_usage_->end()) {
+                BOOST_FOREACH(const datasrc::ZoneMemoryUsage& usage,
+                              current->second) {
+                    if (usage.zone_name != *zone_name) {
+                        usages.push_back(usage);
+                    }
+                }
+            }
+            const std::vector<datasrc::ZoneMemoryUsage> zone_usages =
+                found->second->getZoneMemoryUsage(*zone_name);
+            usages.insert(usages.end(), zone_usages.begin(),
+                          zone_usages.end());
+        } else {
+            usages = found->second->getZoneMemoryUsage();
+        }
+
+        typename MapMutexType::Locker locker(*map_mutex_);
+        (*memory_usage_)[rrclass].swap(usages);
+    }
+
     void doUpdateZone(datasrc_clientmgr_internal::CommandID command,
                       const bundy::data::ConstElementPtr& arg);
     boost::shared_ptr<datasrc::memory::ZoneWriter> getZoneWriter(
@@ -887,7 +1137,9 @@ private:
     CondVarType* cond_;
     MutexType* queue_mutex_;
     datasrc::ClientListMapPtr* clients_map_;
-    MutexType* map_mutex_;
+    MapMutexType* map_mutex_;
+    DataGenerations* data_generations_;
+    ZoneMemoryUsageMap* memory_usage_;
     int wake_fd_;
 
     // These are local to the builder thread:
@@ -913,12 +1165,13 @@ private:
 };
 
 // Shortcut typedef for normal use
-typedef DataSrcClientsBuilderBase<util::thread::Mutex, util::thread::CondVar>
+typedef DataSrcClientsBuilderBase<util::thread::Mutex, util::thread::CondVar,
+                                  util::thread::RWMutex>
 DataSrcClientsBuilder;
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 void
-DataSrcClientsBuilderBase<MutexType, CondVarType>::run() {
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::run() {
     LOG_INFO(auth_logger, AUTH_DATASRC_CLIENTS_BUILDER_STARTED);
 
     try {
@@ -985,10 +1238,10 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::run() {
     }
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 bool
-DataSrcClientsBuilderBase<MutexType, CondVarType>::handleCommand(
-    const Command& command)
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::
+handleCommand(const Command& command)
 {
     const CommandID cid = command.id;
     if (cid >= NUM_COMMANDS) {
@@ -1036,9 +1289,10 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::handleCommand(
     return (keep_running);
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 void
-DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::
+doUpdateZone(
     datasrc_clientmgr_internal::CommandID command,
     const bundy::data::ConstElementPtr& arg)
 {
@@ -1085,8 +1339,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
 
         zwriter->load(); // this can take time but doesn't cause a race
         {   // install() can cause a race and must be in a critical section
-            typename MutexType::Locker locker(*map_mutex_);
+            typename MapMutexType::Locker locker(*map_mutex_);
             zwriter->install();
+            data_generations_->changeZone(rrclass, origin);
         }
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS,
                   AUTH_DATASRC_CLIENTS_BUILDER_LOAD_ZONE)
@@ -1095,6 +1350,8 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
         // same as load(). We could let the destructor do it, but do it
         // ourselves explicitly just in case.
         zwriter->cleanup();
+
+        updateMemoryUsage(rrclass, &origin);
     } catch (const InternalCommandError& ex) {
         throw;     // this comes from getZoneWriter.  just let it go through.
     } catch (const bundy::Exception& ex) {
@@ -1109,9 +1366,10 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
 
 // A dedicated subroutine of doUpdateZone().  Separated just for keeping the
 // main method concise.
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 boost::shared_ptr<datasrc::memory::ZoneWriter>
-DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::
+getZoneWriter(
     datasrc_clientmgr_internal::CommandID command,
     datasrc::ConfigurableClientList& client_list,
     const std::string& datasrc_name, const dns::RRClass& rrclass,
@@ -1122,7 +1380,7 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     // source for lookup.  So we need to protect the access here.
     datasrc::ConfigurableClientList::ZoneWriterPair writerpair;
     {
-        typename MutexType::Locker locker(*map_mutex_);
+        typename MapMutexType::Locker locker(*map_mutex_);
         writerpair = client_list.getCachedZoneWriter(origin, false,
                                                      datasrc_name);
     }
@@ -1163,10 +1421,10 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     return (boost::shared_ptr<datasrc::memory::ZoneWriter>());
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 FinishedCallback
-DataSrcClientsBuilderBase<MutexType, CondVarType>::doReleaseSegments(
-    const Command& command)
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::
+doReleaseSegments(const Command& command)
 {
     try {
         if (!command.params) {
@@ -1206,7 +1464,8 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doReleaseSegments(
 typedef DataSrcClientsMgrBase<
     util::thread::Thread,
     datasrc_clientmgr_internal::DataSrcClientsBuilder,
-    util::thread::Mutex, util::thread::CondVar> DataSrcClientsMgr;
+    util::thread::Mutex, util::thread::CondVar,
+    util::thread::RWMutex> DataSrcClientsMgr;
 } // namespace auth
 } // namespace bundy
 
@@ -20,6 +20,7 @@
 
 #include <datasrc/client.h>
 #include <datasrc/client_list.h>
+#include <datasrc/memory/zone_finder.h>
 
 #include <auth/query.h>
 
@@ -380,6 +381,14 @@ Query::process(datasrc::ClientList& client_list,
         return;
     }
 
+    // Changes to in-memory zones are tracked by the data source clients
+    // manager, so responses built from them can be cached.
+    from_memory_ = (dynamic_cast<const datasrc::memory::InMemoryZoneFinder*>(
+                        result.finder_.get()) != NULL);
+    if (from_memory_) {
+        zone_name_ = result.finder_->getOrigin();
+    }
+
     if (qtype == RRType::RRSIG()) {
         // We will not serve RRSIGs directly. See #2226 and the
         // following thread for discussion why:
@@ -554,6 +563,7 @@ Query::initialize(datasrc::ClientList& client_list,
     dnssec_ = dnssec;
     dnssec_opt_ = (dnssec ? bundy::datasrc::ZoneFinder::FIND_DNSSEC :
                    bundy::datasrc::ZoneFinder::FIND_DEFAULT);
+    from_memory_ = false;
 }
 
 void
@@ -570,6 +580,10 @@ Query::reset() {
 
 bool
 Query::processDSAtChild() {
+    // The response will come from a different zone; we don't bother to
+    // check where it is.
+    from_memory_ = false;
+
     const ClientList::FindResult zresult = client_list_->find(*qname_, true);
 
     if (zresult.dsrc_client_ == NULL) {
@@ -15,6 +15,7 @@
  */
 
 #include <exceptions/exceptions.h>
+#include <dns/name.h>
 #include <dns/rrset.h>
 #include <datasrc/zone.h>
 
@@ -281,6 +282,7 @@ public:
     Query() :
         client_list_(NULL), qname_(NULL), qtype_(NULL),
         dnssec_(false), dnssec_opt_(bundy::datasrc::ZoneFinder::FIND_DEFAULT),
+        from_memory_(false), zone_name_(bundy::dns::Name::ROOT_NAME()),
         response_(NULL)
     {
         answers_.reserve(RESERVE_RRSETS);
@@ -330,6 +332,20 @@ public:
                  const bundy::dns::Name& qname, const bundy::dns::RRType& qtype,
                  bundy::dns::Message& response, bool dnssec = false);
 
+    /// \brief Return whether the last response came from in-memory data.
+    ///
+    /// It returns true iff the response built by the last call to
+    /// \c process() was built solely from a zone of an in-memory data
+    /// source (so the response can be cached as long as the in-memory
+    /// data don't change).  If \c process() threw, the result is
+    /// undefined.
+    bool isFromMemory() const { return (from_memory_); }
+
+    /// \brief Return the name of the zone the last response came from.
+    ///
+    /// It's only meaningful if \c isFromMemory() returns true.
+    const bundy::dns::Name& getZoneName() const { return (zone_name_); }
+
     /// \short Bad zone data encountered.
     ///
     /// This is thrown when a process encounters a misconfigured zone in a
@@ -485,6 +501,8 @@ private:
     const bundy::dns::RRType* qtype_;
     bool dnssec_;
     bundy::datasrc::ZoneFinder::FindOptions dnssec_opt_;
+    bool from_memory_;
+    bundy::dns::Name zone_name_;
     ResponseCreator response_creator_;
 
     bundy::dns::Message* response_;
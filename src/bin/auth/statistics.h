@@ -75,6 +75,8 @@ private:
         BIT_ATTRIBUTES_TYPES
     };
     std::bitset<BIT_ATTRIBUTES_TYPES> bit_attributes_;
+    // response attributes not available in the response message
+    boost::optional<unsigned int> res_answer_count_;  // ANCOUNT
 public:
     /// \brief The constructor.
     ///
@@ -251,6 +253,28 @@ public:
     void setResponseTSIG(const bool signed_tsig) {
         bit_attributes_[RES_TSIG_SIGNED] = signed_tsig;
     }
+
+    /// \brief Return the number of RRs in the answer section of the
+    /// response if it's been set by \c setResponseAnswerCount().
+    ///
+    /// \return the number of answer RRs wrapped with boost::optional; it's
+    ///         converted to false if it hasn't been set.
+    /// \throw None
+    const boost::optional<unsigned int>& getResponseAnswerCount() const {
+        return (res_answer_count_);
+    }
+
+    /// \brief Set the number of RRs in the answer section of the response.
+    ///
+    /// This is only necessary if the response isn't built in the response
+    /// \c Message (e.g., it's taken from a cache of rendered responses);
+    /// otherwise the number is taken from the message.
+    ///
+    /// \param count the number of answer RRs
+    /// \throw None
+    void setResponseAnswerCount(const unsigned int count) {
+        res_answer_count_ = count;
+    }
 };
 
 /// \brief Set of DNS message counters.
@@ -308,6 +332,15 @@ public:
     void inc(const MessageAttributes& msgattrs,
              const bundy::dns::Message& response, const bool done);
 
+    /// \brief Add the values of another set of counters to this one.
+    ///
+    /// This is used to sum up the counters maintained per query thread.
+    ///
+    /// \param other The set of counters to add.
+    /// \throw bundy::InvalidParameter Internal condition check failed (the
+    /// underlying counters differ in size).
+    void add(const Counters& other);
+
     /// \brief Get statistics counters.
     ///
     /// This method is mostly exception free. But it may still throw a
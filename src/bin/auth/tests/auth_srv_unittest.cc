@@ -38,6 +38,11 @@
 #include <auth/statistics.h>
 #include <auth/statistics_items.h>
 #include <auth/datasrc_config.h>
+#include <auth/rrl.h>
+#include <auth/answer_cache.h>
+#include <auth/xfrout.h>
+
+#include <acl/dns.h>
 
 #include <config/tests/fake_session.h>
 #include <config/ccsession.h>
@@ -60,6 +65,8 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
 
+#include <cstring>
+#include <ctime>
 #include <vector>
 
 #include <sys/types.h>
@@ -647,6 +654,63 @@ TEST_F(AuthSrvTest, AXFRDisconnectFail) {
     xfrout_forwarder.enableClose();
 }
 
+// Enable native transfers with the given ACL.
+void
+setNativeXfrout(AuthSrv& server, const char* acl) {
+    server.setXfroutConfig(boost::shared_ptr<const XfroutConfig>(
+        new XfroutConfig(10, bundy::acl::dns::getRequestLoader().load(
+                             Element::fromJSON(acl)))));
+}
+
+TEST_F(AuthSrvTest, AXFRNativeRejected) {
+    setNativeXfrout(server, "[{\"action\": \"REJECT\"}]");
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("example.com"), RRClass::IN(),
+                                       RRType::AXFR());
+    createRequestPacket(request_message, IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::REFUSED(),
+                opcode.getCode(), QR_FLAG, 1, 0, 0, 0);
+    // It's not forwarded to bundy-xfrout
+    EXPECT_FALSE(xfrout_forwarder.isConnected());
+}
+
+TEST_F(AuthSrvTest, AXFRNativeDropped) {
+    setNativeXfrout(server, "[{\"action\": \"DROP\"}]");
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("example.com"), RRClass::IN(),
+                                       RRType::AXFR());
+    createRequestPacket(request_message, IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_FALSE(dnsserv.hasAnswer());
+    EXPECT_FALSE(xfrout_forwarder.isConnected());
+}
+
+TEST_F(AuthSrvTest, AXFRNativeBadSocket) {
+    // The dummy socket of the test has no native descriptor, so the
+    // transfer can't be started and SERVFAIL is returned.
+    setNativeXfrout(server, "[{\"action\": \"ACCEPT\"}]");
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("example.com"), RRClass::IN(),
+                                       RRType::AXFR());
+    createRequestPacket(request_message, IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::SERVFAIL(),
+                opcode.getCode(), QR_FLAG, 1, 0, 0, 0);
+    EXPECT_FALSE(xfrout_forwarder.isConnected());
+}
+
+TEST_F(AuthSrvTest, AXFRNativeOverUDP) {
+    // Native transfers are still rejected over UDP
+    setNativeXfrout(server, "[{\"action\": \"ACCEPT\"}]");
+    axfrOverUDP();
+}
+
 TEST_F(AuthSrvTest, IXFRConnectFail) {
     EXPECT_FALSE(xfrout_forwarder.isConnected()); // check prerequisite
     xfrout_forwarder.disableConnect();
@@ -1276,6 +1340,29 @@ TEST_F(AuthSrvTest, queryWithInMemoryClientDNSSEC) {
                 opcode.getCode(), QR_FLAG | AA_FLAG, 1, 2, 3, 3);
 }
 
+TEST_F(AuthSrvTest, zoneMemoryStatistics) {
+    // Without any in-memory zone there's only the server-wide item.
+    EXPECT_EQ(1, server.getStatistics()->get("zones")->mapValue().size());
+
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    const ConstElementPtr zones = server.getStatistics()->get("zones");
+    EXPECT_EQ(3, zones->mapValue().size());
+    EXPECT_TRUE(zones->contains("_SERVER_"));
+    ASSERT_TRUE(zones->contains("example."));
+    const ConstElementPtr memory = zones->get("example.")->get("memory");
+    ASSERT_TRUE(memory);
+    EXPECT_LT(0, memory->get("nodes")->intValue());
+    EXPECT_LT(0, memory->get("rdatasets")->intValue());
+    EXPECT_EQ(memory->get("node_bytes")->intValue() +
+              memory->get("rdataset_bytes")->intValue() +
+              memory->get("nsec3_bytes")->intValue() +
+              memory->get("name_index_bytes")->intValue(),
+              memory->get("total_bytes")->intValue());
+
+    // The "BIND." zone in class CH is also reported.
+    EXPECT_TRUE(zones->get("BIND.")->contains("memory"));
+}
+
 TEST_F(AuthSrvTest, chQueryWithInMemoryClient) {
     // Set up the in-memory
     updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
@@ -1292,6 +1379,157 @@ TEST_F(AuthSrvTest, chQueryWithInMemoryClient) {
                 opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
 }
 
+TEST_F(AuthSrvTest, responseRateLimiting) {
+    // Allow 1 response per second, and let every other limited response
+    // slip.
+    server.setResponseLimiter(boost::shared_ptr<ResponseLimiter>(
+                                  new ResponseLimiter(1, 1, 1, 15, 2, 100, 24,
+                                                      56, false,
+                                                      std::time(NULL), 0)));
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+
+    // The first response is sent as usual.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+
+    // The next one exceeds the limit, and slips: it's an empty, truncated
+    // response.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG | TC_FLAG, 1, 0, 0, 0);
+
+    // The next one is dropped.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_FALSE(dnsserv.hasAnswer());
+
+    // Responses over TCP are not limited.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH(), IPPROTO_TCP);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+
+    // NXDOMAIN responses are accounted separately.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("AUTHORS.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+
+    // REFUSED responses are limited as errors (once the credit of 1 is used
+    // up, a slip first and then a drop).
+    createAndSendRequest(RRType::A(), Opcode::QUERY(), Name("example.org"),
+                         RRClass::IN());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    createAndSendRequest(RRType::A(), Opcode::QUERY(), Name("example.org"),
+                         RRClass::IN());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    createAndSendRequest(RRType::A(), Opcode::QUERY(), Name("example.org"),
+                         RRClass::IN());
+    EXPECT_FALSE(dnsserv.hasAnswer());
+
+    // Once disabled, responses are no longer limited.
+    server.setResponseLimiter(boost::shared_ptr<ResponseLimiter>());
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+}
+
+TEST_F(AuthSrvTest, answerCache) {
+    const boost::shared_ptr<AnswerCache> cache(new AnswerCache(10));
+    server.setAnswerCache(cache);
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+
+    // The first response is built normally and stored in the cache.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+    EXPECT_EQ(1, cache->getEntryCount());
+    const vector<uint8_t> first_response(
+        static_cast<const uint8_t*>(response_obuffer->getData()),
+        static_cast<const uint8_t*>(response_obuffer->getData()) +
+        response_obuffer->getLength());
+
+    // The same query with a different ID and a differently cased name gets
+    // the same answer with the ID and question of the query.
+    UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
+                                       default_qid + 1, Name("version.bind."),
+                                       RRClass::CH(), RRType::TXT());
+    createRequestPacket(request_message, IPPROTO_UDP);
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid + 1, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+    EXPECT_EQ(Name("version.bind."),
+              (*parse_message->beginQuestion())->getName());
+    ASSERT_EQ(first_response.size(), response_obuffer->getLength());
+    EXPECT_EQ(0, memcmp(&first_response[0] + 2,
+                        static_cast<const uint8_t*>(
+                            response_obuffer->getData()) + 2,
+                        first_response.size() - 2));
+    EXPECT_EQ(1, cache->getEntryCount());
+
+    // Reloading the data invalidates the answer; the new answer replaces it.
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+    EXPECT_EQ(1, cache->getEntryCount());
+}
+
+// Cached answers to queries with EDNS carry the OPT RR of the response.
+TEST_F(AuthSrvTest, answerCacheWithDNSSEC) {
+    const boost::shared_ptr<AnswerCache> cache(new AnswerCache(10));
+    server.setAnswerCache(cache);
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+
+    for (int i = 0; i < 2; ++i) {
+        UnitTestUtil::createDNSSECRequestMessage(request_message,
+                                                 Opcode::QUERY(),
+                                                 default_qid + i,
+                                                 Name("VERSION.BIND."),
+                                                 RRClass::CH(), RRType::TXT());
+        createRequestPacket(request_message, IPPROTO_UDP);
+        parse_message->clear(Message::PARSE);
+        response_obuffer->clear();
+        server.processMessage(*io_message, *parse_message, *response_obuffer,
+                              &dnsserv);
+        EXPECT_TRUE(dnsserv.hasAnswer());
+
+        InputBuffer ib(response_obuffer->getData(),
+                       response_obuffer->getLength());
+        Message response(Message::PARSE);
+        response.fromWire(ib);
+        EXPECT_EQ(default_qid + i, response.getQid());
+        EXPECT_EQ(Rcode::NOERROR(), response.getRcode());
+        ASSERT_TRUE(response.getEDNS());
+        EXPECT_TRUE(response.getEDNS()->getDNSSECAwareness());
+        EXPECT_EQ(1, response.getRRCount(Message::SECTION_ANSWER));
+        EXPECT_EQ(1, cache->getEntryCount());
+    }
+
+    // The same query without EDNS is a separate entry.
+    createAndSendRequest(RRType::TXT(), Opcode::QUERY(), Name("VERSION.BIND."),
+                         RRClass::CH());
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
+    EXPECT_EQ(2, cache->getEntryCount());
+}
+
 #ifdef USE_STATIC_LINK
 TEST_F(AuthSrvTest, DISABLED_queryCounterTruncTest) {
 #else
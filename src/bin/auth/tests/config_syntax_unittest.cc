@@ -36,7 +36,17 @@ TEST_F(AuthConfigSyntaxTest, inmemoryDefaultFileType) {
     EXPECT_TRUE(
         mspec_.validateConfig(
             Element::fromJSON(
-                "{\"tcp_recv_timeout\": 1000,"
+                "{\"tcp_recv_timeout\": 1000, \"query_threads\": 0,"
+                " \"response_rate_limiting\": "
+                "  {\"enable\": false, \"responses_per_second\": 5,"
+                "   \"nxdomains_per_second\": 5, \"errors_per_second\": 5,"
+                "   \"window\": 15, \"slip\": 2, \"max_table_size\": 20000,"
+                "   \"ipv4_prefix_length\": 24, \"ipv6_prefix_length\": 56,"
+                "   \"log_only\": false},"
+                " \"answer_cache_size\": 0,"
+                " \"native_xfrout\": "
+                "  {\"enable\": false, \"max_transfers_out\": 10,"
+                "   \"transfer_acl\": [{\"action\": \"ACCEPT\"}]},"
                 " \"listen_on\": [], \"datasources\": "
                 "  [{\"type\": \"memory\", \"class\": \"IN\", "
                 "    \"zones\": [{\"origin\": \"example.com\","
@@ -86,4 +96,69 @@ TEST_F(AuthConfigSyntaxTest, badTCPRecvTimeout) {
                 "                 \"filetype\": \"sqlite3\"}]}]}"), false));
 }
 
+TEST_F(AuthConfigSyntaxTest, badQueryThreads) {
+    // query_threads must be int
+    EXPECT_FALSE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"query_threads\": \"foo\"}"), false));
+    EXPECT_TRUE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"query_threads\": 4}"), false));
+}
+
+TEST_F(AuthConfigSyntaxTest, badAnswerCacheSize) {
+    // answer_cache_size must be int
+    EXPECT_FALSE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"answer_cache_size\": \"foo\"}"), false));
+    EXPECT_TRUE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"answer_cache_size\": 10000}"), false));
+}
+
+TEST_F(AuthConfigSyntaxTest, nativeXfrout) {
+    // Partial configuration is okay
+    EXPECT_TRUE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"native_xfrout\": {\"enable\": true}}"),
+            false));
+    EXPECT_TRUE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"native_xfrout\": "
+                              " {\"enable\": true,"
+                              "  \"max_transfers_out\": 20,"
+                              "  \"transfer_acl\": "
+                              "   [{\"action\": \"REJECT\","
+                              "     \"from\": \"192.0.2.1\"}]}}"),
+            false));
+    EXPECT_FALSE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"native_xfrout\": "
+                              " {\"max_transfers_out\": \"foo\"}}"),
+            false));
+}
+
+TEST_F(AuthConfigSyntaxTest, responseRateLimiting) {
+    // Partial configuration is okay
+    EXPECT_TRUE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"response_rate_limiting\": "
+                              " {\"enable\": true, \"slip\": 0}}"),
+            false));
+    // Type mismatch
+    EXPECT_FALSE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"response_rate_limiting\": "
+                              " {\"enable\": 1}}"), false));
+    EXPECT_FALSE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"response_rate_limiting\": "
+                              " {\"window\": \"15\"}}"), false));
+    // Unknown item
+    EXPECT_FALSE(
+        mspec_.validateConfig(
+            Element::fromJSON("{\"response_rate_limiting\": "
+                              " {\"all_per_second\": 10}}"), false));
+}
+
 }
@@ -26,6 +26,9 @@
 #include <auth/auth_srv.h>
 #include <auth/auth_config.h>
 #include <auth/common.h>
+#include <auth/rrl.h>
+#include <auth/answer_cache.h>
+#include <auth/xfrout.h>
 
 #include "datasrc_util.h"
 
@@ -157,4 +160,145 @@ TEST_F(AuthConfigTest, tcpRecvTimeoutConfig) {
                  AuthConfigError);
 }
 
+// Try setting the number of query threads through config
+TEST_F(AuthConfigTest, queryThreadsConfig) {
+    EXPECT_EQ(0, server.getQueryThreads());
+    // No UDP socket is open, so no thread is actually started; we only check
+    // the configuration is accepted and kept.
+    configureAuthServer(server,
+                        Element::fromJSON("{ \"query_threads\": 4 }"));
+    EXPECT_EQ(4, server.getQueryThreads());
+    configureAuthServer(server,
+                        Element::fromJSON("{ \"query_threads\": 0 }"));
+    EXPECT_EQ(0, server.getQueryThreads());
+
+    // Out of range values are rejected and the current value is kept.
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{ \"query_threads\": -1 }")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{ \"query_threads\": 257 }")),
+                 AuthConfigError);
+    EXPECT_EQ(0, server.getQueryThreads());
+}
+
+TEST_F(AuthConfigTest, responseRateLimitingConfig) {
+    // Disabled by default
+    EXPECT_FALSE(server.getResponseLimiter());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"response_rate_limiting\": "
+                            " {\"enable\": true, \"responses_per_second\": 10,"
+                            "  \"nxdomains_per_second\": 3,"
+                            "  \"errors_per_second\": 2, \"window\": 5,"
+                            "  \"slip\": 0, \"log_only\": true}}"));
+    boost::shared_ptr<bundy::auth::ResponseLimiter> limiter =
+        server.getResponseLimiter();
+    ASSERT_TRUE(limiter);
+    EXPECT_EQ(10, limiter->getResponseRate());
+    EXPECT_EQ(3, limiter->getNXDOMAINRate());
+    EXPECT_EQ(2, limiter->getErrorRate());
+    EXPECT_EQ(5, limiter->getWindow());
+    EXPECT_EQ(0, limiter->getSlip());
+    EXPECT_TRUE(limiter->isLogOnly());
+
+    // Missing parameters are set to the defaults.
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"response_rate_limiting\": "
+                            " {\"enable\": true}}"));
+    limiter = server.getResponseLimiter();
+    ASSERT_TRUE(limiter);
+    EXPECT_EQ(5, limiter->getResponseRate());
+    EXPECT_EQ(15, limiter->getWindow());
+    EXPECT_EQ(2, limiter->getSlip());
+    EXPECT_FALSE(limiter->isLogOnly());
+
+    // Invalid parameters are rejected, and the current setting is kept.
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{\"response_rate_limiting\": "
+                                         " {\"enable\": true,"
+                                         "  \"window\": 0}}")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{\"response_rate_limiting\": "
+                                         " {\"enable\": true,"
+                                         "  \"slip\": -1}}")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{\"response_rate_limiting\": "
+                                         " {\"enable\": true,"
+                                         "  \"ipv4_prefix_length\": 33}}")),
+                 AuthConfigError);
+    EXPECT_EQ(limiter, server.getResponseLimiter());
+
+    // Disable it.
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"response_rate_limiting\": "
+                            " {\"enable\": false}}"));
+    EXPECT_FALSE(server.getResponseLimiter());
+}
+
+TEST_F(AuthConfigTest, answerCacheConfig) {
+    // Disabled by default
+    EXPECT_FALSE(server.getAnswerCache());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"answer_cache_size\": 1000}"));
+    const boost::shared_ptr<bundy::auth::AnswerCache> cache =
+        server.getAnswerCache();
+    ASSERT_TRUE(cache);
+    EXPECT_EQ(1000, cache->getMaxEntries());
+
+    // Invalid values are rejected, and the current setting is kept.
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{\"answer_cache_size\": -1}")),
+                 AuthConfigError);
+    EXPECT_EQ(cache, server.getAnswerCache());
+
+    // 0 disables it.
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"answer_cache_size\": 0}"));
+    EXPECT_FALSE(server.getAnswerCache());
+}
+
+TEST_F(AuthConfigTest, nativeXfroutConfig) {
+    // Disabled by default
+    EXPECT_FALSE(server.getXfroutConfig());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"native_xfrout\": {\"enable\": true}}"));
+    const boost::shared_ptr<const bundy::auth::XfroutConfig> config =
+        server.getXfroutConfig();
+    ASSERT_TRUE(config);
+    EXPECT_EQ(10, config->getMaxTransfers());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"native_xfrout\": {\"enable\": true,"
+                            " \"max_transfers_out\": 2,"
+                            " \"transfer_acl\": [{\"action\": \"REJECT\"}]}}"));
+    ASSERT_TRUE(server.getXfroutConfig());
+    EXPECT_EQ(2, server.getXfroutConfig()->getMaxTransfers());
+
+    // Invalid values are rejected, and the current setting is kept.
+    const boost::shared_ptr<const bundy::auth::XfroutConfig> current =
+        server.getXfroutConfig();
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{\"native_xfrout\": "
+                                         " {\"enable\": true,"
+                                         "  \"max_transfers_out\": 0}}")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                                         "{\"native_xfrout\": "
+                                         " {\"enable\": true,"
+                                         "  \"transfer_acl\": "
+                                         "   [{\"action\": \"BAD\"}]}}")),
+                 AuthConfigError);
+    EXPECT_EQ(current, server.getXfroutConfig());
+
+    // Disabling it restores forwarding to bundy-xfrout.
+    configureAuthServer(server, Element::fromJSON(
+                            "{\"native_xfrout\": {\"enable\": false}}"));
+    EXPECT_FALSE(server.getXfroutConfig());
+}
+
 }
@@ -49,6 +49,8 @@ using bundy::data::ConstElementPtr;
 using namespace bundy::dns;
 using namespace bundy::data;
 using namespace bundy::datasrc;
+using bundy::auth::DataGenerations;
+using bundy::auth::ZoneMemoryUsageMap;
 using namespace bundy::auth::datasrc_clientmgr_internal;
 using namespace bundy::auth::unittest;
 using namespace bundy::testutils;
@@ -61,7 +63,8 @@ protected:
                     boost::shared_ptr<ConfigurableClientList> >),
         write_end(-1), read_end(-1),
         builder(&command_queue, &callback_queue, &cond, &queue_mutex,
-                &clients_map, &map_mutex, generateSockets()),
+                &clients_map, &map_mutex, &data_generations, &memory_usage,
+                generateSockets()),
         cond(command_queue, delayed_command_queue), rrclass(RRClass::IN()),
         shutdown_cmd(SHUTDOWN, ConstElementPtr(), FinishedCallback()),
         noop_cmd(NOOP, ConstElementPtr(), FinishedCallback())
@@ -84,6 +87,8 @@ protected:
     std::list<Command> delayed_command_queue; // commands available after wait
     std::list<FinishedCallbackPair> callback_queue; // Callbacks from commands
     int write_end, read_end;
+    DataGenerations data_generations;
+    ZoneMemoryUsageMap memory_usage;
     TestDataSrcClientsBuilder builder;
     TestCondVar cond;
     TestMutex queue_mutex;
@@ -249,6 +254,10 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_FALSE(builder.getInternalCallbacks().front().second->boolValue());
     EXPECT_EQ(1, clients_map->size());
     EXPECT_EQ(1, map_mutex.lock_count);
+    // The data generation is incremented with the new map.
+    EXPECT_EQ(1, data_generations.getGeneration());
+    // The memory usage is computed for the new map, too.
+    EXPECT_EQ(1, memory_usage.size());
 
     // Store the nonempty clients map we now have
     ClientListMapPtr working_config_clients(clients_map);
@@ -313,6 +322,9 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(0, clients_map->size());
     EXPECT_EQ(3, map_mutex.lock_count);
+    // Failed attempts don't change the data generation.
+    EXPECT_EQ(3, data_generations.getGeneration());
+    EXPECT_TRUE(memory_usage.empty());
 
     // Also check if it has been cleanly unlocked every time
     EXPECT_EQ(3, map_mutex.unlock_count);
@@ -414,13 +426,19 @@ TEST_F(DataSrcClientsBuilderTest, loadZone) {
                                FinishedCallback());
     EXPECT_TRUE(builder.handleCommand(loadzone_cmd));
 
-    // loadZone involves two critical sections: one for getting the zone
-    // writer, and one for actually updating the zone data.  So the lock/unlock
-    // count should be incremented by 2.
-    EXPECT_EQ(2, map_mutex.lock_count);
-    EXPECT_EQ(2, map_mutex.unlock_count);
+    // loadZone involves three critical sections: one for getting the zone
+    // writer, one for actually updating the zone data, and one for storing
+    // its memory usage.  So the lock/unlock count should be incremented by 3.
+    EXPECT_EQ(3, map_mutex.lock_count);
+    EXPECT_EQ(3, map_mutex.unlock_count);
 
     newZoneChecks(clients_map, rrclass);
+
+    // The memory usage of the loaded zone has been computed.  The other
+    // zone isn't there, as the zones were configured without the builder.
+    ASSERT_EQ(1, memory_usage[rrclass].size());
+    EXPECT_EQ(Name("test1.example"), memory_usage[rrclass][0].zone_name);
+    EXPECT_LT(0, memory_usage[rrclass][0].usage.node_count);
 }
 
 // Shared test for both LOADZONE and UPDATEZONE
@@ -476,12 +494,26 @@ DataSrcClientsBuilderTest::checkLoadOrUpdateZone(CommandID cmdid) {
                           "{\"class\": \"IN\","
                           " \"origin\": \"example.org\"}"),
                       FinishedCallback());
+    const uint64_t old_generation = data_generations.getGeneration();
+    const uint64_t old_zone_generation =
+        data_generations.getZoneGeneration(rrclass, Name("example.org"));
+    const uint64_t other_zone_generation =
+        data_generations.getZoneGeneration(rrclass, Name("example.net"));
     EXPECT_TRUE(builder.handleCommand(cmd));
     // And now it should be present too.
     EXPECT_EQ(ZoneFinder::SUCCESS,
               clients_map->find(rrclass)->second->
               find(Name("example.org")).finder_->
               find(Name("www.example.org"), RRType::A())->code);
+    // The data has changed, so is the generation.
+    EXPECT_EQ(old_generation + 1, data_generations.getGeneration());
+    // Only the generation of the loaded zone changes.
+    EXPECT_LT(old_zone_generation,
+              data_generations.getZoneGeneration(rrclass,
+                                                 Name("example.org")));
+    EXPECT_EQ(other_zone_generation,
+              data_generations.getZoneGeneration(rrclass,
+                                                 Name("example.net")));
 
     // An error case: the zone has no configuration. (note .com here)
     const Command nozone_cmd(cmdid, Element::fromJSON(
@@ -14,6 +14,7 @@
 
 #include <exceptions/exceptions.h>
 
+#include <dns/name.h>
 #include <dns/rrclass.h>
 
 #include <cc/data.h>
@@ -159,6 +160,7 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_FALSE(holder.findClientList(RRClass::IN()));
         EXPECT_FALSE(holder.findClientList(RRClass::CH()));
         EXPECT_TRUE(holder.getClasses().empty());
+        EXPECT_EQ(0, holder.getDataGeneration());
         // map should be protected here
         EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->lock_count);
         EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
@@ -178,6 +180,7 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_TRUE(holder.findClientList(RRClass::IN()));
         EXPECT_TRUE(holder.findClientList(RRClass::CH()));
         EXPECT_EQ(2, holder.getClasses().size());
+        EXPECT_EQ(1, holder.getDataGeneration());
     }
     // We need to clear command queue by hand
     FakeDataSrcClientsBuilder::command_queue->clear();
@@ -193,6 +196,7 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_TRUE(holder.findClientList(RRClass::IN()));
         EXPECT_FALSE(holder.findClientList(RRClass::CH()));
         EXPECT_EQ(RRClass::IN(), holder.getClasses()[0]);
+        EXPECT_EQ(2, holder.getDataGeneration());
     }
 
     // Duplicate lock acquisition is prohibited (only test mgr can detect
@@ -201,6 +205,39 @@ TEST(DataSrcClientsMgrTest, holder) {
     EXPECT_THROW(TestDataSrcClientsMgr::Holder holder2(mgr), bundy::Unexpected);
 }
 
+// A change of a zone only changes the generation of that zone, while a
+// change of all data changes the generation of every zone.
+TEST(DataGenerationsTest, zoneGeneration) {
+    DataGenerations generations;
+    const Name org("example.org"), net("example.net");
+    EXPECT_EQ(0, generations.getGeneration());
+    EXPECT_EQ(0, generations.getZoneGeneration(RRClass::IN(), org));
+
+    generations.changeZone(RRClass::IN(), org);
+    EXPECT_EQ(1, generations.getGeneration());
+    EXPECT_EQ(1, generations.getZoneGeneration(RRClass::IN(), org));
+    // The zone name is case insensitive.
+    EXPECT_EQ(1, generations.getZoneGeneration(RRClass::IN(),
+                                               Name("EXAMPLE.ORG")));
+    EXPECT_EQ(0, generations.getZoneGeneration(RRClass::IN(), net));
+
+    generations.changeAll();
+    EXPECT_EQ(2, generations.getGeneration());
+    EXPECT_EQ(2, generations.getZoneGeneration(RRClass::IN(), org));
+    EXPECT_EQ(2, generations.getZoneGeneration(RRClass::IN(), net));
+
+    generations.changeZone(RRClass::IN(), net);
+    EXPECT_EQ(2, generations.getZoneGeneration(RRClass::IN(), org));
+    EXPECT_EQ(3, generations.getZoneGeneration(RRClass::IN(), net));
+
+    // The generation can also be taken by the zone ID.
+    const size_t net_id = DataGenerations::getZoneID(RRClass::IN(), net);
+    EXPECT_GT(DataGenerations::ZONE_SLOTS, net_id);
+    EXPECT_EQ(net_id, DataGenerations::getZoneID(RRClass::IN(),
+                                                 Name("Example.Net")));
+    EXPECT_EQ(3, generations.getZoneGeneration(net_id));
+}
+
 namespace {
 /* wrapper for hiding the optional argument for loadZone(). */
 void loadZoneWrapper(TestDataSrcClientsMgr* mgr, const ConstElementPtr& args) {
@@ -253,6 +253,19 @@ public:
         const Name name(ls.toText());
         return (calculate(name));
     }
+    virtual void calculateBatch(const LabelSequence* const labels[],
+                                size_t count, string hashes[]) const
+    {
+        // Names unknown to the map are allowed here, as the in-memory
+        // finder also hashes a few names it may not need (like wildcards
+        // for its NSEC3 hash cache).  If such a value is actually used
+        // the empty string makes findNSEC3() fail.
+        for (size_t i = 0; i < count; ++i) {
+            const NSEC3HashMap::const_iterator found =
+                hash_map_.find(Name(labels[i]->toText()));
+            hashes[i] = (found != hash_map_.end()) ? found->second : "";
+        }
+    }
     virtual bool match(const rdata::generic::NSEC3PARAM&) const {
         return (true);
     }
@@ -1213,6 +1226,22 @@ TEST_P(QueryTest, exactMatch) {
                   www_a_txt, zone_ns_txt, ns_addrs_txt);
 }
 
+TEST_P(QueryTest, fromMemory) {
+    // Only responses from the in-memory data source are marked so.
+    query.process(*list_, qname, qtype, response);
+    EXPECT_EQ(GetParam() == INMEMORY, query.isFromMemory());
+    if (GetParam() == INMEMORY) {
+        EXPECT_EQ(Name("example.com"), query.getZoneName());
+    }
+
+    // A response without zone data is never marked.
+    MockClient empty_mock_client;
+    SingletonList empty_list(empty_mock_client);
+    response.clear(bundy::dns::Message::RENDER);
+    query.process(empty_list, qname, qtype, response);
+    EXPECT_FALSE(query.isFromMemory());
+}
+
 TEST_P(QueryTest, exactMatchMultipleQueries) {
     EXPECT_NO_THROW(query.process(*list_, qname, qtype, response));
     // find match rrset
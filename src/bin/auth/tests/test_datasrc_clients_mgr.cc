@@ -96,6 +96,7 @@ TestDataSrcClientsMgrBase::reconfigureHook() {
     assert(command_queue_.front().id == RECONFIGURE);
     try {
         clients_map_ = configureDataSource(command_queue_.front().params);
+        data_generations_.changeAll();
     } catch (...) {}
 }
 
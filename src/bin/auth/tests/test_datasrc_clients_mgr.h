@@ -71,6 +71,9 @@ public:
     private:
         TestMutex& mutex_;
     };
+    // Shared locks are counted the same way, so a test can't tell them
+    // from exclusive ones; duplicate acquisition is still an error.
+    typedef Locker ReaderLocker;
     size_t lock_count; // number of lock acquisitions; tests can check this
     size_t unlock_count; // number of lock releases; tests can check this
     size_t noop_count;          // allow doNoop() to modify this
@@ -162,7 +165,8 @@ public:
         TestCondVar* cond,
         TestMutex* queue_mutex,
         bundy::datasrc::ClientListMapPtr* clients_map,
-        TestMutex* map_mutex, int wakeup_fd)
+        TestMutex* map_mutex, DataGenerations*, ZoneMemoryUsageMap*,
+        int wakeup_fd)
     {
         FakeDataSrcClientsBuilder::started = false;
         FakeDataSrcClientsBuilder::command_queue = command_queue;
@@ -0,0 +1,468 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/xfrout.h>
+
+#include <exceptions/exceptions.h>
+
+#include <cc/data.h>
+
+#include <datasrc/client_list.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <dns/tsig.h>
+#include <dns/tsigerror.h>
+#include <dns/tsigkey.h>
+
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy;
+using namespace bundy::auth;
+using namespace bundy::datasrc;
+using namespace bundy::dns;
+using bundy::util::InputBuffer;
+
+namespace {
+
+typedef vector<vector<uint8_t> > Messages;
+
+// Build a transfer request, optionally with an SOA in the authority
+// section and signed with TSIG.
+vector<uint8_t>
+makeRequest(const Name& zone, const RRType& type,
+            ConstRRsetPtr soa = ConstRRsetPtr(),
+            TSIGContext* tsig_context = NULL)
+{
+    Message request(Message::RENDER);
+    request.setQid(4649);
+    request.setOpcode(Opcode::QUERY());
+    request.setRcode(Rcode::NOERROR());
+    request.addQuestion(Question(zone, RRClass::IN(), type));
+    if (soa) {
+        request.addRRset(Message::SECTION_AUTHORITY,
+                         boost::const_pointer_cast<AbstractRRset>(soa));
+    }
+    MessageRenderer renderer;
+    request.toWire(renderer, tsig_context);
+    const uint8_t* data = static_cast<const uint8_t*>(renderer.getData());
+    return (vector<uint8_t>(data, data + renderer.getLength()));
+}
+
+ConstRRsetPtr
+makeSOA(const Name& zone, uint32_t serial) {
+    RRsetPtr soa(new RRset(zone, RRClass::IN(), RRType::SOA(),
+                           RRTTL(3600)));
+    soa->addRdata(rdata::createRdata(
+                      RRType::SOA(), RRClass::IN(),
+                      "ns1.example. bugs.x.w.example. " +
+                      boost::lexical_cast<string>(serial) +
+                      " 3600 300 3600000 3600"));
+    return (soa);
+}
+
+void
+addMessage(Messages* messages, const void* data, size_t length) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    messages->push_back(vector<uint8_t>(p, p + length));
+}
+
+// Parse a response message
+void
+parseMessage(const vector<uint8_t>& data, Message& message) {
+    InputBuffer buffer(&data[0], data.size());
+    message.fromWire(buffer);
+}
+
+class XfroutRendererTest : public ::testing::Test {
+protected:
+    XfroutRendererTest() :
+        request_(Message::PARSE), origin_("example")
+    {
+        const vector<uint8_t> data = makeRequest(origin_, RRType::AXFR());
+        InputBuffer buffer(&data[0], data.size());
+        request_.fromWire(buffer);
+    }
+
+    // An A RRset with the given number of RRs
+    RRsetPtr makeA(const string& name, int count) {
+        RRsetPtr rrset(new RRset(Name(name), RRClass::IN(), RRType::A(),
+                                 RRTTL(3600)));
+        for (int i = 0; i < count; ++i) {
+            rrset->addRdata(rdata::createRdata(
+                                RRType::A(), RRClass::IN(),
+                                "192.0.2." + boost::lexical_cast<string>(i)));
+        }
+        return (rrset);
+    }
+
+    Message request_;
+    const Name origin_;
+    Messages messages_;
+};
+
+TEST_F(XfroutRendererTest, singleMessage) {
+    XfroutRenderer renderer(request_, NULL,
+                            boost::bind(addMessage, &messages_, _1, _2));
+    renderer.addRRset(*makeSOA(origin_, 1));
+    renderer.addRRset(*makeA("a.example", 2));
+    renderer.addRRset(*makeSOA(origin_, 1));
+    EXPECT_TRUE(messages_.empty());
+    renderer.finish();
+    ASSERT_EQ(1, messages_.size());
+    EXPECT_EQ(1, renderer.getMessageCount());
+
+    Message response(Message::PARSE);
+    parseMessage(messages_[0], response);
+    EXPECT_EQ(4649, response.getQid());
+    EXPECT_TRUE(response.getHeaderFlag(Message::HEADERFLAG_QR));
+    EXPECT_TRUE(response.getHeaderFlag(Message::HEADERFLAG_AA));
+    EXPECT_EQ(Rcode::NOERROR(), response.getRcode());
+    EXPECT_EQ(1, response.getRRCount(Message::SECTION_QUESTION));
+    EXPECT_EQ(4, response.getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ(0, response.getRRCount(Message::SECTION_ADDITIONAL));
+}
+
+TEST_F(XfroutRendererTest, multipleMessages) {
+    // Each message can hold a few A RRs only
+    const size_t max_length = 100;
+    XfroutRenderer renderer(request_, NULL,
+                            boost::bind(addMessage, &messages_, _1, _2),
+                            max_length);
+    for (int i = 0; i < 10; ++i) {
+        renderer.addRRset(*makeA("a" + boost::lexical_cast<string>(i) +
+                                 ".example", 1));
+    }
+    // This one is too large for a message and split into RRs
+    renderer.addRRset(*makeA("b.example", 10));
+    renderer.finish();
+    EXPECT_LT(1, messages_.size());
+    EXPECT_EQ(messages_.size(), renderer.getMessageCount());
+
+    size_t count = 0;
+    for (size_t i = 0; i < messages_.size(); ++i) {
+        EXPECT_GE(max_length, messages_[i].size());
+        Message response(Message::PARSE);
+        parseMessage(messages_[i], response);
+        // Only the first message has the question
+        EXPECT_EQ(i == 0 ? 1 : 0,
+                  response.getRRCount(Message::SECTION_QUESTION));
+        EXPECT_LT(0, response.getRRCount(Message::SECTION_ANSWER));
+        count += response.getRRCount(Message::SECTION_ANSWER);
+    }
+    EXPECT_EQ(20, count);
+}
+
+TEST_F(XfroutRendererTest, tooLargeRR) {
+    XfroutRenderer renderer(request_, NULL,
+                            boost::bind(addMessage, &messages_, _1, _2), 40);
+    EXPECT_THROW(renderer.addRRset(*makeA("a-very-long-label-in-the-name."
+                                          "example", 1)),
+                 XfroutError);
+}
+
+TEST_F(XfroutRendererTest, tsig) {
+    const TSIGKey key("key:QkFECg==:hmac-sha1");
+    TSIGContext client_context(key);
+    TSIGContext server_context(key);
+
+    // Sign the request by the client and verify it by the server, so the
+    // client can verify the responses.
+    const vector<uint8_t> data = makeRequest(origin_, RRType::AXFR(),
+                                             ConstRRsetPtr(),
+                                             &client_context);
+    Message request(Message::PARSE);
+    parseMessage(data, request);
+    ASSERT_TRUE(request.getTSIGRecord() != NULL);
+    ASSERT_EQ(TSIGError::NOERROR(),
+              server_context.verify(request.getTSIGRecord(), &data[0],
+                                    data.size()));
+
+    const size_t max_length = 200;
+    XfroutRenderer renderer(request, &server_context,
+                            boost::bind(addMessage, &messages_, _1, _2),
+                            max_length);
+    for (int i = 0; i < 10; ++i) {
+        renderer.addRRset(*makeA("a" + boost::lexical_cast<string>(i) +
+                                 ".example", 1));
+    }
+    renderer.finish();
+    EXPECT_LT(1, messages_.size());
+
+    // Every message is signed and fits the limit with the TSIG.
+    for (size_t i = 0; i < messages_.size(); ++i) {
+        EXPECT_GE(max_length, messages_[i].size());
+        Message response(Message::PARSE);
+        parseMessage(messages_[i], response);
+        ASSERT_TRUE(response.getTSIGRecord() != NULL);
+        EXPECT_EQ(TSIGError::NOERROR(),
+                  client_context.verify(response.getTSIGRecord(),
+                                        &messages_[i][0],
+                                        messages_[i].size()));
+    }
+}
+
+class XfroutSessionTest : public ::testing::Test {
+protected:
+    XfroutSessionTest() :
+        origin_("example"), list_(new ConfigurableClientList(RRClass::IN()))
+    {
+        list_->configure(data::Element::fromJSON(
+                             "[{\"type\": \"MasterFiles\","
+                             "  \"cache-enable\": true, "
+                             "  \"params\": {\"example\": \"" +
+                             string(TEST_DATA_DIR
+                                    "/rfc5155-example.zone.signed") +
+                             "\"}}]"), true);
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds_) == -1) {
+            bundy_throw(Unexpected, "socketpair failed");
+        }
+    }
+
+    ~XfroutSessionTest() {
+        // fds_[0] is closed by the session
+        close(fds_[1]);
+    }
+
+    // Create a session for the given request, render the response and
+    // send it part by part, and receive the messages.
+    void transfer(const vector<uint8_t>& request, ClientList* list) {
+        XfroutSession session(fds_[0], "client", &request[0],
+                              request.size(),
+                              unique_ptr<TSIGContext>());
+        session.start(list);
+        while (session.send() && !session.isComplete()) {
+            session.renderNext();
+        }
+        EXPECT_TRUE(session.isComplete());
+        EXPECT_EQ(session.getMessageCount(), receive());
+    }
+
+    // Read all data from the socket and split it into messages.  The
+    // sending side has been closed.
+    size_t receive() {
+        shutdown(fds_[1], SHUT_WR);
+        vector<uint8_t> data;
+        uint8_t buf[4096];
+        ssize_t n;
+        while ((n = read(fds_[1], buf, sizeof(buf))) > 0) {
+            data.insert(data.end(), buf, buf + n);
+        }
+        size_t pos = 0;
+        while (pos + 2 <= data.size()) {
+            const size_t length = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+            EXPECT_GE(data.size(), pos + length);
+            responses_.push_back(vector<uint8_t>(data.begin() + pos,
+                                                 data.begin() + pos +
+                                                 length));
+            pos += length;
+        }
+        EXPECT_EQ(data.size(), pos);
+        return (responses_.size());
+    }
+
+    // Return all answer RRsets of the responses
+    vector<ConstRRsetPtr> getAnswers(const Rcode& expected_rcode =
+                                     Rcode::NOERROR())
+    {
+        vector<ConstRRsetPtr> answers;
+        for (size_t i = 0; i < responses_.size(); ++i) {
+            Message response(Message::PARSE);
+            parseMessage(responses_[i], response);
+            EXPECT_EQ(expected_rcode, response.getRcode());
+            for (RRsetIterator it =
+                     response.beginSection(Message::SECTION_ANSWER);
+                 it != response.endSection(Message::SECTION_ANSWER); ++it) {
+                answers.push_back(*it);
+            }
+        }
+        return (answers);
+    }
+
+    const Name origin_;
+    boost::shared_ptr<ConfigurableClientList> list_;
+    int fds_[2];
+    Messages responses_;
+};
+
+TEST_F(XfroutSessionTest, axfr) {
+    transfer(makeRequest(origin_, RRType::AXFR()), list_.get());
+    ASSERT_EQ(1, responses_.size());
+
+    const vector<ConstRRsetPtr> answers = getAnswers();
+    ASSERT_LT(2, answers.size());
+    // The SOA is at the beginning and end, without RRSIGs, and nowhere
+    // else.  The RRSIG of the SOA is in the middle.
+    EXPECT_EQ(RRType::SOA(), answers.front()->getType());
+    EXPECT_EQ(RRType::SOA(), answers.back()->getType());
+    bool found_soa_sig = false;
+    for (size_t i = 1; i < answers.size() - 1; ++i) {
+        EXPECT_NE(RRType::SOA(), answers[i]->getType());
+        if (answers[i]->getType() == RRType::RRSIG() &&
+            answers[i]->getName() == origin_) {
+            found_soa_sig = true;
+        }
+    }
+    EXPECT_TRUE(found_soa_sig);
+}
+
+TEST_F(XfroutSessionTest, notAuth) {
+    transfer(makeRequest(Name("example.org"), RRType::AXFR()), list_.get());
+    ASSERT_EQ(1, responses_.size());
+    EXPECT_TRUE(getAnswers(Rcode::NOTAUTH()).empty());
+}
+
+TEST_F(XfroutSessionTest, noList) {
+    transfer(makeRequest(origin_, RRType::AXFR()), NULL);
+    ASSERT_EQ(1, responses_.size());
+    EXPECT_TRUE(getAnswers(Rcode::NOTAUTH()).empty());
+}
+
+TEST_F(XfroutSessionTest, ixfrUpToDate) {
+    // The serial of the zone is 1
+    transfer(makeRequest(origin_, RRType::IXFR(), makeSOA(origin_, 1)),
+             list_.get());
+    const vector<ConstRRsetPtr> answers = getAnswers();
+    ASSERT_EQ(1, answers.size());
+    EXPECT_EQ(RRType::SOA(), answers[0]->getType());
+}
+
+TEST_F(XfroutSessionTest, ixfrAXFRStyle) {
+    // In-memory data sources don't have journals
+    transfer(makeRequest(origin_, RRType::IXFR(), makeSOA(origin_, 0)),
+             list_.get());
+    const vector<ConstRRsetPtr> answers = getAnswers();
+    ASSERT_LT(2, answers.size());
+    EXPECT_EQ(RRType::SOA(), answers.front()->getType());
+    EXPECT_EQ(RRType::SOA(), answers.back()->getType());
+    EXPECT_NE(RRType::SOA(), answers[1]->getType());
+}
+
+TEST_F(XfroutSessionTest, ixfrWithoutSOA) {
+    transfer(makeRequest(origin_, RRType::IXFR()), list_.get());
+    ASSERT_EQ(1, responses_.size());
+    EXPECT_TRUE(getAnswers(Rcode::FORMERR()).empty());
+}
+
+TEST_F(XfroutSessionTest, sendFailure) {
+    // The client has gone.  (SIGPIPE is suppressed by send().)
+    const vector<uint8_t> request = makeRequest(origin_, RRType::AXFR());
+    XfroutSession session(fds_[0], "client", &request[0], request.size(),
+                          unique_ptr<TSIGContext>());
+    session.start(list_.get());
+    session.renderNext();
+    session.cancel();
+    EXPECT_FALSE(session.send());
+}
+
+TEST_F(XfroutSessionTest, sendTimeout) {
+    // The session doesn't block on the socket.
+    const vector<uint8_t> request = makeRequest(origin_, RRType::AXFR());
+    XfroutSession session(fds_[0], "client", &request[0], request.size(),
+                          unique_ptr<TSIGContext>(), 100);
+    EXPECT_NE(0, fcntl(fds_[0], F_GETFL, 0) & O_NONBLOCK);
+
+    // The client doesn't read anything, and the socket buffer is full.
+    const vector<uint8_t> data(4096);
+    while (write(fds_[0], &data[0], data.size()) > 0) {
+        ;
+    }
+    session.start(list_.get());
+    session.renderNext();
+    ASSERT_TRUE(session.isComplete());
+    EXPECT_FALSE(session.send());
+}
+
+// A large zone is rendered in batches of messages.
+TEST_F(XfroutSessionTest, batches) {
+    const string zone_file = TEST_DATA_BUILDDIR "/xfrout-large.zone";
+    {
+        std::ofstream zone(zone_file.c_str());
+        zone << "example. 3600 IN SOA ns1.example. bugs.x.w.example. "
+            "1 3600 300 3600000 3600\n"
+            "example. 3600 IN NS ns1.example.\n";
+        const string txt(200, 'x');
+        for (size_t i = 0; i < 10000; ++i) {
+            zone << "t" << i << ".example. 3600 IN TXT " << txt << "\n";
+        }
+    }
+    list_->configure(data::Element::fromJSON(
+                         "[{\"type\": \"MasterFiles\","
+                         "  \"cache-enable\": true, "
+                         "  \"params\": {\"example\": \"" + zone_file +
+                         "\"}}]"), true);
+    std::remove(zone_file.c_str());
+
+    const vector<uint8_t> request = makeRequest(origin_, RRType::AXFR());
+    XfroutSession session(fds_[0], "client", &request[0], request.size(),
+                          unique_ptr<TSIGContext>());
+    session.start(list_.get());
+    EXPECT_TRUE(session.isFromCache());
+    EXPECT_FALSE(session.isComplete());
+    EXPECT_EQ(0, session.getMessageCount());
+    size_t batches = 0;
+    while (!session.isComplete()) {
+        const size_t count = session.getMessageCount();
+        session.renderNext();
+        EXPECT_GE(XfroutSession::BATCH_MESSAGES,
+                  session.getMessageCount() - count);
+        ++batches;
+    }
+    // About 2MB of data, in messages of up to 64KB
+    EXPECT_LT(XfroutSession::BATCH_MESSAGES, session.getMessageCount());
+    EXPECT_LT(1, batches);
+}
+
+TEST(XfroutConfigTest, construct) {
+    const boost::shared_ptr<const acl::dns::RequestACL> acl(
+        acl::dns::getRequestLoader().load(
+            data::Element::fromJSON("[{\"action\": \"ACCEPT\"}]")));
+    const XfroutConfig config(10, acl);
+    EXPECT_EQ(10, config.getMaxTransfers());
+    EXPECT_EQ(acl.get(), &config.getACL());
+
+    EXPECT_THROW(XfroutConfig(0, acl), InvalidParameter);
+    EXPECT_THROW(XfroutConfig(10,
+                              boost::shared_ptr<const acl::dns::RequestACL>()),
+                 InvalidParameter);
+}
+
+}
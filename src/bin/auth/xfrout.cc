@@ -0,0 +1,552 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/xfrout.h>
+#include <auth/auth_log.h>
+
+#include <exceptions/exceptions.h>
+
+#include <datasrc/client.h>
+#include <datasrc/client_list.h>
+#include <datasrc/exceptions.h>
+#include <datasrc/zone_finder.h>
+#include <datasrc/zone_iterator.h>
+#include <datasrc/memory/memory_client.h>
+
+#include <dns/message.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <dns/serial.h>
+
+#include <util/buffer.h>
+
+#include <boost/bind.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace bundy::dns;
+using namespace bundy::datasrc;
+using boost::shared_ptr;
+
+namespace bundy {
+namespace auth {
+
+namespace {
+// The offsets of the header fields of a DNS message
+const size_t HEADER_QID_POS = 0;
+const size_t HEADER_FLAGS_POS = 2;
+const size_t HEADER_QDCOUNT_POS = 4;
+const size_t HEADER_ANCOUNT_POS = 6;
+const size_t HEADER_NSCOUNT_POS = 8;
+const size_t HEADER_ARCOUNT_POS = 10;
+const size_t HEADER_LEN = 12;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;   // SIGPIPE is ignored by the server anyway
+#endif
+
+// Return a copy of the given RRset without RRSIGs.  The SOA at the
+// beginning and end of a transfer must not be followed by its signatures,
+// but the one from the data source may have them attached.
+ConstRRsetPtr
+stripRRsig(const AbstractRRset& rrset) {
+    RRsetPtr copy(new RRset(rrset.getName(), rrset.getClass(),
+                            rrset.getType(), rrset.getTTL()));
+    for (RdataIteratorPtr it = rrset.getRdataIterator(); !it->isLast();
+         it->next()) {
+        copy->addRdata(it->getCurrent());
+    }
+    return (copy);
+}
+
+uint32_t
+getSOASerial(const AbstractRRset& soa) {
+    return (dynamic_cast<const rdata::generic::SOA&>(
+                soa.getRdataIterator()->getCurrent()).getSerial().getValue());
+}
+}
+
+XfroutConfig::XfroutConfig(
+    size_t max_transfers,
+    const shared_ptr<const acl::dns::RequestACL>& acl) :
+    max_transfers_(max_transfers), acl_(acl)
+{
+    if (max_transfers_ == 0) {
+        bundy_throw(InvalidParameter,
+                    "The maximum number of transfers must not be 0");
+    }
+    if (!acl_) {
+        bundy_throw(InvalidParameter, "Empty transfer ACL");
+    }
+}
+
+XfroutRenderer::XfroutRenderer(const Message& request,
+                               TSIGContext* tsig_context,
+                               const MessageCallback& callback,
+                               size_t max_length) :
+    qid_(request.getQid()),
+    question_(*request.beginQuestion()),
+    tsig_context_(tsig_context),
+    callback_(callback),
+    max_length_(max_length),
+    qdcount_(0),
+    ancount_(0),
+    message_count_(0)
+{
+    startMessage();
+}
+
+void
+XfroutRenderer::startMessage() {
+    renderer_.clear();
+    renderer_.setCompressMode(MessageRenderer::CASE_SENSITIVE);
+    renderer_.setLengthLimit(max_length_ -
+                             (tsig_context_ != NULL ?
+                              tsig_context_->getTSIGLength() : 0));
+    renderer_.skip(HEADER_LEN);
+    qdcount_ = 0;
+    ancount_ = 0;
+
+    // Only the first message has the question (RFC 5936, Section 2.2).
+    if (message_count_ == 0) {
+        question_->toWire(renderer_);
+        qdcount_ = 1;
+    }
+}
+
+bool
+XfroutRenderer::renderRRset(const AbstractRRset& rrset) {
+    const size_t pos = renderer_.getLength();
+    const unsigned int count = rrset.toWire(renderer_);
+    if (renderer_.isTruncated()) {
+        // The names in the partially rendered RRs may remain in the
+        // compression table, so nothing can be added to this message any
+        // more; the caller starts a new one.
+        renderer_.trim(renderer_.getLength() - pos);
+        return (false);
+    }
+    ancount_ += count;
+    return (true);
+}
+
+void
+XfroutRenderer::addRRset(const AbstractRRset& rrset) {
+    if (renderRRset(rrset)) {
+        return;
+    }
+    if (ancount_ > 0) {
+        flushMessage();
+        startMessage();
+        if (renderRRset(rrset)) {
+            return;
+        }
+    }
+
+    // It doesn't fit even in an empty message.  Split it into RRs and
+    // RRSIGs, unless it's already a single RR.
+    startMessage();
+    const RRsetPtr sigs = rrset.getRRsig();
+    if (rrset.getRdataCount() <= 1 && !sigs) {
+        bundy_throw(XfroutError, "RR too large for a message: " <<
+                    rrset.getName() << "/" << rrset.getType());
+    }
+    for (RdataIteratorPtr it = rrset.getRdataIterator(); !it->isLast();
+         it->next()) {
+        BasicRRset rr(rrset.getName(), rrset.getClass(), rrset.getType(),
+                      rrset.getTTL());
+        rr.addRdata(it->getCurrent());
+        addRRset(rr);
+    }
+    if (sigs) {
+        addRRset(*sigs);
+    }
+}
+
+void
+XfroutRenderer::flushMessage() {
+    renderer_.writeUint16At(qid_, HEADER_QID_POS);
+    renderer_.writeUint16At(Message::HEADERFLAG_QR | Message::HEADERFLAG_AA |
+                            (Opcode::QUERY().getCode() << 11) |
+                            Rcode::NOERROR().getCode(), HEADER_FLAGS_POS);
+    renderer_.writeUint16At(qdcount_, HEADER_QDCOUNT_POS);
+    renderer_.writeUint16At(ancount_, HEADER_ANCOUNT_POS);
+    renderer_.writeUint16At(0, HEADER_NSCOUNT_POS);
+    renderer_.writeUint16At(0, HEADER_ARCOUNT_POS);
+
+    if (tsig_context_ != NULL) {
+        // The space for the TSIG RR was reserved in startMessage().
+        renderer_.setLengthLimit(max_length_);
+        const ConstTSIGRecordPtr tsig =
+            tsig_context_->sign(qid_, renderer_.getData(),
+                                renderer_.getLength());
+        if (tsig->toWire(renderer_) != 1) {
+            bundy_throw(Unexpected, "Failed to render a TSIG RR");
+        }
+        renderer_.writeUint16At(1, HEADER_ARCOUNT_POS);
+    }
+
+    callback_(renderer_.getData(), renderer_.getLength());
+    ++message_count_;
+}
+
+void
+XfroutRenderer::finish() {
+    flushMessage();
+}
+
+const int XfroutSession::DEFAULT_SEND_TIMEOUT;
+const size_t XfroutSession::BATCH_MESSAGES;
+
+XfroutSession::XfroutSession(int fd, const std::string& client,
+                             const void* request_data, size_t request_length,
+                             std::unique_ptr<TSIGContext> tsig_context,
+                             int send_timeout) :
+    fd_(fd),
+    client_(client),
+    send_timeout_(send_timeout),
+    request_(Message::PARSE),
+    tsig_context_(std::move(tsig_context)),
+    output_(0),
+    message_count_(0),
+    sent_length_(0),
+    from_cache_(false),
+    complete_(false),
+    failed_(false),
+    error_response_(false)
+{
+    try {
+        util::InputBuffer buffer(request_data, request_length);
+        request_.fromWire(buffer);
+        if (request_.getRRCount(Message::SECTION_QUESTION) != 1) {
+            bundy_throw(BadValue, "Transfer request must have 1 question");
+        }
+        // send() relies on the non-blocking mode for its timeout.
+        const int flags = fcntl(fd_, F_GETFL, 0);
+        if (flags == -1 ||
+            ((flags & O_NONBLOCK) == 0 &&
+             fcntl(fd_, F_SETFL, flags | O_NONBLOCK) == -1)) {
+            bundy_throw(Unexpected, "failed to make the transfer socket "
+                        "non-blocking: " << std::strerror(errno));
+        }
+    } catch (...) {
+        close(fd_);
+        throw;
+    }
+}
+
+XfroutSession::~XfroutSession() {
+    close(fd_);
+}
+
+const Name&
+XfroutSession::getZoneName() const {
+    return ((*request_.beginQuestion())->getName());
+}
+
+const RRClass&
+XfroutSession::getZoneClass() const {
+    return ((*request_.beginQuestion())->getClass());
+}
+
+const RRType&
+XfroutSession::getType() const {
+    return ((*request_.beginQuestion())->getType());
+}
+
+void
+XfroutSession::start(ClientList* list) {
+    LOG_INFO(auth_logger, AUTH_XFROUT_STARTED).arg(getType()).arg(client_)
+        .arg(getZoneName()).arg(getZoneClass());
+
+    const Rcode* rcode;
+    try {
+        rcode = &startResponse(list);
+    } catch (const bundy::Exception& ex) {
+        LOG_ERROR(auth_logger, AUTH_XFROUT_RENDER_FAILED).arg(getType())
+            .arg(client_).arg(getZoneName()).arg(getZoneClass())
+            .arg(ex.what());
+        rcode = &Rcode::SERVFAIL();
+    }
+    if (*rcode != Rcode::NOERROR()) {
+        LOG_INFO(auth_logger, AUTH_XFROUT_ERROR_RESPONSE).arg(getType())
+            .arg(client_).arg(getZoneName()).arg(getZoneClass()).arg(*rcode);
+        renderErrorResponse(*rcode);
+    }
+}
+
+const Rcode&
+XfroutSession::startResponse(ClientList* list) {
+    if (list == NULL) {
+        return (Rcode::NOTAUTH());
+    }
+    const Name& zone_name = getZoneName();
+    const ClientList::FindResult result(list->find(zone_name, true, true));
+    if (result.dsrc_client_ == NULL) {
+        return (Rcode::NOTAUTH());
+    }
+    keeper_ = result.life_keeper_;
+    from_cache_ = (dynamic_cast<const memory::InMemoryClient*>(
+                       result.dsrc_client_) != NULL);
+
+    renderer_.reset(new XfroutRenderer(
+                        request_, tsig_context_.get(),
+                        boost::bind(&XfroutSession::addMessage, this,
+                                    _1, _2)));
+    if (getType() != RRType::IXFR()) {
+        return (startAXFR(*result.dsrc_client_));
+    }
+
+    // IXFR: the request must have the SOA of the client's version of the
+    // zone in the authority section (RFC 1995, Section 3).
+    ConstRRsetPtr remote_soa;
+    for (RRsetIterator it =
+             request_.beginSection(Message::SECTION_AUTHORITY);
+         it != request_.endSection(Message::SECTION_AUTHORITY); ++it) {
+        if ((*it)->getType() == RRType::SOA() &&
+            (*it)->getName() == zone_name &&
+            (*it)->getClass() == getZoneClass() &&
+            (*it)->getRdataCount() == 1) {
+            remote_soa = *it;
+            break;
+        }
+    }
+    if (!remote_soa) {
+        return (Rcode::FORMERR());
+    }
+    if (!result.finder_) {
+        return (Rcode::SERVFAIL());
+    }
+    const ZoneFinderContextPtr soa_context =
+        result.finder_->find(zone_name, RRType::SOA());
+    if (soa_context->code != ZoneFinder::SUCCESS ||
+        soa_context->rrset->getRdataCount() != 1) {
+        return (Rcode::SERVFAIL());
+    }
+    const ConstRRsetPtr local_soa = stripRRsig(*soa_context->rrset);
+    const uint32_t begin_serial = getSOASerial(*remote_soa);
+    const uint32_t end_serial = getSOASerial(*local_soa);
+
+    if (Serial(begin_serial) >= Serial(end_serial)) {
+        // The client is up to date; the response is the SOA only.
+        LOG_INFO(auth_logger, AUTH_XFROUT_IXFR_UPTODATE).arg(client_)
+            .arg(zone_name).arg(getZoneClass()).arg(begin_serial)
+            .arg(end_serial);
+        renderer_->addRRset(*local_soa);
+        finishResponse();
+        return (Rcode::NOERROR());
+    }
+
+    std::pair<ZoneJournalReader::Result, ZoneJournalReaderPtr> journal;
+    try {
+        journal = result.dsrc_client_->getJournalReader(zone_name,
+                                                        begin_serial,
+                                                        end_serial);
+    } catch (const bundy::NotImplemented&) {
+        journal.first = ZoneJournalReader::NO_SUCH_VERSION;
+    }
+    if (journal.first == ZoneJournalReader::NO_SUCH_ZONE) {
+        return (Rcode::NOTAUTH());
+    }
+    if (journal.first != ZoneJournalReader::SUCCESS) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_XFROUT_IXFR_AXFR_STYLE)
+            .arg(client_).arg(zone_name).arg(getZoneClass())
+            .arg(begin_serial).arg(end_serial);
+        return (startAXFR(*result.dsrc_client_));
+    }
+
+    // The differences follow in renderNext()
+    renderer_->addRRset(*local_soa);
+    journal_ = journal.second;
+    soa_ = local_soa;
+    return (Rcode::NOERROR());
+}
+
+const Rcode&
+XfroutSession::startAXFR(const DataSourceClient& client) {
+    ZoneIteratorPtr iterator;
+    try {
+        iterator = client.getIterator(getZoneName(), false);
+    } catch (const DataSourceError&) {
+        // No such zone or the zone is empty
+        return (Rcode::NOTAUTH());
+    }
+    const ConstRRsetPtr soa = iterator->getSOA();
+    if (!soa || soa->getRdataCount() != 1) {
+        return (Rcode::SERVFAIL());
+    }
+
+    // The rest of the zone follows in renderNext()
+    soa_ = stripRRsig(*soa);
+    renderer_->addRRset(*soa_);
+    iterator_ = iterator;
+    return (Rcode::NOERROR());
+}
+
+void
+XfroutSession::renderNext() {
+    if (complete_) {
+        return;
+    }
+    const size_t first_message = message_count_;
+    try {
+        while (message_count_ - first_message < BATCH_MESSAGES) {
+            const ConstRRsetPtr rrset = iterator_ ?
+                iterator_->getNextRRset() : journal_->getNextDiff();
+            if (!rrset) {
+                renderer_->addRRset(*soa_);
+                finishResponse();
+                return;
+            }
+            if (iterator_ && rrset->getType() == RRType::SOA()) {
+                // The SOA is sent at the beginning and end, but its
+                // signatures are sent in the middle like any other RRset.
+                const RRsetPtr sigs = rrset->getRRsig();
+                if (sigs) {
+                    renderer_->addRRset(*sigs);
+                }
+                continue;
+            }
+            renderer_->addRRset(*rrset);
+        }
+    } catch (const bundy::Exception& ex) {
+        LOG_ERROR(auth_logger, AUTH_XFROUT_RENDER_FAILED).arg(getType())
+            .arg(client_).arg(getZoneName()).arg(getZoneClass())
+            .arg(ex.what());
+        if (sent_length_ == 0) {
+            LOG_INFO(auth_logger, AUTH_XFROUT_ERROR_RESPONSE).arg(getType())
+                .arg(client_).arg(getZoneName()).arg(getZoneClass())
+                .arg(Rcode::SERVFAIL());
+            renderErrorResponse(Rcode::SERVFAIL());
+        } else {
+            // Part of the response has been sent; all we can do is to
+            // close the connection.
+            failed_ = true;
+            finishResponse();
+        }
+    }
+}
+
+void
+XfroutSession::finishResponse() {
+    if (!failed_) {
+        renderer_->finish();
+    }
+    complete_ = true;
+    iterator_.reset();
+    journal_.reset();
+    keeper_.reset();
+}
+
+void
+XfroutSession::renderErrorResponse(const Rcode& rcode) {
+    // Discard anything rendered before the error
+    output_.clear();
+    message_count_ = 0;
+    error_response_ = true;
+    complete_ = true;
+    iterator_.reset();
+    journal_.reset();
+    keeper_.reset();
+
+    request_.makeResponse();
+    request_.setRcode(rcode);
+    MessageRenderer renderer;
+    renderer.setLengthLimit(XfroutRenderer::MAX_MESSAGE_SIZE);
+    request_.toWire(renderer, tsig_context_.get());
+    addMessage(renderer.getData(), renderer.getLength());
+}
+
+void
+XfroutSession::addMessage(const void* data, size_t length) {
+    // Messages over TCP are preceded by their length
+    output_.writeUint16(length);
+    output_.writeData(data, length);
+    ++message_count_;
+}
+
+bool
+XfroutSession::send() {
+    if (failed_) {
+        return (false);         // the reason has been logged
+    }
+    const size_t length = output_.getLength();
+    if (!sendData(static_cast<const uint8_t*>(output_.getData()), length)) {
+        return (false);
+    }
+    output_.clear();
+    sent_length_ += length;
+
+    if (complete_ && length > 0 && !error_response_) {
+        LOG_INFO(auth_logger, AUTH_XFROUT_DONE).arg(getType()).arg(client_)
+            .arg(getZoneName()).arg(getZoneClass()).arg(message_count_)
+            .arg(sent_length_);
+    }
+    return (true);
+}
+
+bool
+XfroutSession::sendData(const uint8_t* data, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        const ssize_t n = ::send(fd_, data + sent, length - sent, SEND_FLAGS);
+        if (n >= 0) {
+            sent += n;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        std::string error;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // Wait until the client accepts more data.  If the connection
+            // fails in the meantime, the next send() reports it.
+            struct pollfd pfd;
+            pfd.fd = fd_;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            const int result = poll(&pfd, 1, send_timeout_);
+            if (result > 0 || (result == -1 && errno == EINTR)) {
+                continue;
+            }
+            error = (result == 0) ? "timed out" : std::strerror(errno);
+        } else {
+            error = std::strerror(errno);
+        }
+        LOG_ERROR(auth_logger, AUTH_XFROUT_SEND_FAILED).arg(getType())
+            .arg(client_).arg(getZoneName()).arg(getZoneClass()).arg(error);
+        return (false);
+    }
+    return (true);
+}
+
+void
+XfroutSession::cancel() {
+    shutdown(fd_, SHUT_RDWR);
+}
+
+} // namespace auth
+} // namespace bundy
@@ -0,0 +1,300 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_XFROUT_H
+#define AUTH_XFROUT_H 1
+
+#include <exceptions/exceptions.h>
+
+#include <acl/dns.h>
+
+#include <datasrc/client.h>
+#include <datasrc/client_list.h>
+#include <datasrc/zone.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/rcode.h>
+#include <dns/rrset.h>
+#include <dns/tsig.h>
+
+#include <util/buffer.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <memory>
+#include <string>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace auth {
+
+/// \brief A zone transfer can't be completed.
+class XfroutError : public bundy::Exception {
+public:
+    XfroutError(const char* file, size_t line, const char* what) :
+        bundy::Exception(file, line, what)
+    {}
+};
+
+/// \brief Configuration of the outgoing zone transfers handled by
+/// bundy-auth itself.
+///
+/// It's an immutable set of parameters; a new object is created on
+/// reconfiguration.
+class XfroutConfig : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_transfers is 0 or acl is empty
+    ///
+    /// \param max_transfers The maximum number of transfers that can be
+    /// in progress at the same time.
+    /// \param acl The ACL applied to transfer requests.
+    XfroutConfig(size_t max_transfers,
+                 const boost::shared_ptr<const acl::dns::RequestACL>& acl);
+
+    /// \brief Return the maximum number of concurrent transfers.
+    size_t getMaxTransfers() const { return (max_transfers_); }
+
+    /// \brief Return the ACL applied to transfer requests.
+    const acl::dns::RequestACL& getACL() const { return (*acl_); }
+
+private:
+    const size_t max_transfers_;
+    const boost::shared_ptr<const acl::dns::RequestACL> acl_;
+};
+
+/// \brief Renderer of the messages of a zone transfer response.
+///
+/// RRsets added by \c addRRset() are rendered directly into the answer
+/// section of the current message, which is passed to the callback and
+/// replaced with a new one when the next RRset doesn't fit in it.  So each
+/// message is packed up to the size limit with the actual (compressed)
+/// size of the RRsets rather than an estimate.  The same
+/// \c dns::MessageRenderer, and so its name compression table, is used
+/// for all messages; names are compressed case-sensitively as required
+/// by RFC 5936.  Only the first message has the question section.
+///
+/// An RRset that is too large for a single message is split into its
+/// RRs (and RRSIGs).  If a single RR is too large, \c XfroutError is
+/// thrown.
+///
+/// If a TSIG context is given, every message is signed with it.
+class XfroutRenderer : boost::noncopyable {
+public:
+    /// \brief The callback type to receive rendered messages.
+    ///
+    /// The parameters are the data and the length of a complete DNS
+    /// message.
+    typedef boost::function<void(const void*, size_t)> MessageCallback;
+
+    /// \brief The maximum size of a DNS message over TCP.
+    static const size_t MAX_MESSAGE_SIZE = 65535;
+
+    /// \brief Constructor.
+    ///
+    /// \param request The transfer request (in the parse mode).  Its
+    /// question is copied to the first response message.
+    /// \param tsig_context The TSIG context to sign the messages with, or
+    /// NULL.  It must be valid throughout the lifetime of this object.
+    /// \param callback The callback called with each rendered message.
+    /// \param max_length The size limit of each message; only tests would
+    /// specify it.
+    XfroutRenderer(const dns::Message& request,
+                   dns::TSIGContext* tsig_context,
+                   const MessageCallback& callback,
+                   size_t max_length = MAX_MESSAGE_SIZE);
+
+    /// \brief Add an RRset to the answer section.
+    ///
+    /// \throw XfroutError An RR is too large for a message.
+    void addRRset(const dns::AbstractRRset& rrset);
+
+    /// \brief Complete the last message and pass it to the callback.
+    void finish();
+
+    /// \brief Return the number of messages passed to the callback so far.
+    size_t getMessageCount() const { return (message_count_); }
+
+private:
+    void startMessage();
+    void flushMessage();
+    bool renderRRset(const dns::AbstractRRset& rrset);
+
+    const dns::qid_t qid_;
+    const dns::ConstQuestionPtr question_;
+    dns::TSIGContext* const tsig_context_;
+    const MessageCallback callback_;
+    const size_t max_length_;
+    dns::MessageRenderer renderer_;
+    uint16_t qdcount_;
+    uint16_t ancount_;
+    size_t message_count_;
+};
+
+/// \brief An outgoing zone transfer over a TCP connection.
+///
+/// This class handles an AXFR or IXFR request passed from the server,
+/// much like \c XfroutSession of bundy-xfrout: it looks up the zone in
+/// the data sources, builds the response messages with
+/// \c XfroutRenderer and sends them to the client.
+///
+/// The response is streamed: \c start() looks up the zone and prepares
+/// the response, and then \c renderNext() builds the next few messages
+/// and \c send() sends them, until the response is complete.  Only
+/// \c start() and \c renderNext() access the data sources, so the
+/// caller holds the data sources only while calling them, in short
+/// steps; a slow client only delays the transfer itself.  If the zone is
+/// served from memory (see \c isFromCache()), the data must not change
+/// between the steps; the caller is expected to check it and abort the
+/// transfer otherwise.  Zones in other data sources are read with their
+/// own connection to the data source (see \c datasrc::ZoneIterator), so
+/// they don't depend on the data source clients after \c start().
+///
+/// IXFR requests are answered from the journal of the data source if
+/// it supports it; otherwise (which includes in-memory data sources),
+/// or if the journal doesn't have the requested range of differences,
+/// an AXFR-style IXFR response is returned.
+class XfroutSession : boost::noncopyable {
+public:
+    /// \brief The default timeout of sending a message, in milliseconds.
+    static const int DEFAULT_SEND_TIMEOUT = 30000;
+
+    /// \brief The number of messages built by a \c renderNext() call.
+    static const size_t BATCH_MESSAGES = 16;
+
+    /// \brief Constructor.
+    ///
+    /// The request is parsed again from the wire-format data, which is
+    /// copied, so the caller doesn't have to keep it.
+    ///
+    /// \throw dns::DNSProtocolError etc. The request can't be parsed
+    /// (which is unlikely as the server has already done it).
+    ///
+    /// \param fd The connected TCP socket to the client.  The session
+    /// takes its ownership and closes it on destruction.  It's switched
+    /// to the non-blocking mode if it isn't already.
+    /// \param client A textual representation of the client for logging.
+    /// \param request_data The request in the wire format.
+    /// \param request_length The length of \c request_data.
+    /// \param tsig_context The TSIG context that verified the request,
+    /// or NULL if it wasn't signed.  The ownership is transferred.
+    /// \param send_timeout How long \c send() waits for the client to
+    /// accept more data, in milliseconds.
+    XfroutSession(int fd, const std::string& client,
+                  const void* request_data, size_t request_length,
+                  std::unique_ptr<dns::TSIGContext> tsig_context,
+                  int send_timeout = DEFAULT_SEND_TIMEOUT);
+
+    /// \brief Destructor.  It closes the socket.
+    ~XfroutSession();
+
+    /// \brief Return the requested zone name.
+    const dns::Name& getZoneName() const;
+
+    /// \brief Return the requested zone class.
+    const dns::RRClass& getZoneClass() const;
+
+    /// \brief Return the request type, AXFR or IXFR.
+    const dns::RRType& getType() const;
+
+    /// \brief Look up the zone and prepare the response.
+    ///
+    /// On an error, such as the zone not being found, an error response
+    /// is built instead, and the response is complete.  This method
+    /// doesn't throw (except on memory allocation failure).
+    ///
+    /// \param list The client list for the zone class, or NULL if there's
+    /// none.
+    void start(datasrc::ClientList* list);
+
+    /// \brief Build the next messages of the response.
+    ///
+    /// It builds about \c BATCH_MESSAGES messages, or the rest of the
+    /// response if it's shorter, to be sent by \c send().  If it fails
+    /// before anything is sent, an error response is built instead;
+    /// otherwise the transfer is aborted (\c isComplete() returns true,
+    /// and \c send() returns false).  This method doesn't throw (except
+    /// on memory allocation failure).
+    void renderNext();
+
+    /// \brief Return whether the whole response has been built.
+    bool isComplete() const { return (complete_); }
+
+    /// \brief Return whether the zone is served from memory.
+    ///
+    /// If so, the zone data must not change between \c start() and the
+    /// last \c renderNext() call.
+    bool isFromCache() const { return (from_cache_); }
+
+    /// \brief Send the messages built so far to the client.
+    ///
+    /// The socket is written in the non-blocking mode, waiting up to the
+    /// send timeout each time the client doesn't accept more data.  It
+    /// doesn't throw; errors are logged.
+    ///
+    /// \return true if all the messages are sent; false on an error or
+    /// timeout, in which case the transfer should be given up.
+    bool send();
+
+    /// \brief Abort the transfer.
+    ///
+    /// It shuts the connection down, so \c send() running in another
+    /// thread fails soon.  It can be called from any thread.
+    void cancel();
+
+    /// \brief Return the number of rendered response messages.
+    size_t getMessageCount() const { return (message_count_); }
+
+private:
+    const dns::Rcode& startResponse(datasrc::ClientList* list);
+    const dns::Rcode& startAXFR(const datasrc::DataSourceClient& client);
+    void finishResponse();
+    void renderErrorResponse(const dns::Rcode& rcode);
+    void addMessage(const void* data, size_t length);
+    bool sendData(const uint8_t* data, size_t length);
+
+    const int fd_;
+    const std::string client_;
+    const int send_timeout_;
+    dns::Message request_;
+    std::unique_ptr<dns::TSIGContext> tsig_context_;
+    std::unique_ptr<XfroutRenderer> renderer_;
+    // The source of the RRsets of the response.  The keeper keeps the
+    // data source client valid while they're used.
+    boost::shared_ptr<datasrc::ClientList::FindResult::LifeKeeper> keeper_;
+    datasrc::ZoneIteratorPtr iterator_;
+    datasrc::ZoneJournalReaderPtr journal_;
+    dns::ConstRRsetPtr soa_;            // the SOA at the end of the response
+    util::OutputBuffer output_;         // messages built but not yet sent
+    size_t message_count_;
+    size_t sent_length_;
+    bool from_cache_;
+    bool complete_;
+    bool failed_;
+    bool error_response_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_XFROUT_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -82,9 +82,12 @@ namespace dhcp {
 
 const std::string Dhcpv4Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
+const time_t Dhcpv4Srv::RECLAIM_INTERVAL;
+const size_t Dhcpv4Srv::RECLAIM_BATCH_SIZE;
+
 Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
                      const bool direct_response_desired)
-: shutdown_(true), alloc_engine_(), port_(port),
+: shutdown_(true), alloc_engine_(), next_reclaim_time_(0), port_(port),
     use_bcast_(use_bcast), hook_index_pkt4_receive_(-1),
     hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1) {
 
@@ -165,6 +168,18 @@ Dhcpv4Srv::run() {
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
+        // Reclaim the expired leases periodically, so that their addresses
+        // are free when new clients come. If the batch was full, there may
+        // be more expired leases, so the next batch is reclaimed right after
+        // the next packet is processed.
+        const time_t now = time(NULL);
+        if (now >= next_reclaim_time_) {
+            next_reclaim_time_ = now;
+            if (reclaimExpiredLeases() < RECLAIM_BATCH_SIZE) {
+                next_reclaim_time_ += RECLAIM_INTERVAL;
+            }
+        }
+
         // client's message and server's response
         Pkt4Ptr query;
         Pkt4Ptr rsp;
@@ -1340,6 +1355,12 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
             bool success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
 
             if (success) {
+                // The address can be handed out again.
+                if (alloc_engine_) {
+                    alloc_engine_->markAddressFree(
+                        *CfgMgr::instance().getSubnets4(), *lease);
+                }
+
                 // Release successful
                 LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RELEASE)
                     .arg(lease->addr_.toText())
@@ -1367,6 +1388,37 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
 
 }
 
+size_t
+Dhcpv4Srv::reclaimExpiredLeases() {
+    if (!alloc_engine_) {
+        return (0);
+    }
+
+    Lease4Collection reclaimed;
+    try {
+        reclaimed = alloc_engine_->
+            reclaimExpiredLeases4(*CfgMgr::instance().getSubnets4(),
+                                  RECLAIM_BATCH_SIZE);
+
+        if (CfgMgr::instance().ddnsEnabled()) {
+            // Remove existing DNS entries for the leases, if any.
+            for (Lease4Collection::const_iterator lease = reclaimed.begin();
+                 lease != reclaimed.end(); ++lease) {
+                queueNameChangeRequest(bundy::dhcp_ddns::CHG_REMOVE, *lease);
+            }
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp4_logger, DHCP4_RECLAIM_EXPIRED_LEASES_FAIL)
+            .arg(ex.what());
+    }
+
+    if (!reclaimed.empty()) {
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RECLAIM_EXPIRED_LEASES)
+            .arg(reclaimed.size());
+    }
+    return (reclaimed.size());
+}
+
 void
 Dhcpv4Srv::processDecline(Pkt4Ptr& /* decline */) {
     /// @todo Implement this (also see ticket #3116)
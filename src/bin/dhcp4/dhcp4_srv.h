@@ -108,6 +108,18 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Interval between the reclamations of expired leases (in
+    /// seconds).
+    static const time_t RECLAIM_INTERVAL = 10;
+
+    /// @brief Maximum number of expired leases reclaimed at once.
+    ///
+    /// The reclamation runs in the main loop, so the batch is limited to
+    /// keep the server responsive when many leases expire at the same time.
+    /// The remaining leases are reclaimed in the next batch, which is run
+    /// without waiting for the @c RECLAIM_INTERVAL.
+    static const size_t RECLAIM_BATCH_SIZE = 100;
+
     /// @brief Return textual type of packet received by server
     ///
     /// Returns the name of valid packet received by the server (e.g. DISCOVER).
@@ -679,6 +691,20 @@ protected:
     /// @return true if successful, false otherwise (will prevent sending response)
     bool classSpecificProcessing(const Pkt4Ptr& query, const Pkt4Ptr& rsp);
 
+    /// @brief Reclaims a batch of expired leases.
+    ///
+    /// Removes up to @c RECLAIM_BATCH_SIZE expired leases from the lease
+    /// database and marks their addresses as free, so that they can be
+    /// handed out to new clients without being reused lazily by the
+    /// allocation engine. If DNS updates are enabled, NameChangeRequests
+    /// are queued to remove the DNS entries of the reclaimed leases.
+    ///
+    /// This function does not throw. It logs the error if the reclamation
+    /// failed.
+    ///
+    /// @return Number of the reclaimed leases.
+    size_t reclaimExpiredLeases();
+
 private:
 
     /// @brief Constructs netmask option based on subnet4
@@ -702,6 +728,9 @@ private:
     /// during normal operation (e.g. to use different allocators)
     boost::shared_ptr<AllocEngine> alloc_engine_;
 
+    /// @brief Time when the expired leases are to be reclaimed next.
+    time_t next_reclaim_time_;
+
     uint16_t port_;  ///< UDP port number on which server listens.
     bool use_bcast_; ///< Should broadcast be enabled on sockets (if true).
 
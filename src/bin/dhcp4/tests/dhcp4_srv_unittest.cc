@@ -1186,6 +1186,9 @@ TEST_F(Dhcpv4SrvTest, ReleaseBasic) {
                               temp_valid, temp_t1, temp_t2, temp_timestamp,
                               subnet_->getID()));
     ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+    FreeAddressIndexPtr index = pool_->getFreeIndex();
+    ASSERT_TRUE(index);
+    index->markUsed(addr);
 
     // Check that the lease is really in the database
     Lease4Ptr l = LeaseMgrFactory::instance().getLease4(addr);
@@ -1226,6 +1229,38 @@ TEST_F(Dhcpv4SrvTest, ReleaseBasic) {
     EXPECT_FALSE(l);
 
     // Ok, the lease is *really* not there.
+
+    // And the address can be allocated again.
+    EXPECT_FALSE(index->isUsed(addr));
+}
+
+// This test verifies that the expired leases are reclaimed, while the valid
+// ones are left alone.
+TEST_F(Dhcpv4SrvTest, reclaimExpiredLeases) {
+    boost::scoped_ptr<NakedDhcpv4Srv> srv;
+    ASSERT_NO_THROW(srv.reset(new NakedDhcpv4Srv(0)));
+
+    const IOAddress expired_addr("192.0.2.106");
+    const IOAddress valid_addr("192.0.2.107");
+    uint8_t mac_addr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe};
+
+    // The first lease expired 10 seconds ago.
+    Lease4Ptr expired(new Lease4(expired_addr, mac_addr, sizeof(mac_addr),
+                                 NULL, 0, 100, 50, 75, time(NULL) - 110,
+                                 subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(expired));
+    mac_addr[5] = 0xff;
+    Lease4Ptr valid(new Lease4(valid_addr, mac_addr, sizeof(mac_addr),
+                               NULL, 0, 100, 50, 75, time(NULL) - 10,
+                               subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(valid));
+
+    EXPECT_EQ(1, srv->reclaimExpiredLeases());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(expired_addr));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(valid_addr));
+
+    // There's nothing more to reclaim.
+    EXPECT_EQ(0, srv->reclaimExpiredLeases());
 }
 
 // This test verifies that incoming (invalid) RELEASE can be handled properly.
@@ -191,6 +191,12 @@
                 "item_type": "boolean",
                 "item_optional": true,
                 "item_default": true
+            },
+            {
+                "item_name": "lfc-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
             }
         ]
       },
@@ -274,6 +280,13 @@
                   "item_description" : "Restricts access to this subnet to specified client class (if defined)"
                 },
 
+                { "item_name": "allocator",
+                  "item_type": "string",
+                  "item_optional": false,
+                  "item_default": "",
+                  "item_description" : "Allocation algorithm for this subnet: iterative, hashed or random (server default if empty)"
+                },
+
                 { "item_name": "relay",
                   "item_type": "map",
                   "item_optional": false,
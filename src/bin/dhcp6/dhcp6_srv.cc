@@ -104,6 +104,9 @@ namespace dhcp {
 
 const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
+const time_t Dhcpv6Srv::RECLAIM_INTERVAL;
+const size_t Dhcpv6Srv::RECLAIM_BATCH_SIZE;
+
 /// @brief file name of a server-id file
 ///
 /// Server must store its duid in persistent storage that must not change
@@ -115,7 +118,8 @@ const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 static const char* SERVER_DUID_FILE = "bundy-dhcp6-serverid";
 
 Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
-:alloc_engine_(), serverid_(), port_(port), shutdown_(true)
+:alloc_engine_(), next_reclaim_time_(0), serverid_(), port_(port),
+ shutdown_(true)
 {
 
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_OPEN_SOCKET).arg(port);
@@ -245,6 +249,18 @@ bool Dhcpv6Srv::run() {
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
+        // Reclaim the expired leases periodically, so that their addresses
+        // are free when new clients come. If the batch was full, there may
+        // be more expired leases, so the next batch is reclaimed right after
+        // the next packet is processed.
+        const time_t now = time(NULL);
+        if (now >= next_reclaim_time_) {
+            next_reclaim_time_ = now;
+            if (reclaimExpiredLeases() < RECLAIM_BATCH_SIZE) {
+                next_reclaim_time_ += RECLAIM_INTERVAL;
+            }
+        }
+
         // client's message and server's response
         Pkt6Ptr query;
         Pkt6Ptr rsp;
@@ -2054,6 +2070,11 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success && alloc_engine_) {
+            // The address can be handed out again.
+            alloc_engine_->markAddressFree(*CfgMgr::instance().getSubnets6(),
+                                           *lease);
+        }
     }
 
     // Here the success should be true if we removed lease successfully
@@ -2198,6 +2219,11 @@ Dhcpv6Srv::releaseIA_PD(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success && alloc_engine_) {
+            // The prefix can be handed out again.
+            alloc_engine_->markAddressFree(*CfgMgr::instance().getSubnets6(),
+                                           *lease);
+        }
     } else {
         // Callouts decided to skip the next processing step. The next
         // processing step would to send the packet, so skip at this
@@ -2334,6 +2360,38 @@ Dhcpv6Srv::processRelease(const Pkt6Ptr& release) {
     return (reply);
 }
 
+size_t
+Dhcpv6Srv::reclaimExpiredLeases() {
+    if (!alloc_engine_) {
+        return (0);
+    }
+
+    Lease6Collection reclaimed;
+    try {
+        reclaimed = alloc_engine_->
+            reclaimExpiredLeases6(*CfgMgr::instance().getSubnets6(),
+                                  RECLAIM_BATCH_SIZE);
+
+        // Remove existing DNS entries for the address leases, if any. This
+        // does nothing if DNS updates are disabled.
+        for (Lease6Collection::const_iterator lease = reclaimed.begin();
+             lease != reclaimed.end(); ++lease) {
+            if ((*lease)->type_ != Lease::TYPE_PD) {
+                createRemovalNameChangeRequest(*lease);
+            }
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp6_logger, DHCP6_RECLAIM_EXPIRED_LEASES_FAIL)
+            .arg(ex.what());
+    }
+
+    if (!reclaimed.empty()) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_RECLAIM_EXPIRED_LEASES)
+            .arg(reclaimed.size());
+    }
+    return (reclaimed.size());
+}
+
 Pkt6Ptr
 Dhcpv6Srv::processDecline(const Pkt6Ptr& decline) {
     /// @todo: Implement this
@@ -100,6 +100,18 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Interval between the reclamations of expired leases (in
+    /// seconds).
+    static const time_t RECLAIM_INTERVAL = 10;
+
+    /// @brief Maximum number of expired leases reclaimed at once.
+    ///
+    /// The reclamation runs in the main loop, so the batch is limited to
+    /// keep the server responsive when many leases expire at the same time.
+    /// The remaining leases are reclaimed in the next batch, which is run
+    /// without waiting for the @c RECLAIM_INTERVAL.
+    static const size_t RECLAIM_BATCH_SIZE = 100;
+
     /// @brief Get UDP port on which server should listen.
     ///
     /// Typically, server listens on UDP port 547. Other ports are only
@@ -597,6 +609,19 @@ protected:
     /// @param pkt packet to be classified
     void classifyPacket(const Pkt6Ptr& pkt);
 
+    /// @brief Reclaims a batch of expired leases.
+    ///
+    /// Removes up to @c RECLAIM_BATCH_SIZE expired leases from the lease
+    /// database and marks their addresses and prefixes as free, so that they
+    /// can be handed out to new clients without being reused lazily by the
+    /// allocation engine. If DNS updates are enabled, NameChangeRequests
+    /// are queued to remove the DNS entries of the reclaimed address leases.
+    ///
+    /// This function does not throw. It logs the error if the reclamation
+    /// failed.
+    ///
+    /// @return Number of the reclaimed leases.
+    size_t reclaimExpiredLeases();
 
     /// @brief this is a prefix added to the contend of vendor-class option
     ///
@@ -665,6 +690,9 @@ private:
     /// during normal operation (e.g. to use different allocators)
     boost::shared_ptr<AllocEngine> alloc_engine_;
 
+    /// Time when the expired leases are to be reclaimed next.
+    time_t next_reclaim_time_;
+
     /// Server DUID (to be sent in server-identifier option)
     OptionPtr serverid_;
 
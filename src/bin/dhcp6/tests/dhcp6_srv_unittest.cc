@@ -998,6 +998,35 @@ TEST_F(Dhcpv6SrvTest, pdReleaseReject) {
     testReleaseReject(Lease::TYPE_PD, IOAddress("2001:db8:1:2::"));
 }
 
+// This test verifies that the expired leases are reclaimed, while the valid
+// ones are left alone.
+TEST_F(Dhcpv6SrvTest, reclaimExpiredLeases) {
+    NakedDhcpv6Srv srv(0);
+
+    const IOAddress expired_addr("2001:db8:1:1::cafe:babe");
+    const IOAddress valid_addr("2001:db8:1:1::cafe:babf");
+    OptionPtr clientid = generateClientId();
+    ASSERT_TRUE(subnet_->inPool(Lease::TYPE_NA, expired_addr));
+
+    // The first lease expired 12 seconds ago.
+    Lease6Ptr expired(new Lease6(Lease::TYPE_NA, expired_addr, duid_, 234,
+                                 501, 502, 503, 504, subnet_->getID(), 128));
+    expired->cltt_ = time(NULL) - 514;
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(expired));
+    Lease6Ptr valid(new Lease6(Lease::TYPE_NA, valid_addr, duid_, 235,
+                               501, 502, 503, 504, subnet_->getID(), 128));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(valid));
+
+    EXPECT_EQ(1, srv.reclaimExpiredLeases());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                                                       expired_addr));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                                                      valid_addr));
+
+    // There's nothing more to reclaim.
+    EXPECT_EQ(0, srv.reclaimExpiredLeases());
+}
+
 // This test verifies if the status code option is generated properly.
 TEST_F(Dhcpv6SrvTest, StatusCode) {
     NakedDhcpv6Srv srv(0);
@@ -428,7 +428,7 @@ Dhcpv6SrvTest::testReleaseBasic(Lease::Type type, const IOAddress& existing,
     ASSERT_TRUE(subnet_->inPool(type, existing));
 
     // Let's prepopulate the database
-    Lease6Ptr lease(new Lease6(Lease::TYPE_NA, existing, duid_, iaid,
+    Lease6Ptr lease(new Lease6(type, existing, duid_, iaid,
                                501, 502, 503, 504, subnet_->getID(),
                                prefix_len));
     ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
@@ -437,6 +437,14 @@ Dhcpv6SrvTest::testReleaseBasic(Lease::Type type, const IOAddress& existing,
     Lease6Ptr l = LeaseMgrFactory::instance().getLease6(type, existing);
     ASSERT_TRUE(l);
 
+    // The address pool is too large to have a free address index, but the
+    // prefix pool has one.
+    FreeAddressIndexPtr index =
+        subnet_->getPool(type, existing, false)->getFreeIndex();
+    if (index) {
+        index->markUsed(existing);
+    }
+
     // Let's create a RELEASE
     Pkt6Ptr rel = createMessage(DHCPV6_RELEASE, type, release_addr, prefix_len,
                                 iaid);
@@ -475,6 +483,11 @@ Dhcpv6SrvTest::testReleaseBasic(Lease::Type type, const IOAddress& existing,
     l = LeaseMgrFactory::instance().getLease6(type, *duid_, iaid,
                                               subnet_->getID());
     ASSERT_FALSE(l);
+
+    // The address or prefix can be allocated again.
+    if (index) {
+        EXPECT_FALSE(index->isUsed(existing));
+    }
 }
 
 void
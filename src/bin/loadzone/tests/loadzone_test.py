@@ -35,6 +35,7 @@ TESTDATA_WRITE_PATH = os.environ['TESTDATA_WRITE_PATH'] + os.sep
 WRITE_ZONE_DB_FILE = TESTDATA_WRITE_PATH + "rwtest.sqlite3.copied"
 TEST_ZONE_NAME = Name('example.org')
 DATASRC_CONFIG = '{"database_file": "' + WRITE_ZONE_DB_FILE + '"}'
+SNAPSHOT_FILE = TESTDATA_WRITE_PATH + "example.org.snapshot"
 
 # before/after SOAs: different in mname and serial
 ORIG_SOA_TXT = 'example.org. 3600 IN SOA ns1.example.org. ' +\
@@ -58,6 +59,8 @@ class TestLoadZoneRunner(unittest.TestCase):
         # unexpectedly in the middle of updating the DB, a lock could stay
         # there and would affect the other tests that would otherwise succeed.
         os.unlink(WRITE_ZONE_DB_FILE)
+        if os.path.exists(SNAPSHOT_FILE):
+            os.unlink(SNAPSHOT_FILE)
 
     def test_init(self):
         '''
@@ -83,6 +86,11 @@ class TestLoadZoneRunner(unittest.TestCase):
         self.assertEqual('INFO', self.__runner._log_severity) # default
         self.assertEqual(0, self.__runner._log_debuglevel)
         self.assertFalse(self.__runner._empty_zone)
+        self.assertIsNone(self.__runner._snapshot_file)
+
+        runner = LoadZoneRunner(['-s', SNAPSHOT_FILE] + self.__args)
+        runner._parse_args()
+        self.assertEqual(SNAPSHOT_FILE, runner._snapshot_file)
 
     def test_set_loglevel(self):
         runner = LoadZoneRunner(['-d', '1'] + self.__args)
@@ -126,6 +134,11 @@ class TestLoadZoneRunner(unittest.TestCase):
         self.assertRaises(BadArgument,
                           LoadZoneRunner(['-i', '-5'] + args)._parse_args)
 
+        # snapshot file name without the suffix
+        self.assertRaises(BadArgument,
+                          LoadZoneRunner(['-s', 'example.org.zone'] + args).
+                          _parse_args)
+
         # -c cannot be omitted unless it's type sqlite3 (right now)
         self.assertRaises(BadArgument,
                           LoadZoneRunner(['-t', 'memory'] + args)._parse_args)
@@ -236,6 +249,35 @@ class TestLoadZoneRunner(unittest.TestCase):
                          self.__runner._report_progress(10, unknown_progress,
                                                         False))
 
+    def test_load_and_snapshot(self):
+        '''loading and writing a snapshot of the loaded zone.'''
+        self.__common_load_setup()
+        self.__runner._snapshot_file = SNAPSHOT_FILE
+        self.__runner._do_load()
+        self.__check_zone_soa(NEW_SOA_TXT)
+
+        # The zone can be loaded into memory from the snapshot.
+        clist = ConfigurableClientList(RRClass.IN)
+        clist.configure('[{"type": "MasterFiles", "cache-enable": true, ' +
+                        '"params": {"example.org": "' + SNAPSHOT_FILE +
+                        '"}}]', True)
+        client = clist.find(TEST_ZONE_NAME, True, False)[0]
+        result, finder = client.find_zone(TEST_ZONE_NAME)
+        self.assertEqual(client.SUCCESS, result)
+        result, rrset, _ = finder.find(TEST_ZONE_NAME, RRType.SOA)
+        self.assertEqual(finder.SUCCESS, result)
+        self.assertEqual(NEW_SOA_TXT, rrset.to_text())
+
+    def test_load_snapshot_fail(self):
+        '''writing the snapshot fails, but the load isn't canceled.'''
+        self.__common_load_setup()
+        self.__runner._zone_name = Name('example.com')
+        self.__runner._zone_file = ALT_NEW_ZONE_TXT_FILE
+        self.__runner._snapshot_file = \
+            TESTDATA_WRITE_PATH + 'no-such-dir/example.com.snapshot'
+        self.assertRaises(SnapshotFailure, self.__runner._do_load)
+        self.__check_zone_soa(ALT_NEW_SOA_TXT, zone_name=Name('example.com'))
+
     def test_create_and_load(self):
         '''successful case to loading contents to a new zone (created).'''
         self.__common_load_setup()
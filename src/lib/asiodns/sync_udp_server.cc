@@ -28,11 +28,18 @@
 
 #include <cassert>
 
+#include <cstring>
+
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>             // for some IPC/network system calls
 #include <errno.h>
+#include <poll.h>
+
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+#define SYNC_UDP_SERVER_BATCH 1
+#endif
 
 using namespace std;
 using namespace bundy::asiolink;
@@ -49,7 +56,6 @@ SyncUDPServer::create(asio::io_service& io_service, const int fd,
 
 SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
                              const int af, DNSLookup* lookup) :
-    output_buffer_(new bundy::util::OutputBuffer(0)),
     query_(new bundy::dns::Message(bundy::dns::Message::PARSE)),
     udp_endpoint_(sender_), lookup_callback_(lookup),
     resume_called_(false), done_(false), stopped_(false)
@@ -73,13 +79,24 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
         bundy_throw(IOError, exception.what());
     }
     udp_socket_.reset(new UDPSocket<DummyIOCallback>(*socket_));
+    for (size_t i = 0; i < MAX_BATCH_SIZE; ++i) {
+        output_buffers_[i].reset(new bundy::util::OutputBuffer(0));
+    }
 }
 
 void
 SyncUDPServer::scheduleRead() {
+#ifdef SYNC_UDP_SERVER_BATCH
+    // We only need to know the socket is readable; the packets themselves
+    // are read with recvmmsg() in handleBatch().
+    socket_->async_receive(
+        asio::null_buffers(),
+        boost::bind(&SyncUDPServer::handleRead, shared_from_this(), _1, _2));
+#else
     socket_->async_receive_from(
-        asio::mutable_buffers_1(data_, MAX_LENGTH), sender_,
+        asio::mutable_buffers_1(data_[0], MAX_LENGTH), sender_,
         boost::bind(&SyncUDPServer::handleRead, shared_from_this(), _1, _2));
+#endif
 }
 
 void
@@ -104,46 +121,178 @@ SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
             LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).arg(ec.message());
         }
     }
+#ifdef SYNC_UDP_SERVER_BATCH
+    // With null_buffers length is always 0; the real read happens below.
+    if (ec) {
+        scheduleRead();
+        return;
+    }
+    handleBatch();
+#else
     if (ec || length == 0) {
         scheduleRead();
         return;
     }
     // OK, we have a real packet of data. Let's dig into it!
+    if (processPacket(0, length)) {
+        // Good, there's an answer.
+        socket_->send_to(asio::const_buffers_1(output_buffers_[0]->getData(),
+                                               output_buffers_[0]->getLength()),
+                         sender_, 0, ec_);
+        if (ec_) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
+                      arg(sender_.address().to_string()).arg(ec_.message());
+        }
+    }
 
+    // And schedule handling another socket.
+    scheduleRead();
+#endif
+}
+
+bool
+SyncUDPServer::processPacket(const size_t index, const size_t length) {
     // Make sure the buffers are fresh.  Note that we don't touch query_
     // because it's supposed to be cleared in lookup_callback_.  We should
     // eventually even remove this member variable (and remove it from
     // the lookup_callback_ interface, but until then, any callback
     // implementation should be careful that it's the responsibility of
     // the callback implementation.  See also #2239).
-    output_buffer_->clear();
+    output_buffers_[index]->clear();
 
     // Mark that we don't have an answer yet.
     done_ = false;
     resume_called_ = false;
 
     // Call the actual lookup
-    const IOMessage message(data_, length, *udp_socket_, udp_endpoint_);
-    (*lookup_callback_)(message, query_, answer_, output_buffer_, this);
+    const IOMessage message(data_[index], length, *udp_socket_,
+                            udp_endpoint_);
+    (*lookup_callback_)(message, query_, answer_, output_buffers_[index],
+                        this);
 
     if (!resume_called_) {
         bundy_throw(bundy::Unexpected,
                   "No resume called from the lookup callback");
     }
 
-    if (done_) {
-        // Good, there's an answer.
-        socket_->send_to(asio::const_buffers_1(output_buffer_->getData(),
-                                               output_buffer_->getLength()),
-                         sender_, 0, ec_);
-        if (ec_) {
-            LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
-                      arg(sender_.address().to_string()).arg(ec_.message());
+    return (done_);
+}
+
+void
+SyncUDPServer::handleBatch() {
+#ifdef SYNC_UDP_SERVER_BATCH
+    const int fd = socket_->native();
+
+    struct mmsghdr msgs[MAX_BATCH_SIZE];
+    struct iovec iovs[MAX_BATCH_SIZE];
+    std::memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < MAX_BATCH_SIZE; ++i) {
+        iovs[i].iov_base = data_[i];
+        iovs[i].iov_len = MAX_LENGTH;
+        msgs[i].msg_hdr.msg_name = senders_[i].data();
+        msgs[i].msg_hdr.msg_namelen = senders_[i].capacity();
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int received = recvmmsg(fd, msgs, MAX_BATCH_SIZE, MSG_DONTWAIT,
+                                  NULL);
+    if (received < 0) {
+        // Someone else may have eaten the packet (or we were woken up
+        // spuriously); that's not an error worth logging.
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).
+                arg(std::strerror(errno));
         }
+        scheduleRead();
+        return;
     }
 
-    // And schedule handling another socket.
+    // Run all the received packets through the lookup callback and collect
+    // the answers.  We reuse the headers of the received messages for
+    // sending (the sender addresses are already in place), compacting the
+    // ones with an answer to the front.
+    size_t answers = 0;
+    size_t answered[MAX_BATCH_SIZE];
+    for (size_t i = 0; i < static_cast<size_t>(received); ++i) {
+        const size_t length = msgs[i].msg_len;
+        if (length == 0) {
+            continue;
+        }
+        senders_[i].resize(msgs[i].msg_hdr.msg_namelen);
+        sender_ = senders_[i];
+        const bool done = processPacket(i, length);
+        if (stopped_) {
+            // The callback stopped the server; the socket is closed, so
+            // there's no point in sending anything.
+            return;
+        }
+        if (!done) {
+            continue;
+        }
+        iovs[answers].iov_base =
+            const_cast<void*>(output_buffers_[i]->getData());
+        iovs[answers].iov_len = output_buffers_[i]->getLength();
+        msgs[answers].msg_hdr.msg_name = senders_[i].data();
+        msgs[answers].msg_hdr.msg_namelen = senders_[i].size();
+        msgs[answers].msg_hdr.msg_iov = &iovs[answers];
+        msgs[answers].msg_hdr.msg_iovlen = 1;
+        msgs[answers].msg_hdr.msg_control = NULL;
+        msgs[answers].msg_hdr.msg_controllen = 0;
+        msgs[answers].msg_hdr.msg_flags = 0;
+        answered[answers] = i;
+        ++answers;
+    }
+
+    // Flush the answers.  sendmmsg() may send only a part of them, and the
+    // socket is in non-blocking mode, so we may need to wait for it to
+    // become writable.  The wait is bounded by SEND_TIMEOUT; if the socket
+    // doesn't become writable in time, the rest of the batch is dropped.
+    // A message that can't be sent for another reason is logged and skipped
+    // so it doesn't block the rest.
+    size_t sent = 0;
+    while (sent < answers) {
+        const int result = sendmmsg(fd, &msgs[sent], answers - sent, 0);
+        if (result > 0) {
+            sent += result;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (stopped_) {
+                return;
+            }
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            const int ready = poll(&pfd, 1, SEND_TIMEOUT);
+            if (ready > 0 || (ready < 0 && errno == EINTR)) {
+                continue;
+            }
+            if (ready == 0) {
+                for (; sent < answers; ++sent) {
+                    LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
+                        arg(senders_[answered[sent]].address().to_string()).
+                        arg(std::strerror(ETIMEDOUT));
+                }
+                break;
+            }
+        }
+        LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
+            arg(senders_[answered[sent]].address().to_string()).
+            arg(std::strerror(errno));
+        ++sent;
+    }
+
+    // And schedule handling another batch.
     scheduleRead();
+#else
+    bundy_throw(bundy::Unexpected, "SyncUDPServer built without recvmmsg "
+                "and sendmmsg support");
+#endif
 }
 
 void
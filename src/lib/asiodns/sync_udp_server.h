@@ -49,6 +49,12 @@ typedef boost::shared_ptr<SyncUDPServer> SyncUDPServerPtr;
 /// This allows for implementation with less overhead, compared with
 /// the \c UDPServer class.
 ///
+/// Where the system provides \c recvmmsg() and \c sendmmsg(), the server
+/// drains up to \c MAX_BATCH_SIZE queued datagrams per socket event with
+/// a single system call, runs them through the lookup callback back to
+/// back, and sends all the answers at once.  Otherwise it handles one
+/// datagram per event.
+///
 /// This class inherits from boost::enable_shared_from_this so a shared
 /// pointer of this object can be passed in an ASIO callback and won't be
 /// accidentally destroyed while waiting for events.  To enforce this style
@@ -142,12 +148,22 @@ private:
 
     // Maximum size of incoming UDP packet
     static const size_t MAX_LENGTH = 4096;
-    // Buffer for incoming data
-    uint8_t data_[MAX_LENGTH];
-    // The buffer to render the output to and send it.
+    // Maximum number of packets received (and answered) in one batch.
+    // Without recvmmsg()/sendmmsg() only the first slot is used.
+    static const size_t MAX_BATCH_SIZE = 32;
+    // How long (in milliseconds) to wait for the socket to become writable
+    // when flushing a batch.  The answers not sent by then are dropped, so
+    // the thread gets back to its IOService (and notices stop()).
+    static const int SEND_TIMEOUT = 100;
+    // Buffers for incoming data, one per packet of a batch
+    uint8_t data_[MAX_BATCH_SIZE][MAX_LENGTH];
+    // The buffers to render the output to and send it, one per packet of
+    // a batch.  They have to survive until the whole batch is sent.
     // If it was OK to have just a buffer, not the wrapper class,
     // we could reuse the data_
-    bundy::util::OutputBufferPtr output_buffer_;
+    bundy::util::OutputBufferPtr output_buffers_[MAX_BATCH_SIZE];
+    // Senders of the packets of a batch (filled in by recvmmsg()).
+    asio::ip::udp::endpoint senders_[MAX_BATCH_SIZE];
     // Objects to hold the query message and the answer.  The latter isn't
     // used and only defined as a placeholder as the callback signature
     // requires it.
@@ -180,11 +196,19 @@ private:
     // Auxiliary functions
 
     // Schedule next read on the socket. Just a wrapper around
-    // socket_->async_read_from with the correct parameters.
+    // socket_->async_read_from with the correct parameters (or, in the
+    // batched mode, an asynchronous wait for the socket to be readable).
     void scheduleRead();
     // Callback from the socket's read call (called when there's an error or
     // when a new packet comes).
     void handleRead(const asio::error_code& ec, const size_t length);
+    // Receive a batch of packets with recvmmsg(), process them and send
+    // the answers with sendmmsg().  Only used in the batched mode.
+    void handleBatch();
+    // Run the lookup callback for the packet stored in data_[index], sent
+    // from sender_.  Returns true if the answer in output_buffers_[index]
+    // is to be sent back.
+    bool processPacket(const size_t index, const size_t length);
 };
 
 } // namespace asiodns
@@ -24,6 +24,7 @@
 #include <asiodns/dns_answer.h>
 #include <asiodns/dns_lookup.h>
 #include <string>
+#include <vector>
 #include <cstring>
 #include <cerrno>
 #include <csignal>
@@ -750,6 +751,46 @@ TEST_F(SyncServerTest, mustResume) {
                  bundy::Unexpected);
 }
 
+// Several queued queries are all answered, in order.  With recvmmsg() and
+// sendmmsg() they are handled as a single batch (one socket event).
+TEST_F(SyncServerTest, batchedQueries) {
+    static const size_t QUERY_COUNT = 3;
+    const ip::udp::endpoint server(server_address_, server_port);
+    ip::udp::socket client(service, ip::udp::v6());
+    for (size_t i = 0; i < QUERY_COUNT; ++i) {
+        const std::string data(std::string(query_message) +
+                               static_cast<char>('0' + i));
+        client.send_to(buffer(data), server);
+    }
+    asio::socket_base::non_blocking_io non_blocking(true);
+    client.io_control(non_blocking);
+
+    (*udp_server_)();
+    std::vector<std::string> answers;
+    size_t events = 0;
+    while (answers.size() < QUERY_COUNT && events < QUERY_COUNT) {
+        service.run_one();
+        ++events;
+        char data[SimpleClient::MAX_DATA_LEN];
+        ip::udp::endpoint sender;
+        asio::error_code ec;
+        size_t length;
+        while ((length = client.receive_from(buffer(data), sender, 0,
+                                             ec)) > 0 && !ec) {
+            answers.push_back(std::string(data, length));
+        }
+    }
+
+    ASSERT_EQ(QUERY_COUNT, answers.size());
+    for (size_t i = 0; i < QUERY_COUNT; ++i) {
+        EXPECT_EQ(std::string(query_message) + static_cast<char>('0' + i),
+                  answers[i]);
+    }
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+    EXPECT_EQ(static_cast<size_t>(1), events);
+#endif
+}
+
 // SyncUDPServer doesn't allow NULL lookup callback.
 TEST_F(SyncServerTest, nullLookupCallback) {
     EXPECT_THROW(SyncUDPServer::create(service, 0, AF_INET, NULL),
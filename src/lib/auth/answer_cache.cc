@@ -0,0 +1,253 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/answer_cache.h>
+
+#include <dns/labelsequence.h>
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/lru_hash_table.h>
+#include <util/threads/sync.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace bundy::dns;
+using bundy::util::LruHashTable;
+using bundy::util::thread::Mutex;
+
+namespace bundy {
+namespace auth {
+
+namespace {
+// Length of the DNS header
+const size_t HEADER_LEN = 12;
+
+// Header flags of a response that are copied from the query
+const uint16_t QUERY_FLAGS = Message::HEADERFLAG_RD | Message::HEADERFLAG_CD;
+
+// The cache is split into at most this many shards, each with its own
+// lock, if every shard can still hold MIN_SHARD_ENTRIES entries.
+const size_t MAX_SHARDS = 16;
+const size_t MIN_SHARD_ENTRIES = 1024;
+
+// Compare wire-format names of the same length case insensitively (note
+// that a label length can never be an upper case letter).
+bool
+sameName(const uint8_t* n1, const uint8_t* n2, size_t name_len) {
+    for (size_t i = 0; i < name_len; ++i) {
+        const uint8_t c1 = (n1[i] >= 'A' && n1[i] <= 'Z') ?
+            n1[i] + ('a' - 'A') : n1[i];
+        const uint8_t c2 = (n2[i] >= 'A' && n2[i] <= 'Z') ?
+            n2[i] + ('a' - 'A') : n2[i];
+        if (c1 != c2) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+// Compare the wire-format questions; the names are compared case
+// insensitively, and the type and class exactly.
+bool
+sameQuestion(const uint8_t* q1, const uint8_t* q2, size_t name_len) {
+    return (sameName(q1, q2, name_len) &&
+            std::equal(q1 + name_len, q1 + name_len + 4, q2 + name_len));
+}
+
+// The query name of an entry isn't stored separately; it's compared with
+// the question of the cached data, which is always the same as the key's
+// except for the case.
+struct AnswerCacheEntry {
+    AnswerCacheEntry() :
+        hash_(0), qtype_(0), qclass_(0), edns_(false), dnssec_ok_(false),
+        zone_id_(0), generation_(0)
+    {}
+
+    bool matches(const AnswerCacheKey& key) const {
+        if (qtype_ != key.qtype_.getCode() ||
+            qclass_ != key.qclass_.getCode() || edns_ != key.edns_ ||
+            dnssec_ok_ != key.dnssec_ok_) {
+            return (false);
+        }
+        size_t name_len;
+        const uint8_t* const name = key.qname_.getData(&name_len);
+        return (data_.size() >= HEADER_LEN + name_len + 4 &&
+                sameName(name, &data_[HEADER_LEN], name_len));
+    }
+
+    void reset(const AnswerCacheKey& key) {
+        qtype_ = key.qtype_.getCode();
+        qclass_ = key.qclass_.getCode();
+        edns_ = key.edns_;
+        dnssec_ok_ = key.dnssec_ok_;
+    }
+
+    size_t hash_;
+    uint16_t qtype_;
+    uint16_t qclass_;
+    bool edns_;
+    bool dnssec_ok_;
+    size_t zone_id_;
+    uint64_t generation_;
+    std::vector<uint8_t> data_;
+
+    boost::intrusive::list_member_hook<> hash_hook_;
+    boost::intrusive::list_member_hook<> lru_hook_;
+};
+}
+
+struct AnswerCache::Impl {
+    // A part of the cache holding the answers whose keys hash to it.
+    struct Shard : boost::noncopyable {
+        explicit Shard(size_t max_entries) : table_(max_entries) {}
+
+        Mutex mutex_;
+        LruHashTable<AnswerCacheEntry> table_;
+    };
+    typedef boost::shared_ptr<Shard> ShardPtr;
+
+    explicit Impl(size_t max_entries) : max_entries_(max_entries) {
+        size_t n_shards = max_entries / MIN_SHARD_ENTRIES;
+        if (n_shards > MAX_SHARDS) {
+            n_shards = MAX_SHARDS;
+        } else if (n_shards == 0) {
+            n_shards = 1;
+        }
+        const size_t shard_size = (max_entries + n_shards - 1) / n_shards;
+        for (size_t i = 0; i < n_shards; ++i) {
+            shards_.push_back(ShardPtr(new Shard(shard_size)));
+        }
+    }
+
+    static size_t getHash(const AnswerCacheKey& key) {
+        size_t hash = key.qname_.getHash(false);
+        hash ^= key.qtype_.getCode() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= key.qclass_.getCode() + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+        return (hash ^ (key.edns_ ? 1 : 0) ^ (key.dnssec_ok_ ? 2 : 0));
+    }
+
+    // The table buckets are chosen by the low bits of the hash, so the
+    // shard is chosen by the upper bits.
+    Shard& getShard(size_t hash) {
+        return (*shards_[(hash >> 16) % shards_.size()]);
+    }
+
+    const size_t max_entries_;
+    std::vector<ShardPtr> shards_;
+};
+
+AnswerCache::AnswerCache(size_t max_entries) {
+    if (max_entries == 0) {
+        bundy_throw(InvalidParameter, "answer cache size must not be 0");
+    }
+    impl_ = new Impl(max_entries);
+}
+
+AnswerCache::~AnswerCache() {
+    delete impl_;
+}
+
+bool
+AnswerCache::getAnswer(const AnswerCacheKey& key,
+                       const Generations& generations,
+                       const void* query_data, size_t query_length,
+                       size_t length_limit, util::OutputBuffer& buffer)
+{
+    const size_t hash = Impl::getHash(key);
+    Impl::Shard& shard = impl_->getShard(hash);
+    Mutex::Locker locker(shard.mutex_);
+    AnswerCacheEntry* entry = shard.table_.find(key, hash);
+    if (entry == NULL || entry->data_.size() > length_limit ||
+        entry->generation_ != generations.getGeneration(entry->zone_id_)) {
+        return (false);
+    }
+
+    // The question is copied from the query as is, so it must be the same
+    // length as the cached one.  This is normally the case, but a (weird)
+    // query could have a compressed name.
+    const size_t name_len = key.qname_.getDataLength();
+    const size_t question_end = HEADER_LEN + name_len + 4;
+    const uint8_t* const query = static_cast<const uint8_t*>(query_data);
+    const uint8_t* const answer = &entry->data_[0];
+    if (query_length < question_end ||
+        !sameQuestion(query + HEADER_LEN, answer + HEADER_LEN, name_len)) {
+        return (false);
+    }
+
+    shard.table_.touch(*entry);
+
+    const uint16_t query_flags = (query[2] << 8) | query[3];
+    const uint16_t answer_flags = (answer[2] << 8) | answer[3];
+    buffer.writeData(query, 2); // ID
+    buffer.writeUint16((answer_flags & ~QUERY_FLAGS) |
+                       (query_flags & QUERY_FLAGS));
+    buffer.writeData(answer + 4, HEADER_LEN - 4); // section counts
+    buffer.writeData(query + HEADER_LEN, question_end - HEADER_LEN);
+    buffer.writeData(answer + question_end,
+                     entry->data_.size() - question_end);
+    return (true);
+}
+
+void
+AnswerCache::addAnswer(const AnswerCacheKey& key, size_t zone_id,
+                       uint64_t generation, const void* data, size_t length)
+{
+    if (length < HEADER_LEN + key.qname_.getDataLength() + 4) {
+        bundy_throw(InvalidParameter, "answer data too short: " << length);
+    }
+
+    const size_t hash = Impl::getHash(key);
+    Impl::Shard& shard = impl_->getShard(hash);
+    Mutex::Locker locker(shard.mutex_);
+    AnswerCacheEntry* entry = shard.table_.find(key, hash);
+    if (entry != NULL) {
+        shard.table_.touch(*entry);
+    } else {
+        entry = &shard.table_.insert(hash);
+        entry->reset(key);
+    }
+
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    entry->zone_id_ = zone_id;
+    entry->generation_ = generation;
+    entry->data_.assign(bytes, bytes + length);
+}
+
+size_t
+AnswerCache::getEntryCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < impl_->shards_.size(); ++i) {
+        Impl::Shard& shard = *impl_->shards_[i];
+        Mutex::Locker locker(shard.mutex_);
+        count += shard.table_.getEntryCount();
+    }
+    return (count);
+}
+
+size_t
+AnswerCache::getMaxEntries() const {
+    return (impl_->max_entries_);
+}
+
+} // namespace auth
+} // namespace bundy
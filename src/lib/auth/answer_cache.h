@@ -0,0 +1,178 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_ANSWER_CACHE_H
+#define AUTH_ANSWER_CACHE_H 1
+
+#include <dns/labelsequence.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <util/buffer.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace auth {
+
+/// \brief The key of an answer in the \c AnswerCache.
+///
+/// It consists of the parameters of a query that determine the content
+/// of the response other than the header ID, the RD and CD flags, and the
+/// case of the query name: the query name, type and class, whether the
+/// query has EDNS (the response has an OPT RR iff so), and the DO bit.
+///
+/// The object only refers to the data of the query name; it must be valid
+/// throughout the lifetime of the key.
+struct AnswerCacheKey {
+    AnswerCacheKey(const dns::Name& qname, const dns::RRType& qtype,
+                   const dns::RRClass& qclass, bool edns, bool dnssec_ok) :
+        qname_(qname), qtype_(qtype), qclass_(qclass), edns_(edns),
+        dnssec_ok_(dnssec_ok)
+    {}
+
+    /// \brief Constructor from a label sequence of an absolute query name.
+    AnswerCacheKey(const dns::LabelSequence& qname, const dns::RRType& qtype,
+                   const dns::RRClass& qclass, bool edns, bool dnssec_ok) :
+        qname_(qname), qtype_(qtype), qclass_(qclass), edns_(edns),
+        dnssec_ok_(dnssec_ok)
+    {}
+
+    const dns::LabelSequence qname_;
+    const dns::RRType qtype_;
+    const dns::RRClass qclass_;
+    const bool edns_;
+    const bool dnssec_ok_;
+};
+
+/// \brief A cache of rendered responses.
+///
+/// This class keeps the wire-format data of responses to queries so they
+/// can be answered again by simply copying the data, only patching the
+/// header ID, the RD and CD flags and the question (which can differ from
+/// the cached one in the case of the query name).
+///
+/// Each answer is stored with an ID of the zone it was built from and the
+/// generation number of the zone's data at that time (see
+/// \c DataGenerations of the auth server), and is only used while the
+/// zone's generation is current, as told by a \c Generations object.  So
+/// reloading a zone only invalidates the answers from that zone.  Answers
+/// of an older generation are simply left to be replaced by newer ones.
+///
+/// The cache is a hash table with a fixed maximum number of entries; once
+/// it's full, the least recently used entry is recycled for a new answer.
+/// Entries are allocated on demand and never freed until the cache is
+/// destroyed.
+///
+/// It's the caller's responsibility to store only responses that don't
+/// depend on anything but the key and the zone data, e.g., not TSIG
+/// signed or truncated ones.
+///
+/// This class is thread safe.  Large caches are split into shards by the
+/// hash of the key, each with its own lock, so concurrent lookups rarely
+/// wait for each other.
+class AnswerCache : boost::noncopyable {
+public:
+    /// \brief The current generations of the zones of the cached answers.
+    class Generations {
+    public:
+        /// \brief Destructor.
+        virtual ~Generations() {}
+
+        /// \brief Return the current generation of a zone.
+        ///
+        /// This is called while holding a lock of the cache, so it should
+        /// be cheap and must not use the cache.
+        ///
+        /// \param zone_id The zone ID passed to \c addAnswer().
+        virtual uint64_t getGeneration(size_t zone_id) const = 0;
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_entries is 0
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The maximum number of answers in the cache.
+    explicit AnswerCache(size_t max_entries);
+
+    /// \brief Destructor.
+    ~AnswerCache();
+
+    /// \brief Render a cached answer to a query, if any.
+    ///
+    /// If there's an answer for \c key whose zone generation is current
+    /// according to \c generations and it fits in \c length_limit, it's
+    /// appended to \c buffer with the ID, the RD and CD flags and the
+    /// question copied from \c query_data, and the answer becomes the most
+    /// recently used one.
+    ///
+    /// \c query_data must be the wire-format query the key was made of.
+    /// If its question isn't in the canonical uncompressed form matching
+    /// the cached one (other than in the case of the query name) it's
+    /// considered a miss.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param key The key of the answer.
+    /// \param generations The current generations of the zones.
+    /// \param query_data The wire-format query.
+    /// \param query_length The length of \c query_data.
+    /// \param length_limit The maximum length of the response.
+    /// \param buffer The buffer to render the answer to.
+    /// \return true if an answer has been rendered; false otherwise.
+    bool getAnswer(const AnswerCacheKey& key, const Generations& generations,
+                   const void* query_data, size_t query_length,
+                   size_t length_limit, util::OutputBuffer& buffer);
+
+    /// \brief Store a rendered response.
+    ///
+    /// Any existing answer for the key is replaced.  \c data must begin
+    /// with the DNS header followed by the question of the key.
+    ///
+    /// \throw bundy::InvalidParameter data is too short for the header and
+    /// the question
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param key The key of the answer.
+    /// \param zone_id The ID of the zone the response was built from.
+    /// \param generation The generation of the zone's data the response
+    /// was built from.
+    /// \param data The wire-format response.
+    /// \param length The length of \c data.
+    void addAnswer(const AnswerCacheKey& key, size_t zone_id,
+                   uint64_t generation, const void* data, size_t length);
+
+    /// \brief Return the number of entries currently in the cache.
+    size_t getEntryCount() const;
+
+    /// \brief Return the maximum number of entries in the cache.
+    size_t getMaxEntries() const;
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_ANSWER_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
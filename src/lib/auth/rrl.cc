@@ -0,0 +1,319 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <auth/rrl.h>
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+#include <auth/rrl_log.h>
+#include <auth/rrl_name_pool.h>
+#include <auth/rrl_table.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <asiolink/io_endpoint.h>
+
+#include <util/threads/sync.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <netinet/in.h>
+
+using bundy::asiolink::IOEndpoint;
+using bundy::dns::LabelSequence;
+using bundy::dns::Name;
+using bundy::dns::RRClass;
+using bundy::dns::RRType;
+using bundy::util::thread::Mutex;
+
+namespace bundy {
+namespace auth {
+
+using namespace detail;
+
+namespace {
+// The max number of query names saved (per shard) for logging "stop
+// limiting" events.
+const size_t MAX_LOG_QNAMES = 256;
+
+// The table is split into at most this many shards, each with its own lock,
+// so concurrent calls to check() rarely contend.  A table is only split if
+// every shard can hold at least MIN_SHARD_ENTRIES entries; smaller tables
+// keep a single shard so the LRU purge order stays exact.
+const size_t MAX_SHARDS = 16;
+const size_t MIN_SHARD_ENTRIES = 1024;
+
+const char* const RESPONSE_TYPE_TEXT[] = { "normal", "NXDOMAIN", "error" };
+
+uint32_t
+makeMask(int prefixlen) {
+    return (prefixlen <= 0 ? 0 :
+            prefixlen >= 32 ? 0xffffffff : ~(0xffffffff >> prefixlen));
+}
+}
+
+struct ResponseLimiter::Impl {
+    // A part of the table holding the entries whose keys hash to it, with
+    // the timestamp bases and logged names of those entries.  All members
+    // are protected by mutex_.
+    struct Shard : boost::noncopyable {
+        Shard(Impl* impl, size_t max_entries, std::time_t now) :
+            table_(max_entries,
+                   boost::bind(&Impl::recycleEntry, impl, this, _1)),
+            ts_bases_(now, boost::bind(&RRLTable::invalidateTimestamps,
+                                       &table_, _1)),
+            log_qnames_(MAX_LOG_QNAMES)
+        {}
+
+        Mutex mutex_;
+        RRLTable table_;
+        RRLTimeStamps ts_bases_;
+        NamePool log_qnames_;
+    };
+    typedef boost::shared_ptr<Shard> ShardPtr;
+
+    Impl(int responses_per_second, int nxdomains_per_second,
+         int errors_per_second, int window, int slip, size_t max_table_size,
+         int ipv4_prefixlen, int ipv6_prefixlen, bool log_only,
+         std::time_t now, uint32_t hash_seed) :
+        window_(window), slip_(slip),
+        ipv4_prefixlen_(ipv4_prefixlen),
+        ipv6_prefixlen_(ipv6_prefixlen > 64 ? 64 : ipv6_prefixlen),
+        ipv4_mask_(htonl(makeMask(ipv4_prefixlen))), log_only_(log_only),
+        hash_seed_(hash_seed)
+    {
+        size_t n_shards = max_table_size / MIN_SHARD_ENTRIES;
+        if (n_shards > MAX_SHARDS) {
+            n_shards = MAX_SHARDS;
+        } else if (n_shards == 0) {
+            n_shards = 1;
+        }
+        const size_t shard_size = (max_table_size + n_shards - 1) / n_shards;
+        for (size_t i = 0; i < n_shards; ++i) {
+            shards_.push_back(ShardPtr(new Shard(this, shard_size, now)));
+        }
+        rates_[RESPONSE_QUERY] = responses_per_second;
+        rates_[RESPONSE_NXDOMAIN] = nxdomains_per_second;
+        rates_[RESPONSE_ERROR] = errors_per_second;
+        ipv6_masks_[0] = htonl(makeMask(ipv6_prefixlen_));
+        ipv6_masks_[1] = htonl(makeMask(ipv6_prefixlen_ - 32));
+        ipv6_masks_[2] = 0;
+        ipv6_masks_[3] = 0;
+    }
+
+    // Return the shard for the key.  The table buckets are chosen by the
+    // low bits of the hash, so use the upper bits here to keep the entries
+    // of a shard spread over all of its buckets.
+    Shard& getShard(const RRLKey& key) {
+        return (*shards_[(key.getHash() >> 16) % shards_.size()]);
+    }
+
+    // Log the end of limiting for the entry, and release the saved name.
+    // The shard's mutex must be held.
+    void logStop(Shard& shard, RRLEntry& entry) {
+        const Name* qname = shard.log_qnames_.getName(entry.getLogQName());
+        LOG_INFO(rrl_logger, LIBAUTH_RRL_STOP_LIMIT).
+            arg(RESPONSE_TYPE_TEXT[entry.getKey().getResponseType()]).
+            arg(entry.getKey().getIPText(ipv4_prefixlen_, ipv6_prefixlen_)).
+            arg(makeLogTarget(entry.getKey(), qname));
+        shard.log_qnames_.freeName(entry.getLogQName());
+        entry.setLogged(false, 0);
+    }
+
+    void recycleEntry(Shard* shard, RRLEntry& entry) {
+        if (entry.isLogged()) {
+            logStop(*shard, entry);
+        }
+    }
+
+    std::string makeLogTarget(const RRLKey& key, const Name* qname) const {
+        const ResponseType resp_type = key.getResponseType();
+        if (resp_type == RESPONSE_ERROR) {
+            return ("any name");
+        }
+        std::string target = qname ? qname->toText(true) : std::string("?");
+        if (resp_type == RESPONSE_QUERY) {
+            target += " " + key.getClassText() + " " + key.getType().toText();
+        }
+        return (target);
+    }
+
+    int rates_[RESPONSE_TYPE_MAX + 1];
+    const int window_;
+    const int slip_;
+    const int ipv4_prefixlen_;
+    const int ipv6_prefixlen_;
+    const uint32_t ipv4_mask_;
+    uint32_t ipv6_masks_[4];
+    const bool log_only_;
+    const uint32_t hash_seed_;
+    std::vector<ShardPtr> shards_;
+};
+
+ResponseLimiter::ResponseLimiter(int responses_per_second,
+                                 int nxdomains_per_second,
+                                 int errors_per_second, int window, int slip,
+                                 size_t max_table_size, int ipv4_prefixlen,
+                                 int ipv6_prefixlen, bool log_only,
+                                 std::time_t now, uint32_t hash_seed) :
+    impl_(NULL)
+{
+    if (responses_per_second < 0 || nxdomains_per_second < 0 ||
+        errors_per_second < 0) {
+        bundy_throw(InvalidParameter, "RRL rates must not be negative");
+    }
+    if (window < 1 || window > 3600) {
+        bundy_throw(InvalidParameter, "RRL window out of range: " << window);
+    }
+    if (slip < 0 || slip > 10) {
+        bundy_throw(InvalidParameter, "RRL slip out of range: " << slip);
+    }
+    if (max_table_size == 0) {
+        bundy_throw(InvalidParameter, "RRL max table size must not be 0");
+    }
+    if (ipv4_prefixlen < 0 || ipv4_prefixlen > 32) {
+        bundy_throw(InvalidParameter, "RRL IPv4 prefix length out of range: "
+                    << ipv4_prefixlen);
+    }
+    if (ipv6_prefixlen < 0 || ipv6_prefixlen > 128) {
+        bundy_throw(InvalidParameter, "RRL IPv6 prefix length out of range: "
+                    << ipv6_prefixlen);
+    }
+    impl_ = new Impl(responses_per_second, nxdomains_per_second,
+                     errors_per_second, window, slip, max_table_size,
+                     ipv4_prefixlen, ipv6_prefixlen, log_only, now,
+                     hash_seed);
+}
+
+ResponseLimiter::~ResponseLimiter() {
+    delete impl_;
+}
+
+RRLResult
+ResponseLimiter::check(const IOEndpoint& client, bool is_tcp,
+                       const RRClass& qclass, const RRType& qtype,
+                       const Name* qname, ResponseType resp_type,
+                       std::time_t now)
+{
+    // A TCP client has proven its address, so it can't be a victim.
+    if (is_tcp) {
+        return (RRL_OK);
+    }
+    const int rate = impl_->rates_[resp_type];
+    if (rate == 0) {
+        return (RRL_OK);
+    }
+
+    // Error responses are limited per client network regardless of names.
+    if (resp_type == RESPONSE_ERROR) {
+        qname = NULL;
+    }
+    RRLKey key;
+    if (qname) {
+        const LabelSequence qname_labels(*qname);
+        key = RRLKey(client, qtype, &qname_labels, qclass, resp_type,
+                     impl_->ipv4_mask_, impl_->ipv6_masks_,
+                     impl_->hash_seed_);
+    } else {
+        key = RRLKey(client, qtype, NULL, qclass, resp_type,
+                     impl_->ipv4_mask_, impl_->ipv6_masks_,
+                     impl_->hash_seed_);
+    }
+    Impl::Shard& shard = impl_->getShard(key);
+    Mutex::Locker locker(shard.mutex_);
+    RRLEntry& entry = shard.table_.getEntry(key);
+    if (entry.isLogged() &&
+        entry.getAge(shard.ts_bases_, now) > impl_->window_) {
+        // It's been quiet for a full window since the last response, so
+        // it's no longer considered to be limited.
+        impl_->logStop(shard, entry);
+    }
+    const RRLResult result = entry.updateBalance(shard.ts_bases_, rate,
+                                                 impl_->slip_,
+                                                 impl_->window_, now);
+    if (result == RRL_OK) {
+        return (RRL_OK);
+    }
+
+    if (!entry.isLogged()) {
+        if (qname) {
+            const std::pair<bool, size_t> saved =
+                shard.log_qnames_.saveName(*qname);
+            entry.setLogged(true, saved.second);
+        } else {
+            entry.setLogged(true, MAX_LOG_QNAMES);
+        }
+        LOG_INFO(rrl_logger, impl_->log_only_ ?
+                 LIBAUTH_RRL_LIMIT_LOG_ONLY : LIBAUTH_RRL_LIMIT).
+            arg(RESPONSE_TYPE_TEXT[resp_type]).
+            arg(key.getIPText(impl_->ipv4_prefixlen_,
+                              impl_->ipv6_prefixlen_)).
+            arg(impl_->makeLogTarget(key, qname));
+    }
+    return (impl_->log_only_ ? RRL_OK : result);
+}
+
+int
+ResponseLimiter::getResponseRate() const {
+    return (impl_->rates_[RESPONSE_QUERY]);
+}
+
+int
+ResponseLimiter::getNXDOMAINRate() const {
+    return (impl_->rates_[RESPONSE_NXDOMAIN]);
+}
+
+int
+ResponseLimiter::getErrorRate() const {
+    return (impl_->rates_[RESPONSE_ERROR]);
+}
+
+int
+ResponseLimiter::getWindow() const {
+    return (impl_->window_);
+}
+
+int
+ResponseLimiter::getSlip() const {
+    return (impl_->slip_);
+}
+
+bool
+ResponseLimiter::isLogOnly() const {
+    return (impl_->log_only_);
+}
+
+size_t
+ResponseLimiter::getEntryCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < impl_->shards_.size(); ++i) {
+        Impl::Shard& shard = *impl_->shards_[i];
+        Mutex::Locker locker(shard.mutex_);
+        count += shard.table_.getEntryCount();
+    }
+    return (count);
+}
+
+} // namespace auth
+} // namespace bundy
@@ -0,0 +1,158 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef AUTH_RRL_H
+#define AUTH_RRL_H 1
+
+#include <auth/rrl_response_type.h>
+#include <auth/rrl_result.h>
+
+#include <dns/dns_fwd.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <ctime>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace asiolink {
+class IOEndpoint;
+}
+
+namespace auth {
+
+/// \brief Response Rate Limiting (RRL) engine.
+///
+/// This class implements the DNS Response Rate Limiting, which was
+/// originally designed and implemented for BIND 9, to mitigate reflection
+/// (amplification) attacks using authoritative servers.
+///
+/// Responses are classified into entries by the client network (the
+/// address masked by the configured prefix length), the response type
+/// (normal answer, NXDOMAIN, or error), and the query name, type and class.
+/// Each entry is given credit of a configured number of responses per
+/// second for its response type, and a response is limited once the credit
+/// is used up.  A limited response is normally dropped, but every \c slip-th
+/// one is "slipped", i.e., replaced with a small truncated response so
+/// legitimate clients whose address is spoofed can still retry over TCP.
+///
+/// For NXDOMAIN responses the name of the zone (or any other name shared
+/// by the responses, as chosen by the caller) should be passed instead of
+/// the query name, so the attacker cannot avoid limiting by querying random
+/// names.  Error responses are limited regardless of the query name.
+///
+/// Responses over TCP are never limited, since the client address cannot
+/// be forged for them.
+///
+/// If configured in the log-only mode, the engine performs all accounting
+/// and logging but never actually limits responses; this is useful to see
+/// how the limits would work before enabling them.
+///
+/// check() may be called concurrently by multiple threads.  For large tables
+/// the entries are split into shards by the hash of their keys, each
+/// protected by its own lock, so threads contend only when their responses
+/// map to the same shard.
+class ResponseLimiter : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// A rate of 0 means responses of the corresponding type are never
+    /// limited.
+    ///
+    /// \throw bundy::InvalidParameter any of the parameters is out of range.
+    /// \throw std::bad_alloc memory allocation failed.
+    ///
+    /// \param responses_per_second The limit of normal responses per second.
+    /// \param nxdomains_per_second The limit of NXDOMAIN responses per second.
+    /// \param errors_per_second The limit of error responses per second.
+    /// \param window The window of the rates in seconds (1 to 3600).
+    /// \param slip The slip ratio (0 to 10).
+    /// \param max_table_size The maximum number of entries to maintain.
+    /// \param ipv4_prefixlen The prefix length of client IPv4 networks.
+    /// \param ipv6_prefixlen The prefix length of client IPv6 networks.
+    /// Only up to the higher 64 bits are used; a larger value is accepted
+    /// but has the same effect as 64.
+    /// \param log_only If true, responses are never actually limited.
+    /// \param now The current time.
+    /// \param hash_seed A seed value to calculate hash of query names.
+    /// It should be an unpredictable random value.
+    ResponseLimiter(int responses_per_second, int nxdomains_per_second,
+                    int errors_per_second, int window, int slip,
+                    size_t max_table_size, int ipv4_prefixlen,
+                    int ipv6_prefixlen, bool log_only, std::time_t now,
+                    uint32_t hash_seed);
+
+    /// \brief Destructor.
+    ~ResponseLimiter();
+
+    /// \brief Check whether a response should be limited.
+    ///
+    /// This method updates the entry for the response and returns how the
+    /// response should be handled.  In the log-only mode it always returns
+    /// \c RRL_OK.  It also logs the start and stop of limiting for each
+    /// entry.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param client The client's end point.
+    /// \param is_tcp Whether the query was received over TCP.
+    /// \param qclass The query class.
+    /// \param qtype The query type.
+    /// \param qname The query name (or zone name for NXDOMAIN).  Can be NULL,
+    /// and is ignored for \c RESPONSE_ERROR.
+    /// \param resp_type The response type.
+    /// \param now The current time.
+    /// \return The result of rate limiting for the response.
+    RRLResult check(const asiolink::IOEndpoint& client, bool is_tcp,
+                    const dns::RRClass& qclass, const dns::RRType& qtype,
+                    const dns::Name* qname, detail::ResponseType resp_type,
+                    std::time_t now);
+
+    /// \brief Return the limit of normal responses per second.
+    int getResponseRate() const;
+
+    /// \brief Return the limit of NXDOMAIN responses per second.
+    int getNXDOMAINRate() const;
+
+    /// \brief Return the limit of error responses per second.
+    int getErrorRate() const;
+
+    /// \brief Return the window of the rates in seconds.
+    int getWindow() const;
+
+    /// \brief Return the slip ratio.
+    int getSlip() const;
+
+    /// \brief Return whether it's in the log-only mode.
+    bool isLogOnly() const;
+
+    /// \brief Return the number of entries currently maintained.
+    size_t getEntryCount() const;
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,97 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <auth/rrl_entry.h>
+
+#include <utility>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+int
+RRLEntry::getAge(const RRLTimeStamps& ts_bases, std::time_t now) const {
+    if (!timestamp_valid_) {
+        return (RRL_TIMESTAMP_FOREVER);
+    }
+    return (RRLTimeStamps::deltaTime(
+                ts_bases.getBaseByGen(timestamp_gen_) + timestamp_, now));
+}
+
+void
+RRLEntry::setAge(RRLTimeStamps& ts_bases, std::time_t now) {
+    const std::pair<std::time_t, size_t> base = ts_bases.getCurrentBase(now);
+    int ts = now - base.first;
+    if (ts < 0) {
+        // The base can be in the "near future" (see getCurrentBase());
+        // consider the response happened at the base time.
+        ts = 0;
+    } else if (ts >= RRL_TIMESTAMP_FOREVER) {
+        // This shouldn't happen as the base is updated before it's too old,
+        // but we make sure the value fits in the storage.
+        ts = RRL_TIMESTAMP_FOREVER - 1;
+    }
+    timestamp_ = ts;
+    timestamp_gen_ = base.second;
+    timestamp_valid_ = true;
+}
+
+RRLResult
+RRLEntry::updateBalance(RRLTimeStamps& ts_bases, int rate, int slip,
+                        int window, std::time_t now)
+{
+    // Credit the entry for the time passed since the last response.  If
+    // it's unused for longer than the window, the past doesn't matter and
+    // we start over with the full credit.
+    const int age = getAge(ts_bases, now);
+    if (age > window) {
+        responses_ = rate;
+    } else if (age > 0) {
+        responses_ += rate * age;
+        if (responses_ > rate) {
+            responses_ = rate;
+        }
+    }
+    if (age > 0) {
+        setAge(ts_bases, now);
+    }
+
+    // Then debit it for this response.
+    if (--responses_ >= 0) {
+        return (RRL_OK);
+    }
+    const int min_balance = -window * rate;
+    if (responses_ < min_balance) {
+        responses_ = min_balance;
+    }
+
+    // Let the first limited response and every slip-th one after that slip.
+    if (slip > 0) {
+        if (slip_count_++ == 0) {
+            if (slip_count_ >= slip) {
+                slip_count_ = 0;
+            }
+            return (RRL_SLIP);
+        }
+        if (slip_count_ >= slip) {
+            slip_count_ = 0;
+        }
+    }
+    return (RRL_DROP);
+}
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
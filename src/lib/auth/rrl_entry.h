@@ -0,0 +1,184 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef AUTH_RRL_ENTRY_H
+#define AUTH_RRL_ENTRY_H 1
+
+#include <auth/rrl_key.h>
+#include <auth/rrl_result.h>
+#include <auth/rrl_timestamps.h>
+
+#include <boost/intrusive/list.hpp>
+
+#include <ctime>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+/// \brief Number of timestamp bases maintained for RRL entries.
+const size_t RRL_TIMESTAMP_BASES_COUNT = 4;
+
+/// \brief The time range in seconds while an entry's timestamp is valid
+/// relative to its base.
+const int RRL_TIMESTAMP_FOREVER = 4096;
+
+/// \brief The timestamp bases used for RRL entries.
+typedef RRLTimeStampBases<RRL_TIMESTAMP_BASES_COUNT, RRL_TIMESTAMP_FOREVER>
+RRLTimeStamps;
+
+/// \brief A single entry of the RRL table.
+///
+/// An entry corresponds to a particular \c RRLKey, i.e., a set of responses
+/// of the same type to the same client network, and maintains the "credit"
+/// balance of the responses.  The balance is replenished by the configured
+/// rate every second, and is debited by one for every response.  Once it
+/// becomes negative the responses are limited.
+///
+/// To keep the memory footprint small, the time of the last response is
+/// stored as a 12-bit offset from one of the timestamp bases maintained
+/// in an \c RRLTimeStamps object, which is shared by all entries of the
+/// same table.
+class RRLEntry {
+public:
+    /// \brief The default constructor.
+    ///
+    /// The constructed entry is not associated with any key; reset() must
+    /// be called before it's used.
+    RRLEntry() :
+        responses_(0), log_qname_(0), timestamp_(0), timestamp_gen_(0),
+        timestamp_valid_(false), logged_(false), slip_count_(0)
+    {}
+
+    /// \brief Reinitialize the entry for the given key.
+    ///
+    /// All accounting information, including the timestamp, is reset.
+    /// The log state is reset, too; it's the caller's responsibility to
+    /// release any resource associated with the old state before calling
+    /// this method.
+    ///
+    /// \throw None
+    void reset(const RRLKey& key) {
+        key_ = key;
+        responses_ = 0;
+        log_qname_ = 0;
+        timestamp_ = 0;
+        timestamp_gen_ = 0;
+        timestamp_valid_ = false;
+        logged_ = false;
+        slip_count_ = 0;
+    }
+
+    /// \brief Return the key of the entry.
+    const RRLKey& getKey() const { return (key_); }
+
+    /// \brief Return the seconds passed since the last response for the
+    /// entry.
+    ///
+    /// If the entry has never been used or its timestamp has been
+    /// invalidated, it returns \c RRL_TIMESTAMP_FOREVER.
+    ///
+    /// \throw None
+    int getAge(const RRLTimeStamps& ts_bases, std::time_t now) const;
+
+    /// \brief Record the given time as the time of the last response.
+    ///
+    /// \throw None
+    void setAge(RRLTimeStamps& ts_bases, std::time_t now);
+
+    /// \brief Invalidate the timestamp if it's relative to the given
+    /// generation of timestamp base.
+    ///
+    /// This is expected to be called when that generation of base is about
+    /// to be reused.
+    ///
+    /// \throw None
+    void invalidateTimestamp(size_t gen) {
+        if (timestamp_gen_ == gen) {
+            timestamp_valid_ = false;
+        }
+    }
+
+    /// \brief Credit and debit the balance for a new response.
+    ///
+    /// The balance is first credited for the seconds passed since the last
+    /// response (limited to \c rate), and then debited by one for the
+    /// current response.  If the resulting balance is negative, the response
+    /// is limited: every \c slip-th limited response (starting from the
+    /// first one) results in \c RRL_SLIP, and the others in \c RRL_DROP.
+    /// If \c slip is 0, limited responses are always dropped.  The negative
+    /// balance is bounded by \c window times \c rate.
+    ///
+    /// \throw None
+    ///
+    /// \param ts_bases The timestamp bases of the table.
+    /// \param rate The allowed responses per second for the entry.  Must be
+    /// positive.
+    /// \param slip The slip ratio.
+    /// \param window The window of the rate in seconds.  Must be positive.
+    /// \param now The current time.
+    /// \return The result of rate limiting for the response.
+    RRLResult updateBalance(RRLTimeStamps& ts_bases, int rate, int slip,
+                            int window, std::time_t now);
+
+    /// \brief Return the current balance of the entry.
+    int getResponseBalance() const { return (responses_); }
+
+    /// \brief Return whether the start of limiting has been logged.
+    bool isLogged() const { return (logged_); }
+
+    /// \brief Return the index of the saved name for logging.
+    ///
+    /// This is only meaningful if isLogged() is true.
+    size_t getLogQName() const { return (log_qname_); }
+
+    /// \brief Set or clear the "logged" state of the entry.
+    ///
+    /// \param logged Whether the start of limiting has been logged.
+    /// \param log_qname An index of a saved name (in \c NamePool) for
+    /// the query name used on logging.
+    void setLogged(bool logged, size_t log_qname) {
+        logged_ = logged;
+        log_qname_ = log_qname;
+    }
+
+    /// \brief Hook for the list of the same hash bucket.
+    boost::intrusive::list_member_hook<> hash_hook_;
+
+    /// \brief Hook for the LRU list.
+    boost::intrusive::list_member_hook<> lru_hook_;
+
+private:
+    RRLKey key_;
+    int32_t responses_;         // current balance of the credit
+    size_t log_qname_;          // index of the name in NamePool for logging
+    uint16_t timestamp_;        // offset of the last response time from base
+    uint8_t timestamp_gen_;     // generation of the timestamp base
+    bool timestamp_valid_;      // whether timestamp is meaningful
+    bool logged_;               // whether limiting has been logged
+    uint8_t slip_count_;        // number of limited responses modulo slip
+};
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_ENTRY_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,37 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef AUTH_RRL_RESULT_H
+#define AUTH_RRL_RESULT_H 1
+
+namespace bundy {
+namespace auth {
+
+/// \brief Result of response rate limiting.
+enum RRLResult {
+    RRL_OK,                     ///< The response can be sent as usual
+    RRL_DROP,                   ///< The response should be dropped
+    RRL_SLIP                    ///< A truncated (TC=1) response should be
+                                ///< sent instead of the real response
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_RESULT_H
+
+// Local Variables:
+// mode: c++
+// End:
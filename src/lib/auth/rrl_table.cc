@@ -0,0 +1,151 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <auth/rrl_table.h>
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+
+#include <exceptions/exceptions.h>
+
+#include <boost/intrusive/list.hpp>
+#include <boost/scoped_array.hpp>
+
+#include <deque>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+struct RRLTable::Impl {
+    typedef boost::intrusive::list<
+        RRLEntry,
+        boost::intrusive::member_hook<
+            RRLEntry, boost::intrusive::list_member_hook<>,
+            &RRLEntry::hash_hook_>,
+        boost::intrusive::constant_time_size<false> > HashBucket;
+    typedef boost::intrusive::list<
+        RRLEntry,
+        boost::intrusive::member_hook<
+            RRLEntry, boost::intrusive::list_member_hook<>,
+            &RRLEntry::lru_hook_> > LRUList;
+
+    Impl(size_t max_entries, RecycleCallback callback) :
+        max_entries_(max_entries), bucket_mask_(0), callback_(callback)
+    {
+        // Use a power of 2 not smaller than max_entries as the number of
+        // buckets so the average length of the chains is at most 1 and
+        // a bucket can be identified by masking the hash value.
+        size_t n_buckets = 1;
+        while (n_buckets < max_entries) {
+            n_buckets <<= 1;
+        }
+        bucket_mask_ = n_buckets - 1;
+        buckets_.reset(new HashBucket[n_buckets]);
+    }
+
+    ~Impl() {
+        // Unlink all entries before they are destroyed so the (safe mode)
+        // hooks won't complain.
+        lru_.clear();
+        for (size_t i = 0; i <= bucket_mask_; ++i) {
+            buckets_[i].clear();
+        }
+    }
+
+    HashBucket& getBucket(const RRLKey& key) {
+        return (buckets_[key.getHash() & bucket_mask_]);
+    }
+
+    const size_t max_entries_;
+    size_t bucket_mask_;
+    boost::scoped_array<HashBucket> buckets_;
+    LRUList lru_;               // most recently used entry first
+    // A deque never relocates existing elements on push_back(), so it's
+    // safe to keep the entries linked in the intrusive lists.
+    std::deque<RRLEntry> entries_;
+    const RecycleCallback callback_;
+};
+
+RRLTable::RRLTable(size_t max_entries, RecycleCallback callback) {
+    if (max_entries == 0) {
+        bundy_throw(InvalidParameter, "RRL table size must not be 0");
+    }
+    impl_ = new Impl(max_entries, callback);
+}
+
+RRLTable::~RRLTable() {
+    delete impl_;
+}
+
+RRLEntry&
+RRLTable::getEntry(const RRLKey& key) {
+    Impl::HashBucket& bucket = impl_->getBucket(key);
+    for (Impl::HashBucket::iterator it = bucket.begin(); it != bucket.end();
+         ++it) {
+        if (it->getKey() == key) {
+            // Move it to the head of both the LRU list and the bucket, so
+            // a busy entry will be found sooner next time.
+            impl_->lru_.erase(impl_->lru_.iterator_to(*it));
+            impl_->lru_.push_front(*it);
+            if (it != bucket.begin()) {
+                RRLEntry& entry = *it;
+                bucket.erase(it);
+                bucket.push_front(entry);
+            }
+            return (bucket.front());
+        }
+    }
+
+    RRLEntry* entry;
+    if (impl_->entries_.size() < impl_->max_entries_) {
+        impl_->entries_.push_back(RRLEntry());
+        entry = &impl_->entries_.back();
+    } else {
+        entry = &impl_->lru_.back();
+        if (impl_->callback_) {
+            impl_->callback_(*entry);
+        }
+        impl_->lru_.pop_back();
+        Impl::HashBucket& old_bucket = impl_->getBucket(entry->getKey());
+        old_bucket.erase(old_bucket.iterator_to(*entry));
+    }
+    entry->reset(key);
+    impl_->lru_.push_front(*entry);
+    bucket.push_front(*entry);
+    return (*entry);
+}
+
+void
+RRLTable::invalidateTimestamps(size_t gen) {
+    for (Impl::LRUList::iterator it = impl_->lru_.begin();
+         it != impl_->lru_.end();
+         ++it) {
+        it->invalidateTimestamp(gen);
+    }
+}
+
+size_t
+RRLTable::getEntryCount() const {
+    return (impl_->entries_.size());
+}
+
+size_t
+RRLTable::getMaxEntries() const {
+    return (impl_->max_entries_);
+}
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
@@ -0,0 +1,103 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef AUTH_RRL_TABLE_H
+#define AUTH_RRL_TABLE_H 1
+
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+/// \brief The table of RRL entries.
+///
+/// This is a hash table of \c RRLEntry objects with a fixed maximum number
+/// of entries.  The entries are also linked in an LRU list; once the table
+/// is full, the least recently used entry is recycled for a new key.
+///
+/// Entries are allocated on demand up to the maximum, and are never freed
+/// until the table is destroyed; the hash buckets are allocated on
+/// construction.
+///
+/// This class is not thread safe.
+class RRLTable : boost::noncopyable {
+public:
+    /// \brief A functor type to be called when an entry is about to be
+    /// recycled for a different key.
+    typedef boost::function<void(RRLEntry&)> RecycleCallback;
+
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_entries is 0
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The maximum number of entries in the table.
+    /// \param callback Functor to be called when an entry is recycled.
+    /// It can be empty.
+    RRLTable(size_t max_entries, RecycleCallback callback);
+
+    /// \brief Destructor.
+    ~RRLTable();
+
+    /// \brief Return the entry for the given key.
+    ///
+    /// If the entry for the key is found it's returned; otherwise, a new
+    /// entry is allocated, or, if the table is full, the least recently
+    /// used entry is recycled (calling the recycle callback) and
+    /// initialized for the key.  In either case the returned entry becomes
+    /// the most recently used one.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param key The key of the entry.
+    /// \return A reference to the entry for the key.
+    RRLEntry& getEntry(const RRLKey& key);
+
+    /// \brief Invalidate timestamps of all entries relative to the given
+    /// generation of timestamp base.
+    ///
+    /// This is expected to be used as (a part of) the base change callback
+    /// of \c RRLTimeStamps.
+    ///
+    /// \throw None
+    void invalidateTimestamps(size_t gen);
+
+    /// \brief Return the number of entries currently in the table.
+    size_t getEntryCount() const;
+
+    /// \brief Return the maximum number of entries in the table.
+    size_t getMaxEntries() const;
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_TABLE_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,333 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/answer_cache.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <dns/rdataclass.h>
+
+#include <util/buffer.h>
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using namespace bundy::auth;
+using namespace bundy::dns;
+using bundy::util::OutputBuffer;
+
+namespace {
+
+// Generations of a few zones, all 1 initially.
+class TestGenerations : public AnswerCache::Generations {
+public:
+    TestGenerations() : generations_(2, 1) {}
+
+    virtual uint64_t getGeneration(size_t zone_id) const {
+        return (generations_.at(zone_id));
+    }
+
+    std::vector<uint64_t> generations_;
+};
+
+class AnswerCacheTest : public ::testing::Test {
+protected:
+    AnswerCacheTest() :
+        cache_(3), qname_("www.example.org"), query_(0), response_(0)
+    {
+        renderQuery(query_, qname_, 0x1234, false);
+        renderResponse(response_, qname_, RRType::A());
+    }
+
+    // Render a query for <name>/A/IN
+    void renderQuery(OutputBuffer& buffer, const Name& name, qid_t qid,
+                     bool rd)
+    {
+        Message message(Message::RENDER);
+        message.setQid(qid);
+        message.setOpcode(Opcode::QUERY());
+        message.setRcode(Rcode::NOERROR());
+        message.setHeaderFlag(Message::HEADERFLAG_RD, rd);
+        message.addQuestion(Question(name, RRClass::IN(), RRType::A()));
+        MessageRenderer renderer;
+        renderer.setBuffer(&buffer);
+        message.toWire(renderer);
+        renderer.setBuffer(NULL);
+    }
+
+    // Render an authoritative response for <name>/<qtype>/IN with one A RR
+    void renderResponse(OutputBuffer& buffer, const Name& name,
+                        const RRType& qtype)
+    {
+        Message message(Message::RENDER);
+        message.setQid(0);
+        message.setOpcode(Opcode::QUERY());
+        message.setRcode(Rcode::NOERROR());
+        message.setHeaderFlag(Message::HEADERFLAG_QR);
+        message.setHeaderFlag(Message::HEADERFLAG_AA);
+        message.addQuestion(Question(name, RRClass::IN(), qtype));
+        RRsetPtr rrset(new RRset(name, RRClass::IN(), RRType::A(),
+                                 RRTTL(3600)));
+        rrset->addRdata(rdata::in::A("192.0.2.1"));
+        message.addRRset(Message::SECTION_ANSWER, rrset);
+        MessageRenderer renderer;
+        renderer.setBuffer(&buffer);
+        message.toWire(renderer);
+        renderer.setBuffer(NULL);
+    }
+
+    // Parse the given wire data as a message
+    void parse(const OutputBuffer& buffer, Message& message) {
+        bundy::util::InputBuffer ibuffer(buffer.getData(),
+                                         buffer.getLength());
+        message.fromWire(ibuffer);
+    }
+
+    AnswerCacheKey makeKey(const Name& name) {
+        return (AnswerCacheKey(name, RRType::A(), RRClass::IN(), false,
+                               false));
+    }
+
+    // Look up the answer to query_ while zone 0 is of the given generation
+    bool getAnswer(const AnswerCacheKey& key, uint64_t generation,
+                   OutputBuffer& buffer, size_t limit = 512)
+    {
+        generations_.generations_[0] = generation;
+        return (cache_.getAnswer(key, generations_, query_.getData(),
+                                 query_.getLength(), limit, buffer));
+    }
+
+    // Add an answer for <name>/A/IN from the zone of generation 1
+    void addAnswer(const Name& name, size_t zone_id = 0) {
+        OutputBuffer response(0);
+        renderResponse(response, name, RRType::A());
+        cache_.addAnswer(makeKey(name), zone_id, 1, response.getData(),
+                         response.getLength());
+    }
+
+    // Check if there's a current answer for <name>/A/IN
+    bool hasAnswer(const Name& name) {
+        OutputBuffer query(0);
+        renderQuery(query, name, 0, false);
+        OutputBuffer buffer(0);
+        return (cache_.getAnswer(makeKey(name), generations_,
+                                 query.getData(), query.getLength(), 512,
+                                 buffer));
+    }
+
+    TestGenerations generations_;
+    AnswerCache cache_;
+    const Name qname_;
+    OutputBuffer query_;
+    OutputBuffer response_;
+};
+
+TEST_F(AnswerCacheTest, construct) {
+    EXPECT_EQ(0, cache_.getEntryCount());
+    EXPECT_EQ(3, cache_.getMaxEntries());
+    EXPECT_THROW(AnswerCache(0), bundy::InvalidParameter);
+}
+
+TEST_F(AnswerCacheTest, getAnswer) {
+    OutputBuffer buffer(0);
+    EXPECT_FALSE(getAnswer(makeKey(qname_), 1, buffer));
+    EXPECT_EQ(0, buffer.getLength());
+
+    cache_.addAnswer(makeKey(qname_), 0, 1, response_.getData(),
+                     response_.getLength());
+    EXPECT_EQ(1, cache_.getEntryCount());
+    ASSERT_TRUE(getAnswer(makeKey(qname_), 1, buffer));
+    ASSERT_EQ(response_.getLength(), buffer.getLength());
+
+    // The ID is taken from the query; the rest is the cached response.
+    Message message(Message::PARSE);
+    parse(buffer, message);
+    EXPECT_EQ(0x1234, message.getQid());
+    EXPECT_TRUE(message.getHeaderFlag(Message::HEADERFLAG_AA));
+    EXPECT_FALSE(message.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_EQ(1, message.getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ(0, std::memcmp(
+                  static_cast<const uint8_t*>(buffer.getData()) + 2,
+                  static_cast<const uint8_t*>(response_.getData()) + 2,
+                  response_.getLength() - 2));
+
+    // Different keys don't match.
+    buffer.clear();
+    EXPECT_FALSE(cache_.getAnswer(
+                     AnswerCacheKey(qname_, RRType::A(), RRClass::IN(), true,
+                                    false),
+                     generations_, query_.getData(), query_.getLength(), 512,
+                     buffer));
+    EXPECT_FALSE(cache_.getAnswer(
+                     AnswerCacheKey(qname_, RRType::A(), RRClass::IN(), false,
+                                    true),
+                     generations_, query_.getData(), query_.getLength(), 512,
+                     buffer));
+    EXPECT_FALSE(cache_.getAnswer(
+                     AnswerCacheKey(qname_, RRType::AAAA(), RRClass::IN(),
+                                    false, false),
+                     generations_, query_.getData(), query_.getLength(), 512,
+                     buffer));
+    EXPECT_FALSE(cache_.getAnswer(
+                     AnswerCacheKey(qname_, RRType::A(), RRClass::CH(), false,
+                                    false),
+                     generations_, query_.getData(), query_.getLength(), 512,
+                     buffer));
+    EXPECT_EQ(0, buffer.getLength());
+}
+
+TEST_F(AnswerCacheTest, patchQuery) {
+    cache_.addAnswer(makeKey(qname_), 0, 1, response_.getData(),
+                     response_.getLength());
+
+    // The RD flag and the case of the query name come from the query.
+    const Name upper_name("WWW.Example.ORG");
+    query_.clear();
+    renderQuery(query_, upper_name, 0xabcd, true);
+    OutputBuffer buffer(0);
+    ASSERT_TRUE(getAnswer(makeKey(upper_name), 1, buffer));
+    Message message(Message::PARSE);
+    parse(buffer, message);
+    EXPECT_EQ(0xabcd, message.getQid());
+    EXPECT_TRUE(message.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_TRUE(message.getHeaderFlag(Message::HEADERFLAG_QR));
+    EXPECT_EQ("WWW.Example.ORG.",
+              (*message.beginQuestion())->getName().toText(false));
+}
+
+TEST_F(AnswerCacheTest, generation) {
+    cache_.addAnswer(makeKey(qname_), 0, 1, response_.getData(),
+                     response_.getLength());
+    OutputBuffer buffer(0);
+    EXPECT_FALSE(getAnswer(makeKey(qname_), 2, buffer));
+
+    // Adding it again for the new generation replaces the old one.
+    cache_.addAnswer(makeKey(qname_), 0, 2, response_.getData(),
+                     response_.getLength());
+    EXPECT_EQ(1, cache_.getEntryCount());
+    EXPECT_TRUE(getAnswer(makeKey(qname_), 2, buffer));
+    buffer.clear();
+    EXPECT_FALSE(getAnswer(makeKey(qname_), 1, buffer));
+}
+
+TEST_F(AnswerCacheTest, lengthLimit) {
+    cache_.addAnswer(makeKey(qname_), 0, 1, response_.getData(),
+                     response_.getLength());
+    OutputBuffer buffer(0);
+    EXPECT_FALSE(getAnswer(makeKey(qname_), 1, buffer,
+                           response_.getLength() - 1));
+    EXPECT_TRUE(getAnswer(makeKey(qname_), 1, buffer,
+                          response_.getLength()));
+}
+
+TEST_F(AnswerCacheTest, badQuery) {
+    cache_.addAnswer(makeKey(qname_), 0, 1, response_.getData(),
+                     response_.getLength());
+    OutputBuffer buffer(0);
+
+    // A query too short for the question is a miss.
+    EXPECT_FALSE(cache_.getAnswer(makeKey(qname_), generations_,
+                                  query_.getData(), query_.getLength() - 1,
+                                  512, buffer));
+
+    // So is a query whose question doesn't match the cached one in the
+    // wire format (as it would be if the name were compressed).
+    OutputBuffer query(0);
+    query.writeData(query_.getData(), query_.getLength());
+    query.writeUint8At('x', 13);
+    EXPECT_FALSE(cache_.getAnswer(makeKey(qname_), generations_,
+                                  query.getData(), query.getLength(), 512,
+                                  buffer));
+    EXPECT_EQ(0, buffer.getLength());
+}
+
+TEST_F(AnswerCacheTest, addAnswerTooShort) {
+    EXPECT_THROW(cache_.addAnswer(makeKey(qname_), 0, 1, response_.getData(),
+                                  12 + qname_.getLength() + 3),
+                 bundy::InvalidParameter);
+    EXPECT_EQ(0, cache_.getEntryCount());
+}
+
+TEST_F(AnswerCacheTest, recycle) {
+    const Name name1("a.example.org"), name2("b.example.org"),
+        name3("c.example.org"), name4("d.example.org");
+    addAnswer(name1);
+    addAnswer(name2);
+    addAnswer(name3);
+    EXPECT_EQ(3, cache_.getEntryCount());
+
+    // Use the answer for name1 again; now name2 is the least recently used
+    // one and will be replaced with name4.
+    EXPECT_TRUE(hasAnswer(name1));
+    addAnswer(name4);
+    EXPECT_EQ(3, cache_.getEntryCount());
+    EXPECT_FALSE(hasAnswer(name2));
+    EXPECT_TRUE(hasAnswer(name1));
+    EXPECT_TRUE(hasAnswer(name3));
+    EXPECT_TRUE(hasAnswer(name4));
+}
+
+TEST_F(AnswerCacheTest, zoneGeneration) {
+    const Name name1("a.example.org"), name2("a.example.com");
+    addAnswer(name1, 0);
+    addAnswer(name2, 1);
+    EXPECT_TRUE(hasAnswer(name1));
+    EXPECT_TRUE(hasAnswer(name2));
+
+    // A change to one zone only invalidates the answers from that zone.
+    generations_.generations_[1] = 2;
+    EXPECT_TRUE(hasAnswer(name1));
+    EXPECT_FALSE(hasAnswer(name2));
+}
+
+TEST_F(AnswerCacheTest, shards) {
+    // A large cache is split into shards; it should still behave as a
+    // single cache.
+    AnswerCache cache(20000);
+    EXPECT_EQ(20000, cache.getMaxEntries());
+    std::vector<Name> names;
+    for (int i = 0; i < 100; ++i) {
+        std::ostringstream oss;
+        oss << "n" << i << ".example.org";
+        names.push_back(Name(oss.str()));
+        OutputBuffer response(0);
+        renderResponse(response, names.back(), RRType::A());
+        cache.addAnswer(makeKey(names.back()), 0, 1, response.getData(),
+                        response.getLength());
+    }
+    EXPECT_EQ(100, cache.getEntryCount());
+    for (int i = 0; i < 100; ++i) {
+        OutputBuffer query(0);
+        renderQuery(query, names[i], 0, false);
+        OutputBuffer buffer(0);
+        EXPECT_TRUE(cache.getAnswer(makeKey(names[i]), generations_,
+                                    query.getData(), query.getLength(), 512,
+                                    buffer));
+    }
+}
+
+}
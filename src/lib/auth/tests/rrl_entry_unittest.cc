@@ -0,0 +1,166 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+#include <auth/rrl_response_type.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_address.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <netinet/in.h>
+
+using namespace bundy::auth;
+using namespace bundy::auth::detail;
+using namespace bundy::dns;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOAddress;
+
+namespace {
+
+const uint32_t MASK4 = 0xffffffff;
+const uint32_t MASK6[4] = { 0xffffffff, 0xffffffff, 0, 0 };
+
+void
+noopCallback(size_t) {}
+
+class RRLEntryTest : public ::testing::Test {
+protected:
+    RRLEntryTest() :
+        ep_(IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.1"), 53210)),
+        qname_("example.com"), qlabels_(qname_),
+        key_(*ep_, RRType::A(), &qlabels_, RRClass::IN(), RESPONSE_QUERY,
+             MASK4, MASK6, 0),
+        ts_bases_(10, noopCallback)
+    {
+        entry_.reset(key_);
+    }
+
+    boost::scoped_ptr<const IOEndpoint> ep_;
+    const Name qname_;
+    const LabelSequence qlabels_;
+    const RRLKey key_;
+    RRLTimeStamps ts_bases_;
+    RRLEntry entry_;
+};
+
+TEST_F(RRLEntryTest, reset) {
+    EXPECT_TRUE(entry_.getKey() == key_);
+    EXPECT_EQ(0, entry_.getResponseBalance());
+    EXPECT_FALSE(entry_.isLogged());
+    EXPECT_EQ(RRL_TIMESTAMP_FOREVER, entry_.getAge(ts_bases_, 10));
+
+    entry_.setLogged(true, 42);
+    EXPECT_TRUE(entry_.isLogged());
+    EXPECT_EQ(42, entry_.getLogQName());
+    entry_.setAge(ts_bases_, 10);
+
+    // reset() clears all states.
+    entry_.reset(key_);
+    EXPECT_FALSE(entry_.isLogged());
+    EXPECT_EQ(RRL_TIMESTAMP_FOREVER, entry_.getAge(ts_bases_, 10));
+}
+
+TEST_F(RRLEntryTest, age) {
+    entry_.setAge(ts_bases_, 15);
+    EXPECT_EQ(0, entry_.getAge(ts_bases_, 15));
+    EXPECT_EQ(5, entry_.getAge(ts_bases_, 20));
+    // A "near future" timestamp is considered to be now.
+    EXPECT_EQ(0, entry_.getAge(ts_bases_, 14));
+
+    // Invalidating a different generation doesn't affect it.
+    entry_.invalidateTimestamp(1);
+    EXPECT_EQ(5, entry_.getAge(ts_bases_, 20));
+    entry_.invalidateTimestamp(0);
+    EXPECT_EQ(RRL_TIMESTAMP_FOREVER, entry_.getAge(ts_bases_, 20));
+}
+
+TEST_F(RRLEntryTest, updateBalance) {
+    // rate = 2, slip = 2, window = 3.  The initial balance is the rate.
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 2, 2, 3, 20));
+    EXPECT_EQ(1, entry_.getResponseBalance());
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 2, 2, 3, 20));
+    EXPECT_EQ(0, entry_.getResponseBalance());
+
+    // Credit is used up.  The first limited response slips, and every
+    // other one after that.
+    EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 2, 2, 3, 20));
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 2, 2, 3, 20));
+    EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 2, 2, 3, 20));
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 2, 2, 3, 20));
+    EXPECT_EQ(-4, entry_.getResponseBalance());
+
+    // The negative balance is bounded by window * rate.
+    for (int i = 0; i < 10; ++i) {
+        entry_.updateBalance(ts_bases_, 2, 2, 3, 20);
+    }
+    EXPECT_EQ(-6, entry_.getResponseBalance());
+
+    // One second later the balance is credited with the rate, which isn't
+    // still sufficient.
+    EXPECT_NE(RRL_OK, entry_.updateBalance(ts_bases_, 2, 2, 3, 21));
+    EXPECT_EQ(-5, entry_.getResponseBalance());
+
+    // 3 seconds later: -5 + 2 * 3 = 1 before the debit.
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 2, 2, 3, 24));
+    EXPECT_EQ(0, entry_.getResponseBalance());
+
+    // The credit is bounded by the rate.
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 2, 2, 3, 27));
+    EXPECT_EQ(1, entry_.getResponseBalance());
+
+    // After a period longer than the window, it starts over.
+    entry_.updateBalance(ts_bases_, 2, 2, 3, 27);
+    entry_.updateBalance(ts_bases_, 2, 2, 3, 27);
+    EXPECT_EQ(-1, entry_.getResponseBalance());
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 2, 2, 3, 31));
+    EXPECT_EQ(1, entry_.getResponseBalance());
+}
+
+TEST_F(RRLEntryTest, slip) {
+    // If slip is 0, limited responses are always dropped.
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 1, 0, 15, 20));
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 0, 15, 20));
+    }
+
+    // If slip is 1, they always slip.
+    entry_.reset(key_);
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 1, 1, 15, 20));
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 1, 15, 20));
+    }
+
+    // Otherwise, one out of every slip responses slips.
+    entry_.reset(key_);
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 1, 3, 15, 20));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 3, 15, 20));
+        EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 3, 15, 20));
+        EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 3, 15, 20));
+    }
+}
+
+}
@@ -0,0 +1,142 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <auth/rrl_table.h>
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+#include <auth/rrl_response_type.h>
+
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_address.h>
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include <netinet/in.h>
+
+using namespace bundy::auth::detail;
+using namespace bundy::dns;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOAddress;
+
+namespace {
+
+const uint32_t MASK4 = 0xffffffff;
+const uint32_t MASK6[4] = { 0xffffffff, 0xffffffff, 0, 0 };
+
+class RRLTableTest : public ::testing::Test {
+protected:
+    RRLTableTest() :
+        table_(3, boost::bind(&RRLTableTest::recycled, this, _1))
+    {}
+
+    // Return a key for a client address of 192.0.2.<id>
+    RRLKey makeKey(int id) {
+        std::stringstream ss;
+        ss << "192.0.2." << id;
+        boost::scoped_ptr<const IOEndpoint> ep(
+            IOEndpoint::create(IPPROTO_UDP, IOAddress(ss.str()), 53210));
+        return (RRLKey(*ep, RRType::A(), NULL, RRClass::IN(), RESPONSE_QUERY,
+                       MASK4, MASK6, 0));
+    }
+
+    void recycled(RRLEntry& entry) {
+        recycled_.push_back(&entry);
+    }
+
+    RRLTable table_;
+    std::vector<RRLEntry*> recycled_;
+};
+
+TEST_F(RRLTableTest, construct) {
+    EXPECT_EQ(0, table_.getEntryCount());
+    EXPECT_EQ(3, table_.getMaxEntries());
+    EXPECT_THROW(RRLTable(0, RRLTable::RecycleCallback()),
+                 bundy::InvalidParameter);
+}
+
+TEST_F(RRLTableTest, getEntry) {
+    RRLEntry& entry1 = table_.getEntry(makeKey(1));
+    EXPECT_TRUE(entry1.getKey() == makeKey(1));
+    EXPECT_EQ(1, table_.getEntryCount());
+
+    // The same entry will be returned for the same key.
+    EXPECT_EQ(&entry1, &table_.getEntry(makeKey(1)));
+    EXPECT_EQ(1, table_.getEntryCount());
+
+    // Different keys have different entries.
+    RRLEntry& entry2 = table_.getEntry(makeKey(2));
+    RRLEntry& entry3 = table_.getEntry(makeKey(3));
+    EXPECT_NE(&entry1, &entry2);
+    EXPECT_NE(&entry2, &entry3);
+    EXPECT_EQ(3, table_.getEntryCount());
+    EXPECT_TRUE(recycled_.empty());
+}
+
+TEST_F(RRLTableTest, recycle) {
+    RRLEntry& entry1 = table_.getEntry(makeKey(1));
+    RRLEntry& entry2 = table_.getEntry(makeKey(2));
+    table_.getEntry(makeKey(3));
+    // Use entry 1 again; now entry 2 is the least recently used one.
+    table_.getEntry(makeKey(1));
+
+    // The table is full, so the entry for key 2 is recycled.
+    RRLEntry& entry4 = table_.getEntry(makeKey(4));
+    EXPECT_EQ(3, table_.getEntryCount());
+    ASSERT_EQ(1, recycled_.size());
+    EXPECT_EQ(&entry2, recycled_[0]);
+    EXPECT_EQ(&entry2, &entry4);
+    EXPECT_TRUE(entry4.getKey() == makeKey(4));
+
+    // Entries for the other keys are still there.
+    EXPECT_EQ(&entry1, &table_.getEntry(makeKey(1)));
+    EXPECT_EQ(1, recycled_.size());
+
+    // Key 2 needs to be recycled from another entry (which is for key 3).
+    table_.getEntry(makeKey(2));
+    ASSERT_EQ(2, recycled_.size());
+    EXPECT_TRUE(recycled_[1]->getKey() == makeKey(2));
+}
+
+TEST_F(RRLTableTest, invalidateTimestamps) {
+    RRLTimeStamps ts_bases(10, boost::bind(&RRLTable::invalidateTimestamps,
+                                           &table_, _1));
+    RRLEntry& entry1 = table_.getEntry(makeKey(1));
+    entry1.setAge(ts_bases, 10);
+    EXPECT_EQ(0, entry1.getAge(ts_bases, 10));
+
+    // A base change with different generation doesn't affect the entry.
+    table_.invalidateTimestamps(1);
+    EXPECT_EQ(0, entry1.getAge(ts_bases, 10));
+
+    // Once all bases are used and the first one is about to be reused, the
+    // timestamp of the entry is invalidated.
+    for (size_t i = 1; i <= RRL_TIMESTAMP_BASES_COUNT; ++i) {
+        ts_bases.getCurrentBase(10 + i * RRL_TIMESTAMP_FOREVER);
+    }
+    EXPECT_EQ(RRL_TIMESTAMP_FOREVER, entry1.getAge(ts_bases, 10));
+}
+
+}
@@ -0,0 +1,226 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <auth/rrl.h>
+#include <auth/rrl_response_type.h>
+#include <auth/rrl_result.h>
+
+#include <dns/name.h>
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_address.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/threads/thread.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <ctime>
+#include <sstream>
+#include <string>
+
+#include <netinet/in.h>
+
+using namespace bundy::auth;
+using namespace bundy::auth::detail;
+using namespace bundy::dns;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOAddress;
+using bundy::util::thread::Thread;
+
+namespace {
+
+const std::time_t NOW = 1000;
+
+class ResponseLimiterTest : public ::testing::Test {
+protected:
+    ResponseLimiterTest() :
+        ep4_(IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.1"), 53210)),
+        ep6_(IOEndpoint::create(IPPROTO_UDP, IOAddress("2001:db8::1"), 53210)),
+        qname_("www.example.com"),
+        // responses: 2/s, nxdomains: 1/s, errors: 1/s, window: 15,
+        // slip: 2, max 100 entries, /24 and /56 prefixes
+        rrl_(new ResponseLimiter(2, 1, 1, 15, 2, 100, 24, 56, false, NOW,
+                                 0))
+    {}
+
+    RRLResult check(const IOEndpoint& ep, ResponseType resp_type,
+                    const Name* qname, std::time_t now = NOW,
+                    bool is_tcp = false)
+    {
+        return (rrl_->check(ep, is_tcp, RRClass::IN(), RRType::A(), qname,
+                            resp_type, now));
+    }
+
+    boost::scoped_ptr<const IOEndpoint> ep4_;
+    boost::scoped_ptr<const IOEndpoint> ep6_;
+    const Name qname_;
+    boost::scoped_ptr<ResponseLimiter> rrl_;
+};
+
+TEST_F(ResponseLimiterTest, construct) {
+    EXPECT_EQ(2, rrl_->getResponseRate());
+    EXPECT_EQ(1, rrl_->getNXDOMAINRate());
+    EXPECT_EQ(1, rrl_->getErrorRate());
+    EXPECT_EQ(15, rrl_->getWindow());
+    EXPECT_EQ(2, rrl_->getSlip());
+    EXPECT_FALSE(rrl_->isLogOnly());
+    EXPECT_EQ(0, rrl_->getEntryCount());
+
+    // Out-of-range parameters
+    EXPECT_THROW(ResponseLimiter(-1, 1, 1, 15, 2, 100, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, -1, 1, 15, 2, 100, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, -1, 15, 2, 100, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 0, 2, 100, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 3601, 2, 100, 24, 56, false, NOW,
+                                 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 15, -1, 100, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 15, 11, 100, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 15, 2, 0, 24, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 15, 2, 100, 33, 56, false, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseLimiter(1, 1, 1, 15, 2, 100, 24, 129, false, NOW, 0),
+                 bundy::InvalidParameter);
+}
+
+TEST_F(ResponseLimiterTest, limitResponses) {
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(RRL_SLIP, check(*ep4_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(RRL_DROP, check(*ep4_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(1, rrl_->getEntryCount());
+
+    // Another client in the same network shares the entry.
+    boost::scoped_ptr<const IOEndpoint> ep(
+        IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.2"), 53));
+    EXPECT_EQ(RRL_SLIP, check(*ep, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(1, rrl_->getEntryCount());
+
+    // A different network, name or response type is accounted separately.
+    ep.reset(IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.3.1"), 53));
+    EXPECT_EQ(RRL_OK, check(*ep, RESPONSE_QUERY, &qname_));
+    const Name other_name("example.com");
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &other_name));
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_NXDOMAIN, &qname_));
+    EXPECT_EQ(RRL_OK, check(*ep6_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(5, rrl_->getEntryCount());
+
+    // Responses over TCP are never limited.
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_, NOW, true));
+
+    // The credit recovers after a while.
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_, NOW + 20));
+}
+
+TEST_F(ResponseLimiterTest, perTypeRates) {
+    // NXDOMAIN has its own rate (1/s here).
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_NXDOMAIN, &qname_));
+    EXPECT_EQ(RRL_SLIP, check(*ep4_, RESPONSE_NXDOMAIN, &qname_));
+
+    // Error responses are limited regardless of the name.
+    const Name other_name("example.com");
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_ERROR, &qname_));
+    EXPECT_EQ(RRL_SLIP, check(*ep4_, RESPONSE_ERROR, &other_name));
+    EXPECT_EQ(RRL_DROP, check(*ep4_, RESPONSE_ERROR, NULL));
+
+    // A rate of 0 means no limit.
+    rrl_.reset(new ResponseLimiter(0, 1, 1, 15, 2, 100, 24, 56, false, NOW,
+                                   0));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_));
+    }
+    EXPECT_EQ(0, rrl_->getEntryCount());
+}
+
+TEST_F(ResponseLimiterTest, logOnly) {
+    rrl_.reset(new ResponseLimiter(1, 1, 1, 15, 2, 100, 24, 56, true, NOW,
+                                   0));
+    EXPECT_TRUE(rrl_->isLogOnly());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_));
+    }
+    EXPECT_EQ(1, rrl_->getEntryCount());
+}
+
+TEST_F(ResponseLimiterTest, tableFull) {
+    rrl_.reset(new ResponseLimiter(1, 1, 1, 15, 0, 2, 32, 56, false, NOW, 0));
+    boost::scoped_ptr<const IOEndpoint> ep2(
+        IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.2"), 53));
+    boost::scoped_ptr<const IOEndpoint> ep3(
+        IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.3"), 53));
+
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(RRL_DROP, check(*ep4_, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(RRL_OK, check(*ep2, RESPONSE_QUERY, &qname_));
+    // This will purge the entry for ep4_, so ep4_ will start over.
+    EXPECT_EQ(RRL_OK, check(*ep3, RESPONSE_QUERY, &qname_));
+    EXPECT_EQ(2, rrl_->getEntryCount());
+    EXPECT_EQ(RRL_OK, check(*ep4_, RESPONSE_QUERY, &qname_));
+}
+
+// Each client of the given /16 network gets its first response and then
+// is dropped.
+void
+checkClients(ResponseLimiter* rrl, const std::string& prefix, int n_clients,
+             int* n_unexpected)
+{
+    const Name qname("www.example.com");
+    for (int i = 0; i < n_clients; ++i) {
+        std::ostringstream addr;
+        addr << prefix << "." << (i / 256) << "." << (i % 256);
+        boost::scoped_ptr<const IOEndpoint> ep(
+            IOEndpoint::create(IPPROTO_UDP, IOAddress(addr.str()), 53));
+        if (rrl->check(*ep, false, RRClass::IN(), RRType::A(), &qname,
+                       RESPONSE_QUERY, NOW) != RRL_OK ||
+            rrl->check(*ep, false, RRClass::IN(), RRType::A(), &qname,
+                       RESPONSE_QUERY, NOW) != RRL_DROP) {
+            ++*n_unexpected;
+        }
+    }
+}
+
+TEST_F(ResponseLimiterTest, concurrentChecks) {
+    // A table this large is split into shards, which can be used by
+    // multiple threads at once.
+    rrl_.reset(new ResponseLimiter(1, 1, 1, 15, 0, 20000, 32, 56, false, NOW,
+                                   0));
+    int n_unexpected1 = 0;
+    int n_unexpected2 = 0;
+    Thread thread1(boost::bind(checkClients, rrl_.get(), "192.0", 4000,
+                               &n_unexpected1));
+    Thread thread2(boost::bind(checkClients, rrl_.get(), "198.51", 4000,
+                               &n_unexpected2));
+    thread1.wait();
+    thread2.wait();
+    EXPECT_EQ(0, n_unexpected1);
+    EXPECT_EQ(0, n_unexpected2);
+    EXPECT_EQ(8000, rrl_->getEntryCount());
+}
+
+}
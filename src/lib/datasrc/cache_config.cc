@@ -54,6 +54,25 @@ getSegmentTypeFromConf(const Element& conf) {
     }
     return (conf.get("cache-type")->stringValue());
 }
+
+bool
+getNameIndexFromConf(const Element& conf) {
+    return (conf.contains("cache-name-index") &&
+            conf.get("cache-name-index")->boolValue());
+}
+
+size_t
+getThreadsFromConf(const Element& conf, const std::string& item) {
+    if (!conf.contains(item)) {
+        return (1);
+    }
+    const int64_t threads = conf.get(item)->intValue();
+    if (threads < 1) {
+        bundy_throw(CacheConfigError, item << " must be positive: "
+                    << threads);
+    }
+    return (threads);
+}
 }
 
 CacheConfig::CacheConfig(const std::string& datasrc_type,
@@ -62,6 +81,9 @@ CacheConfig::CacheConfig(const std::string& datasrc_type,
                          bool allowed) :
     enabled_(allowed && getEnabledFromConf(datasrc_conf)),
     segment_type_(getSegmentTypeFromConf(datasrc_conf)),
+    name_index_(getNameIndexFromConf(datasrc_conf)),
+    load_threads_(getThreadsFromConf(datasrc_conf, "cache-load-threads")),
+    parse_threads_(getThreadsFromConf(datasrc_conf, "cache-parse-threads")),
     datasrc_client_(datasrc_client)
 {
     ConstElementPtr params = datasrc_conf.get("params");
@@ -127,10 +149,11 @@ namespace {
 memory::ZoneDataLoader*
 createLoaderFromFile(util::MemorySegment& segment, const dns::RRClass& rrclass,
                      const dns::Name& name, const std::string& filename,
+                     bool name_index, size_t parse_threads,
                      memory::ZoneData* old_data)
 {
     return (new memory::ZoneDataLoader(segment, rrclass, name, filename,
-                                       old_data));
+                                       old_data, name_index, parse_threads));
 }
 
 memory::ZoneDataLoader*
@@ -138,10 +161,11 @@ createLoaderFromDataSource(util::MemorySegment& segment,
                            const dns::RRClass& rrclass,
                            const dns::Name& name,
                            const DataSourceClient* datasrc_client,
-                           memory::ZoneData* old_data)
+                           bool name_index, memory::ZoneData* old_data)
 {
     return (new memory::ZoneDataLoader(segment, rrclass, name,
-                                       *datasrc_client, old_data));
+                                       *datasrc_client, old_data,
+                                       name_index));
 }
 
 } // unnamed namespace
@@ -159,7 +183,8 @@ CacheConfig::getLoaderCreator(const dns::RRClass& rrclass,
     if (!found->second.empty()) {
         // This is "MasterFiles" data source.
         return (boost::bind(createLoaderFromFile, _1, rrclass, zone_name,
-                            found->second, _2));
+                            found->second, name_index_, parse_threads_,
+                            _2));
     }
 
     // Otherwise there must be a "source" data source (ensured by constructor)
@@ -175,7 +200,7 @@ CacheConfig::getLoaderCreator(const dns::RRClass& rrclass,
     // Wrap the iterator into the correct functor (which keeps it alive as
     // long as it is needed).
     return (boost::bind(createLoaderFromDataSource, _1, rrclass, zone_name,
-                        datasrc_client_, _2));
+                        datasrc_client_, name_index_, _2));
 }
 
 } // namespace internal
@@ -108,6 +108,15 @@ public:
     /// This constructor also identifies the underlying memory segment type
     /// used for the cache.  It's given via the "cache-type" configuration
     /// item if defined; otherwise it defaults to "local".
+    /// Likewise, the "cache-name-index" item specifies whether to build
+    /// the hash index of names for each cached zone (see
+    /// \c memory::ZoneData::enableNameIndex()); it defaults to false.
+    /// The "cache-load-threads" item specifies how many threads load the
+    /// zones into the cache at once on configuration, and the
+    /// "cache-parse-threads" item how many threads parse each master file
+    /// of a "MasterFiles" data source (see
+    /// \c dns::MasterLoader::setThreadCount()).  Both default to 1, and
+    /// must be positive (otherwise CacheConfigError is thrown).
     ///
     /// \throw InvalidParameter Program error at the caller side rather than
     /// in the configuration (see above)
@@ -147,6 +156,21 @@ public:
     /// \throw None
     const std::string& getSegmentType() const { return (segment_type_); }
 
+    /// \brief Return if the name index is built for the cached zones.
+    ///
+    /// \throw None
+    bool isNameIndexEnabled() const { return (name_index_); }
+
+    /// \brief Return the number of threads to load the zones with.
+    ///
+    /// \throw None
+    size_t getLoadThreads() const { return (load_threads_); }
+
+    /// \brief Return the number of threads to parse a master file with.
+    ///
+    /// \throw None
+    size_t getParseThreads() const { return (parse_threads_); }
+
     /// \brief Return a \c LoadAction functor to load zone data into memory.
     ///
     /// This method returns an appropriate \c LoadAction functor that can be
@@ -232,6 +256,9 @@ public:
 private:
     const bool enabled_; // if the use of in-memory zone table is enabled
     const std::string segment_type_;
+    const bool name_index_; // if the zone data have the name index
+    const size_t load_threads_; // number of threads for the initial load
+    const size_t parse_threads_; // number of threads to parse a master file
     // client of underlying data source, will be NULL for MasterFile datasrc
     const DataSourceClient* datasrc_client_;
 
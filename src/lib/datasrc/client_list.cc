@@ -23,15 +23,24 @@
 #include <datasrc/memory/zone_writer.h>
 #include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/zone_table.h>
+#include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/logger.h>
 #include <datasrc/zone_table_accessor_cache.h>
 #include <dns/masterload.h>
 #include <util/memory_segment_local.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
+#include <iterator>
+#include <map>
 #include <memory>
 #include <set>
+#include <utility>
+#include <vector>
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
 using namespace bundy::data;
@@ -44,10 +53,206 @@ using boost::dynamic_pointer_cast;
 using bundy::datasrc::memory::InMemoryClient;
 using bundy::datasrc::memory::ZoneTableSegment;
 using bundy::datasrc::memory::ZoneDataUpdater;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
 
 namespace bundy {
 namespace datasrc {
 
+namespace {
+
+// The progress of the initial load of the zones of a data source is logged
+// every this many zones.
+const size_t LOAD_PROGRESS_INTERVAL = 1000;
+
+void
+logLoadProgress(size_t loaded, size_t total, const string& datasrc_name,
+                const RRClass& rrclass)
+{
+    if (loaded % LOAD_PROGRESS_INTERVAL == 0 || loaded == total) {
+        LOG_INFO(logger, DATASRC_LIST_LOAD_PROGRESS).arg(loaded).arg(total).
+            arg(datasrc_name).arg(rrclass);
+    }
+}
+
+// A view of a local memory segment for one of the threads that load zones
+// into it in parallel.  Memory is allocated from the shared segment under
+// a mutex.  Named addresses, which the loader uses to keep objects under
+// construction, are kept in this object, so each thread has its own set.
+// This is only possible because a local segment never relocates.
+class LoaderMemorySegment : public MemorySegment {
+public:
+    LoaderMemorySegment(MemorySegment& segment, Mutex& mutex) :
+        segment_(segment), mutex_(mutex)
+    {}
+    virtual void* allocate(size_t size) {
+        Mutex::Locker locker(mutex_);
+        return (segment_.allocate(size));
+    }
+    virtual void deallocate(void* ptr, size_t size) {
+        Mutex::Locker locker(mutex_);
+        segment_.deallocate(ptr, size);
+    }
+    virtual bool allMemoryDeallocated() const {
+        return (named_addrs_.empty());
+    }
+
+protected:
+    virtual NamedAddressResult getNamedAddressImpl(const char* name) const {
+        const map<string, void*>::const_iterator found =
+            named_addrs_.find(name);
+        if (found != named_addrs_.end()) {
+            return (NamedAddressResult(true, found->second));
+        }
+        return (NamedAddressResult(false, NULL));
+    }
+    virtual bool setNamedAddressImpl(const char* name, void* addr) {
+        named_addrs_[name] = addr;
+        return (false);
+    }
+    virtual bool clearNamedAddressImpl(const char* name) {
+        return (named_addrs_.erase(name) != 0);
+    }
+
+private:
+    MemorySegment& segment_;
+    Mutex& mutex_;
+    map<string, void*> named_addrs_;
+};
+
+// Loads zones into the local zone table segment of a data source with
+// several threads.  Each thread repeatedly takes the next zone, loads it
+// and installs it into the zone table, just like the sequential load with
+// ZoneWriter does.  The zone table isn't visible to anyone else yet; the
+// installation is serialized by the mutex for allocations.
+class ParallelZoneLoader : boost::noncopyable {
+public:
+    typedef pair<Name, memory::ZoneDataLoaderCreator> ZoneSpec;
+
+    ParallelZoneLoader(ZoneTableSegment& ztable_segment,
+                       const RRClass& rrclass, const string& datasrc_name,
+                       const vector<ZoneSpec>& zones) :
+        ztable_segment_(ztable_segment), rrclass_(rrclass),
+        datasrc_name_(datasrc_name), zones_(zones), next_(0), loaded_(0),
+        stop_(false)
+    {}
+
+    // Load all the zones with the given number of threads and wait for
+    // completion.  If loading a zone fails with anything other than
+    // a zone load error (which results in an empty zone, as in the
+    // sequential load), the other threads stop and DataSourceError is
+    // thrown.
+    void load(size_t n_threads) {
+        vector<boost::shared_ptr<Thread> > threads;
+        try {
+            for (size_t i = 0; i < n_threads && i < zones_.size(); ++i) {
+                threads.push_back(boost::shared_ptr<Thread>(
+                    new Thread(boost::bind(&ParallelZoneLoader::run,
+                                           this))));
+            }
+        } catch (...) {
+            {
+                Mutex::Locker locker(mutex_);
+                stop_ = true;
+            }
+            waitAll(threads);
+            throw;
+        }
+        waitAll(threads);
+        if (!error_.empty()) {
+            bundy_throw(DataSourceError, error_);
+        }
+    }
+
+private:
+    static void waitAll(vector<boost::shared_ptr<Thread> >& threads) {
+        BOOST_FOREACH(boost::shared_ptr<Thread>& thread, threads) {
+            thread->wait();     // run() doesn't throw
+        }
+    }
+
+    void run() {
+        LoaderMemorySegment segment(ztable_segment_.getMemorySegment(),
+                                    segment_mutex_);
+        try {
+            while (true) {
+                size_t i;
+                {
+                    Mutex::Locker locker(mutex_);
+                    if (stop_ || next_ == zones_.size()) {
+                        return;
+                    }
+                    i = next_++;
+                }
+                loadZone(segment, zones_[i]);
+                Mutex::Locker locker(mutex_);
+                logLoadProgress(++loaded_, zones_.size(), datasrc_name_,
+                                rrclass_);
+            }
+        } catch (const std::exception& ex) {
+            setError(ex.what());
+        } catch (...) {
+            setError("unknown error");
+        }
+    }
+
+    void setError(const string& error) {
+        Mutex::Locker locker(mutex_);
+        stop_ = true;
+        if (error_.empty()) {
+            error_ = "failed to load zones into the cache of data source '" +
+                datasrc_name_ + "': " + error;
+        }
+    }
+
+    void loadZone(MemorySegment& segment, const ZoneSpec& zone) {
+        typedef memory::detail::SegmentObjectHolder<memory::ZoneData, RRClass>
+            ZoneDataHolder;
+        ZoneDataHolder holder(segment, rrclass_);
+        try {
+            boost::scoped_ptr<memory::ZoneDataLoader> loader(
+                zone.second(segment, NULL));
+            // There are no old data, so there's nothing to commit (the
+            // ZoneWriter would call commit(), which is a no-op in this case).
+            holder.set(loader->load());
+        } catch (const ZoneLoaderException& ex) {
+            LOG_ERROR(logger, DATASRC_LOAD_ZONE_ERROR).arg(zone.first).
+                arg(rrclass_).arg(datasrc_name_).arg(ex.what());
+        }
+
+        memory::ZoneData* old_data;
+        {
+            Mutex::Locker locker(segment_mutex_);
+            MemorySegment& mem_sgmt = ztable_segment_.getMemorySegment();
+            memory::ZoneTable* const table =
+                ztable_segment_.getHeader().getTable();
+            const memory::ZoneTable::AddResult result(
+                holder.get() ?
+                table->addZone(mem_sgmt, zone.first, holder.get()) :
+                table->addEmptyZone(mem_sgmt, zone.first));
+            holder.release();
+            old_data = result.zone_data;
+        }
+        if (old_data) {
+            // Only if the same zone is listed twice.
+            memory::ZoneData::destroy(segment, old_data, rrclass_);
+        }
+    }
+
+    ZoneTableSegment& ztable_segment_;
+    const RRClass rrclass_;
+    const string datasrc_name_;
+    const vector<ZoneSpec>& zones_;
+    Mutex segment_mutex_;       // for allocations and the zone table
+    Mutex mutex_;               // for the rest below
+    size_t next_;
+    size_t loaded_;
+    bool stop_;
+    string error_;
+};
+
+} // unnamed namespace
+
 ConfigurableClientList::DataSourceInfo::DataSourceInfo(
     DataSourceClient* data_src_client,
     const DataSourceClientContainerPtr& container,
@@ -156,6 +361,37 @@ ConfigurableClientList::configure(const ConstElementPtr& config,
                 continue;
             }
 
+            const size_t zone_count =
+                std::distance(cache_conf->begin(), cache_conf->end());
+            const size_t n_threads = cache_conf->getLoadThreads();
+            if (n_threads > 1 && cache_conf->getSegmentType() == "local") {
+                // Allocations from other types of segments can relocate
+                // the segment, so they can't be shared among threads.
+                vector<ParallelZoneLoader::ZoneSpec> zones;
+                for (internal::CacheConfig::ConstZoneIterator zone_it =
+                         cache_conf->begin();
+                     zone_it != cache_conf->end();
+                     ++zone_it)
+                {
+                    const Name& zname = zone_it->first;
+                    try {
+                        zones.push_back(ParallelZoneLoader::ZoneSpec(
+                            zname,
+                            cache_conf->getLoaderCreator(rrclass_, zname)));
+                    } catch (const NoSuchZone&) {
+                        LOG_ERROR(logger, DATASRC_CACHE_ZONE_NOTFOUND).
+                            arg(zname).arg(rrclass_).arg(datasrc_name);
+                    }
+                }
+                LOG_INFO(logger, DATASRC_LIST_LOAD_PARALLEL).
+                    arg(zones.size()).arg(datasrc_name).arg(rrclass_).
+                    arg(n_threads);
+                ParallelZoneLoader(zt_segment, rrclass_, datasrc_name,
+                                   zones).load(n_threads);
+                continue;
+            }
+
+            size_t loaded = 0;
             internal::CacheConfig::ConstZoneIterator end_of_zones =
                 cache_conf->end();
             for (internal::CacheConfig::ConstZoneIterator zone_it =
@@ -186,6 +422,7 @@ ConfigurableClientList::configure(const ConstElementPtr& config,
                     LOG_ERROR(logger, DATASRC_CACHE_ZONE_NOTFOUND).
                         arg(zname).arg(rrclass_).arg(datasrc_name);
                 }
+                logLoadProgress(++loaded, zone_count, datasrc_name, rrclass_);
             }
         }
         // If everything is OK up until now, we have the new configuration
@@ -428,6 +665,59 @@ ConfigurableClientList::getStatus() const {
     return (result);
 }
 
+bool
+ConfigurableClientList::isCacheOnly() const {
+    BOOST_FOREACH(const DataSourceInfo& info, data_sources_) {
+        if (!info.cache_) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+vector<ZoneMemoryUsage>
+ConfigurableClientList::getZoneMemoryUsage() const {
+    return (getZoneMemoryUsageInternal(NULL));
+}
+
+vector<ZoneMemoryUsage>
+ConfigurableClientList::getZoneMemoryUsage(const Name& zone_name) const {
+    return (getZoneMemoryUsageInternal(&zone_name));
+}
+
+vector<ZoneMemoryUsage>
+ConfigurableClientList::getZoneMemoryUsageInternal(
+    const Name* zone_name) const
+{
+    vector<ZoneMemoryUsage> usages;
+    BOOST_FOREACH(const DataSourceInfo& info, data_sources_) {
+        if (!info.ztable_segment_ || !info.ztable_segment_->isUsable()) {
+            continue;
+        }
+        const memory::ZoneTable* table =
+            info.ztable_segment_->getHeader().getTable();
+        const internal::CacheConfig* config = info.getCacheConfig();
+        for (internal::CacheConfig::ConstZoneIterator it = config->begin();
+             it != config->end();
+             ++it)
+        {
+            if (zone_name && it->first != *zone_name) {
+                continue;
+            }
+            const memory::ZoneTable::FindResult found =
+                table->findZone(it->first);
+            if (found.code != result::SUCCESS || found.zone_data == NULL ||
+                found.zone_data->isEmpty()) {
+                continue;
+            }
+            usages.push_back(ZoneMemoryUsage(
+                                 info.name_, it->first,
+                                 found.zone_data->getMemoryUsage(rrclass_)));
+        }
+    }
+    return (usages);
+}
+
 ConstZoneTableAccessorPtr
 ConfigurableClientList::getZoneTableAccessor(const std::string& datasrc_name,
                                              bool use_cache) const
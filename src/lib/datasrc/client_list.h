@@ -22,6 +22,7 @@
 #include <cc/data.h>
 #include <exceptions/exceptions.h>
 #include <datasrc/memory/zone_table_segment.h>
+#include <datasrc/memory/zone_data.h>
 #include <datasrc/zone_table_accessor.h>
 
 #include <vector>
@@ -134,6 +135,21 @@ private:
     MemorySegmentState state_;
 };
 
+/// \brief Memory usage of a zone in the in-memory cache of a data source.
+///
+/// This is the result of \c ConfigurableClientList::getZoneMemoryUsage().
+struct ZoneMemoryUsage {
+    ZoneMemoryUsage(const std::string& datasrc_name_param,
+                    const dns::Name& zone_name_param,
+                    const memory::ZoneDataMemoryUsage& usage_param) :
+        datasrc_name(datasrc_name_param), zone_name(zone_name_param),
+        usage(usage_param)
+    {}
+    std::string datasrc_name;
+    dns::Name zone_name;
+    memory::ZoneDataMemoryUsage usage;
+};
+
 /// \brief The list of data source clients.
 ///
 /// The purpose of this class is to hold several data source clients and search
@@ -531,6 +547,42 @@ public:
     /// it is exception free.
     std::vector<DataSourceStatus> getStatus() const;
 
+    /// \brief Return whether all lookups are answered from in-memory caches.
+    ///
+    /// This is true if every data source in the list has its in-memory
+    /// cache enabled, in which case \c find() never uses the data source
+    /// clients themselves.  The in-memory data can be searched by multiple
+    /// threads at the same time, while other data source clients generally
+    /// must not be used by more than one thread at a time.
+    ///
+    /// \throw None
+    bool isCacheOnly() const;
+
+    /// \brief Get memory usage of all zones in the in-memory caches.
+    ///
+    /// This returns a \c ZoneMemoryUsage for each zone that is loaded in
+    /// the cache of a data source in this list.  Data sources whose cache
+    /// is disabled or not usable yet (e.g., a mapped segment waiting to be
+    /// reset) are skipped, as well as zones that failed to load.
+    ///
+    /// This method walks through all cached zones, so it can take time
+    /// for large zones.  It shouldn't be called in a performance sensitive
+    /// path.
+    ///
+    /// This may throw standard exceptions, such as std::bad_alloc. Otherwise,
+    /// it is exception free.
+    std::vector<ZoneMemoryUsage> getZoneMemoryUsage() const;
+
+    /// \brief Get memory usage of a single zone in the in-memory caches.
+    ///
+    /// This is the same as the version without arguments, but only the
+    /// given zone is examined (in each data source that caches it), so
+    /// the time it takes is proportional to the size of that zone only.
+    ///
+    /// \param zone_name The name of the zone.
+    std::vector<ZoneMemoryUsage>
+    getZoneMemoryUsage(const dns::Name& zone_name) const;
+
     /// \brief Access to the data source clients.
     ///
     /// It can be used to examine the loaded list of data sources clients
@@ -569,6 +621,13 @@ private:
     /// to reuse it.
     void findInternal(MutableResult& result, const dns::Name& name,
                       bool want_exact_match, bool want_finder) const;
+
+    /// \brief Internal implementation of getZoneMemoryUsage().
+    ///
+    /// If zone_name is NULL, all cached zones are examined; otherwise only
+    /// the given zone.
+    std::vector<ZoneMemoryUsage>
+    getZoneMemoryUsageInternal(const dns::Name* zone_name) const;
     const bundy::dns::RRClass rrclass_;
 
     /// \brief Currently active configuration.
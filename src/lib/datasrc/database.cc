@@ -17,6 +17,7 @@
 #include <vector>
 
 #include <datasrc/database.h>
+#include <datasrc/database_cache.h>
 #include <datasrc/exceptions.h>
 #include <datasrc/zone_iterator.h>
 #include <datasrc/rrset_collection_base.h>
@@ -31,12 +32,17 @@
 #include <dns/rdataclass.h>
 #include <dns/nsec3hash.h>
 
+#include <util/buffer.h>
+
 #include <datasrc/exceptions.h>
 #include <datasrc/logger.h>
 
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <algorithm>
+#include <ctime>
+
 using namespace bundy::dns;
 using namespace std;
 using namespace bundy::dns::rdata;
@@ -93,6 +99,15 @@ DatabaseClient::DatabaseClient(const std::string& datasrc_name, RRClass rrclass,
     }
 }
 
+void
+DatabaseClient::enableFindCache(size_t max_entries, uint32_t check_interval) {
+    if (max_entries == 0) {
+        find_cache_.reset();
+    } else {
+        find_cache_.reset(new DatabaseFindCache(max_entries, check_interval));
+    }
+}
+
 DataSourceClient::FindResult
 DatabaseClient::findZone(const Name& name) const {
     std::pair<bool, int> zone(accessor_->getZone(name.toText()));
@@ -100,7 +115,8 @@ DatabaseClient::findZone(const Name& name) const {
     if (zone.first) {
         return (FindResult(result::SUCCESS,
                            ZoneFinderPtr(new Finder(accessor_,
-                                                    zone.second, name)),
+                                                    zone.second, name,
+                                                    find_cache_)),
                            name.getLabelCount()));
     }
     // Then super domains
@@ -112,7 +128,8 @@ DatabaseClient::findZone(const Name& name) const {
             return (FindResult(result::PARTIALMATCH,
                                ZoneFinderPtr(new Finder(accessor_,
                                                         zone.second,
-                                                        superdomain)),
+                                                        superdomain,
+                                                        find_cache_)),
 
                                superdomain.getLabelCount()));
         }
@@ -142,27 +159,61 @@ DatabaseClient::deleteZone(const Name& zone_name) {
     }
     accessor_->deleteZone(zinfo.second);
     transaction.commit();
+    if (find_cache_) {
+        find_cache_->invalidateZone(zinfo.second);
+    }
     return (true);
 }
 
 DatabaseClient::Finder::Finder(boost::shared_ptr<DatabaseAccessor> accessor,
-                               int zone_id, const bundy::dns::Name& origin) :
+                               int zone_id, const bundy::dns::Name& origin,
+                               boost::shared_ptr<DatabaseFindCache> cache) :
     accessor_(accessor),
     zone_id_(zone_id),
-    origin_(origin)
+    origin_(origin),
+    cache_(cache)
 { }
 
 namespace {
+// Creates the Rdata of the record the given context currently points to.
+// If the accessor provides the RDATA in wire format, the Rdata is built
+// directly from it; otherwise the text in rdata_str is parsed.
+//
+// Raises a DataSourceError if the wire data is broken; errors in the text
+// are propagated as they are.
+bundy::dns::rdata::RdataPtr
+createRecordRdata(const bundy::dns::RRType& type,
+                  const bundy::dns::RRClass& cls,
+                  const DatabaseAccessor::IteratorContext& context,
+                  const std::string& rdata_str)
+{
+    const uint8_t* wire_data;
+    size_t wire_len;
+    if (context.getRdataWire(wire_data, wire_len)) {
+        try {
+            bundy::util::InputBuffer buffer(wire_data, wire_len);
+            return (bundy::dns::rdata::createRdata(type, cls, buffer,
+                                                   wire_len));
+        } catch (const bundy::Exception& ex) {
+            bundy_throw(DataSourceError,
+                        "bad wire-format rdata in database for " << type
+                        << ": " << ex.what());
+        }
+    }
+    return (bundy::dns::rdata::createRdata(type, cls, rdata_str));
+}
+
 // Adds the given Rdata to the given RRset
 // If the rrset is an empty pointer, a new one is
 // created with the given name, class, type and ttl
 // The type is checked if the rrset exists, but the
 // name is not.
 //
-// Then adds the given rdata to the set
+// Then adds the rdata of the record the context
+// points to (see createRecordRdata()) to the set
 //
 // Raises a DataSourceError if the type does not
-// match, or if the given rdata string does not
+// match, or if the given rdata does not
 // parse correctly for the given type and class
 //
 // The DatabaseAccessor is passed to print the
@@ -173,6 +224,7 @@ void addOrCreate(bundy::dns::RRsetPtr& rrset,
                     const bundy::dns::RRClass& cls,
                     const bundy::dns::RRType& type,
                     const bundy::dns::RRTTL& ttl,
+                    const DatabaseAccessor::IteratorContext& context,
                     const std::string& rdata_str,
                     const DatabaseAccessor& db
                 )
@@ -192,7 +244,7 @@ void addOrCreate(bundy::dns::RRsetPtr& rrset,
         }
     }
     try {
-        rrset->addRdata(bundy::dns::rdata::createRdata(type, cls, rdata_str));
+        rrset->addRdata(createRecordRdata(type, cls, context, rdata_str));
     } catch (const bundy::dns::rdata::InvalidRdataText& ivrt) {
         // at this point, rrset may have been initialised for no reason,
         // and won't be used. But the caller would drop the shared_ptr
@@ -291,8 +343,8 @@ DatabaseClient::Finder::getRRsets(const string& name, const WantedTypes& types,
                 // done.
                 // A possible optimization here is to not store them for
                 // types we are certain we don't need
-                sig_store.addSig(rdata::createRdata(cur_type, getClass(),
-                     columns[DatabaseAccessor::RDATA_COLUMN]));
+                sig_store.addSig(createRecordRdata(cur_type, getClass(),
+                     *context, columns[DatabaseAccessor::RDATA_COLUMN]));
             }
 
             if (types.find(cur_type) != types.end() || any) {
@@ -310,7 +362,7 @@ DatabaseClient::Finder::getRRsets(const string& name, const WantedTypes& types,
                 // of the 'type covered' field in the RRSIG Rdata).
                 //cur_sigtype(columns[SIGTYPE_COLUMN]);
                 addOrCreate(result[cur_type], construct_name_object,
-                            getClass(), cur_type, cur_ttl,
+                            getClass(), cur_type, cur_ttl, *context,
                             columns[DatabaseAccessor::RDATA_COLUMN],
                             *accessor_);
             }
@@ -431,6 +483,18 @@ DELEGATION_TYPES() {
     return (result);
 }
 
+const WantedTypes&
+SOA_TYPES() {
+    static bool initialized(false);
+    static WantedTypes result;
+
+    if (!initialized) {
+        result.insert(RRType::SOA());
+        initialized = true;
+    }
+    return (result);
+}
+
 const WantedTypes&
 FINAL_TYPES() {
     static bool initialized(false);
@@ -466,12 +530,69 @@ DatabaseClient::Finder::find(const bundy::dns::Name& name,
     if (type == RRType::ANY()) {
         bundy_throw(bundy::Unexpected, "Use findAll to answer ANY");
     }
+    if (cache_) {
+        return (findCached(name, type, options));
+    }
     const DBResultContext result = findInternal(name, type, NULL, options);
     return (ZoneFinderContextPtr(new GenericContext(
                                      *this, options, result.context_,
                                      result.match_label_count_)));
 }
 
+ZoneFinderContextPtr
+DatabaseClient::Finder::findCached(const bundy::dns::Name& name,
+                                   const bundy::dns::RRType& type,
+                                   const FindOptions options)
+{
+    const time_t now = time(NULL);
+    if (cache_->needsCheck(zone_id_, now)) {
+        checkZoneSerial(now);
+    }
+
+    DatabaseFindCache::Result cached;
+    if (cache_->find(zone_id_, name, type, options, now, cached)) {
+        LOG_DEBUG(logger, DBG_TRACE_DETAILED, DATASRC_DATABASE_FIND_CACHED)
+            .arg(accessor_->getDBName()).arg(name).arg(type).arg(getClass());
+        return (ZoneFinderContextPtr(new GenericContext(
+                                         *this, options,
+                                         ResultContext(cached.code,
+                                                       cached.rrset,
+                                                       cached.flags),
+                                         cached.match_label_count)));
+    }
+
+    const DBResultContext result = findInternal(name, type, NULL, options);
+    cache_->add(zone_id_, name, type, options,
+                DatabaseFindCache::Result(result.context_.code,
+                                          result.context_.rrset,
+                                          result.context_.flags,
+                                          result.match_label_count_),
+                now);
+    return (ZoneFinderContextPtr(new GenericContext(
+                                     *this, options, result.context_,
+                                     result.match_label_count_)));
+}
+
+void
+DatabaseClient::Finder::checkZoneSerial(time_t now) {
+    const FoundRRsets found = getRRsets(origin_.toText(), SOA_TYPES(), false);
+    const std::map<RRType, RRsetPtr>::const_iterator it =
+        found.second.find(RRType::SOA());
+    if (it == found.second.end() || it->second->getRdataCount() == 0) {
+        // A zone without SOA is broken; don't cache anything for it.
+        cache_->invalidateZone(zone_id_);
+        return;
+    }
+    const generic::SOA& soa = dynamic_cast<const generic::SOA&>(
+        it->second->getRdataIterator()->getCurrent());
+    // RFC 2308: the TTL of negative answers is the smaller of the SOA TTL
+    // and MINIMUM.
+    const uint32_t negative_ttl =
+        std::min(it->second->getTTL().getValue(), soa.getMinimum());
+    cache_->updateZone(zone_id_, soa.getSerial().getValue(), negative_ttl,
+                       now);
+}
+
 DatabaseClient::Finder::DelegationSearchResult
 DatabaseClient::Finder::findDelegationPoint(const bundy::dns::Name& name,
                                             const FindOptions options)
@@ -1422,8 +1543,10 @@ class DatabaseUpdater : public ZoneUpdater {
 public:
     DatabaseUpdater(boost::shared_ptr<DatabaseAccessor> accessor, int zone_id,
             const Name& zone_name, const RRClass& zone_class,
-            bool journaling) :
-        committed_(false), accessor_(accessor), zone_id_(zone_id),
+            bool journaling,
+            boost::shared_ptr<DatabaseFindCache> find_cache) :
+        committed_(false), accessor_(accessor), find_cache_(find_cache),
+        zone_id_(zone_id),
         db_name_(accessor->getDBName()), zone_name_(zone_name.toText()),
         zone_class_(zone_class), journaling_(journaling),
         diff_phase_(NOT_STARTED), serial_(0),
@@ -1473,6 +1596,10 @@ private:
 
     bool committed_;
     boost::shared_ptr<DatabaseAccessor> accessor_;
+    // The find cache of the client (if any), which needs to be invalidated
+    // on commit.  The finder of the updater itself never uses it, as it
+    // sees the uncommitted changes.
+    boost::shared_ptr<DatabaseFindCache> find_cache_;
     const int zone_id_;
     const string db_name_;
     const string zone_name_;
@@ -1751,6 +1878,9 @@ DatabaseUpdater::commit() {
     }
     accessor_->commit();
     committed_ = true; // make sure the destructor won't trigger rollback
+    if (find_cache_) {
+        find_cache_->invalidateZone(zone_id_);
+    }
 
     // Disable the RRsetCollection if it exists.
     if (rrset_collection_) {
@@ -1782,7 +1912,8 @@ DatabaseClient::getUpdater(const bundy::dns::Name& name, bool replace,
     }
 
     return (ZoneUpdaterPtr(new DatabaseUpdater(update_accessor, zone.second,
-                                               name, rrclass_, journaling)));
+                                               name, rrclass_, journaling,
+                                               find_cache_)));
 }
 
 //
@@ -32,12 +32,17 @@
 #include <dns/name.h>
 #include <exceptions/exceptions.h>
 
+#include <ctime>
 #include <map>
 #include <set>
 
+#include <stdint.h>
+
 namespace bundy {
 namespace datasrc {
 
+class DatabaseFindCache;
+
 /// \brief Abstraction of lowlevel database with DNS data
 ///
 /// This class is defines interface to databases. Each supported database
@@ -281,8 +286,6 @@ public:
         /// \param columns The data will be returned through here. The order
         ///     is specified by the RecordColumns enum, and the size must be
         ///     COLUMN_COUNT
-        /// \todo Do we consider databases where it is stored in binary blob
-        ///     format?
         /// \throw DataSourceError if there's database-related error. If the
         ///     exception (or any other in case of derived class) is thrown,
         ///     the iterator can't be safely used any more.
@@ -290,6 +293,31 @@ public:
         ///         updated. false if there was no more data, in which case
         ///         the columns array is untouched.
         virtual bool getNext(std::string (&columns)[COLUMN_COUNT]) = 0;
+
+        /// \brief Return the RDATA of the current record in wire format
+        ///
+        /// A database may store the RDATA of records in the wire format in
+        /// addition to the text representation.  In that case this method
+        /// provides the wire-format RDATA of the record last returned by
+        /// getNext(), so the caller can build the Rdata object directly
+        /// from it instead of parsing the RDATA_COLUMN text.
+        ///
+        /// The returned data is only valid until the next call to
+        /// getNext().
+        ///
+        /// The default implementation always returns false; the caller
+        /// then has to use RDATA_COLUMN.  Derived classes don't have to
+        /// override it unless they can provide the wire format.
+        ///
+        /// \param data On success, set to the beginning of the wire data.
+        /// \param len On success, set to the length of the wire data.
+        /// \return true if the wire-format RDATA is available for the
+        ///     current record, false otherwise.
+        virtual bool getRdataWire(const uint8_t*& /*data*/,
+                                  size_t& /*len*/) const
+        {
+            return (false);
+        }
     };
 
     typedef boost::shared_ptr<IteratorContext> IteratorContextPtr;
@@ -884,6 +912,26 @@ public:
                    bundy::dns::RRClass rrclass,
                    boost::shared_ptr<DatabaseAccessor> accessor);
 
+    /// \brief Enable (or disable) the cache of find() results.
+    ///
+    /// When enabled, the results of \c ZoneFinder::find() on the finders
+    /// returned by \c findZone() are kept in a \c DatabaseFindCache and
+    /// repeated lookups are answered from it without querying the
+    /// database.  See \c DatabaseFindCache for when results expire; in
+    /// short, changes made by other processes are noticed within
+    /// \c check_interval seconds, changes made through updaters of this
+    /// client immediately.
+    ///
+    /// Any previously cached results are discarded.  The cache is disabled
+    /// by default.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The maximum number of cached results.  If it's
+    ///     0, the cache is disabled.
+    /// \param check_interval How often (in seconds) the SOA serial of a
+    ///     zone is checked for changes.
+    void enableFindCache(size_t max_entries, uint32_t check_interval = 1);
 
     /// \brief Corresponding ZoneFinder implementation
     ///
@@ -910,8 +958,12 @@ public:
         /// \param origin The name of the origin of this zone. It could query
         ///     it from database, but as the DatabaseClient just searched for
         ///     the zone using the name, it should have it.
+        /// \param cache If non NULL, the results of find() are cached in it
+        ///     (shared with DatabaseClient).
         Finder(boost::shared_ptr<DatabaseAccessor> database, int zone_id,
-               const bundy::dns::Name& origin);
+               const bundy::dns::Name& origin,
+               boost::shared_ptr<DatabaseFindCache> cache =
+               boost::shared_ptr<DatabaseFindCache>());
 
         // The following three methods are just implementations of inherited
         // ZoneFinder's pure virtual methods.
@@ -990,6 +1042,18 @@ public:
         boost::shared_ptr<DatabaseAccessor> accessor_;
         const int zone_id_;
         const bundy::dns::Name origin_;
+        boost::shared_ptr<DatabaseFindCache> cache_;
+
+        /// \brief find() using the cache.
+        ///
+        /// Returns the cached result if there is one, otherwise looks it
+        /// up in the database and caches it.
+        ZoneFinderContextPtr findCached(const bundy::dns::Name& name,
+                                        const bundy::dns::RRType& type,
+                                        const FindOptions options);
+
+        /// \brief Report the current SOA serial of the zone to the cache.
+        void checkZoneSerial(time_t now);
 
         /// \brief Shortcut name for the result of getRRsets
         typedef std::pair<bool, std::map<dns::RRType, dns::RRsetPtr> >
@@ -1511,6 +1575,9 @@ private:
 
     /// \brief The accessor to our database.
     const boost::shared_ptr<DatabaseAccessor> accessor_;
+
+    /// \brief The cache of find() results, NULL if disabled.
+    boost::shared_ptr<DatabaseFindCache> find_cache_;
 };
 
 }
@@ -0,0 +1,230 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/database_cache.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/lru_hash_table.h>
+
+#include <algorithm>
+#include <map>
+
+using namespace bundy::dns;
+using bundy::util::LruHashTable;
+
+namespace bundy {
+namespace datasrc {
+
+namespace {
+struct FindCacheKey {
+    FindCacheKey(int zone_id_param, const Name& name_param,
+                 const RRType& type_param,
+                 ZoneFinder::FindOptions options_param) :
+        zone_id(zone_id_param), name(name_param), type(type_param),
+        options(options_param)
+    {}
+
+    const int zone_id;
+    const Name& name;
+    const RRType& type;
+    const ZoneFinder::FindOptions options;
+};
+
+struct FindCacheEntry {
+    FindCacheEntry() :
+        hash_(0), zone_id_(0), name_(Name::ROOT_NAME()), qtype_(0),
+        options_(ZoneFinder::FIND_DEFAULT), generation_(0), expire_(0)
+    {}
+
+    bool matches(const FindCacheKey& key) const {
+        // Name comparison is case insensitive.
+        return (zone_id_ == key.zone_id && qtype_ == key.type.getCode() &&
+                options_ == key.options && name_ == key.name);
+    }
+
+    size_t hash_;
+    int zone_id_;
+    Name name_;
+    uint16_t qtype_;
+    ZoneFinder::FindOptions options_;
+    uint64_t generation_;
+    time_t expire_;
+    DatabaseFindCache::Result result_;
+
+    boost::intrusive::list_member_hook<> hash_hook_;
+    boost::intrusive::list_member_hook<> lru_hook_;
+};
+
+// What we know about a zone: the SOA serial and negative TTL last reported,
+// when they were reported, and the generation number of the cache entries
+// that belong to this version of the zone.
+struct ZoneState {
+    uint32_t serial_;
+    uint32_t negative_ttl_;
+    time_t checked_;
+    uint64_t generation_;
+};
+}
+
+struct DatabaseFindCache::Impl {
+    typedef std::map<int, ZoneState> ZoneStateMap;
+
+    Impl(size_t max_entries, uint32_t check_interval) :
+        check_interval_(check_interval), table_(max_entries),
+        last_generation_(0)
+    {}
+
+    static size_t getHash(const FindCacheKey& key) {
+        size_t hash = LabelSequence(key.name).getHash(false);
+        hash ^= key.type.getCode() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= key.zone_id + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return (hash ^ (static_cast<size_t>(key.options) << 16));
+    }
+
+    const ZoneState* getZoneState(int zone_id) const {
+        const ZoneStateMap::const_iterator it = zones_.find(zone_id);
+        return (it == zones_.end() ? NULL : &it->second);
+    }
+
+    const uint32_t check_interval_;
+    LruHashTable<FindCacheEntry> table_;
+    ZoneStateMap zones_;
+    uint64_t last_generation_;
+};
+
+DatabaseFindCache::DatabaseFindCache(size_t max_entries,
+                                     uint32_t check_interval)
+{
+    if (max_entries == 0) {
+        bundy_throw(InvalidParameter, "find cache size must not be 0");
+    }
+    impl_ = new Impl(max_entries, check_interval);
+}
+
+DatabaseFindCache::~DatabaseFindCache() {
+    delete impl_;
+}
+
+bool
+DatabaseFindCache::needsCheck(int zone_id, time_t now) const {
+    const ZoneState* state = impl_->getZoneState(zone_id);
+    return (state == NULL ||
+            now < state->checked_ || // the clock went backwards
+            now - state->checked_ >= impl_->check_interval_);
+}
+
+void
+DatabaseFindCache::updateZone(int zone_id, uint32_t serial,
+                              uint32_t negative_ttl, time_t now)
+{
+    Impl::ZoneStateMap::iterator it = impl_->zones_.find(zone_id);
+    if (it == impl_->zones_.end()) {
+        it = impl_->zones_.insert(
+            Impl::ZoneStateMap::value_type(zone_id, ZoneState())).first;
+        it->second.generation_ = ++impl_->last_generation_;
+    } else if (it->second.serial_ != serial) {
+        // Entries of the old generation are left until they are recycled;
+        // they never match the zone again.
+        it->second.generation_ = ++impl_->last_generation_;
+    }
+    it->second.serial_ = serial;
+    it->second.negative_ttl_ = negative_ttl;
+    it->second.checked_ = now;
+}
+
+void
+DatabaseFindCache::invalidateZone(int zone_id) {
+    impl_->zones_.erase(zone_id);
+}
+
+bool
+DatabaseFindCache::find(int zone_id, const Name& name, const RRType& type,
+                        ZoneFinder::FindOptions options, time_t now,
+                        Result& result)
+{
+    const ZoneState* state = impl_->getZoneState(zone_id);
+    if (state == NULL) {
+        return (false);
+    }
+    const FindCacheKey key(zone_id, name, type, options);
+    FindCacheEntry* entry = impl_->table_.find(key, Impl::getHash(key));
+    if (entry == NULL || entry->generation_ != state->generation_ ||
+        entry->expire_ <= now) {
+        return (false);
+    }
+    impl_->table_.touch(*entry);
+    result = entry->result_;
+    return (true);
+}
+
+void
+DatabaseFindCache::add(int zone_id, const Name& name, const RRType& type,
+                       ZoneFinder::FindOptions options, const Result& result,
+                       time_t now)
+{
+    const ZoneState* state = impl_->getZoneState(zone_id);
+    if (state == NULL) {
+        return;
+    }
+
+    uint32_t ttl = 0;
+    if (result.code == ZoneFinder::NXDOMAIN ||
+        result.code == ZoneFinder::NXRRSET) {
+        ttl = state->negative_ttl_;
+        if (result.rrset) {
+            ttl = std::min(ttl, result.rrset->getTTL().getValue());
+        }
+    } else if (result.rrset) {
+        ttl = result.rrset->getTTL().getValue();
+    }
+    if (ttl == 0) {
+        return;
+    }
+
+    const FindCacheKey key(zone_id, name, type, options);
+    const size_t hash = Impl::getHash(key);
+    FindCacheEntry* entry = impl_->table_.find(key, hash);
+    if (entry != NULL) {
+        impl_->table_.touch(*entry);
+    } else {
+        entry = &impl_->table_.insert(hash);
+        entry->zone_id_ = zone_id;
+        entry->name_ = name;
+        entry->qtype_ = type.getCode();
+        entry->options_ = options;
+    }
+    entry->generation_ = state->generation_;
+    entry->expire_ = now + ttl;
+    entry->result_ = result;
+}
+
+size_t
+DatabaseFindCache::getEntryCount() const {
+    return (impl_->table_.getEntryCount());
+}
+
+size_t
+DatabaseFindCache::getMaxEntries() const {
+    return (impl_->table_.getMaxEntries());
+}
+
+} // namespace datasrc
+} // namespace bundy
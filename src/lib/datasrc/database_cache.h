@@ -0,0 +1,172 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_DATABASE_CACHE_H
+#define DATASRC_DATABASE_CACHE_H 1
+
+#include <datasrc/zone_finder.h>
+
+#include <dns/name.h>
+#include <dns/rrset.h>
+#include <dns/rrtype.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <ctime>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace datasrc {
+
+/// \brief A cache of \c find() results of database-backed zones.
+///
+/// \c DatabaseClient::Finder::find() generally needs several queries to
+/// the database for a single lookup: one for each possible delegation
+/// point above the name, one for the name itself, and, for negative
+/// answers, more for wildcards, empty non-terminals and the NSEC proof.
+/// This class keeps the outcome of such lookups, keyed by the zone, the
+/// name, the type and the find options, so repeated lookups for the same
+/// name can be answered without the database.
+///
+/// An entry is valid for the TTL of its RRset.  Negative results are
+/// valid for the negative caching TTL of the zone (the smaller of the TTL
+/// and the MINIMUM field of the SOA, as in RFC 2308), and not longer than
+/// the TTL of the NSEC RRset if there's one.
+///
+/// Changes to the zone are detected by its SOA serial.  The finder checks
+/// the serial at most once every "check interval" seconds, and reports it
+/// through \c updateZone(); when it has changed, all entries of the zone
+/// are dropped.  Changes made through \c DatabaseClient's own updaters are
+/// applied immediately via \c invalidateZone().  Changes made by other
+/// processes can thus be unnoticed for up to the check interval.
+///
+/// The cache has a fixed maximum number of entries; once it's full, the
+/// least recently used entry is recycled for a new result.
+///
+/// This class is not thread safe, like the \c DatabaseClient it's used in.
+class DatabaseFindCache : boost::noncopyable {
+public:
+    /// \brief A cached \c find() result.
+    struct Result {
+        Result() :
+            code(ZoneFinder::NXDOMAIN), flags(ZoneFinder::RESULT_DEFAULT),
+            match_label_count(0)
+        {}
+        Result(ZoneFinder::Result code_param,
+               const dns::ConstRRsetPtr& rrset_param,
+               ZoneFinder::FindResultFlags flags_param,
+               uint8_t match_label_count_param) :
+            code(code_param), rrset(rrset_param), flags(flags_param),
+            match_label_count(match_label_count_param)
+        {}
+
+        ZoneFinder::Result code;
+        dns::ConstRRsetPtr rrset;
+        ZoneFinder::FindResultFlags flags;
+        uint8_t match_label_count;
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_entries is 0
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The maximum number of results in the cache.
+    /// \param check_interval How often (in seconds) the SOA serial of a
+    /// zone should be checked.
+    DatabaseFindCache(size_t max_entries, uint32_t check_interval);
+
+    /// \brief Destructor.
+    ~DatabaseFindCache();
+
+    /// \brief Return whether the serial of the zone needs to be checked.
+    ///
+    /// This is true if the serial of the zone has never been reported
+    /// through \c updateZone(), the zone has been invalidated since then,
+    /// or the check interval has passed since the last report.
+    bool needsCheck(int zone_id, time_t now) const;
+
+    /// \brief Report the current SOA of a zone.
+    ///
+    /// If the serial is different from the previously reported one, or
+    /// the zone has been invalidated, all entries of the zone are
+    /// dropped.  The SOA TTL and MINIMUM are used as the negative TTL.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param zone_id The ID of the zone.
+    /// \param serial The current SOA serial of the zone.
+    /// \param negative_ttl The negative caching TTL of the zone.
+    /// \param now The current time.
+    void updateZone(int zone_id, uint32_t serial, uint32_t negative_ttl,
+                    time_t now);
+
+    /// \brief Drop all entries of the zone.
+    ///
+    /// The next \c needsCheck() for the zone returns true.
+    void invalidateZone(int zone_id);
+
+    /// \brief Look up a cached result.
+    ///
+    /// \param zone_id The ID of the zone.
+    /// \param name The name passed to \c find().
+    /// \param type The type passed to \c find().
+    /// \param options The options passed to \c find().
+    /// \param now The current time.
+    /// \param result The cached result is stored here if found.
+    /// \return true if a valid result is found; false otherwise.
+    bool find(int zone_id, const dns::Name& name, const dns::RRType& type,
+              ZoneFinder::FindOptions options, time_t now, Result& result);
+
+    /// \brief Store a result.
+    ///
+    /// Results of a zone not reported through \c updateZone() (or
+    /// invalidated since then) and results whose TTL is 0 are not stored.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param zone_id The ID of the zone.
+    /// \param name The name passed to \c find().
+    /// \param type The type passed to \c find().
+    /// \param options The options passed to \c find().
+    /// \param result The result of \c find().
+    /// \param now The current time.
+    void add(int zone_id, const dns::Name& name, const dns::RRType& type,
+             ZoneFinder::FindOptions options, const Result& result,
+             time_t now);
+
+    /// \brief Return the number of entries currently in the cache.
+    ///
+    /// This includes entries that are expired or belong to an old version
+    /// of a zone and are waiting to be recycled.
+    size_t getEntryCount() const;
+
+    /// \brief Return the maximum number of entries in the cache.
+    size_t getMaxEntries() const;
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_DATABASE_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
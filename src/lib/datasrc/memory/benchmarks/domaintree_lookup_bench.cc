@@ -0,0 +1,164 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <bench/benchmark.h>
+
+#include <util/memory_segment_local.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/rrclass.h>
+
+#include <datasrc/memory/zone_data.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <unistd.h>
+
+using std::vector;
+using namespace bundy::bench;
+using namespace bundy::datasrc::memory;
+using namespace bundy::dns;
+
+namespace {
+// A local memory segment that keeps track of the amount of memory currently
+// allocated through it, so we can show the memory footprint of the tree.
+class CountingMemorySegment : public bundy::util::MemorySegmentLocal {
+public:
+    CountingMemorySegment() : current_size_(0) {}
+    virtual void* allocate(size_t size) {
+        void* p = MemorySegmentLocal::allocate(size);
+        current_size_ += size;
+        return (p);
+    }
+    virtual void deallocate(void* ptr, size_t size) {
+        MemorySegmentLocal::deallocate(ptr, size);
+        current_size_ -= size;
+    }
+    size_t getCurrentSize() const { return (current_size_); }
+private:
+    size_t current_size_;
+};
+
+// Repeat exact match lookups of the given names in the zone tree.
+class LookupBenchMark {
+public:
+    LookupBenchMark(const ZoneTree& tree, const vector<Name>& names) :
+        tree_(tree), names_(names)
+    {}
+    unsigned int run() {
+        vector<Name>::const_iterator it;
+        const vector<Name>::const_iterator it_end = names_.end();
+        for (it = names_.begin(); it != it_end; ++it) {
+            const ZoneNode* node = NULL;
+            const ZoneTree::Result result = tree_.find(*it, &node);
+            assert(result == ZoneTree::EXACTMATCH);
+        }
+        return (names_.size());
+    }
+private:
+    const ZoneTree& tree_;
+    const vector<Name>& names_;
+};
+
+const char* const ZONE_NAME = "example.org";
+
+void
+usage() {
+    std::cerr << "Usage: domaintree_lookup_bench [-n iterations] "
+        "[-s zone_size] [-q query_count]" << std::endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 1;
+    size_t zone_size = 1000000;
+    size_t query_count = 1000000;
+    while ((ch = getopt(argc, argv, "n:s:q:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 's':
+            zone_size = atoi(optarg);
+            break;
+        case 'q':
+            query_count = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0 || zone_size == 0) {
+        usage();
+    }
+
+    // Build a zone of zone_size names, a thousand names per subdomain, like
+    // "host123.sub45.example.org".  This gives a tree of trees of realistic
+    // depth for large zones.
+    const Name origin(ZONE_NAME);
+    vector<Name> names;
+    names.reserve(zone_size);
+    for (size_t i = 0; i < zone_size; ++i) {
+        names.push_back(
+            Name("host" + boost::lexical_cast<std::string>(i % 1000) +
+                 ".sub" + boost::lexical_cast<std::string>(i / 1000)).
+            concatenate(origin));
+    }
+
+    CountingMemorySegment mem_sgmt;
+    ZoneData* zone_data = ZoneData::create(mem_sgmt, origin);
+    const size_t empty_size = mem_sgmt.getCurrentSize();
+    for (vector<Name>::const_iterator it = names.begin();
+         it != names.end();
+         ++it)
+    {
+        ZoneNode* node;
+        zone_data->insertName(mem_sgmt, *it, &node);
+    }
+    const ZoneTree& tree = zone_data->getZoneTree();
+    std::cout << "Zone tree of " << tree.getNodeCount() << " nodes uses "
+              << (mem_sgmt.getCurrentSize() - empty_size) << " bytes ("
+              << (mem_sgmt.getCurrentSize() - empty_size) /
+        tree.getNodeCount() << " bytes per node)" << std::endl;
+
+    // Query the names in random order, so consecutive lookups don't share
+    // the cache lines of the upper part of the tree too much.
+    vector<Name> queries;
+    queries.reserve(query_count);
+    srandom(1);
+    for (size_t i = 0; i < query_count; ++i) {
+        queries.push_back(names[random() % names.size()]);
+    }
+
+    std::cout << "Benchmark for exact match lookups" << std::endl;
+    BenchMark<LookupBenchMark>(iteration, LookupBenchMark(tree, queries));
+
+    // Cleanup, and memory leak check
+    ZoneData::destroy(mem_sgmt, zone_data, RRClass::IN());
+    assert(mem_sgmt.allMemoryDeallocated());
+
+    return (0);
+}
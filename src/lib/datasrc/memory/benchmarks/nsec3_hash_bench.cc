@@ -0,0 +1,220 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/memory_segment_local.h>
+
+#include <log/logger_support.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/nsec3hash.h>
+#include <dns/rrclass.h>
+
+#include <datasrc/memory/nsec3_hash_cache.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/zone_finder.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::bench;
+using namespace bundy::datasrc::memory;
+using bundy::datasrc::ZoneFinder;
+using namespace bundy::dns;
+
+namespace {
+// Names that don't exist in the zone, so each of them needs a closest
+// encloser proof and a wildcard proof as for an NXDOMAIN answer.  A new
+// set of names is used in each run, like the random names of a flood of
+// queries that bypasses resolver caches.
+class QueryNames {
+public:
+    QueryNames(const Name& origin, size_t count) :
+        origin_(origin), count_(count), generation_(0)
+    {}
+    const vector<Name>& getNext() {
+        names_.clear();
+        for (size_t i = 0; i < count_; ++i) {
+            names_.push_back(
+                Name("nx" + boost::lexical_cast<string>(generation_) + "-" +
+                     boost::lexical_cast<string>(i)).concatenate(origin_));
+        }
+        ++generation_;
+        return (names_);
+    }
+private:
+    const Name origin_;
+    const size_t count_;
+    unsigned int generation_;
+    vector<Name> names_;
+};
+
+// The NSEC3 lookups of Query::addNXDOMAINProofByNSEC3().
+class NXDOMAINProofBenchMark {
+public:
+    NXDOMAINProofBenchMark(const ZoneData& zone_data, QueryNames& names,
+                           NSEC3HashCache* cache) :
+        zone_data_(zone_data), names_(names), cache_(cache)
+    {}
+    unsigned int run() {
+        InMemoryZoneFinder finder(zone_data_, RRClass::IN(), cache_);
+        const vector<Name>& names = names_.getNext();
+        for (size_t i = 0; i < names.size(); ++i) {
+            const ZoneFinder::FindNSEC3Result result =
+                finder.findNSEC3(names[i], true);
+            const Name& name = names[i];
+            const Name wildname(Name("*").concatenate(
+                                    name.split(name.getLabelCount() -
+                                               result.closest_labels)));
+            finder.findNSEC3(wildname, false);
+        }
+        return (names.size());
+    }
+private:
+    const ZoneData& zone_data_;
+    QueryNames& names_;
+    NSEC3HashCache* const cache_;
+};
+
+// Calculate the closest encloser, next closer and wildcard hashes, one by
+// one or all at once.  The closest encloser is assumed to be the origin.
+class HashBenchMark {
+public:
+    HashBenchMark(const NSEC3Data& nsec3_data, QueryNames& names,
+                  bool batch) :
+        hash_(NSEC3Hash::create(nsec3_data.hashalg, nsec3_data.iterations,
+                                nsec3_data.getSaltData(),
+                                nsec3_data.getSaltLen())),
+        names_(names), batch_(batch)
+    {}
+    unsigned int run() {
+        const vector<Name>& names = names_.getNext();
+        for (size_t i = 0; i < names.size(); ++i) {
+            const Name closest(names[i].split(1));
+            const Name wildname(Name("*").concatenate(closest));
+            const LabelSequence labels[] = {
+                LabelSequence(closest), LabelSequence(names[i]),
+                LabelSequence(wildname)
+            };
+            string hashes[3];
+            if (batch_) {
+                const LabelSequence* const label_ptrs[] = {
+                    &labels[0], &labels[1], &labels[2]
+                };
+                hash_->calculateBatch(label_ptrs, 3, hashes);
+            } else {
+                for (int j = 0; j < 3; ++j) {
+                    hashes[j] = hash_->calculate(labels[j]);
+                }
+            }
+        }
+        return (names.size());
+    }
+private:
+    boost::shared_ptr<NSEC3Hash> hash_;
+    QueryNames& names_;
+    const bool batch_;
+};
+
+void
+usage() {
+    cerr << "Usage: nsec3_hash_bench [-n iterations] [-q queries] "
+        "zone_file origin" << endl;
+    cerr << "  zone_file must be an NSEC3-signed zone" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100;
+    size_t queries = 100;
+    while ((ch = getopt(argc, argv, "n:q:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 'q':
+            queries = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (argc != 2) {
+        usage();
+    }
+    const string zone_file = argv[0];
+    const Name origin(argv[1]);
+
+    bundy::log::initLogger("nsec3-hash-bench", bundy::log::NONE);
+
+    bundy::util::MemorySegmentLocal mem_sgmt;
+    ZoneDataLoader loader(mem_sgmt, RRClass::IN(), origin, zone_file);
+    ZoneData* zone_data = loader.load();
+    if (!zone_data->isNSEC3Signed()) {
+        cerr << zone_file << " is not NSEC3-signed" << endl;
+        ZoneData::destroy(mem_sgmt, zone_data, RRClass::IN());
+        return (1);
+    }
+    const NSEC3Data& nsec3_data = *zone_data->getNSEC3Data();
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Queries per iteration: " << queries << endl;
+    cout << "  Zone file: " << zone_file << endl;
+    cout << "  Origin: " << origin << endl;
+    cout << "  NSEC3 hash iterations: " << nsec3_data.iterations << endl;
+
+    QueryNames names(origin, queries);
+
+    cout << "Benchmark for hashing names one by one" << endl;
+    BenchMark<HashBenchMark>(iteration,
+                             HashBenchMark(nsec3_data, names, false));
+
+    cout << "Benchmark for hashing names in a batch" << endl;
+    BenchMark<HashBenchMark>(iteration,
+                             HashBenchMark(nsec3_data, names, true));
+
+    cout << "Benchmark for NXDOMAIN proofs without NSEC3 hash cache" << endl;
+    BenchMark<NXDOMAINProofBenchMark>(
+        iteration, NXDOMAINProofBenchMark(*zone_data, names, NULL));
+
+    NSEC3HashCache cache(10000);
+    cout << "Benchmark for NXDOMAIN proofs with NSEC3 hash cache" << endl;
+    BenchMark<NXDOMAINProofBenchMark>(
+        iteration, NXDOMAINProofBenchMark(*zone_data, names, &cache));
+
+    ZoneData::destroy(mem_sgmt, zone_data, RRClass::IN());
+    // Memory leak check
+    assert(mem_sgmt.allMemoryDeallocated());
+
+    return (0);
+}
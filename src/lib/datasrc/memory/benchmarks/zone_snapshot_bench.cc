@@ -0,0 +1,152 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/memory_segment_local.h>
+
+#include <log/logger_support.h>
+
+#include <dns/master_loader.h>
+#include <dns/master_loader_callbacks.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrcollator.h>
+#include <dns/rrset.h>
+
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/zone_snapshot.h>
+
+#include <boost/bind.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::bench;
+using namespace bundy::datasrc::memory;
+using namespace bundy::dns;
+
+namespace {
+void
+addRRset(ZoneSnapshotWriter* writer, const RRsetPtr& rrset) {
+    writer->addRRset(*rrset);
+}
+
+void
+ignoreMessage(const string&, size_t, const string&) {
+}
+
+// Convert the master file into a snapshot, as a zone would be saved before
+// a restart.
+void
+writeSnapshot(const string& zone_file, const Name& origin,
+              const string& snapshot_file)
+{
+    ZoneSnapshotWriter writer(snapshot_file, origin, RRClass::IN());
+    RRCollator collator(boost::bind(addRRset, &writer, _1));
+    MasterLoader loader(zone_file.c_str(), origin, RRClass::IN(),
+                        MasterLoaderCallbacks(ignoreMessage, ignoreMessage),
+                        collator.getCallback());
+    loader.load();
+    collator.flush();
+    writer.close();
+}
+
+// Load the zone from the given file into a new ZoneData, as on startup,
+// and destroy it again.
+class ZoneLoadBenchMark {
+public:
+    ZoneLoadBenchMark(bundy::util::MemorySegment& mem_sgmt,
+                      const string& zone_file, const Name& origin) :
+        mem_sgmt_(mem_sgmt), zone_file_(zone_file), origin_(origin)
+    {}
+    unsigned int run() {
+        ZoneDataLoader loader(mem_sgmt_, RRClass::IN(), origin_, zone_file_);
+        ZoneData* zone_data = loader.load();
+        ZoneData::destroy(mem_sgmt_, zone_data, RRClass::IN());
+        return (1);
+    }
+private:
+    bundy::util::MemorySegment& mem_sgmt_;
+    const string zone_file_;
+    const Name origin_;
+};
+
+void
+usage() {
+    cerr << "Usage: zone_snapshot_bench [-n iterations] "
+        "zone_file origin snapshot_file" << endl;
+    cerr << "  (snapshot_file must end with \".snapshot\")" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 1;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (argc != 3) {
+        usage();
+    }
+    const string zone_file = argv[0];
+    const Name origin(argv[1]);
+    const string snapshot_file = argv[2];
+    if (!isZoneSnapshot(snapshot_file)) {
+        usage();
+    }
+
+    bundy::log::initLogger("zone-snapshot-bench", bundy::log::NONE);
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Zone file: " << zone_file << endl;
+    cout << "  Origin: " << origin << endl;
+    cout << "  Snapshot file: " << snapshot_file << endl;
+
+    writeSnapshot(zone_file, origin, snapshot_file);
+    bundy::util::MemorySegmentLocal mem_sgmt;
+
+    cout << "Benchmark for loading the zone from the master file" << endl;
+    BenchMark<ZoneLoadBenchMark>(iteration,
+                                 ZoneLoadBenchMark(mem_sgmt, zone_file,
+                                                   origin));
+
+    cout << "Benchmark for loading the zone from the snapshot" << endl;
+    BenchMark<ZoneLoadBenchMark>(iteration,
+                                 ZoneLoadBenchMark(mem_sgmt, snapshot_file,
+                                                   origin));
+
+    // Memory leak check
+    assert(mem_sgmt.allMemoryDeallocated());
+
+    return (0);
+}
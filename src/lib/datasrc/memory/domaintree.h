@@ -111,7 +111,7 @@ private:
     ///
     /// The only valid usage of the returned pointer is to pass it to
     /// the corresponding constructor of \c dns::LabelSequence.
-    const void* getLabelsData() const { return (this + 1); }
+    const void* getLabelsData() const { return (labels_head_); }
 
     /// \brief Accessor to the memory region for node labels, mutable version.
     ///
@@ -119,7 +119,14 @@ private:
     /// \c LabelSequence::serialize() with the node's labels_capacity_ member
     /// (which should be sufficiently large for the \c LabelSequence in that
     /// context).
-    void* getLabelsData() { return (this + 1); }
+    void* getLabelsData() { return (labels_head_); }
+
+    /// \brief Return the size of memory for a node with the given capacity
+    /// for labels.
+    static size_t getAllocSize(size_t labels_capacity) {
+        return (sizeof(DomainTreeNode<T>) - sizeof(labels_head_) +
+                labels_capacity);
+    }
 
     /// \brief Allocate and construct \c DomainTreeNode
     ///
@@ -134,10 +141,11 @@ private:
     static DomainTreeNode<T>* create(util::MemorySegment& mem_sgmt,
                                      const dns::LabelSequence& labels)
     {
-        const size_t labels_len = labels.getSerializedLength();
-        void* p = mem_sgmt.allocate(sizeof(DomainTreeNode<T>) + labels_len);
-        DomainTreeNode<T>* node = new(p) DomainTreeNode<T>(labels_len);
-        labels.serialize(node->getLabelsData(), labels_len);
+        const size_t labels_capacity =
+            std::max(labels.getSerializedLength(), sizeof(labels_head_));
+        void* p = mem_sgmt.allocate(getAllocSize(labels_capacity));
+        DomainTreeNode<T>* node = new(p) DomainTreeNode<T>(labels_capacity);
+        labels.serialize(node->getLabelsData(), labels_capacity);
         return (node);
     }
 
@@ -155,8 +163,7 @@ private:
     {
         const size_t labels_capacity = node->labels_capacity_;
         node->~DomainTreeNode<T>();
-        mem_sgmt.deallocate(node,
-                            sizeof(DomainTreeNode<T>) + labels_capacity);
+        mem_sgmt.deallocate(node, getAllocSize(labels_capacity));
     }
 
     /// \brief Reset node's label sequence to a new one.
@@ -226,6 +233,16 @@ public:
         return (dns::LabelSequence(getLabelsData()));
     }
 
+    /// \brief Return the size of memory allocated for the node.
+    ///
+    /// This includes the space for the node's label sequence, but not
+    /// the data stored in the node.
+    ///
+    /// \throw none
+    size_t getMemorySize() const {
+        return (getAllocSize(labels_capacity_));
+    }
+
     /// \brief Return the absolute label sequence of the node.
     ///
     /// This method returns the label sequence corresponding to the full
@@ -747,6 +764,15 @@ private:
     // So we can change this implementation without affecting its users if
     // a future change to LabelSequence breaks this assumption.
     BOOST_STATIC_ASSERT((1 << 9) > dns::LabelSequence::MAX_SERIALIZED_LENGTH);
+
+    /// \brief The beginning of the node's label sequence data.
+    ///
+    /// The data continue beyond the end of the object up to
+    /// labels_capacity_ bytes.  By starting them here rather than after
+    /// the object, they use what would otherwise be the tail padding of
+    /// the structure, and they immediately follow the fields used in
+    /// lookups, so a lookup touches as few cache lines as possible.
+    uint8_t labels_head_[4];
 };
 
 template <typename T>
@@ -1353,6 +1379,17 @@ private:
                            bool (*callback)(const DomainTreeNode<T>&, CBARG),
                            CBARG callback_arg);
 
+    /// \brief Hint the CPU to start loading the given node into the cache.
+    ///
+    /// \c node can be NULL, in which case this is effectively no-op.
+    static void prefetchNode(const DomainTreeNode<T>* node) {
+#ifdef __GNUC__
+        __builtin_prefetch(node);
+#else
+        (void) node;
+#endif
+    }
+
 public:
     /// \brief Find with callback and node chain
     /// \anchor callback
@@ -1857,6 +1894,13 @@ DomainTree<T>::findImpl(TT* tree,
     dns::LabelSequence target_labels(target_labels_orig);
 
     while (node != NULL) {
+        // The next node to visit is one of the children.  Start loading
+        // them while we compare the labels, which hides much of the cache
+        // miss latency in a large tree.
+        prefetchNode(node->getLeft());
+        prefetchNode(node->getRight());
+        prefetchNode(node->getDown());
+
         node_path.last_compared_ = node;
         node_path.last_comparison_ = target_labels.compare(node->getLabels());
         const bundy::dns::NameComparisonResult::NameRelation relation =
@@ -2272,7 +2316,9 @@ DomainTree<T>::remove(util::MemorySegment& mem_sgmt, DomainTreeNode<T>* node,
         // of 1 child. Note that this is not an in-place value swap of
         // node data, but the actual node locations are swapped in
         // exchange(). Unlike normal BSTs, we have to do this as our
-        // label data is at address (this + 1).
+        // label data is stored within the node's own allocation (starting
+        // at labels_head_, in the tail of the node structure; see
+        // getAllocSize()), so it can't be moved to another node.
         if (node->getLeft() && node->getRight()) {
             DomainTreeNode<T>* rightmost = node->getLeft();
             while (rightmost->getRight() != NULL) {
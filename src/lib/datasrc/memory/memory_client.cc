@@ -43,12 +43,19 @@ namespace memory {
 
 using boost::shared_ptr;
 
+namespace {
+// The maximum number of NSEC3 hash values kept for the finders.  Each entry
+// takes a few hundred bytes at most.
+const size_t NSEC3_HASH_CACHE_SIZE = 10000;
+}
+
 InMemoryClient::InMemoryClient(const std::string& datasrc_name,
                                shared_ptr<ZoneTableSegment> ztable_segment,
                                RRClass rrclass) :
     DataSourceClient(datasrc_name),
     ztable_segment_(ztable_segment),
-    rrclass_(rrclass)
+    rrclass_(rrclass),
+    nsec3_hash_cache_(new NSEC3HashCache(NSEC3_HASH_CACHE_SIZE))
 {}
 
 RRClass
@@ -72,7 +79,8 @@ InMemoryClient::findZone(const bundy::dns::Name& zone_name) const {
 
     ZoneFinderPtr finder;
     if (result.code != result::NOTFOUND && result.zone_data) {
-        finder.reset(new InMemoryZoneFinder(*result.zone_data, getClass()));
+        finder.reset(new InMemoryZoneFinder(*result.zone_data, getClass(),
+                                            nsec3_hash_cache_.get()));
     }
 
     return (DataSourceClient::FindResult(result.code, finder,
@@ -21,8 +21,10 @@
 #include <datasrc/client.h>
 #include <datasrc/memory/zone_table.h>
 #include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/nsec3_hash_cache.h>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <string>
 
@@ -52,6 +54,9 @@ class ZoneTableSegment;
 /// loaded to the data source is of the same RR class.  For example, the
 /// \c load() method assumes that the zone being loaded belongs to the
 /// same RR class as the memory::Client instance.
+///
+/// The NSEC3 hash values calculated by the finders of the client are kept
+/// in an \c NSEC3HashCache shared by all of them.
 class InMemoryClient : public DataSourceClient {
 public:
     ///
@@ -118,6 +123,7 @@ public:
 private:
     boost::shared_ptr<ZoneTableSegment> ztable_segment_;
     const bundy::dns::RRClass rrclass_;
+    const boost::scoped_ptr<NSEC3HashCache> nsec3_hash_cache_;
 };
 
 } // namespace memory
@@ -0,0 +1,233 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/nsec3_hash_cache.h>
+#include <datasrc/memory/zone_data.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/nsec3hash.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/buffer.h>
+#include <util/lru_hash_table.h>
+#include <util/threads/sync.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstring>
+#include <vector>
+
+using namespace bundy::dns;
+using bundy::util::LruHashTable;
+using bundy::util::thread::Mutex;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+namespace {
+// The cache is split into at most this many stripes, each with its own
+// lock, if every stripe can still hold MIN_STRIPE_ENTRIES entries.
+const size_t MAX_STRIPES = 16;
+const size_t MIN_STRIPE_ENTRIES = 512;
+
+struct HashCacheKey {
+    HashCacheKey(const NSEC3Data& nsec3_data_param,
+                 const LabelSequence& labels_param) :
+        nsec3_data(nsec3_data_param), labels(labels_param)
+    {}
+
+    const NSEC3Data& nsec3_data;
+    const LabelSequence& labels;
+};
+
+struct HashCacheEntry {
+    HashCacheEntry() :
+        hash_(0), hashalg_(0), iterations_(0), name_(Name::ROOT_NAME())
+    {}
+
+    bool matches(const HashCacheKey& key) const {
+        // Name comparison is case insensitive.
+        return (hashalg_ == key.nsec3_data.hashalg &&
+                iterations_ == key.nsec3_data.iterations &&
+                salt_.size() == key.nsec3_data.getSaltLen() &&
+                (salt_.empty() ||
+                 std::memcmp(&salt_[0], key.nsec3_data.getSaltData(),
+                             salt_.size()) == 0) &&
+                LabelSequence(name_).equals(key.labels));
+    }
+
+    size_t hash_;
+    uint8_t hashalg_;
+    uint16_t iterations_;
+    std::vector<uint8_t> salt_;
+    Name name_;
+    std::string nsec3_hash_;
+
+    boost::intrusive::list_member_hook<> hash_hook_;
+    boost::intrusive::list_member_hook<> lru_hook_;
+};
+}
+
+struct NSEC3HashCache::Impl {
+    // A part of the cache holding the entries whose keys hash to it.
+    struct Stripe : boost::noncopyable {
+        explicit Stripe(size_t max_entries) : table_(max_entries) {}
+
+        Mutex mutex_;
+        LruHashTable<HashCacheEntry> table_;
+    };
+    typedef boost::shared_ptr<Stripe> StripePtr;
+
+    explicit Impl(size_t max_entries) : max_entries_(max_entries) {
+        size_t n_stripes = max_entries / MIN_STRIPE_ENTRIES;
+        if (n_stripes > MAX_STRIPES) {
+            n_stripes = MAX_STRIPES;
+        } else if (n_stripes == 0) {
+            n_stripes = 1;
+        }
+        const size_t stripe_size = (max_entries + n_stripes - 1) / n_stripes;
+        for (size_t i = 0; i < n_stripes; ++i) {
+            stripes_.push_back(StripePtr(new Stripe(stripe_size)));
+        }
+    }
+
+    static size_t getHash(const HashCacheKey& key) {
+        size_t hash = key.labels.getHash(false);
+        hash ^= key.nsec3_data.iterations + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+        return (hash ^ (key.nsec3_data.getSaltLen() << 16));
+    }
+
+    // The table buckets are chosen by the low bits of the hash, so the
+    // stripe is chosen by the upper bits.
+    Stripe& getStripe(size_t hash) {
+        return (*stripes_[(hash >> 16) % stripes_.size()]);
+    }
+
+    // Look up the hash value; the stripe's mutex must be held.
+    static bool find(Stripe& stripe, const HashCacheKey& key, size_t hash,
+                     std::string& nsec3_hash)
+    {
+        HashCacheEntry* entry = stripe.table_.find(key, hash);
+        if (entry == NULL) {
+            return (false);
+        }
+        stripe.table_.touch(*entry);
+        nsec3_hash = entry->nsec3_hash_;
+        return (true);
+    }
+
+    // Store the hash value; the stripe's mutex must be held.
+    static void add(Stripe& stripe, const HashCacheKey& key, size_t hash,
+                    const std::string& nsec3_hash)
+    {
+        // Another thread may have added it while we were calculating.
+        HashCacheEntry* entry = stripe.table_.find(key, hash);
+        if (entry != NULL) {
+            stripe.table_.touch(*entry);
+            return;
+        }
+
+        size_t length;
+        const uint8_t* data = key.labels.getData(&length);
+        util::InputBuffer buffer(data, length);
+
+        entry = &stripe.table_.insert(hash);
+        entry->hashalg_ = key.nsec3_data.hashalg;
+        entry->iterations_ = key.nsec3_data.iterations;
+        entry->salt_.assign(key.nsec3_data.getSaltData(),
+                            key.nsec3_data.getSaltData() +
+                            key.nsec3_data.getSaltLen());
+        entry->name_ = Name(buffer);
+        entry->nsec3_hash_ = nsec3_hash;
+    }
+
+    const size_t max_entries_;
+    std::vector<StripePtr> stripes_;
+};
+
+NSEC3HashCache::NSEC3HashCache(size_t max_entries) {
+    if (max_entries == 0) {
+        bundy_throw(InvalidParameter, "NSEC3 hash cache size must not be 0");
+    }
+    impl_ = new Impl(max_entries);
+}
+
+NSEC3HashCache::~NSEC3HashCache() {
+    delete impl_;
+}
+
+void
+NSEC3HashCache::calculate(const NSEC3Data& nsec3_data,
+                          const LabelSequence* const labels[], size_t count,
+                          std::string hashes[])
+{
+    std::vector<size_t> key_hashes(count);
+    std::vector<const LabelSequence*> missing_labels;
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < count; ++i) {
+        const HashCacheKey key(nsec3_data, *labels[i]);
+        key_hashes[i] = Impl::getHash(key);
+        Impl::Stripe& stripe = impl_->getStripe(key_hashes[i]);
+        Mutex::Locker locker(stripe.mutex_);
+        if (!Impl::find(stripe, key, key_hashes[i], hashes[i])) {
+            missing_labels.push_back(labels[i]);
+            missing.push_back(i);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    const boost::scoped_ptr<NSEC3Hash> hash
+        (NSEC3Hash::create(nsec3_data.hashalg, nsec3_data.iterations,
+                           nsec3_data.getSaltData(),
+                           nsec3_data.getSaltLen()));
+    std::vector<std::string> missing_hashes(missing.size());
+    hash->calculateBatch(&missing_labels[0], missing.size(),
+                         &missing_hashes[0]);
+
+    for (size_t i = 0; i < missing.size(); ++i) {
+        hashes[missing[i]] = missing_hashes[i];
+        const size_t key_hash = key_hashes[missing[i]];
+        Impl::Stripe& stripe = impl_->getStripe(key_hash);
+        Mutex::Locker locker(stripe.mutex_);
+        Impl::add(stripe, HashCacheKey(nsec3_data, *missing_labels[i]),
+                  key_hash, missing_hashes[i]);
+    }
+}
+
+size_t
+NSEC3HashCache::getEntryCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < impl_->stripes_.size(); ++i) {
+        Impl::Stripe& stripe = *impl_->stripes_[i];
+        Mutex::Locker locker(stripe.mutex_);
+        count += stripe.table_.getEntryCount();
+    }
+    return (count);
+}
+
+size_t
+NSEC3HashCache::getMaxEntries() const {
+    return (impl_->max_entries_);
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,105 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_NSEC3_HASH_CACHE_H
+#define DATASRC_MEMORY_NSEC3_HASH_CACHE_H 1
+
+#include <dns/labelsequence.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+class NSEC3Data;
+
+/// \brief A cache of NSEC3 hash values of names.
+///
+/// With a large number of iterations the NSEC3 hash is expensive to
+/// calculate, and every negative answer from an NSEC3-signed zone needs
+/// a few of them: the closest encloser, the next closer name and the
+/// wildcard at the closest encloser.  Since the same names (the zone
+/// origin and its wildcard in particular) tend to appear in many
+/// answers, this class keeps the calculated values so they can be
+/// reused.
+///
+/// An entry is keyed by the name and the NSEC3 parameters (algorithm,
+/// iterations and salt) of the zone.  As the hash value only depends on
+/// these, an entry never becomes invalid, even if the zone is reloaded;
+/// if the parameters change the entries of the old ones are simply not
+/// used any more.  The names are in the zone so the entries of a zone
+/// can't be mixed up with those of another zone.
+///
+/// The cache has a fixed maximum number of entries; once it's full, the
+/// least recently used entry is recycled for a new name.
+///
+/// This class is thread safe, so it can be shared by the finders of an
+/// \c InMemoryClient used from multiple threads.  Large caches are split
+/// into stripes by the hash of the key, each with its own lock, so the
+/// threads rarely wait for each other.  The hash values are calculated
+/// without holding any lock.
+class NSEC3HashCache : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_entries is 0
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The maximum number of hash values in the cache.
+    explicit NSEC3HashCache(size_t max_entries);
+
+    /// \brief Destructor.
+    ~NSEC3HashCache();
+
+    /// \brief Return the NSEC3 hash values of names.
+    ///
+    /// The values found in the cache are returned from it; the others are
+    /// calculated together with \c dns::NSEC3Hash::calculateBatch() and
+    /// stored in the cache.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param nsec3_data The NSEC3 parameters of the zone.
+    /// \param labels The absolute label sequences of the names.
+    /// \param count The number of names.
+    /// \param hashes Base32hex-encoded hash values of the names are stored
+    /// here, in the same order as the names.
+    void calculate(const NSEC3Data& nsec3_data,
+                   const dns::LabelSequence* const labels[], size_t count,
+                   std::string hashes[]);
+
+    /// \brief Return the number of entries currently in the cache.
+    size_t getEntryCount() const;
+
+    /// \brief Return the maximum number of entries in the cache.
+    size_t getMaxEntries() const;
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_MEMORY_NSEC3_HASH_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -292,17 +292,22 @@ void
 RdataSet::destroy(util::MemorySegment& mem_sgmt, RdataSet* rdataset,
                   RRClass rrclass)
 {
+    const size_t size = rdataset->getMemorySize(rrclass);
+    rdataset->~RdataSet();
+    mem_sgmt.deallocate(rdataset, size);
+}
+
+size_t
+RdataSet::getMemorySize(RRClass rrclass) const {
     const size_t data_len =
-        RdataReader(rrclass, rdataset->type,
-                    reinterpret_cast<const uint8_t*>(rdataset->getDataBuf()),
-                    rdataset->getRdataCount(), rdataset->getSigRdataCount(),
+        RdataReader(rrclass, type,
+                    reinterpret_cast<const uint8_t*>(getDataBuf()),
+                    getRdataCount(), getSigRdataCount(),
                     &RdataReader::emptyNameAction,
                     &RdataReader::emptyDataAction).getSize();
     const size_t ext_rrsig_count_len =
-        rdataset->sig_rdata_count_ == MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
-    rdataset->~RdataSet();
-    mem_sgmt.deallocate(rdataset,
-                        sizeof(RdataSet) + ext_rrsig_count_len + data_len);
+        sig_rdata_count_ == MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    return (sizeof(RdataSet) + ext_rrsig_count_len + data_len);
 }
 
 namespace {
@@ -278,6 +278,16 @@ public:
     static void destroy(util::MemorySegment& mem_sgmt, RdataSet* rdataset,
                         dns::RRClass rrclass);
 
+    /// \brief Return the size of memory allocated for the \c RdataSet.
+    ///
+    /// Like \c destroy(), this method needs to know the RR class of the
+    /// \c RdataSet.
+    ///
+    /// \throw none
+    ///
+    /// \param rrclass The RR class of the \c RdataSet.
+    size_t getMemorySize(dns::RRClass rrclass) const;
+
     /// \brief Find \c RdataSet of given RR type from a list (const version).
     ///
     /// This function is a convenient shortcut for commonly used operation of
@@ -14,6 +14,8 @@
 
 #include "segment_object_holder.h"
 
+#include <util/threads/sync.h>
+
 #include <boost/lexical_cast.hpp>
 
 #include <cassert>
@@ -24,15 +26,25 @@ namespace datasrc {
 namespace memory {
 namespace detail {
 
+namespace {
+// Zone data can be loaded by several threads at once (each into its own
+// view of the segment), so the counter is protected.
+util::thread::Mutex index_mutex;
+}
+
 std::string
 getNextHolderName() {
     static uint64_t index = 0;
-    ++index;
+    uint64_t current;
+    {
+        util::thread::Mutex::Locker locker(index_mutex);
+        current = ++index;
+    }
     // in practice we should be able to assume this, uint64 is large
     // and should not overflow
-    assert(index != 0);
+    assert(current != 0);
     return ("Segment object holder auto name " +
-            boost::lexical_cast<std::string>(index));
+            boost::lexical_cast<std::string>(current));
 }
 
 }
@@ -15,6 +15,7 @@
 #include <util/memory_segment.h>
 
 #include <dns/name.h>
+#include <dns/labelsequence.h>
 #include <dns/rrclass.h>
 #include <dns/rdataclass.h>
 
@@ -23,6 +24,7 @@
 #include "rdataset.h"
 #include "rdata_serialization.h"
 #include "zone_data.h"
+#include "zone_name_index.h"
 #include "segment_object_holder.h"
 
 #include <boost/bind.hpp>
@@ -229,6 +231,9 @@ ZoneData::destroy(util::MemorySegment& mem_sgmt, ZoneData* zone_data,
     if (zone_data->nsec3_data_) {
         NSEC3Data::destroy(mem_sgmt, zone_data->nsec3_data_.get(), zone_class);
     }
+    if (zone_data->name_index_) {
+        ZoneNameIndex::destroy(mem_sgmt, zone_data->name_index_.get());
+    }
     mem_sgmt.deallocate(zone_data, sizeof(ZoneData));
 }
 
@@ -241,6 +246,10 @@ ZoneData::insertName(util::MemorySegment& mem_sgmt, const Name& name,
     // This should be ensured by the API:
     assert((result == ZoneTree::SUCCESS ||
             result == ZoneTree::ALREADYEXISTS) && node != NULL);
+
+    if (name_index_) {
+        name_index_->insert(mem_sgmt, LabelSequence(name), *node);
+    }
 }
 
 ZoneNode*
@@ -265,6 +274,18 @@ ZoneData::removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node) {
     if (node == getOriginNode()) {
         return;
     }
+    if (name_index_) {
+        // The tree also removes the empty upper nodes that are left without
+        // any lower node.  We don't know which of them will go, so we remove
+        // all empty ancestors from the index; it's harmless if a remaining
+        // one is missing there.
+        for (const ZoneNode* current = node;
+             current != NULL && current != getOriginNode() &&
+                 current->isEmpty();
+             current = current->getUpperNode()) {
+            name_index_->remove(current);
+        }
+    }
     zone_tree_->remove(mem_sgmt, node, nullDeleter);
 }
 
@@ -273,6 +294,83 @@ ZoneData::setMinTTL(uint32_t min_ttl_val) {
     setTTLInNetOrder(min_ttl_val, &min_ttl_);
 }
 
+namespace {
+// Add the memory used by the given tree, its nodes and their RdataSets
+// to the counters.  origin must be the name of the top node of the tree,
+// which is the smallest name in it.
+void
+addTreeMemoryUsage(const ZoneTree& tree, const LabelSequence& origin,
+                   RRClass rrclass, size_t* node_count, size_t* node_bytes,
+                   size_t* rdataset_count, size_t* rdataset_bytes)
+{
+    *node_bytes += sizeof(ZoneTree);
+
+    ZoneChain node_path;
+    const ZoneNode* node = NULL;
+    const ZoneTree::Result result =
+        tree.find<void*>(origin, &node, node_path, NULL, NULL);
+    assert(result == ZoneTree::EXACTMATCH);
+    for (; node != NULL; node = tree.nextNode(node_path)) {
+        ++*node_count;
+        *node_bytes += node->getMemorySize();
+        for (const RdataSet* rdataset = node->getData();
+             rdataset != NULL;
+             rdataset = rdataset->getNext()) {
+            ++*rdataset_count;
+            *rdataset_bytes += rdataset->getMemorySize(rrclass);
+        }
+    }
+}
+}
+
+ZoneDataMemoryUsage
+ZoneData::getMemoryUsage(RRClass zone_class) const {
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    const LabelSequence origin = origin_node_->getAbsoluteLabels(labels_buf);
+
+    ZoneDataMemoryUsage usage;
+    usage.node_bytes = sizeof(ZoneData);
+    addTreeMemoryUsage(*zone_tree_, origin, zone_class, &usage.node_count,
+                       &usage.node_bytes, &usage.rdataset_count,
+                       &usage.rdataset_bytes);
+    if (nsec3_data_) {
+        size_t count = 0;       // NSEC3 nodes and RdataSets aren't counted
+        usage.nsec3_bytes = sizeof(NSEC3Data) + 1 +
+            nsec3_data_->getSaltLen();
+        addTreeMemoryUsage(nsec3_data_->getNSEC3Tree(), origin, zone_class,
+                           &count, &usage.nsec3_bytes, &count,
+                           &usage.nsec3_bytes);
+    }
+    if (name_index_) {
+        usage.name_index_bytes = name_index_->getMemorySize();
+    }
+    return (usage);
+}
+
+void
+ZoneData::enableNameIndex(util::MemorySegment& mem_sgmt) {
+    // Both allocations can throw MemorySegmentGrown, but leave this object
+    // consistent if they do.  Once the table is large enough, adding the
+    // names doesn't allocate any more.
+    if (!name_index_) {
+        name_index_ = ZoneNameIndex::create(mem_sgmt);
+    }
+    name_index_->reserve(mem_sgmt, zone_tree_->getNodeCount());
+
+    const ZoneTree& tree = *zone_tree_;
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    ZoneChain node_path;
+    const ZoneNode* node = NULL;
+    const ZoneTree::Result result =
+        tree.find<void*>(origin_node_->getAbsoluteLabels(labels_buf), &node,
+                         node_path, NULL, NULL);
+    assert(result == ZoneTree::EXACTMATCH);
+    for (; node != NULL; node = tree.nextNode(node_path)) {
+        name_index_->insert(mem_sgmt, node->getAbsoluteLabels(labels_buf),
+                            node);
+    }
+}
+
 } // namespace memory
 } // namespace datasrc
 } // datasrc isc
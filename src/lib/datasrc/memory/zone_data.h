@@ -45,6 +45,8 @@ typedef DomainTree<RdataSet> ZoneTree;
 typedef DomainTreeNode<RdataSet> ZoneNode;
 typedef DomainTreeNodeChain<RdataSet> ZoneChain;
 
+class ZoneNameIndex;
+
 /// \brief NSEC3 data for a DNS zone.
 ///
 /// This class encapsulates a set of NSEC3 related data for a zone
@@ -220,6 +222,11 @@ public:
     /// \param node A pointer to \c ZoneNode pointer in which the created or
     /// found node for the name is stored.  Must not be NULL (the method does
     /// not check that condition).
+    ///
+    /// If the zone has a name index (see \c enableNameIndex()), the name is
+    /// also added to it.  In that case \c util::MemorySegmentGrown can be
+    /// thrown after the name has been added to the tree; calling this
+    /// method again completes the insertion.
     void insertName(util::MemorySegment& mem_sgmt, const dns::Name& name,
                     ZoneNode** node);
 
@@ -263,6 +270,30 @@ private:
     }
 };
 
+/// \brief Memory usage of a zone's data.
+///
+/// This is the result of \c ZoneData::getMemoryUsage().  All sizes are
+/// in bytes, and they are the sizes requested from the memory segment;
+/// any overhead of the segment implementation is not included.
+struct ZoneDataMemoryUsage {
+    ZoneDataMemoryUsage() :
+        node_count(0), node_bytes(0), rdataset_count(0), rdataset_bytes(0),
+        nsec3_bytes(0), name_index_bytes(0)
+    {}
+
+    /// \brief Return the total memory used by the zone's data.
+    size_t getTotal() const {
+        return (node_bytes + rdataset_bytes + nsec3_bytes + name_index_bytes);
+    }
+
+    size_t node_count;          ///< Number of nodes in the zone tree
+    size_t node_bytes;          ///< Zone tree, its nodes, and the ZoneData
+    size_t rdataset_count;      ///< Number of RdataSets in the zone tree
+    size_t rdataset_bytes;      ///< RdataSets in the zone tree
+    size_t nsec3_bytes;         ///< NSEC3Data, including its tree
+    size_t name_index_bytes;    ///< Name index (see ZoneNameIndex)
+};
+
 /// \brief DNS zone data.
 ///
 /// This class encapsulates the content of a DNS zone (which is essentially a
@@ -548,6 +579,29 @@ public:
     /// \throw none
     const NSEC3Data* getNSEC3Data() const { return (nsec3_data_.get()); }
 
+    /// \brief Return the hash index of the zone's names.
+    ///
+    /// This returns NULL unless \c enableNameIndex() has been called.
+    /// See \c ZoneNameIndex for how to use the index.
+    ///
+    /// \throw none
+    const ZoneNameIndex* getNameIndex() const { return (name_index_.get()); }
+
+    /// \brief Return the memory usage of the zone's data.
+    ///
+    /// This method walks through the entire zone, so it takes time
+    /// proportional to the size of the zone.  It's intended for
+    /// administrative purposes, and shouldn't be called in a performance
+    /// sensitive path.
+    ///
+    /// Like \c destroy(), this method needs to know the RR class of the
+    /// zone.
+    ///
+    /// \throw none
+    ///
+    /// \param zone_class The RR class of the zone.
+    ZoneDataMemoryUsage getMemoryUsage(dns::RRClass zone_class) const;
+
     /// \brief Return a pointer to the zone's minimum TTL data.
     ///
     /// The returned pointer points to a memory region that is valid at least
@@ -709,12 +763,31 @@ public:
     /// \param min_ttl_val The minimum TTL value as unsigned 32-bit integer
     /// in the host byte order.
     void setMinTTL(uint32_t min_ttl_val);
+
+    /// \brief Create the hash index of the zone's names.
+    ///
+    /// This method creates a \c ZoneNameIndex for the names currently in
+    /// the zone; subsequent calls to \c insertName() and \c removeNode()
+    /// keep it up to date.  If the index already exists, this method makes
+    /// sure it contains all names of the zone.
+    ///
+    /// If \c util::MemorySegmentGrown is thrown, the zone data and the
+    /// index (if created) are still valid, and the caller can retry the
+    /// call with the possibly relocated zone data.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt Memory segment in which the zone data is allocated.
+    void enableNameIndex(util::MemorySegment& mem_sgmt);
     //@}
 
 private:
     const boost::interprocess::offset_ptr<ZoneTree> zone_tree_;
     const boost::interprocess::offset_ptr<ZoneNode> origin_node_;
     boost::interprocess::offset_ptr<NSEC3Data> nsec3_data_;
+    boost::interprocess::offset_ptr<ZoneNameIndex> name_index_;
     uint32_t min_ttl_;
 };
 
@@ -20,6 +20,7 @@
 #include <datasrc/memory/util_internal.h>
 #include <datasrc/memory/rrset_collection.h>
 #include <datasrc/memory/treenode_rrset.h>
+#include <datasrc/memory/zone_snapshot.h>
 #include <datasrc/client.h>
 
 #include <dns/labelsequence.h>
@@ -35,6 +36,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <map>
+#include <vector>
 
 using namespace bundy::dns;
 using namespace bundy::dns::rdata;
@@ -279,7 +281,7 @@ public:
         mem_sgmt_(mem_sgmt), rrclass_(rrclass), zone_name_(zone_name),
         old_data_(old_data),
         old_serial_(old_serial ? new dns::Serial(*old_serial) : NULL),
-        loaded_data_(NULL)
+        loaded_data_(NULL), name_index_(false)
     {
         validateOldData(zone_name, old_data);
     }
@@ -303,6 +305,11 @@ public:
         return (loaded_data_);
     }
 
+    // Whether to build the name index for newly created zone data.
+    void setNameIndex(bool name_index) {
+        name_index_ = name_index;
+    }
+
 protected:
     bool doLoadCommon(size_t count_limit);
 
@@ -319,6 +326,11 @@ protected:
                     holder->set(zone_data);
                 } else {
                     holder->set(ZoneData::create(mem_sgmt_, zone_name_));
+                    if (name_index_) {
+                        // The index is empty at this point; it's filled
+                        // as the names are added.
+                        holder->get()->enableNameIndex(mem_sgmt_);
+                    }
                 }
                 data_holder_.swap(holder);
                 break;
@@ -350,6 +362,7 @@ protected:
     boost::scoped_ptr<SegmentObjectHolder<ZoneData, RRClass> > data_holder_;
     boost::scoped_ptr<ZoneDataUpdaterHelper> update_helper_;
     ZoneData* loaded_data_;
+    bool name_index_;
 };
 
 void
@@ -430,10 +443,10 @@ class MasterFileLoader : public ZoneDataLoader::ZoneDataLoaderImpl {
 public:
     MasterFileLoader(util::MemorySegment& mem_sgmt, const dns::RRClass& rrclass,
                      const dns::Name& zone_name, const std::string& zone_file,
-                     ZoneData* old_data) :
+                     ZoneData* old_data, size_t parse_threads) :
         ZoneDataLoader::ZoneDataLoaderImpl(mem_sgmt, rrclass, zone_name,
                                            old_data, NULL),
-        zone_file_(zone_file)
+        zone_file_(zone_file), parse_threads_(parse_threads)
     {}
     virtual ~MasterFileLoader() {}
     virtual bool isDataReused() const { return (false); }
@@ -465,6 +478,9 @@ protected:
                                                               rrclass_,
                                                               &load_ok_),
                                   rrcollator_->getCallback()));
+        if (parse_threads_ > 1) {
+            master_loader_->setThreadCount(parse_threads_);
+        }
     }
 
     virtual bool updateRRsets(size_t count_limit) {
@@ -482,6 +498,7 @@ protected:
 private:
     bool load_ok_; // we actually don't use it; only need a placeholder
     const std::string zone_file_;
+    const size_t parse_threads_;
     boost::scoped_ptr<dns::RRCollator> rrcollator_;
     boost::scoped_ptr<dns::MasterLoader> master_loader_;
 };
@@ -515,6 +532,42 @@ private:
     ZoneIteratorPtr iterator_;
 };
 
+// Zone snapshot based loader implementation.  The RRsets come in the order
+// they were written, like those of a zone iterator.
+class SnapshotLoader : public ZoneDataLoader::ZoneDataLoaderImpl {
+public:
+    SnapshotLoader(util::MemorySegment& mem_sgmt, const dns::RRClass& rrclass,
+                   const dns::Name& zone_name, const std::string& snapshot,
+                   ZoneData* old_data) :
+        ZoneDataLoader::ZoneDataLoaderImpl(mem_sgmt, rrclass, zone_name,
+                                           old_data, NULL),
+        snapshot_(snapshot)
+    {}
+    virtual ~SnapshotLoader() {}
+    virtual bool isDataReused() const { return (false); }
+
+protected:
+    virtual bool updateRRsets(size_t count_limit) {
+        // The file is read (and verified) at the beginning of the load,
+        // so errors in it are reported as load errors.
+        if (!reader_) {
+            reader_.reset(new ZoneSnapshotReader(snapshot_, zone_name_,
+                                                 rrclass_));
+        }
+        size_t count = 0;
+        ConstRRsetPtr rrset;
+        while (count < count_limit &&
+               (rrset = reader_->getNextRRset()) != NULL) {
+            update_helper_->updateFromLoad(rrset, ZoneDataUpdaterHelper::ADD);
+            count++;
+        }
+        return (!rrset);
+    }
+private:
+    const std::string snapshot_;
+    boost::scoped_ptr<ZoneSnapshotReader> reader_;
+};
+
 // A simple thin wrapper in case the load can be skipped because there's no
 // change in the SOA serial.
 class ReuseLoader : public ZoneDataLoader::ZoneDataLoaderImpl {
@@ -549,6 +602,15 @@ protected:
 // modifies the existing zone data, rather than creating a new one and replace
 // it with the old on completion.  So any intermediate failure will invalidate
 // the zone data.
+//
+// Since the modification has to be done in commitDiffs(), which is usually
+// called in a critical section, doLoad() does everything else beforehand:
+// it reads the entire diff sequence from the journal, checks its structure,
+// and reduces it to the net changes from the current version.  A change
+// that is reverted later in the sequence (the SOA of each intermediate
+// version, or RRSIGs that are replaced and then replaced again) cancels out
+// and never touches the zone data.  A broken sequence is thus detected in
+// doLoad(), while the current zone data are still intact and in use.
 class JournalLoader : public ZoneDataLoader::ZoneDataLoaderImpl {
 public:
     JournalLoader(util::MemorySegment& mem_sgmt,
@@ -568,7 +630,7 @@ public:
     virtual ~JournalLoader() {}
     virtual bool isDataReused() const { return (true); }
     virtual bool doLoad(size_t) {
-        saveDiffs();
+        readDiffs();
         loaded_data_ = old_data_;
         return (true);
     }
@@ -591,84 +653,145 @@ public:
     }
 
 protected:
-    // The installer called for ZoneDataLoader using a zone journal reader.
-    // It performs some minimal sanity checks on the sequence of data, but
-    // the basic assumption is that any invalid data mean implementation defect
-    // (not bad user input) and shouldn't happen anyway.
+    // Apply the net changes prepared in readDiffs(): all removals first,
+    // then all additions, so the intermediate state never has both the old
+    // and the new version of, e.g., a CNAME.  Both lists are sorted by
+    // owner name, so the helper handles all changes to a node at once.
     virtual bool updateRRsets(size_t) {
+        BOOST_FOREACH(const RRsetPtr& rrset, deletions_) {
+            update_helper_->updateFromLoad(rrset,
+                                           ZoneDataUpdaterHelper::DELETE);
+        }
+        BOOST_FOREACH(const RRsetPtr& rrset, additions_) {
+            update_helper_->updateFromLoad(rrset,
+                                           ZoneDataUpdaterHelper::ADD);
+        }
+        return (true);
+    }
+
+private:
+    // Identifies a single RR in the diff sequence.  The covered type is
+    // part of the key so RRSIGs covering different types are never merged
+    // into one RRset.  The TTL is part of it too, so a TTL change (delete
+    // and re-add of the same RDATA with a different TTL) is kept.
+    struct DiffRR {
+        DiffRR(const AbstractRRset& rrset, const ConstRdataPtr& rdata_param) :
+            name(rrset.getName()), type(rrset.getType()),
+            covered(type == RRType::RRSIG() ?
+                    dynamic_cast<const generic::RRSIG&>(*rdata_param).
+                    typeCovered() : type),
+            ttl(rrset.getTTL()), rdata(rdata_param)
+        {}
+
+        bool operator<(const DiffRR& other) const {
+            const int ncmp = name.compare(other.name).getOrder();
+            if (ncmp != 0) {
+                return (ncmp < 0);
+            }
+            if (type != other.type) {
+                return (type < other.type);
+            }
+            if (covered != other.covered) {
+                return (covered < other.covered);
+            }
+            if (ttl != other.ttl) {
+                return (ttl < other.ttl);
+            }
+            return (rdata->compare(*other.rdata) < 0);
+        }
+
+        // Whether this RR can be in the same RRset as the other one.
+        bool sameRRset(const DiffRR& other) const {
+            return (name == other.name && type == other.type &&
+                    covered == other.covered && ttl == other.ttl);
+        }
+
+        const Name name;
+        const RRType type;
+        const RRType covered;
+        const RRTTL ttl;
+        const ConstRdataPtr rdata;
+    };
+    // Each RR maps to the number of times it's added minus the number of
+    // times it's deleted in the sequence.
+    typedef std::map<DiffRR, int> DiffCountMap;
+
+    void readDiffs() {
         enum DIFF_MODE {INIT, ADD, DELETE} mode = INIT;
+        DiffCountMap counts;
+        size_t diff_count = 0;
         ConstRRsetPtr rrset;
-        std::vector<ConstRRsetPtr>::const_iterator it = saved_diffs_.begin();
-        const std::vector<ConstRRsetPtr>::const_iterator it_end =
-            saved_diffs_.end();
-        while ((rrset = nextDiff(it, it_end))) {
+        while ((rrset = jnl_reader_->getNextDiff())) {
+            ++diff_count;
             if (rrset->getType() == RRType::SOA()) {
                 mode = (mode == INIT || mode == ADD) ? DELETE : ADD;
             } else if (mode == INIT) {
                 // diff sequence doesn't begin with SOA. It means broken journal
                 // reader implementation.
-                bundy_throw(bundy::Unexpected,
+                bundy_throw(ZoneValidationError,
                             "broken journal reader: diff not begin with SOA");
             }
-            update_helper_->updateFromLoad(rrset,
-                                           (mode == ADD) ?
-                                           ZoneDataUpdaterHelper::ADD :
-                                           ZoneDataUpdaterHelper::DELETE);
+            for (RdataIteratorPtr rit = rrset->getRdataIterator();
+                 !rit->isLast(); rit->next()) {
+                const ConstRdataPtr rdata =
+                    createRdata(rrset->getType(), rrset->getClass(),
+                                rit->getCurrent());
+                counts[DiffRR(*rrset, rdata)] += (mode == ADD) ? 1 : -1;
+            }
+        }
+        jnl_reader_.reset();
+        if (diff_count == 0) {
+            // In our expected form of diff sequence, it shouldn't be empty,
+            // since there should be at least begin and end SOAs.
+            // Eliminating this case at this point makes the later
+            // processing easier.
+            bundy_throw(ZoneValidationError,
+                        "empty diff sequence is provided for load");
         }
         if (mode != ADD) {
             // Diff must end in the add mode (there should at least be one
             // add for the final SOA)
-            bundy_throw(bundy::Unexpected, "broken journal reader: incomplete");
+            bundy_throw(ZoneValidationError,
+                        "broken journal reader: incomplete");
         }
 
-        return (true);
-    }
-
-private:
-    void saveDiffs() {
-        int count = 0;
-        ConstRRsetPtr rrset;
-        while (count++ < MAX_SAVED_DIFFS_ &&
-               (rrset = jnl_reader_->getNextDiff())) {
-            saved_diffs_.push_back(rrset);
-        }
-        if (!rrset) {
-            jnl_reader_.reset();
-            if (saved_diffs_.empty()) {
-                // In our expected form of diff sequence, it shouldn't be empty,
-                // since there should be at least begin and end SOAs.
-                // Eliminating this case at this point makes the later
-                // processing easier.
-                bundy_throw(ZoneValidationError,
-                            "empty diff sequence is provided for load");
+        size_t change_count = 0;
+        const DiffRR* last_deletion = NULL;
+        const DiffRR* last_addition = NULL;
+        BOOST_FOREACH(const DiffCountMap::value_type& entry, counts) {
+            // A valid sequence never adds an RR that exists or deletes one
+            // that doesn't, so the count is 1, 0 or -1 here.  We only look
+            // at the sign; any inconsistency is left to the updater.
+            if (entry.second < 0) {
+                addChange(entry.first, last_deletion, deletions_);
+                ++change_count;
+            } else if (entry.second > 0) {
+                addChange(entry.first, last_addition, additions_);
+                ++change_count;
             }
         }
+        LOG_DEBUG(logger, DBG_TRACE_DETAILED,
+                  DATASRC_MEMORY_LOAD_JOURNAL_DIFFS).arg(diff_count).
+            arg(zone_name_).arg(rrclass_).arg(change_count);
     }
 
-    ConstRRsetPtr
-    nextDiff(std::vector<ConstRRsetPtr>::const_iterator& it,
-             const std::vector<ConstRRsetPtr>::const_iterator& it_end)
+    // Add an RR to a list of changes.  As the map is sorted, RRs of the same
+    // RRset come in a row, so they are merged into the last RRset of the
+    // list.
+    void addChange(const DiffRR& rr, const DiffRR*& last_rr,
+                   std::vector<RRsetPtr>& changes)
     {
-        ConstRRsetPtr next_diff;    // null by default
-        if (it != it_end) {
-            next_diff = *it;
-            ++it;
-        } else if (jnl_reader_) {
-            next_diff = jnl_reader_->getNextDiff();
+        if (!last_rr || !last_rr->sameRRset(rr)) {
+            changes.push_back(RRsetPtr(new RRset(rr.name, rrclass_, rr.type,
+                                                 rr.ttl)));
         }
-        return (next_diff);
+        changes.back()->addRdata(rr.rdata);
+        last_rr = &rr;
     }
 
     ZoneJournalReaderPtr jnl_reader_;
-
-    // To minimize the risk of hitting an exception from the journal reader
-    // in commitDiffs(), we save up to MAX_SAVED_DIFFS_ diff RRs in the
-    // load() phase.  While it doesn't guarantee a success in commitDiffs()
-    // (if it fails we fall back to invalidate the zone and reload the entire
-    // zone), this should work for many cases with small updates (like in
-    // dynamic updates).
-    static const unsigned int MAX_SAVED_DIFFS_ = 100;
-    std::vector<ConstRRsetPtr> saved_diffs_;
+    std::vector<RRsetPtr> deletions_;
+    std::vector<RRsetPtr> additions_;
 };
 }
 
@@ -676,21 +799,30 @@ ZoneDataLoader::ZoneDataLoader(util::MemorySegment& mem_sgmt,
                                const dns::RRClass& rrclass,
                                const dns::Name& zone_name,
                                const std::string& zone_file,
-                               ZoneData* old_data) :
+                               ZoneData* old_data, bool name_index,
+                               size_t parse_threads) :
     impl_(NULL)                 // defer until logging to avoid leak
 {
-    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_FILE).
-        arg(zone_name).arg(rrclass).arg(zone_file);
-
-    impl_ = new MasterFileLoader(mem_sgmt, rrclass, zone_name, zone_file,
-                                 old_data);
+    if (isZoneSnapshot(zone_file)) {
+        LOG_DEBUG(logger, DBG_TRACE_BASIC,
+                  DATASRC_MEMORY_MEM_LOAD_FROM_SNAPSHOT).
+            arg(zone_name).arg(rrclass).arg(zone_file);
+        impl_ = new SnapshotLoader(mem_sgmt, rrclass, zone_name, zone_file,
+                                   old_data);
+    } else {
+        LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_FILE).
+            arg(zone_name).arg(rrclass).arg(zone_file);
+        impl_ = new MasterFileLoader(mem_sgmt, rrclass, zone_name, zone_file,
+                                     old_data, parse_threads);
+    }
+    impl_->setNameIndex(name_index);
 }
 
 ZoneDataLoader::ZoneDataLoader(util::MemorySegment& mem_sgmt,
                                const dns::RRClass& rrclass,
                                const dns::Name& zone_name,
                                const DataSourceClient& datasrc_client,
-                               ZoneData* old_data) :
+                               ZoneData* old_data, bool name_index) :
     impl_(NULL)
 {
     const std::string& dsrc_name = datasrc_client.getDataSourceName();
@@ -740,6 +872,7 @@ ZoneDataLoader::ZoneDataLoader(util::MemorySegment& mem_sgmt,
     }
     impl_ = new IteratorLoader(mem_sgmt, rrclass, zone_name, iterator,
                                old_data, old_serial.get());
+    impl_->setNameIndex(name_index);
 }
 
 ZoneDataLoader::~ZoneDataLoader() {
@@ -56,13 +56,21 @@ public:
     /// \param rrclass The RRClass.
     /// \param zone_name The name of the zone that is being loaded.
     /// \param zone_file Filename which contains the zone data for \c zone_name.
+    /// It's either a master file or a zone snapshot (see
+    /// \c ZoneSnapshotWriter); snapshots are recognized by their file name
+    /// (see \c isZoneSnapshot()).
     /// \param old_data If non-NULL, zone data currently being used.  Also
     /// in that case, its origin name must be equal to \c zone_name.
+    /// \param name_index If true, newly created zone data will have the
+    /// hash index of names (see \c ZoneData::enableNameIndex()).
+    /// \param parse_threads The number of threads to parse a master file
+    /// with (see \c dns::MasterLoader::setThreadCount()).
     ZoneDataLoader(util::MemorySegment& mem_sgmt,
                    const dns::RRClass& rrclass,
                    const dns::Name& zone_name,
                    const std::string& zone_file,
-                   ZoneData* old_data = NULL);
+                   ZoneData* old_data = NULL, bool name_index = false,
+                   size_t parse_threads = 1);
 
     /// \brief Constructor for loading from a given data source.
     ///
@@ -77,7 +85,7 @@ public:
                    const dns::RRClass& rrclass,
                    const dns::Name& zone_name,
                    const DataSourceClient& datasrc_client,
-                   ZoneData* old_data = NULL);
+                   ZoneData* old_data = NULL, bool name_index = false);
 
     /// Destructor.
     virtual ~ZoneDataLoader();
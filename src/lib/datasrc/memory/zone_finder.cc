@@ -16,6 +16,7 @@
 #include <datasrc/memory/domaintree.h>
 #include <datasrc/memory/treenode_rrset.h>
 #include <datasrc/memory/rdata_serialization.h>
+#include <datasrc/memory/zone_name_index.h>
 
 #include <datasrc/zone_finder.h>
 #include <datasrc/exceptions.h>
@@ -81,6 +82,10 @@ public:
 using internal::ZoneFinderResultContext;
 
 namespace {
+/// The number of names (from the query name up) whose NSEC3 hashes
+/// a recursive findNSEC3() calculates at once.
+const unsigned int NSEC3_HASH_BATCH_LEVELS = 2;
+
 /// Conceptual RRset in the form of a pair of zone node and RdataSet.
 ///
 /// In this implementation, the owner name of an RRset is derived from the
@@ -475,6 +480,20 @@ FindNodeResult findNode(const ZoneData& zone_data,
                         ZoneFinder::FindOptions options,
                         bool out_of_zone_ok = false)
 {
+    // If the zone has a name index, try it first.  An exact match there
+    // gives the same result as the tree search unless the search would pass
+    // a zone cut or DNAME on the way, or the node is empty (we'd then need
+    // the node chain to find the NSEC).  Leave these to the tree search.
+    const ZoneNameIndex* const name_index = zone_data.getNameIndex();
+    if (name_index != NULL) {
+        bool callback_above = false;
+        const ZoneNode* const node = name_index->find(name_labels,
+                                                      &callback_above);
+        if (node != NULL && !callback_above && !node->isEmpty()) {
+            return (FindNodeResult(ZoneFinder::SUCCESS, node, NULL));
+        }
+    }
+
     const ZoneNode* node = NULL;
     FindState state((options & ZoneFinder::FIND_GLUE_OK) != 0);
 
@@ -917,6 +936,24 @@ InMemoryZoneFinder::findInternal(const bundy::dns::Name& name,
                              options, wild));
 }
 
+void
+InMemoryZoneFinder::calculateNSEC3Hashes(const LabelSequence* const labels[],
+                                         size_t count,
+                                         std::string hashes[]) const
+{
+    const NSEC3Data* nsec3_data = zone_data_.getNSEC3Data();
+    if (nsec3_hash_cache_ != NULL) {
+        nsec3_hash_cache_->calculate(*nsec3_data, labels, count, hashes);
+    } else {
+        const boost::scoped_ptr<NSEC3Hash> hash
+            (NSEC3Hash::create(nsec3_data->hashalg,
+                               nsec3_data->iterations,
+                               nsec3_data->getSaltData(),
+                               nsec3_data->getSaltLen()));
+        hash->calculateBatch(labels, count, hashes);
+    }
+}
+
 bundy::datasrc::ZoneFinder::FindNSEC3Result
 InMemoryZoneFinder::findNSEC3(const bundy::dns::Name& name, bool recursive) {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_FINDNSEC3).arg(name).
@@ -972,11 +1009,10 @@ InMemoryZoneFinder::findNSEC3(const bundy::dns::Name& name, bool recursive) {
                   origin_ls << "/" << getClass());
     }
 
-    const boost::scoped_ptr<NSEC3Hash> hash
-        (NSEC3Hash::create(nsec3_data->hashalg,
-                           nsec3_data->iterations,
-                           nsec3_data->getSaltData(),
-                           nsec3_data->getSaltLen()));
+    // The hashes of the names from the query name up to the origin,
+    // indexed by the number of labels stripped from the query name.
+    // They are calculated in batches as the loop below needs them.
+    std::vector<std::string> hlabels(qlabels - olabels + 1);
 
     // Examine all names from the query name to the origin name, stripping
     // the deepest label one by one, until we find a name that has a matching
@@ -984,7 +1020,44 @@ InMemoryZoneFinder::findNSEC3(const bundy::dns::Name& name, bool recursive) {
     for (unsigned int labels = qlabels; labels >= olabels;
          --labels, name_ls.stripLeft(1))
     {
-        const std::string hlabel = hash->calculate(name_ls);
+        const unsigned int level = qlabels - labels;
+        if (hlabels[level].empty()) {
+            // In the recursive mode, the closest encloser is usually found
+            // within a couple of levels, so we hash that many names at once.
+            // With a cache we also hash the wildcards at the names above
+            // the query name: the caller will need the one at the closest
+            // encloser, and it'll then be found in the cache.
+            const unsigned int last_level = !recursive ? level + 1 :
+                std::min(level + NSEC3_HASH_BATCH_LEVELS,
+                         static_cast<unsigned int>(hlabels.size()));
+            std::vector<Name> wildcards;
+            if (recursive && nsec3_hash_cache_ != NULL) {
+                for (unsigned int l = std::max(level, 1U); l < last_level;
+                     ++l) {
+                    wildcards.push_back(Name("*").concatenate(name.split(l)));
+                }
+            }
+            std::vector<LabelSequence> batch;
+            LabelSequence batch_ls(name_ls);
+            for (unsigned int l = level; l < last_level; ++l) {
+                batch.push_back(batch_ls);
+                batch_ls.stripLeft(1);
+            }
+            for (size_t i = 0; i < wildcards.size(); ++i) {
+                batch.push_back(LabelSequence(wildcards[i]));
+            }
+            std::vector<const LabelSequence*> batch_labels;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                batch_labels.push_back(&batch[i]);
+            }
+            std::vector<std::string> batch_hashes(batch.size());
+            calculateNSEC3Hashes(&batch_labels[0], batch.size(),
+                                 &batch_hashes[0]);
+            for (unsigned int l = level; l < last_level; ++l) {
+                hlabels[l] = batch_hashes[l - level];
+            }
+        }
+        const std::string& hlabel = hlabels[level];
 
         LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_FINDNSEC3_TRYHASH).
             arg(name).arg(labels).arg(hlabel);
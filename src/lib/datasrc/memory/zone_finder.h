@@ -17,11 +17,13 @@
 
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/treenode_rrset.h>
+#include <datasrc/memory/nsec3_hash_cache.h>
 
 #include <datasrc/zone_finder.h>
 #include <dns/name.h>
 #include <dns/rrset.h>
 #include <dns/rrtype.h>
+#include <dns/labelsequence.h>
 
 #include <string>
 
@@ -48,10 +50,15 @@ public:
     ///
     /// \param zone_data The ZoneData containing the zone.
     /// \param rrclass The RR class of the zone
+    /// \param nsec3_hash_cache If non NULL, NSEC3 hash values are looked
+    /// up in and stored to this cache.  It must be valid as long as the
+    /// finder is used.
     InMemoryZoneFinder(const ZoneData& zone_data,
-                       const bundy::dns::RRClass& rrclass) :
+                       const bundy::dns::RRClass& rrclass,
+                       NSEC3HashCache* nsec3_hash_cache = NULL) :
         zone_data_(zone_data),
-        rrclass_(rrclass)
+        rrclass_(rrclass),
+        nsec3_hash_cache_(nsec3_hash_cache)
     {}
 
     /// \brief Find an RRset in the datasource
@@ -109,8 +116,14 @@ private:
         const FindOptions options =
         FIND_DEFAULT);
 
+    /// Calculate the NSEC3 hashes of the names, through the cache if
+    /// there's one.
+    void calculateNSEC3Hashes(const bundy::dns::LabelSequence* const labels[],
+                              size_t count, std::string hashes[]) const;
+
     const ZoneData& zone_data_;
     const bundy::dns::RRClass rrclass_;
+    NSEC3HashCache* const nsec3_hash_cache_;
 };
 
 } // namespace memory
@@ -0,0 +1,248 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_name_index.h>
+
+#include <cassert>
+#include <ctime>
+#include <new>                  // for the placement new
+
+using namespace bundy::dns;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+struct ZoneNameIndex::Entry {
+    Entry() : hash(0) {}
+    boost::interprocess::offset_ptr<const ZoneNode> node; // NULL if unused
+    uint32_t hash;
+};
+
+namespace {
+// The smallest table size.  The table is kept at most half full.
+const uint32_t MIN_CAPACITY = 16;
+
+// Check whether the absolute name of the node is equal to the given name.
+// The node only has its own labels, so we compare them with the
+// corresponding part of the name on the way up to the top of the tree.
+// At the same time we record whether any of the ancestors has a callback.
+bool
+matchNode(const ZoneNode* const node, const LabelSequence& name,
+          bool* callback_above)
+{
+    LabelSequence remaining(name);
+    bool callback = false;
+    for (const ZoneNode* current = node; current != NULL; ) {
+        const LabelSequence labels = current->getLabels();
+        const size_t count = labels.getLabelCount();
+        const size_t remaining_count = remaining.getLabelCount();
+        if (count > remaining_count) {
+            return (false);
+        }
+        LabelSequence part(remaining);
+        if (count < remaining_count) {
+            part.stripRight(remaining_count - count);
+        }
+        if (!part.equals(labels)) {
+            return (false);
+        }
+        if (current != node && current->getFlag(ZoneNode::FLAG_CALLBACK)) {
+            callback = true;
+        }
+
+        const ZoneNode* const upper = current->getUpperNode();
+        if (upper == NULL) {
+            if (count != remaining_count) {
+                return (false);
+            }
+        } else {
+            if (count == remaining_count) {
+                return (false);
+            }
+            remaining.stripLeft(count);
+        }
+        current = upper;
+    }
+    if (callback_above != NULL) {
+        *callback_above = callback;
+    }
+    return (true);
+}
+}
+
+ZoneNameIndex::ZoneNameIndex(uint32_t seed) :
+    entries_(NULL), capacity_(0), count_(0), seed_(seed)
+{}
+
+ZoneNameIndex*
+ZoneNameIndex::create(util::MemorySegment& mem_sgmt) {
+    void* p = mem_sgmt.allocate(sizeof(ZoneNameIndex));
+    // The seed makes the hash values less predictable.  It's part of the
+    // index so all users of a shared index agree on the hash.
+    const uint32_t seed = static_cast<uint32_t>(std::time(NULL)) ^
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(p));
+    return (new(p) ZoneNameIndex(seed));
+}
+
+void
+ZoneNameIndex::destroy(util::MemorySegment& mem_sgmt, ZoneNameIndex* index) {
+    if (index->entries_) {
+        mem_sgmt.deallocate(index->entries_.get(),
+                            sizeof(Entry) * index->capacity_);
+    }
+    mem_sgmt.deallocate(index, sizeof(ZoneNameIndex));
+}
+
+uint32_t
+ZoneNameIndex::getHash(const LabelSequence& name) const {
+    return (static_cast<uint32_t>(name.getFullHash(false, seed_)));
+}
+
+void
+ZoneNameIndex::reserve(util::MemorySegment& mem_sgmt, size_t count) {
+    uint32_t new_capacity = MIN_CAPACITY;
+    while (new_capacity < count * 2) {
+        new_capacity *= 2;
+    }
+    if (new_capacity <= capacity_) {
+        return;
+    }
+
+    // Allocate the new table first; if it throws nothing has changed.
+    Entry* new_entries = static_cast<Entry*>(
+        mem_sgmt.allocate(sizeof(Entry) * new_capacity));
+    for (uint32_t i = 0; i < new_capacity; ++i) {
+        new(&new_entries[i]) Entry();
+    }
+    Entry* const old_entries = entries_.get();
+    const uint32_t old_capacity = capacity_;
+    rehash(new_entries, new_capacity);
+    if (old_entries != NULL) {
+        mem_sgmt.deallocate(old_entries, sizeof(Entry) * old_capacity);
+    }
+}
+
+void
+ZoneNameIndex::rehash(Entry* new_entries, uint32_t new_capacity) {
+    const uint32_t mask = new_capacity - 1;
+    for (uint32_t i = 0; i < capacity_; ++i) {
+        const Entry& entry = entries_[i];
+        if (!entry.node) {
+            continue;
+        }
+        uint32_t pos = entry.hash & mask;
+        while (new_entries[pos].node) {
+            pos = (pos + 1) & mask;
+        }
+        new_entries[pos].node = entry.node;
+        new_entries[pos].hash = entry.hash;
+    }
+    entries_ = new_entries;
+    capacity_ = new_capacity;
+}
+
+const ZoneNameIndex::Entry*
+ZoneNameIndex::findEntry(const ZoneNode* node, uint32_t hash) const {
+    if (capacity_ == 0) {
+        return (NULL);
+    }
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t pos = hash & mask; entries_[pos].node;
+         pos = (pos + 1) & mask) {
+        if (entries_[pos].node.get() == node) {
+            return (&entries_[pos]);
+        }
+    }
+    return (NULL);
+}
+
+void
+ZoneNameIndex::insert(util::MemorySegment& mem_sgmt, const LabelSequence& name,
+                      const ZoneNode* node)
+{
+    const uint32_t hash = getHash(name);
+    if (findEntry(node, hash) != NULL) {
+        return;
+    }
+    reserve(mem_sgmt, count_ + 1);
+
+    const uint32_t mask = capacity_ - 1;
+    uint32_t pos = hash & mask;
+    while (entries_[pos].node) {
+        pos = (pos + 1) & mask;
+    }
+    entries_[pos].node = node;
+    entries_[pos].hash = hash;
+    ++count_;
+}
+
+void
+ZoneNameIndex::remove(const ZoneNode* node) {
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    const Entry* const found =
+        findEntry(node, getHash(node->getAbsoluteLabels(labels_buf)));
+    if (found == NULL) {
+        return;
+    }
+
+    // Remove the entry, shifting back the following entries of the same
+    // cluster that would otherwise become unreachable.
+    const uint32_t mask = capacity_ - 1;
+    uint32_t hole = found - entries_.get();
+    for (uint32_t pos = (hole + 1) & mask; entries_[pos].node;
+         pos = (pos + 1) & mask) {
+        const uint32_t home = entries_[pos].hash & mask;
+        // The entry can stay if its home position is cyclically in
+        // (hole, pos].
+        const bool stays = (hole <= pos) ? (hole < home && home <= pos) :
+            (hole < home || home <= pos);
+        if (!stays) {
+            entries_[hole].node = entries_[pos].node;
+            entries_[hole].hash = entries_[pos].hash;
+            hole = pos;
+        }
+    }
+    entries_[hole].node = NULL;
+    entries_[hole].hash = 0;
+    --count_;
+}
+
+size_t
+ZoneNameIndex::getMemorySize() const {
+    return (sizeof(ZoneNameIndex) + sizeof(Entry) * capacity_);
+}
+
+const ZoneNode*
+ZoneNameIndex::find(const LabelSequence& name, bool* callback_above) const {
+    assert(name.isAbsolute());
+    if (capacity_ == 0) {
+        return (NULL);
+    }
+    const uint32_t hash = getHash(name);
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t pos = hash & mask; entries_[pos].node;
+         pos = (pos + 1) & mask) {
+        const Entry& entry = entries_[pos];
+        if (entry.hash == hash &&
+            matchNode(entry.node.get(), name, callback_above)) {
+            return (entry.node.get());
+        }
+    }
+    return (NULL);
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,164 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_ZONE_NAME_INDEX_H
+#define DATASRC_MEMORY_ZONE_NAME_INDEX_H 1
+
+#include <util/memory_segment.h>
+
+#include <dns/labelsequence.h>
+
+#include <datasrc/memory/zone_data.h>
+
+#include <boost/interprocess/offset_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+/// \brief Hash index of the names of a zone.
+///
+/// This class maps absolute owner names to the corresponding \c ZoneNode
+/// objects of a \c ZoneTree, so an exact match lookup can be done with
+/// a hash calculation and a single name comparison instead of a series of
+/// label comparisons through the tree.  It's an auxiliary structure of
+/// \c ZoneData: the tree is always the authoritative source of the names,
+/// and the index may not contain all of them (for example, names that are
+/// created implicitly as empty non-terminals).  So the user must fall back
+/// to the tree search when a name is not found in the index.
+///
+/// Like other zone data classes, an object of this class is allocated in
+/// a \c util::MemorySegment and only contains offset pointers, so it can be
+/// stored in a shared memory region.  The entries are kept in a single
+/// open-addressing table with linear probing, which is grown as names are
+/// added.
+///
+/// The index refers to the nodes but does not own them.  The owner must
+/// remove a node from the index before the node is destroyed.
+class ZoneNameIndex : boost::noncopyable {
+private:
+    struct Entry;
+
+    /// \brief The constructor.
+    ///
+    /// An object of this class is always expected to be created by the
+    /// allocator (\c create()), so the constructor is hidden as private.
+    ///
+    /// \throw none
+    explicit ZoneNameIndex(uint32_t seed);
+
+public:
+    /// \brief Allocate and construct \c ZoneNameIndex.
+    ///
+    /// The new index is empty and doesn't have any space for entries.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c ZoneNameIndex is allocated.
+    static ZoneNameIndex* create(util::MemorySegment& mem_sgmt);
+
+    /// \brief Destruct and deallocate \c ZoneNameIndex.
+    ///
+    /// The indexed nodes are not affected.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// \c index.
+    /// \param index A non NULL pointer to a valid \c ZoneNameIndex object
+    /// that was originally created by the \c create() method.
+    static void destroy(util::MemorySegment& mem_sgmt, ZoneNameIndex* index);
+
+    /// \brief Make sure the index can hold the given number of names
+    /// without growing.
+    ///
+    /// If this method throws, the index is unchanged.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    void reserve(util::MemorySegment& mem_sgmt, size_t count);
+
+    /// \brief Add a node to the index.
+    ///
+    /// \c name must be the absolute name of \c node.  If the node is
+    /// already in the index, this method does nothing.  If this method
+    /// throws, the index is unchanged, so the caller can simply retry
+    /// after \c util::MemorySegmentGrown.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    void insert(util::MemorySegment& mem_sgmt, const dns::LabelSequence& name,
+                const ZoneNode* node);
+
+    /// \brief Remove a node from the index.
+    ///
+    /// It's not an error if the node isn't in the index.
+    ///
+    /// \throw none
+    void remove(const ZoneNode* node);
+
+    /// \brief Find the node of the given name.
+    ///
+    /// If \c callback_above is non NULL, it's set to true if and only if
+    /// any ancestor node of the found one has the \c FLAG_CALLBACK flag,
+    /// i.e., \c DomainTree::find() would call the callback on the way to
+    /// the node.  This information is collected as part of the check of
+    /// the name, so it's cheaper than checking it separately.
+    ///
+    /// \throw none
+    ///
+    /// \param name The absolute name to be found.
+    /// \param callback_above If non NULL, see above.
+    /// \return The node of the given name; NULL if it's not in the index.
+    const ZoneNode* find(const dns::LabelSequence& name,
+                         bool* callback_above = NULL) const;
+
+    /// \brief Return the number of names in the index.
+    ///
+    /// \throw none
+    size_t getNameCount() const { return (count_); }
+
+    /// \brief Return the size of memory allocated for the index.
+    ///
+    /// \throw none
+    size_t getMemorySize() const;
+
+private:
+    uint32_t getHash(const dns::LabelSequence& name) const;
+    const Entry* findEntry(const ZoneNode* node, uint32_t hash) const;
+    void rehash(Entry* new_entries, uint32_t new_capacity);
+
+    boost::interprocess::offset_ptr<Entry> entries_;
+    uint32_t capacity_;         // always 0 or a power of 2
+    uint32_t count_;
+    const uint32_t seed_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_MEMORY_ZONE_NAME_INDEX_H
+
+// Local Variables:
+// mode: c++
+// End:
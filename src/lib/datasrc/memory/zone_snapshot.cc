@@ -0,0 +1,427 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_snapshot.h>
+
+#include <dns/rdata.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+
+#include <util/buffer.h>
+
+#include <boost/crc.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace bundy::dns;
+using bundy::util::InputBuffer;
+using bundy::util::OutputBuffer;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+namespace {
+const char SNAPSHOT_MAGIC[] = "BUNDYZSN";
+const size_t SNAPSHOT_MAGIC_LEN = sizeof(SNAPSHOT_MAGIC) - 1;
+const uint16_t SNAPSHOT_VERSION = 2;
+const char SNAPSHOT_SUFFIX[] = ".snapshot";
+const size_t SNAPSHOT_SUFFIX_LEN = sizeof(SNAPSHOT_SUFFIX) - 1;
+
+const uint8_t FLAG_SAME_OWNER = 0x01;
+const uint8_t TRAILER_MARK = 0xff;
+
+// The data is buffered and written (read) in pieces of (about) this size.
+const size_t WRITE_BUFFER_SIZE = 64 * 1024;
+const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+void
+writeRdata(OutputBuffer& buffer, const AbstractRRset& rrset) {
+    for (RdataIteratorPtr it = rrset.getRdataIterator(); !it->isLast();
+         it->next()) {
+        // Reserve the length field, and fill it in after the RDATA.
+        const size_t pos = buffer.getLength();
+        buffer.skip(sizeof(uint16_t));
+        it->getCurrent().toWire(buffer);
+        buffer.writeUint16At(buffer.getLength() - pos - sizeof(uint16_t),
+                             pos);
+    }
+}
+
+void
+readRdata(InputBuffer& buffer, const RRType& rrtype, const RRClass& rrclass,
+          size_t count, AbstractRRset& rrset)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const size_t len = buffer.readUint16();
+        rrset.addRdata(rdata::createRdata(rrtype, rrclass, buffer, len));
+    }
+}
+}
+
+struct ZoneSnapshotWriter::Impl {
+    Impl(const std::string& filename) :
+        filename_(filename), tmp_filename_(filename + ".tmp"),
+        buffer_(WRITE_BUFFER_SIZE), rrset_buffer_(0), count_(0),
+        closed_(false)
+    {}
+
+    // An unfinished snapshot never replaces the target; just drop the
+    // temporary file.
+    ~Impl() {
+        if (!closed_ && file_.is_open()) {
+            file_.close();
+            std::remove(tmp_filename_.c_str());
+        }
+    }
+
+    // Write the buffered data to the file.
+    void flush() {
+        crc_.process_bytes(buffer_.getData(), buffer_.getLength());
+        file_.write(static_cast<const char*>(buffer_.getData()),
+                    buffer_.getLength());
+        if (!file_) {
+            bundy_throw(ZoneSnapshotError, "failed to write zone snapshot "
+                        << filename_);
+        }
+        buffer_.clear();
+    }
+
+    const std::string filename_;
+    const std::string tmp_filename_; // the file being written
+    std::ofstream file_;
+    OutputBuffer buffer_;
+    OutputBuffer rrset_buffer_; // the RRset being written
+    boost::crc_32_type crc_;
+    boost::scoped_ptr<Name> last_name_;
+    uint32_t count_;
+    bool closed_;
+};
+
+ZoneSnapshotWriter::ZoneSnapshotWriter(const std::string& filename,
+                                       const Name& origin,
+                                       const RRClass& rrclass) :
+    impl_(new Impl(filename))
+{
+    errno = 0;
+    impl_->file_.open(impl_->tmp_filename_.c_str(),
+                      std::ios_base::out | std::ios_base::binary |
+                      std::ios_base::trunc);
+    if (!impl_->file_) {
+        const int error = errno;
+        delete impl_;
+        bundy_throw(ZoneSnapshotError, "failed to open zone snapshot "
+                    << filename << ".tmp for writing: "
+                    << std::strerror(error));
+    }
+    impl_->buffer_.writeData(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+    impl_->buffer_.writeUint16(SNAPSHOT_VERSION);
+    rrclass.toWire(impl_->buffer_);
+    impl_->buffer_.writeUint8(origin.getLength());
+    origin.toWire(impl_->buffer_);
+}
+
+ZoneSnapshotWriter::~ZoneSnapshotWriter() {
+    delete impl_;
+}
+
+void
+ZoneSnapshotWriter::addRRset(const AbstractRRset& rrset) {
+    if (impl_->closed_) {
+        bundy_throw(ZoneSnapshotError, "zone snapshot " << impl_->filename_
+                    << " is already closed");
+    }
+
+    // The RRset is built separately so its length can precede it.
+    OutputBuffer& rrset_buffer = impl_->rrset_buffer_;
+    rrset_buffer.clear();
+    uint8_t flags = 0;
+    if (impl_->last_name_ && *impl_->last_name_ == rrset.getName()) {
+        flags |= FLAG_SAME_OWNER;
+    } else {
+        rrset.getName().toWire(rrset_buffer);
+        impl_->last_name_.reset(new Name(rrset.getName()));
+    }
+    rrset.getType().toWire(rrset_buffer);
+    rrset.getTTL().toWire(rrset_buffer);
+    rrset_buffer.writeUint16(rrset.getRdataCount());
+    writeRdata(rrset_buffer, rrset);
+
+    const RRsetPtr sigs = rrset.getRRsig();
+    if (sigs && sigs->getRdataCount() > 0) {
+        rrset_buffer.writeUint16(sigs->getRdataCount());
+        sigs->getTTL().toWire(rrset_buffer);
+        writeRdata(rrset_buffer, *sigs);
+    } else {
+        rrset_buffer.writeUint16(0);
+    }
+
+    OutputBuffer& buffer = impl_->buffer_;
+    buffer.writeUint8(flags);
+    buffer.writeUint32(rrset_buffer.getLength());
+    buffer.writeData(rrset_buffer.getData(), rrset_buffer.getLength());
+    ++impl_->count_;
+    if (buffer.getLength() >= WRITE_BUFFER_SIZE) {
+        impl_->flush();
+    }
+}
+
+void
+ZoneSnapshotWriter::close() {
+    if (impl_->closed_) {
+        bundy_throw(ZoneSnapshotError, "zone snapshot " << impl_->filename_
+                    << " is already closed");
+    }
+    impl_->buffer_.writeUint8(TRAILER_MARK);
+    impl_->buffer_.writeUint32(impl_->count_);
+    impl_->flush();
+    impl_->buffer_.writeUint32(impl_->crc_.checksum());
+    impl_->flush();
+    impl_->file_.flush();
+    impl_->file_.close();
+    if (!impl_->file_) {
+        bundy_throw(ZoneSnapshotError, "failed to write zone snapshot "
+                    << impl_->tmp_filename_);
+    }
+
+    // Replace the target only now, so a reader never sees a partially
+    // written snapshot and the previous one survives a failed write.
+    impl_->closed_ = true;
+    if (std::rename(impl_->tmp_filename_.c_str(),
+                    impl_->filename_.c_str()) != 0) {
+        const int error = errno;
+        std::remove(impl_->tmp_filename_.c_str());
+        bundy_throw(ZoneSnapshotError, "failed to rename zone snapshot "
+                    << impl_->tmp_filename_ << " to " << impl_->filename_
+                    << ": " << std::strerror(error));
+    }
+}
+
+struct ZoneSnapshotReader::Impl {
+    Impl(const std::string& filename, const RRClass& rrclass) :
+        filename_(filename), rrclass_(rrclass), file_buffer_(READ_BUFFER_SIZE),
+        read_count_(0), at_end_(false)
+    {}
+
+    // Read exactly len bytes of the file (and add them to the checksum).
+    void read(void* data, size_t len) {
+        if (!file_.read(static_cast<char*>(data), len)) {
+            bundy_throw(ZoneSnapshotError, "zone snapshot " << filename_
+                        << " is incomplete");
+        }
+        crc_.process_bytes(data, len);
+    }
+
+    // Read len bytes of the file into data_ and return a buffer for them.
+    // The data is read in pieces so a broken length doesn't make us
+    // allocate more than the file actually contains.
+    InputBuffer readData(size_t len) {
+        data_.clear();
+        while (data_.size() < len) {
+            const size_t pos = data_.size();
+            data_.resize(pos + std::min(len - pos, READ_BUFFER_SIZE));
+            read(&data_[pos], data_.size() - pos);
+        }
+        return (InputBuffer(data_.empty() ? NULL : &data_[0], len));
+    }
+
+    // Read an integer of the given size (in network byte order).
+    uint32_t readInteger(size_t len) {
+        uint8_t data[sizeof(uint32_t)];
+        read(data, len);
+        InputBuffer buffer(data, len);
+        return (len == 1 ? buffer.readUint8() :
+                (len == 2 ? buffer.readUint16() : buffer.readUint32()));
+    }
+
+    // Check the trailer (after the mark).
+    void readTrailer() {
+        const uint32_t count = readInteger(sizeof(uint32_t));
+        const uint32_t checksum = crc_.checksum();
+        // The checksum itself isn't checksummed.
+        uint8_t data[sizeof(uint32_t)];
+        if (!file_.read(reinterpret_cast<char*>(data), sizeof(data))) {
+            bundy_throw(ZoneSnapshotError, "zone snapshot " << filename_
+                        << " is incomplete");
+        }
+        if (InputBuffer(data, sizeof(data)).readUint32() != checksum) {
+            bundy_throw(ZoneSnapshotError, "checksum mismatch in "
+                        "zone snapshot " << filename_);
+        }
+        if (count != read_count_) {
+            bundy_throw(ZoneSnapshotError, "broken zone snapshot "
+                        << filename_ << ": " << read_count_
+                        << " RRsets, expected " << count);
+        }
+        if (file_.peek() != std::ifstream::traits_type::eof()) {
+            bundy_throw(ZoneSnapshotError, "broken zone snapshot "
+                        << filename_ << ": extra data after the trailer");
+        }
+    }
+
+    const std::string filename_;
+    const RRClass rrclass_;
+    std::vector<char> file_buffer_;
+    std::ifstream file_;
+    boost::crc_32_type crc_;
+    std::vector<uint8_t> data_; // the part of the file being parsed
+    boost::scoped_ptr<Name> last_name_;
+    uint32_t read_count_;
+    bool at_end_;
+};
+
+ZoneSnapshotReader::ZoneSnapshotReader(const std::string& filename,
+                                       const Name& origin,
+                                       const RRClass& rrclass) :
+    impl_(new Impl(filename, rrclass))
+{
+    try {
+        // The stream reads through a large buffer; this only works before
+        // the file is opened.
+        impl_->file_.rdbuf()->pubsetbuf(&impl_->file_buffer_[0],
+                                        impl_->file_buffer_.size());
+        impl_->file_.open(filename.c_str(),
+                          std::ios_base::in | std::ios_base::binary);
+        if (!impl_->file_) {
+            bundy_throw(ZoneSnapshotError, "failed to open zone snapshot "
+                        << filename);
+        }
+
+        // The header is read here.  The RRsets are read one by one as
+        // they're returned, and the checksum is verified at the end.
+        char magic[SNAPSHOT_MAGIC_LEN];
+        if (!impl_->file_.read(magic, SNAPSHOT_MAGIC_LEN) ||
+            std::memcmp(magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) != 0) {
+            bundy_throw(ZoneSnapshotError, filename
+                        << " is not a zone snapshot");
+        }
+        impl_->crc_.process_bytes(magic, SNAPSHOT_MAGIC_LEN);
+        const uint16_t version = impl_->readInteger(sizeof(uint16_t));
+        if (version != SNAPSHOT_VERSION) {
+            bundy_throw(ZoneSnapshotError, "unsupported version ("
+                        << version << ") of zone snapshot " << filename);
+        }
+        const RRClass snapshot_class(impl_->readInteger(sizeof(uint16_t)));
+        InputBuffer origin_buffer =
+            impl_->readData(impl_->readInteger(sizeof(uint8_t)));
+        const Name snapshot_origin(origin_buffer);
+        if (snapshot_class != rrclass || snapshot_origin != origin) {
+            bundy_throw(ZoneSnapshotError, "zone snapshot " << filename
+                        << " is of " << snapshot_origin << "/"
+                        << snapshot_class << ", not " << origin << "/"
+                        << rrclass);
+        }
+    } catch (const ZoneSnapshotError&) {
+        delete impl_;
+        throw;
+    } catch (const bundy::Exception& ex) {
+        delete impl_;
+        bundy_throw(ZoneSnapshotError, "broken zone snapshot " << filename
+                    << ": " << ex.what());
+    }
+}
+
+ZoneSnapshotReader::~ZoneSnapshotReader() {
+    delete impl_;
+}
+
+ConstRRsetPtr
+ZoneSnapshotReader::getNextRRset() {
+    if (impl_->at_end_) {
+        return (ConstRRsetPtr());
+    }
+    try {
+        const uint8_t flags = impl_->readInteger(sizeof(uint8_t));
+        if (flags == TRAILER_MARK) {
+            impl_->readTrailer();
+            impl_->at_end_ = true;
+            return (ConstRRsetPtr());
+        }
+        if ((flags & ~FLAG_SAME_OWNER) != 0) {
+            bundy_throw(ZoneSnapshotError, "broken zone snapshot "
+                        << impl_->filename_ << ": unknown flags");
+        }
+        InputBuffer buffer =
+            impl_->readData(impl_->readInteger(sizeof(uint32_t)));
+        if ((flags & FLAG_SAME_OWNER) == 0) {
+            impl_->last_name_.reset(new Name(buffer));
+        } else if (!impl_->last_name_) {
+            bundy_throw(ZoneSnapshotError, "broken zone snapshot "
+                        << impl_->filename_ << ": no previous owner name");
+        }
+        const RRType rrtype(buffer.readUint16());
+        const RRTTL ttl(buffer);
+        const RRsetPtr rrset(new RRset(*impl_->last_name_, impl_->rrclass_,
+                                       rrtype, ttl));
+        readRdata(buffer, rrtype, impl_->rrclass_, buffer.readUint16(),
+                  *rrset);
+        const size_t sig_count = buffer.readUint16();
+        if (sig_count > 0) {
+            const RRTTL sig_ttl(buffer);
+            const RRsetPtr sigs(new RRset(*impl_->last_name_,
+                                          impl_->rrclass_, RRType::RRSIG(),
+                                          sig_ttl));
+            readRdata(buffer, RRType::RRSIG(), impl_->rrclass_, sig_count,
+                      *sigs);
+            rrset->addRRsig(sigs);
+            // addRRsig() gives the signatures the TTL of the RRset.
+            rrset->getRRsig()->setTTL(sig_ttl);
+        }
+        if (buffer.getPosition() != buffer.getLength()) {
+            bundy_throw(ZoneSnapshotError, "broken zone snapshot "
+                        << impl_->filename_ << ": extra data in an RRset");
+        }
+        ++impl_->read_count_;
+        return (rrset);
+    } catch (const ZoneSnapshotError&) {
+        throw;
+    } catch (const bundy::Exception& ex) {
+        bundy_throw(ZoneSnapshotError, "broken zone snapshot "
+                    << impl_->filename_ << ": " << ex.what());
+    }
+}
+
+bool
+isZoneSnapshot(const std::string& filename) {
+    return (filename.size() > SNAPSHOT_SUFFIX_LEN &&
+            filename.compare(filename.size() - SNAPSHOT_SUFFIX_LEN,
+                             SNAPSHOT_SUFFIX_LEN, SNAPSHOT_SUFFIX) == 0);
+}
+
+size_t
+writeZoneSnapshot(ZoneIterator& iterator, const Name& origin,
+                  const RRClass& rrclass, const std::string& filename)
+{
+    ZoneSnapshotWriter writer(filename, origin, rrclass);
+    size_t count = 0;
+    ConstRRsetPtr rrset;
+    while ((rrset = iterator.getNextRRset()) != NULL) {
+        writer.addRRset(*rrset);
+        ++count;
+    }
+    writer.close();
+    return (count);
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,185 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_ZONE_SNAPSHOT_H
+#define DATASRC_MEMORY_ZONE_SNAPSHOT_H 1
+
+#include <datasrc/exceptions.h>
+#include <datasrc/zone_iterator.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+/// \brief A zone snapshot can't be written or read.
+///
+/// This includes the cases where the snapshot is broken or is of a
+/// different zone or version.
+struct ZoneSnapshotError : public ZoneLoaderException {
+    ZoneSnapshotError(const char* file, size_t line, const char* what) :
+        ZoneLoaderException(file, line, what)
+    {}
+};
+
+/// \brief Writer of binary zone snapshots.
+///
+/// A zone snapshot is a file containing all RRsets of a zone in a compact
+/// binary form, which can be loaded into memory much faster than a
+/// master file, as there's nothing to tokenize or convert from text: the
+/// names and RDATA are stored in the DNS wire format.  A snapshot can be
+/// used wherever a master file is accepted for in-memory zones, if its
+/// name ends with ".snapshot"; see \c isZoneSnapshot() and
+/// \c ZoneDataLoader.
+///
+/// The format (version 2) is as follows.  All integers are in network
+/// byte order.
+/// \code
+/// header:  "BUNDYZSN" (8 bytes), version (16 bits), RR class (16 bits),
+///          length of the origin name (8 bits), the origin name (wire
+///          format)
+/// RRset:   flags (8 bits; 1 = same owner name as the previous RRset),
+///          length of the rest of the RRset (32 bits),
+///          owner name (wire format; only if the flag is not set),
+///          type (16 bits), TTL (32 bits), RDATA count (16 bits),
+///          { RDATA length (16 bits), RDATA (wire format) } * count,
+///          RRSIG count (16 bits), RRSIG TTL (32 bits; only if the count
+///          is not 0), { RDATA length, RDATA } * RRSIG count
+/// trailer: 0xff (8 bits), the number of RRsets (32 bits),
+///          CRC-32 of everything before it (32 bits)
+/// \endcode
+///
+/// The RRsets are given through \c addRRset(), and the snapshot is
+/// complete only after \c close().  The data is written to a temporary
+/// file (the given name with ".tmp" appended), which \c close() renames
+/// over the target, so an existing snapshot is replaced atomically and is
+/// kept intact if writing fails.  An incomplete snapshot is rejected
+/// when it's read.
+class ZoneSnapshotWriter : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// This creates (or truncates) the temporary file and writes the
+    /// header.  The target file isn't touched until \c close().
+    ///
+    /// \throw ZoneSnapshotError the file cannot be written.
+    ///
+    /// \param filename The name of the snapshot file.
+    /// \param origin The origin name of the zone.
+    /// \param rrclass The RR class of the zone.
+    ZoneSnapshotWriter(const std::string& filename, const dns::Name& origin,
+                       const dns::RRClass& rrclass);
+
+    /// \brief Destructor.
+    ///
+    /// If \c close() hasn't been called, the temporary file is removed
+    /// and the target file is left as it was.
+    ~ZoneSnapshotWriter();
+
+    /// \brief Add an RRset (and its RRSIGs, if any) to the snapshot.
+    ///
+    /// \throw ZoneSnapshotError the snapshot is closed or the file cannot
+    /// be written.
+    void addRRset(const dns::AbstractRRset& rrset);
+
+    /// \brief Complete the snapshot and rename it over the target file.
+    ///
+    /// \throw ZoneSnapshotError the snapshot is already closed or the file
+    /// cannot be written or renamed.
+    void close();
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+/// \brief Reader of binary zone snapshots.
+///
+/// See \c ZoneSnapshotWriter for the format.  The header is checked on
+/// construction, and the RRsets are read from the file one by one (so
+/// the file is never held in memory as a whole).  The checksum and the
+/// number of RRsets are verified when the end of the snapshot is reached,
+/// so the last call to \c getNextRRset() fails for a broken or incomplete
+/// snapshot; the caller must discard the RRsets read so far in that case
+/// (as \c ZoneDataLoader does on any load error).
+class ZoneSnapshotReader : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw ZoneSnapshotError the file cannot be read, it's not a
+    /// snapshot of a supported version, or it's of another zone.
+    ///
+    /// \param filename The name of the snapshot file.
+    /// \param origin The origin name of the zone expected in the snapshot.
+    /// \param rrclass The RR class of the zone expected in the snapshot.
+    ZoneSnapshotReader(const std::string& filename, const dns::Name& origin,
+                       const dns::RRClass& rrclass);
+
+    /// \brief Destructor.
+    ~ZoneSnapshotReader();
+
+    /// \brief Return the next RRset of the snapshot.
+    ///
+    /// RRSIGs written with an RRset are attached to it.
+    ///
+    /// \throw ZoneSnapshotError the snapshot is broken or incomplete.
+    ///
+    /// \return The next RRset, or NULL if there's no more RRset.
+    dns::ConstRRsetPtr getNextRRset();
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+/// \brief Return whether the file is to be loaded as a zone snapshot.
+///
+/// It only checks if the file name ends with ".snapshot"; the file isn't
+/// opened.  A file given for a zone with that suffix that is not a valid
+/// snapshot fails the load.
+///
+/// \throw None
+bool isZoneSnapshot(const std::string& filename);
+
+/// \brief Write a snapshot of the zone from a zone iterator.
+///
+/// The file name should end with ".snapshot" to be loaded as a snapshot.
+///
+/// \throw ZoneSnapshotError the file cannot be written.
+///
+/// \param iterator An iterator of the zone.
+/// \param origin The origin name of the zone.
+/// \param rrclass The RR class of the zone.
+/// \param filename The name of the snapshot file.
+/// \return The number of the RRsets written.
+size_t writeZoneSnapshot(ZoneIterator& iterator, const dns::Name& origin,
+                         const dns::RRClass& rrclass,
+                         const std::string& filename);
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_MEMORY_ZONE_SNAPSHOT_H
+
+// Local Variables:
+// mode: c++
+// End:
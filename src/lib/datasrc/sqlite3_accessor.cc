@@ -21,6 +21,10 @@
 #include <exceptions/exceptions.h>
 
 #include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <util/buffer.h>
 
 #include <datasrc/sqlite3_accessor.h>
 #include <datasrc/sqlite3_datasrc_messages.h>
@@ -32,6 +36,7 @@
 
 using namespace std;
 using namespace bundy::data;
+using bundy::util::OutputBuffer;
 
 namespace {
 // Expected schema.  The major version must match else there is an error.  If
@@ -45,7 +50,12 @@ namespace {
 // program may not be taking advantage of features (possibly performance
 // improvements) added to the database.
 const int SQLITE_SCHEMA_MAJOR_VERSION = 2;
-const int SQLITE_SCHEMA_MINOR_VERSION = 2;
+const int SQLITE_SCHEMA_MINOR_VERSION = 3;
+
+// The first minor version of the schema that has the rdata_wire columns in
+// the records and nsec3 tables.  For older databases we fall back to the
+// statements that only use the textual rdata.
+const int SQLITE_SCHEMA_WIRE_RDATA_MINOR_VERSION = 3;
 }
 
 namespace bundy {
@@ -81,7 +91,12 @@ enum StatementID {
     DEL_NSEC3_RECORD = 21,
     ADD_ZONE = 22,
     DELETE_ZONE = 23,
-    NUM_STATEMENTS = 24
+    ANY_WIRE = 24,
+    ANY_SUB_WIRE = 25,
+    NSEC3_WIRE = 26,
+    ADD_RECORD_WIRE = 27,
+    ADD_NSEC3_RECORD_WIRE = 28,
+    NUM_STATEMENTS = 29
 };
 
 const char* const text_statements[NUM_STATEMENTS] = {
@@ -171,9 +186,30 @@ const char* const text_statements[NUM_STATEMENTS] = {
     // ADD_ZONE: add a zone to the zones table
     "INSERT INTO zones (name, rdclass) VALUES (?1, ?2)", // ADD_ZONE
     // DELETE_ZONE: delete a zone from the zones table
-    "DELETE FROM zones WHERE id=?1" // DELETE_ZONE
+    "DELETE FROM zones WHERE id=?1", // DELETE_ZONE
+
+    // The following are variants of ANY, ANY_SUB, NSEC3, ADD_RECORD and
+    // ADD_NSEC3_RECORD for databases that have the rdata_wire column
+    // (schema 2.3 and later).  In the SELECT statements the wire-format
+    // rdata is returned as the 5th column (index WIRE_RDATA_COLUMN below).
+    "SELECT rdtype, ttl, sigtype, rdata, rdata_wire FROM records " // ANY_WIRE
+        "WHERE zone_id=?1 AND name=?2",
+    "SELECT rdtype, ttl, sigtype, rdata, rdata_wire " // ANY_SUB_WIRE
+        "FROM records WHERE zone_id=?1 AND rname LIKE ?2",
+    "SELECT rdtype, ttl, 1, rdata, rdata_wire FROM nsec3 " // NSEC3_WIRE
+        "WHERE zone_id=?1 AND hash=?2",
+    "INSERT INTO records "      // ADD_RECORD_WIRE
+        "(zone_id, name, rname, ttl, rdtype, sigtype, rdata, rdata_wire) "
+        "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)",
+    "INSERT INTO nsec3 "        // ADD_NSEC3_RECORD_WIRE
+        "(zone_id, hash, owner, ttl, rdtype, rdata, rdata_wire) "
+        "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)"
 };
 
+// Column index of the wire-format rdata in the result of the *_WIRE
+// SELECT statements.
+const int WIRE_RDATA_COLUMN = 4;
+
 struct SQLite3Parameters {
     SQLite3Parameters() :
         db_(NULL), major_version_(-1), minor_version_(-1),
@@ -204,6 +240,11 @@ struct SQLite3Parameters {
         return (statements_[id]);
     }
 
+    // Whether the records and nsec3 tables have the rdata_wire column.
+    bool hasWireRdata() const {
+        return (minor_version_ >= SQLITE_SCHEMA_WIRE_RDATA_MINOR_VERSION);
+    }
+
     void
     finalizeStatements() {
         for (int i = 0; i < NUM_STATEMENTS; ++i) {
@@ -282,6 +323,18 @@ public:
         }
     }
 
+    // Bind the given data as a BLOB.  An empty data is bound as NULL.
+    void bindBlob(int index, const void* data, size_t len,
+                  void(*destructor)(void*))
+    {
+        const int rc = (len == 0) ? sqlite3_bind_null(stmt_, index) :
+            sqlite3_bind_blob(stmt_, index, data, len, destructor);
+        if (rc != SQLITE_OK) {
+            bundy_throw(DataSourceError, "failed to bind SQLite3 parameter: " <<
+                      sqlite3_errmsg(dbparameters_.db_));
+        }
+    }
+
     void exec() {
         if (sqlite3_step(stmt_) != SQLITE_DONE) {
             sqlite3_reset(stmt_);
@@ -341,7 +394,7 @@ public:
 const char* const SCHEMA_LIST[] = {
     "CREATE TABLE schema_version (version INTEGER NOT NULL, "
         "minor INTEGER NOT NULL DEFAULT 0)",
-    "INSERT INTO schema_version VALUES (2, 2)",
+    "INSERT INTO schema_version VALUES (2, 3)",
     "CREATE TABLE zones (id INTEGER PRIMARY KEY, "
     "name TEXT NOT NULL COLLATE NOCASE, "
     "rdclass TEXT NOT NULL COLLATE NOCASE DEFAULT 'IN', "
@@ -351,7 +404,7 @@ const char* const SCHEMA_LIST[] = {
         "zone_id INTEGER NOT NULL, name TEXT NOT NULL COLLATE NOCASE, "
         "rname TEXT NOT NULL COLLATE NOCASE, ttl INTEGER NOT NULL, "
         "rdtype TEXT NOT NULL COLLATE NOCASE, sigtype TEXT COLLATE NOCASE, "
-        "rdata TEXT NOT NULL)",
+        "rdata TEXT NOT NULL, rdata_wire BLOB)",
     "CREATE INDEX records_byname ON records (name)",
     "CREATE INDEX records_byrname ON records (rname)",
     // The next index is a tricky one.  It's necessary for
@@ -366,7 +419,7 @@ const char* const SCHEMA_LIST[] = {
         "hash TEXT NOT NULL COLLATE NOCASE, "
         "owner TEXT NOT NULL COLLATE NOCASE, "
         "ttl INTEGER NOT NULL, rdtype TEXT NOT NULL COLLATE NOCASE, "
-        "rdata TEXT NOT NULL)",
+        "rdata TEXT NOT NULL, rdata_wire BLOB)",
     "CREATE INDEX nsec3_byhash ON nsec3 (hash)",
     "CREATE INDEX nsec3_byhash_and_rdtype ON nsec3 (hash, rdtype)",
     "CREATE TABLE diffs (id INTEGER PRIMARY KEY, "
@@ -699,7 +752,10 @@ public:
         statement2_(NULL),
         rc_(SQLITE_OK),
         rc2_(SQLITE_OK),
-        name_("")
+        name_(""),
+        has_wire_(false),
+        wire_data_(NULL),
+        wire_len_(0)
     {
         // We create the statements now and then just keep getting data
         // from them.
@@ -732,27 +788,33 @@ public:
         statement2_(NULL),
         rc_(SQLITE_OK),
         rc2_(SQLITE_OK),
-        name_(name)
+        name_(name),
+        has_wire_(accessor->dbparameters_->hasWireRdata()),
+        wire_data_(NULL),
+        wire_len_(0)
     {
         // Choose the statement text depending on the query type, and
         // prepare a statement to get data from it.
         switch (qtype) {
             case QT_ANY:
                 statement_ = prepare(accessor->dbparameters_->db_,
-                                     text_statements[ANY]);
+                                     text_statements[has_wire_ ? ANY_WIRE :
+                                                     ANY]);
                 bindZoneId(id);
                 bindName(name_);
                 break;
             case QT_SUBDOMAINS:
                 statement_ = prepare(accessor->dbparameters_->db_,
-                                     text_statements[ANY_SUB]);
+                                     text_statements[has_wire_ ?
+                                                     ANY_SUB_WIRE : ANY_SUB]);
                 bindZoneId(id);
                 // Done once, this should not be very inefficient.
                 bindName(bundy::dns::Name(name_).reverse().toText() + "%");
                 break;
             case QT_NSEC3:
                 statement_ = prepare(accessor->dbparameters_->db_,
-                                     text_statements[NSEC3]);
+                                     text_statements[has_wire_ ? NSEC3_WIRE :
+                                                     NSEC3]);
                 bindZoneId(id);
                 bindName(name_);
                 break;
@@ -770,6 +832,8 @@ public:
         // If there's another row, get it
         // If finalize has been called (e.g. when previous getNext() got
         // SQLITE_DONE), directly return false
+        wire_data_ = NULL;
+        wire_len_ = 0;
         while (statement_ != NULL) {
             rc_ = sqlite3_step(statement_);
             if (rc_ == SQLITE_ROW) {
@@ -786,6 +850,15 @@ public:
                 if (iterator_type_ == ITT_ALL) {
                     copyColumn(data, NAME_COLUMN);
                 }
+                // The wire-format rdata is NULL if it couldn't be converted
+                // when the record was added, or if the record was added
+                // by something that only knows the text form.
+                if (has_wire_) {
+                    wire_data_ = sqlite3_column_blob(statement_,
+                                                     WIRE_RDATA_COLUMN);
+                    wire_len_ = sqlite3_column_bytes(statement_,
+                                                     WIRE_RDATA_COLUMN);
+                }
                 return (true);
             } else if (rc_ != SQLITE_DONE) {
                 bundy_throw(DataSourceError,
@@ -804,6 +877,15 @@ public:
         return (false);
     }
 
+    virtual bool getRdataWire(const uint8_t*& data, size_t& len) const {
+        if (wire_data_ == NULL || wire_len_ == 0) {
+            return (false);
+        }
+        data = static_cast<const uint8_t*>(wire_data_);
+        len = wire_len_;
+        return (true);
+    }
+
     virtual ~Context() {
         finalize();
     }
@@ -861,6 +943,9 @@ private:
     int rc_;
     int rc2_;
     const std::string name_;
+    const bool has_wire_;       // whether statement_ returns the wire rdata
+    const void* wire_data_;     // wire rdata of the current row, if any
+    size_t wire_len_;
 };
 
 
@@ -1237,11 +1322,14 @@ SQLite3Accessor::rollback() {
 }
 
 namespace {
-// Commonly used code sequence for adding/deleting record
+// Commonly used code sequence for adding/deleting record.
+// If rdata_wire is non NULL, it's bound as the last parameter of the
+// statement (as NULL if the buffer is empty).
 template <typename COLUMNS_TYPE>
 void
 doUpdate(SQLite3Parameters& dbparams, StatementID stmt_id,
-         COLUMNS_TYPE update_params, const char* exec_desc)
+         COLUMNS_TYPE update_params, const char* exec_desc,
+         const OutputBuffer* rdata_wire = NULL)
 {
     StatementProcessor proc(dbparams, stmt_id, exec_desc);
 
@@ -1255,8 +1343,31 @@ doUpdate(SQLite3Parameters& dbparams, StatementID stmt_id,
         proc.bindText(++param_id, update_params[i].empty() ? NULL :
                       update_params[i].c_str(), SQLITE_TRANSIENT);
     }
+    if (rdata_wire != NULL) {
+        proc.bindBlob(++param_id, rdata_wire->getData(),
+                      rdata_wire->getLength(), SQLITE_STATIC);
+    }
     proc.exec();
 }
+
+// Convert the textual rdata of a record to be added into the wire format
+// stored in the rdata_wire column.  The conversion is done here, once, so
+// lookups don't have to parse the text.  If the data can't be parsed the
+// buffer is left empty; the record is then stored with the text only, as
+// it was before the rdata_wire column was introduced, and the error will be
+// detected when it's looked up.
+void
+convertRdataToWire(const string& rrtype, const string& rrclass,
+                   const string& rdata, OutputBuffer& buffer)
+{
+    try {
+        bundy::dns::rdata::createRdata(bundy::dns::RRType(rrtype),
+                                       bundy::dns::RRClass(rrclass),
+                                       rdata)->toWire(buffer);
+    } catch (const bundy::Exception&) {
+        buffer.clear();
+    }
+}
 }
 
 void
@@ -1265,8 +1376,17 @@ SQLite3Accessor::addRecordToZone(const string (&columns)[ADD_COLUMN_COUNT]) {
         bundy_throw(DataSourceError, "adding record to SQLite3 "
                   "data source without transaction");
     }
-    doUpdate<const string (&)[ADD_COLUMN_COUNT]>(
-        *dbparameters_, ADD_RECORD, columns, "add record to zone");
+    if (dbparameters_->hasWireRdata()) {
+        OutputBuffer rdata_wire(0);
+        convertRdataToWire(columns[ADD_TYPE], class_, columns[ADD_RDATA],
+                           rdata_wire);
+        doUpdate<const string (&)[ADD_COLUMN_COUNT]>(
+            *dbparameters_, ADD_RECORD_WIRE, columns, "add record to zone",
+            &rdata_wire);
+    } else {
+        doUpdate<const string (&)[ADD_COLUMN_COUNT]>(
+            *dbparameters_, ADD_RECORD, columns, "add record to zone");
+    }
 }
 
 void
@@ -1288,9 +1408,18 @@ SQLite3Accessor::addNSEC3RecordToZone(
           columns[ADD_NSEC3_HASH] + "." + dbparameters_->updated_zone_origin_,
           columns[ADD_NSEC3_TTL],
           columns[ADD_NSEC3_TYPE], columns[ADD_NSEC3_RDATA] };
-    doUpdate<const string (&)[ADD_NSEC3_COLUMN_COUNT + 1]>(
-        *dbparameters_, ADD_NSEC3_RECORD, sqlite3_columns,
-        "add NSEC3 record to zone");
+    if (dbparameters_->hasWireRdata()) {
+        OutputBuffer rdata_wire(0);
+        convertRdataToWire(columns[ADD_NSEC3_TYPE], class_,
+                           columns[ADD_NSEC3_RDATA], rdata_wire);
+        doUpdate<const string (&)[ADD_NSEC3_COLUMN_COUNT + 1]>(
+            *dbparameters_, ADD_NSEC3_RECORD_WIRE, sqlite3_columns,
+            "add NSEC3 record to zone", &rdata_wire);
+    } else {
+        doUpdate<const string (&)[ADD_NSEC3_COLUMN_COUNT + 1]>(
+            *dbparameters_, ADD_NSEC3_RECORD, sqlite3_columns,
+            "add NSEC3 record to zone");
+    }
 }
 
 void
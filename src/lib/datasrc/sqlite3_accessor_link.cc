@@ -21,8 +21,11 @@
 
 #include <log/message_initializer.h>
 
+#include <memory>
 #include <string>
 
+#include <stdint.h>
+
 using namespace std;
 using namespace bundy::dns;
 using namespace bundy::data;
@@ -33,6 +36,9 @@ namespace datasrc {
 namespace {
 
 const char* const CONFIG_ITEM_DATABASE_FILE = "database_file";
+const char* const CONFIG_ITEM_FIND_CACHE_SIZE = "find_cache_size";
+const char* const CONFIG_ITEM_FIND_CACHE_CHECK_INTERVAL =
+    "find_cache_check_interval";
 
 void
 addError(ElementPtr errors, const std::string& error) {
@@ -41,6 +47,38 @@ addError(ElementPtr errors, const std::string& error) {
     }
 }
 
+// Check an optional non-negative integer item.
+bool
+checkOptionalCount(ConstElementPtr config, const char* item,
+                   ElementPtr errors)
+{
+    if (!config->contains(item)) {
+        return (true);
+    }
+    ConstElementPtr value = config->get(item);
+    if (!value || value->getType() != Element::integer) {
+        addError(errors, "value of " + string(item) +
+                 " in SQLite3 backend is not an integer");
+        return (false);
+    }
+    if (value->intValue() < 0 || value->intValue() > 0xffffffff) {
+        addError(errors, "value of " + string(item) +
+                 " in SQLite3 backend is out of range");
+        return (false);
+    }
+    return (true);
+}
+
+uint32_t
+getOptionalCount(ConstElementPtr config, const char* item,
+                 uint32_t default_value)
+{
+    if (!config->contains(item)) {
+        return (default_value);
+    }
+    return (config->get(item)->intValue());
+}
+
 bool
 checkConfig(ConstElementPtr config, ElementPtr errors) {
     /* Specific configuration is under discussion, right now this accepts
@@ -70,6 +108,14 @@ checkConfig(ConstElementPtr config, ElementPtr errors) {
                      " in SQLite3 backend is empty");
             result = false;
         }
+        if (!checkOptionalCount(config, CONFIG_ITEM_FIND_CACHE_SIZE,
+                                errors)) {
+            result = false;
+        }
+        if (!checkOptionalCount(config, CONFIG_ITEM_FIND_CACHE_CHECK_INTERVAL,
+                                errors)) {
+            result = false;
+        }
     }
 
     return (result);
@@ -94,8 +140,15 @@ createInstance(const std::string& datasrc_name,
     try {
         boost::shared_ptr<DatabaseAccessor> sqlite3_accessor(
             new SQLite3Accessor(dbfile, "IN")); // XXX: avoid hardcode RR class
-        return (new DatabaseClient(datasrc_name, bundy::dns::RRClass::IN(),
-                                   sqlite3_accessor));
+        std::unique_ptr<DatabaseClient> client(
+            new DatabaseClient(datasrc_name, bundy::dns::RRClass::IN(),
+                               sqlite3_accessor));
+        // The find cache is disabled unless a size is given.
+        client->enableFindCache(
+            getOptionalCount(config, CONFIG_ITEM_FIND_CACHE_SIZE, 0),
+            getOptionalCount(config, CONFIG_ITEM_FIND_CACHE_CHECK_INTERVAL,
+                             1));
+        return (client.release());
     } catch (const std::exception& exc) {
         error = std::string("Error creating SQLite3 datasource: ") +
             exc.what();
@@ -16,6 +16,7 @@
 #include <datasrc/exceptions.h>
 #include <datasrc/memory/loader_creator.h>
 #include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_name_index.h>
 #include <datasrc/tests/mock_client.h>
 
 #include <cc/data.h>
@@ -36,6 +37,7 @@ using bundy::datasrc::internal::CacheConfig;
 using bundy::datasrc::internal::CacheConfigError;
 using bundy::datasrc::memory::ZoneDataLoaderCreator;
 using bundy::datasrc::memory::ZoneData;
+using bundy::datasrc::memory::ZoneNameIndex;
 
 namespace {
 
@@ -311,4 +313,100 @@ TEST_F(CacheConfigTest, getSegmentType) {
                  bundy::data::TypeError);
 }
 
+TEST_F(CacheConfigTest, nameIndex) {
+    // Disabled by default
+    const CacheConfig cache_conf("MasterFiles", 0, *master_config_, true);
+    EXPECT_FALSE(cache_conf.isNameIndexEnabled());
+    boost::scoped_ptr<memory::ZoneDataLoader> loader(
+        cache_conf.getLoaderCreator(RRClass::IN(), Name::ROOT_NAME())
+        (msgmt_, NULL));
+    ZoneData* zone_data = loader->load();
+    ASSERT_TRUE(zone_data);
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data->getNameIndex());
+    ZoneData::destroy(msgmt_, zone_data, RRClass::IN());
+
+    // If enabled, the loaded zone data have the index.
+    ConstElementPtr config(Element::fromJSON(
+                               "{\"cache-enable\": true,"
+                               " \"cache-name-index\": true,"
+                               " \"params\": "
+                               "  {\".\": \"" TEST_DATA_DIR "/root.zone\"}"
+                               "}"));
+    const CacheConfig index_conf("MasterFiles", 0, *config, true);
+    EXPECT_TRUE(index_conf.isNameIndexEnabled());
+    loader.reset(index_conf.getLoaderCreator(RRClass::IN(),
+                                             Name::ROOT_NAME())(msgmt_, NULL));
+    zone_data = loader->load();
+    ASSERT_TRUE(zone_data);
+    const ZoneNameIndex* index = zone_data->getNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL), index);
+    EXPECT_EQ(zone_data->getOriginNode(),
+              index->find(LabelSequence(Name::ROOT_NAME())));
+    ZoneData::destroy(msgmt_, zone_data, RRClass::IN());
+
+    // Wrong type
+    ConstElementPtr badconfig(Element::fromJSON("{\"cache-enable\": true,"
+                                                " \"cache-name-index\": 1,"
+                                                " \"params\": {}}"));
+    EXPECT_THROW(CacheConfig("MasterFiles", 0, *badconfig, true),
+                 bundy::data::TypeError);
+}
+
+TEST_F(CacheConfigTest, loadThreads) {
+    // A single thread by default
+    EXPECT_EQ(1, CacheConfig("MasterFiles", 0,
+                             *master_config_, true).getLoadThreads());
+
+    ConstElementPtr config(Element::fromJSON("{\"cache-enable\": true,"
+                                             " \"cache-load-threads\": 8,"
+                                             " \"params\": {}}"));
+    EXPECT_EQ(8, CacheConfig("MasterFiles", 0, *config,
+                             true).getLoadThreads());
+
+    // At least one thread is necessary
+    ConstElementPtr badconfig(Element::fromJSON("{\"cache-enable\": true,"
+                                                " \"cache-load-threads\": 0,"
+                                                " \"params\": {}}"));
+    EXPECT_THROW(CacheConfig("MasterFiles", 0, *badconfig, true),
+                 CacheConfigError);
+    badconfig = Element::fromJSON("{\"cache-enable\": true,"
+                                  " \"cache-load-threads\": \"8\","
+                                  " \"params\": {}}");
+    EXPECT_THROW(CacheConfig("MasterFiles", 0, *badconfig, true),
+                 bundy::data::TypeError);
+}
+
+TEST_F(CacheConfigTest, parseThreads) {
+    // A single thread by default
+    EXPECT_EQ(1, CacheConfig("MasterFiles", 0,
+                             *master_config_, true).getParseThreads());
+
+    // The zone is loaded with the configured number of threads; the
+    // result is the same.
+    ConstElementPtr config(Element::fromJSON(
+                               "{\"cache-enable\": true,"
+                               " \"cache-parse-threads\": 4,"
+                               " \"params\": "
+                               "  {\".\": \"" TEST_DATA_DIR
+                               "/root.zone\"}"
+                               "}"));
+    const CacheConfig cache_conf("MasterFiles", 0, *config, true);
+    EXPECT_EQ(4, cache_conf.getParseThreads());
+    const boost::scoped_ptr<memory::ZoneDataLoader> loader(
+        cache_conf.getLoaderCreator(RRClass::IN(), Name::ROOT_NAME())
+        (msgmt_, NULL));
+    ZoneData* zone_data = loader->load();
+    ASSERT_TRUE(zone_data);
+    EXPECT_TRUE(zone_data->getOriginNode()->getData());
+    ZoneData::destroy(msgmt_, zone_data, RRClass::IN());
+
+    // At least one thread is necessary
+    ConstElementPtr badconfig(Element::fromJSON("{\"cache-enable\": true,"
+                                                " \"cache-parse-threads\": 0,"
+                                                " \"params\": {}}"));
+    EXPECT_THROW(CacheConfig("MasterFiles", 0, *badconfig, true),
+                 CacheConfigError);
+}
+
 }
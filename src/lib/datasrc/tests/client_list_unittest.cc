@@ -1025,6 +1025,39 @@ TEST_P(ListTest, BadMasterFile) {
     EXPECT_TRUE(list_->find(Name("example.org."), true) == negative_result_);
 }
 
+// Same as the previous one, but the zones are loaded with several threads
+// (for the local segment; others fall back to the sequential load).
+TEST_P(ListTest, parallelLoad) {
+    const ConstElementPtr elem(Element::fromJSON("["
+        "{"
+        "   \"type\": \"MasterFiles\","
+        "   \"cache-enable\": true,"
+        "   \"cache-load-threads\": 4,"
+        "   \"params\": {"
+        "       \"example.com.\": \"" TEST_DATA_DIR "/example.com.flattened\","
+        "       \"example.net.\": \"" TEST_DATA_DIR "/example.net-empty\","
+        "       \"example.edu.\": \"" TEST_DATA_DIR "/example.edu-broken\","
+        "       \"example.info.\": \"" TEST_DATA_DIR "/example.info-nonexist\","
+        "       \"foo.bar.\": \"" TEST_DATA_DIR "/example.org.nsec3-signed\","
+        "       \".\": \"" TEST_DATA_DIR "/root.zone\""
+        "   }"
+        "}]"));
+    list_->configure(elem, true);
+
+    const boost::shared_ptr<InMemoryClient> cache(
+        list_->getDataSources()[0].cache_);
+    EXPECT_EQ(6, cache->getZoneCount());
+    positiveResult(list_->find(Name("example.com."), true), ds_[0],
+                   Name("example.com."), true, "example.com", true);
+    positiveResult(list_->find(Name(".")), ds_[0], Name("."), true, "root",
+                   true);
+    emptyResult(list_->find(Name("foo.bar"), true), true, "foo.bar");
+    emptyResult(list_->find(Name("example.net."), true), true, "example.net");
+    emptyResult(list_->find(Name("example.edu."), true), true, "example.edu");
+    emptyResult(list_->find(Name("example.info."), true), true,
+                "example.info");
+}
+
 ConfigurableClientList::CacheStatus
 ListTest::doReload(const Name& origin, const string& datasrc_name) {
     ConfigurableClientList::ZoneWriterPair
@@ -1369,6 +1402,78 @@ ListTest::accessorIterate(const ConstZoneTableAccessorPtr& accessor,
     }
 }
 
+TEST_F(ListTest, zoneMemoryUsage) {
+    EXPECT_TRUE(list_->getZoneMemoryUsage().empty());
+
+    const ConstElementPtr elem(Element::fromJSON("["
+        "{"
+        "   \"type\": \"type1\","
+        "   \"cache-enable\": false,"
+        "   \"params\": {}"
+        "},"
+        "{"
+        "   \"type\": \"MasterFiles\","
+        "   \"cache-enable\": true,"
+        "   \"params\": {"
+        "       \".\": \"" TEST_DATA_DIR "/root.zone\""
+        "   }"
+        "}]"));
+    list_->configure(elem, true);
+
+    // Only the cached zone is reported.
+    const vector<ZoneMemoryUsage> usages(list_->getZoneMemoryUsage());
+    ASSERT_EQ(1, usages.size());
+    EXPECT_EQ("MasterFiles", usages[0].datasrc_name);
+    EXPECT_EQ(Name::ROOT_NAME(), usages[0].zone_name);
+    EXPECT_LT(0, usages[0].usage.node_count);
+    EXPECT_LT(0, usages[0].usage.rdataset_count);
+    EXPECT_LT(usages[0].usage.rdataset_bytes, usages[0].usage.getTotal());
+
+    // The same for the zone alone, and nothing for a zone that isn't cached.
+    const vector<ZoneMemoryUsage> zone_usages(
+        list_->getZoneMemoryUsage(Name::ROOT_NAME()));
+    ASSERT_EQ(1, zone_usages.size());
+    EXPECT_EQ(Name::ROOT_NAME(), zone_usages[0].zone_name);
+    EXPECT_EQ(usages[0].usage.getTotal(), zone_usages[0].usage.getTotal());
+    EXPECT_TRUE(list_->getZoneMemoryUsage(Name("example.org")).empty());
+}
+
+TEST_F(ListTest, cacheOnly) {
+    // Trivially true for an empty list.
+    EXPECT_TRUE(list_->isCacheOnly());
+
+    list_->configure(config_elem_, true);
+    EXPECT_FALSE(list_->isCacheOnly());
+
+    // A data source without cache makes the list use data source clients.
+    const ConstElementPtr elem(Element::fromJSON("["
+        "{"
+        "   \"type\": \"MasterFiles\","
+        "   \"cache-enable\": true,"
+        "   \"params\": {"
+        "       \".\": \"" TEST_DATA_DIR "/root.zone\""
+        "   }"
+        "},"
+        "{"
+        "   \"type\": \"type1\","
+        "   \"cache-enable\": false,"
+        "   \"params\": {}"
+        "}]"));
+    list_->configure(elem, true);
+    EXPECT_FALSE(list_->isCacheOnly());
+
+    const ConstElementPtr elem_cached(Element::fromJSON("["
+        "{"
+        "   \"type\": \"MasterFiles\","
+        "   \"cache-enable\": true,"
+        "   \"params\": {"
+        "       \".\": \"" TEST_DATA_DIR "/root.zone\""
+        "   }"
+        "}]"));
+    list_->configure(elem_cached, true);
+    EXPECT_TRUE(list_->isCacheOnly());
+}
+
 TEST_F(ListTest, zoneTableAccessor) {
     // empty configuration
     const ConstElementPtr elem(new ListElement);
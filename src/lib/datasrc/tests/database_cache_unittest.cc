@@ -0,0 +1,182 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/database_cache.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/name.h>
+#include <dns/rrtype.h>
+
+#include <testutils/dnsmessage_test.h>
+
+#include <gtest/gtest.h>
+
+using namespace bundy::dns;
+using namespace bundy::datasrc;
+using bundy::testutils::textToRRset;
+
+namespace {
+
+const int ZONE_ID = 42;
+const time_t NOW = 1000;
+
+class DatabaseFindCacheTest : public ::testing::Test {
+protected:
+    DatabaseFindCacheTest() :
+        cache_(10, 5),
+        name_("www.example.org"),
+        a_result_(ZoneFinder::SUCCESS,
+                  textToRRset("www.example.org. 300 IN A 192.0.2.1"),
+                  ZoneFinder::RESULT_DEFAULT, 3),
+        nx_result_(ZoneFinder::NXDOMAIN,
+                   textToRRset("example.org. 3600 IN NSEC "
+                               "zzz.example.org. A NS SOA NSEC RRSIG"),
+                   ZoneFinder::RESULT_NSEC_SIGNED, 2)
+    {
+        cache_.updateZone(ZONE_ID, 1, 60, NOW);
+    }
+
+    DatabaseFindCache cache_;
+    const Name name_;
+    const DatabaseFindCache::Result a_result_;
+    const DatabaseFindCache::Result nx_result_;
+    DatabaseFindCache::Result result_;
+};
+
+TEST_F(DatabaseFindCacheTest, badConstruct) {
+    EXPECT_THROW(DatabaseFindCache(0, 1), bundy::InvalidParameter);
+}
+
+TEST_F(DatabaseFindCacheTest, positive) {
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW, result_));
+    cache_.add(ZONE_ID, name_, RRType::A(), ZoneFinder::FIND_DEFAULT,
+               a_result_, NOW);
+    EXPECT_EQ(1, cache_.getEntryCount());
+
+    // Name comparison is case insensitive.
+    ASSERT_TRUE(cache_.find(ZONE_ID, Name("WWW.example.ORG"), RRType::A(),
+                            ZoneFinder::FIND_DEFAULT, NOW + 299, result_));
+    EXPECT_EQ(ZoneFinder::SUCCESS, result_.code);
+    EXPECT_EQ(a_result_.rrset, result_.rrset);
+    EXPECT_EQ(3, result_.match_label_count);
+
+    // The type, options and zone are part of the key.
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::AAAA(),
+                             ZoneFinder::FIND_DEFAULT, NOW, result_));
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DNSSEC, NOW, result_));
+    EXPECT_FALSE(cache_.find(ZONE_ID + 1, name_, RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW, result_));
+
+    // Expires with the TTL.
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW + 300, result_));
+}
+
+TEST_F(DatabaseFindCacheTest, negative) {
+    cache_.add(ZONE_ID, name_, RRType::A(), ZoneFinder::FIND_DNSSEC,
+               nx_result_, NOW);
+    ASSERT_TRUE(cache_.find(ZONE_ID, name_, RRType::A(),
+                            ZoneFinder::FIND_DNSSEC, NOW + 59, result_));
+    EXPECT_EQ(ZoneFinder::NXDOMAIN, result_.code);
+    EXPECT_EQ(ZoneFinder::RESULT_NSEC_SIGNED, result_.flags);
+
+    // The negative TTL of the zone is used rather than the NSEC TTL.
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DNSSEC, NOW + 60, result_));
+
+    // Negative results without an RRset are cached too.
+    cache_.add(ZONE_ID, name_, RRType::TXT(), ZoneFinder::FIND_DEFAULT,
+               DatabaseFindCache::Result(ZoneFinder::NXRRSET,
+                                         ConstRRsetPtr(),
+                                         ZoneFinder::RESULT_DEFAULT, 3),
+               NOW);
+    EXPECT_TRUE(cache_.find(ZONE_ID, name_, RRType::TXT(),
+                            ZoneFinder::FIND_DEFAULT, NOW, result_));
+}
+
+TEST_F(DatabaseFindCacheTest, zeroTTL) {
+    cache_.add(ZONE_ID, name_, RRType::A(), ZoneFinder::FIND_DEFAULT,
+               DatabaseFindCache::Result(
+                   ZoneFinder::SUCCESS,
+                   textToRRset("www.example.org. 0 IN A 192.0.2.1"),
+                   ZoneFinder::RESULT_DEFAULT, 3), NOW);
+    EXPECT_EQ(0, cache_.getEntryCount());
+}
+
+TEST_F(DatabaseFindCacheTest, serialCheck) {
+    EXPECT_FALSE(cache_.needsCheck(ZONE_ID, NOW));
+    EXPECT_FALSE(cache_.needsCheck(ZONE_ID, NOW + 4));
+    EXPECT_TRUE(cache_.needsCheck(ZONE_ID, NOW + 5));
+    EXPECT_TRUE(cache_.needsCheck(ZONE_ID, NOW - 1));
+    EXPECT_TRUE(cache_.needsCheck(ZONE_ID + 1, NOW));
+
+    cache_.add(ZONE_ID, name_, RRType::A(), ZoneFinder::FIND_DEFAULT,
+               a_result_, NOW);
+
+    // Same serial: the entries stay.
+    cache_.updateZone(ZONE_ID, 1, 60, NOW + 5);
+    EXPECT_FALSE(cache_.needsCheck(ZONE_ID, NOW + 5));
+    EXPECT_TRUE(cache_.find(ZONE_ID, name_, RRType::A(),
+                            ZoneFinder::FIND_DEFAULT, NOW + 5, result_));
+
+    // New serial: they are gone.
+    cache_.updateZone(ZONE_ID, 2, 60, NOW + 10);
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW + 10, result_));
+}
+
+TEST_F(DatabaseFindCacheTest, invalidate) {
+    cache_.add(ZONE_ID, name_, RRType::A(), ZoneFinder::FIND_DEFAULT,
+               a_result_, NOW);
+    cache_.invalidateZone(ZONE_ID);
+    EXPECT_TRUE(cache_.needsCheck(ZONE_ID, NOW));
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW, result_));
+
+    // Nothing is stored until the zone is reported again, and the old
+    // entries don't come back even with the same serial.
+    cache_.add(ZONE_ID, Name("example.org"), RRType::A(),
+               ZoneFinder::FIND_DEFAULT, a_result_, NOW);
+    EXPECT_EQ(1, cache_.getEntryCount());
+    cache_.updateZone(ZONE_ID, 1, 60, NOW);
+    EXPECT_FALSE(cache_.find(ZONE_ID, name_, RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW, result_));
+}
+
+TEST_F(DatabaseFindCacheTest, recycle) {
+    for (int i = 0; i < 10; ++i) {
+        cache_.add(ZONE_ID, Name(std::string(1, 'a' + i) + ".example.org"),
+                   RRType::A(), ZoneFinder::FIND_DEFAULT, a_result_, NOW);
+    }
+    EXPECT_EQ(10, cache_.getEntryCount());
+
+    // Use the first one so the second one is the least recently used.
+    EXPECT_TRUE(cache_.find(ZONE_ID, Name("a.example.org"), RRType::A(),
+                            ZoneFinder::FIND_DEFAULT, NOW, result_));
+    cache_.add(ZONE_ID, name_, RRType::A(), ZoneFinder::FIND_DEFAULT,
+               a_result_, NOW);
+    EXPECT_EQ(10, cache_.getEntryCount());
+    EXPECT_EQ(10, cache_.getMaxEntries());
+    EXPECT_TRUE(cache_.find(ZONE_ID, name_, RRType::A(),
+                            ZoneFinder::FIND_DEFAULT, NOW, result_));
+    EXPECT_TRUE(cache_.find(ZONE_ID, Name("a.example.org"), RRType::A(),
+                            ZoneFinder::FIND_DEFAULT, NOW, result_));
+    EXPECT_FALSE(cache_.find(ZONE_ID, Name("b.example.org"), RRType::A(),
+                             ZoneFinder::FIND_DEFAULT, NOW, result_));
+}
+
+}
@@ -23,6 +23,7 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <cstdio>
 #include <cstdlib>
 #include <string>
 
@@ -60,8 +61,31 @@ createSQLite3Accessor() {
 const DatabaseClientTestParam sqlite3_param = { createSQLite3Accessor,
                                                 enableNSEC3Generic };
 
+// Same as createSQLite3Accessor(), but on a newly created database of the
+// current schema.  The test data then store the RDATA in wire format as well
+// as text, so the same set of tests checks the finder with the wire data.
+boost::shared_ptr<DatabaseAccessor>
+createSQLite3WireAccessor() {
+    const char* const dbfile = TEST_DATA_BUILDDIR "/rwtest-wire.sqlite3.copied";
+    std::remove(dbfile);
+
+    boost::shared_ptr<DatabaseAccessor> accessor(
+        new SQLite3Accessor(dbfile, "IN"));
+    accessor->startTransaction();
+    accessor->addZone("example.org.");
+    accessor->commit();
+    loadTestDataGeneric(*accessor);
+
+    return (accessor);
+}
+
+const DatabaseClientTestParam sqlite3_wire_param = {
+    createSQLite3WireAccessor, enableNSEC3Generic };
+
 INSTANTIATE_TEST_CASE_P(SQLite3, DatabaseClientTest,
                         ::testing::Values(&sqlite3_param));
+INSTANTIATE_TEST_CASE_P(SQLite3Wire, DatabaseClientTest,
+                        ::testing::Values(&sqlite3_wire_param));
 
 INSTANTIATE_TEST_CASE_P(SQLite3, RRsetCollectionTest,
                         ::testing::Values(&sqlite3_param));
@@ -4180,6 +4180,116 @@ TEST_P(DatabaseClientTest, findNSEC3) {
     performNSEC3Test(*finder, true);
 }
 
+// Replace an RRset of example.org in a single update through the given
+// client.
+void
+replaceRRset(DataSourceClient& client, const AbstractRRset& old_rrset,
+             const AbstractRRset& new_rrset)
+{
+    ZoneUpdaterPtr updater = client.getUpdater(Name("example.org"), false);
+    updater->deleteRRset(old_rrset);
+    updater->addRRset(new_rrset);
+    updater->commit();
+}
+
+TEST_P(DatabaseClientTest, findCached) {
+    client_->enableFindCache(100, 3600);
+    boost::shared_ptr<DatabaseClient::Finder> finder(getFinder());
+    expected_rdatas_.clear();
+    expected_rdatas_.push_back("192.0.2.1");
+    doFindTest(*finder, qname_, qtype_, qtype_, rrttl_, ZoneFinder::SUCCESS,
+               expected_rdatas_, empty_rdatas_);
+
+    // Change the data through another client, which doesn't share the
+    // cache.  The cached result is still returned until the zone is checked
+    // again, ...
+    RRset old_rrset(qname_, qclass_, qtype_, rrttl_);
+    old_rrset.addRdata(rdata::createRdata(qtype_, qclass_, "192.0.2.1"));
+    DatabaseClient other_client("dbtest", qclass_, current_accessor_);
+    replaceRRset(other_client, old_rrset, *rrset_);
+    {
+        SCOPED_TRACE("cached");
+        doFindTest(*finder, qname_, qtype_, qtype_, rrttl_,
+                   ZoneFinder::SUCCESS, expected_rdatas_, empty_rdatas_);
+    }
+
+    // ... while a finder without the cache sees the new data.
+    expected_rdatas_.clear();
+    expected_rdatas_.push_back("192.0.2.2");
+    {
+        SCOPED_TRACE("not cached");
+        doFindTest(*other_client.findZone(zname_).zone_finder, qname_, qtype_,
+                   qtype_, rrttl_, ZoneFinder::SUCCESS, expected_rdatas_,
+                   empty_rdatas_);
+    }
+
+    // Results for other names or types are looked up and cached separately.
+    EXPECT_EQ(ZoneFinder::NXDOMAIN,
+              finder->find(Name("nosuchname.example.org"), qtype_)->code);
+    EXPECT_EQ(ZoneFinder::NXRRSET,
+              finder->find(qname_, RRType::TXT())->code);
+}
+
+TEST_P(DatabaseClientTest, findCachedSerialCheck) {
+    // Check the zone serial on every find.
+    client_->enableFindCache(100, 0);
+    boost::shared_ptr<DatabaseClient::Finder> finder(getFinder());
+    expected_rdatas_.clear();
+    expected_rdatas_.push_back("192.0.2.1");
+    doFindTest(*finder, qname_, qtype_, qtype_, rrttl_, ZoneFinder::SUCCESS,
+               expected_rdatas_, empty_rdatas_);
+
+    // A change without updating the serial isn't noticed.
+    RRset old_rrset(qname_, qclass_, qtype_, rrttl_);
+    old_rrset.addRdata(rdata::createRdata(qtype_, qclass_, "192.0.2.1"));
+    DatabaseClient other_client("dbtest", qclass_, current_accessor_);
+    replaceRRset(other_client, old_rrset, *rrset_);
+    {
+        SCOPED_TRACE("same serial");
+        doFindTest(*finder, qname_, qtype_, qtype_, rrttl_,
+                   ZoneFinder::SUCCESS, expected_rdatas_, empty_rdatas_);
+    }
+
+    // Once the serial changes, the cached results of the zone are dropped.
+    RRset new_soa(zname_, qclass_, RRType::SOA(), rrttl_);
+    new_soa.addRdata(rdata::createRdata(RRType::SOA(), qclass_,
+                                        "ns1.example.org. admin.example.org. "
+                                        "1235 3600 1800 2419200 7200"));
+    replaceRRset(other_client, *soa_, new_soa);
+    expected_rdatas_.clear();
+    expected_rdatas_.push_back("192.0.2.2");
+    {
+        SCOPED_TRACE("new serial");
+        doFindTest(*finder, qname_, qtype_, qtype_, rrttl_,
+                   ZoneFinder::SUCCESS, expected_rdatas_, empty_rdatas_);
+    }
+}
+
+TEST_P(DatabaseClientTest, findCachedInvalidatedOnCommit) {
+    // The mock accessor uses a different zone ID for updates than for
+    // lookups, so the commit can't tell which cached zone to invalidate.
+    if (is_mock_) {
+        return;
+    }
+
+    client_->enableFindCache(100, 3600);
+    boost::shared_ptr<DatabaseClient::Finder> finder(getFinder());
+    expected_rdatas_.clear();
+    expected_rdatas_.push_back("192.0.2.1");
+    doFindTest(*finder, qname_, qtype_, qtype_, rrttl_, ZoneFinder::SUCCESS,
+               expected_rdatas_, empty_rdatas_);
+
+    // An update through the same client is seen right after the commit,
+    // even with the same serial.
+    RRset old_rrset(qname_, qclass_, qtype_, rrttl_);
+    old_rrset.addRdata(rdata::createRdata(qtype_, qclass_, "192.0.2.1"));
+    replaceRRset(*client_, old_rrset, *rrset_);
+    expected_rdatas_.clear();
+    expected_rdatas_.push_back("192.0.2.2");
+    doFindTest(*finder, qname_, qtype_, qtype_, rrttl_, ZoneFinder::SUCCESS,
+               expected_rdatas_, empty_rdatas_);
+}
+
 TEST_P(DatabaseClientTest, createZone) {
     const Name new_name("example.com");
     const DataSourceClient::FindResult result(client_->findZone(new_name));
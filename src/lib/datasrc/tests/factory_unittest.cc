@@ -159,6 +159,22 @@ TEST(FactoryTest, sqlite3ClientBadConfig) {
 
     ZoneUpdaterPtr updater(dsc.getInstance().getUpdater(
         bundy::dns::Name("example.org."), false));
+
+    // The find cache parameters must be non-negative integers.
+    config->set("find_cache_size", Element::create("100"));
+    EXPECT_THROW(DataSourceClientContainer("sqlite3", "sqlite3", config),
+                 DataSourceError);
+    config->set("find_cache_size", Element::create(-1));
+    EXPECT_THROW(DataSourceClientContainer("sqlite3", "sqlite3", config),
+                 DataSourceError);
+    config->set("find_cache_size", Element::create(100));
+    config->set("find_cache_check_interval", Element::create(true));
+    EXPECT_THROW(DataSourceClientContainer("sqlite3", "sqlite3", config),
+                 DataSourceError);
+    config->set("find_cache_check_interval", Element::create(10));
+    DataSourceClientContainer dsc_cached("sqlite3", "sqlite3", config);
+    EXPECT_EQ(result::SUCCESS, dsc_cached.getInstance().findZone(
+                  bundy::dns::Name("example.org.")).code);
 }
 
 TEST(FactoryTest, badType) {
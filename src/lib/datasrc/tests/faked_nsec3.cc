@@ -95,6 +95,19 @@ public:
         const Name name(ls.toText());
         return (calculate(name));
     }
+    virtual void calculateBatch(const LabelSequence* const labels[],
+                                size_t count, string hashes[]) const
+    {
+        // The in-memory findNSEC3() hashes names it may not need along
+        // with those it does.  The former don't have to be in the map;
+        // they get an empty string, which can't be converted to a name
+        // if it's ever used.
+        for (size_t i = 0; i < count; ++i) {
+            const NSEC3HashMap::const_iterator found =
+                map_.find(Name(labels[i]->toText()));
+            hashes[i] = (found != map_.end()) ? found->second : "";
+        }
+    }
     virtual bool match(const rdata::generic::NSEC3PARAM&) const {
         return (true);
     }
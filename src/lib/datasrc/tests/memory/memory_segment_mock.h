@@ -33,21 +33,31 @@ namespace test {
 // allocate() will succeed, and the 3rd call will fail with an exception.
 // This segment object can be used after the exception is thrown, and the
 // count is internally reset to 0.
+// It also keeps track of the total size of memory currently allocated, which
+// can be retrieved via getAllocatedSize().
 class MemorySegmentMock : public bundy::util::MemorySegmentLocal {
 public:
-    MemorySegmentMock() : throw_count_(0) {}
+    MemorySegmentMock() : throw_count_(0), allocated_size_(0) {}
     virtual void* allocate(std::size_t size) {
         if (throw_count_ > 0) {
             if (--throw_count_ == 0) {
                 throw std::bad_alloc();
             }
         }
-        return (bundy::util::MemorySegmentLocal::allocate(size));
+        void* p = bundy::util::MemorySegmentLocal::allocate(size);
+        allocated_size_ += size;
+        return (p);
+    }
+    virtual void deallocate(void* ptr, std::size_t size) {
+        bundy::util::MemorySegmentLocal::deallocate(ptr, size);
+        allocated_size_ -= size;
     }
     void setThrowCount(std::size_t count) { throw_count_ = count; }
+    std::size_t getAllocatedSize() const { return (allocated_size_); }
 
 private:
     std::size_t throw_count_;
+    std::size_t allocated_size_;
 };
 
 } // namespace test
@@ -0,0 +1,249 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/nsec3_hash_cache.h>
+#include <datasrc/memory/zone_data.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/nsec3hash.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+
+#include <datasrc/tests/memory/memory_segment_mock.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+using namespace bundy::dns;
+using namespace bundy::dns::rdata;
+using namespace bundy::datasrc::memory;
+using namespace bundy::datasrc::memory::test;
+
+namespace {
+
+// A hash calculator that counts the names it hashes, using the default
+// one for the actual calculation.
+class CountingNSEC3Hash : public NSEC3Hash {
+public:
+    CountingNSEC3Hash(NSEC3Hash* hash, size_t& count) :
+        hash_(hash), count_(count)
+    {}
+    virtual ~CountingNSEC3Hash() {
+        delete hash_;
+    }
+    virtual std::string calculate(const Name& name) const {
+        ++count_;
+        return (hash_->calculate(name));
+    }
+    virtual std::string calculate(const LabelSequence& ls) const {
+        ++count_;
+        return (hash_->calculate(ls));
+    }
+    virtual void calculateBatch(const LabelSequence* const labels[],
+                                size_t count, std::string hashes[]) const
+    {
+        count_ += count;
+        hash_->calculateBatch(labels, count, hashes);
+    }
+    virtual bool match(const generic::NSEC3& nsec3) const {
+        return (hash_->match(nsec3));
+    }
+    virtual bool match(const generic::NSEC3PARAM& nsec3param) const {
+        return (hash_->match(nsec3param));
+    }
+private:
+    NSEC3Hash* const hash_;
+    size_t& count_;
+};
+
+class CountingNSEC3HashCreator : public NSEC3HashCreator {
+public:
+    CountingNSEC3HashCreator() : count_(0) {}
+    virtual NSEC3Hash* create(const generic::NSEC3PARAM& param) const {
+        return (new CountingNSEC3Hash(default_creator_.create(param),
+                                      count_));
+    }
+    virtual NSEC3Hash* create(const generic::NSEC3& nsec3) const {
+        return (new CountingNSEC3Hash(default_creator_.create(nsec3),
+                                      count_));
+    }
+    virtual NSEC3Hash* create(uint8_t algorithm, uint16_t iterations,
+                              const uint8_t* salt_data,
+                              size_t salt_length) const
+    {
+        return (new CountingNSEC3Hash(
+                    default_creator_.create(algorithm, iterations,
+                                            salt_data, salt_length),
+                    count_));
+    }
+
+    mutable size_t count_;
+private:
+    DefaultNSEC3HashCreator default_creator_;
+};
+
+class NSEC3HashCacheTest : public ::testing::Test {
+protected:
+    NSEC3HashCacheTest() :
+        cache_(4),
+        origin_("example"),
+        // Parameters of the RFC5155 example
+        nsec3_data_(NSEC3Data::create(mem_sgmt_, origin_,
+                                      generic::NSEC3PARAM("1 0 12 aabbccdd")))
+    {
+        setNSEC3HashCreator(&creator_);
+    }
+
+    ~NSEC3HashCacheTest() {
+        setNSEC3HashCreator(NULL);
+        NSEC3Data::destroy(mem_sgmt_, nsec3_data_, RRClass::IN());
+    }
+
+    // Return the hash of a single name through the cache.
+    std::string calculate(const NSEC3Data& nsec3_data, const Name& name) {
+        const LabelSequence ls(name);
+        const LabelSequence* const labels = &ls;
+        std::string hash;
+        cache_.calculate(nsec3_data, &labels, 1, &hash);
+        return (hash);
+    }
+
+    MemorySegmentMock mem_sgmt_;
+    CountingNSEC3HashCreator creator_;
+    NSEC3HashCache cache_;
+    const Name origin_;
+    NSEC3Data* nsec3_data_;
+};
+
+TEST_F(NSEC3HashCacheTest, badConstruct) {
+    EXPECT_THROW(NSEC3HashCache(0), bundy::InvalidParameter);
+}
+
+TEST_F(NSEC3HashCacheTest, calculate) {
+    EXPECT_EQ(0, cache_.getEntryCount());
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*nsec3_data_, origin_));
+    EXPECT_EQ(1, creator_.count_);
+    EXPECT_EQ(1, cache_.getEntryCount());
+
+    // The second time it comes from the cache.  Names are case insensitive.
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*nsec3_data_, origin_));
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*nsec3_data_, Name("EXAMPLE")));
+    EXPECT_EQ(1, creator_.count_);
+    EXPECT_EQ(1, cache_.getEntryCount());
+}
+
+TEST_F(NSEC3HashCacheTest, batch) {
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*nsec3_data_, origin_));
+
+    // Only the names not in the cache are calculated, in one batch, and
+    // the results are in the order of the names.
+    const Name a_name("a.example");
+    const Name wild_name("*.w.example");
+    const LabelSequence ls0(a_name), ls1(origin_), ls2(wild_name);
+    const LabelSequence* const labels[] = { &ls0, &ls1, &ls2 };
+    std::string hashes[3];
+    cache_.calculate(*nsec3_data_, labels, 3, hashes);
+    EXPECT_EQ("35MTHGPGCU1QG68FAB165KLNSNK3DPVL", hashes[0]);
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM", hashes[1]);
+    EXPECT_EQ("R53BQ7CC2UVMUBFU5OCMM6PERS9TK9EN", hashes[2]);
+    EXPECT_EQ(3, creator_.count_);
+    EXPECT_EQ(3, cache_.getEntryCount());
+
+    cache_.calculate(*nsec3_data_, labels, 3, hashes);
+    EXPECT_EQ(3, creator_.count_);
+}
+
+TEST_F(NSEC3HashCacheTest, parameters) {
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*nsec3_data_, origin_));
+
+    // The same name with other parameters is a different entry.  0
+    // iterations and empty salt: borrowed from the .com zone data.
+    NSEC3Data* nosalt_data =
+        NSEC3Data::create(mem_sgmt_, Name("com"),
+                          generic::NSEC3PARAM("1 0 0 -"));
+    EXPECT_EQ("CK0POJMG874LJREF7EFN8430QVIT8BSM",
+              calculate(*nosalt_data, Name("com")));
+    EXPECT_NE("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*nosalt_data, origin_));
+    EXPECT_EQ(3, creator_.count_);
+    EXPECT_EQ(3, cache_.getEntryCount());
+    NSEC3Data::destroy(mem_sgmt_, nosalt_data, RRClass::IN());
+
+    NSEC3Data* other_salt_data =
+        NSEC3Data::create(mem_sgmt_, origin_,
+                          generic::NSEC3PARAM("1 0 12 aabbccde"));
+    EXPECT_NE("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM",
+              calculate(*other_salt_data, origin_));
+    EXPECT_EQ(4, creator_.count_);
+    NSEC3Data::destroy(mem_sgmt_, other_salt_data, RRClass::IN());
+}
+
+TEST_F(NSEC3HashCacheTest, recycle) {
+    const char* const names[] = {
+        "example", "a.example", "b.example", "c.example"
+    };
+    for (int i = 0; i < 4; ++i) {
+        calculate(*nsec3_data_, Name(names[i]));
+    }
+    EXPECT_EQ(4, cache_.getEntryCount());
+    EXPECT_EQ(4, cache_.getMaxEntries());
+
+    // Use the first one so the second one is the least recently used.
+    calculate(*nsec3_data_, origin_);
+    EXPECT_EQ(4, creator_.count_);
+
+    calculate(*nsec3_data_, Name("d.example"));
+    EXPECT_EQ(5, creator_.count_);
+    EXPECT_EQ(4, cache_.getEntryCount());
+
+    calculate(*nsec3_data_, origin_);
+    calculate(*nsec3_data_, Name("d.example"));
+    EXPECT_EQ(5, creator_.count_);
+    EXPECT_EQ("35MTHGPGCU1QG68FAB165KLNSNK3DPVL",
+              calculate(*nsec3_data_, Name("a.example")));
+    EXPECT_EQ(6, creator_.count_);
+}
+
+TEST_F(NSEC3HashCacheTest, stripes) {
+    // A large cache is split into stripes; it should still behave as a
+    // single cache.
+    NSEC3HashCache cache(10000);
+    EXPECT_EQ(10000, cache.getMaxEntries());
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            std::ostringstream oss;
+            oss << "n" << i << ".example";
+            const Name name(oss.str());
+            const LabelSequence ls(name);
+            const LabelSequence* const labels = &ls;
+            std::string hash;
+            cache.calculate(*nsec3_data_, &labels, 1, &hash);
+            EXPECT_EQ(32, hash.size());
+        }
+        EXPECT_EQ(100, creator_.count_);
+        EXPECT_EQ(100, cache.getEntryCount());
+    }
+}
+
+}
@@ -19,6 +19,7 @@
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/zone_data_updater.h>
 #include <datasrc/memory/segment_object_holder.h>
+#include <datasrc/memory/treenode_rrset.h>
 #include <datasrc/client.h>
 #include <datasrc/zone_iterator.h>
 
@@ -98,7 +99,8 @@ private:
 class MockJournalReader : public ZoneJournalReader {
 public:
     MockJournalReader(const Name& zone_name, uint32_t beg_serial,
-                      uint32_t end_serial, bool broken, bool remove_nsec3)
+                      uint32_t end_serial, bool broken, bool remove_nsec3,
+                      bool unordered)
     {
         EXPECT_TRUE(beg_serial < end_serial);
 
@@ -110,7 +112,9 @@ public:
                                    RRTTL(3600)));
             soa->addRdata(rdata::generic::SOA(zone_name, zone_name, s,
                                               3600, 3600, 3600, 3600));
-            diffs_.push_back(soa); // delete old SOA
+            if (!unordered || s != beg_serial) {
+                diffs_.push_back(soa); // delete old SOA
+            }
             diffs_.push_back(ns); // delete old NS
             if (remove_nsec3 && s == beg_serial) {
                 const RRsetPtr nsec3p(new RRset(zone_name, RRClass::IN(),
@@ -154,7 +158,8 @@ public:
     MockDataSourceClient() :
         DataSourceClient("test"), use_journal_(false), use_null_journal_(false),
         use_null_iterator_(false), use_null_soa_(false),
-        use_broken_soa_(false), use_broken_journal_(false), use_nsec3_(false),
+        use_broken_soa_(false), use_broken_journal_(false),
+        use_unordered_journal_(false), use_nsec3_(false),
         remove_nsec3_(false), serial_(1)
     {}
     virtual FindResult findZone(const Name&) const { throw 0; }
@@ -181,7 +186,8 @@ public:
             ZoneJournalReaderPtr reader(new MockJournalReader(
                                             zname, beg, end,
                                             use_broken_journal_,
-                                            remove_nsec3_));
+                                            remove_nsec3_,
+                                            use_unordered_journal_));
             return (std::pair<ZoneJournalReader::Result, ZoneJournalReaderPtr>(
                         ZoneJournalReader::SUCCESS, reader));
         }
@@ -195,6 +201,7 @@ public:
     bool use_null_soa_;
     bool use_broken_soa_;
     bool use_broken_journal_;
+    bool use_unordered_journal_;
     bool use_nsec3_;
     bool remove_nsec3_;
     uint32_t serial_;
@@ -335,14 +342,27 @@ ZoneDataLoaderTest::loadFromDataSourceCommon(bool incremental) {
     EXPECT_TRUE(loader6.isDataReused());
     EXPECT_EQ(zone_data_, loader6.commit(zone_data_));
 
-    // increase the end serial sufficiently large so the internal vector
-    // will be full and JournalReader still has some data.
+    // A longer sequence of many versions.  The whole sequence is read in
+    // load(), and only the net changes are applied on commit: the SOA of
+    // the last version replaces the current one, and the NS, which is
+    // deleted and re-added in each version, stays.
     dsc.serial_ = 120;
     ZoneDataLoader loader7(mem_sgmt_, zclass_, origin, dsc, zone_data_);
     ZoneData* zone_data7 = checkLoad(loader7, incremental, true);
     EXPECT_EQ(zone_data_, zone_data7);
     EXPECT_TRUE(loader7.isDataReused());
     EXPECT_EQ(zone_data_, loader7.commit(zone_data_));
+    const ZoneNode* origin_node = zone_data_->getOriginNode();
+    const RdataSet* soa_rdset = RdataSet::find(origin_node->getData(),
+                                               RRType::SOA());
+    ASSERT_NE(static_cast<const RdataSet*>(NULL), soa_rdset);
+    EXPECT_EQ(1, soa_rdset->getRdataCount());
+    const TreeNodeRRset soa_rrset(zclass_, origin_node, soa_rdset, false);
+    EXPECT_EQ(120, dynamic_cast<const rdata::generic::SOA&>(
+                  soa_rrset.getRdataIterator()->getCurrent()).
+              getSerial().getValue());
+    EXPECT_NE(static_cast<const RdataSet*>(NULL),
+              RdataSet::find(origin_node->getData(), RRType::NS()));
 
     // if getJournalReader returns NULL, it should fall back to iterator-based
     // load.
@@ -365,6 +385,23 @@ ZoneDataLoaderTest::loadFromDataSourceCommon(bool incremental) {
     EXPECT_THROW(loader9.commit(zone_data_), ZoneDataUpdater::RemoveError);
 }
 
+TEST_F(ZoneDataLoaderTest, loadFromUnorderedJournal) {
+    const Name origin("example.com");
+    MockDataSourceClient dsc;
+    zone_data_ = ZoneDataLoader(mem_sgmt_, zclass_, origin, dsc).load();
+
+    // The diff sequence doesn't begin with SOA.  It's detected on load(),
+    // before any change is made to the current data.
+    dsc.serial_ = 5;
+    dsc.use_journal_ = true;
+    dsc.use_unordered_journal_ = true;
+    ZoneDataLoader loader(mem_sgmt_, zclass_, origin, dsc, zone_data_);
+    EXPECT_THROW(loader.load(), ZoneValidationError);
+    EXPECT_NE(static_cast<const RdataSet*>(NULL),
+              RdataSet::find(zone_data_->getOriginNode()->getData(),
+                             RRType::NS()));
+}
+
 TEST_F(ZoneDataLoaderTest, loadFromDataSource) {
     loadFromDataSourceCommon(false);
 }
@@ -13,6 +13,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_name_index.h>
 #include <datasrc/memory/rdata_serialization.h>
 #include <datasrc/memory/rdataset.h>
 
@@ -33,6 +34,8 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/lexical_cast.hpp>
+
 #include <new>                  // for bad_alloc
 #include <string>
 
@@ -358,4 +361,146 @@ TEST_F(ZoneDataTest, removeNSEC3Node) {
     removeCommon<NSEC3Data>(*nsec3_data, nsec3_data->findName(zname_));
 }
 
+TEST_F(ZoneDataTest, nameIndex) {
+    // By default there's no index.
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // Nodes existing on enabling the index are indexed, including the
+    // origin and empty nodes created by splitting a node.
+    ZoneNode* node_www = NULL;
+    ZoneNode* node_mail = NULL;
+    zone_data_->insertName(mem_sgmt_, Name("www.sub.example.com"), &node_www);
+    zone_data_->insertName(mem_sgmt_, Name("mail.sub.example.com"),
+                           &node_mail);
+    zone_data_->enableNameIndex(mem_sgmt_);
+    const ZoneNameIndex* index = zone_data_->getNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL), index);
+    EXPECT_EQ(4, index->getNameCount());
+    EXPECT_EQ(node_www,
+              index->find(LabelSequence(Name("www.sub.example.com"))));
+    EXPECT_EQ(node_mail,
+              index->find(LabelSequence(Name("mail.sub.example.com"))));
+    EXPECT_EQ(zone_data_->findName(Name("sub.example.com")),
+              index->find(LabelSequence(Name("sub.example.com"))));
+    EXPECT_EQ(zone_data_->getOriginNode(),
+              index->find(LabelSequence(zname_)));
+
+    // Lookup is case insensitive, and doesn't match other names.
+    EXPECT_EQ(node_www,
+              index->find(LabelSequence(Name("WWW.Sub.Example.COM"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("www.example.com"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("www.sub.example.org"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("example.com.example.com"))));
+
+    // Names added later are indexed, enough of them to grow the table.
+    for (int i = 0; i < 100; ++i) {
+        ZoneNode* node = NULL;
+        const Name name(Name("n" + boost::lexical_cast<std::string>(i)).
+                        concatenate(zname_));
+        zone_data_->insertName(mem_sgmt_, name, &node);
+        EXPECT_EQ(node, index->find(LabelSequence(name)));
+    }
+    EXPECT_EQ(104, index->getNameCount());
+    EXPECT_EQ(node_www,
+              index->find(LabelSequence(Name("www.sub.example.com"))));
+
+    // Adding an existing name doesn't change the index.
+    ZoneNode* node = NULL;
+    zone_data_->insertName(mem_sgmt_, Name("www.sub.example.com"), &node);
+    EXPECT_EQ(node_www, node);
+    EXPECT_EQ(104, index->getNameCount());
+
+    // Removed nodes, including empty upper ones, are removed from the
+    // index.
+    zone_data_->removeNode(mem_sgmt_, node_www);
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("www.sub.example.com"))));
+    EXPECT_EQ(node_mail,
+              index->find(LabelSequence(Name("mail.sub.example.com"))));
+    zone_data_->removeNode(mem_sgmt_, node_mail);
+    EXPECT_EQ(101, index->getNameCount());
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("mail.sub.example.com"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("sub.example.com"))));
+    for (int i = 0; i < 100; ++i) {
+        const Name name(Name("n" + boost::lexical_cast<std::string>(i)).
+                        concatenate(zname_));
+        EXPECT_EQ(zone_data_->findName(name), index->find(LabelSequence(name)));
+    }
+
+    // Enabling it again is harmless.
+    zone_data_->enableNameIndex(mem_sgmt_);
+    EXPECT_EQ(index, zone_data_->getNameIndex());
+    EXPECT_EQ(101, index->getNameCount());
+}
+
+TEST_F(ZoneDataTest, nameIndexCallbackAbove) {
+    ZoneNode* node_cut = NULL;
+    ZoneNode* node_glue = NULL;
+    zone_data_->insertName(mem_sgmt_, Name("child.example.com"), &node_cut);
+    zone_data_->insertName(mem_sgmt_, Name("ns.child.example.com"),
+                           &node_glue);
+    node_cut->setFlag(ZoneNode::FLAG_CALLBACK);
+    zone_data_->enableNameIndex(mem_sgmt_);
+    const ZoneNameIndex* index = zone_data_->getNameIndex();
+
+    // Only a callback of an ancestor is reported.
+    bool callback_above = true;
+    EXPECT_EQ(node_cut, index->find(LabelSequence(Name("child.example.com")),
+                                    &callback_above));
+    EXPECT_FALSE(callback_above);
+    EXPECT_EQ(node_glue,
+              index->find(LabelSequence(Name("ns.child.example.com")),
+                          &callback_above));
+    EXPECT_TRUE(callback_above);
+}
+
+TEST_F(ZoneDataTest, getMemoryUsage) {
+    // Initially there's only the origin node.
+    ZoneDataMemoryUsage usage = zone_data_->getMemoryUsage(RRClass::IN());
+    EXPECT_EQ(1, usage.node_count);
+    EXPECT_EQ(0, usage.rdataset_count);
+    EXPECT_EQ(0, usage.rdataset_bytes);
+    EXPECT_EQ(0, usage.nsec3_bytes);
+    EXPECT_EQ(0, usage.name_index_bytes);
+    EXPECT_EQ(mem_sgmt_.getAllocatedSize(), usage.getTotal());
+
+    // Add some names and RdataSets, NSEC3 data and the name index.  All
+    // memory allocated for the zone should be accounted for.
+    ZoneNode* node = NULL;
+    zone_data_->insertName(mem_sgmt_, a_rrset_->getName(), &node);
+    RdataSet* rdataset_a =
+        RdataSet::create(mem_sgmt_, encoder_, a_rrset_, ConstRRsetPtr());
+    node->setData(rdataset_a);
+    RdataSet* rdataset_aaaa =
+        RdataSet::create(mem_sgmt_, encoder_, aaaa_rrset_, ConstRRsetPtr());
+    rdataset_a->next = rdataset_aaaa;
+    zone_data_->insertName(mem_sgmt_, Name("a.b.example.com"), &node);
+
+    NSEC3Data* nsec3_data = NSEC3Data::create(mem_sgmt_, zname_,
+                                              param_rdata_);
+    zone_data_->setNSEC3Data(nsec3_data); // for auto delete in teardown
+    nsec3_data->insertName(mem_sgmt_, nsec3_rrset_->getName(), &node);
+    node->setData(RdataSet::create(mem_sgmt_, encoder_, nsec3_rrset_,
+                                   ConstRRsetPtr()));
+
+    zone_data_->enableNameIndex(mem_sgmt_);
+
+    usage = zone_data_->getMemoryUsage(RRClass::IN());
+    EXPECT_EQ(3, usage.node_count);
+    EXPECT_EQ(2, usage.rdataset_count);
+    EXPECT_EQ(rdataset_a->getMemorySize(RRClass::IN()) +
+              rdataset_aaaa->getMemorySize(RRClass::IN()),
+              usage.rdataset_bytes);
+    EXPECT_LT(0, usage.nsec3_bytes);
+    EXPECT_EQ(zone_data_->getNameIndex()->getMemorySize(),
+              usage.name_index_bytes);
+    EXPECT_EQ(mem_sgmt_.getAllocatedSize(), usage.getTotal());
+}
+
 }
@@ -27,6 +27,7 @@
 #include <datasrc/memory/zone_finder.h>
 #include <datasrc/memory/zone_data_updater.h>
 #include <datasrc/memory/rdata_serialization.h>
+#include <datasrc/memory/zone_name_index.h>
 #include <datasrc/memory/zone_table_segment.h>
 #include <datasrc/memory/memory_client.h>
 #include <datasrc/exceptions.h>
@@ -680,6 +681,40 @@ TEST_F(InMemoryZoneFinderTest, glue) {
              NULL, ZoneFinder::FIND_GLUE_OK);
 }
 
+// The results must be the same with the name index; the index is only used
+// when the tree search wouldn't find anything special on the way.
+TEST_F(InMemoryZoneFinderTest, findWithNameIndex) {
+    zone_data_->enableNameIndex(mem_sgmt_);
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    addToZoneData(rr_a_);
+    addToZoneData(rr_ns_);
+    addToZoneData(rr_child_ns_);
+    addToZoneData(rr_child_glue_);
+    addToZoneData(rr_dname_);
+    addToZoneData(rr_dname_a_);
+    addToZoneData(rr_cname_);
+
+    findTest(origin_, RRType::A(), ZoneFinder::SUCCESS, true, rr_a_);
+    findTest(origin_, RRType::TXT(), ZoneFinder::NXRRSET, true);
+    findTest(rr_cname_->getName(), RRType::A(), ZoneFinder::CNAME, true,
+             rr_cname_);
+    findTest(Name("child.example.org"), RRType::A(), ZoneFinder::DELEGATION,
+             true, rr_child_ns_);
+    findTest(rr_child_glue_->getName(), RRType::A(), ZoneFinder::DELEGATION,
+             true, rr_child_ns_);
+    findTest(rr_child_glue_->getName(), RRType::A(), ZoneFinder::SUCCESS, true,
+             rr_child_glue_, ZoneFinder::RESULT_DEFAULT, NULL,
+             ZoneFinder::FIND_GLUE_OK);
+    findTest(rr_dname_->getName(), RRType::A(), ZoneFinder::SUCCESS, true,
+             rr_dname_a_);
+    findTest(Name("below.dname.example.org"), RRType::A(), ZoneFinder::DNAME,
+             true, rr_dname_);
+    findTest(Name("nosuch.example.org"), RRType::A(), ZoneFinder::NXDOMAIN,
+             true);
+}
+
 TEST_F(InMemoryZoneFinderTest, findAtOrigin) {
     // Add origin NS.
     rr_ns_->addRRsig(createRdata(RRType::RRSIG(), RRClass::IN(),
@@ -0,0 +1,322 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_snapshot.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/rrset_collection.h>
+#include <datasrc/memory/zone_data.h>
+
+#include <dns/master_loader.h>
+#include <dns/name.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrcollator.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+
+#include <datasrc/tests/memory/memory_segment_mock.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace bundy::dns;
+using namespace bundy::datasrc;
+using namespace bundy::datasrc::memory;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char* const SNAPSHOT_FILE = TEST_DATA_BUILDDIR "/test.snapshot";
+const char* const SNAPSHOT_TMP_FILE = TEST_DATA_BUILDDIR "/test.snapshot.tmp";
+
+// An iterator over a given list of RRsets.
+class VectorIterator : public ZoneIterator {
+public:
+    VectorIterator(const vector<ConstRRsetPtr>& rrsets) :
+        rrsets_(rrsets), it_(rrsets_.begin())
+    {}
+    virtual ConstRRsetPtr getNextRRset() {
+        return (it_ == rrsets_.end() ? ConstRRsetPtr() : *it_++);
+    }
+    virtual ConstRRsetPtr getSOA() const {
+        return (rrsets_.front());
+    }
+private:
+    const vector<ConstRRsetPtr> rrsets_;
+    vector<ConstRRsetPtr>::const_iterator it_;
+};
+
+void
+addToVector(vector<ConstRRsetPtr>* rrsets, const RRsetPtr& rrset) {
+    rrsets->push_back(rrset);
+}
+
+void
+ignoreMessage(const string&, size_t, const string&) {
+}
+
+class ZoneSnapshotTest : public ::testing::Test {
+protected:
+    ZoneSnapshotTest() :
+        origin_("example.org"), zclass_(RRClass::IN())
+    {
+        std::remove(SNAPSHOT_FILE);
+        std::remove(SNAPSHOT_TMP_FILE);
+    }
+    ~ZoneSnapshotTest() {
+        std::remove(SNAPSHOT_FILE);
+        std::remove(SNAPSHOT_TMP_FILE);
+    }
+
+    // Read the RRsets of a master file.
+    vector<ConstRRsetPtr> readMasterFile(const string& zone_file) {
+        vector<ConstRRsetPtr> rrsets;
+        RRCollator collator(boost::bind(addToVector, &rrsets, _1));
+        MasterLoader loader(zone_file.c_str(), origin_, zclass_,
+                            MasterLoaderCallbacks(ignoreMessage,
+                                                  ignoreMessage),
+                            collator.getCallback());
+        loader.load();
+        collator.flush();
+        return (rrsets);
+    }
+
+    // Load a zone with ZoneDataLoader and return the text of all RRsets
+    // found in it for the given RRsets (whose RRSIGs are ignored).
+    vector<string> loadZone(const string& zone_file,
+                            const vector<ConstRRsetPtr>& rrsets)
+    {
+        ZoneDataLoader loader(mem_sgmt_, zclass_, origin_, zone_file);
+        ZoneData* zone_data = loader.load();
+        vector<string> result;
+        {
+            memory::RRsetCollection collection(*zone_data, zclass_);
+            for (size_t i = 0; i < rrsets.size(); ++i) {
+                if (rrsets[i]->getType() == RRType::RRSIG()) {
+                    continue;
+                }
+                const ConstRRsetPtr found =
+                    collection.find(rrsets[i]->getName(), zclass_,
+                                    rrsets[i]->getType());
+                result.push_back(found ? found->toText() : "");
+            }
+        }
+        ZoneData::destroy(mem_sgmt_, zone_data, zclass_);
+        return (result);
+    }
+
+    // Overwrite a byte of the snapshot file.
+    void corruptSnapshot(long pos, char c) {
+        std::fstream file(SNAPSHOT_FILE, std::ios_base::in |
+                          std::ios_base::out | std::ios_base::binary);
+        file.seekp(pos, pos < 0 ? std::ios_base::end : std::ios_base::beg);
+        file.put(c);
+    }
+
+    // Open a snapshot and read all of its RRsets.
+    void readSnapshot(const char* filename, const Name& origin,
+                      const RRClass& rrclass)
+    {
+        ZoneSnapshotReader reader(filename, origin, rrclass);
+        while (reader.getNextRRset()) {
+            ;
+        }
+    }
+
+    // Corruption may only be detected at the end of the snapshot.
+    void checkBrokenSnapshot() {
+        EXPECT_THROW(readSnapshot(SNAPSHOT_FILE, origin_, zclass_),
+                     ZoneSnapshotError);
+    }
+
+    // Write a snapshot of the RRsets.
+    void writeSnapshot(const vector<ConstRRsetPtr>& rrsets) {
+        VectorIterator iterator(rrsets);
+        writeZoneSnapshot(iterator, origin_, zclass_, SNAPSHOT_FILE);
+    }
+
+    const Name origin_;
+    const RRClass zclass_;
+    test::MemorySegmentMock mem_sgmt_;
+};
+
+// A zone loaded from its snapshot is the same as the one loaded from the
+// master file.
+TEST_F(ZoneSnapshotTest, loadSnapshot) {
+    const char* const zone_files[] = {
+        TEST_DATA_DIR "/example.org-rrsigs.zone",
+        TEST_DATA_DIR "/example.org-nsec3-signed.zone",
+        TEST_DATA_DIR "/example.org-multiple.zone"
+    };
+    for (size_t i = 0; i < sizeof(zone_files) / sizeof(zone_files[0]); ++i) {
+        SCOPED_TRACE(zone_files[i]);
+        const vector<ConstRRsetPtr> rrsets = readMasterFile(zone_files[i]);
+        VectorIterator iterator(rrsets);
+        EXPECT_EQ(rrsets.size(),
+                  writeZoneSnapshot(iterator, origin_, zclass_,
+                                    SNAPSHOT_FILE));
+        EXPECT_TRUE(isZoneSnapshot(SNAPSHOT_FILE));
+        EXPECT_FALSE(isZoneSnapshot(zone_files[i]));
+
+        const vector<string> expected = loadZone(zone_files[i], rrsets);
+        EXPECT_TRUE(expected == loadZone(SNAPSHOT_FILE, rrsets));
+    }
+    EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated());
+}
+
+// RRsets, including the attached RRSIGs, are read back as they were
+// written.
+TEST_F(ZoneSnapshotTest, readWrite) {
+    const vector<ConstRRsetPtr> rrsets =
+        readMasterFile(TEST_DATA_DIR "/example.org-rrsigs.zone");
+
+    ZoneSnapshotWriter writer(SNAPSHOT_FILE, origin_, zclass_);
+    for (size_t i = 0; i < rrsets.size(); ++i) {
+        writer.addRRset(*rrsets[i]);
+    }
+    writer.close();
+    EXPECT_THROW(writer.close(), ZoneSnapshotError);
+    EXPECT_THROW(writer.addRRset(*rrsets[0]), ZoneSnapshotError);
+
+    ZoneSnapshotReader reader(SNAPSHOT_FILE, origin_, zclass_);
+    for (size_t i = 0; i < rrsets.size(); ++i) {
+        const ConstRRsetPtr rrset = reader.getNextRRset();
+        ASSERT_TRUE(rrset);
+        EXPECT_EQ(rrsets[i]->toText(), rrset->toText());
+    }
+    EXPECT_FALSE(reader.getNextRRset());
+    EXPECT_FALSE(reader.getNextRRset()); // stays at the end
+}
+
+TEST_F(ZoneSnapshotTest, signatures) {
+    const RRsetPtr rrset(new RRset(Name("www.example.org"), zclass_,
+                                   RRType::A(), RRTTL(300)));
+    rrset->addRdata(rdata::in::A("192.0.2.1"));
+    const RRsetPtr sigs(new RRset(Name("www.example.org"), zclass_,
+                                  RRType::RRSIG(), RRTTL(600)));
+    sigs->addRdata(rdata::generic::RRSIG("A 7 3 300 20150420235959 "
+                                         "20051021000000 40430 example.org. "
+                                         "FAKEFAKE"));
+    rrset->addRRsig(sigs);
+    rrset->getRRsig()->setTTL(RRTTL(600)); // reset by addRRsig()
+
+    ZoneSnapshotWriter writer(SNAPSHOT_FILE, origin_, zclass_);
+    writer.addRRset(*rrset);
+    writer.close();
+
+    ZoneSnapshotReader reader(SNAPSHOT_FILE, origin_, zclass_);
+    const ConstRRsetPtr result = reader.getNextRRset();
+    ASSERT_TRUE(result);
+    EXPECT_EQ(rrset->toText(), result->toText());
+    ASSERT_TRUE(result->getRRsig());
+    EXPECT_EQ(sigs->toText(), result->getRRsig()->toText());
+    EXPECT_EQ(RRTTL(300), result->getTTL());
+    EXPECT_FALSE(reader.getNextRRset());
+}
+
+// Snapshots are recognized by the file name, not the content.
+TEST_F(ZoneSnapshotTest, isZoneSnapshot) {
+    EXPECT_TRUE(isZoneSnapshot(SNAPSHOT_FILE));
+    EXPECT_TRUE(isZoneSnapshot(TEST_DATA_BUILDDIR "/no-such-file.snapshot"));
+    EXPECT_FALSE(isZoneSnapshot(TEST_DATA_DIR "/example.org.zone"));
+    EXPECT_FALSE(isZoneSnapshot(".snapshot"));
+    EXPECT_FALSE(isZoneSnapshot("example.snapshot.zone"));
+    EXPECT_FALSE(isZoneSnapshot(""));
+}
+
+// Broken, incomplete, and mismatching snapshots are rejected.
+TEST_F(ZoneSnapshotTest, badSnapshot) {
+    EXPECT_THROW(readSnapshot(TEST_DATA_BUILDDIR "/no-such-file",
+                              origin_, zclass_), ZoneSnapshotError);
+    EXPECT_THROW(readSnapshot(TEST_DATA_DIR "/example.org.zone",
+                              origin_, zclass_), ZoneSnapshotError);
+
+    const vector<ConstRRsetPtr> rrsets =
+        readMasterFile(TEST_DATA_DIR "/example.org-rrsigs.zone");
+    {
+        // Not closed: the data only goes to the temporary file, which is
+        // removed.
+        ZoneSnapshotWriter writer(SNAPSHOT_FILE, origin_, zclass_);
+        for (size_t i = 0; i < rrsets.size(); ++i) {
+            writer.addRRset(*rrsets[i]);
+        }
+        EXPECT_TRUE(std::ifstream(SNAPSHOT_TMP_FILE).good());
+        EXPECT_FALSE(std::ifstream(SNAPSHOT_FILE).good());
+    }
+    EXPECT_FALSE(std::ifstream(SNAPSHOT_TMP_FILE).good());
+    EXPECT_FALSE(std::ifstream(SNAPSHOT_FILE).good());
+
+    writeSnapshot(rrsets);
+    EXPECT_FALSE(std::ifstream(SNAPSHOT_TMP_FILE).good());
+    EXPECT_NO_THROW(readSnapshot(SNAPSHOT_FILE, origin_, zclass_));
+
+    {
+        // An unfinished write leaves the existing snapshot intact.
+        ZoneSnapshotWriter writer(SNAPSHOT_FILE, origin_, zclass_);
+        writer.addRRset(*rrsets[0]);
+    }
+    EXPECT_NO_THROW(readSnapshot(SNAPSHOT_FILE, origin_, zclass_));
+
+    // Another zone or class.
+    EXPECT_THROW(readSnapshot(SNAPSHOT_FILE, Name("example.com"),
+                              zclass_), ZoneSnapshotError);
+    EXPECT_THROW(readSnapshot(SNAPSHOT_FILE, origin_, RRClass::CH()),
+                 ZoneSnapshotError);
+
+    // Data or checksum changed.
+    corruptSnapshot(100, 'x');
+    checkBrokenSnapshot();
+    writeSnapshot(rrsets);
+    corruptSnapshot(-1, 'x');
+    checkBrokenSnapshot();
+
+    // Truncated.
+    writeSnapshot(rrsets);
+    {
+        std::ifstream file(SNAPSHOT_FILE, std::ios_base::binary);
+        const string data((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+        file.close();
+        std::ofstream out(SNAPSHOT_FILE, std::ios_base::binary |
+                          std::ios_base::trunc);
+        out.write(data.data(), data.size() / 2);
+    }
+    checkBrokenSnapshot();
+
+    // Unknown version.
+    writeSnapshot(rrsets);
+    corruptSnapshot(9, 99);
+    checkBrokenSnapshot();
+
+    // ZoneDataLoader reports the error as a load error.
+    ZoneDataLoader loader(mem_sgmt_, zclass_, origin_, SNAPSHOT_FILE);
+    EXPECT_THROW(loader.load(), ZoneLoaderException);
+    EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated());
+
+    // The file cannot be created.
+    EXPECT_THROW(ZoneSnapshotWriter writer(TEST_DATA_BUILDDIR
+                                           "/no-such-dir/file",
+                                           origin_, zclass_),
+                 ZoneSnapshotError);
+}
+
+}
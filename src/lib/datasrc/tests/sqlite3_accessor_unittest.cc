@@ -18,7 +18,12 @@
 
 #include <datasrc/exceptions.h>
 
+#include <dns/rdata.h>
 #include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <util/buffer.h>
+#include <util/unittests/wiredata.h>
 
 #include <exceptions/exceptions.h>
 
@@ -40,7 +45,10 @@ using boost::lexical_cast;
 using bundy::data::ConstElementPtr;
 using bundy::data::Element;
 using bundy::dns::RRClass;
+using bundy::dns::RRType;
 using bundy::dns::Name;
+using bundy::util::OutputBuffer;
+using bundy::util::unittests::matchWireData;
 
 namespace {
 // Some test data
@@ -1113,6 +1121,94 @@ TEST_F(SQLite3Update, nsec3IteratorOnAdd) {
     EXPECT_FALSE(context->getNext(data));
 }
 
+// Check the context provides the wire-format rdata matching the given text
+// for the record it currently points to.
+void
+checkRdataWire(const DatabaseAccessor::IteratorContext& context,
+               const char* const rrtype, const char* const rdata)
+{
+    OutputBuffer expected(0);
+    bundy::dns::rdata::createRdata(RRType(rrtype), RRClass::IN(),
+                                   rdata)->toWire(expected);
+    const uint8_t* data;
+    size_t len;
+    ASSERT_TRUE(context.getRdataWire(data, len));
+    matchWireData(expected.getData(), expected.getLength(), data, len);
+}
+
+TEST_F(SQLite3Create, addRecordWithWireRdata) {
+    // A newly created database has the rdata_wire columns, and added
+    // records are stored in both the text and wire formats.
+    boost::shared_ptr<SQLite3Accessor> accessor(
+        new SQLite3Accessor(SQLITE_NEW_DBFILE, "IN"));
+    accessor->startTransaction();
+    accessor->addZone("example.com.");
+    accessor->commit();
+
+    const int zone_id = accessor->startUpdateZone("example.com.",
+                                                  false).second;
+    string add_columns[DatabaseAccessor::ADD_COLUMN_COUNT];
+    copy(new_data, new_data + DatabaseAccessor::ADD_COLUMN_COUNT,
+         add_columns);
+    accessor->addRecordToZone(add_columns);
+    string add_nsec3_columns[DatabaseAccessor::ADD_NSEC3_COLUMN_COUNT];
+    copy(nsec3_data, nsec3_data + DatabaseAccessor::ADD_NSEC3_COLUMN_COUNT,
+         add_nsec3_columns);
+    accessor->addNSEC3RecordToZone(add_nsec3_columns);
+    // Broken rdata can't be converted; it's stored as text only.
+    add_columns[DatabaseAccessor::ADD_NAME] = "broken.example.com.";
+    add_columns[DatabaseAccessor::ADD_REV_NAME] = "com.example.broken.";
+    add_columns[DatabaseAccessor::ADD_RDATA] = "bad";
+    accessor->addRecordToZone(add_columns);
+    accessor->commit();
+
+    string columns[DatabaseAccessor::COLUMN_COUNT];
+    DatabaseAccessor::IteratorContextPtr context =
+        accessor->getRecords("newdata.example.com.", zone_id);
+    ASSERT_TRUE(context->getNext(columns));
+    checkRecordRow(columns, "A", "3600", "", "192.0.2.1", "");
+    checkRdataWire(*context, "A", "192.0.2.1");
+    EXPECT_FALSE(context->getNext(columns));
+
+    // Same for the subdomain search
+    context = accessor->getRecords("example.com.", zone_id, true);
+    ASSERT_TRUE(context->getNext(columns));
+    EXPECT_EQ("A", columns[DatabaseAccessor::TYPE_COLUMN]);
+
+    context = accessor->getNSEC3Records(apex_hash, zone_id);
+    ASSERT_TRUE(context->getNext(columns));
+    checkRdataWire(*context, "NSEC3",
+                   nsec3_data[DatabaseAccessor::ADD_NSEC3_RDATA]);
+    EXPECT_FALSE(context->getNext(columns));
+
+    context = accessor->getRecords("broken.example.com.", zone_id);
+    ASSERT_TRUE(context->getNext(columns));
+    EXPECT_EQ("bad", columns[DatabaseAccessor::RDATA_COLUMN]);
+    const uint8_t* data;
+    size_t len;
+    EXPECT_FALSE(context->getRdataWire(data, len));
+}
+
+TEST_F(SQLite3Update, noWireRdataInOldSchema) {
+    // The test database is of an older schema without the rdata_wire
+    // columns.  Records, old and new ones, are only available as text.
+    zone_id = accessor->startUpdateZone("example.com.", false).second;
+    copy(new_data, new_data + DatabaseAccessor::ADD_COLUMN_COUNT,
+         add_columns);
+    accessor->addRecordToZone(add_columns);
+    accessor->commit();
+
+    const uint8_t* data;
+    size_t len;
+    iterator = accessor->getRecords("foo.bar.example.com.", zone_id);
+    ASSERT_TRUE(iterator->getNext(get_columns));
+    EXPECT_FALSE(iterator->getRdataWire(data, len));
+    iterator = accessor->getRecords("newdata.example.com.", zone_id);
+    ASSERT_TRUE(iterator->getNext(get_columns));
+    EXPECT_EQ("192.0.2.1", get_columns[DatabaseAccessor::RDATA_COLUMN]);
+    EXPECT_FALSE(iterator->getRdataWire(data, len));
+}
+
 TEST_F(SQLite3Update, addThenRollback) {
     zone_id = accessor->startUpdateZone("example.com.", false).second;
     copy(new_data, new_data + DatabaseAccessor::ADD_COLUMN_COUNT,
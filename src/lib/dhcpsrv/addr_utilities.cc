@@ -15,6 +15,8 @@
 #include <dhcpsrv/addr_utilities.h>
 #include <exceptions/exceptions.h>
 
+#include <limits>
+
 #include <string.h>
 
 using namespace bundy;
@@ -168,6 +170,29 @@ bundy::asiolink::IOAddress lastAddrInPrefix6(const bundy::asiolink::IOAddress& p
     return (bundy::asiolink::IOAddress::fromBytes(AF_INET6, packed));
 }
 
+/// @brief converts an address to a 128-bit number
+///
+/// IPv4 addresses are stored in the lowest 32 bits.
+///
+/// @param addr the address
+/// @param hi [out] the high 64 bits
+/// @param lo [out] the low 64 bits
+void addrToWords(const bundy::asiolink::IOAddress& addr, uint64_t& hi,
+                 uint64_t& lo) {
+    const std::vector<uint8_t>& bytes = addr.toBytes();
+    hi = 0;
+    lo = 0;
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        hi = (hi << 8) | (lo >> 56);
+        lo = (lo << 8) | bytes[i];
+    }
+}
+
+/// @brief returns the number of bits in an address of the family
+unsigned int addrBits(const bundy::asiolink::IOAddress& addr) {
+    return (addr.isV4() ? 32 : 128);
+}
+
 }; // end of anonymous namespace
 
 namespace bundy {
@@ -205,5 +230,75 @@ bundy::asiolink::IOAddress getNetmask4(uint8_t len) {
     return (IOAddress(x));
 }
 
+uint64_t prefixesInRange(const bundy::asiolink::IOAddress& min,
+                         const bundy::asiolink::IOAddress& max,
+                         uint8_t len) {
+    if (min.getFamily() != max.getFamily()) {
+        bundy_throw(BadValue, "Address family mismatch: " << min << " and "
+                  << max);
+    }
+    if (len == 0 || len > addrBits(min)) {
+        bundy_throw(BadValue, "Invalid prefix length " << static_cast<int>(len));
+    }
+    if (max < min) {
+        bundy_throw(BadValue, max << " is smaller than " << min);
+    }
+
+    uint64_t min_hi, min_lo, max_hi, max_lo;
+    addrToWords(min, min_hi, min_lo);
+    addrToWords(max, max_hi, max_lo);
+
+    // Calculate the difference and shift the host bits out.
+    uint64_t hi = max_hi - min_hi - (max_lo < min_lo ? 1 : 0);
+    uint64_t lo = max_lo - min_lo;
+    const unsigned int shift = addrBits(min) - len;
+    if (shift >= 64) {
+        lo = (shift == 128 ? 0 : hi >> (shift - 64));
+        hi = 0;
+    } else if (shift > 0) {
+        lo = (lo >> shift) | (hi << (64 - shift));
+        hi >>= shift;
+    }
+
+    if (hi != 0 || lo == std::numeric_limits<uint64_t>::max()) {
+        return (std::numeric_limits<uint64_t>::max());
+    }
+    return (lo + 1);
+}
+
+bundy::asiolink::IOAddress offsetPrefix(const bundy::asiolink::IOAddress& prefix,
+                                        uint64_t offset, uint8_t len) {
+    if (len == 0 || len > addrBits(prefix)) {
+        bundy_throw(BadValue, "Invalid prefix length " << static_cast<int>(len));
+    }
+
+    // Shift the offset to the prefix bits.
+    const unsigned int shift = addrBits(prefix) - len;
+    uint64_t offset_hi = 0;
+    uint64_t offset_lo = offset;
+    if (shift >= 64) {
+        offset_hi = offset << (shift - 64);
+        offset_lo = 0;
+    } else if (shift > 0) {
+        offset_hi = offset >> (64 - shift);
+        offset_lo = offset << shift;
+    }
+
+    uint64_t hi, lo;
+    addrToWords(prefix, hi, lo);
+    lo += offset_lo;
+    hi += offset_hi + (lo < offset_lo ? 1 : 0);
+
+    // Convert it back, dropping whatever overflowed.
+    uint8_t packed[V6ADDRESS_LEN];
+    const size_t bytes = addrBits(prefix) / 8;
+    for (size_t i = bytes; i > 0; --i) {
+        packed[i - 1] = lo & 0xff;
+        lo = (lo >> 8) | (hi << 56);
+        hi >>= 8;
+    }
+    return (IOAddress::fromBytes(prefix.getFamily(), packed));
+}
+
 };
 };
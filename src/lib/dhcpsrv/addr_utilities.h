@@ -57,6 +57,40 @@ bundy::asiolink::IOAddress lastAddrInPrefix(const bundy::asiolink::IOAddress& pr
 /// @return netmask
 bundy::asiolink::IOAddress getNetmask4(uint8_t len);
 
+/// @brief returns the number of prefixes of a given length in a range
+///
+/// Example: For 2001:db8:: - 2001:db8:0:ff:ffff:ffff:ffff:ffff and length
+/// /64 the function will return 256. For addresses, the length is 32 (IPv4)
+/// or 128 (IPv6) and the function returns the number of addresses.
+///
+/// @throw BadValue if the addresses are of different families, max is
+/// smaller than min or the length is invalid
+///
+/// @param min the first address in the range
+/// @param max the last address in the range
+/// @param len prefix length
+///
+/// @return the number of prefixes, or the largest uint64_t value if there
+/// are more
+uint64_t prefixesInRange(const bundy::asiolink::IOAddress& min,
+                         const bundy::asiolink::IOAddress& max,
+                         uint8_t len);
+
+/// @brief returns a prefix a given number of prefixes after another one
+///
+/// Example: For 2001:db8::, offset 2 and length /64 the function will
+/// return 2001:db8:0:2::. The result wraps around the address space.
+///
+/// @throw BadValue if the length is invalid
+///
+/// @param prefix the prefix (or address) to start from
+/// @param offset the number of prefixes to skip
+/// @param len prefix length
+///
+/// @return the prefix
+bundy::asiolink::IOAddress offsetPrefix(const bundy::asiolink::IOAddress& prefix,
+                                        uint64_t offset, uint8_t len);
+
 };
 };
 
@@ -12,6 +12,7 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <dhcpsrv/addr_utilities.h>
 #include <dhcpsrv/alloc_engine.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/lease_mgr_factory.h>
@@ -20,8 +21,10 @@
 #include <hooks/hooks_manager.h>
 
 #include <cstring>
+#include <limits>
 #include <vector>
 #include <string.h>
+#include <time.h>
 
 using namespace bundy::asiolink;
 using namespace bundy::hooks;
@@ -48,11 +51,92 @@ struct AllocEngineHooks {
 // module is called.
 AllocEngineHooks Hooks;
 
+/// @brief Finds the subnet with the specified ID.
+///
+/// @return The subnet, or NULL if there's no such subnet.
+template<typename SubnetCollectionType>
+bundy::dhcp::SubnetPtr
+findSubnet(const SubnetCollectionType& subnets, bundy::dhcp::SubnetID id) {
+    for (typename SubnetCollectionType::const_iterator subnet = subnets.begin();
+         subnet != subnets.end(); ++subnet) {
+        if ((*subnet)->getID() == id) {
+            return (*subnet);
+        }
+    }
+    return (bundy::dhcp::SubnetPtr());
+}
+
+/// @brief Calculates the 64-bit FNV-1a hash of the data.
+///
+/// The hash doesn't depend on the platform or the process, so the hashed
+/// allocator picks the same addresses after the server is restarted.
+///
+/// @param data the data to hash
+/// @param hash the hash of the preceding data, if any
+/// @return the hash
+uint64_t
+fnv1aHash(const std::vector<uint8_t>& data,
+          uint64_t hash = 14695981039346656037ULL) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return (hash);
+}
+
 }; // anonymous namespace
 
 namespace bundy {
 namespace dhcp {
 
+uint8_t
+AllocEngine::Allocator::getPrefixLength(const PoolPtr& pool) {
+    Pool6Ptr pool6 = boost::dynamic_pointer_cast<Pool6>(pool);
+    return (pool6 ? pool6->getLength() : 32);
+}
+
+bundy::asiolink::IOAddress
+AllocEngine::Allocator::pickFromPools(const PoolCollection& pools,
+                                      uint64_t position) {
+    // Count the addresses in all pools. If there are more than 2^64 (which
+    // is possible for IPv6), the pools beyond are never picked.
+    std::vector<uint64_t> sizes;
+    uint64_t total = 0;
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        sizes.push_back(prefixesInRange((*pool)->getFirstAddress(),
+                                        (*pool)->getLastAddress(),
+                                        getPrefixLength(*pool)));
+        total += std::min(sizes.back(),
+                          std::numeric_limits<uint64_t>::max() - total);
+    }
+
+    // Find the pool and the address at that position.
+    position %= total;
+    size_t index = 0;
+    while (position >= sizes[index]) {
+        position -= sizes[index];
+        ++index;
+    }
+    const PoolPtr& pool = pools[index];
+    const IOAddress candidate = offsetPrefix(pool->getFirstAddress(),
+                                             position, getPrefixLength(pool));
+
+    // Skip the addresses known to be in use. If the rest of the pool is
+    // used, start over from the beginning of the pool before moving to the
+    // next one.
+    FreeAddressIndexPtr free_index = pool->getFreeIndex();
+    if (!free_index) {
+        return (candidate);
+    }
+    IOAddress free_addr("::");
+    if (free_index->findFree(candidate, free_addr)) {
+        return (free_addr);
+    }
+    const size_t next = (index + 1) % pools.size();
+    return (skipUsedAddresses(pools, next, pools[next]->getFirstAddress()));
+}
+
 AllocEngine::IterativeAllocator::IterativeAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
 }
@@ -175,7 +259,8 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
     // - perhaps allocation algorithm was changed
     if (it == pools.end()) {
         // ok to access first element directly. We checked that pools is non-empty
-        IOAddress next = pools[0]->getFirstAddress();
+        IOAddress next = skipUsedAddresses(pools, 0,
+                                           pools[0]->getFirstAddress());
         subnet->setLastAllocated(pool_type_, next);
         return (next);
     }
@@ -197,6 +282,7 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
     }
     if ((*it)->inRange(next)) {
         // the next one is in the pool as well, so we haven't hit pool boundary yet
+        next = skipUsedAddresses(pools, it - pools.begin(), next);
         subnet->setLastAllocated(pool_type_, next);
         return (next);
     }
@@ -206,41 +292,90 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
     if (it == pools.end()) {
         // Really out of luck today. That was the last pool. Let's rewind
         // to the beginning.
-        next = pools[0]->getFirstAddress();
+        next = skipUsedAddresses(pools, 0, pools[0]->getFirstAddress());
         subnet->setLastAllocated(pool_type_, next);
         return (next);
     }
 
     // there is a next pool, let's try first address from it
-    next = (*it)->getFirstAddress();
+    next = skipUsedAddresses(pools, it - pools.begin(),
+                             (*it)->getFirstAddress());
     subnet->setLastAllocated(pool_type_, next);
     return (next);
 }
 
+bundy::asiolink::IOAddress
+AllocEngine::Allocator::skipUsedAddresses(const PoolCollection& pools,
+                                                   size_t index,
+                                                   const IOAddress& start) {
+    // Search the rest of the pool the start address belongs to, then the
+    // following pools, and finally the same pool again from its beginning.
+    for (size_t i = 0; i <= pools.size(); ++i) {
+        const PoolPtr& pool = pools[(index + i) % pools.size()];
+        const IOAddress& from = (i == 0 ? start : pool->getFirstAddress());
+        FreeAddressIndexPtr free_index = pool->getFreeIndex();
+        if (!free_index) {
+            // We don't know anything about this pool, so let's try it the
+            // usual way.
+            return (from);
+        }
+        IOAddress free_addr("::");
+        if (free_index->findFree(from, free_addr)) {
+            return (free_addr);
+        }
+    }
+
+    // All addresses are marked as used. Some of them may have been released
+    // or expired since they were marked, so forget what we know and check
+    // them in the lease database again.
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        (*pool)->getFreeIndex()->clear();
+    }
+    return (start);
+}
+
 AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
 }
 
 
 bundy::asiolink::IOAddress
-AllocEngine::HashedAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
+AllocEngine::HashedAllocator::pickAddress(const SubnetPtr& subnet,
+                                          const DuidPtr& duid,
+                                          const IOAddress& hint) {
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    // The hint is hashed as well, so each unavailable address leads to
+    // another one. The hash of the same client and hint is always the same.
+    uint64_t hash = fnv1aHash(hint.toBytes());
+    if (duid) {
+        hash = fnv1aHash(duid->getDuid(), hash);
+    }
+    return (pickFromPools(pools, hash));
 }
 
 AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+    generator_.seed(static_cast<uint32_t>(time(NULL)));
 }
 
 
 bundy::asiolink::IOAddress
-AllocEngine::RandomAllocator::pickAddress(const SubnetPtr&,
+AllocEngine::RandomAllocator::pickAddress(const SubnetPtr& subnet,
                                           const DuidPtr&,
                                           const IOAddress&) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    const uint64_t position = (static_cast<uint64_t>(generator_()) << 32) |
+        generator_();
+    return (pickFromPools(pools, position));
 }
 
 
@@ -248,19 +383,36 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
                          bool ipv6)
     :attempts_(attempts) {
 
+    // Initalize the allocators for all lease types
+    allocators_ = createAllocators(engine_type, ipv6);
+
+    // And the allocators that can be selected for a subnet
+    subnet_allocators_["iterative"] = createAllocators(ALLOC_ITERATIVE, ipv6);
+    subnet_allocators_["hashed"] = createAllocators(ALLOC_HASHED, ipv6);
+    subnet_allocators_["random"] = createAllocators(ALLOC_RANDOM, ipv6);
+
+    // Register hook points
+    hook_index_lease4_select_ = Hooks.hook_index_lease4_select_;
+    hook_index_lease6_select_ = Hooks.hook_index_lease6_select_;
+}
+
+std::map<Lease::Type, AllocEngine::AllocatorPtr>
+AllocEngine::createAllocators(AllocType engine_type, bool ipv6) {
+    std::map<Lease::Type, AllocatorPtr> allocators;
+
     // Choose the basic (normal address) lease type
     Lease::Type basic_type = ipv6 ? Lease::TYPE_NA : Lease::TYPE_V4;
 
     // Initalize normal address allocators
     switch (engine_type) {
     case ALLOC_ITERATIVE:
-        allocators_[basic_type] = AllocatorPtr(new IterativeAllocator(basic_type));
+        allocators[basic_type] = AllocatorPtr(new IterativeAllocator(basic_type));
         break;
     case ALLOC_HASHED:
-        allocators_[basic_type] = AllocatorPtr(new HashedAllocator(basic_type));
+        allocators[basic_type] = AllocatorPtr(new HashedAllocator(basic_type));
         break;
     case ALLOC_RANDOM:
-        allocators_[basic_type] = AllocatorPtr(new RandomAllocator(basic_type));
+        allocators[basic_type] = AllocatorPtr(new RandomAllocator(basic_type));
         break;
     default:
         bundy_throw(BadValue, "Invalid/unsupported allocation algorithm");
@@ -271,25 +423,34 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
     if (ipv6) {
         switch (engine_type) {
         case ALLOC_ITERATIVE:
-            allocators_[Lease::TYPE_TA] = AllocatorPtr(new IterativeAllocator(Lease::TYPE_TA));
-            allocators_[Lease::TYPE_PD] = AllocatorPtr(new IterativeAllocator(Lease::TYPE_PD));
+            allocators[Lease::TYPE_TA] = AllocatorPtr(new IterativeAllocator(Lease::TYPE_TA));
+            allocators[Lease::TYPE_PD] = AllocatorPtr(new IterativeAllocator(Lease::TYPE_PD));
             break;
         case ALLOC_HASHED:
-            allocators_[Lease::TYPE_TA] = AllocatorPtr(new HashedAllocator(Lease::TYPE_TA));
-            allocators_[Lease::TYPE_PD] = AllocatorPtr(new HashedAllocator(Lease::TYPE_PD));
+            allocators[Lease::TYPE_TA] = AllocatorPtr(new HashedAllocator(Lease::TYPE_TA));
+            allocators[Lease::TYPE_PD] = AllocatorPtr(new HashedAllocator(Lease::TYPE_PD));
             break;
         case ALLOC_RANDOM:
-            allocators_[Lease::TYPE_TA] = AllocatorPtr(new RandomAllocator(Lease::TYPE_TA));
-            allocators_[Lease::TYPE_PD] = AllocatorPtr(new RandomAllocator(Lease::TYPE_PD));
+            allocators[Lease::TYPE_TA] = AllocatorPtr(new RandomAllocator(Lease::TYPE_TA));
+            allocators[Lease::TYPE_PD] = AllocatorPtr(new RandomAllocator(Lease::TYPE_PD));
             break;
         default:
             bundy_throw(BadValue, "Invalid/unsupported allocation algorithm");
         }
     }
+    return (allocators);
+}
 
-    // Register hook points
-    hook_index_lease4_select_ = Hooks.hook_index_lease4_select_;
-    hook_index_lease6_select_ = Hooks.hook_index_lease6_select_;
+AllocEngine::AllocType
+AllocEngine::allocTypeFromText(const std::string& text) {
+    if (text == "iterative") {
+        return (ALLOC_ITERATIVE);
+    } else if (text == "hashed") {
+        return (ALLOC_HASHED);
+    } else if (text == "random") {
+        return (ALLOC_RANDOM);
+    }
+    bundy_throw(BadValue, "Unknown allocation algorithm: " << text);
 }
 
 Lease6Collection
@@ -302,17 +463,17 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                              Lease6Collection& old_leases) {
 
     try {
-        AllocatorPtr allocator = getAllocator(type);
+        if (!subnet) {
+            bundy_throw(InvalidOperation, "Subnet is required for allocation");
+        }
+
+        AllocatorPtr allocator = getAllocator(type, subnet);
 
         if (!allocator) {
             bundy_throw(InvalidOperation, "No allocator specified for "
                       << Lease6::typeToText(type));
         }
 
-        if (!subnet) {
-            bundy_throw(InvalidOperation, "Subnet is required for allocation");
-        }
-
         if (!duid) {
             bundy_throw(InvalidOperation, "DUID is mandatory for allocation");
         }
@@ -385,6 +546,7 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     return (collection);
                 }
 
+                markAddressUsed(subnet, type, hint);
             }
         }
 
@@ -404,9 +566,15 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // The allocator gets the client's hint first, then the previous
+        // candidate, so that the hashed allocator probes a different address
+        // in each attempt.
+        IOAddress pick_hint = hint;
         unsigned int i = attempts_;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, duid, hint);
+            IOAddress candidate = allocator->pickAddress(subnet, duid,
+                                                         pick_hint);
+            pick_hint = candidate;
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -459,6 +627,9 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     collection.push_back(existing);
                     return (collection);
                 }
+
+                // The lease is in use, so let the allocator skip it.
+                markAddressUsed(subnet, type, candidate);
             }
 
             // Continue trying allocation until we run out of attempts
@@ -493,7 +664,11 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
 
     try {
 
-        AllocatorPtr allocator = getAllocator(Lease::TYPE_V4);
+        if (!subnet) {
+            bundy_throw(InvalidOperation, "Can't allocate IPv4 address without subnet");
+        }
+
+        AllocatorPtr allocator = getAllocator(Lease::TYPE_V4, subnet);
 
         // Allocator is always created in AllocEngine constructor and there is
         // currently no other way to set it, so that check is not really necessary.
@@ -501,10 +676,6 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
             bundy_throw(InvalidOperation, "No allocator selected");
         }
 
-        if (!subnet) {
-            bundy_throw(InvalidOperation, "Can't allocate IPv4 address without subnet");
-        }
-
         if (!hwaddr) {
             bundy_throw(InvalidOperation, "HWAddr must be defined");
         }
@@ -575,6 +746,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                                               fake_allocation));
                 }
 
+                markAddressUsed(subnet, Lease::TYPE_V4, hint);
             }
         }
 
@@ -594,9 +766,23 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // The client identifier used by the allocator (e.g. the hashed
+        // allocator picks the same address for the same client). Clients
+        // which don't send the client identifier are identified by their
+        // hardware address.
+        DuidPtr client_key = clientid;
+        if (!client_key && !hwaddr->hwaddr_.empty()) {
+            client_key.reset(new DUID(hwaddr->hwaddr_));
+        }
+
+        // The allocator gets the client's hint first, then the previous
+        // candidate.
+        IOAddress pick_hint = hint;
         unsigned int i = attempts_;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, clientid, hint);
+            IOAddress candidate = allocator->pickAddress(subnet, client_key,
+                                                         pick_hint);
+            pick_hint = candidate;
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -625,6 +811,9 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                                               hostname, callout_handle,
                                               fake_allocation));
                 }
+
+                // The lease is in use, so let the allocator skip it.
+                markAddressUsed(subnet, Lease::TYPE_V4, candidate);
             }
 
             // Continue trying allocation until we run out of attempts
@@ -793,6 +982,7 @@ Lease6Ptr AllocEngine::reuseExpiredLease(Lease6Ptr& expired,
     if (!fake_allocation) {
         // for REQUEST we do update the lease
         LeaseMgrFactory::instance().updateLease6(expired);
+        markAddressUsed(subnet, expired->type_, expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -874,6 +1064,7 @@ Lease4Ptr AllocEngine::reuseExpiredLease(Lease4Ptr& expired,
     if (!fake_allocation) {
         // for REQUEST we do update the lease
         LeaseMgrFactory::instance().updateLease4(expired);
+        markAddressUsed(subnet, Lease::TYPE_V4, expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -946,7 +1137,7 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
         bool status = LeaseMgrFactory::instance().addLease(lease);
 
         if (status) {
-
+            markAddressUsed(subnet, type, lease->addr_);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -1042,6 +1233,7 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
         // That is a real (REQUEST) allocation
         bool status = LeaseMgrFactory::instance().addLease(lease);
         if (status) {
+            markAddressUsed(subnet, Lease::TYPE_V4, lease->addr_);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -1088,6 +1280,83 @@ AllocEngine::updateFqdnData(const Lease6Collection& leases,
     return (updated_leases);
 }
 
+void
+AllocEngine::markAddressUsed(const SubnetPtr& subnet, Lease::Type type,
+                             const IOAddress& addr) {
+    const PoolPtr pool = subnet->getPool(type, addr, false);
+    if (pool) {
+        FreeAddressIndexPtr free_index = pool->getFreeIndex();
+        if (free_index) {
+            free_index->markUsed(addr);
+        }
+    }
+}
+
+void
+AllocEngine::markAddressFree(const SubnetPtr& subnet, Lease::Type type,
+                             const IOAddress& addr) {
+    if (!subnet) {
+        return;
+    }
+    const PoolPtr pool = subnet->getPool(type, addr, false);
+    if (pool) {
+        FreeAddressIndexPtr free_index = pool->getFreeIndex();
+        if (free_index) {
+            free_index->markFree(addr);
+        }
+    }
+}
+
+void
+AllocEngine::markAddressFree(const Subnet4Collection& subnets,
+                             const Lease4& lease) {
+    markAddressFree(findSubnet(subnets, lease.subnet_id_), Lease::TYPE_V4,
+                    lease.addr_);
+}
+
+void
+AllocEngine::markAddressFree(const Subnet6Collection& subnets,
+                             const Lease6& lease) {
+    markAddressFree(findSubnet(subnets, lease.subnet_id_), lease.type_,
+                    lease.addr_);
+}
+
+Lease4Collection
+AllocEngine::reclaimExpiredLeases4(const Subnet4Collection& subnets,
+                                   size_t max_leases) {
+    const Lease4Collection expired =
+        LeaseMgrFactory::instance().getExpiredLeases4(max_leases);
+    Lease4Collection reclaimed;
+    for (Lease4Collection::const_iterator lease = expired.begin();
+         lease != expired.end(); ++lease) {
+        // The lease may have been removed in the meantime (e.g. by another
+        // server sharing the database), in which case there's nothing to do.
+        if (!LeaseMgrFactory::instance().deleteLease((*lease)->addr_)) {
+            continue;
+        }
+        markAddressFree(subnets, **lease);
+        reclaimed.push_back(*lease);
+    }
+    return (reclaimed);
+}
+
+Lease6Collection
+AllocEngine::reclaimExpiredLeases6(const Subnet6Collection& subnets,
+                                   size_t max_leases) {
+    const Lease6Collection expired =
+        LeaseMgrFactory::instance().getExpiredLeases6(max_leases);
+    Lease6Collection reclaimed;
+    for (Lease6Collection::const_iterator lease = expired.begin();
+         lease != expired.end(); ++lease) {
+        if (!LeaseMgrFactory::instance().deleteLease((*lease)->addr_)) {
+            continue;
+        }
+        markAddressFree(subnets, **lease);
+        reclaimed.push_back(*lease);
+    }
+    return (reclaimed);
+}
+
 AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     std::map<Lease::Type, AllocatorPtr>::const_iterator alloc = allocators_.find(type);
 
@@ -1098,6 +1367,28 @@ AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     return (alloc->second);
 }
 
+AllocEngine::AllocatorPtr
+AllocEngine::getAllocator(Lease::Type type, const SubnetPtr& subnet) {
+    const std::string& name = subnet->getAllocatorType();
+    if (name.empty()) {
+        return (getAllocator(type));
+    }
+
+    std::map<std::string, std::map<Lease::Type, AllocatorPtr> >::const_iterator
+        allocators = subnet_allocators_.find(name);
+    if (allocators == subnet_allocators_.end()) {
+        bundy_throw(BadValue, "Unknown allocation algorithm " << name
+                    << " selected for subnet " << subnet->toText());
+    }
+    std::map<Lease::Type, AllocatorPtr>::const_iterator alloc =
+        allocators->second.find(type);
+    if (alloc == allocators->second.end()) {
+        bundy_throw(BadValue, "No allocator initialized for pool type "
+                  << Lease::typeToText(type));
+    }
+    return (alloc->second);
+}
+
 AllocEngine::~AllocEngine() {
     // no need to delete allocator. smart_ptr will do the trick for us
 }
@@ -24,8 +24,10 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 #include <map>
+#include <string>
 
 namespace bundy {
 namespace dhcp {
@@ -80,7 +82,8 @@ protected:
         ///
         /// @param subnet next address will be returned from pool of that subnet
         /// @param duid Client's DUID
-        /// @param hint client's hint
+        /// @param hint client's hint in the first call for a lease; the
+        ///        address returned by the previous call in the next calls
         ///
         /// @return the next address
         virtual bundy::asiolink::IOAddress
@@ -100,6 +103,47 @@ protected:
         }
     protected:
 
+        /// @brief Returns the length of the prefixes allocated from a pool
+        ///
+        /// @param pool the pool
+        /// @return delegated prefix length for IPv6 pools, 32 for IPv4 pools
+        static uint8_t getPrefixLength(const PoolPtr& pool);
+
+        /// @brief Picks an address (or prefix) at a position in the pools
+        ///
+        /// All pools are treated as a single range of addresses, and the
+        /// address at the specified position (modulo the total number of
+        /// addresses) is selected. If the address is marked as used in the
+        /// free address index of its pool, the next address not marked is
+        /// returned instead, searching the rest of the pool, then the
+        /// other pools. If all addresses are marked, the marks are cleared
+        /// (see @c skipUsedAddresses()).
+        ///
+        /// @param pools pools of the subnet (must not be empty)
+        /// @param position the position
+        /// @return the address
+        static bundy::asiolink::IOAddress
+        pickFromPools(const PoolCollection& pools, uint64_t position);
+
+        /// @brief Returns the first address not marked as used
+        ///
+        /// The search starts at the specified address of the specified pool
+        /// and continues in the following pools, wrapping around to the
+        /// first pool. It stops at the first pool which has no free address
+        /// index (e.g. it is too large), and returns its first address.
+        ///
+        /// If all addresses are marked as used, the marks are cleared (they
+        /// may be stale, e.g. when the leases were removed by another server
+        /// sharing the database) and the start address is returned.
+        ///
+        /// @param pools pools of the subnet
+        /// @param index index of the pool the start address belongs to
+        /// @param start the address to start the search at
+        /// @return the address found
+        static bundy::asiolink::IOAddress
+        skipUsedAddresses(const PoolCollection& pools, size_t index,
+                          const bundy::asiolink::IOAddress& start);
+
         /// @brief defines pool type allocation
         Lease::Type pool_type_;
     };
@@ -113,6 +157,10 @@ protected:
     /// a pool iteratively, one after another. Once the last address is reached,
     /// it starts allocating from the beginning of the first pool (i.e. it loops
     /// over).
+    ///
+    /// Addresses marked as used in the free address index of the pool (see
+    /// @c Pool::getFreeIndex()) are skipped, so a highly utilized pool doesn't
+    /// take many allocation attempts to find a free address.
     class IterativeAllocator : public Allocator {
     public:
 
@@ -161,7 +209,15 @@ protected:
 
     /// @brief Address/prefix allocator that gets an address based on a hash
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// This allocator picks the address at the position given by a hash of
+    /// the client's DUID (or client identifier) in the pools. So a client
+    /// gets the same address each time it asks for one while the address
+    /// is free, even after the server is restarted, and clients arriving
+    /// at the same time are spread over the pools instead of competing for
+    /// the next address of the iterative allocator.
+    ///
+    /// If the address is not available, the next one is picked based on a
+    /// hash of the DUID and the unavailable address.
     class HashedAllocator : public Allocator {
     public:
 
@@ -171,12 +227,11 @@ protected:
 
         /// @brief returns an address based on hash calculated from client's DUID.
         ///
-        /// @todo: Implement this method
-        ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID
         /// @param hint a hint (last address that was picked)
         /// @return selected address
+        /// @throw AllocFailed if there are no pools in the subnet
         virtual bundy::asiolink::IOAddress pickAddress(const SubnetPtr& subnet,
                                                      const DuidPtr& duid,
                                                      const bundy::asiolink::IOAddress& hint);
@@ -184,25 +239,32 @@ protected:
 
     /// @brief Random allocator that picks address randomly
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// Each address of all pools of the subnet is picked with the same
+    /// probability, except that the addresses known to be in use are
+    /// skipped.
     class RandomAllocator : public Allocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief default constructor
+        ///
+        /// Seeds the random number generator with the current time.
         /// @param type - specifies allocation type
         RandomAllocator(Lease::Type type);
 
         /// @brief returns an random address from pool of specified subnet
         ///
-        /// @todo: Implement this method
-        ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID (ignored)
         /// @param hint the last address that was picked (ignored)
         /// @return a random address from the pool
+        /// @throw AllocFailed if there are no pools in the subnet
         virtual bundy::asiolink::IOAddress
         pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
                     const bundy::asiolink::IOAddress& hint);
+
+    private:
+        /// @brief the random number generator
+        boost::mt19937 generator_;
     };
 
     public:
@@ -214,6 +276,13 @@ protected:
         ALLOC_RANDOM     // random - an address is randomly selected
     } AllocType;
 
+    /// @brief Converts the name of an allocation type to the value
+    ///
+    /// @param text "iterative", "hashed" or "random"
+    /// @return the allocation type
+    /// @throw BadValue if the name is unknown
+    static AllocType allocTypeFromText(const std::string& text);
+
 
     /// @brief Default constructor.
     ///
@@ -354,12 +423,90 @@ protected:
                     const bundy::hooks::CalloutHandlePtr& callout_handle,
                     Lease6Collection& old_leases);
 
+    /// @brief Reclaims expired IPv4 leases.
+    ///
+    /// Removes up to the specified number of expired leases (the ones which
+    /// expired first) from the lease database and marks their addresses as
+    /// free in the pools, so that they can be handed out to new clients
+    /// without being found and reused by the allocation loop. It is meant
+    /// to be called periodically by the server.
+    ///
+    /// The caller is responsible for removing the DNS entries for the
+    /// returned leases.
+    ///
+    /// @param subnets Configured subnets, used to find the pools of the
+    ///        reclaimed addresses
+    /// @param max_leases Maximum number of leases to reclaim (0 for no limit)
+    ///
+    /// @return Reclaimed leases
+    Lease4Collection
+    reclaimExpiredLeases4(const Subnet4Collection& subnets, size_t max_leases);
+
+    /// @brief Reclaims expired IPv6 leases.
+    ///
+    /// The IPv6 version of @c reclaimExpiredLeases4.
+    ///
+    /// @param subnets Configured subnets, used to find the pools of the
+    ///        reclaimed addresses and prefixes
+    /// @param max_leases Maximum number of leases to reclaim (0 for no limit)
+    ///
+    /// @return Reclaimed leases
+    Lease6Collection
+    reclaimExpiredLeases6(const Subnet6Collection& subnets, size_t max_leases);
+
+    /// @brief Marks an address as free in the free address index
+    ///
+    /// It is called when the lease for the address is removed from the
+    /// lease database: when it is reclaimed, released or declined.
+    ///
+    /// @param subnet Subnet the address belongs to (may be NULL if it is
+    ///        no longer configured, in which case nothing is done)
+    /// @param type Type of the lease
+    /// @param addr The address (or prefix)
+    void markAddressFree(const SubnetPtr& subnet, Lease::Type type,
+                         const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Marks the address of a removed IPv4 lease as free
+    ///
+    /// The server calls it after it has deleted the lease from the lease
+    /// database on its own (e.g. on DHCPRELEASE), so that the allocator
+    /// can hand the address out again.
+    ///
+    /// @param subnets Configured subnets, used to find the pool of the
+    ///        address
+    /// @param lease The removed lease
+    void markAddressFree(const Subnet4Collection& subnets,
+                         const Lease4& lease);
+
+    /// @brief Marks the address of a removed IPv6 lease as free
+    ///
+    /// The IPv6 version of the above.
+    ///
+    /// @param subnets Configured subnets, used to find the pool of the
+    ///        address or prefix
+    /// @param lease The removed lease
+    void markAddressFree(const Subnet6Collection& subnets,
+                         const Lease6& lease);
+
     /// @brief returns allocator for a given pool type
     /// @param type type of pool (V4, IA, TA or PD)
     /// @throw BadValue if allocator for a given type is missing
     /// @return pointer to allocator handing a given resource types
     AllocatorPtr getAllocator(Lease::Type type);
 
+    /// @brief returns allocator for a given pool type in a subnet
+    ///
+    /// This is the allocator selected for the subnet (see
+    /// @c Subnet::setAllocatorType()), or the allocator selected for the
+    /// engine if there's none.
+    ///
+    /// @param type type of pool (V4, IA, TA or PD)
+    /// @param subnet the subnet
+    /// @throw BadValue if allocator for a given type is missing or the
+    ///        allocator selected for the subnet is unknown
+    /// @return pointer to allocator handing a given resource types
+    AllocatorPtr getAllocator(Lease::Type type, const SubnetPtr& subnet);
+
     /// @brief Destructor. Used during DHCPv6 service shutdown.
     virtual ~AllocEngine();
 private:
@@ -496,6 +643,25 @@ private:
                                 const bundy::hooks::CalloutHandlePtr& callout_handle,
                                 bool fake_allocation = false);
 
+    /// @brief Creates allocators of a given type
+    ///
+    /// @param engine_type selects allocation algorithm
+    /// @param ipv6 creates allocators for IPv6 leases if true, IPv4 if false
+    /// @return allocators for each lease type
+    static std::map<Lease::Type, AllocatorPtr>
+    createAllocators(AllocType engine_type, bool ipv6);
+
+    /// @brief Marks an address as used in the free address index
+    ///
+    /// It is called when the address is found to be leased, so that the
+    /// allocator doesn't pick it again.
+    ///
+    /// @param subnet Subnet the address belongs to
+    /// @param type Type of the lease
+    /// @param addr The address (or prefix)
+    void markAddressUsed(const SubnetPtr& subnet, Lease::Type type,
+                         const bundy::asiolink::IOAddress& addr);
+
     /// @brief Updates FQDN data for a collection of leases.
     ///
     /// @param leases Collection of leases for which FQDN data should be
@@ -524,6 +690,12 @@ private:
     /// For IPv6, there will be 3 allocators: TYPE_NA, TYPE_TA, TYPE_PD
     std::map<Lease::Type, AllocatorPtr> allocators_;
 
+    /// @brief allocators of each type, selectable for a subnet
+    ///
+    /// The key is the name of the allocation type.
+    std::map<std::string, std::map<Lease::Type, AllocatorPtr> >
+    subnet_allocators_;
+
     /// @brief number of attempts before we give up lease allocation (0=unlimited)
     unsigned int attempts_;
 
@@ -0,0 +1,174 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <log/logger_support.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/pool.h>
+#include <dhcpsrv/subnet.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::bench;
+using namespace bundy::asiolink;
+using namespace bundy::dhcp;
+using bundy::hooks::CalloutHandlePtr;
+
+namespace {
+// Picks addresses for new clients from an almost full pool, as for DHCPDISCOVER
+// (so the pool utilization doesn't change).  Without the free address index,
+// the index is cleared before each allocation, so the allocation engine tries
+// one address after another until it finds a free one, as it did before the
+// index was introduced.
+class AllocBenchMark {
+public:
+    AllocBenchMark(AllocEngine& engine, const Subnet4Ptr& subnet,
+                   const Pool4Ptr& pool, size_t count, bool use_index) :
+        engine_(engine), subnet_(subnet), pool_(pool), count_(count),
+        use_index_(use_index)
+    {}
+    unsigned int run() {
+        static const uint8_t mac[] = { 0, 1, 2, 3, 4, 5 };
+        const HWAddrPtr hwaddr(new HWAddr(mac, sizeof(mac), HTYPE_ETHER));
+        Lease4Ptr old_lease;
+        for (size_t i = 0; i < count_; ++i) {
+            if (!use_index_) {
+                pool_->getFreeIndex()->clear();
+            }
+            const Lease4Ptr lease =
+                engine_.allocateLease4(subnet_, ClientIdPtr(), hwaddr,
+                                       IOAddress("0.0.0.0"), false, false,
+                                       "", true, CalloutHandlePtr(),
+                                       old_lease);
+            assert(lease);
+        }
+        return (count_);
+    }
+private:
+    AllocEngine& engine_;
+    const Subnet4Ptr subnet_;
+    const Pool4Ptr pool_;
+    const size_t count_;
+    const bool use_index_;
+};
+
+// Leases the given percentage of the addresses in the pool, picked at random.
+size_t
+fillPool(const Subnet4Ptr& subnet, const Pool4Ptr& pool,
+         unsigned int utilization)
+{
+    const uint32_t first = static_cast<uint32_t>(pool->getFirstAddress());
+    const uint32_t last = static_cast<uint32_t>(pool->getLastAddress());
+    const time_t now = time(NULL);
+    size_t leased = 0;
+    srandom(1);
+    for (uint32_t addr = first; addr <= last; ++addr) {
+        if (random() % 100 >= utilization) {
+            continue;
+        }
+        const uint8_t hwaddr[] = { 0, 0xfe,
+                                   static_cast<uint8_t>(addr >> 24),
+                                   static_cast<uint8_t>(addr >> 16),
+                                   static_cast<uint8_t>(addr >> 8),
+                                   static_cast<uint8_t>(addr) };
+        const Lease4Ptr lease(new Lease4(IOAddress(addr), hwaddr,
+                                         sizeof(hwaddr), NULL, 0, 3600, 1800,
+                                         2700, now, subnet->getID()));
+        LeaseMgrFactory::instance().addLease(lease);
+        ++leased;
+    }
+    return (leased);
+}
+
+void
+usage() {
+    cerr << "Usage: alloc_engine_bench [-n iterations] [-a allocations] "
+        "[-u utilization]" << endl;
+    cerr << "  utilization is the percentage of the pool leased (1-99)"
+         << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 10;
+    size_t allocations = 1000;
+    unsigned int utilization = 95;
+    while ((ch = getopt(argc, argv, "n:a:u:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 'a':
+            allocations = atoi(optarg);
+            break;
+        case 'u':
+            utilization = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    if (utilization < 1 || utilization > 99) {
+        usage();
+    }
+
+    bundy::log::initLogger("alloc-engine-bench", bundy::log::NONE);
+
+    LeaseMgrFactory::create("type=memfile universe=4 persist=false");
+
+    const Subnet4Ptr subnet(new Subnet4(IOAddress("10.0.0.0"), 16, 1000,
+                                        2000, 3000));
+    const Pool4Ptr pool(new Pool4(IOAddress("10.0.0.0"), 16));
+    subnet->addPool(pool);
+    const size_t leased = fillPool(subnet, pool, utilization);
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Allocations per iteration: " << allocations << endl;
+    cout << "  Pool: " << pool->toText() << endl;
+    cout << "  Leased addresses: " << leased << " (" << utilization << "%)"
+         << endl;
+
+    // Unlimited attempts; there's always a free address.
+    AllocEngine engine(AllocEngine::ALLOC_ITERATIVE, 0, false);
+
+    cout << "Benchmark for allocation without free address index" << endl;
+    BenchMark<AllocBenchMark>(iteration,
+                              AllocBenchMark(engine, subnet, pool,
+                                             allocations, false));
+
+    cout << "Benchmark for allocation with free address index" << endl;
+    BenchMark<AllocBenchMark>(iteration,
+                              AllocBenchMark(engine, subnet, pool,
+                                             allocations, true));
+
+    LeaseMgrFactory::destroy();
+
+    return (0);
+}
@@ -14,6 +14,7 @@
 
 #include <dhcp/iface_mgr.h>
 #include <dhcp/libdhcp++.h>
+#include <dhcpsrv/alloc_engine.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcp_parsers.h>
 #include <hooks/hooks_manager.h>
@@ -1109,6 +1110,24 @@ SubnetConfigParser::createSubnet() {
         subnet_->setIface(iface);
     }
 
+    // Get the allocation algorithm selected for the subnet, if any.
+    std::string allocator;
+    try {
+        allocator = string_values_->getParam("allocator");
+    } catch (const DhcpConfigError &) {
+        // allocator is not mandatory so swallow the exception
+    }
+
+    if (!allocator.empty()) {
+        try {
+            AllocEngine::allocTypeFromText(allocator);
+        } catch (const BadValue&) {
+            bundy_throw(DhcpConfigError, "Unknown allocator " << allocator
+                        << " specified for subnet " << subnet_->toText());
+        }
+        subnet_->setAllocatorType(allocator);
+    }
+
     // We are going to move configured options to the Subnet object.
     // Configured options reside in the container where options
     // are grouped by space names. Thus we need to get all space names
@@ -0,0 +1,301 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/free_address_index.h>
+#include <exceptions/exceptions.h>
+
+using namespace bundy::asiolink;
+
+namespace {
+
+/// @brief An IPv4 or IPv6 address as a 128-bit unsigned integer.
+struct Value128 {
+    uint64_t hi_;
+    uint64_t lo_;
+};
+
+Value128
+toValue(const IOAddress& addr) {
+    const std::vector<uint8_t>& bytes = addr.toBytes();
+    Value128 value = { 0, 0 };
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        value.hi_ = (value.hi_ << 8) | (value.lo_ >> 56);
+        value.lo_ = (value.lo_ << 8) | bytes[i];
+    }
+    return (value);
+}
+
+IOAddress
+toIOAddress(short family, Value128 value) {
+    uint8_t packed[V6ADDRESS_LEN];
+    const size_t len = (family == AF_INET ? V4ADDRESS_LEN : V6ADDRESS_LEN);
+    for (size_t i = len; i > 0; --i) {
+        packed[i - 1] = value.lo_ & 0xff;
+        value.lo_ = (value.lo_ >> 8) | (value.hi_ << 56);
+        value.hi_ >>= 8;
+    }
+    return (IOAddress::fromBytes(family, packed));
+}
+
+bool
+lessThan(const Value128& a, const Value128& b) {
+    return (a.hi_ < b.hi_ || (a.hi_ == b.hi_ && a.lo_ < b.lo_));
+}
+
+Value128
+subtract(const Value128& a, const Value128& b) {
+    const Value128 result = { a.hi_ - b.hi_ - (a.lo_ < b.lo_ ? 1 : 0),
+                              a.lo_ - b.lo_ };
+    return (result);
+}
+
+Value128
+add(const Value128& a, const Value128& b) {
+    Value128 result = { a.hi_ + b.hi_, a.lo_ + b.lo_ };
+    if (result.lo_ < a.lo_) {
+        ++result.hi_;
+    }
+    return (result);
+}
+
+Value128
+shiftRight(const Value128& value, unsigned int bits) {
+    Value128 result = value;
+    if (bits >= 64) {
+        result.lo_ = (bits >= 128 ? 0 : value.hi_ >> (bits - 64));
+        result.hi_ = 0;
+    } else if (bits > 0) {
+        result.lo_ = (value.lo_ >> bits) | (value.hi_ << (64 - bits));
+        result.hi_ = value.hi_ >> bits;
+    }
+    return (result);
+}
+
+Value128
+shiftLeft(const Value128& value, unsigned int bits) {
+    Value128 result = value;
+    if (bits >= 64) {
+        result.hi_ = (bits >= 128 ? 0 : value.lo_ << (bits - 64));
+        result.lo_ = 0;
+    } else if (bits > 0) {
+        result.hi_ = (value.hi_ << bits) | (value.lo_ >> (64 - bits));
+        result.lo_ = value.lo_ << bits;
+    }
+    return (result);
+}
+
+/// @brief Returns the number of bits in an address of the family.
+unsigned int
+getAddressBits(const IOAddress& addr) {
+    return (addr.isV4() ? 32 : 128);
+}
+
+/// @brief Calculates the capacity of the index for the pool.
+///
+/// @return The capacity, or 0 if the pool can't be indexed.
+uint64_t
+getPoolCapacity(const IOAddress& first, const IOAddress& last,
+                uint8_t prefix_len)
+{
+    if (first.getFamily() != last.getFamily() || prefix_len == 0 ||
+        prefix_len > getAddressBits(first)) {
+        return (0);
+    }
+    const Value128 first_value = toValue(first);
+    const Value128 last_value = toValue(last);
+    if (lessThan(last_value, first_value)) {
+        return (0);
+    }
+    const Value128 diff = shiftRight(subtract(last_value, first_value),
+                                     getAddressBits(first) - prefix_len);
+    if (diff.hi_ != 0 ||
+        diff.lo_ >= bundy::dhcp::FreeAddressIndex::MAX_CAPACITY) {
+        return (0);
+    }
+    return (diff.lo_ + 1);
+}
+
+/// @brief Returns the position of the least significant bit set.
+unsigned int
+findFirstSet(uint64_t word) {
+    return (__builtin_ctzll(word));
+}
+
+}
+
+namespace bundy {
+namespace dhcp {
+
+const uint64_t FreeAddressIndex::MAX_CAPACITY;
+const uint64_t FreeAddressIndex::NOT_FOUND;
+
+FreeAddressIndex::FreeAddressIndex(const IOAddress& first,
+                                   const IOAddress& last,
+                                   uint8_t prefix_len)
+    : first_(first), shift_(getAddressBits(first) - prefix_len),
+      capacity_(getPoolCapacity(first, last, prefix_len)), used_count_(0)
+{
+    if (capacity_ == 0) {
+        bundy_throw(BadValue, "unable to create the free address index for "
+                    "the pool " << first << "-" << last << " with prefix "
+                    "length " << static_cast<int>(prefix_len));
+    }
+    initLevels();
+}
+
+bool
+FreeAddressIndex::canIndex(const IOAddress& first, const IOAddress& last,
+                           uint8_t prefix_len)
+{
+    return (getPoolCapacity(first, last, prefix_len) > 0);
+}
+
+void
+FreeAddressIndex::initLevels() {
+    levels_.clear();
+    uint64_t bits = capacity_;
+    do {
+        const uint64_t words = (bits + 63) / 64;
+        levels_.push_back(std::vector<uint64_t>(words, 0));
+        // The bits beyond the end are set, so they are never found.
+        if (bits % 64 != 0) {
+            levels_.back().back() = ~0ULL << (bits % 64);
+        }
+        bits = words;
+    } while (bits > 1);
+}
+
+bool
+FreeAddressIndex::toPosition(const IOAddress& addr, uint64_t& pos) const {
+    if (addr.getFamily() != first_.getFamily()) {
+        return (false);
+    }
+    const Value128 value = toValue(addr);
+    const Value128 first_value = toValue(first_);
+    if (lessThan(value, first_value)) {
+        return (false);
+    }
+    const Value128 diff = shiftRight(subtract(value, first_value), shift_);
+    if (diff.hi_ != 0 || diff.lo_ >= capacity_) {
+        return (false);
+    }
+    pos = diff.lo_;
+    return (true);
+}
+
+IOAddress
+FreeAddressIndex::toAddress(uint64_t pos) const {
+    const Value128 offset = { 0, pos };
+    return (toIOAddress(first_.getFamily(),
+                        add(toValue(first_), shiftLeft(offset, shift_))));
+}
+
+bool
+FreeAddressIndex::isUsed(const IOAddress& addr) const {
+    uint64_t pos;
+    if (!toPosition(addr, pos)) {
+        return (false);
+    }
+    return ((levels_[0][pos / 64] & (1ULL << (pos % 64))) != 0);
+}
+
+void
+FreeAddressIndex::markUsed(const IOAddress& addr) {
+    uint64_t pos;
+    if (toPosition(addr, pos) &&
+        (levels_[0][pos / 64] & (1ULL << (pos % 64))) == 0) {
+        setBit(0, pos);
+        ++used_count_;
+    }
+}
+
+void
+FreeAddressIndex::markFree(const IOAddress& addr) {
+    uint64_t pos;
+    if (toPosition(addr, pos) &&
+        (levels_[0][pos / 64] & (1ULL << (pos % 64))) != 0) {
+        clearBit(0, pos);
+        --used_count_;
+    }
+}
+
+void
+FreeAddressIndex::clear() {
+    initLevels();
+    used_count_ = 0;
+}
+
+bool
+FreeAddressIndex::findFree(const IOAddress& start, IOAddress& addr) const {
+    if (start.getFamily() != first_.getFamily()) {
+        return (false);
+    }
+    uint64_t pos = 0;
+    if (!lessThan(toValue(start), toValue(first_)) &&
+        !toPosition(start, pos)) {
+        // The start is beyond the end of the pool.
+        return (false);
+    }
+    pos = findClear(0, pos);
+    if (pos == NOT_FOUND) {
+        return (false);
+    }
+    addr = toAddress(pos);
+    return (true);
+}
+
+uint64_t
+FreeAddressIndex::findClear(size_t level, uint64_t pos) const {
+    const std::vector<uint64_t>& words = levels_[level];
+    const uint64_t word = pos / 64;
+    if (word >= words.size()) {
+        return (NOT_FOUND);
+    }
+    const uint64_t bits = ~words[word] & (~0ULL << (pos % 64));
+    if (bits != 0) {
+        return (word * 64 + findFirstSet(bits));
+    }
+    // The rest of this word is used. Find the next word which is not full
+    // in the level above (the top level has only one word).
+    if (level + 1 == levels_.size()) {
+        return (NOT_FOUND);
+    }
+    const uint64_t next = findClear(level + 1, word + 1);
+    if (next == NOT_FOUND) {
+        return (NOT_FOUND);
+    }
+    return (next * 64 + findFirstSet(~words[next]));
+}
+
+void
+FreeAddressIndex::setBit(size_t level, uint64_t pos) {
+    uint64_t& word = levels_[level][pos / 64];
+    word |= (1ULL << (pos % 64));
+    if (word == ~0ULL && level + 1 < levels_.size()) {
+        setBit(level + 1, pos / 64);
+    }
+}
+
+void
+FreeAddressIndex::clearBit(size_t level, uint64_t pos) {
+    uint64_t& word = levels_[level][pos / 64];
+    const bool full = (word == ~0ULL);
+    word &= ~(1ULL << (pos % 64));
+    if (full && level + 1 < levels_.size()) {
+        clearBit(level + 1, pos / 64);
+    }
+}
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
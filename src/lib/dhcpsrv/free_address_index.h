@@ -0,0 +1,180 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef FREE_ADDRESS_INDEX_H
+#define FREE_ADDRESS_INDEX_H
+
+#include <asiolink/io_address.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Index of the addresses (or prefixes) of a pool known to be in use.
+///
+/// The allocation engine picks candidate addresses from a pool and checks
+/// each of them in the lease database until it finds a free one. When most
+/// of the pool is in use, this takes many attempts, each of them a lease
+/// database query. This index remembers the addresses which have been found
+/// to be in use, so that the next candidate which is not known to be in use
+/// can be found without querying the lease database.
+///
+/// The index is a hierarchical bitmap: a bit in the lowest level is set
+/// when the corresponding address is in use, and a bit in each of the upper
+/// levels is set when the corresponding 64-bit word of the level below has
+/// all bits set. Marking an address and finding the next address not in use
+/// take O(log64(n)) time, where n is the number of addresses in the pool,
+/// i.e. at most 4 steps for the largest supported pool.
+///
+/// The addresses are marked as free again when their leases are reclaimed,
+/// released or declined.  Still, the index only holds hints: the leases may
+/// be changed without the knowledge of the allocation engine (e.g. by
+/// another server sharing the database), so the lease database remains the
+/// authoritative source and each candidate must still be checked there.
+///
+/// For IPv6 prefix delegation pools, each bit represents a delegated prefix
+/// rather than an address.
+class FreeAddressIndex : public boost::noncopyable {
+public:
+    /// @brief The maximum number of addresses (or prefixes) in an index.
+    ///
+    /// With this limit the index takes at most 2MB of memory. Larger pools
+    /// (typically IPv6 pools) are rarely highly utilized, so they are not
+    /// indexed.
+    static const uint64_t MAX_CAPACITY = 1ULL << 24;
+
+    /// @brief Constructor.
+    ///
+    /// @param first The first address (or prefix) in the pool.
+    /// @param last The last address in the pool.
+    /// @param prefix_len The length of the prefixes allocated from the pool
+    /// (32 for IPv4 addresses, 128 for IPv6 addresses).
+    ///
+    /// @throw bundy::BadValue if the addresses are of different families,
+    /// last is smaller than first, the prefix length is invalid or the pool
+    /// is larger than @c MAX_CAPACITY.
+    FreeAddressIndex(const bundy::asiolink::IOAddress& first,
+                     const bundy::asiolink::IOAddress& last,
+                     uint8_t prefix_len);
+
+    /// @brief Checks whether a pool can be indexed.
+    ///
+    /// @param first The first address in the pool.
+    /// @param last The last address in the pool.
+    /// @param prefix_len The length of the prefixes allocated from the pool.
+    ///
+    /// @return true if the constructor would succeed with these parameters.
+    static bool canIndex(const bundy::asiolink::IOAddress& first,
+                         const bundy::asiolink::IOAddress& last,
+                         uint8_t prefix_len);
+
+    /// @brief Returns the number of addresses (or prefixes) in the index.
+    uint64_t getCapacity() const {
+        return (capacity_);
+    }
+
+    /// @brief Returns the number of addresses marked as used.
+    uint64_t getUsedCount() const {
+        return (used_count_);
+    }
+
+    /// @brief Checks if the address is marked as used.
+    ///
+    /// @return true if the address is marked as used; false if it isn't, or
+    /// it doesn't belong to the pool.
+    bool isUsed(const bundy::asiolink::IOAddress& addr) const;
+
+    /// @brief Marks the address as used.
+    ///
+    /// It does nothing if the address doesn't belong to the pool.
+    void markUsed(const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Marks the address as not used.
+    ///
+    /// It does nothing if the address doesn't belong to the pool.
+    void markFree(const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Marks all addresses as not used.
+    void clear();
+
+    /// @brief Finds the first address not marked as used.
+    ///
+    /// The search starts at the specified address and continues up to the
+    /// last address of the pool (it doesn't wrap around).
+    ///
+    /// @param start The address the search starts at. If it is smaller than
+    /// the first address of the pool, the search starts at the beginning
+    /// of the pool.
+    /// @param [out] addr The address found.
+    ///
+    /// @return true if an address was found; false otherwise.
+    bool findFree(const bundy::asiolink::IOAddress& start,
+                  bundy::asiolink::IOAddress& addr) const;
+
+private:
+    /// @brief Converts an address to the position in the index.
+    ///
+    /// @return false if the address doesn't belong to the pool.
+    bool toPosition(const bundy::asiolink::IOAddress& addr,
+                    uint64_t& pos) const;
+
+    /// @brief Converts a position in the index to the address.
+    bundy::asiolink::IOAddress toAddress(uint64_t pos) const;
+
+    /// @brief Finds the first cleared bit at or after pos in the level.
+    ///
+    /// @return The position of the bit, or @c NOT_FOUND if there's none.
+    uint64_t findClear(size_t level, uint64_t pos) const;
+
+    /// @brief Returned by @c findClear() if there's no cleared bit.
+    static const uint64_t NOT_FOUND = ~0ULL;
+
+    /// @brief Sets all bits to 0, except for the bits beyond the capacity.
+    void initLevels();
+
+    /// @brief Sets the bit and updates the upper levels.
+    void setBit(size_t level, uint64_t pos);
+
+    /// @brief Clears the bit and updates the upper levels.
+    void clearBit(size_t level, uint64_t pos);
+
+    /// @brief The first address of the pool.
+    const bundy::asiolink::IOAddress first_;
+
+    /// @brief The number of low-order bits not in the allocated prefixes.
+    const uint8_t shift_;
+
+    /// @brief The number of addresses (or prefixes) in the index.
+    uint64_t capacity_;
+
+    /// @brief The number of addresses marked as used.
+    uint64_t used_count_;
+
+    /// @brief The levels of the bitmap, the lowest level first.
+    std::vector<std::vector<uint64_t> > levels_;
+};
+
+/// @brief A pointer to the @c FreeAddressIndex object.
+typedef boost::shared_ptr<FreeAddressIndex> FreeAddressIndexPtr;
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
+
+#endif // FREE_ADDRESS_INDEX_H
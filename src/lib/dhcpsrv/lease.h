@@ -141,6 +141,10 @@ struct Lease {
     /// @return true if the lease is expired
     bool expired() const;
 
+    /// @brief returns the time when the lease expires
+    /// @return cltt plus the valid lifetime, in seconds since the epoch
+    int64_t getExpirationTime() const;
+
     /// @brief Returns true if the other lease has equal FQDN data.
     ///
     /// @param other Lease which FQDN data is to be compared with our lease.
@@ -298,6 +298,28 @@ public:
     Lease6Ptr getLease6(Lease::Type type, const DUID& duid,
                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns IPv4 leases which have expired.
+    ///
+    /// The leases are returned in the order of their expiration time,
+    /// starting with the lease which expired first.
+    ///
+    /// @param max_leases maximum number of leases to be returned (0 means
+    ///        no limit)
+    ///
+    /// @return Lease collection (may be empty if no lease has expired)
+    virtual Lease4Collection getExpiredLeases4(size_t max_leases) const = 0;
+
+    /// @brief Returns IPv6 leases which have expired.
+    ///
+    /// The leases are returned in the order of their expiration time,
+    /// starting with the lease which expired first.
+    ///
+    /// @param max_leases maximum number of leases to be returned (0 means
+    ///        no limit)
+    ///
+    /// @return Lease collection (may be empty if no lease has expired)
+    virtual Lease6Collection getExpiredLeases6(size_t max_leases) const = 0;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
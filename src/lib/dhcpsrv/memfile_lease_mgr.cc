@@ -17,12 +17,181 @@
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
 
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+
 #include <iostream>
+#include <vector>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace bundy::dhcp;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
+
+namespace {
+
+/// @brief Suffix of the lease file in use before the cleanup started.
+const char* const LFC_PREVIOUS_SUFFIX = ".2";
+
+/// @brief Suffix of the snapshot made by the last cleanup.
+const char* const LFC_SNAPSHOT_SUFFIX = ".1";
+
+/// @brief Suffix of the snapshot being written.
+const char* const LFC_OUTPUT_SUFFIX = ".output";
+
+/// @brief Checks if the file exists.
+bool
+fileExists(const std::string& path) {
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0);
+}
+
+/// @brief Returns the size of the file, or 0 if it doesn't exist.
+uint64_t
+getFileSize(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return (0);
+    }
+    return (st.st_size);
+}
+
+/// @brief Returns the number of milliseconds elapsed since start.
+int64_t
+getElapsedMs(const boost::posix_time::ptime& start) {
+    return ((boost::posix_time::microsec_clock::universal_time() - start).
+            total_milliseconds());
+}
+
+/// @brief Copies the leases held in the storage.
+///
+/// The leases are copied by value, so the copy isn't affected by the
+/// subsequent updates of the storage.
+template<typename LeaseType, typename StorageType>
+boost::shared_ptr<std::vector<LeaseType> >
+copyLeases(const StorageType& storage) {
+    boost::shared_ptr<std::vector<LeaseType> >
+        leases(new std::vector<LeaseType>());
+    leases->reserve(storage.size());
+    for (typename StorageType::const_iterator lease = storage.begin();
+         lease != storage.end(); ++lease) {
+        leases->push_back(**lease);
+    }
+    return (leases);
+}
+
+/// @brief Writes the snapshot of the leases for the lease file.
+///
+/// The leases are written to the [path].output file, which is then renamed
+/// to [path].1, replacing the previous snapshot.  Finally, [path].2 is
+/// removed.
+///
+/// @param path Path to the lease file.
+/// @param leases Leases to be written.
+///
+/// @throw bundy::dhcp::DbOperationError or bundy::util::CSVFileError If any
+/// of the file operations fails.
+template<typename LeaseFileType, typename LeaseType>
+void
+writeSnapshot(const std::string& path,
+              const boost::shared_ptr<std::vector<LeaseType> >& leases)
+{
+    const boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    const std::string output = path + LFC_OUTPUT_SUFFIX;
+    const std::string snapshot = path + LFC_SNAPSHOT_SUFFIX;
+    const std::string previous = path + LFC_PREVIOUS_SUFFIX;
+    const uint64_t old_size = getFileSize(snapshot) + getFileSize(previous);
+
+    LeaseFileType output_file(output);
+    output_file.recreate();
+    for (typename std::vector<LeaseType>::const_iterator lease =
+             leases->begin(); lease != leases->end(); ++lease) {
+        output_file.append(*lease);
+    }
+    output_file.close();
+
+    // Make sure the snapshot is on disk before it replaces the previous
+    // one and the lease file it has been made from is removed.
+    const int fd = open(output.c_str(), O_RDONLY);
+    if (fd < 0 || fsync(fd) != 0) {
+        const int error = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        bundy_throw(DbOperationError, "failed to sync '" << output << "': "
+                    << std::strerror(error));
+    }
+    close(fd);
+
+    if (std::rename(output.c_str(), snapshot.c_str()) != 0) {
+        bundy_throw(DbOperationError, "failed to rename '" << output
+                    << "' to '" << snapshot << "': " << std::strerror(errno));
+    }
+    if (unlink(previous.c_str()) != 0 && errno != ENOENT) {
+        bundy_throw(DbOperationError, "failed to remove '" << previous
+                    << "': " << std::strerror(errno));
+    }
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_COMPLETE).arg(path)
+        .arg(leases->size()).arg(old_size).arg(getFileSize(snapshot))
+        .arg(getElapsedMs(start));
+}
+
+/// @brief Renames the lease file to [path].2 and creates a new one.
+///
+/// @throw bundy::dhcp::DbOperationError If failed to rename the file.
+template<typename LeaseFileType>
+void
+rotateLeaseFile(LeaseFileType& lease_file) {
+    const std::string path = lease_file.getFilename();
+    const std::string previous = path + LFC_PREVIOUS_SUFFIX;
+    lease_file.close();
+    if (std::rename(path.c_str(), previous.c_str()) != 0) {
+        const int error = errno;
+        // Continue appending to the original file.
+        lease_file.open();
+        bundy_throw(DbOperationError, "failed to rename '" << path
+                    << "' to '" << previous << "': " << std::strerror(error));
+    }
+    // The file doesn't exist now, so it's created.
+    lease_file.open();
+}
+
+/// @brief Cleans up the lease file synchronously.
+///
+/// This is used when a previous cleanup didn't complete.  It writes the
+/// snapshot of the leases held in the storage, which replaces all the
+/// existing files, and then truncates the lease file.
+template<typename LeaseType, typename LeaseFileType, typename StorageType>
+void
+cleanupLeaseFile(LeaseFileType& lease_file, const StorageType& storage) {
+    const std::string path = lease_file.getFilename();
+    LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_RECOVER).arg(path);
+    writeSnapshot<LeaseFileType, LeaseType>(path,
+                                            copyLeases<LeaseType>(storage));
+    lease_file.recreate();
+}
+
+/// @brief Checks if there are files left by an incomplete cleanup.
+bool
+lfcIncomplete(const std::string& path) {
+    return (fileExists(path + LFC_PREVIOUS_SUFFIX) ||
+            fileExists(path + LFC_OUTPUT_SUFFIX));
+}
+
+}
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+    : LeaseMgr(parameters), lfc_interval_(0), lfc_last_(time(NULL)),
+      lfc_running_(false) {
     // Check the universe and use v4 file or v6 file.
     std::string universe = getParameter("universe");
     if (universe == "4") {
@@ -41,6 +210,8 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
         }
     }
 
+    lfcInit();
+
     // If lease persistence have been disabled for both v4 and v6,
     // issue a warning. It is ok not to write leases to disk when
     // doing testing, but it should not be done in normal server
@@ -51,6 +222,7 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    lfcWait();
     if (lease_file4_) {
         lease_file4_->close();
         lease_file4_.reset();
@@ -79,6 +251,7 @@ Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
     }
 
     storage4_.insert(lease);
+    lfcCheck();
     return (true);
 }
 
@@ -100,6 +273,7 @@ Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
     }
 
     storage6_.insert(lease);
+    lfcCheck();
     return (true);
 }
 
@@ -130,7 +304,7 @@ Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
         // Every Lease4 has a hardware address, so we can compare it
         if ((*lease)->hwaddr_ == hwaddr.hwaddr_) {
-            collection.push_back((*lease));
+            collection.push_back(Lease4Ptr(new Lease4(**lease)));
         }
     }
 
@@ -174,7 +348,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id) const {
         // client-id is not mandatory in DHCPv4. There can be a lease that does
         // not have a client-id. Dereferencing null pointer would be a bad thing
         if((*lease)->client_id_ && *(*lease)->client_id_ == client_id) {
-            collection.push_back((*lease));
+            collection.push_back(Lease4Ptr(new Lease4(**lease)));
         }
     }
 
@@ -207,7 +381,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     }
 
     // Lease was found. Return it to the caller.
-    return (*lease);
+    return (Lease4Ptr(new Lease4(**lease)));
 }
 
 Lease4Ptr
@@ -288,6 +462,46 @@ Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
     return (collection);
 }
 
+Lease4Collection
+Memfile_LeaseMgr::getExpiredLeases4(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED4).arg(max_leases);
+
+    // We are going to use index #4 of the multi index container, which
+    // sorts the leases by the expiration time.
+    typedef Lease4Storage::nth_index<4>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<4>();
+    // The leases which expired before now.
+    SearchIndex::const_iterator end = idx.lower_bound(time(NULL));
+    Lease4Collection collection;
+    for (SearchIndex::const_iterator lease = idx.begin();
+         lease != end && (max_leases == 0 || collection.size() < max_leases);
+         ++lease) {
+        collection.push_back(Lease4Ptr(new Lease4(**lease)));
+    }
+    return (collection);
+}
+
+Lease6Collection
+Memfile_LeaseMgr::getExpiredLeases6(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED6).arg(max_leases);
+
+    // We are going to use index #2 of the multi index container, which
+    // sorts the leases by the expiration time.
+    typedef Lease6Storage::nth_index<2>::type SearchIndex;
+    const SearchIndex& idx = storage6_.get<2>();
+    // The leases which expired before now.
+    SearchIndex::const_iterator end = idx.lower_bound(time(NULL));
+    Lease6Collection collection;
+    for (SearchIndex::const_iterator lease = idx.begin();
+         lease != end && (max_leases == 0 || collection.size() < max_leases);
+         ++lease) {
+        collection.push_back(Lease6Ptr(new Lease6(**lease)));
+    }
+    return (collection);
+}
+
 void
 Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -306,7 +520,10 @@ Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
         lease_file4_->append(*lease);
     }
 
-    **lease_it = *lease;
+    // The lease is replaced rather than modified in place, so that the
+    // indexes (e.g. by the expiration time) are updated.
+    storage4_.replace(lease_it, Lease4Ptr(new Lease4(*lease)));
+    lfcCheck();
 }
 
 void
@@ -327,7 +544,10 @@ Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
         lease_file6_->append(*lease);
     }
 
-    **lease_it = *lease;
+    // The lease is replaced rather than modified in place, so that the
+    // indexes (e.g. by the expiration time) are updated.
+    storage6_.replace(lease_it, Lease6Ptr(new Lease6(*lease)));
+    lfcCheck();
 }
 
 bool
@@ -351,6 +571,7 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
                 lease_file4_->append(lease_copy);
             }
             storage4_.erase(l);
+            lfcCheck();
             return (true);
         }
 
@@ -372,6 +593,7 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
             }
 
             storage6_.erase(l);
+            lfcCheck();
             return (true);
         }
     }
@@ -469,15 +691,46 @@ Memfile_LeaseMgr::load4() {
     // data on disk.
     storage4_.clear();
 
+    const boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    const std::string path = lease_file4_->getFilename();
+    size_t records = 0;
+    uint64_t size = 0;
+
+    // Read the files of the Lease File Cleanup first: the snapshot and
+    // the lease file in use before the cleanup started.
+    const char* const suffixes[] = { LFC_SNAPSHOT_SUFFIX, LFC_PREVIOUS_SUFFIX };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+        const std::string filename = path + suffixes[i];
+        if (fileExists(filename)) {
+            CSVLeaseFile4 lease_file(filename);
+            lease_file.open();
+            records += loadFile4(lease_file);
+            lease_file.close();
+            size += getFileSize(filename);
+        }
+    }
+    records += loadFile4(*lease_file4_);
+    size += getFileSize(path);
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_LOADED)
+        .arg(storage4_.size()).arg(records).arg(size)
+        .arg(getElapsedMs(start));
+}
+
+size_t
+Memfile_LeaseMgr::loadFile4(CSVLeaseFile4& lease_file) {
+    size_t records = 0;
     Lease4Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file4_->next(lease)) {
-            bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file4_->getReadMsg());
+        if (!lease_file.next(lease)) {
+            bundy_throw(DbOperationError, "Failed to parse the DHCPv4 lease in"
+                      " the lease file " << lease_file.getFilename() << ": "
+                      << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -486,8 +739,10 @@ Memfile_LeaseMgr::load4() {
                       DHCPSRV_MEMFILE_LEASE_LOAD4)
                 .arg(lease->toText());
             loadLease4(lease);
+            ++records;
         }
     } while (lease);
+    return (records);
 }
 
 void
@@ -510,7 +765,7 @@ Memfile_LeaseMgr::loadLease4(Lease4Ptr& lease) {
 
         } else {
             // Update existing lease.
-            **lease_it = *lease;
+            storage4_.replace(lease_it, lease);
         }
     }
 }
@@ -530,15 +785,46 @@ Memfile_LeaseMgr::load6() {
     // data on disk.
     storage6_.clear();
 
+    const boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    const std::string path = lease_file6_->getFilename();
+    size_t records = 0;
+    uint64_t size = 0;
+
+    // Read the files of the Lease File Cleanup first: the snapshot and
+    // the lease file in use before the cleanup started.
+    const char* const suffixes[] = { LFC_SNAPSHOT_SUFFIX, LFC_PREVIOUS_SUFFIX };
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+        const std::string filename = path + suffixes[i];
+        if (fileExists(filename)) {
+            CSVLeaseFile6 lease_file(filename);
+            lease_file.open();
+            records += loadFile6(lease_file);
+            lease_file.close();
+            size += getFileSize(filename);
+        }
+    }
+    records += loadFile6(*lease_file6_);
+    size += getFileSize(path);
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_LOADED)
+        .arg(storage6_.size()).arg(records).arg(size)
+        .arg(getElapsedMs(start));
+}
+
+size_t
+Memfile_LeaseMgr::loadFile6(CSVLeaseFile6& lease_file) {
+    size_t records = 0;
     Lease6Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file6_->next(lease)) {
+        if (!lease_file.next(lease)) {
             bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file6_->getReadMsg());
+                      " the lease file " << lease_file.getFilename() << ": "
+                      << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -546,10 +832,11 @@ Memfile_LeaseMgr::load6() {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
                       DHCPSRV_MEMFILE_LEASE_LOAD6)
                 .arg(lease->toText());
-
             loadLease6(lease);
+            ++records;
         }
     } while (lease);
+    return (records);
 }
 
 void
@@ -572,9 +859,136 @@ Memfile_LeaseMgr::loadLease6(Lease6Ptr& lease) {
 
         } else {
             // Update existing lease.
-            **lease_it = *lease;
+            storage6_.replace(lease_it, lease);
+        }
+    }
+
+}
+
+void
+Memfile_LeaseMgr::lfcInit() {
+    std::string lfc_interval;
+    try {
+        lfc_interval = getParameter("lfc-interval");
+    } catch (const Exception& ex) {
+        // The cleanup is disabled by default.
+        lfc_interval = "0";
+    }
+    try {
+        lfc_interval_ = boost::lexical_cast<uint32_t>(lfc_interval);
+    } catch (const boost::bad_lexical_cast&) {
+        bundy_throw(bundy::BadValue, "invalid value 'lfc-interval="
+                  << lfc_interval << "'");
+    }
+
+    // Complete the cleanup interrupted by the shutdown of the server
+    // (or a crash). The leases have been read from all the files, so
+    // this can be done at any stage of the cleanup.
+    if (persistLeases(V4) && lfcIncomplete(lease_file4_->getFilename())) {
+        cleanupLeaseFile<Lease4>(*lease_file4_, storage4_);
+    }
+    if (persistLeases(V6) && lfcIncomplete(lease_file6_->getFilename())) {
+        cleanupLeaseFile<Lease6>(*lease_file6_, storage6_);
+    }
+}
+
+void
+Memfile_LeaseMgr::lfcCheck() {
+    if (lfc_interval_ == 0 || time(NULL) - lfc_last_ < lfc_interval_) {
+        return;
+    }
+
+    // The lease has been already stored, so the failure to start the
+    // cleanup is not reported to the caller. It will be retried after
+    // the interval.
+    try {
+        lfcRun();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START_FAILED)
+            .arg(getLeaseFilePath(persistLeases(V4) ? V4 : V6))
+            .arg(ex.what());
+    }
+}
+
+void
+Memfile_LeaseMgr::lfcRun() {
+    if (!persistLeases(V4) && !persistLeases(V6)) {
+        return;
+    }
+
+    const std::string path = getLeaseFilePath(persistLeases(V4) ? V4 : V6);
+    {
+        Mutex::Locker locker(lfc_mutex_);
+        if (lfc_running_) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                      DHCPSRV_MEMFILE_LFC_IN_PROGRESS).arg(path);
+            return;
         }
     }
+    // Reap the thread of the previous cleanup.
+    lfcWait();
+    lfc_last_ = time(NULL);
+
+    // If the previous cleanup has failed, its files are still there.
+    // Rotating the lease file would overwrite them, so do the cleanup now.
+    if (lfcIncomplete(path)) {
+        if (persistLeases(V4)) {
+            cleanupLeaseFile<Lease4>(*lease_file4_, storage4_);
+        } else {
+            cleanupLeaseFile<Lease6>(*lease_file6_, storage6_);
+        }
+        return;
+    }
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START).arg(path);
 
+    // The leases are copied before the lease file is rotated, and both
+    // happen before any other update of the leases, so the snapshot
+    // reflects all records in the rotated file and none in the new one.
+    boost::function<void()> snapshot;
+    if (persistLeases(V4)) {
+        snapshot = boost::bind(&writeSnapshot<CSVLeaseFile4, Lease4>, path,
+                               copyLeases<Lease4>(storage4_));
+        rotateLeaseFile(*lease_file4_);
+    } else {
+        snapshot = boost::bind(&writeSnapshot<CSVLeaseFile6, Lease6>, path,
+                               copyLeases<Lease6>(storage6_));
+        rotateLeaseFile(*lease_file6_);
+    }
+
+    Mutex::Locker locker(lfc_mutex_);
+    lfc_running_ = true;
+    try {
+        lfc_thread_.reset(new Thread(boost::bind(&Memfile_LeaseMgr::lfcThread,
+                                                 this, snapshot)));
+    } catch (...) {
+        // The rotated file is left, so the next cleanup will be done
+        // synchronously.
+        lfc_running_ = false;
+        throw;
+    }
+}
+
+void
+Memfile_LeaseMgr::lfcWait() {
+    if (lfc_thread_) {
+        lfc_thread_->wait();
+        lfc_thread_.reset();
+    }
 }
 
+void
+Memfile_LeaseMgr::lfcThread(const boost::function<void()>& snapshot) {
+    try {
+        snapshot();
+    } catch (const std::exception& ex) {
+        // The files of the incomplete cleanup are left. The leases are
+        // read correctly from them and the next cleanup completes this one.
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAILED)
+            .arg(getLeaseFilePath(persistLeases(V4) ? V4 : V6))
+            .arg(ex.what());
+    }
+
+    Mutex::Locker locker(lfc_mutex_);
+    lfc_running_ = false;
+}
@@ -19,12 +19,21 @@
 #include <dhcpsrv/csv_lease_file4.h>
 #include <dhcpsrv/csv_lease_file6.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/indexed_by.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <ctime>
+#include <string>
 
 namespace bundy {
 namespace dhcp {
@@ -68,6 +77,29 @@ namespace dhcp {
 /// is not specified, the default location in the installation
 /// directory is used: var/bundy/kea-leases4.csv and
 /// var/bundy/kea-leases6.csv.
+///
+/// As every update of a lease appends a record, the lease file grows
+/// without bound and more and more records have to be replayed at startup.
+/// To avoid this, the backend performs the Lease File Cleanup (LFC): if the
+/// "lfc-interval=[seconds]" parameter is given and is not 0, the first
+/// write to the lease database after the interval has elapsed since the
+/// previous cleanup (or the startup) triggers a new one.  The cleanup
+/// works with the following files, where [path] is the lease file:
+/// - [path]: the file to which the leases are appended,
+/// - [path].2: the lease file in use before the cleanup started,
+/// - [path].1: the snapshot of the leases made by the last cleanup,
+/// - [path].output: the snapshot being written.
+///
+/// When the cleanup starts, the lease file is renamed to [path].2 and a new
+/// empty lease file is created, so the server continues to append to it.
+/// The leases held in memory at this point are copied and written to
+/// [path].output by a background thread, which then renames it to
+/// [path].1 and removes [path].2.  At startup, the leases are read from
+/// [path].1, [path].2 and [path] in this order (each if it exists).  This
+/// results in the correct set of leases whenever the server stopped during
+/// the cleanup.  If [path].2 or [path].output exists after the leases have
+/// been read, i.e. the last cleanup didn't complete, the cleanup is done
+/// immediately before the server continues.
 class Memfile_LeaseMgr : public LeaseMgr {
 public:
 
@@ -216,6 +248,28 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns IPv4 leases which have expired.
+    ///
+    /// This function returns copies of the leases, in the order of their
+    /// expiration time.
+    ///
+    /// @param max_leases maximum number of leases to be returned (0 means
+    ///        no limit)
+    ///
+    /// @return lease collection (may be empty if no lease has expired)
+    virtual Lease4Collection getExpiredLeases4(size_t max_leases) const;
+
+    /// @brief Returns IPv6 leases which have expired.
+    ///
+    /// This function returns copies of the leases, in the order of their
+    /// expiration time.
+    ///
+    /// @param max_leases maximum number of leases to be returned (0 means
+    ///        no limit)
+    ///
+    /// @return lease collection (may be empty if no lease has expired)
+    virtual Lease6Collection getExpiredLeases6(size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @warning This function does not validate the pointer to the lease.
@@ -315,6 +369,34 @@ public:
     /// server shut down.
     bool persistLeases(Universe u) const;
 
+    /// @brief Returns the interval of the Lease File Cleanup.
+    ///
+    /// @return Interval in seconds; 0 if the cleanup is disabled.
+    uint32_t getLFCInterval() const {
+        return (lfc_interval_);
+    }
+
+    /// @brief Starts the Lease File Cleanup.
+    ///
+    /// This method rotates the lease file and starts writing the snapshot
+    /// of the leases in the background (see the description of this class).
+    /// It is called automatically when the "lfc-interval" elapses, but it
+    /// can be also called explicitly, regardless of the interval.  If the
+    /// leases are not written to disk or the previous cleanup is still in
+    /// progress, this method does nothing.
+    ///
+    /// If the previous cleanup has failed, the files it left are cleaned up
+    /// synchronously instead, so the lease files are always consistent.
+    ///
+    /// @throw bundy::dhcp::DbOperationError If failed to rotate the lease
+    /// file.
+    void lfcRun();
+
+    /// @brief Waits for the Lease File Cleanup in progress to complete.
+    ///
+    /// If there's no cleanup in progress, it returns immediately.
+    void lfcWait();
+
 protected:
 
     /// @brief Load all DHCPv4 leases from the file.
@@ -380,6 +462,43 @@ protected:
     /// argument to this function.
     std::string initLeaseFilePath(Universe u);
 
+    /// @brief Reads leases from a single lease file into the storage.
+    ///
+    /// @param lease_file Opened lease file.
+    ///
+    /// @return Number of lease records read from the file.
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    size_t loadFile4(CSVLeaseFile4& lease_file);
+
+    /// @brief Reads leases from a single lease file into the storage.
+    ///
+    /// @param lease_file Opened lease file.
+    ///
+    /// @return Number of lease records read from the file.
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    size_t loadFile6(CSVLeaseFile6& lease_file);
+
+    /// @brief Initializes the Lease File Cleanup.
+    ///
+    /// This method reads the "lfc-interval" parameter.  It must be called
+    /// after the leases have been loaded: if the files of an incomplete
+    /// cleanup exist, they are cleaned up synchronously.
+    ///
+    /// @throw bundy::BadValue If the interval is not a valid number.
+    void lfcInit();
+
+    /// @brief Starts the Lease File Cleanup if the interval has elapsed.
+    ///
+    /// This method is called after each write to the lease file.
+    void lfcCheck();
+
+    /// @brief Body of the background thread of the Lease File Cleanup.
+    ///
+    /// @param snapshot A function writing the snapshot file.
+    void lfcThread(const boost::function<void()>& snapshot);
+
     // This is a multi-index container, which holds elements that can
     // be accessed using different search indexes.
     typedef boost::multi_index_container<
@@ -394,7 +513,10 @@ protected:
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            // The index is only used for exact matches, so it is hashed
+            // rather than ordered: a lookup takes constant time instead of
+            // a logarithmic number of DUID comparisons.
+            boost::multi_index::hashed_unique<
                 // This is a composite index that will be used to search for
                 // the lease using three attributes: DUID, IAID, Subnet Id.
                 boost::multi_index::composite_key<
@@ -408,6 +530,13 @@ protected:
                     boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the third index starts here.
+            // This index sorts leases by their expiration time.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
      > Lease6Storage; // Specify the type name of this container.
@@ -429,7 +558,11 @@ protected:
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            // This index and the next two are only used for exact matches,
+            // so they are hashed rather than ordered: a lookup takes constant
+            // time instead of a logarithmic number of comparisons of the
+            // hardware addresses and client identifiers.
+            boost::multi_index::hashed_unique<
                 // This is a composite index that combines two attributes of the
                 // Lease4 object: hardware address and subnet id.
                 boost::multi_index::composite_key<
@@ -447,7 +580,7 @@ protected:
             >,
 
             // Specification of the third index starts here.
-            boost::multi_index::ordered_non_unique<
+            boost::multi_index::hashed_non_unique<
                 // This is a composite index that uses two values to search for a
                 // lease: client id and subnet id.
                 boost::multi_index::composite_key<
@@ -462,7 +595,7 @@ protected:
             >,
 
             // Specification of the fourth index starts here.
-            boost::multi_index::ordered_non_unique<
+            boost::multi_index::hashed_non_unique<
                 // This is a composite index that uses two values to search for a
                 // lease: client id and subnet id.
                 boost::multi_index::composite_key<
@@ -478,6 +611,13 @@ protected:
                     // The subnet id is accessed through the subnet_id_ member.
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the fifth index starts here.
+            // This index sorts leases by their expiration time.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
     > Lease4Storage; // Specify the type name for this container.
@@ -494,6 +634,23 @@ protected:
     /// @brief Holds the pointer to the DHCPv6 lease file IO.
     boost::shared_ptr<CSVLeaseFile6> lease_file6_;
 
+    /// @brief Interval of the Lease File Cleanup in seconds (0: disabled).
+    uint32_t lfc_interval_;
+
+    /// @brief Time when the last Lease File Cleanup started.
+    time_t lfc_last_;
+
+    /// @brief The thread writing the snapshot of the leases (if any).
+    boost::scoped_ptr<bundy::util::thread::Thread> lfc_thread_;
+
+    /// @brief Indicates if @c lfc_thread_ hasn't completed yet.
+    ///
+    /// It's protected by @c lfc_mutex_.
+    bool lfc_running_;
+
+    /// @brief Protects @c lfc_running_.
+    bundy::util::thread::Mutex lfc_mutex_;
+
 };
 
 }; // end of bundy::dhcp namespace
@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <time.h>
@@ -145,6 +146,13 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE client_id = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE4_EXPIRE,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire LIMIT ?"},
     {MySqlLeaseMgr::GET_LEASE4_HWADDR,
                     "SELECT address, hwaddr, client_id, "
                         "valid_lifetime, expire, subnet_id, "
@@ -179,6 +187,14 @@ TaggedStatement tagged_statements[] = {
                             "FROM lease6 "
                             "WHERE duid = ? AND iaid = ? AND subnet_id = ? "
                             "AND lease_type = ?"},
+    {MySqlLeaseMgr::GET_LEASE6_EXPIRE,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire LIMIT ?"},
     {MySqlLeaseMgr::GET_VERSION,
                     "SELECT version, minor FROM schema_version"},
     {MySqlLeaseMgr::INSERT_LEASE4,
@@ -1787,6 +1803,68 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
     return (result);
 }
 
+Lease4Collection
+MySqlLeaseMgr::getExpiredLeases4(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED4).arg(max_leases);
+
+    // Set up the WHERE clause value
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+
+    // Leases which expired before now
+    MYSQL_TIME expire;
+    convertToDatabaseTime(time(NULL), 0, expire);
+    inbind[0].buffer_type = MYSQL_TYPE_TIMESTAMP;
+    inbind[0].buffer = reinterpret_cast<char*>(&expire);
+    inbind[0].buffer_length = sizeof(expire);
+
+    // LIMIT (there's no way to say "no limit" in a prepared statement,
+    // so the largest value is used)
+    uint64_t limit = (max_leases == 0 ?
+                      std::numeric_limits<uint64_t>::max() : max_leases);
+    inbind[1].buffer_type = MYSQL_TYPE_LONGLONG;
+    inbind[1].buffer = reinterpret_cast<char*>(&limit);
+    inbind[1].is_unsigned = MLM_TRUE;
+
+    // ... and get the data
+    Lease4Collection result;
+    getLeaseCollection(GET_LEASE4_EXPIRE, inbind, result);
+
+    return (result);
+}
+
+Lease6Collection
+MySqlLeaseMgr::getExpiredLeases6(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED6).arg(max_leases);
+
+    // Set up the WHERE clause value
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+
+    // Leases which expired before now
+    MYSQL_TIME expire;
+    convertToDatabaseTime(time(NULL), 0, expire);
+    inbind[0].buffer_type = MYSQL_TYPE_TIMESTAMP;
+    inbind[0].buffer = reinterpret_cast<char*>(&expire);
+    inbind[0].buffer_length = sizeof(expire);
+
+    // LIMIT (there's no way to say "no limit" in a prepared statement,
+    // so the largest value is used)
+    uint64_t limit = (max_leases == 0 ?
+                      std::numeric_limits<uint64_t>::max() : max_leases);
+    inbind[1].buffer_type = MYSQL_TYPE_LONGLONG;
+    inbind[1].buffer = reinterpret_cast<char*>(&limit);
+    inbind[1].is_unsigned = MLM_TRUE;
+
+    // ... and get the data
+    Lease6Collection result;
+    getLeaseCollection(GET_LEASE6_EXPIRE, inbind, result);
+
+    return (result);
+}
+
 // Update lease methods.  These comprise common code that handles the actual
 // update, and type-specific methods that set up the parameters for the prepared
 // statement depending on the type of lease.
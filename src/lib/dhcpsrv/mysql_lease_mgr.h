@@ -314,6 +314,38 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns IPv4 leases which have expired.
+    ///
+    /// @param max_leases maximum number of leases to be returned (0 means
+    ///        no limit)
+    ///
+    /// @return lease collection, in the order of the expiration time (may
+    ///         be empty if no lease has expired)
+    ///
+    /// @throw bundy::dhcp::DataTruncation Data was truncated on retrieval to
+    ///        fit into the space allocated for the result.  This indicates a
+    ///        programming error.
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease4Collection getExpiredLeases4(size_t max_leases) const;
+
+    /// @brief Returns IPv6 leases which have expired.
+    ///
+    /// @param max_leases maximum number of leases to be returned (0 means
+    ///        no limit)
+    ///
+    /// @return lease collection, in the order of the expiration time (may
+    ///         be empty if no lease has expired)
+    ///
+    /// @throw bundy::BadValue record retrieved from database had an invalid
+    ///        lease type field.
+    /// @throw bundy::dhcp::DataTruncation Data was truncated on retrieval to
+    ///        fit into the space allocated for the result.  This indicates a
+    ///        programming error.
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease6Collection getExpiredLeases6(size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -458,11 +490,13 @@ public:
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <time.h>
@@ -92,6 +93,14 @@ TaggedStatement tagged_statements[] = {
      "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease4 "
      "WHERE client_id = $1 AND subnet_id = $2"},
+    {PgSqlLeaseMgr::GET_LEASE4_EXPIRE, 1,
+         { 20 },
+         "get_lease4_expire",
+     "SELECT address, hwaddr, client_id, "
+     "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease4 "
+     "WHERE expire < CURRENT_TIMESTAMP "
+     "ORDER BY expire LIMIT $1"},
     {PgSqlLeaseMgr::GET_LEASE4_HWADDR, 1,
          { 17 },
          "get_lease4_hwaddr",
@@ -130,6 +139,15 @@ TaggedStatement tagged_statements[] = {
      "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease6 "
      "WHERE lease_type = $1 AND duid = $2 AND iaid = $3 AND subnet_id = $4"},
+    {PgSqlLeaseMgr::GET_LEASE6_EXPIRE, 1,
+        { 20 },
+        "get_lease6_expire",
+     "SELECT address, duid, valid_lifetime, "
+     "extract(epoch from expire)::bigint, subnet_id, pref_lifetime, "
+     "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease6 "
+     "WHERE expire < CURRENT_TIMESTAMP "
+     "ORDER BY expire LIMIT $1"},
     {PgSqlLeaseMgr::GET_VERSION, 0,
         { 0 },
      "get_version",
@@ -1007,6 +1025,50 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
     return (result);
 }
 
+Lease4Collection
+PgSqlLeaseMgr::getExpiredLeases4(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED4).arg(max_leases);
+
+    // Set up the LIMIT clause value (the largest bigint means no limit)
+    BindParams inparams;
+    ostringstream tmp;
+    if (max_leases == 0) {
+        tmp << std::numeric_limits<int64_t>::max();
+    } else {
+        tmp << max_leases;
+    }
+    inparams.push_back(PgSqlParam(tmp.str()));
+
+    // ... and get the data
+    Lease4Collection result;
+    getLeaseCollection(GET_LEASE4_EXPIRE, inparams, result);
+
+    return (result);
+}
+
+Lease6Collection
+PgSqlLeaseMgr::getExpiredLeases6(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED6).arg(max_leases);
+
+    // Set up the LIMIT clause value (the largest bigint means no limit)
+    BindParams inparams;
+    ostringstream tmp;
+    if (max_leases == 0) {
+        tmp << std::numeric_limits<int64_t>::max();
+    } else {
+        tmp << max_leases;
+    }
+    inparams.push_back(PgSqlParam(tmp.str()));
+
+    // ... and get the data
+    Lease6Collection result;
+    getLeaseCollection(GET_LEASE6_EXPIRE, inparams, result);
+
+    return (result);
+}
+
 template <typename LeasePtr>
 void
 PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, BindParams & params,
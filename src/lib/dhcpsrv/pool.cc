@@ -24,7 +24,8 @@ namespace dhcp {
 
 Pool::Pool(Lease::Type type, const bundy::asiolink::IOAddress& first,
            const bundy::asiolink::IOAddress& last)
-    :id_(getNextID()), first_(first), last_(last), type_(type) {
+    :id_(getNextID()), first_(first), last_(last), type_(type),
+     no_free_index_(false) {
 }
 
 bool Pool::inRange(const bundy::asiolink::IOAddress& addr) const {
@@ -39,6 +40,24 @@ Pool::toText() const {
     return (tmp.str());
 }
 
+uint8_t
+Pool::getAllocatedLength() const {
+    return (first_.isV4() ? 32 : 128);
+}
+
+FreeAddressIndexPtr
+Pool::getFreeIndex() {
+    if (!free_index_ && !no_free_index_) {
+        const uint8_t len = getAllocatedLength();
+        if (FreeAddressIndex::canIndex(first_, last_, len)) {
+            free_index_.reset(new FreeAddressIndex(first_, last_, len));
+        } else {
+            no_free_index_ = true;
+        }
+    }
+    return (free_index_);
+}
+
 Pool4::Pool4(const bundy::asiolink::IOAddress& first,
              const bundy::asiolink::IOAddress& last)
 :Pool(Lease::TYPE_V4, first, last) {
@@ -17,6 +17,7 @@
 
 #include <asiolink/io_address.h>
 #include <boost/shared_ptr.hpp>
+#include <dhcpsrv/free_address_index.h>
 #include <dhcpsrv/lease.h>
 
 #include <vector>
@@ -71,6 +72,16 @@ public:
     /// @return textual representation
     virtual std::string toText() const;
 
+    /// @brief Returns the index of the addresses in use in the pool.
+    ///
+    /// The index is created when this method is called for the first time.
+    /// It is used by the allocation engine to skip addresses known to be
+    /// in use (see @c FreeAddressIndex for details).
+    ///
+    /// @return The index, or an empty pointer if the pool is too large to
+    /// be indexed.
+    FreeAddressIndexPtr getFreeIndex();
+
     /// @brief virtual destructor
     ///
     /// We need Pool to be a polymorphic class, so we could dynamic cast
@@ -94,6 +105,12 @@ protected:
          const bundy::asiolink::IOAddress& first,
          const bundy::asiolink::IOAddress& last);
 
+    /// @brief Returns the length of the prefixes allocated from the pool.
+    ///
+    /// @return 32 for IPv4 pools and 128 for IPv6 pools; derived classes
+    /// which allocate prefixes return their length.
+    virtual uint8_t getAllocatedLength() const;
+
     /// @brief returns the next unique Pool-ID
     ///
     /// @return the next unique Pool-ID
@@ -120,6 +137,12 @@ protected:
 
     /// @brief defines a lease type that will be served from this pool
     Lease::Type type_;
+
+    /// @brief The index of the addresses in use, created on demand.
+    FreeAddressIndexPtr free_index_;
+
+    /// @brief true if the pool can't be indexed.
+    bool no_free_index_;
 };
 
 /// @brief Pool information for IPv4 addresses
@@ -214,6 +237,12 @@ public:
     /// @return textual representation
     virtual std::string toText() const;
 
+protected:
+    /// @brief Returns the delegated prefix length.
+    virtual uint8_t getAllocatedLength() const {
+        return (prefix_len_);
+    }
+
 private:
     /// @brief Defines prefix length (for TYPE_PD only)
     uint8_t prefix_len_;
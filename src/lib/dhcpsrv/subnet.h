@@ -381,6 +381,25 @@ public:
     /// @return network interface name for directly attached subnets or ""
     std::string getIface() const;
 
+    /// @brief Sets the name of the allocator used for this subnet
+    ///
+    /// The allocator picks addresses and prefixes for new leases. The names
+    /// are those accepted by @c AllocEngine::allocTypeFromText() (e.g.
+    /// "iterative", "hashed" or "random"). An empty name means that the
+    /// allocator selected for the server is used.
+    ///
+    /// @param allocator_type name of the allocator
+    void setAllocatorType(const std::string& allocator_type) {
+        allocator_type_ = allocator_type;
+    }
+
+    /// @brief Returns the name of the allocator used for this subnet
+    ///
+    /// @return name of the allocator, or "" for the server's default
+    const std::string& getAllocatorType() const {
+        return (allocator_type_);
+    }
+
     /// @brief Returns textual representation of the subnet (e.g.
     /// "2001:db8::/64")
     ///
@@ -585,6 +604,9 @@ protected:
     /// @brief Name of the network interface (if connected directly)
     std::string iface_;
 
+    /// @brief Name of the allocator used for this subnet ("" for default)
+    std::string allocator_type_;
+
     /// @brief Relay information
     ///
     /// See @ref RelayInfo for detailed description. This structure is public,
@@ -20,6 +20,7 @@
 
 #include <gtest/gtest.h>
 
+#include <limits>
 #include <vector>
 
 #include <stdint.h>
@@ -200,4 +201,54 @@ TEST(AddrUtilitiesTest, getNetmask4) {
     EXPECT_THROW(getNetmask4(33), bundy::BadValue);
 }
 
+// Checks that the number of prefixes in a range is calculated correctly.
+TEST(AddrUtilitiesTest, prefixesInRange) {
+    EXPECT_EQ(1, prefixesInRange(IOAddress("192.0.2.1"),
+                                 IOAddress("192.0.2.1"), 32));
+    EXPECT_EQ(256, prefixesInRange(IOAddress("192.0.2.0"),
+                                   IOAddress("192.0.2.255"), 32));
+    EXPECT_EQ(1ULL << 32, prefixesInRange(IOAddress("0.0.0.0"),
+                                          IOAddress("255.255.255.255"), 32));
+    EXPECT_EQ(17, prefixesInRange(IOAddress("2001:db8::10"),
+                                  IOAddress("2001:db8::20"), 128));
+    EXPECT_EQ(256, prefixesInRange(IOAddress("2001:db8::"),
+                                   IOAddress("2001:db8:0:ff:ffff:ffff:ffff:ffff"),
+                                   64));
+
+    // Too many prefixes to count.
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+              prefixesInRange(IOAddress("2001:db8::"),
+                              IOAddress("2001:db8::ffff:ffff:ffff:ffff:ffff"),
+                              128));
+
+    EXPECT_THROW(prefixesInRange(IOAddress("192.0.2.1"),
+                                 IOAddress("2001:db8::1"), 32),
+                 bundy::BadValue);
+    EXPECT_THROW(prefixesInRange(IOAddress("192.0.2.2"),
+                                 IOAddress("192.0.2.1"), 32),
+                 bundy::BadValue);
+    EXPECT_THROW(prefixesInRange(IOAddress("192.0.2.1"),
+                                 IOAddress("192.0.2.2"), 33),
+                 bundy::BadValue);
+}
+
+// Checks that prefixes are offset correctly.
+TEST(AddrUtilitiesTest, offsetPrefix) {
+    EXPECT_EQ("192.0.2.1", offsetPrefix(IOAddress("192.0.2.1"), 0,
+                                        32).toText());
+    EXPECT_EQ("192.0.3.4", offsetPrefix(IOAddress("192.0.2.0"), 260,
+                                        32).toText());
+    EXPECT_EQ("0.0.0.1", offsetPrefix(IOAddress("255.255.255.255"), 2,
+                                      32).toText());
+    EXPECT_EQ("2001:db8::20", offsetPrefix(IOAddress("2001:db8::10"), 16,
+                                           128).toText());
+    EXPECT_EQ("2001:db8:0:2::", offsetPrefix(IOAddress("2001:db8::"), 2,
+                                             64).toText());
+    EXPECT_EQ("2001:db9::", offsetPrefix(IOAddress("2001:db8:ffff::"), 1,
+                                         48).toText());
+
+    EXPECT_THROW(offsetPrefix(IOAddress("192.0.2.1"), 1, 33),
+                 bundy::BadValue);
+}
+
 }; // end of anonymous namespace
@@ -29,6 +29,7 @@
 #include <hooks/callout_manager.h>
 #include <hooks/hooks_manager.h>
 
+#include <boost/lexical_cast.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
@@ -63,7 +64,10 @@ public:
 
     // Expose internal classes for testing purposes
     using AllocEngine::Allocator;
+    using AllocEngine::AllocatorPtr;
     using AllocEngine::IterativeAllocator;
+    using AllocEngine::HashedAllocator;
+    using AllocEngine::RandomAllocator;
     using AllocEngine::getAllocator;
 
     /// @brief IterativeAllocator with internal methods exposed
@@ -470,9 +474,8 @@ public:
 TEST_F(AllocEngine6Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)), NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)), NotImplemented);
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)));
 
     ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100, true)));
 
@@ -800,6 +803,50 @@ TEST_F(AllocEngine6Test, IterativeAllocator_manyPools6) {
     }
 }
 
+// This test verifies that the hashed allocator picks the same address and
+// prefix for the same client, and that each pick is within the pools.
+TEST_F(AllocEngine6Test, HashedAllocator6) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+    NakedAllocEngine::HashedAllocator pd_alloc(Lease::TYPE_PD);
+
+    const IOAddress addr = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, addr));
+    const IOAddress prefix = pd_alloc.pickAddress(subnet_, duid_,
+                                                  IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, prefix));
+
+    // The picks don't depend on the allocator state, so they are the same
+    // after the server restart.
+    NakedAllocEngine::HashedAllocator alloc2(Lease::TYPE_NA);
+    NakedAllocEngine::HashedAllocator pd_alloc2(Lease::TYPE_PD);
+    EXPECT_EQ(addr, alloc2.pickAddress(subnet_, duid_, IOAddress("::")));
+    EXPECT_EQ(prefix, pd_alloc2.pickAddress(subnet_, duid_, IOAddress("::")));
+
+    // The next attempt picks another address.
+    const IOAddress next = alloc.pickAddress(subnet_, duid_, addr);
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, next));
+    EXPECT_NE(addr, next);
+}
+
+// This test verifies that the random allocator picks addresses and prefixes
+// within the pools.
+TEST_F(AllocEngine6Test, RandomAllocator6) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_NA);
+    NakedAllocEngine::RandomAllocator pd_alloc(Lease::TYPE_PD);
+
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+
+        candidate = pd_alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+    }
+    // The pool has 17 addresses; all of them are picked sooner or later.
+    EXPECT_EQ(17, generated_addrs.size());
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine6Test, smallPool6) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -985,6 +1032,53 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that expired leases are removed from the lease database
+// and their addresses marked as free, while valid leases are kept.
+TEST_F(AllocEngine6Test, reclaimExpiredLeases6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100)));
+    ASSERT_TRUE(engine);
+
+    FreeAddressIndexPtr index = pool_->getFreeIndex();
+    ASSERT_TRUE(index);
+
+    // Three expired leases and a valid one.
+    const time_t now = time(NULL);
+    for (int i = 0; i < 4; ++i) {
+        IOAddress addr("2001:db8:1::1" + boost::lexical_cast<std::string>(i));
+        Lease6Ptr lease(new Lease6(Lease::TYPE_NA, addr, duid_, iaid_ + i,
+                                   501, 502, 503, 504, subnet_->getID(), 0));
+        lease->cltt_ = (i < 3 ? now - 500 - i : now);
+        lease->valid_lft_ = 495;
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        index->markUsed(addr);
+    }
+
+    // Reclaim two leases at most: the ones which expired first.
+    const Subnet6Collection& subnets = *CfgMgr::instance().getSubnets6();
+    Lease6Collection reclaimed = engine->reclaimExpiredLeases6(subnets, 2);
+    ASSERT_EQ(2, reclaimed.size());
+    EXPECT_EQ("2001:db8:1::12", reclaimed[0]->addr_.toText());
+    EXPECT_EQ("2001:db8:1::11", reclaimed[1]->addr_.toText());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                                                       IOAddress("2001:db8:1::12")));
+    EXPECT_FALSE(index->isUsed(IOAddress("2001:db8:1::12")));
+    EXPECT_FALSE(index->isUsed(IOAddress("2001:db8:1::11")));
+    EXPECT_TRUE(index->isUsed(IOAddress("2001:db8:1::10")));
+
+    // The rest of the expired leases.
+    reclaimed = engine->reclaimExpiredLeases6(subnets, 0);
+    ASSERT_EQ(1, reclaimed.size());
+    EXPECT_EQ("2001:db8:1::10", reclaimed[0]->addr_.toText());
+    EXPECT_FALSE(index->isUsed(IOAddress("2001:db8:1::10")));
+
+    // The valid lease is left alone.
+    EXPECT_TRUE(engine->reclaimExpiredLeases6(subnets, 0).empty());
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                                                      IOAddress("2001:db8:1::13")));
+    EXPECT_TRUE(index->isUsed(IOAddress("2001:db8:1::13")));
+}
+
 // --- IPv4 ---
 
 // This test checks if the v4 Allocation Engine can be instantiated, parses
@@ -992,11 +1086,10 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
 TEST_F(AllocEngine4Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5, false)),
-                 NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5, false)),
-                 NotImplemented);
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5,
+                                            false)));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5,
+                                            false)));
 
     // Create V4 (ipv6=false) Allocation Engine that will try at most
     // 100 attempts to pick up a lease
@@ -1310,6 +1403,219 @@ TEST_F(AllocEngine4Test, IterativeAllocator_manyPools4) {
 }
 
 
+// This test verifies that the iterative allocator skips the addresses marked
+// as used in the free address index of the pool.
+TEST_F(AllocEngine4Test, IterativeAllocatorSkipUsed4) {
+    NakedAllocEngine::IterativeAllocator alloc(Lease::TYPE_V4);
+    FreeAddressIndexPtr index = pool_->getFreeIndex();
+    ASSERT_TRUE(index);
+
+    index->markUsed(IOAddress("192.0.2.100"));
+    index->markUsed(IOAddress("192.0.2.102"));
+    index->markUsed(IOAddress("192.0.2.103"));
+
+    EXPECT_EQ("192.0.2.101", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+    EXPECT_EQ("192.0.2.104", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+
+    // The search wraps around to the beginning of the pool.
+    for (int i = 105; i <= 109; ++i) {
+        index->markUsed(IOAddress("192.0.2." +
+                                  boost::lexical_cast<std::string>(i)));
+    }
+    EXPECT_EQ("192.0.2.101", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+
+    // When all addresses are marked, the marks are forgotten and the
+    // addresses are tried one after another again.
+    index->markUsed(IOAddress("192.0.2.101"));
+    index->markUsed(IOAddress("192.0.2.104"));
+    EXPECT_EQ("192.0.2.102", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+    EXPECT_EQ(0, index->getUsedCount());
+}
+
+// This test checks that the allocation engine remembers the addresses found
+// in use, so that they don't take allocation attempts again.
+TEST_F(AllocEngine4Test, allocateLease4SkipUsed) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+
+    // Addresses 192.0.2.100-105 are leased to other clients.
+    for (int i = 100; i <= 105; ++i) {
+        uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe,
+                             static_cast<uint8_t>(i) };
+        Lease4Ptr lease(new Lease4(IOAddress("192.0.2." +
+                                       boost::lexical_cast<std::string>(i)),
+                                   hwaddr, sizeof(hwaddr), NULL, 0,
+                                   501, 502, 503, time(NULL),
+                                   subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "",
+                                             false, CalloutHandlePtr(),
+                                             old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.106", lease->addr_.toText());
+    EXPECT_EQ(7, pool_->getFreeIndex()->getUsedCount());
+
+    // Let the allocator start over from the beginning of the pool. A single
+    // attempt is enough to allocate a free address for another client.
+    subnet_->setLastAllocated(Lease::TYPE_V4, IOAddress("192.0.2.109"));
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 1, false)));
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    HWAddrPtr hwaddr(new HWAddr(hwaddr2, sizeof(hwaddr2), HTYPE_ETHER));
+    lease = engine->allocateLease4(subnet_, ClientIdPtr(), hwaddr,
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.107", lease->addr_.toText());
+}
+
+// This test verifies that the hashed allocator picks the same address for
+// the same client, also after the server restart, and that different clients
+// are spread over all pools.
+TEST_F(AllocEngine4Test, HashedAllocator4) {
+    for (int i = 2; i < 10; ++i) {
+        stringstream min, max;
+        min << "192.0.2." << i * 10 + 1;
+        max << "192.0.2." << i * 10 + 9;
+        subnet_->addPool(Pool4Ptr(new Pool4(IOAddress(min.str()),
+                                            IOAddress(max.str()))));
+    }
+
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+    const IOAddress addr = alloc.pickAddress(subnet_, clientid_,
+                                             IOAddress("0.0.0.0"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, addr));
+    EXPECT_EQ(addr, alloc.pickAddress(subnet_, clientid_,
+                                      IOAddress("0.0.0.0")));
+
+    NakedAllocEngine::HashedAllocator alloc2(Lease::TYPE_V4);
+    EXPECT_EQ(addr, alloc2.pickAddress(subnet_, clientid_,
+                                       IOAddress("0.0.0.0")));
+
+    // Different clients get different addresses from all pools.
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 256; ++i) {
+        ClientIdPtr clientid(new ClientId(vector<uint8_t>(8, i)));
+        const IOAddress candidate = alloc.pickAddress(subnet_, clientid,
+                                                      IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        generated_addrs.insert(candidate);
+    }
+    EXPECT_LT(40, generated_addrs.size());
+    EXPECT_TRUE(generated_addrs.count(IOAddress("192.0.2.105")) ||
+                generated_addrs.count(IOAddress("192.0.2.106")) ||
+                generated_addrs.count(IOAddress("192.0.2.107")));
+    EXPECT_TRUE(generated_addrs.count(IOAddress("192.0.2.25")) ||
+                generated_addrs.count(IOAddress("192.0.2.26")) ||
+                generated_addrs.count(IOAddress("192.0.2.27")));
+}
+
+// This test verifies that the hashed allocator skips the addresses marked
+// as used in the free address index of the pool.
+TEST_F(AllocEngine4Test, HashedAllocatorSkipUsed4) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+    FreeAddressIndexPtr index = pool_->getFreeIndex();
+    ASSERT_TRUE(index);
+
+    // Only 192.0.2.101 is not marked as used, so it is picked wherever the
+    // hash points to.
+    for (int i = 100; i <= 109; ++i) {
+        if (i != 101) {
+            index->markUsed(IOAddress("192.0.2." +
+                                      boost::lexical_cast<std::string>(i)));
+        }
+    }
+    for (int i = 0; i < 16; ++i) {
+        ClientIdPtr clientid(new ClientId(vector<uint8_t>(8, i)));
+        EXPECT_EQ("192.0.2.101",
+                  alloc.pickAddress(subnet_, clientid,
+                                    IOAddress("0.0.0.0")).toText());
+    }
+}
+
+// This test verifies that the random allocator picks addresses within
+// the pool.
+TEST_F(AllocEngine4Test, RandomAllocator4) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_V4);
+
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, clientid_,
+                                                IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        generated_addrs.insert(candidate);
+    }
+    // All 10 addresses of the pool are picked sooner or later.
+    EXPECT_EQ(10, generated_addrs.size());
+}
+
+// This test checks that the allocator selected for the subnet is used, and
+// that the hashed allocator leases the same address to the client after the
+// server restart.
+TEST_F(AllocEngine4Test, subnetAllocator4) {
+    boost::scoped_ptr<NakedAllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new NakedAllocEngine(
+                                     AllocEngine::ALLOC_ITERATIVE, 100, false)));
+
+    // By default, the engine's allocator is used.
+    EXPECT_EQ(engine->getAllocator(Lease::TYPE_V4),
+              engine->getAllocator(Lease::TYPE_V4, subnet_));
+
+    subnet_->setAllocatorType("hashed");
+    NakedAllocEngine::AllocatorPtr alloc =
+        engine->getAllocator(Lease::TYPE_V4, subnet_);
+    ASSERT_TRUE(alloc);
+    EXPECT_NE(engine->getAllocator(Lease::TYPE_V4), alloc);
+    EXPECT_TRUE(dynamic_cast<NakedAllocEngine::HashedAllocator*>(alloc.get()));
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "",
+                                             true, CalloutHandlePtr(),
+                                             old_lease_);
+    ASSERT_TRUE(lease);
+
+    // The new engine offers the same address.
+    ASSERT_NO_THROW(engine.reset(new NakedAllocEngine(
+                                     AllocEngine::ALLOC_ITERATIVE, 100, false)));
+    Lease4Ptr lease2 = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                              IOAddress("0.0.0.0"),
+                                              false, false, "",
+                                              true, CalloutHandlePtr(),
+                                              old_lease_);
+    ASSERT_TRUE(lease2);
+    EXPECT_EQ(lease->addr_, lease2->addr_);
+
+    subnet_->setAllocatorType("random");
+    alloc = engine->getAllocator(Lease::TYPE_V4, subnet_);
+    EXPECT_TRUE(dynamic_cast<NakedAllocEngine::RandomAllocator*>(alloc.get()));
+
+    subnet_->setAllocatorType("bogus");
+    EXPECT_THROW(engine->getAllocator(Lease::TYPE_V4, subnet_), BadValue);
+}
+
+// This test checks that the allocation algorithm names are converted to the
+// allocator types.
+TEST(AllocEngineTest, allocTypeFromText) {
+    EXPECT_EQ(AllocEngine::ALLOC_ITERATIVE,
+              AllocEngine::allocTypeFromText("iterative"));
+    EXPECT_EQ(AllocEngine::ALLOC_HASHED,
+              AllocEngine::allocTypeFromText("hashed"));
+    EXPECT_EQ(AllocEngine::ALLOC_RANDOM,
+              AllocEngine::allocTypeFromText("random"));
+    EXPECT_THROW(AllocEngine::allocTypeFromText(""), BadValue);
+    EXPECT_THROW(AllocEngine::allocTypeFromText("Hashed"), BadValue);
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine4Test, smallPool4) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -1509,6 +1815,54 @@ TEST_F(AllocEngine4Test, requestReuseExpiredLease4) {
     EXPECT_TRUE(*old_lease_ == original_lease);
 }
 
+// This test checks that expired leases are removed from the lease database
+// and their addresses marked as free, while valid leases are kept.
+TEST_F(AllocEngine4Test, reclaimExpiredLeases4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    FreeAddressIndexPtr index = pool_->getFreeIndex();
+    ASSERT_TRUE(index);
+
+    // Three expired leases and a valid one.
+    const time_t now = time(NULL);
+    for (int i = 0; i < 4; ++i) {
+        IOAddress addr("192.0.2." + boost::lexical_cast<std::string>(100 + i));
+        uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe,
+                             static_cast<uint8_t>(i) };
+        Lease4Ptr lease(new Lease4(addr, hwaddr, sizeof(hwaddr), NULL, 0,
+                                   495, 100, 200,
+                                   (i < 3 ? now - 500 - i : now),
+                                   subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+        index->markUsed(addr);
+    }
+
+    // Reclaim two leases at most: the ones which expired first.
+    const Subnet4Collection& subnets = *CfgMgr::instance().getSubnets4();
+    Lease4Collection reclaimed = engine->reclaimExpiredLeases4(subnets, 2);
+    ASSERT_EQ(2, reclaimed.size());
+    EXPECT_EQ("192.0.2.102", reclaimed[0]->addr_.toText());
+    EXPECT_EQ("192.0.2.101", reclaimed[1]->addr_.toText());
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(IOAddress("192.0.2.102")));
+    EXPECT_FALSE(index->isUsed(IOAddress("192.0.2.102")));
+    EXPECT_FALSE(index->isUsed(IOAddress("192.0.2.101")));
+    EXPECT_TRUE(index->isUsed(IOAddress("192.0.2.100")));
+
+    // The rest of the expired leases.
+    reclaimed = engine->reclaimExpiredLeases4(subnets, 0);
+    ASSERT_EQ(1, reclaimed.size());
+    EXPECT_EQ("192.0.2.100", reclaimed[0]->addr_.toText());
+    EXPECT_FALSE(index->isUsed(IOAddress("192.0.2.100")));
+
+    // The valid lease is left alone.
+    EXPECT_TRUE(engine->reclaimExpiredLeases4(subnets, 0).empty());
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(IOAddress("192.0.2.103")));
+    EXPECT_TRUE(index->isUsed(IOAddress("192.0.2.103")));
+}
+
 /// @todo write renewLease6
 
 // This test checks if a lease is really renewed when renewLease4 method is
@@ -0,0 +1,189 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/free_address_index.h>
+#include <dhcpsrv/pool.h>
+
+#include <gtest/gtest.h>
+
+using namespace bundy;
+using namespace bundy::dhcp;
+using namespace bundy::asiolink;
+
+namespace {
+
+// Checks that invalid pools are rejected.
+TEST(FreeAddressIndexTest, constructor) {
+    FreeAddressIndex index(IOAddress("192.0.2.10"), IOAddress("192.0.2.19"),
+                           32);
+    EXPECT_EQ(10, index.getCapacity());
+    EXPECT_EQ(0, index.getUsedCount());
+
+    // Mixed families.
+    EXPECT_THROW(FreeAddressIndex(IOAddress("192.0.2.1"),
+                                  IOAddress("2001:db8::1"), 32), BadValue);
+    // The last address is smaller than the first one.
+    EXPECT_THROW(FreeAddressIndex(IOAddress("192.0.2.2"),
+                                  IOAddress("192.0.2.1"), 32), BadValue);
+    // Invalid prefix lengths.
+    EXPECT_THROW(FreeAddressIndex(IOAddress("192.0.2.1"),
+                                  IOAddress("192.0.2.2"), 0), BadValue);
+    EXPECT_THROW(FreeAddressIndex(IOAddress("192.0.2.1"),
+                                  IOAddress("192.0.2.2"), 33), BadValue);
+    // Too large.
+    EXPECT_FALSE(FreeAddressIndex::canIndex(IOAddress("10.0.0.0"),
+                                            IOAddress("11.0.0.0"), 32));
+    EXPECT_TRUE(FreeAddressIndex::canIndex(IOAddress("10.0.0.0"),
+                                           IOAddress("10.255.255.255"), 32));
+    EXPECT_FALSE(FreeAddressIndex::canIndex(IOAddress("2001:db8::"),
+                                            IOAddress("2001:db8::ffff:ffff"),
+                                            128));
+}
+
+// Checks that addresses can be marked as used and free.
+TEST(FreeAddressIndexTest, markUsed) {
+    FreeAddressIndex index(IOAddress("192.0.2.0"), IOAddress("192.0.2.255"),
+                           32);
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.100")));
+
+    index.markUsed(IOAddress("192.0.2.100"));
+    EXPECT_TRUE(index.isUsed(IOAddress("192.0.2.100")));
+    EXPECT_EQ(1, index.getUsedCount());
+
+    // Marking it again doesn't change anything.
+    index.markUsed(IOAddress("192.0.2.100"));
+    EXPECT_EQ(1, index.getUsedCount());
+
+    // Addresses out of the pool are ignored.
+    index.markUsed(IOAddress("192.0.3.0"));
+    index.markUsed(IOAddress("2001:db8::1"));
+    EXPECT_EQ(1, index.getUsedCount());
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.3.0")));
+
+    index.markFree(IOAddress("192.0.2.100"));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.100")));
+    EXPECT_EQ(0, index.getUsedCount());
+
+    index.markUsed(IOAddress("192.0.2.1"));
+    index.clear();
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.1")));
+    EXPECT_EQ(0, index.getUsedCount());
+}
+
+// Checks that the next free address is found.
+TEST(FreeAddressIndexTest, findFree) {
+    FreeAddressIndex index(IOAddress("192.0.2.10"), IOAddress("192.0.2.19"),
+                           32);
+    IOAddress addr("0.0.0.0");
+
+    // Starting before the pool means starting at its first address.
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.1"), addr));
+    EXPECT_EQ("192.0.2.10", addr.toText());
+
+    index.markUsed(IOAddress("192.0.2.12"));
+    index.markUsed(IOAddress("192.0.2.13"));
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.12"), addr));
+    EXPECT_EQ("192.0.2.14", addr.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.11"), addr));
+    EXPECT_EQ("192.0.2.11", addr.toText());
+
+    // The search doesn't wrap around.
+    index.markUsed(IOAddress("192.0.2.19"));
+    EXPECT_FALSE(index.findFree(IOAddress("192.0.2.19"), addr));
+    EXPECT_FALSE(index.findFree(IOAddress("192.0.2.20"), addr));
+    EXPECT_FALSE(index.findFree(IOAddress("2001:db8::1"), addr));
+}
+
+// Checks that a free address is found in a large, almost full pool.
+TEST(FreeAddressIndexTest, findFreeLarge) {
+    const IOAddress first("10.0.0.0");
+    const IOAddress last("10.3.255.255");
+    FreeAddressIndex index(first, last, 32);
+    ASSERT_EQ(1 << 18, index.getCapacity());
+
+    // Mark all addresses except for 10.2.3.4 and 10.3.255.255 as used.
+    IOAddress addr("0.0.0.0");
+    while (index.findFree(first, addr)) {
+        if (addr == IOAddress("10.2.3.4")) {
+            break;
+        }
+        index.markUsed(addr);
+    }
+    ASSERT_EQ("10.2.3.4", addr.toText());
+    IOAddress start("10.2.3.5");
+    while (index.findFree(start, addr) &&
+           addr != IOAddress("10.3.255.255")) {
+        index.markUsed(addr);
+    }
+    EXPECT_EQ((1 << 18) - 2, index.getUsedCount());
+
+    ASSERT_TRUE(index.findFree(first, addr));
+    EXPECT_EQ("10.2.3.4", addr.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("10.2.3.5"), addr));
+    EXPECT_EQ("10.3.255.255", addr.toText());
+
+    index.markUsed(IOAddress("10.2.3.4"));
+    index.markUsed(IOAddress("10.3.255.255"));
+    EXPECT_FALSE(index.findFree(first, addr));
+
+    // Freeing an address makes it found again.
+    index.markFree(IOAddress("10.0.0.1"));
+    ASSERT_TRUE(index.findFree(first, addr));
+    EXPECT_EQ("10.0.0.1", addr.toText());
+}
+
+// Checks the IPv6 addresses and prefixes.
+TEST(FreeAddressIndexTest, findFreeV6) {
+    FreeAddressIndex index(IOAddress("2001:db8::"),
+                           IOAddress("2001:db8::ffff"), 128);
+    EXPECT_EQ(65536, index.getCapacity());
+    index.markUsed(IOAddress("2001:db8::"));
+    IOAddress addr("::");
+    ASSERT_TRUE(index.findFree(IOAddress("::"), addr));
+    EXPECT_EQ("2001:db8::1", addr.toText());
+
+    // A /48 pool of /64 prefixes.
+    FreeAddressIndex pd_index(IOAddress("2001:db8:1::"),
+                              IOAddress("2001:db8:1:ffff:ffff:ffff:ffff:ffff"),
+                              64);
+    EXPECT_EQ(65536, pd_index.getCapacity());
+    pd_index.markUsed(IOAddress("2001:db8:1::"));
+    pd_index.markUsed(IOAddress("2001:db8:1:1::"));
+    ASSERT_TRUE(pd_index.findFree(IOAddress("2001:db8:1::"), addr));
+    EXPECT_EQ("2001:db8:1:2::", addr.toText());
+}
+
+// Checks that pools create the index of the proper size.
+TEST(FreeAddressIndexTest, pool) {
+    Pool4 pool4(IOAddress("192.0.2.0"), 24);
+    FreeAddressIndexPtr index = pool4.getFreeIndex();
+    ASSERT_TRUE(index);
+    EXPECT_EQ(256, index->getCapacity());
+    // The same index is returned.
+    EXPECT_EQ(index, pool4.getFreeIndex());
+
+    Pool6 pool6(Lease::TYPE_PD, IOAddress("2001:db8:1::"), 48, 56);
+    index = pool6.getFreeIndex();
+    ASSERT_TRUE(index);
+    EXPECT_EQ(256, index->getCapacity());
+
+    // The pool is too large.
+    Pool6 large_pool6(Lease::TYPE_NA, IOAddress("2001:db8::"), 64);
+    EXPECT_FALSE(large_pool6.getFreeIndex());
+}
+
+}
@@ -17,6 +17,7 @@
 #include <asiolink/io_address.h>
 #include <gtest/gtest.h>
 #include <sstream>
+#include <ctime>
 
 using namespace std;
 using namespace bundy::asiolink;
@@ -1506,6 +1507,84 @@ GenericLeaseMgrTest::testRecreateLease6() {
     detailCompareLease(lease, l_returned);
 }
 
+void
+GenericLeaseMgrTest::testGetExpiredLeases4() {
+    // The leases created for the tests have expired long ago. Make every
+    // other lease valid, so as it is not returned.
+    std::vector<Lease4Ptr> leases = createLeases4();
+    const time_t now = time(NULL);
+    for (size_t i = 0; i < leases.size(); ++i) {
+        if (i % 2 != 0) {
+            leases[i]->cltt_ = now;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+
+    // All expired leases are returned when there's no limit.
+    Lease4Collection returned = lmptr_->getExpiredLeases4(0);
+    ASSERT_EQ((leases.size() + 1) / 2, returned.size());
+    for (size_t i = 0; i < returned.size(); ++i) {
+        EXPECT_TRUE(returned[i]->expired());
+        if (i > 0) {
+            EXPECT_LE(returned[i - 1]->getExpirationTime(),
+                      returned[i]->getExpirationTime());
+        }
+    }
+
+    // The limit is honored, and the earliest expired leases are returned.
+    Lease4Collection limited = lmptr_->getExpiredLeases4(2);
+    ASSERT_EQ(2, limited.size());
+    EXPECT_EQ(returned[0]->addr_.toText(), limited[0]->addr_.toText());
+    EXPECT_EQ(returned[1]->addr_.toText(), limited[1]->addr_.toText());
+
+    // Once a lease is renewed, it is no longer returned.
+    Lease4Ptr renewed(new Lease4(*returned[0]));
+    renewed->cltt_ = now;
+    lmptr_->updateLease4(renewed);
+    returned = lmptr_->getExpiredLeases4(0);
+    ASSERT_EQ((leases.size() + 1) / 2 - 1, returned.size());
+    EXPECT_EQ(limited[1]->addr_.toText(), returned[0]->addr_.toText());
+}
+
+void
+GenericLeaseMgrTest::testGetExpiredLeases6() {
+    // The leases created for the tests have expired long ago. Make every
+    // other lease valid, so as it is not returned.
+    std::vector<Lease6Ptr> leases = createLeases6();
+    const time_t now = time(NULL);
+    for (size_t i = 0; i < leases.size(); ++i) {
+        if (i % 2 != 0) {
+            leases[i]->cltt_ = now;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+
+    // All expired leases are returned when there's no limit.
+    Lease6Collection returned = lmptr_->getExpiredLeases6(0);
+    ASSERT_EQ((leases.size() + 1) / 2, returned.size());
+    for (size_t i = 0; i < returned.size(); ++i) {
+        EXPECT_TRUE(returned[i]->expired());
+        if (i > 0) {
+            EXPECT_LE(returned[i - 1]->getExpirationTime(),
+                      returned[i]->getExpirationTime());
+        }
+    }
+
+    // The limit is honored, and the earliest expired leases are returned.
+    Lease6Collection limited = lmptr_->getExpiredLeases6(2);
+    ASSERT_EQ(2, limited.size());
+    EXPECT_EQ(returned[0]->addr_.toText(), limited[0]->addr_.toText());
+    EXPECT_EQ(returned[1]->addr_.toText(), limited[1]->addr_.toText());
+
+    // Once a lease is renewed, it is no longer returned.
+    Lease6Ptr renewed(new Lease6(*returned[0]));
+    renewed->cltt_ = now;
+    lmptr_->updateLease6(renewed);
+    returned = lmptr_->getExpiredLeases6(0);
+    ASSERT_EQ((leases.size() + 1) / 2 - 1, returned.size());
+    EXPECT_EQ(limited[1]->addr_.toText(), returned[0]->addr_.toText());
+}
+
 
 }; // namespace test
 }; // namespace dhcp
@@ -245,6 +245,20 @@ public:
     /// persistent storage has been updated as expected.
     void testRecreateLease6();
 
+    /// @brief Checks that expired IPv4 leases are retrieved.
+    ///
+    /// Adds the leases, some of which have expired, and checks that only the
+    /// expired ones are returned, ordered by the expiration time and up to
+    /// the specified number.
+    void testGetExpiredLeases4();
+
+    /// @brief Checks that expired IPv6 leases are retrieved.
+    ///
+    /// Adds the leases, some of which have expired, and checks that only the
+    /// expired ones are returned, ordered by the expiration time and up to
+    /// the specified number.
+    void testGetExpiredLeases6();
+
     /// @brief String forms of IPv4 addresses
     std::vector<std::string>  straddress4_;
 
@@ -204,6 +204,166 @@ TEST_F(MemfileLeaseMgrTest, persistLeases) {
 }
 
 
+// Checks that the interval of the Lease File Cleanup is parsed correctly.
+TEST_F(MemfileLeaseMgrTest, lfcInterval) {
+    LeaseFileIO io4(getLeaseFilePath("leasefile4_1.csv"));
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = getLeaseFilePath("leasefile4_1.csv");
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    // The cleanup is disabled by default.
+    EXPECT_EQ(0, lease_mgr->getLFCInterval());
+
+    pmap["lfc-interval"] = "3600";
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_EQ(3600, lease_mgr->getLFCInterval());
+
+    pmap["lfc-interval"] = "bogus";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+}
+
+// Checks that the Lease File Cleanup replaces the DHCPv4 lease file with
+// the snapshot of the leases, and that the leases are read correctly
+// from the resulting files.
+TEST_F(MemfileLeaseMgrTest, lfcRun4) {
+    LeaseFileIO io_snapshot(io4_.testfile_ + ".1");
+    LeaseFileIO io_previous(io4_.testfile_ + ".2");
+    LeaseFileIO io_output(io4_.testfile_ + ".output");
+
+    // The first lease is updated and the second one is removed.
+    io4_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+                   "fqdn_fwd,fqdn_rev,hostname\n"
+                   "192.0.2.1,06:07:08:09:0a:bc,,100,100,8,1,1,"
+                   "host.example.com\n"
+                   "192.0.3.15,dd:de:ba:0d:1b:2e:3e:4f,0a:00:01:04,100,100,7,"
+                   "0,0,\n"
+                   "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,"
+                   "host.example.com\n"
+                   "192.0.3.15,dd:de:ba:0d:1b:2e:3e:4f,0a:00:01:04,0,100,7,"
+                   "0,0,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    ASSERT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    ASSERT_FALSE(lease_mgr->getLease4(IOAddress("192.0.3.15")));
+
+    ASSERT_NO_THROW(lease_mgr->lfcRun());
+    ASSERT_NO_THROW(lease_mgr->lfcWait());
+
+    // The snapshot holds the only lease; the lease file in use before
+    // the cleanup has been removed and a new one is empty.
+    const std::string header = "address,hwaddr,client_id,valid_lifetime,"
+        "expire,subnet_id,fqdn_fwd,fqdn_rev,hostname\n";
+    EXPECT_EQ(header + "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,"
+              "host.example.com\n", io_snapshot.readFile());
+    EXPECT_FALSE(io_previous.exists());
+    EXPECT_FALSE(io_output.exists());
+    EXPECT_EQ(header, io4_.readFile());
+
+    // The leases are still appended to the lease file.
+    Lease4Ptr lease = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    lease->valid_lft_ = 300;
+    lease_mgr->updateLease4(lease);
+    EXPECT_EQ(header + "192.0.2.1,06:07:08:09:0a:bc,,300,300,8,1,1,"
+              "host.example.com\n", io4_.readFile());
+
+    // Both files are read when the server is restarted.
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    lease = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(300, lease->valid_lft_);
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.3.15")));
+}
+
+// Checks that the DHCPv6 leases are written to the snapshot by the Lease
+// File Cleanup.
+TEST_F(MemfileLeaseMgrTest, lfcRun6) {
+    LeaseFileIO io_snapshot(io6_.testfile_ + ".1");
+    LeaseFileIO io_previous(io6_.testfile_ + ".2");
+
+    const std::string header = "address,duid,valid_lifetime,expire,subnet_id,"
+        "pref_lifetime,lease_type,iaid,prefix_len,fqdn_fwd,fqdn_rev,"
+        "hostname\n";
+    io6_.writeFile(header +
+                   "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,200,8,100,0,7,128,1,1,host.example.com\n"
+                   "2001:db8:2::10,01:01:01:01:0a:01:02:03:04:05,300,300,6,"
+                   "150,0,8,128,0,0,\n"
+                   "2001:db8:2::10,01:01:01:01:0a:01:02:03:04:05,0,300,6,"
+                   "0,0,8,128,0,0,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "6";
+    pmap["name"] = io6_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    ASSERT_NO_THROW(lease_mgr->lfcRun());
+    ASSERT_NO_THROW(lease_mgr->lfcWait());
+
+    EXPECT_EQ(header +
+              "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+              "200,200,8,100,0,7,128,1,1,host.example.com\n",
+              io_snapshot.readFile());
+    EXPECT_FALSE(io_previous.exists());
+    EXPECT_EQ(header, io6_.readFile());
+
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_TRUE(lease_mgr->getLease6(Lease::TYPE_NA,
+                                     IOAddress("2001:db8:1::1")));
+    EXPECT_FALSE(lease_mgr->getLease6(Lease::TYPE_NA,
+                                      IOAddress("2001:db8:2::10")));
+}
+
+// Checks that the cleanup interrupted by the shutdown of the server is
+// completed at startup, and that the leases are read from all the files
+// in the right order.
+TEST_F(MemfileLeaseMgrTest, lfcRecover) {
+    LeaseFileIO io_snapshot(io4_.testfile_ + ".1");
+    LeaseFileIO io_previous(io4_.testfile_ + ".2");
+    LeaseFileIO io_output(io4_.testfile_ + ".output");
+
+    const std::string header = "address,hwaddr,client_id,valid_lifetime,"
+        "expire,subnet_id,fqdn_fwd,fqdn_rev,hostname\n";
+    // The snapshot made by the previous cleanup.
+    io_snapshot.writeFile(header +
+                          "192.0.2.1,06:07:08:09:0a:bc,,100,100,8,0,0,\n"
+                          "192.0.2.2,06:07:08:09:0a:bd,,100,100,8,0,0,\n");
+    // The lease file in use when the last cleanup started: the first
+    // lease has been updated and the second one removed.
+    io_previous.writeFile(header +
+                          "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,0,0,\n"
+                          "192.0.2.2,06:07:08:09:0a:bd,,0,100,8,0,0,\n");
+    // The incomplete snapshot.
+    io_output.writeFile(header +
+                        "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,0,0,\n");
+    // The current lease file.
+    io4_.writeFile(header +
+                   "192.0.2.3,06:07:08:09:0a:be,,100,100,8,0,0,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    Lease4Ptr lease = lease_mgr->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(200, lease->valid_lft_);
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+
+    // The cleanup has been completed.
+    EXPECT_EQ(header +
+              "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,0,0,\n"
+              "192.0.2.3,06:07:08:09:0a:be,,100,100,8,0,0,\n",
+              io_snapshot.readFile());
+    EXPECT_FALSE(io_previous.exists());
+    EXPECT_FALSE(io_output.exists());
+    EXPECT_EQ(header, io4_.readFile());
+}
+
+
 // Checks that adding/getting/deleting a Lease6 object works.
 TEST_F(MemfileLeaseMgrTest, addGetDelete6) {
     startBackend(V6);
@@ -404,6 +564,20 @@ TEST_F(MemfileLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Checks that expired DHCPv4 leases are retrieved in the order of
+/// their expiration.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases4) {
+    startBackend(V4);
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that expired DHCPv6 leases are retrieved in the order of
+/// their expiration.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases6) {
+    startBackend(V6);
+    testGetExpiredLeases6();
+}
+
 // The following tests are not applicable for memfile. When adding
 // new tests to the list here, make sure to provide brief explanation
 // why they are not applicable:
@@ -506,4 +506,16 @@ TEST_F(MySqlLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Checks that expired DHCPv4 leases are retrieved in the order of
+/// their expiration.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that expired DHCPv6 leases are retrieved in the order of
+/// their expiration.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
 }; // Of anonymous namespace
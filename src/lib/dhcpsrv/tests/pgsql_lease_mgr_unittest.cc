@@ -456,4 +456,16 @@ TEST_F(PgSqlLeaseMgrTest, updateLease6) {
     testUpdateLease6();
 }
 
+/// @brief Checks that expired DHCPv4 leases are retrieved in the order of
+/// their expiration.
+TEST_F(PgSqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that expired DHCPv6 leases are retrieved in the order of
+/// their expiration.
+TEST_F(PgSqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
 };
@@ -969,6 +969,17 @@ TEST(Subnet6Test, iface) {
     EXPECT_EQ("en1", subnet.getIface());
 }
 
+// This trivial test checks if the allocation algorithm selected for the
+// subnet is stored properly.
+TEST(Subnet6Test, allocatorType) {
+    Subnet6 subnet(IOAddress("2001:db8::"), 32, 1, 2, 3, 4);
+
+    EXPECT_TRUE(subnet.getAllocatorType().empty());
+
+    subnet.setAllocatorType("hashed");
+    EXPECT_EQ("hashed", subnet.getAllocatorType());
+}
+
 // This trivial test checks if the interface-id option can be set and
 // later retrieved for a subnet6 object.
 TEST(Subnet6Test, interfaceId) {
@@ -0,0 +1,127 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <dns/master_loader.h>
+#include <dns/master_loader_callbacks.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+
+#include <boost/bind.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::bench;
+using namespace bundy::dns;
+
+namespace {
+void
+countRR(size_t* count, const Name&, const RRClass&, const RRType&,
+        const RRTTL&, const rdata::RdataPtr&)
+{
+    ++*count;
+}
+
+void
+ignoreMessage(const string&, size_t, const string&) {
+}
+
+// Load the zone file with MasterLoader, parsing it with the given number
+// of threads.  The RRs are only counted.
+class MasterLoaderBenchMark {
+public:
+    MasterLoaderBenchMark(const string& zone_file, const Name& origin,
+                          size_t n_threads) :
+        zone_file_(zone_file), origin_(origin), n_threads_(n_threads)
+    {}
+    unsigned int run() {
+        size_t count = 0;
+        MasterLoader loader(zone_file_.c_str(), origin_, RRClass::IN(),
+                            MasterLoaderCallbacks(ignoreMessage,
+                                                  ignoreMessage),
+                            boost::bind(countRR, &count,
+                                        _1, _2, _3, _4, _5),
+                            static_cast<MasterLoader::Options>(
+                                MasterLoader::MANY_ERRORS |
+                                MasterLoader::MAP_FILES));
+        loader.setThreadCount(n_threads_);
+        loader.load();
+        return (count);
+    }
+private:
+    const string zone_file_;
+    const Name origin_;
+    const size_t n_threads_;
+};
+
+void
+usage() {
+    cerr << "Usage: master_loader_bench [-n iterations] [-t threads] "
+        "zone_file origin" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 1;
+    int n_threads = 4;
+    while ((ch = getopt(argc, argv, "n:t:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 't':
+            n_threads = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (argc != 2 || n_threads < 1) {
+        usage();
+    }
+    const string zone_file = argv[0];
+    const Name origin(argv[1]);
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Zone file: " << zone_file << endl;
+    cout << "  Origin: " << origin << endl;
+    cout << "  Threads: " << n_threads << endl;
+
+    cout << "Benchmark for loading the zone in a single thread" << endl;
+    BenchMark<MasterLoaderBenchMark>(iteration,
+                                     MasterLoaderBenchMark(zone_file, origin,
+                                                           1));
+
+    cout << "Benchmark for loading the zone with " << n_threads
+         << " threads" << endl;
+    BenchMark<MasterLoaderBenchMark>(iteration,
+                                     MasterLoaderBenchMark(zone_file, origin,
+                                                           n_threads));
+
+    return (0);
+}
@@ -18,8 +18,11 @@
 #include <dns/labelsequence.h>
 #include <dns/messagerenderer.h>
 #include <oldmessagerenderer.h>
+#include <bucketmessagerenderer.h>
 
 #include <cassert>
+#include <sstream>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -100,6 +103,35 @@ const char* const example_servfail_names[] = {
     "www.example.com", NULL
 };
 
+// Names contained in a large response with many distinct names, such as a
+// chunk of AXFR or a DNSSEC-signed negative response in an NSEC3 zone: for
+// each of the given number of hosts, the owner name, its NSEC3 hash owner
+// name and the signer name of the RRSIGs.  The names are generated by
+// getLargeResponseNames().
+const size_t LARGE_RESPONSE_HOSTS = 200;
+
+vector<string>
+getLargeResponseNames() {
+    static const char* const base32hex = "0123456789abcdefghijklmnopqrstuv";
+    vector<string> names;
+    for (size_t i = 0; i < LARGE_RESPONSE_HOSTS; ++i) {
+        ostringstream host;
+        host << "host" << i << ".example.com";
+        names.push_back(host.str());
+
+        // A pseudo NSEC3 hash label, 32 characters long.
+        string label;
+        unsigned int seed = i * 2654435761U;
+        for (size_t j = 0; j < 32; ++j) {
+            seed = seed * 1103515245 + 12345;
+            label.push_back(base32hex[(seed >> 16) % 32]);
+        }
+        names.push_back(label + ".example.com");
+        names.push_back("example.com");
+    }
+    return (names);
+}
+
 // An experimental "dumb" renderer for comparison.  It doesn't do any name
 // compression.  It simply ignores all setter method, returns a dummy value
 // for getter methods, and write names to the internal buffer as plain binary
@@ -152,6 +184,15 @@ main(int argc, char* argv[]) {
     cout << "Parameters:" << endl;
     cout << "  Iterations: " << iteration << endl;
 
+    const vector<string> large_names = getLargeResponseNames();
+    vector<const char*> large_response_names;
+    for (vector<string>::const_iterator it = large_names.begin();
+         it != large_names.end();
+         ++it) {
+        large_response_names.push_back(it->c_str());
+    }
+    large_response_names.push_back(NULL);
+
     typedef pair<const char* const*, string> DataSpec;
     vector<DataSpec> spec_list;
     spec_list.push_back(DataSpec(root_to_com_names, "(positive response)"));
@@ -159,6 +200,8 @@ main(int argc, char* argv[]) {
                                  "(NXDOMAIN response)"));
     spec_list.push_back(DataSpec(example_servfail_names,
                                  "(SERVFAIL response)"));
+    spec_list.push_back(DataSpec(&large_response_names[0],
+                                 "(large response)"));
     for (vector<DataSpec>::const_iterator it = spec_list.begin();
          it != spec_list.end();
          ++it) {
@@ -179,6 +222,13 @@ main(int argc, char* argv[]) {
         BenchMark<DumbRendererBenchMark>(iteration,
                                          DumbRendererBenchMark(names));
 
+        typedef MessageRendererBenchMark<BucketMessageRenderer>
+            BucketRendererBenchMark;
+        cout << "Benchmark for bucket-based MessageRenderer " << it->second
+             << endl;
+        BenchMark<BucketRendererBenchMark>(iteration,
+                                           BucketRendererBenchMark(names));
+
         typedef MessageRendererBenchMark<MessageRenderer> RendererBenchMark;
         cout << "Benchmark for new MessageRenderer " << it->second << endl;
         BenchMark<RendererBenchMark>(iteration, RendererBenchMark(names));
@@ -0,0 +1,236 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/name_internal.h>
+
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::bench;
+using namespace bundy::dns;
+using bundy::dns::name::internal::maptolower;
+
+namespace {
+// A name to be compared in the benchmark.  The label offsets are
+// calculated beforehand, so the byte-by-byte comparison below can walk
+// the labels from the right like LabelSequence does without extra cost.
+struct BenchName {
+    explicit BenchName(const Name& name) :
+        labels(name), nlabels(0)
+    {
+        size_t len;
+        data = labels.getData(&len);
+        for (size_t pos = 0; pos < len; pos += data[pos] + 1) {
+            offsets[nlabels++] = pos;
+        }
+    }
+    LabelSequence labels;
+    const uint8_t* data;
+    size_t offsets[Name::MAX_LABELS];
+    size_t nlabels;
+};
+
+// The byte-by-byte implementation of LabelSequence::equals() and compare()
+// that was used before the comparison was vectorized, for comparison.
+// Only the result needed for the benchmark (the order) is returned.
+class OldLabelSequenceCompare {
+public:
+    static bool equals(const BenchName& name1, const BenchName& name2) {
+        size_t len1, len2;
+        const uint8_t* data1 = name1.labels.getData(&len1);
+        const uint8_t* data2 = name2.labels.getData(&len2);
+        if (len1 != len2) {
+            return (false);
+        }
+        for (size_t i = 0; i < len1; ++i) {
+            if (maptolower[data1[i]] != maptolower[data2[i]]) {
+                return (false);
+            }
+        }
+        return (true);
+    }
+    static int compare(const BenchName& name1, const BenchName& name2) {
+        size_t l1 = name1.nlabels;
+        size_t l2 = name2.nlabels;
+        while (l1 > 0 && l2 > 0) {
+            size_t pos1 = name1.offsets[--l1];
+            size_t pos2 = name2.offsets[--l2];
+            const unsigned int count1 = name1.data[pos1++];
+            const unsigned int count2 = name2.data[pos2++];
+            unsigned int count = (count1 < count2) ? count1 : count2;
+            while (count > 0) {
+                const int chdiff =
+                    static_cast<int>(maptolower[name1.data[pos1]]) -
+                    static_cast<int>(maptolower[name2.data[pos2]]);
+                if (chdiff != 0) {
+                    return (chdiff);
+                }
+                --count;
+                ++pos1;
+                ++pos2;
+            }
+            if (count1 != count2) {
+                return (static_cast<int>(count1) - static_cast<int>(count2));
+            }
+        }
+        return (static_cast<int>(l1) - static_cast<int>(l2));
+    }
+};
+
+// The current implementation of LabelSequence.
+class LabelSequenceCompare {
+public:
+    static bool equals(const BenchName& name1, const BenchName& name2) {
+        return (name1.labels.equals(name2.labels));
+    }
+    static int compare(const BenchName& name1, const BenchName& name2) {
+        return (name1.labels.compare(name2.labels).getOrder());
+    }
+};
+
+// The results of the comparisons are written here so that the compiler
+// cannot omit them.
+volatile unsigned int bench_result;
+
+// This templated benchmark compares each name of the given set with its
+// counterpart in the other set (which differ in the case of all letters
+// and possibly at the end of the first label), first for equality, then
+// for ordering.
+template <typename T>
+class NameCompareBenchMark {
+public:
+    NameCompareBenchMark(const vector<BenchName>& names1,
+                         const vector<BenchName>& names2) :
+        names1_(names1), names2_(names2)
+    {}
+    unsigned int run() {
+        unsigned int matched = 0;
+        for (size_t i = 0; i < names1_.size(); ++i) {
+            if (T::equals(names1_[i], names2_[i])) {
+                ++matched;
+            }
+            if (T::compare(names1_[i], names2_[i]) == 0) {
+                ++matched;
+            }
+            bench_result = matched;
+        }
+        // Half of the names match, and they should match in both tests.
+        assert(matched == names1_.size());
+        // Store the result so the comparison isn't optimized away.
+        bench_result = matched;
+        return (names1_.size() * 2);
+    }
+private:
+    const vector<BenchName>& names1_;
+    const vector<BenchName>& names2_;
+};
+
+// Build a set of names whose first label is of the given length, and the
+// corresponding names in upper case.  Every other name differs at the last
+// character of the first label so the comparison covers both results.
+void
+buildNames(size_t label_len, vector<Name>& names1, vector<Name>& names2) {
+    static const char* const suffix = ".zone-with-a-longer-name.example.com";
+    for (size_t i = 0; i < 100; ++i) {
+        string label;
+        unsigned int seed = (i + 1) * 2654435761U;
+        for (size_t j = 0; j < label_len; ++j) {
+            seed = seed * 1103515245 + 12345;
+            label.push_back('a' + (seed >> 16) % 26);
+        }
+        string upper_label;
+        for (size_t j = 0; j < label.size(); ++j) {
+            upper_label.push_back(toupper(label[j]));
+        }
+        if (i % 2 == 1) {
+            upper_label[upper_label.size() - 1] = '0';
+        }
+        string upper_suffix(suffix);
+        for (size_t j = 0; j < upper_suffix.size(); ++j) {
+            upper_suffix[j] = toupper(upper_suffix[j]);
+        }
+        names1.push_back(Name(label + suffix));
+        names2.push_back(Name(upper_label + upper_suffix));
+    }
+}
+
+void
+usage() {
+    cerr << "Usage: name_compare_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 10000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    const size_t label_lengths[] = { 3, 16, 32, 63 };
+    for (size_t i = 0; i < sizeof(label_lengths) / sizeof(label_lengths[0]);
+         ++i) {
+        vector<Name> names1, names2;
+        buildNames(label_lengths[i], names1, names2);
+        vector<BenchName> bench_names1, bench_names2;
+        for (size_t j = 0; j < names1.size(); ++j) {
+            bench_names1.push_back(BenchName(names1[j]));
+            bench_names2.push_back(BenchName(names2[j]));
+        }
+
+        typedef NameCompareBenchMark<OldLabelSequenceCompare>
+            OldCompareBenchMark;
+        cout << "Benchmark for byte-by-byte comparison (label length "
+             << label_lengths[i] << ")" << endl;
+        BenchMark<OldCompareBenchMark>(iteration,
+                                       OldCompareBenchMark(bench_names1,
+                                                           bench_names2));
+
+        typedef NameCompareBenchMark<LabelSequenceCompare> CompareBenchMark;
+        cout << "Benchmark for LabelSequence comparison (label length "
+             << label_lengths[i] << ")" << endl;
+        BenchMark<CompareBenchMark>(iteration,
+                                    CompareBenchMark(bench_names1,
+                                                     bench_names2));
+    }
+
+    return (0);
+}
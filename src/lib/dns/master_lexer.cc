@@ -63,6 +63,17 @@ struct MasterLexer::MasterLexerImpl {
         separators_.set('"');
         esc_separators_.set('\r');
         esc_separators_.set('\n');
+        // The characters that need to be examined one by one in the
+        // string state: those which can end the string (see isTokenEnd())
+        // or start a comment or an escape.
+        for (size_t i = 0; i < string_stops_.size(); ++i) {
+            if (separators_.test(i & 0x7f) || i == ';' || i == '\\') {
+                string_stops_.set(i);
+            }
+        }
+        qstring_stops_.set('"');
+        qstring_stops_.set('\\');
+        qstring_stops_.set('\n');
     }
 
     // A helper method to skip possible comments toward the end of EOL or EOF.
@@ -71,12 +82,7 @@ struct MasterLexer::MasterLexerImpl {
     // current character.
     int skipComment(int c, bool escaped = false) {
         if (c == ';' && !escaped) {
-            while (true) {
-                c = source_->getChar();
-                if (c == '\n' || c == InputSource::END_OF_STREAM) {
-                    return (c);
-                }
-            }
+            return (source_->skipLine());
         }
         return (c);
     }
@@ -127,6 +133,11 @@ struct MasterLexer::MasterLexerImpl {
     std::bitset<128> separators_;
     std::bitset<128> esc_separators_;
 
+    // The characters not to be simply copied to the token data in the
+    // string and qstring states, respectively.
+    InputSource::StopChars string_stops_;
+    InputSource::StopChars qstring_stops_;
+
     // These are to allow restoring state before previous token.
     bool has_previous_;
     size_t previous_paren_count_;
@@ -141,13 +152,16 @@ MasterLexer::~MasterLexer() {
 }
 
 bool
-MasterLexer::pushSource(const char* filename, std::string* error) {
+MasterLexer::pushSource(const char* filename, std::string* error,
+                        bool map_file)
+{
     if (filename == NULL) {
         bundy_throw(InvalidParameter,
                   "NULL filename for MasterLexer::pushSource");
     }
     try {
-        impl_->sources_.push_back(InputSourcePtr(new InputSource(filename)));
+        impl_->sources_.push_back(InputSourcePtr(new InputSource(filename,
+                                                                 map_file)));
     } catch (const InputSource::OpenError& ex) {
         if (error != NULL) {
             *error = ex.what();
@@ -519,6 +533,10 @@ String::handle(MasterLexer& lexer) const {
 
     bool escaped = false;
     while (true) {
+        if (!escaped) {
+            getLexerImpl(lexer)->source_->readUntil(
+                getLexerImpl(lexer)->string_stops_, data);
+        }
         const int c = getLexerImpl(lexer)->skipComment(
             getLexerImpl(lexer)->source_->getChar(), escaped);
 
@@ -544,6 +562,10 @@ QString::handle(MasterLexer& lexer) const {
 
     bool escaped = false;
     while (true) {
+        if (!escaped) {
+            getLexerImpl(lexer)->source_->readUntil(
+                getLexerImpl(lexer)->qstring_stops_, data);
+        }
         const int c = getLexerImpl(lexer)->source_->getChar();
         if (c == InputSource::END_OF_STREAM) {
             token = MasterToken(MasterToken::UNEXPECTED_END);
@@ -388,9 +388,14 @@ public:
     /// \param filename A non NULL string specifying a master file
     /// \param error If non null, a placeholder to set error description in
     /// case of failure.
+    /// \param map_file If true, the file is mapped into memory (if
+    /// possible) rather than read through a file stream.  This is faster,
+    /// but the process gets SIGBUS if the file is truncated while it's
+    /// read, so it should only be used for files that don't change.
     ///
     /// \return true if pushing the file succeeds; false otherwise.
-    bool pushSource(const char* filename, std::string* error = NULL);
+    bool pushSource(const char* filename, std::string* error = NULL,
+                    bool map_file = false);
 
     /// \brief Make the given stream the current input source of MasterLexer.
     ///
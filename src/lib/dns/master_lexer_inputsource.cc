@@ -20,6 +20,13 @@
 #include <cassert>
 #include <cerrno>
 #include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace bundy {
 namespace dns {
@@ -94,6 +101,9 @@ InputSource::InputSource(std::istream& input_stream) :
     saved_line_(line_),
     buffer_pos_(0),
     total_pos_(0),
+    mapped_size_(0),
+    mapped_data_(NULL),
+    mapped_begin_(0),
     name_(createStreamName(input_stream)),
     input_(input_stream),
     input_size_(getStreamSize(input_))
@@ -118,21 +128,55 @@ openFileStream(std::ifstream& file_stream, const char* filename) {
 
     return (file_stream);
 }
+
+// Map the file into memory if it's a non-empty regular file.  Returns NULL
+// if it's not mapped for whatever reason; the file is then read through
+// a file stream, which also reports the errors if it cannot be opened.
+const char*
+mapFile(const char* filename, size_t& size) {
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return (NULL);
+    }
+    void* addr = MAP_FAILED;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        static_cast<uint64_t>(st.st_size) <
+        std::numeric_limits<size_t>::max()) {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);                  // the mapping stays valid
+    if (addr == MAP_FAILED) {
+        return (NULL);
+    }
+    // This is only a hint, so errors are ignored.
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    size = st.st_size;
+    return (static_cast<const char*>(addr));
+}
 }
 
-InputSource::InputSource(const char* filename) :
+InputSource::InputSource(const char* filename, bool map_file) :
     at_eof_(false),
     line_(1),
     saved_line_(line_),
     buffer_pos_(0),
     total_pos_(0),
+    mapped_size_(0),
+    mapped_data_(map_file ? mapFile(filename, mapped_size_) : NULL),
+    mapped_begin_(0),
     name_(filename),
-    input_(openFileStream(file_stream_, filename)),
-    input_size_(getStreamSize(input_))
+    input_(mapped_data_ != NULL ? file_stream_ :
+           openFileStream(file_stream_, filename)),
+    input_size_(mapped_data_ != NULL ? mapped_size_ :
+                getStreamSize(input_))
 {}
 
 InputSource::~InputSource()
 {
+    if (mapped_data_ != NULL) {
+        munmap(const_cast<char*>(mapped_data_), mapped_size_);
+    }
     if (file_stream_.is_open()) {
         file_stream_.close();
     }
@@ -140,6 +184,20 @@ InputSource::~InputSource()
 
 int
 InputSource::getChar() {
+    if (mapped_data_ != NULL) {
+        if (total_pos_ == mapped_size_) {
+            at_eof_ = true;
+            return (END_OF_STREAM);
+        }
+        // Converted the same way as the buffered characters below.
+        const int c = mapped_data_[total_pos_];
+        ++total_pos_;
+        if (c == '\n') {
+            ++line_;
+        }
+        return (c);
+    }
+
     if (buffer_pos_ == buffer_.size()) {
         // We may have reached EOF at the last call to
         // getChar(). at_eof_ will be set then. We then simply return
@@ -175,10 +233,68 @@ InputSource::getChar() {
     return (c);
 }
 
+int
+InputSource::skipLine() {
+    if (mapped_data_ == NULL) {
+        while (true) {
+            const int c = getChar();
+            if (c == '\n' || c == END_OF_STREAM) {
+                return (c);
+            }
+        }
+    }
+
+    const void* nl = std::memchr(mapped_data_ + total_pos_, '\n',
+                                 mapped_size_ - total_pos_);
+    if (nl == NULL) {
+        total_pos_ = mapped_size_;
+        at_eof_ = true;
+        return (END_OF_STREAM);
+    }
+    total_pos_ = static_cast<const char*>(nl) - mapped_data_ + 1;
+    ++line_;
+    return ('\n');
+}
+
+void
+InputSource::readUntil(const StopChars& stop_chars, std::vector<char>& data) {
+    assert(stop_chars.test('\n'));
+
+    if (mapped_data_ == NULL) {
+        while (true) {
+            const int c = getChar();
+            if (c == END_OF_STREAM ||
+                stop_chars.test(static_cast<unsigned char>(c))) {
+                ungetChar();
+                return;
+            }
+            data.push_back(c);
+        }
+    }
+
+    // As '\n' is a stop character, the line doesn't change.
+    size_t pos = total_pos_;
+    while (pos < mapped_size_ &&
+           !stop_chars.test(static_cast<unsigned char>(mapped_data_[pos]))) {
+        ++pos;
+    }
+    data.insert(data.end(), mapped_data_ + total_pos_, mapped_data_ + pos);
+    total_pos_ = pos;
+}
+
 void
 InputSource::ungetChar() {
     if (at_eof_) {
         at_eof_ = false;
+    } else if (mapped_data_ != NULL) {
+        if (total_pos_ == mapped_begin_) {
+            bundy_throw(UngetBeforeBeginning,
+                      "Cannot skip before the start of buffer");
+        }
+        --total_pos_;
+        if (mapped_data_[total_pos_] == '\n') {
+            --line_;
+        }
     } else if (buffer_pos_ == 0) {
         bundy_throw(UngetBeforeBeginning,
                   "Cannot skip before the start of buffer");
@@ -193,6 +309,12 @@ InputSource::ungetChar() {
 
 void
 InputSource::ungetAll() {
+    if (mapped_data_ != NULL) {
+        total_pos_ = mapped_begin_;
+        line_ = saved_line_;
+        at_eof_ = false;
+        return;
+    }
     assert(total_pos_ >= buffer_pos_);
     total_pos_ -= buffer_pos_;
     buffer_pos_ = 0;
@@ -207,6 +329,10 @@ InputSource::saveLine() {
 
 void
 InputSource::compact() {
+    if (mapped_data_ != NULL) {
+        mapped_begin_ = total_pos_;
+        return;
+    }
     if (buffer_pos_ == buffer_.size()) {
         buffer_.clear();
     } else {
@@ -19,6 +19,7 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <bitset>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -36,6 +37,12 @@ namespace master_lexer_internal {
 /// can have multiple InputSources if $INCLUDE is used. The source can
 /// also be generic input stream (std::istream).
 ///
+/// A regular file can be mapped into memory on request, and is then read
+/// directly from the mapped memory rather than through a file stream.
+/// This is transparent to the user of this class, except that the file
+/// must not be truncated while it's being read (accessing the lost part
+/// of the mapping raises SIGBUS).
+///
 /// This class is not meant for public use. We also enforce that
 /// instances are non-copyable.
 class InputSource : boost::noncopyable {
@@ -71,11 +78,16 @@ public:
     explicit InputSource(std::istream& input_stream);
 
     /// \brief Constructor which takes a filename to read from. The
-    /// associated file stream is managed internally.
+    /// associated file stream (or the mapped memory) is managed internally.
     ///
     /// \throws OpenError when opening the input file fails or the size of
     /// the file cannot be detected.
-    explicit InputSource(const char* filename);
+    ///
+    /// \param filename The file to read.
+    /// \param map_file If true, map the file into memory if it's a
+    /// non-empty regular file.  The file must then not be truncated
+    /// while it's read.
+    explicit InputSource(const char* filename, bool map_file = false);
 
     /// \brief Destructor
     ~InputSource();
@@ -152,6 +164,39 @@ public:
     /// file fails.
     int getChar();
 
+    /// \brief Skips to the end of the current line.
+    ///
+    /// This is the same as calling \c getChar() until it returns a
+    /// newline character or \c END_OF_STREAM, but it's faster for a
+    /// mapped file.
+    ///
+    /// \throws MasterLexer::ReadError when reading from the input stream or
+    /// file fails.
+    ///
+    /// \return '\n' or \c END_OF_STREAM, whichever is found first.
+    int skipLine();
+
+    /// \brief Characters that \c readUntil() stops at.
+    ///
+    /// A set bit means the character of the index stops the reading.
+    /// '\n' must always be in the set.
+    typedef std::bitset<256> StopChars;
+
+    /// \brief Reads characters up to one of the given characters.
+    ///
+    /// Characters are read and appended to \c data until one in
+    /// \c stop_chars (or the end of the stream) is found.  That character
+    /// is not read; the next \c getChar() returns it.  This is the same
+    /// as a loop of \c getChar() and \c ungetChar(), but it's faster for a
+    /// mapped file.
+    ///
+    /// \throws MasterLexer::ReadError when reading from the input stream or
+    /// file fails.
+    ///
+    /// \param stop_chars The characters to stop at.
+    /// \param data The characters read are appended to this.
+    void readUntil(const StopChars& stop_chars, std::vector<char>& data);
+
     /// \brief Skips backward a single character in the input
     /// source. The last-read character is unget.
     ///
@@ -176,6 +221,12 @@ private:
     size_t buffer_pos_;
     size_t total_pos_;
 
+    // The file contents if it's mapped (NULL otherwise).  The characters
+    // between mapped_begin_ and total_pos_ correspond to buffer_.
+    size_t mapped_size_;
+    const char* const mapped_data_;
+    size_t mapped_begin_;
+
     const std::string name_;
     std::ifstream file_stream_;
     std::istream& input_;
@@ -14,18 +14,27 @@
 
 #include <dns/master_loader.h>
 #include <dns/master_lexer.h>
+#include <dns/master_lexer_inputsource.h>
 #include <dns/name.h>
 #include <dns/rdataclass.h>
 #include <dns/rrttl.h>
 #include <dns/rrclass.h>
+#include <dns/rrparamregistry.h>
 #include <dns/rrtype.h>
 #include <dns/rdata.h>
 
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/algorithm/string/predicate.hpp> // for iequals
+#include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <deque>
+#include <sstream>
 #include <string>
 #include <memory>
 #include <vector>
@@ -38,6 +47,10 @@ using std::vector;
 using std::pair;
 using boost::algorithm::iequals;
 using boost::shared_ptr;
+using bundy::dns::master_lexer_internal::InputSource;
+using bundy::util::thread::CondVar;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
 
 namespace bundy {
 namespace dns {
@@ -54,6 +67,142 @@ public:
     {}
 };
 
+// The parallel load (see MasterLoader::setThreadCount()) splits the input
+// into chunks of (at least) this size.
+const size_t CHUNK_SIZE = 64 * 1024;
+
+// The number of chunks read ahead for each worker thread.
+const size_t CHUNKS_PER_THREAD = 4;
+
+// An RR or a message, produced by a worker thread while parsing a chunk
+// in the parallel load, to be reported in the order of the input.
+struct ParsedItem {
+    enum Type {
+        RR,
+        WARNING,
+        ERROR
+    };
+
+    ParsedItem(Type type_param, const string& source_param, size_t line_param,
+               const string& reason_param) :
+        type(type_param), source(source_param), line(line_param),
+        reason(reason_param), name(Name::ROOT_NAME()), rrtype(0),
+        explicit_ttl(0), has_explicit_ttl(false), default_ttl(0),
+        has_default_ttl(false)
+    {}
+
+    Type type;
+    string source;          // empty for the top-level source
+    size_t line;
+    string reason;          // for WARNING and ERROR
+
+    // The rest is for RR.  The TTL isn't determined in the worker threads
+    // as it can depend on the previous chunks; the explicit TTL (if any)
+    // and the default TTL set by a $TTL earlier in the chunk (if any) are
+    // given instead.
+    Name name;
+    RRType rrtype;
+    RRTTL explicit_ttl;
+    bool has_explicit_ttl;
+    RRTTL default_ttl;
+    bool has_default_ttl;
+    rdata::RdataPtr rdata;
+};
+
+// Remove the quotes around a quoted string, if any.
+void
+unquote(string& str) {
+    if (str.size() >= 2 && str[0] == '"' && str[str.size() - 1] == '"') {
+        str = str.substr(1, str.size() - 2);
+    }
+}
+
+// A chunk of the input in the parallel load, and the result of parsing it.
+// The chunk starts at the first line of a record with an explicit owner
+// name, and the origin at that point is known when the input is split, so
+// it can be parsed independently of other chunks.  The default TTL isn't
+// known then, as a $TTL in an $INCLUDE'd file stays in effect after the
+// $INCLUDE; it's carried over from the previous chunks when the RRs are
+// reported.
+struct Chunk : boost::noncopyable {
+    Chunk(const Name& origin_param, size_t first_line_param) :
+        origin(origin_param), first_line(first_line_param), done(false),
+        seen_error(false)
+    {}
+
+    // Record a message from the parser.  The messages about the chunk
+    // itself are converted to the top-level source and its lines (the
+    // parser sees the chunk as a separate stream).
+    void addMessage(ParsedItem::Type type, const string& msg_source,
+                    size_t line, const string& reason)
+    {
+        if (msg_source == stream_name) {
+            items.push_back(ParsedItem(type, "", first_line + line - 1,
+                                       reason));
+        } else {
+            items.push_back(ParsedItem(type, msg_source, line, reason));
+        }
+    }
+
+    void addRR(const Name& name, const RRType& rrtype,
+               const RRTTL* explicit_ttl, const RRTTL* current_default_ttl,
+               const rdata::RdataPtr& rdata, const string& rr_source,
+               size_t line)
+    {
+        addMessage(ParsedItem::RR, rr_source, line, "");
+        ParsedItem& item = items.back();
+        item.name = name;
+        item.rrtype = rrtype;
+        if (explicit_ttl) {
+            item.explicit_ttl = *explicit_ttl;
+            item.has_explicit_ttl = true;
+        }
+        if (current_default_ttl) {
+            item.default_ttl = *current_default_ttl;
+            item.has_default_ttl = true;
+        }
+        item.rdata = rdata;
+    }
+
+    string text;
+    const Name origin;
+    const size_t first_line;
+    string stream_name;         // name of the stream the parser reads
+    bool done;                  // parsed (protected by the mutex)
+    bool seen_error;
+    string fatal_error;         // set if parsing stopped at a fatal error
+    string unexpected_error;    // set if parsing failed unexpectedly
+    vector<ParsedItem> items;
+    boost::scoped_ptr<RRTTL> end_default_ttl; // the default TTL at the end
+                                              // if set in the chunk
+};
+
+typedef shared_ptr<Chunk> ChunkPtr;
+
+// The state of the parallel load.
+struct ParallelState : boost::noncopyable {
+    ParallelState(const Name& origin_param) :
+        origin(origin_param), eof(false), item_pos(0), position(0),
+        stop(false)
+    {}
+
+    // Used in the thread calling the loader only.
+    boost::scoped_ptr<InputSource> source;
+    Name origin;                // $ORIGIN at the end of the last chunk
+    bool eof;
+    std::deque<ChunkPtr> chunks; // chunks being processed, in input order
+    size_t item_pos;            // next item to report in chunks.front()
+    size_t position;            // size of the chunks completely reported
+    vector<shared_ptr<Thread> > threads;
+
+    // Shared with the worker threads.
+    Mutex mutex;
+    CondVar job_cond;           // signaled when a chunk is queued or on stop
+    CondVar done_cond;          // signaled when a chunk is parsed
+    std::deque<ChunkPtr> jobs;  // chunks waiting for a worker
+    bool stop;
+};
+
 } // end unnamed namespace
 
 /// \brief Private implementation class for the \c MasterLoader
@@ -101,13 +250,25 @@ public:
         initialized_(false),
         ok_(true),
         many_errors_((options & MANY_ERRORS) != 0),
+        map_files_((options & MAP_FILES) != 0),
         previous_name_(false),
         complete_(false),
         seen_error_(false),
         warn_rfc1035_ttl_(true),
-        rr_count_(0)
+        rr_count_(0),
+        input_stream_(NULL),
+        n_threads_(1),
+        started_(false),
+        chunk_(NULL)
     {}
 
+    /// \brief Destructor.
+    ///
+    /// Stops the worker threads of the parallel load if they are running.
+    ~MasterLoaderImpl() {
+        stopThreads();
+    }
+
     /// \brief Wrapper around \c MasterLexer::pushSource() (file version)
     ///
     /// This method is used as a wrapper around the lexer's
@@ -120,7 +281,7 @@ public:
     /// \param current_origin The current origin name to save.
     void pushSource(const std::string& filename, const Name& current_origin) {
         std::string error;
-        if (!lexer_.pushSource(filename.c_str(), &error)) {
+        if (!lexer_.pushSource(filename.c_str(), &error, map_files_)) {
             if (initialized_) {
                 bundy_throw(InternalException, error.c_str());
             } else {
@@ -143,9 +304,22 @@ public:
     /// \param stream The input stream to use as a new source.
     void pushStreamSource(std::istream& stream) {
         lexer_.pushSource(stream);
+        input_stream_ = &stream;
         initialized_ = true;
     }
 
+    /// \brief Implementation of \c MasterLoader::setThreadCount()
+    void setThreadCount(size_t n_threads) {
+        if (n_threads == 0) {
+            bundy_throw(bundy::InvalidParameter, "Thread count set to 0");
+        }
+        if (started_) {
+            bundy_throw(bundy::InvalidOperation,
+                        "Trying to set the thread count after loading");
+        }
+        n_threads_ = n_threads;
+    }
+
     /// \brief Implementation of \c MasterLoader::loadIncremental()
     ///
     /// See \c MasterLoader::loadIncremental() for details.
@@ -153,11 +327,25 @@ public:
 
     /// \brief Return the total size of the input sources pushed so
     /// far. See \c MasterLexer::getTotalSourceSize().
-    size_t getSize() const { return (lexer_.getTotalSourceSize()); }
+    ///
+    /// In the parallel load, files included by $INCLUDE aren't counted.
+    size_t getSize() const {
+        if (parallel_ && parallel_->source) {
+            return (parallel_->source->getSize());
+        }
+        return (lexer_.getTotalSourceSize());
+    }
 
     /// \brief Return the line number being parsed in the pushed input
     /// sources. See \c MasterLexer::getPosition().
-    size_t getPosition() const { return (lexer_.getPosition()); }
+    ///
+    /// In the parallel load, it's the size of the chunks reported so far.
+    size_t getPosition() const {
+        if (parallel_) {
+            return (parallel_->position);
+        }
+        return (lexer_.getPosition());
+    }
 
 private:
     /// \brief Report an error using the callbacks that were supplied
@@ -361,10 +549,17 @@ private:
     /// next line. It's just for calculating the accurate source line
     /// when callback is necessary.
     void limitTTL(RRTTL& ttl, bool post_parsing) {
+        limitTTL(ttl, lexer_.getSourceName(),
+                 lexer_.getSourceLine() - (post_parsing ? 1 : 0));
+    }
+
+    /// \brief Check and limit TTL to maximum value.
+    ///
+    /// Same as the other version, but the source name and line for the
+    /// warning are given explicitly.
+    void limitTTL(RRTTL& ttl, const string& source, size_t line) {
         if (ttl > RRTTL::MAX_TTL()) {
-            const size_t src_line = lexer_.getSourceLine() -
-                (post_parsing ? 1 : 0);
-            callbacks_.warning(lexer_.getSourceName(), src_line,
+            callbacks_.warning(source, line,
                                "TTL " + ttl.toText() + " > MAXTTL, "
                                "setting to 0 per RFC2181");
             ttl = RRTTL(0);
@@ -419,35 +614,101 @@ private:
         // we need to adjust the line number.
         const size_t current_line = lexer_.getSourceLine() - 1;
 
+        const RRTTL* ttl = resolveTTL(explicit_ttl, rrtype, rdata,
+                                      lexer_.getSourceName(), current_line);
+        if (ttl == NULL) {
+            // On catching the exception we'll try to reach EOL again,
+            // so we need to unget it now.
+            lexer_.ungetToken();
+            throw InternalException(__FILE__, __LINE__,
+                                    "no TTL specified; load rejected");
+        }
+        return (*ttl);
+    }
+
+    /// \brief Determine the TTL of the current RR.
+    ///
+    /// The body of \c getCurrentTTL(), also used for the RRs parsed by
+    /// the worker threads of the parallel load, which are given the
+    /// source name and line of the RR explicitly.  It returns NULL if
+    /// no TTL is known for the RR.
+    const RRTTL* resolveTTL(bool explicit_ttl, const RRType& rrtype,
+                            const rdata::ConstRdataPtr& rdata,
+                            const string& source, size_t line)
+    {
         if (!current_ttl_ && !default_ttl_) {
             if (rrtype == RRType::SOA()) {
-                callbacks_.warning(lexer_.getSourceName(), current_line,
+                callbacks_.warning(source, line,
                                    "no TTL specified; "
                                    "using SOA MINTTL instead");
                 const uint32_t ttl_val =
                     dynamic_cast<const rdata::generic::SOA&>(*rdata).
                     getMinimum();
-                setDefaultTTL(RRTTL(ttl_val), true);
+                assignTTL(default_ttl_, RRTTL(ttl_val));
+                limitTTL(*default_ttl_, source, line);
                 assignTTL(current_ttl_, *default_ttl_);
             } else {
-                // On catching the exception we'll try to reach EOL again,
-                // so we need to unget it now.
-                lexer_.ungetToken();
-                throw InternalException(__FILE__, __LINE__,
-                                        "no TTL specified; load rejected");
+                return (NULL);
             }
         } else if (!explicit_ttl && default_ttl_) {
             assignTTL(current_ttl_, *default_ttl_);
         } else if (!explicit_ttl && warn_rfc1035_ttl_) {
             // Omitted (class and) TTL values are default to the last
             // explicitly stated values (RFC 1035, Sec. 5.1).
-            callbacks_.warning(lexer_.getSourceName(), current_line,
+            callbacks_.warning(source, line,
                                "using RFC1035 TTL semantics; default to the "
                                "last explicitly stated TTL");
             warn_rfc1035_ttl_ = false; // we only warn about this once
         }
         assert(current_ttl_);
-        return (*current_ttl_);
+        return (current_ttl_.get());
+    }
+
+    /// \brief Report a parsed RR.
+    ///
+    /// Usually this passes the RR to the add callback.  In a worker
+    /// thread of the parallel load, the RR is recorded in the chunk
+    /// instead, and its TTL is determined when it's reported in the
+    /// thread calling the loader (see \c reportParsedItem()).
+    void addRR(const RRType& rrtype, bool explicit_ttl,
+               const rdata::RdataPtr& rdata)
+    {
+        if (chunk_ != NULL) {
+            // Nothing before the first chunk can give the TTL, so its
+            // state is complete, and an RR without a TTL is rejected right
+            // here just like getCurrentTTL() (which also aborts a
+            // $GENERATE).  The TTLs of other chunks are only resolved when
+            // the RRs are reported.
+            if (chunk_->first_line == 1 && !current_ttl_ && !default_ttl_) {
+                if (rrtype == RRType::SOA()) {
+                    // The SOA MINTTL will be the default TTL (with a
+                    // warning) when the RR is reported; follow it here.
+                    RRTTL ttl(dynamic_cast<const rdata::generic::SOA&>(
+                                  *rdata).getMinimum());
+                    if (ttl > RRTTL::MAX_TTL()) {
+                        ttl = RRTTL(0);
+                    }
+                    chunk_->addRR(*last_name_, rrtype, NULL, NULL, rdata,
+                                  lexer_.getSourceName(),
+                                  lexer_.getSourceLine() - 1);
+                    assignTTL(default_ttl_, ttl);
+                    assignTTL(current_ttl_, ttl);
+                    return;
+                } else {
+                    lexer_.ungetToken();
+                    throw InternalException(__FILE__, __LINE__,
+                                            "no TTL specified; "
+                                            "load rejected");
+                }
+            }
+            chunk_->addRR(*last_name_, rrtype,
+                          explicit_ttl ? current_ttl_.get() : NULL,
+                          default_ttl_.get(), rdata, lexer_.getSourceName(),
+                          lexer_.getSourceLine() - 1);
+        } else {
+            add_callback_(*last_name_, zone_class_, rrtype,
+                          getCurrentTTL(explicit_ttl, rrtype, rdata), rdata);
+        }
     }
 
     /// \brief Handle a $DIRECTIVE
@@ -472,6 +733,47 @@ private:
         }
     }
 
+    /// \brief Implementation of \c loadIncremental() for the parallel load.
+    ///
+    /// The input is split into chunks in this thread, the chunks are
+    /// parsed by the worker threads, and the resulting RRs and messages
+    /// are reported here in the order of the input.  See the commented
+    /// implementation for details.
+    bool loadParallel(size_t count_limit);
+
+    /// \brief Open the input and start the worker threads of the parallel
+    /// load.
+    void startThreads();
+
+    /// \brief Stop the worker threads of the parallel load (if any) and
+    /// wait for them.
+    void stopThreads();
+
+    /// \brief Read chunks of the input and queue them for the worker
+    /// threads, until enough chunks are queued or the input ends.
+    void queueChunks();
+
+    /// \brief Read the next chunk of the input.
+    ///
+    /// \throw MasterLexer::ReadError reading the input failed.
+    void readChunk(Chunk& chunk);
+
+    /// \brief Track the directives that affect the following chunks.
+    ///
+    /// \param line The text of a directive line (without comments).
+    void trackDirective(const string& line);
+
+    /// \brief The body of the worker threads of the parallel load.
+    void runWorker();
+
+    /// \brief Parse a chunk in a worker thread.
+    void parseChunk(Chunk& chunk);
+
+    /// \brief Report an RR or a message parsed by a worker thread.
+    ///
+    /// \return true if an RR was passed to the add callback.
+    bool reportParsedItem(const ParsedItem& item);
+
     /// \brief Skip tokens until end-of-line.
     void eatUntilEOL(bool reportExtra) {
         // We want to continue. Try to read until the end of line
@@ -536,6 +838,7 @@ private:
     bool ok_;                   // Is it OK to continue loading?
     const bool many_errors_;    // Are many errors allowed (or should we abort
                                 // on the first)
+    const bool map_files_;      // Should the files be mapped into memory
     // Some info about the outer files from which we include.
     // The first one is current origin, the second is the last seen name
     // in that file.
@@ -551,6 +854,14 @@ public:
     bool warn_rfc1035_ttl_;     // should warn if implicit TTL determination
                                 // from the previous RR is used.
     size_t rr_count_;    // number of RRs successfully loaded
+
+private:
+    std::istream* input_stream_; // The input stream if constructed with one
+    size_t n_threads_;          // Number of threads to parse the input
+    bool started_;              // Whether the load has been started
+    Chunk* chunk_;              // The chunk to record the RRs in (only for
+                                // the parser in a worker thread)
+    boost::scoped_ptr<ParallelState> parallel_; // For the parallel load
 };
 
 namespace { // begin unnamed namespace
@@ -849,9 +1160,7 @@ MasterLoader::MasterLoaderImpl::doGenerate() {
         // Rdata. The errors should have been reported by callbacks_
         // already. We need to decide if we want to continue or not.
         if (rdata) {
-            add_callback_(*last_name_, zone_class_, rrtype,
-                          getCurrentTTL(explicit_ttl, rrtype, rdata),
-                          rdata);
+            addRR(rrtype, explicit_ttl, rdata);
             // Good, we added another one
             ++rr_count_;
         } else {
@@ -952,6 +1261,10 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
         bundy_throw(bundy::InvalidOperation,
                   "Trying to load when already loaded");
     }
+    started_ = true;
+    if (n_threads_ > 1) {
+        return (loadParallel(count_limit));
+    }
     if (!initialized_) {
         pushSource(master_file_, active_origin_);
     }
@@ -981,9 +1294,7 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
             // callbacks_ already. We need to decide if we want to continue
             // or not.
             if (rdata) {
-                add_callback_(*last_name_, zone_class_, rrtype,
-                              getCurrentTTL(explicit_ttl, rrtype, rdata),
-                              rdata);
+                addRR(rrtype, explicit_ttl, rdata);
                 // Good, we loaded another one
                 ++count;
                 ++rr_count_;
@@ -1019,6 +1330,354 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
     return (!ok_);
 }
 
+bool
+MasterLoader::MasterLoaderImpl::loadParallel(size_t count_limit) {
+    if (!parallel_) {
+        startThreads();
+    }
+    ParallelState& state = *parallel_;
+    size_t count = 0;
+    while (ok_ && count < count_limit) {
+        // Keep the workers busy.  Splitting the input is much cheaper than
+        // parsing it, so this thread can do it in between.
+        queueChunks();
+        if (state.chunks.empty()) {
+            return (true);      // we are done
+        }
+
+        const ChunkPtr chunk = state.chunks.front();
+        {
+            Mutex::Locker locker(state.mutex);
+            while (!chunk->done) {
+                state.done_cond.wait(state.mutex);
+            }
+        }
+        if (!chunk->unexpected_error.empty()) {
+            bundy_throw(bundy::Unexpected, "Failed to parse master file: " <<
+                        chunk->unexpected_error);
+        }
+
+        // Report the RRs and messages of the chunk, possibly across
+        // several calls because of the count limit.
+        while (state.item_pos < chunk->items.size() && count < count_limit) {
+            if (reportParsedItem(chunk->items[state.item_pos++])) {
+                ++count;
+            }
+        }
+        if (state.item_pos == chunk->items.size()) {
+            state.chunks.pop_front();
+            state.item_pos = 0;
+            state.position += chunk->text.size();
+            if (chunk->end_default_ttl) {
+                // In case it was set after the last RR of the chunk.
+                assignTTL(default_ttl_, *chunk->end_default_ttl);
+            }
+            if (chunk->seen_error) {
+                seen_error_ = true;
+            }
+            if (!chunk->fatal_error.empty()) {
+                // The worker stopped at an error without MANY_ERRORS; it
+                // has already been reported.
+                ok_ = false;
+                complete_ = true;
+                bundy_throw(MasterLoaderError, chunk->fatal_error.c_str());
+            }
+        }
+    }
+    // When there was a fatal error and ok is false, we say we are done.
+    return (!ok_);
+}
+
+void
+MasterLoader::MasterLoaderImpl::startThreads() {
+    parallel_.reset(new ParallelState(active_origin_));
+    try {
+        if (input_stream_ != NULL) {
+            parallel_->source.reset(new InputSource(*input_stream_));
+        } else {
+            parallel_->source.reset(new InputSource(master_file_.c_str(),
+                                                    map_files_));
+        }
+    } catch (const InputSource::OpenError& ex) {
+        // Same as the failure of the top-level file in pushSource().
+        reportError("", 0, ex.what());
+        ok_ = false;
+        return;
+    }
+
+    // The registry is (lazily) created on first use; make sure it's not
+    // done by the workers.
+    RRParamRegistry::getRegistry();
+    for (size_t i = 0; i < n_threads_; ++i) {
+        parallel_->threads.push_back(shared_ptr<Thread>(
+            new Thread(boost::bind(&MasterLoaderImpl::runWorker, this))));
+    }
+}
+
+void
+MasterLoader::MasterLoaderImpl::stopThreads() {
+    if (!parallel_) {
+        return;
+    }
+    {
+        Mutex::Locker locker(parallel_->mutex);
+        parallel_->stop = true;
+        parallel_->job_cond.signal();
+    }
+    for (size_t i = 0; i < parallel_->threads.size(); ++i) {
+        parallel_->threads[i]->wait(); // runWorker() doesn't throw
+    }
+    parallel_->threads.clear();
+}
+
+void
+MasterLoader::MasterLoaderImpl::queueChunks() {
+    ParallelState& state = *parallel_;
+    while (!state.eof &&
+           state.chunks.size() < n_threads_ * CHUNKS_PER_THREAD) {
+        const ChunkPtr chunk(new Chunk(state.origin,
+                                       state.source->getCurrentLine()));
+        ChunkPtr error_chunk;
+        try {
+            readChunk(*chunk);
+        } catch (const MasterLexer::ReadError& ex) {
+            // The error is reported after the part of the input read so
+            // far, and the load ends there.  The chunk for the error is
+            // never given to the workers.
+            error_chunk.reset(new Chunk(state.origin, 0));
+            error_chunk->items.push_back(
+                ParsedItem(ParsedItem::ERROR, "",
+                           state.source->getCurrentLine(), ex.what()));
+            error_chunk->seen_error = true;
+            if (!many_errors_) {
+                error_chunk->fatal_error = ex.what();
+            }
+            error_chunk->done = true;
+            state.eof = true;
+        }
+        if (!chunk->text.empty()) {
+            state.chunks.push_back(chunk);
+            Mutex::Locker locker(state.mutex);
+            state.jobs.push_back(chunk);
+            state.job_cond.signal();
+        }
+        if (error_chunk) {
+            state.chunks.push_back(error_chunk);
+        }
+    }
+}
+
+void
+MasterLoader::MasterLoaderImpl::readChunk(Chunk& chunk) {
+    // We only need to know where records start: a record ends at the end
+    // of a line unless it's within parentheses.  Parentheses don't count
+    // in comments and quoted strings, and a backslash escapes the next
+    // character.  A chunk ends before a record with an explicit owner name
+    // (i.e., a line not starting with a space, a comment or a directive)
+    // once it's large enough, so its first RR doesn't depend on the last
+    // owner name of the previous chunk.  Only $ORIGIN is tracked here, for
+    // the origin of the following chunks.  $GENERATE and $INCLUDE are left
+    // to the workers; they don't change the origin after the line (but an
+    // $INCLUDE'd file can change the default TTL, see Chunk).
+    InputSource& source = *parallel_->source;
+    string& text = chunk.text;
+    string directive;           // text of the current directive line
+    bool line_start = true;     // at the start of a record
+    bool in_directive = false;
+    bool in_comment = false;
+    bool in_quotes = false;
+    bool escaped = false;
+    size_t depth = 0;
+    while (true) {
+        const int c = source.getChar();
+        if (c == InputSource::END_OF_STREAM) {
+            parallel_->eof = true;
+            break;
+        }
+        if (line_start) {
+            line_start = false;
+            in_directive = (c == '$');
+            if (c == '"') {
+                // Directives can be quoted.
+                in_directive = (source.getChar() == '$');
+                source.ungetChar();
+            }
+            if (text.size() >= CHUNK_SIZE && !in_directive && c != ' ' &&
+                c != '\t' && c != '\r' && c != '\n' && c != ';' &&
+                c != '(' && c != ')') {
+                source.ungetChar();
+                break;
+            }
+        }
+        text.push_back(c);
+
+        if (c == '\n') {
+            // An unterminated quoted string ends here (as an error).
+            in_comment = false;
+            in_quotes = false;
+            escaped = false;
+            if (depth == 0) {
+                if (in_directive) {
+                    trackDirective(directive);
+                    directive.clear();
+                    in_directive = false;
+                }
+                line_start = true;
+            } else if (in_directive) {
+                directive.push_back(' ');
+            }
+            continue;
+        }
+        if (in_comment) {
+            continue;
+        }
+        if (escaped) {
+            escaped = false;
+        } else if (c == '\\') {
+            escaped = true;
+        } else if (in_quotes) {
+            in_quotes = (c != '"');
+        } else if (c == '"') {
+            in_quotes = true;
+        } else if (c == ';') {
+            in_comment = true;
+            continue;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')' && depth > 0) {
+            --depth;
+        }
+        if (in_directive) {
+            directive.push_back(c);
+        }
+    }
+    source.compact();
+}
+
+void
+MasterLoader::MasterLoaderImpl::trackDirective(const string& line) {
+    // Errors are simply ignored here; the worker parsing the line reports
+    // them, and the directive doesn't take effect in that case either.
+    std::istringstream iss(line);
+    string directive, param;
+    iss >> directive >> param;
+    unquote(directive);
+    unquote(param);
+    if (param.empty()) {
+        return;
+    }
+    // The lexer doesn't take unescaped parentheses as a part of a string.
+    for (size_t i = 0; i < param.size(); ++i) {
+        if (param[i] == '\\') {
+            ++i;
+        } else if (param[i] == '(' || param[i] == ')') {
+            return;
+        }
+    }
+    ParallelState& state = *parallel_;
+    try {
+        if (iequals(directive, "$ORIGIN")) {
+            state.origin = Name(param.c_str(), param.size(), &state.origin);
+        }
+    } catch (const bundy::Exception&) {
+    }
+}
+
+void
+MasterLoader::MasterLoaderImpl::runWorker() {
+    ParallelState& state = *parallel_;
+    while (true) {
+        ChunkPtr chunk;
+        {
+            Mutex::Locker locker(state.mutex);
+            while (!state.stop && state.jobs.empty()) {
+                state.job_cond.wait(state.mutex);
+            }
+            if (state.stop) {
+                // Pass the wake up on, so all the workers stop.
+                state.job_cond.signal();
+                return;
+            }
+            chunk = state.jobs.front();
+            state.jobs.pop_front();
+        }
+        try {
+            parseChunk(*chunk);
+        } catch (const std::exception& ex) {
+            chunk->unexpected_error = ex.what();
+        }
+        Mutex::Locker locker(state.mutex);
+        chunk->done = true;
+        state.done_cond.signal();
+    }
+}
+
+void
+MasterLoader::MasterLoaderImpl::parseChunk(Chunk& chunk) {
+    std::istringstream input(chunk.text);
+    const MasterLoaderCallbacks callbacks(
+        boost::bind(&Chunk::addMessage, &chunk, ParsedItem::ERROR,
+                    _1, _2, _3),
+        boost::bind(&Chunk::addMessage, &chunk, ParsedItem::WARNING,
+                    _1, _2, _3));
+    // The origin at the start of the chunk is used as the zone origin,
+    // which doesn't matter otherwise.
+    MasterLoaderImpl parser("", chunk.origin, zone_class_, callbacks,
+                            add_callback_, options_);
+    parser.chunk_ = &chunk;
+    parser.pushStreamSource(input);
+    chunk.stream_name = parser.lexer_.getSourceName();
+    try {
+        while (!parser.loadIncremental(1000)) {
+            // Body intentionally left blank
+        }
+    } catch (const MasterLoaderError& ex) {
+        chunk.fatal_error = ex.what();
+    }
+    chunk.seen_error = parser.seen_error_;
+    // The parser starts without a default TTL, so it's only set here if
+    // the chunk (or a file it includes) set it.
+    if (parser.default_ttl_) {
+        chunk.end_default_ttl.reset(new RRTTL(*parser.default_ttl_));
+    }
+}
+
+bool
+MasterLoader::MasterLoaderImpl::reportParsedItem(const ParsedItem& item) {
+    const string& source =
+        item.source.empty() ? parallel_->source->getName() : item.source;
+    switch (item.type) {
+    case ParsedItem::WARNING:
+        callbacks_.warning(source, item.line, item.reason);
+        return (false);
+    case ParsedItem::ERROR:
+        // The worker has already decided whether to continue.
+        seen_error_ = true;
+        callbacks_.error(source, item.line, item.reason);
+        return (false);
+    case ParsedItem::RR:
+        break;
+    }
+
+    // Determine the TTL as the single-threaded load does in the same
+    // state; see getCurrentTTL().
+    if (item.has_explicit_ttl) {
+        assignTTL(current_ttl_, item.explicit_ttl);
+    }
+    if (item.has_default_ttl) {
+        assignTTL(default_ttl_, item.default_ttl);
+    }
+    const RRTTL* ttl = resolveTTL(item.has_explicit_ttl, item.rrtype,
+                                  item.rdata, source, item.line);
+    if (ttl == NULL) {
+        reportError(source, item.line, "no TTL specified; load rejected");
+        return (false);
+    }
+    add_callback_(item.name, zone_class_, item.rrtype, *ttl, item.rdata);
+    ++rr_count_;
+    return (true);
+}
+
 MasterLoader::MasterLoader(const char* master_file,
                            const Name& zone_origin,
                            const RRClass& zone_class,
@@ -1055,6 +1714,11 @@ MasterLoader::~MasterLoader() {
     delete impl_;
 }
 
+void
+MasterLoader::setThreadCount(size_t n_threads) {
+    impl_->setThreadCount(n_threads);
+}
+
 bool
 MasterLoader::loadIncremental(size_t count_limit) {
     const bool result = impl_->loadIncremental(count_limit);
@@ -46,8 +46,11 @@ public:
     /// \brief Options how the parsing should work.
     enum Options {
         DEFAULT = 0,       ///< Nothing special.
-        MANY_ERRORS = 1    ///< Lenient mode (see documentation of MasterLoader
+        MANY_ERRORS = 1,   ///< Lenient mode (see documentation of MasterLoader
                            ///  constructor).
+        MAP_FILES = 2      ///< Map the master files into memory rather than
+                           ///  reading them through streams (see
+                           ///  documentation of MasterLoader constructor).
     };
 
     /// \brief Constructor
@@ -75,7 +78,11 @@ public:
     /// \param options Options for the parsing, which is bitwise-or of
     ///     the Options values or DEFAULT. If the MANY_ERRORS option is
     ///     included, the parser tries to continue past errors. If it
-    ///     is not included, it stops at first encountered error.
+    ///     is not included, it stops at first encountered error.  If the
+    ///     MAP_FILES option is included, the master file and included
+    ///     files are mapped into memory, which is faster; but the process
+    ///     gets SIGBUS if one of them is truncated during the load, so
+    ///     it's only safe for files that are never modified in place.
     /// \throw std::bad_alloc when there's not enough memory.
     /// \throw bundy::InvalidParameter if add_callback is empty.
     MasterLoader(const char* master_file,
@@ -102,6 +109,32 @@ public:
     /// \brief Destructor
     ~MasterLoader();
 
+    /// \brief Parse the input with multiple threads.
+    ///
+    /// By default the whole input is tokenized and parsed in the thread
+    /// that calls \c load() or \c loadIncremental().  If this method is
+    /// called with a number larger than 1 (before starting the load), the
+    /// input is instead split into chunks at record boundaries, which are
+    /// tokenized and parsed into RRs by that many worker threads.  The
+    /// calling thread only splits the input and reports the RRs and
+    /// errors to the callbacks, in the same order and with the same
+    /// source names and line numbers as without the threads; the
+    /// callbacks are never called from the worker threads.
+    ///
+    /// The result is the same as the single-threaded load for any valid
+    /// input.  For some broken input (e.g. unbalanced parentheses) the
+    /// reported errors can differ, as the input is split before it's
+    /// parsed.  An $INCLUDE'd file is parsed entirely by the worker
+    /// thread that handles the $INCLUDE directive.
+    ///
+    /// The worker threads are stopped when the loader is destroyed.
+    ///
+    /// \throw bundy::InvalidParameter n_threads is 0.
+    /// \throw bundy::InvalidOperation the load has already started.
+    ///
+    /// \param n_threads The number of threads to parse the input.
+    void setThreadCount(size_t n_threads);
+
     /// \brief Load some RRs
     ///
     /// This method loads at most count_limit RRs and reports them. In case
@@ -22,6 +22,7 @@
 #include <boost/array.hpp>
 #include <boost/static_assert.hpp>
 
+#include <algorithm>
 #include <limits>
 #include <cassert>
 #include <vector>
@@ -39,17 +40,20 @@ namespace {     // hide internal-only names from the public namespaces
 /// rendered in the internal buffer for the \c MessageRendererImpl object.
 ///
 /// A \c MessageRendererImpl object maintains a set of \c OffsetItem
-/// objects in a hash table, and searches the table for the position of the
-/// longest match (ancestor) name against each new name to be rendered into
-/// the buffer.
+/// objects in an open addressing hash table, and searches the table for the
+/// position of the longest match (ancestor) name against each new name to be
+/// rendered into the buffer.
+///
+/// The structure is kept small (12 bytes) so that probing the table touches
+/// as few cache lines as possible.
 struct OffsetItem {
-    OffsetItem(size_t hash, size_t pos, size_t len) :
-        hash_(hash), pos_(pos), len_(len)
+    OffsetItem() : hash_(0), pos_(0), len_(0), generation_(0)
     {}
 
-    /// The hash value for the stored name calculated by LabelSequence.getHash.
-    /// This will help make name comparison in \c NameCompare more efficient.
-    size_t hash_;
+    /// The (lower 32 bits of the) hash value for the stored name calculated
+    /// by LabelSequence.getHash.  This, together with \c len_, will help
+    /// make name comparison in \c NameCompare more efficient.
+    uint32_t hash_;
 
     /// The position (offset from the beginning) in the buffer where the
     /// name starts.
@@ -57,6 +61,11 @@ struct OffsetItem {
 
     /// The length of the corresponding sequence (which is a domain name).
     uint16_t len_;
+
+    /// The generation of the table in which this item was stored.  The item
+    /// is valid only if it's equal to the current generation of the table,
+    /// which allows clearing the whole table by incrementing the generation.
+    uint32_t generation_;
 };
 
 /// \brief The \c NameCompare class is a functor that checks equality
@@ -76,7 +85,7 @@ struct NameCompare {
     /// name to be newly rendered (and only that data).
     /// \param hash The hash value for the name.
     NameCompare(const OutputBuffer& buffer, InputBuffer& name_buf,
-                size_t hash) :
+                uint32_t hash) :
         buffer_(&buffer), name_buf_(&name_buf), hash_(hash)
     {}
 
@@ -144,7 +153,7 @@ private:
 
     const OutputBuffer* buffer_;
     InputBuffer* name_buf_;
-    const size_t hash_;
+    const uint32_t hash_;
 };
 }
 
@@ -158,57 +167,119 @@ private:
 /// It internally holds a hash table for OffsetItem objects corresponding
 /// to portions of names rendered in this renderer.  The offset information
 /// is used to compress subsequent names to be rendered.
+///
+/// The table is a flat array of items using open addressing with linear
+/// probing, so a lookup usually only touches a single cache line and adding
+/// an item doesn't allocate memory.  The number of slots is a power of 2
+/// and the table is doubled when it becomes half full.  Since every item
+/// corresponds to a distinct position of the buffer that can be pointed to
+/// by a compression pointer, the number of items is bounded by
+/// Name::MAX_COMPRESS_POINTER + 1.
 struct MessageRenderer::MessageRendererImpl {
-    // The size of hash buckets and number of hash entries per bucket for
-    // which space is preallocated and kept reserved for subsequent rendering
-    // to provide better performance.  These values are derived from the
-    // BIND 9 implementation that uses a similar hash table.
-    static const size_t BUCKETS = 64;
-    static const size_t RESERVED_ITEMS = 16;
+    // The initial number of table slots, and the maximum number of slots
+    // kept reserved (without being shrunk) on clear() for subsequent
+    // rendering.  The former is large enough for a typical UDP response;
+    // the latter is for large responses such as a chunk of AXFR.
+    static const size_t INITIAL_SLOTS = 256;
+    static const size_t MAX_RESERVED_SLOTS = 4096;
     static const uint16_t NO_OFFSET = 65535; // used as a marker of 'not found'
 
     /// \brief Constructor
     MessageRendererImpl() :
-        msglength_limit_(512), truncated_(false),
+        table_(INITIAL_SLOTS), mask_(INITIAL_SLOTS - 1), item_count_(0),
+        generation_(1), msglength_limit_(512), truncated_(false),
         compress_mode_(MessageRenderer::CASE_INSENSITIVE)
-    {
-        // Reserve some spaces for hash table items.
-        for (size_t i = 0; i < BUCKETS; ++i) {
-            table_[i].reserve(RESERVED_ITEMS);
-        }
-    }
+    {}
 
     uint16_t findOffset(const OutputBuffer& buffer, InputBuffer& name_buf,
                         size_t hash, bool case_sensitive) const
     {
-        // Find a matching entry, if any.  We use some heuristics here: often
-        // the same name appears consecutively (like repeating the same owner
-        // name for a single RRset), so in case there's a collision in the
-        // bucket it will be more likely to find it in the tail side of the
-        // bucket.
-        const size_t bucket_id = hash % BUCKETS;
-        vector<OffsetItem>::const_reverse_iterator found;
         if (case_sensitive) {
-            found = find_if(table_[bucket_id].rbegin(),
-                            table_[bucket_id].rend(),
-                            NameCompare<true>(buffer, name_buf, hash));
+            return (findOffset(NameCompare<true>(buffer, name_buf, hash),
+                               hash));
         } else {
-            found = find_if(table_[bucket_id].rbegin(),
-                            table_[bucket_id].rend(),
-                            NameCompare<false>(buffer, name_buf, hash));
+            return (findOffset(NameCompare<false>(buffer, name_buf, hash),
+                               hash));
         }
-        if (found != table_[bucket_id].rend()) {
-            return (found->pos_);
+    }
+
+    template <typename Compare>
+    uint16_t findOffset(const Compare& compare, size_t hash) const {
+        // Probe the slots from the home position of the hash until we hit
+        // an empty (i.e., of an old generation) one.  The table is never
+        // more than half full, so this loop always terminates.
+        for (size_t i = hash & mask_; ; i = (i + 1) & mask_) {
+            const OffsetItem& item = table_[i];
+            if (item.generation_ != generation_) {
+                return (NO_OFFSET);
+            }
+            if (compare(item)) {
+                return (item.pos_);
+            }
         }
-        return (NO_OFFSET);
     }
 
     void addOffset(size_t hash, size_t offset, size_t len) {
-        table_[hash % BUCKETS].push_back(OffsetItem(hash, offset, len));
+        if ((item_count_ + 1) * 2 > table_.size()) {
+            grow();
+        }
+        insert(hash, offset, len);
+        ++item_count_;
+    }
+
+    void insert(size_t hash, size_t offset, size_t len) {
+        size_t i = hash & mask_;
+        while (table_[i].generation_ == generation_) {
+            i = (i + 1) & mask_;
+        }
+        OffsetItem& item = table_[i];
+        item.hash_ = hash;
+        item.pos_ = offset;
+        item.len_ = len;
+        item.generation_ = generation_;
+    }
+
+    // Double the number of slots and re-insert the current items.  Note
+    // that only the lower 32 bits of the hash values are kept, so those
+    // bits are also used to identify the home slots.
+    void grow() {
+        vector<OffsetItem> old_table(table_.size() * 2);
+        old_table.swap(table_);
+        mask_ = table_.size() - 1;
+        for (vector<OffsetItem>::const_iterator it = old_table.begin();
+             it != old_table.end();
+             ++it) {
+            if (it->generation_ == generation_) {
+                insert(it->hash_, it->pos_, it->len_);
+            }
+        }
+    }
+
+    // Invalidate all items, normally by simply incrementing the generation.
+    void reset() {
+        item_count_ = 0;
+        if (table_.size() > MAX_RESERVED_SLOTS) {
+            // Trim excessive capacity: the new slots are all empty.
+            vector<OffsetItem>(INITIAL_SLOTS).swap(table_);
+            mask_ = INITIAL_SLOTS - 1;
+        }
+        if (++generation_ == 0) {
+            // The generation wrapped around; some items could look valid
+            // again, so actually clear all of them.
+            fill(table_.begin(), table_.end(), OffsetItem());
+            generation_ = 1;
+        }
     }
 
     // The hash table for the (offset + position in the buffer) entries
-    vector<OffsetItem> table_[BUCKETS];
+    vector<OffsetItem> table_;
+    // The number of slots - 1, used as a mask to get the home slot
+    size_t mask_;
+    // The number of valid items in the table
+    size_t item_count_;
+    // The current generation of the table; 0 is never used so that
+    // the items of a newly allocated table are all empty.
+    uint32_t generation_;
     /// The maximum length of rendered data that can fit without
     /// truncation.
     uint16_t msglength_limit_;
@@ -240,18 +311,9 @@ MessageRenderer::clear() {
     impl_->truncated_ = false;
     impl_->compress_mode_ = CASE_INSENSITIVE;
 
-    // Clear the hash table.  We reserve the minimum space for possible
-    // subsequent use of the renderer.
-    for (size_t i = 0; i < MessageRendererImpl::BUCKETS; ++i) {
-        if (impl_->table_[i].size() > MessageRendererImpl::RESERVED_ITEMS) {
-            // Trim excessive capacity: swap ensures the new capacity is only
-            // reasonably large for the reserved space.
-            vector<OffsetItem> new_table;
-            new_table.reserve(MessageRendererImpl::RESERVED_ITEMS);
-            new_table.swap(impl_->table_[i]);
-        }
-        impl_->table_[i].clear();
-    }
+    // Clear the hash table.  The space is kept for possible subsequent use
+    // of the renderer unless it's excessively large.
+    impl_->reset();
 }
 
 size_t
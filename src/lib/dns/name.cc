@@ -20,6 +20,12 @@
 #include <iostream>
 #include <algorithm>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <util/buffer.h>
 #include <dns/exceptions.h>
 #include <dns/name.h>
@@ -110,6 +116,63 @@ const uint8_t maptolower[] = {
     0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
     0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
 };
+
+// The vectorized versions convert a block of bytes to lower case as follows:
+// adding (0x80 - 'A') maps 'A'..'Z' to the 26 smallest signed 8-bit values,
+// so a single signed comparison identifies the upper case letters, and 0x20
+// is then or'ed to each of them.  This is equivalent to maptolower[].
+size_t
+findMismatchNoCase(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    size_t pos = 0;
+#ifdef __AVX2__
+    const __m256i bias256 = _mm256_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m256i limit256 = _mm256_set1_epi8(static_cast<char>(0x80 + 26));
+    const __m256i case256 = _mm256_set1_epi8(0x20);
+    for (; pos + 32 <= len; pos += 32) {
+        const __m256i v1 = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(data1 + pos));
+        const __m256i v2 = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(data2 + pos));
+        const __m256i lower1 = _mm256_or_si256(v1, _mm256_and_si256(
+            _mm256_cmpgt_epi8(limit256, _mm256_add_epi8(v1, bias256)),
+            case256));
+        const __m256i lower2 = _mm256_or_si256(v2, _mm256_and_si256(
+            _mm256_cmpgt_epi8(limit256, _mm256_add_epi8(v2, bias256)),
+            case256));
+        const uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(lower1, lower2)));
+        if (mask != 0xffffffff) {
+            return (pos + __builtin_ctz(~mask));
+        }
+    }
+#endif
+#if defined(__SSE2__) || defined(__AVX2__)
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - 'A'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(0x80 + 26));
+    const __m128i casebit = _mm_set1_epi8(0x20);
+    for (; pos + 16 <= len; pos += 16) {
+        const __m128i v1 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data1 + pos));
+        const __m128i v2 =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data2 + pos));
+        const __m128i lower1 = _mm_or_si128(v1, _mm_and_si128(
+            _mm_cmplt_epi8(_mm_add_epi8(v1, bias), limit), casebit));
+        const __m128i lower2 = _mm_or_si128(v2, _mm_and_si128(
+            _mm_cmplt_epi8(_mm_add_epi8(v2, bias), limit), casebit));
+        const unsigned int mask =
+            _mm_movemask_epi8(_mm_cmpeq_epi8(lower1, lower2));
+        if (mask != 0xffff) {
+            return (pos + __builtin_ctz(~mask));
+        }
+    }
+#endif
+    for (; pos < len; ++pos) {
+        if (maptolower[data1[pos]] != maptolower[data2[pos]]) {
+            break;
+        }
+    }
+    return (pos);
+}
 } // end of internal
 } // end of name
 
@@ -528,25 +591,13 @@ Name::equals(const Name& other) const {
         return (false);
     }
 
-    for (unsigned int l = labelcount_, pos = 0; l > 0; --l) {
-        uint8_t count = ndata_[pos];
-        if (count != other.ndata_[pos]) {
-            return (false);
-        }
-        ++pos;
-
-        while (count-- > 0) {
-            uint8_t label1 = ndata_[pos];
-            uint8_t label2 = other.ndata_[pos];
-
-            if (maptolower[label1] != maptolower[label2]) {
-                return (false);
-            }
-            ++pos;
-        }
-    }
-
-    return (true);
+    // Label lengths are never upper case letters, so we can compare the
+    // entire data, including the lengths, ignoring the case.
+    const uint8_t* const data1 =
+        reinterpret_cast<const uint8_t*>(ndata_.data());
+    const uint8_t* const data2 =
+        reinterpret_cast<const uint8_t*>(other.ndata_.data());
+    return (findMismatchNoCase(data1, data2, length_) == length_);
 }
 
 bool
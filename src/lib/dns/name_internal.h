@@ -15,6 +15,9 @@
 #ifndef NAME_INTERNAL_H
 #define NAME_INTERNAL_H 1
 
+#include <stdint.h>
+#include <cstddef>
+
 // This is effectively a "private" namespace for the Name class implementation,
 // but exposed publicly so the definitions in it can be shared with other
 // modules of the library (as of its introduction, used by LabelSequence and
@@ -32,6 +35,33 @@ namespace dns {
 namespace name {
 namespace internal {
 extern const uint8_t maptolower[];
+
+/// \brief Find the first position where two byte sequences differ,
+/// ignoring the case of ASCII letters.
+///
+/// Both \c data1 and \c data2 must be valid for \c len bytes.  Bytes are
+/// considered equal if they are mapped to the same value by \c maptolower.
+/// The comparison is vectorized when the library is built for a CPU with
+/// SSE2 or AVX2; the result is the same as the plain byte-by-byte loop.
+///
+/// \return The position of the first mismatch, or \c len if they match.
+size_t findMismatchNoCase(const uint8_t* data1, const uint8_t* data2,
+                          size_t len);
+
+/// \brief Compare two byte sequences of the same length ignoring the
+/// case of ASCII letters.
+///
+/// \return The difference of the lowercased bytes at the first mismatch
+/// (negative if \c data1 is smaller), or 0 if the sequences match.
+inline int
+compareNoCase(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    const size_t pos = findMismatchNoCase(data1, data2, len);
+    if (pos == len) {
+        return (0);
+    }
+    return (static_cast<int>(maptolower[data1[pos]]) -
+            static_cast<int>(maptolower[data2[pos]]));
+}
 } // end of internal
 } // end of name
 } // end of dns
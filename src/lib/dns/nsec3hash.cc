@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cstdlib>
@@ -63,7 +64,8 @@ public:
                      const uint8_t* salt_data, size_t salt_length) :
         algorithm_(algorithm), iterations_(iterations),
         salt_data_(NULL), salt_length_(salt_length),
-        digest_(SHA1_HASHSIZE), obuf_(Name::MAX_WIRE)
+        lane_size_(Name::MAX_WIRE + salt_length),
+        work_(SHA1_MAX_LANES * lane_size_), obuf_(Name::MAX_WIRE)
     {
         if (algorithm_ != NSEC3_HASH_SHA1) {
             bundy_throw(UnknownNSEC3HashAlgorithm, "Unknown NSEC3 algorithm: " <<
@@ -77,8 +79,6 @@ public:
             }
             std::memcpy(salt_data_, salt_data, salt_length);
         }
-
-        SHA1Reset(&sha1_ctx_);
     }
 
     virtual ~NSEC3HashRFC5155() {
@@ -87,6 +87,8 @@ public:
 
     virtual std::string calculate(const Name& name) const;
     virtual std::string calculate(const LabelSequence& ls) const;
+    virtual void calculateBatch(const LabelSequence* const labels[],
+                                size_t count, std::string hashes[]) const;
 
     virtual bool match(const generic::NSEC3& nsec3) const;
     virtual bool match(const generic::NSEC3PARAM& nsec3param) const;
@@ -94,66 +96,79 @@ public:
                const vector<uint8_t>& salt) const;
 
 private:
-    std::string calculateForWiredata(const uint8_t* data, size_t length) const;
+    // Calculate the hashes of up to SHA1_MAX_LANES names in wire format.
+    void calculateForWiredata(const uint8_t* const data[],
+                              const size_t lengths[], size_t count,
+                              std::string hashes[]) const;
 
     const uint8_t algorithm_;
     const uint16_t iterations_;
     uint8_t* salt_data_;
     const size_t salt_length_;
+    const size_t lane_size_;
 
     // The following members are placeholder of work place and don't hold
     // any state over multiple calls so can be mutable without breaking
-    // constness.
-    mutable SHA1Context sha1_ctx_;
-    mutable vector<uint8_t> digest_;
+    // constness.  work_ has a lane of lane_size_ bytes for each name
+    // hashed together, holding the name or the digest followed by the salt.
+    mutable vector<uint8_t> work_;
     mutable OutputBuffer obuf_;
 };
 
-inline void
-iterateSHA1(SHA1Context* ctx, const uint8_t* input, size_t inlength,
-            const uint8_t* salt, size_t saltlen,
-            uint8_t output[SHA1_HASHSIZE])
-{
-    SHA1Reset(ctx);
-    SHA1Input(ctx, input, inlength);
-    SHA1Input(ctx, salt, saltlen); // this works whether saltlen == or > 0
-    SHA1Result(ctx, output);
-}
-
-string
-NSEC3HashRFC5155::calculateForWiredata(const uint8_t* data,
-                                       size_t length) const
+void
+NSEC3HashRFC5155::calculateForWiredata(const uint8_t* const data[],
+                                       const size_t lengths[], size_t count,
+                                       string hashes[]) const
 {
-    // We first need to normalize the name by converting all upper case
-    // characters in the labels to lower ones.
-
-    uint8_t name_buf[256];
-    assert(length < sizeof (name_buf));
+    assert(count <= SHA1_MAX_LANES);
+    const uint8_t* messages[SHA1_MAX_LANES];
+    uint8_t* digests[SHA1_MAX_LANES];
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        uint8_t* const name_buf = &work_[lane * lane_size_];
+        messages[lane] = name_buf;
+        digests[lane] = name_buf;
+
+        // We first need to normalize the name by converting all upper case
+        // characters in the labels to lower ones.
+        assert(lengths[lane] <= Name::MAX_WIRE);
+
+        const uint8_t *p1 = data[lane];
+        uint8_t *p2 = name_buf;
+        while (*p1 != 0) {
+            char len = *p1;
+
+            *p2++ = *p1++;
+            while (len--) {
+                *p2++ = bundy::dns::name::internal::maptolower[*p1++];
+            }
+        }
 
-    const uint8_t *p1 = data;
-    uint8_t *p2 = name_buf;
-    while (*p1 != 0) {
-        char len = *p1;
+        *p2 = *p1;
 
-        *p2++ = *p1++;
-        while (len--) {
-            *p2++ = bundy::dns::name::internal::maptolower[*p1++];
+        // The first round hashes the name and the salt.  The names have
+        // different lengths so they are hashed one by one; from then on
+        // each lane holds the digest and the salt and all lanes are
+        // hashed together.
+        if (salt_length_ > 0) {
+            std::memcpy(name_buf + lengths[lane], salt_data_, salt_length_);
+        }
+        SHA1MultiResult(&messages[lane], 1, lengths[lane] + salt_length_,
+                        &digests[lane]);
+        if (salt_length_ > 0) {
+            std::memcpy(name_buf + SHA1_HASHSIZE, salt_data_, salt_length_);
         }
     }
 
-    *p2 = *p1;
-
-    uint8_t* const digest = &digest_[0];
-    assert(digest_.size() == SHA1_HASHSIZE);
-
-    iterateSHA1(&sha1_ctx_, name_buf, length,
-                salt_data_, salt_length_, digest);
     for (unsigned int n = 0; n < iterations_; ++n) {
-        iterateSHA1(&sha1_ctx_, digest, SHA1_HASHSIZE,
-                    salt_data_, salt_length_, digest);
+        SHA1MultiResult(messages, count, SHA1_HASHSIZE + salt_length_,
+                        digests);
     }
 
-    return (encodeBase32Hex(digest_));
+    for (size_t lane = 0; lane < count; ++lane) {
+        hashes[lane] = encodeBase32Hex(
+            vector<uint8_t>(digests[lane], digests[lane] + SHA1_HASHSIZE));
+    }
 }
 
 string
@@ -161,18 +176,38 @@ NSEC3HashRFC5155::calculate(const Name& name) const {
     obuf_.clear();
     name.toWire(obuf_);
 
-    return (calculateForWiredata(static_cast<const uint8_t*>(obuf_.getData()),
-                                 obuf_.getLength()));
+    const uint8_t* const data =
+        static_cast<const uint8_t*>(obuf_.getData());
+    const size_t length = obuf_.getLength();
+    string hash;
+    calculateForWiredata(&data, &length, 1, &hash);
+    return (hash);
 }
 
 string
 NSEC3HashRFC5155::calculate(const LabelSequence& ls) const {
-    assert(ls.isAbsolute());
-
-    size_t length;
-    const uint8_t* data = ls.getData(&length);
+    const LabelSequence* const labels = &ls;
+    string hash;
+    calculateBatch(&labels, 1, &hash);
+    return (hash);
+}
 
-    return (calculateForWiredata(data, length));
+void
+NSEC3HashRFC5155::calculateBatch(const LabelSequence* const labels[],
+                                 size_t count, string hashes[]) const
+{
+    const uint8_t* data[SHA1_MAX_LANES];
+    size_t lengths[SHA1_MAX_LANES];
+
+    for (size_t i = 0; i < count; i += SHA1_MAX_LANES) {
+        const size_t lanes =
+            std::min(count - i, static_cast<size_t>(SHA1_MAX_LANES));
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            assert(labels[i + lane]->isAbsolute());
+            data[lane] = labels[i + lane]->getData(&lengths[lane]);
+        }
+        calculateForWiredata(data, lengths, lanes, &hashes[i]);
+    }
 }
 
 bool
@@ -218,6 +253,15 @@ getNSEC3HashCreator() {
 namespace bundy {
 namespace dns {
 
+void
+NSEC3Hash::calculateBatch(const LabelSequence* const labels[], size_t count,
+                          string hashes[]) const
+{
+    for (size_t i = 0; i < count; ++i) {
+        hashes[i] = calculate(*labels[i]);
+    }
+}
+
 NSEC3Hash*
 NSEC3Hash::create(const generic::NSEC3PARAM& param) {
     return (getNSEC3HashCreator()->create(param));
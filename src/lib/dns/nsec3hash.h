@@ -157,6 +157,27 @@ public:
     /// \return Base32hex-encoded string of the hash value.
     virtual std::string calculate(const LabelSequence& ls) const = 0;
 
+    /// \brief Calculate the NSEC3 hashes of several names at once.
+    ///
+    /// This method is equivalent to calling \c calculate() for each of
+    /// the \c count absolute label sequences pointed to by \c labels
+    /// and storing the results in \c hashes in the same order, but
+    /// derived classes can compute the hashes together more efficiently
+    /// than one by one.  An NSEC3 proof for a query typically needs the
+    /// hashes of a few related names, such as the closest encloser, the
+    /// next closer name and the wildcard at the closest encloser.
+    ///
+    /// The default implementation simply calls \c calculate() for each
+    /// name.
+    ///
+    /// \param labels The absolute label sequences for which the hash
+    /// values are to be calculated.
+    /// \param count The number of label sequences.
+    /// \param hashes Base32hex-encoded strings of the hash values are
+    /// stored here; must be able to hold \c count strings.
+    virtual void calculateBatch(const LabelSequence* const labels[],
+                                size_t count, std::string hashes[]) const;
+
     /// \brief Match given NSEC3 parameters with that of the hash.
     ///
     /// This method compares NSEC3 parameters used for hash calculation
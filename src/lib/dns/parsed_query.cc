@@ -0,0 +1,169 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <dns/parsed_query.h>
+#include <dns/opcode.h>
+
+#include <cstring>
+
+namespace bundy {
+namespace dns {
+
+namespace {
+// Length of the fixed part of an RR following the owner name: type, class,
+// TTL and RDLENGTH.
+const size_t RR_FIXED_LEN = 10;
+
+uint16_t
+readUint16(const uint8_t* p) {
+    return ((p[0] << 8) | p[1]);
+}
+
+// Skip a (possibly compressed) owner name of an RR.  Return the position
+// after the name, or 0 if it's broken.
+size_t
+skipName(const uint8_t* data, size_t length, size_t pos) {
+    while (pos < length) {
+        const uint8_t label_len = data[pos];
+        if ((label_len & Name::COMPRESS_POINTER_MARK8) ==
+            Name::COMPRESS_POINTER_MARK8) {
+            return (pos + 2 <= length ? pos + 2 : 0);
+        } else if (label_len > Name::MAX_LABELLEN) {
+            return (0);         // extended label types are not supported
+        }
+        pos += label_len + 1;
+        if (label_len == 0) {
+            return (pos <= length ? pos : 0);
+        }
+    }
+    return (0);
+}
+}
+
+const size_t ParsedQuery::NO_OFFSET;
+const size_t ParsedQuery::HEADER_LENGTH;
+
+ParsedQuery::ParsedQuery() :
+    qid_(0), flags_(0), qtype_(0), qclass_(0), question_len_(0),
+    edns_offset_(NO_OFFSET), udp_size_(0), edns_version_(0),
+    dnssec_ok_(false), tsig_offset_(NO_OFFSET)
+{
+    // Make the query name the root name so getQName() is always safe.
+    qname_buf_[0] = 1;          // the number of labels
+    qname_buf_[1] = 0;          // the offset of the root label
+    qname_buf_[2] = 0;          // the root label
+}
+
+bool
+ParsedQuery::parse(const void* data, size_t length) {
+    const uint8_t* const wire = static_cast<const uint8_t*>(data);
+
+    // Header: accept only queries with a single question and no answer or
+    // authority RRs.
+    if (length < HEADER_LENGTH) {
+        return (false);
+    }
+    qid_ = readUint16(wire);
+    flags_ = readUint16(wire + 2);
+    if ((flags_ & Message::HEADERFLAG_QR) != 0 ||
+        ((flags_ & 0x7800) >> 11) != Opcode::QUERY_CODE ||
+        readUint16(wire + 4) != 1 || readUint16(wire + 6) != 0 ||
+        readUint16(wire + 8) != 0) {
+        return (false);
+    }
+    const uint16_t arcount = readUint16(wire + 10);
+    if (arcount > 2) {
+        return (false);
+    }
+
+    // Question: the name must be uncompressed.  First find the labels,
+    // then copy the name data into the serialized LabelSequence image
+    // (the label count, the offsets and the data, in this order).
+    uint8_t offsets[Name::MAX_LABELS];
+    size_t label_count = 0;
+    size_t name_len = 0;
+    size_t pos = HEADER_LENGTH;
+    while (true) {
+        if (pos >= length) {
+            return (false);
+        }
+        const uint8_t label_len = wire[pos];
+        if (label_len > Name::MAX_LABELLEN ||
+            name_len + label_len + 1 > Name::MAX_WIRE) {
+            return (false);
+        }
+        offsets[label_count++] = name_len;
+        name_len += label_len + 1;
+        pos += label_len + 1;
+        if (label_len == 0) {
+            break;
+        }
+    }
+    if (pos + 4 > length) {
+        return (false);
+    }
+    qname_buf_[0] = label_count;
+    std::memcpy(qname_buf_ + 1, offsets, label_count);
+    std::memcpy(qname_buf_ + 1 + label_count, wire + HEADER_LENGTH,
+                name_len);
+    qtype_ = readUint16(wire + pos);
+    qclass_ = readUint16(wire + pos + 2);
+    pos += 4;
+    question_len_ = pos - HEADER_LENGTH;
+
+    // Additional section: an optional OPT RR, then an optional TSIG RR.
+    edns_offset_ = NO_OFFSET;
+    udp_size_ = 0;
+    edns_version_ = 0;
+    dnssec_ok_ = false;
+    tsig_offset_ = NO_OFFSET;
+    for (size_t i = 0; i < arcount; ++i) {
+        const size_t rr_pos = pos;
+        pos = skipName(wire, length, pos);
+        if (pos == 0 || pos + RR_FIXED_LEN > length) {
+            return (false);
+        }
+        const uint16_t rrtype = readUint16(wire + pos);
+        const uint16_t rrclass = readUint16(wire + pos + 2);
+        const uint8_t* const ttl = wire + pos + 4;
+        const uint16_t rdlen = readUint16(wire + pos + 8);
+        pos += RR_FIXED_LEN + rdlen;
+        if (pos > length) {
+            return (false);
+        }
+
+        if (rrtype == RRType::OPT().getCode() && !hasEDNS() && !hasTSIG() &&
+            pos - rdlen - RR_FIXED_LEN == rr_pos + 1 && wire[rr_pos] == 0) {
+            // The OPT RR must be owned by the root name.  Its class is
+            // the UDP payload size and its TTL contains the extended
+            // RCODE, version and flags (RFC6891).
+            edns_offset_ = rr_pos;
+            udp_size_ = rrclass;
+            edns_version_ = ttl[1];
+            dnssec_ok_ = (ttl[2] & 0x80) != 0;
+        } else if (rrtype == RRType::TSIG().getCode() && i + 1 == arcount &&
+                   rrclass == RRClass::ANY().getCode()) {
+            tsig_offset_ = rr_pos;
+        } else {
+            return (false);
+        }
+    }
+
+    // Trailing garbage is left to the full parser.
+    return (pos == length);
+}
+
+} // namespace dns
+} // namespace bundy
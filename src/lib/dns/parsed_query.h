@@ -0,0 +1,161 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef PARSED_QUERY_H
+#define PARSED_QUERY_H 1
+
+#include <dns/labelsequence.h>
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dns {
+
+/// \brief A lightweight parser of ordinary wire-format queries.
+///
+/// This class is an alternative to \c Message::fromWire() for the common
+/// case of query processing in an authoritative server.  It parses the
+/// header, the question and the additional section of a query without
+/// creating any \c Name, \c Question or \c RRset objects or allocating
+/// any memory, and gives access to the parsed values.  The query name is
+/// available as a \c LabelSequence referring to a copy of the name data
+/// kept in this object.
+///
+/// Only "ordinary" queries are accepted: those with the opcode of QUERY
+/// and the QR bit cleared, with exactly one question with an uncompressed
+/// name, with empty answer and authority sections, and with an additional
+/// section that consists of at most an OPT RR and a TSIG RR (in this
+/// order).  \c parse() returns false for any other message, including
+/// broken ones; the caller is expected to fall back to the full parser
+/// (\c Message) in that case, which handles all valid messages and
+/// produces the appropriate errors for invalid ones.  Note that the
+/// content of the OPT and TSIG RRs are only minimally checked; these
+/// should be validated by \c Message (or \c EDNS, \c TSIGContext) before
+/// the values have any effect that isn't specific to this query.
+///
+/// An object of this class can be reused for parsing any number of
+/// queries, and it's safe to copy it.
+class ParsedQuery {
+public:
+    /// \brief Value of the offsets that indicates the RR doesn't exist.
+    static const size_t NO_OFFSET = 0;
+
+    /// \brief Length of the DNS header; the question begins here.
+    static const size_t HEADER_LENGTH = 12;
+
+    /// \brief Constructor.
+    ///
+    /// The object is initialized as if an empty message failed to parse.
+    ///
+    /// \throw None
+    ParsedQuery();
+
+    /// \brief Parse a wire-format query.
+    ///
+    /// On success, the getter methods return the values from the parsed
+    /// query.  On failure, the values are undefined.
+    ///
+    /// \throw None
+    ///
+    /// \param data The wire-format query.
+    /// \param length The length of \c data.
+    /// \return true if \c data is an ordinary query; false otherwise.
+    bool parse(const void* data, size_t length);
+
+    /// \brief Return the query ID.
+    qid_t getQid() const { return (qid_); }
+
+    /// \brief Return whether the specified header flag is set in the query.
+    bool getHeaderFlag(Message::HeaderFlag flag) const {
+        return ((flags_ & flag) != 0);
+    }
+
+    /// \brief Return the query name.
+    ///
+    /// The returned object refers to data in this object, so it must not
+    /// be used after this object is destroyed or used for parsing another
+    /// query.
+    LabelSequence getQName() const { return (LabelSequence(qname_buf_)); }
+
+    /// \brief Return the query type.
+    RRType getQType() const { return (RRType(qtype_)); }
+
+    /// \brief Return the query class.
+    RRClass getQClass() const { return (RRClass(qclass_)); }
+
+    /// \brief Return the length of the question in the wire format.
+    ///
+    /// The question always begins right after the header, i.e., at
+    /// the offset of \c HEADER_LENGTH.
+    size_t getQuestionLength() const { return (question_len_); }
+
+    /// \brief Return whether the query has an OPT RR (EDNS).
+    bool hasEDNS() const { return (edns_offset_ != NO_OFFSET); }
+
+    /// \brief Return the offset of the OPT RR in the query data, or
+    /// \c NO_OFFSET if the query doesn't have one.
+    size_t getEDNSOffset() const { return (edns_offset_); }
+
+    /// \brief Return the UDP payload size of the query's OPT RR.
+    ///
+    /// It's only meaningful if \c hasEDNS() is true.
+    uint16_t getUDPSize() const { return (udp_size_); }
+
+    /// \brief Return the EDNS version of the query's OPT RR.
+    ///
+    /// It's only meaningful if \c hasEDNS() is true.
+    uint8_t getEDNSVersion() const { return (edns_version_); }
+
+    /// \brief Return whether the DO bit is set in the query's OPT RR.
+    ///
+    /// It's false if the query doesn't have an OPT RR.
+    bool getDNSSECAwareness() const { return (dnssec_ok_); }
+
+    /// \brief Return whether the query has a TSIG RR.
+    bool hasTSIG() const { return (tsig_offset_ != NO_OFFSET); }
+
+    /// \brief Return the offset of the TSIG RR in the query data, or
+    /// \c NO_OFFSET if the query doesn't have one.
+    size_t getTSIGOffset() const { return (tsig_offset_); }
+
+private:
+    qid_t qid_;
+    uint16_t flags_;
+    uint16_t qtype_;
+    uint16_t qclass_;
+    size_t question_len_;
+    size_t edns_offset_;
+    uint16_t udp_size_;
+    uint8_t edns_version_;
+    bool dnssec_ok_;
+    size_t tsig_offset_;
+
+    // The query name in the serialized form of LabelSequence
+    uint8_t qname_buf_[LabelSequence::MAX_SERIALIZED_LENGTH];
+};
+
+} // namespace dns
+} // namespace bundy
+#endif  // PARSED_QUERY_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -24,6 +24,7 @@
 
 #include <boost/functional/hash.hpp>
 
+#include <cctype>
 #include <string>
 #include <vector>
 #include <utility>
@@ -191,6 +192,42 @@ TEST_F(LabelSequenceTest, operatorEqual) {
     EXPECT_TRUE(ls1 == ls5);       // it's always case insensitive
 }
 
+// Comparison of long labels, which are examined in blocks when vectorized.
+// The result must be the same as that of the simple byte-by-byte comparison
+// for a difference at any position and for any pair of characters,
+// including the ones next to the upper and lower case letters.
+TEST_F(LabelSequenceTest, compareLongLabels) {
+    const char chars[] = { '-', '0', '@', 'A', 'M', 'Z', '[', '`', 'a',
+                           'm', 'z', '{', '\x80', '\xc1', '\xda', '\xff' };
+    const size_t nchars = sizeof(chars) / sizeof(chars[0]);
+    const string base(Name::MAX_LABELLEN, 'x');
+
+    for (size_t pos = 0; pos < base.size(); ++pos) {
+        for (size_t i = 0; i < nchars; ++i) {
+            for (size_t j = 0; j < nchars; ++j) {
+                string label1(base), label2(base);
+                label1[pos] = chars[i];
+                label2[pos] = chars[j];
+                const Name name1(label1 + "." + base + ".example");
+                const Name name2(label2 + "." + base + ".example");
+                const LabelSequence ls_1(name1), ls_2(name2);
+
+                const int expected =
+                    tolower(static_cast<unsigned char>(chars[i])) -
+                    tolower(static_cast<unsigned char>(chars[j]));
+                EXPECT_EQ(expected == 0, ls_1.equals(ls_2));
+                EXPECT_EQ(expected == 0, name1.equals(name2));
+                EXPECT_EQ(i == j, ls_1.equals(ls_2, true));
+                const NameComparisonResult result = ls_1.compare(ls_2);
+                EXPECT_EQ(expected, result.getOrder());
+                EXPECT_EQ(expected == 0 ? NameComparisonResult::EQUAL :
+                          NameComparisonResult::COMMONANCESTOR,
+                          result.getRelation());
+            }
+        }
+    }
+}
+
 // Compare tests
 TEST_F(LabelSequenceTest, compare) {
     // "example.org." and "example.org.", case sensitive
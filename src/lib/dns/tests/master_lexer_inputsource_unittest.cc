@@ -21,6 +21,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <string.h>
 
@@ -141,6 +142,86 @@ TEST_F(InputSourceTest, file) {
     checkGetAndUngetChar(source, str.c_str(), str.size());
 }
 
+// skipLine() and readUntil() should behave like the loops of getChar() and
+// ungetChar() they replace.  The input is the content of masterload.txt.
+void
+checkSkipAndRead(InputSource& source) {
+    InputSource::StopChars stop_chars;
+    stop_chars.set('\n');
+    stop_chars.set(' ');
+    vector<char> data;
+
+    source.readUntil(stop_chars, data);
+    EXPECT_EQ(";;", string(data.begin(), data.end()));
+    EXPECT_EQ(2, source.getPosition());
+    EXPECT_EQ(' ', source.getChar());
+    EXPECT_EQ('\n', source.skipLine());
+    EXPECT_EQ(2, source.getCurrentLine());
+    EXPECT_EQ(35, source.getPosition());
+
+    // The second line is empty.
+    source.mark();
+    EXPECT_EQ('\n', source.skipLine());
+    data.clear();
+    source.readUntil(stop_chars, data);
+    EXPECT_EQ("example.com.", string(data.begin(), data.end()));
+    EXPECT_EQ(3, source.getCurrentLine());
+
+    // They can be ungotten like other characters.
+    source.ungetAll();
+    EXPECT_EQ(2, source.getCurrentLine());
+    EXPECT_EQ(35, source.getPosition());
+    EXPECT_EQ('\n', source.getChar());
+
+    while (source.skipLine() != InputSource::END_OF_STREAM) {
+    }
+    EXPECT_TRUE(source.atEOF());
+    EXPECT_EQ(source.getSize(), source.getPosition());
+    data.clear();
+    source.readUntil(stop_chars, data);
+    EXPECT_TRUE(data.empty());
+    EXPECT_EQ(InputSource::END_OF_STREAM, source.getChar());
+}
+
+TEST_F(InputSourceTest, skipAndRead) {
+    std::ifstream fs(TEST_DATA_SRCDIR "/masterload.txt");
+    stringstream ss;
+    ss << fs.rdbuf();
+    fs.close();
+
+    InputSource stream_source(ss);
+    checkSkipAndRead(stream_source);
+
+    InputSource file_source(TEST_DATA_SRCDIR "/masterload.txt");
+    checkSkipAndRead(file_source);
+
+    InputSource mapped_source(TEST_DATA_SRCDIR "/masterload.txt", true);
+    checkSkipAndRead(mapped_source);
+}
+
+// Mapped files are read from the mapped memory, but compact() and
+// ungetAll() work the same way as for streams.
+TEST_F(InputSourceTest, compactFile) {
+    InputSource source(TEST_DATA_SRCDIR "/masterload.txt", true);
+    EXPECT_EQ(';', source.getChar());
+    EXPECT_EQ(';', source.getChar());
+    source.compact();
+    EXPECT_THROW(source.ungetChar(), InputSource::UngetBeforeBeginning);
+    EXPECT_EQ(' ', source.getChar());
+    EXPECT_EQ('a', source.getChar());
+    source.ungetAll();
+    EXPECT_EQ(2, source.getPosition());
+    EXPECT_EQ(' ', source.getChar());
+}
+
+// Files other than regular files aren't mapped, but can still be read.
+TEST_F(InputSourceTest, unmappedFile) {
+    InputSource source("/dev/null", true);
+    EXPECT_EQ(0, source.getSize());
+    EXPECT_EQ(InputSource::END_OF_STREAM, source.getChar());
+    EXPECT_TRUE(source.atEOF());
+}
+
 // ungetAll() should skip back to the place where the InputSource
 // started at construction, or the last saved start of line.
 TEST_F(InputSourceTest, ungetAll) {
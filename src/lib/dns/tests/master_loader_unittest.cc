@@ -30,6 +30,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <iterator>
 #include <sstream>
 
 using namespace bundy::dns;
@@ -175,6 +176,19 @@ TEST_F(MasterLoaderTest, basicLoad) {
     checkBasicRRs();
 }
 
+// The same, with the file mapped into memory.
+TEST_F(MasterLoaderTest, mappedLoad) {
+    setLoader(TEST_DATA_SRCDIR "/example.org", Name("example.org."),
+              RRClass::IN(), MasterLoader::MAP_FILES);
+    loader_->load();
+    EXPECT_TRUE(loader_->loadedSucessfully());
+    EXPECT_TRUE(errors_.empty());
+    EXPECT_TRUE(warnings_.empty());
+    EXPECT_EQ(550, loader_->getSize());
+    EXPECT_EQ(550, loader_->getPosition());
+    checkBasicRRs();
+}
+
 // Test the $INCLUDE directive
 TEST_F(MasterLoaderTest, include) {
     // Test various cases of include
@@ -1444,4 +1458,157 @@ TEST_F(MasterLoaderTest, numericOwnerName) {
     checkRR("1.example.org", RRType::A(), "192.0.2.1");
 }
 
+// Parameters of setThreadCount() are checked.
+TEST_F(MasterLoaderTest, badThreadCount) {
+    setLoader(TEST_DATA_SRCDIR "/example.org", Name("example.org."),
+              RRClass::IN(), MasterLoader::DEFAULT);
+    EXPECT_THROW(loader_->setThreadCount(0), bundy::InvalidParameter);
+    loader_->loadIncremental(1);
+    EXPECT_THROW(loader_->setThreadCount(2), bundy::InvalidOperation);
+    checkRR("example.org", RRType::SOA(),
+            "ns1.example.org. admin.example.org. "
+            "1234 3600 1800 2419200 7200");
+}
+
+// A zone large enough to be split into several chunks, using directives,
+// omitted owner names and TTLs, and containing some errors.
+string
+makeLargeZone() {
+    stringstream ss;
+    ss << "example.org. IN SOA ns1.example.org. admin.example.org. "
+        "1234 3600 1800 2419200 7200\n";
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 5000 == 0) {
+            ss << "$TTL " << (1000 + i) << "\n";
+            ss << "$ORIGIN sub" << i << ".example.org.\n";
+        }
+        if (i % 1001 == 500) {
+            ss << "name" << i << " 300 IN A 192.0.2.1.2\n";
+        } else if (i % 7 == 0) {
+            ss << "name" << i << " IN TXT ( \"first\"\n"
+                "  \"second\" ) ; comment\n";
+        } else {
+            ss << "name" << i << " " << i << " IN A 192.0.2.1\n";
+        }
+        ss << "    IN AAAA 2001:db8::" << std::hex << i << std::dec << "\n";
+    }
+    ss << "$GENERATE 1-10 host$ A 192.0.2.$\n";
+    ss << "last IN A 192.0.2.2";
+    return (ss.str());
+}
+
+// Loading a zone with multiple threads gives the same result as loading
+// it with a single thread.
+TEST_F(MasterLoaderTest, parallelLoad) {
+    const string zone(makeLargeZone());
+    const MasterLoader::Options options[] = {
+        MasterLoader::MANY_ERRORS, MasterLoader::DEFAULT
+    };
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); ++i) {
+        // The same stream is used for all loads, so the source names in
+        // the messages are the same.
+        stringstream ss(zone);
+        setLoader(ss, Name("example.org."), RRClass::IN(), options[i]);
+        if (options[i] == MasterLoader::DEFAULT) {
+            EXPECT_THROW(loader_->load(), MasterLoaderError);
+        } else {
+            loader_->load();
+        }
+        EXPECT_FALSE(loader_->loadedSucessfully());
+        const list<RRsetPtr> expected_rrsets(rrsets_);
+        const vector<string> expected_errors(errors_);
+        const vector<string> expected_warnings(warnings_);
+        EXPECT_EQ(i == 0 ? 39992 : 1001, expected_rrsets.size());
+        EXPECT_EQ(i == 0 ? 20 : 1, expected_errors.size());
+
+        // Load it in small pieces too, so the chunks are reported over
+        // several calls to loadIncremental().
+        for (size_t limit = 0; limit <= 1000; limit += 1000) {
+            clear();
+            ss.clear();
+            ss.seekg(0);
+            setLoader(ss, Name("example.org."), RRClass::IN(), options[i]);
+            loader_->setThreadCount(4);
+            try {
+                if (limit == 0) {
+                    loader_->load();
+                } else {
+                    while (!loader_->loadIncremental(limit)) {
+                        EXPECT_LE(loader_->getPosition(),
+                                  loader_->getSize());
+                    }
+                }
+                EXPECT_EQ(MasterLoader::MANY_ERRORS, options[i]);
+            } catch (const MasterLoaderError&) {
+                EXPECT_EQ(MasterLoader::DEFAULT, options[i]);
+            }
+            EXPECT_FALSE(loader_->loadedSucessfully());
+            EXPECT_TRUE(expected_errors == errors_);
+            EXPECT_TRUE(expected_warnings == warnings_);
+            ASSERT_EQ(expected_rrsets.size(), rrsets_.size());
+            list<RRsetPtr>::const_iterator it = expected_rrsets.begin();
+            for (; !rrsets_.empty(); ++it) {
+                EXPECT_EQ((*it)->toText(), rrsets_.front()->toText());
+                rrsets_.pop_front();
+            }
+        }
+        clear();
+    }
+}
+
+// A $TTL in an $INCLUDE'd file stays in effect after the $INCLUDE, in
+// the following chunks too.
+TEST_F(MasterLoaderTest, parallelLoadTTLInInclude) {
+    stringstream zone_ss;
+    zone_ss << "$TTL 7200\n"
+        "example.org. IN SOA ns1.example.org. admin.example.org. "
+        "1234 3600 1800 2419200 7200\n";
+    // Each part is larger than a chunk.
+    for (int i = 0; i < 10000; ++i) {
+        if (i == 5000) {
+            zone_ss << "$INCLUDE " TEST_DATA_SRCDIR "/ttlinclude.zone\n";
+        }
+        zone_ss << "name" << i << " IN A 192.0.2.1\n";
+    }
+    const string zone(zone_ss.str());
+
+    stringstream ss(zone);
+    setLoader(ss, Name("example.org."), RRClass::IN(), MasterLoader::DEFAULT);
+    loader_->load();
+    EXPECT_TRUE(loader_->loadedSucessfully());
+    const list<RRsetPtr> expected_rrsets(rrsets_);
+    ASSERT_EQ(10002, expected_rrsets.size());
+    list<RRsetPtr>::const_iterator it = expected_rrsets.begin();
+    std::advance(it, 5001);
+    EXPECT_EQ(Name("included.example.org."), (*it)->getName());
+    EXPECT_EQ(RRTTL(1800), (*it)->getTTL());
+    EXPECT_EQ(RRTTL(1800), expected_rrsets.back()->getTTL());
+
+    clear();
+    ss.clear();
+    ss.seekg(0);
+    setLoader(ss, Name("example.org."), RRClass::IN(), MasterLoader::DEFAULT);
+    loader_->setThreadCount(4);
+    loader_->load();
+    EXPECT_TRUE(loader_->loadedSucessfully());
+    EXPECT_TRUE(errors_.empty());
+    EXPECT_TRUE(warnings_.empty());
+    ASSERT_EQ(expected_rrsets.size(), rrsets_.size());
+    for (it = expected_rrsets.begin(); !rrsets_.empty(); ++it) {
+        EXPECT_EQ((*it)->toText(), rrsets_.front()->toText());
+        rrsets_.pop_front();
+    }
+}
+
+// Nonexistent files are reported.
+TEST_F(MasterLoaderTest, parallelLoadNoFile) {
+    setLoader(TEST_DATA_SRCDIR "/nonexistent", Name("example.org."),
+              RRClass::IN(), MasterLoader::MANY_ERRORS);
+    loader_->setThreadCount(2);
+    loader_->load();
+    EXPECT_FALSE(loader_->loadedSucessfully());
+    EXPECT_EQ(1, errors_.size());
+    EXPECT_TRUE(warnings_.empty());
+}
+
 }
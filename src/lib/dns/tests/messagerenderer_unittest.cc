@@ -295,4 +295,29 @@ TEST_F(MessageRendererTest, manyRRs) {
     // any disruption.
     EXPECT_NO_THROW(renderer.clear());
 }
+
+TEST_F(MessageRendererTest, manyRRsCompressed) {
+    // Render many names twice.  All names of the second round should be
+    // compressed into a single pointer, which requires the compression
+    // table to keep all names while growing.
+    for (size_t i = 0; i < 1000; ++i) {
+        renderer.writeName(Name(lexical_cast<std::string>(i) + ".example"));
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        const size_t length = renderer.getLength();
+        renderer.writeName(Name(lexical_cast<std::string>(i) + ".example"));
+        EXPECT_EQ(2, renderer.getLength() - length);
+    }
+
+    // After clear(), no name should be compressed against the names
+    // rendered before, even if they happen to be at the same position.
+    renderer.clear();
+    renderer.writeName(Name("0.example"));
+    renderer.writeName(Name("1.example"));
+    EXPECT_EQ(Name("0.example").getLength() + 2 + 2, renderer.getLength());
+    renderer.clear();
+    renderer.writeUint8(0);
+    renderer.writeName(Name("1.example"));
+    EXPECT_EQ(1 + Name("1.example").getLength(), renderer.getLength());
+}
 }
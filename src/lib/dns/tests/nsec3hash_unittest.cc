@@ -13,6 +13,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -157,6 +158,55 @@ matchCheck(NSEC3Hash& hash, const string& postfix) {
     EXPECT_TRUE(hash.match(RDATAType("1 1 12 aabbccdd" + postfix)));
 }
 
+// Batched calculation should give the same results as calculate(), also
+// for more names than can be hashed together at once.
+void
+calculateBatchCheck(const NSEC3Hash& hash) {
+    const Name names[] = {
+        Name("example"), Name("a.example"), Name("EXAMPLE"),
+        Name("*.w.example"), Name("x.y.w.example"),
+        Name("a-very-long-label-for-a-multiblock-name.x.y.w.example"),
+        Name(".")
+    };
+    const size_t count = sizeof(names) / sizeof(names[0]);
+    vector<LabelSequence> sequences;
+    const LabelSequence* labels[count];
+    for (size_t i = 0; i < count; ++i) {
+        sequences.push_back(LabelSequence(names[i]));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        labels[i] = &sequences[i];
+    }
+
+    for (size_t n = 0; n <= count; ++n) {
+        string hashes[count];
+        hash.calculateBatch(labels, n, hashes);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(hash.calculate(names[i]), hashes[i]);
+        }
+    }
+}
+
+TEST_F(NSEC3HashTest, calculateBatch) {
+    calculateBatchCheck(*test_hash);
+    calculateBatchCheck(*NSEC3HashPtr(NSEC3Hash::create(
+                                          generic::NSEC3PARAM("1 0 0 -"))));
+    calculateBatchCheck(*NSEC3HashPtr(NSEC3Hash::create(
+                                          generic::NSEC3PARAM(
+                                              "1 0 256 AABBCCDD"))));
+
+    // Known values, in a single batch.
+    const Name example("example");
+    const Name a_example("a.example");
+    const LabelSequence example_ls(example);
+    const LabelSequence a_example_ls(a_example);
+    const LabelSequence* const labels[] = { &example_ls, &a_example_ls };
+    string hashes[2];
+    test_hash->calculateBatch(labels, 2, hashes);
+    EXPECT_EQ("0P9MHAVEQVM6T7VBL5LOP2U3T2RP3TOM", hashes[0]);
+    EXPECT_EQ("35MTHGPGCU1QG68FAB165KLNSNK3DPVL", hashes[1]);
+}
+
 TEST_F(NSEC3HashTest, matchWithNSEC3) {
     {
         SCOPED_TRACE("match NSEC3PARAM based hash against NSEC3 parameters");
@@ -238,6 +288,12 @@ TEST_F(NSEC3HashTest, setCreator) {
               test_hash->calculate(Name("example")));
     EXPECT_EQ("00000000000000000000000000000000",
               test_hash->calculate(LabelSequence(Name("example"))));
+    // The default batched calculation uses the faked calculate().
+    const LabelSequence root_ls(Name::ROOT_NAME());
+    const LabelSequence* const labels = &root_ls;
+    string batch_hash;
+    test_hash->calculateBatch(&labels, 1, &batch_hash);
+    EXPECT_EQ("00000000000000000000000000000000", batch_hash);
     // Same for hash from NSEC3 RDATA
     test_hash.reset(NSEC3Hash::create(generic::NSEC3
                                       ("1 0 12 aabbccdd " +
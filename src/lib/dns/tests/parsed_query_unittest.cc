@@ -0,0 +1,239 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include <dns/parsed_query.h>
+#include <dns/edns.h>
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace std;
+using namespace bundy::dns;
+
+namespace {
+class ParsedQueryTest : public ::testing::Test {
+protected:
+    ParsedQueryTest() : message(Message::RENDER) {
+        message.setQid(0x1035);
+        message.setOpcode(Opcode::QUERY());
+        message.setRcode(Rcode::NOERROR());
+        message.setHeaderFlag(Message::HEADERFLAG_RD);
+        message.addQuestion(Question(Name("www.Example.com"), RRClass::IN(),
+                                     RRType::AAAA()));
+    }
+
+    // Render the message and store the data in wire.
+    void render() {
+        message.toWire(renderer);
+        wire.assign(static_cast<const uint8_t*>(renderer.getData()),
+                    static_cast<const uint8_t*>(renderer.getData()) +
+                    renderer.getLength());
+    }
+
+    bool parse() {
+        return (query.parse(&wire[0], wire.size()));
+    }
+
+    Message message;
+    MessageRenderer renderer;
+    vector<uint8_t> wire;
+    ParsedQuery query;
+};
+
+TEST_F(ParsedQueryTest, construct) {
+    EXPECT_EQ(0, query.getQid());
+    EXPECT_TRUE(query.getQName().equals(LabelSequence(Name::ROOT_NAME())));
+    EXPECT_FALSE(query.hasEDNS());
+    EXPECT_FALSE(query.hasTSIG());
+}
+
+TEST_F(ParsedQueryTest, parse) {
+    render();
+    ASSERT_TRUE(parse());
+    EXPECT_EQ(0x1035, query.getQid());
+    EXPECT_TRUE(query.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_FALSE(query.getHeaderFlag(Message::HEADERFLAG_CD));
+    // The case of the name is preserved.
+    EXPECT_TRUE(query.getQName().equals(
+                    LabelSequence(Name("www.Example.com")), true));
+    EXPECT_EQ(RRType::AAAA(), query.getQType());
+    EXPECT_EQ(RRClass::IN(), query.getQClass());
+    EXPECT_EQ(Name("www.example.com").getLength() + 4,
+              query.getQuestionLength());
+    EXPECT_FALSE(query.hasEDNS());
+    EXPECT_EQ(ParsedQuery::NO_OFFSET, query.getEDNSOffset());
+    EXPECT_FALSE(query.getDNSSECAwareness());
+    EXPECT_FALSE(query.hasTSIG());
+
+    // The object can be reused.
+    message.clear(Message::RENDER);
+    message.setOpcode(Opcode::QUERY());
+    message.setRcode(Rcode::NOERROR());
+    message.addQuestion(Question(Name::ROOT_NAME(), RRClass::CH(),
+                                 RRType::NS()));
+    renderer.clear();
+    render();
+    ASSERT_TRUE(parse());
+    EXPECT_EQ(0, query.getQid());
+    EXPECT_FALSE(query.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_TRUE(query.getQName().equals(LabelSequence(Name::ROOT_NAME())));
+    EXPECT_EQ(RRType::NS(), query.getQType());
+    EXPECT_EQ(RRClass::CH(), query.getQClass());
+}
+
+TEST_F(ParsedQueryTest, parseEDNS) {
+    EDNSPtr edns(new EDNS());
+    edns->setUDPSize(4096);
+    edns->setDNSSECAwareness(true);
+    message.setEDNS(edns);
+    render();
+    ASSERT_TRUE(parse());
+    EXPECT_TRUE(query.hasEDNS());
+    EXPECT_EQ(ParsedQuery::HEADER_LENGTH + query.getQuestionLength(),
+              query.getEDNSOffset());
+    EXPECT_EQ(4096, query.getUDPSize());
+    EXPECT_EQ(0, query.getEDNSVersion());
+    EXPECT_TRUE(query.getDNSSECAwareness());
+    EXPECT_FALSE(query.hasTSIG());
+
+    // Unsupported versions are reported as they are.
+    wire[query.getEDNSOffset() + 6] = 1;
+    ASSERT_TRUE(parse());
+    EXPECT_EQ(1, query.getEDNSVersion());
+}
+
+TEST_F(ParsedQueryTest, parseTSIG) {
+    render();
+    // Append a (dummy) TSIG RR with an empty RDATA and a compressed owner
+    // name, and adjust ARCOUNT.
+    const size_t tsig_offset = wire.size();
+    const uint8_t tsig_rr[] = {
+        0xc0, 0x0c, 0x00, 0xfa, 0x00, 0xff, 0, 0, 0, 0, 0, 0
+    };
+    wire.insert(wire.end(), tsig_rr, tsig_rr + sizeof(tsig_rr));
+    wire[11] = 1;
+    ASSERT_TRUE(parse());
+    EXPECT_FALSE(query.hasEDNS());
+    EXPECT_TRUE(query.hasTSIG());
+    EXPECT_EQ(tsig_offset, query.getTSIGOffset());
+
+    // TSIG must be in class ANY.
+    wire[tsig_offset + 5] = 0x01;
+    EXPECT_FALSE(parse());
+}
+
+TEST_F(ParsedQueryTest, parseEDNSAndTSIG) {
+    message.setEDNS(EDNSPtr(new EDNS()));
+    render();
+    const uint8_t tsig_rr[] = {
+        0x00, 0x00, 0xfa, 0x00, 0xff, 0, 0, 0, 0, 0, 0
+    };
+    wire.insert(wire.end(), tsig_rr, tsig_rr + sizeof(tsig_rr));
+    wire[11] = 2;
+    ASSERT_TRUE(parse());
+    EXPECT_TRUE(query.hasEDNS());
+    EXPECT_TRUE(query.hasTSIG());
+
+    // The OPT RR must come before TSIG.
+    message.clear(Message::RENDER);
+    message.setOpcode(Opcode::QUERY());
+    message.setRcode(Rcode::NOERROR());
+    message.addQuestion(Question(Name::ROOT_NAME(), RRClass::IN(),
+                                 RRType::NS()));
+    renderer.clear();
+    render();
+    wire.insert(wire.end(), tsig_rr, tsig_rr + sizeof(tsig_rr));
+    const uint8_t opt_rr[] = { 0x00, 0x00, 0x29, 0x10, 0, 0, 0, 0, 0, 0, 0 };
+    wire.insert(wire.end(), opt_rr, opt_rr + sizeof(opt_rr));
+    wire[11] = 2;
+    EXPECT_FALSE(parse());
+}
+
+TEST_F(ParsedQueryTest, notOrdinaryQuery) {
+    render();
+    vector<uint8_t> orig_wire = wire;
+
+    // Too short
+    EXPECT_FALSE(query.parse(&wire[0], 11));
+    EXPECT_FALSE(query.parse(&wire[0], wire.size() - 1));
+
+    // Response
+    wire[2] |= 0x80;
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+
+    // Opcode other than QUERY
+    wire[2] |= (Opcode::NOTIFY_CODE << 3);
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+
+    // Unexpected counts
+    wire[5] = 2;                // QDCOUNT
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+    wire[7] = 1;                // ANCOUNT
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+    wire[9] = 1;                // NSCOUNT
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+    wire[11] = 3;               // ARCOUNT
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+
+    // Trailing garbage
+    wire.push_back(0);
+    EXPECT_FALSE(parse());
+    wire = orig_wire;
+
+    // Compressed query name
+    const uint8_t compressed[] = { 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01 };
+    wire.resize(12);
+    wire.insert(wire.end(), compressed, compressed + sizeof(compressed));
+    EXPECT_FALSE(parse());
+
+    // Other RRs in the additional section
+    wire = orig_wire;
+    const uint8_t a_rr[] = { 0x00, 0x00, 0x01, 0x00, 0x01, 0, 0, 0, 0,
+                             0, 4, 192, 0, 2, 1 };
+    wire.insert(wire.end(), a_rr, a_rr + sizeof(a_rr));
+    wire[11] = 1;
+    EXPECT_FALSE(parse());
+
+    // RDATA longer than the data
+    wire = orig_wire;
+    const uint8_t opt_rr[] = { 0x00, 0x00, 0x29, 0x10, 0, 0, 0, 0, 0, 0, 4 };
+    wire.insert(wire.end(), opt_rr, opt_rr + sizeof(opt_rr));
+    wire[11] = 1;
+    EXPECT_FALSE(parse());
+
+    // OPT RR not owned by the root name
+    wire = orig_wire;
+    const uint8_t bad_opt_rr[] = { 0xc0, 0x0c, 0x00, 0x29, 0x10, 0, 0, 0,
+                                   0, 0, 0, 0 };
+    wire.insert(wire.end(), bad_opt_rr, bad_opt_rr + sizeof(bad_opt_rr));
+    wire[11] = 1;
+    EXPECT_FALSE(parse());
+}
+}
@@ -17,12 +17,14 @@
 
 #include <log/logger.h>
 #include <log/logger_impl.h>
+#include <log/logger_manager.h>
 #include <log/logger_name.h>
 #include <log/logger_support.h>
 #include <log/message_dictionary.h>
 #include <log/message_types.h>
 
 #include <util/strutil.h>
+#include <util/threads/sync.h>
 
 using namespace std;
 
@@ -30,9 +32,18 @@ namespace bundy {
 namespace log {
 
 // Initialize underlying logger, but only if logging has been initialized.
-void Logger::initLoggerImpl() {
+// A logger can be used for the first time by more than one thread at once,
+// so the creation is done under the logger manager's mutex.
+LoggerImpl*
+Logger::initLoggerImpl() {
     if (isLoggingInitialized()) {
-        loggerptr_ = new LoggerImpl(name_);
+        bundy::util::thread::Mutex::Locker locker(LoggerManager::getMutex());
+        LoggerImpl* ptr = loggerptr_.load(std::memory_order_relaxed);
+        if (!ptr) {
+            ptr = new LoggerImpl(name_);
+            loggerptr_.store(ptr, std::memory_order_release);
+        }
+        return (ptr);
     } else {
         bundy_throw(LoggingNotInitialized, "attempt to access logging function "
                   "before logging has been initialized");
@@ -42,12 +53,12 @@ void Logger::initLoggerImpl() {
 // Destructor.
 
 Logger::~Logger() {
-    delete loggerptr_;
+    delete loggerptr_.load();
 
     // The next statement is required for the BUNDY hooks framework, where
     // a statically-linked BUNDY loads and unloads multiple libraries. See
     // the hooks documentation for more details.
-    loggerptr_ = 0;
+    loggerptr_.store(NULL);
 }
 
 // Get Name of Logger
@@ -15,6 +15,7 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <string>
@@ -309,18 +310,25 @@ private:
     /// regardless of whether is is statically or automatically declared -  will
     /// cause a "LoggingNotInitialized" exception to be thrown.
     ///
+    /// The pointer is published with release semantics by initLoggerImpl()
+    /// and read here with acquire semantics, so a thread that sees a non-null
+    /// pointer also sees the fully constructed implementation.
+    ///
     /// \return Returns pointer to implementation
     LoggerImpl* getLoggerPtr() {
-        if (!loggerptr_) {
-            initLoggerImpl();
+        LoggerImpl* ptr = loggerptr_.load(std::memory_order_acquire);
+        if (!ptr) {
+            ptr = initLoggerImpl();
         }
-        return (loggerptr_);
+        return (ptr);
     }
 
     /// \brief Initialize Underlying Implementation and Set loggerptr_
-    void initLoggerImpl();
+    ///
+    /// \return The (possibly already set by another thread) implementation
+    LoggerImpl* initLoggerImpl();
 
-    LoggerImpl* loggerptr_;                  ///< Pointer to underlying logger
+    std::atomic<LoggerImpl*> loggerptr_;     ///< Pointer to underlying logger
     char        name_[MAX_LOGGER_NAME_SIZE + 1]; ///< Copy of the logger name
 };
 
@@ -201,6 +201,29 @@ Parameters:\n\
 Return Value(s): Pointer to the iterator.\n\
 ";
 
+const char* const DataSourceClient_writeZoneSnapshot_doc = "\
+write_zone_snapshot(name, filename) -> integer\n\
+\n\
+Write a snapshot of the given zone to a file.\n\
+\n\
+The snapshot is a binary image of the zone that the in-memory data\n\
+source can load much faster than a master file; it's used in place of\n\
+the master file when the name of the zone file ends with \".snapshot\".\n\
+The file is overwritten if it exists.\n\
+\n\
+This throws bundy.datasrc.Error when the zone does not exist in the\n\
+datasource, when the file cannot be written, or when an internal error\n\
+occurs. It throws bundy.datasrc.NotImplemented if the data source\n\
+doesn't support iterating over the zone.\n\
+\n\
+Parameters:\n\
+  name       bundy.dns.Name The name of zone apex.\n\
+  filename   The file to write the snapshot to (it should end with\n\
+             \".snapshot\").\n\
+\n\
+Return Value(s): The number of RRsets written.\n\
+";
+
 const char* const DataSourceClient_getUpdater_doc = "\
 get_updater(name, replace, journaling=False) -> ZoneUpdater\n\
 \n\
@@ -29,6 +29,7 @@
 #include <datasrc/sqlite3_accessor.h>
 #include <datasrc/zone_iterator.h>
 #include <datasrc/client_list.h>
+#include <datasrc/memory/zone_snapshot.h>
 
 #include <dns/python/name_python.h>
 #include <dns/python/rrset_python.h>
@@ -205,6 +206,47 @@ DataSourceClient_getIterator(PyObject* po_self, PyObject* args) {
     }
 }
 
+PyObject*
+DataSourceClient_writeZoneSnapshot(PyObject* po_self, PyObject* args) {
+    s_DataSourceClient* const self = static_cast<s_DataSourceClient*>(po_self);
+    PyObject* name_obj;
+    const char* filename;
+    if (PyArg_ParseTuple(args, "O!s", &name_type, &name_obj, &filename)) {
+        try {
+            const bundy::dns::Name name(PyName_ToName(name_obj));
+            const DataSourceClient::FindResult find_result =
+                self->client->findZone(name);
+            if (find_result.code != result::SUCCESS) {
+                PyErr_SetString(getDataSourceException("Error"),
+                                ("no such zone: " + name.toText()).c_str());
+                return (NULL);
+            }
+            ZoneIteratorPtr iterator = self->client->getIterator(name);
+            const size_t count =
+                memory::writeZoneSnapshot(*iterator, name,
+                                          find_result.zone_finder->getClass(),
+                                          filename);
+            return (Py_BuildValue("I", static_cast<unsigned int>(count)));
+        } catch (const bundy::NotImplemented& ne) {
+            PyErr_SetString(getDataSourceException("NotImplemented"),
+                            ne.what());
+            return (NULL);
+        } catch (const DataSourceError& dse) {
+            PyErr_SetString(getDataSourceException("Error"), dse.what());
+            return (NULL);
+        } catch (const std::exception& exc) {
+            PyErr_SetString(getDataSourceException("Error"), exc.what());
+            return (NULL);
+        } catch (...) {
+            PyErr_SetString(getDataSourceException("Error"),
+                            "Unexpected exception");
+            return (NULL);
+        }
+    } else {
+        return (NULL);
+    }
+}
+
 PyObject*
 DataSourceClient_getUpdater(PyObject* po_self, PyObject* args) {
     s_DataSourceClient* const self = static_cast<s_DataSourceClient*>(po_self);
@@ -308,6 +350,8 @@ PyMethodDef DataSourceClient_methods[] = {
     { "get_iterator",
       DataSourceClient_getIterator, METH_VARARGS,
       DataSourceClient_getIterator_doc },
+    { "write_zone_snapshot", DataSourceClient_writeZoneSnapshot,
+      METH_VARARGS, DataSourceClient_writeZoneSnapshot_doc },
     { "get_updater", DataSourceClient_getUpdater,
       METH_VARARGS, DataSourceClient_getUpdater_doc },
     { "get_journal_reader", DataSourceClient_getJournalReader,
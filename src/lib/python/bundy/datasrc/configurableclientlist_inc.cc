@@ -108,6 +108,21 @@ The tuples contain (name, segment_type, segment_state):\n\
 If segment_state is SEGMENT_UNUSED, None is returned for the segment_type.\n\
 ";
 
+const char* const ConfigurableClientList_get_zone_memory_usage_doc = "\
+get_zone_memory_usage() -> list of tuples\n\
+\n\
+This method returns a list of tuples, with each tuple containing the\n\
+memory usage of a zone cached in memory. Zones that are not cached or\n\
+not loaded yet are not included.\n\
+\n\
+The tuples contain (datasrc_name, zone_name, usage):\n\
+  datasrc_name      The name of the data source.\n\
+  zone_name         The origin of the zone as a bundy.dns.Name object.\n\
+  usage             A dict of the memory usage of the zone, containing\n\
+                    'nodes', 'node_bytes', 'rdatasets', 'rdataset_bytes',\n\
+                    'nsec3_bytes', 'name_index_bytes' and 'total_bytes'.\n\
+";
+
 const char* const ConfigurableClientList_find_doc = "\
 find(zone, want_exact_match=False, want_finder=True) -> datasrc_client,\
 zone_finder, exact_match\n\
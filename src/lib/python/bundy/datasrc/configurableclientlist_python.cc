@@ -247,6 +247,54 @@ ConfigurableClientList_getStatus(PyObject* po_self, PyObject*) {
     }
 }
 
+PyObject*
+ConfigurableClientList_getZoneMemoryUsage(PyObject* po_self, PyObject*) {
+    s_ConfigurableClientList* self =
+        static_cast<s_ConfigurableClientList*>(po_self);
+    try {
+        const std::vector<ZoneMemoryUsage> usages =
+            self->cppobj->getZoneMemoryUsage();
+
+        PyObjectContainer ulist(PyList_New(usages.size()));
+
+        for (size_t i = 0; i < usages.size(); ++i) {
+            const ZoneDataMemoryUsage& usage = usages[i].usage;
+            PyObjectContainer zone_name(
+                createNameObject(usages[i].zone_name));
+            PyObjectContainer umap(Py_BuildValue(
+                "{s:K,s:K,s:K,s:K,s:K,s:K,s:K}",
+                "nodes", static_cast<unsigned long long>(usage.node_count),
+                "node_bytes",
+                static_cast<unsigned long long>(usage.node_bytes),
+                "rdatasets",
+                static_cast<unsigned long long>(usage.rdataset_count),
+                "rdataset_bytes",
+                static_cast<unsigned long long>(usage.rdataset_bytes),
+                "nsec3_bytes",
+                static_cast<unsigned long long>(usage.nsec3_bytes),
+                "name_index_bytes",
+                static_cast<unsigned long long>(usage.name_index_bytes),
+                "total_bytes",
+                static_cast<unsigned long long>(usage.getTotal())));
+            PyObjectContainer tup(Py_BuildValue("(sOO)",
+                                                usages[i].datasrc_name.c_str(),
+                                                zone_name.get(), umap.get()));
+            // The following "steals" our reference on tup, so we must
+            // not decref.
+            PyList_SET_ITEM(ulist.get(), i, tup.release());
+        }
+
+        return (ulist.release());
+    } catch (const std::exception& exc) {
+        PyErr_SetString(getDataSourceException("Error"), exc.what());
+        return (NULL);
+    } catch (...) {
+        PyErr_SetString(getDataSourceException("Error"),
+                        "Unknown C++ exception");
+        return (NULL);
+    }
+}
+
 PyObject*
 ConfigurableClientList_find(PyObject* po_self, PyObject* args) {
     s_ConfigurableClientList* self =
@@ -350,6 +398,8 @@ PyMethodDef ConfigurableClientList_methods[] = {
       METH_VARARGS, ConfigurableClientList_get_cached_zone_writer_doc },
     { "get_status", ConfigurableClientList_getStatus,
       METH_NOARGS, ConfigurableClientList_get_status_doc },
+    { "get_zone_memory_usage", ConfigurableClientList_getZoneMemoryUsage,
+      METH_NOARGS, ConfigurableClientList_get_zone_memory_usage_doc },
     { "find", ConfigurableClientList_find,
       METH_VARARGS, ConfigurableClientList_find_doc },
     { NULL, NULL, 0, NULL }
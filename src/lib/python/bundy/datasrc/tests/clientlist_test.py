@@ -432,6 +432,27 @@ class ClientListTest(unittest.TestCase):
                                bundy.datasrc.ConfigurableClientList.SEGMENT_WAITING),
                               status[0])
 
+    def test_get_zone_memory_usage(self):
+        """
+        Test getting memory usage of cached zones.
+        """
+
+        self.clist = bundy.datasrc.ConfigurableClientList(bundy.dns.RRClass.IN)
+        self.assertEqual([], self.clist.get_zone_memory_usage())
+
+        self.configure_helper()
+
+        usages = self.clist.get_zone_memory_usage()
+        self.assertEqual(1, len(usages))
+        (datasrc_name, zone_name, usage) = usages[0]
+        self.assertEqual('MasterFiles', datasrc_name)
+        self.assertEqual(bundy.dns.Name('example.com'), zone_name)
+        self.assertLess(0, usage['nodes'])
+        self.assertLess(0, usage['rdatasets'])
+        self.assertEqual(usage['node_bytes'] + usage['rdataset_bytes'] +
+                         usage['nsec3_bytes'] + usage['name_index_bytes'],
+                         usage['total_bytes'])
+
 if __name__ == "__main__":
     bundy.log.init("bundy")
     bundy.log.resetUnitTestRootLogger()
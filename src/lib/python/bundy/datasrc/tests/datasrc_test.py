@@ -299,6 +299,36 @@ class DataSrcClient(unittest.TestCase):
                                              "3600 1800 2419200 7200"))
         self.assertTrue(rrsets_equal(expected_soa, iterator.get_soa()))
 
+    def test_write_zone_snapshot(self):
+        snapshot_file = TESTDATA_WRITE_PATH + "example.com.snapshot"
+        dsc = bundy.datasrc.DataSourceClient("sqlite3", READ_ZONE_DB_CONFIG)
+        # 72 RRsets, see test_iterate
+        self.assertEqual(72, dsc.write_zone_snapshot(Name("example.com"),
+                                                     snapshot_file))
+
+        # The snapshot can be loaded into memory in place of a master file.
+        clist = bundy.datasrc.ConfigurableClientList(bundy.dns.RRClass.IN)
+        clist.configure(json.dumps([{
+            "type": "MasterFiles",
+            "cache-enable": True,
+            "params": {"example.com": snapshot_file}}]), True)
+        dsc_mem = clist.find(Name("example.com"), True, False)[0]
+        result, finder = dsc_mem.find_zone(Name("example.com"))
+        self.assertEqual(finder.SUCCESS, result)
+        result, rrset, _ = finder.find(Name("www.example.com"), RRType.A)
+        self.assertEqual(finder.SUCCESS, result)
+        self.assertEqual("www.example.com. 3600 IN A 192.0.2.1\n",
+                         rrset.to_text())
+        os.remove(snapshot_file)
+
+        self.assertRaises(bundy.datasrc.Error, dsc.write_zone_snapshot,
+                          Name("example.org"), snapshot_file)
+        self.assertRaises(bundy.datasrc.Error, dsc.write_zone_snapshot,
+                          Name("example.com"),
+                          TESTDATA_WRITE_PATH + "no-such-dir/x.snapshot")
+        self.assertRaises(TypeError, dsc.write_zone_snapshot,
+                          "example.com", snapshot_file)
+
     def test_construct(self):
         # can't construct directly
         self.assertRaises(TypeError, bundy.datasrc.ZoneFinder)
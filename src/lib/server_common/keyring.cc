@@ -41,7 +41,9 @@ updateKeyring(const std::string&, ConstElementPtr data,
     for (size_t i(0); list && i < list->size(); ++ i) {
         load->add(TSIGKey(list->get(i)->stringValue()));
     }
-    keyring.swap(load);
+    // The keyring may be referred to from other threads (such as query
+    // worker threads of bundy-auth), so it's replaced atomically.
+    boost::atomic_store(&keyring, load);
 }
 
 }
@@ -76,6 +76,25 @@ public:
         }
         return (counters_.at(type));
     }
+
+    /// \brief Add the values of another set of counters to this one.
+    ///
+    /// This is useful to sum up counters that are maintained separately,
+    /// e.g., per thread, to avoid contention.
+    ///
+    /// \param other The set of counters to add; it must have the same
+    /// number of items as this one.
+    ///
+    /// \throw bundy::InvalidParameter the number of items differs
+    void add(const Counter& other) {
+        if (other.counters_.size() != counters_.size()) {
+            bundy_throw(bundy::InvalidParameter,
+                        "Counters of different sizes can't be added");
+        }
+        for (size_t i = 0; i < counters_.size(); ++i) {
+            counters_[i] += other.counters_[i];
+        }
+    }
 };
 
 }   // namespace statistics
@@ -88,3 +88,25 @@ TEST_F(CounterTest, invalidCounterItem) {
     // exception
     EXPECT_THROW(counter.get(NUMBER_OF_ITEMS), bundy::OutOfRange);
 }
+
+TEST_F(CounterTest, addCounter) {
+    Counter other(NUMBER_OF_ITEMS);
+    counter.inc(ITEM1);
+    counter.inc(ITEM2);
+    other.inc(ITEM2);
+    other.inc(ITEM3);
+    other.inc(ITEM3);
+
+    counter.add(other);
+    EXPECT_EQ(counter.get(ITEM1), 1);
+    EXPECT_EQ(counter.get(ITEM2), 2);
+    EXPECT_EQ(counter.get(ITEM3), 2);
+    // The added one is intact
+    EXPECT_EQ(other.get(ITEM1), 0);
+    EXPECT_EQ(other.get(ITEM2), 1);
+    EXPECT_EQ(other.get(ITEM3), 2);
+
+    // Counters of different sizes can't be added.
+    Counter small(NUMBER_OF_ITEMS - 1);
+    EXPECT_THROW(counter.add(small), bundy::InvalidParameter);
+}
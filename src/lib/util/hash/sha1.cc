@@ -487,6 +487,250 @@ SHA1ProcessMessageBlock(SHA1Context *context) {
     context->Message_Block_Index = 0;
 }
 
+/*
+ *  SHA1MultiLoadBlock
+ *
+ *  Description:
+ *      This helper function fills the first 16 words of W with the
+ *      index-th block of the padded message, as SHA1PadMessage would
+ *      pad it with a Pad_Byte of 0x80.
+ *
+ *  Returns:
+ *      Nothing.
+ *
+ */
+static void
+SHA1MultiLoadBlock(const uint8_t *message, unsigned int length,
+                   unsigned int index, bool last, uint32_t W[80])
+{
+    uint8_t       block[SHA1_BLOCKSIZE];
+    const unsigned int offset = index * SHA1_BLOCKSIZE;
+    int           t;
+
+    if (offset + SHA1_BLOCKSIZE <= length) {
+        for (t = 0; t < SHA1_BLOCKSIZE; t++) {
+            block[t] = message[offset + t];
+        }
+    } else {
+        for (t = 0; t < SHA1_BLOCKSIZE; t++) {
+            if (offset + t < length) {
+                block[t] = message[offset + t];
+            } else if (offset + t == length) {
+                block[t] = 0x80;
+            } else {
+                block[t] = 0;
+            }
+        }
+    }
+    if (last) {
+        /* Store the message length in bits as the last 8 octets */
+        const uint32_t length_high = length >> 29;
+        const uint32_t length_low = length << 3;
+        block[56] = (uint8_t) (length_high >> 24);
+        block[57] = (uint8_t) (length_high >> 16);
+        block[58] = (uint8_t) (length_high >> 8);
+        block[59] = (uint8_t) (length_high);
+        block[60] = (uint8_t) (length_low >> 24);
+        block[61] = (uint8_t) (length_low >> 16);
+        block[62] = (uint8_t) (length_low >> 8);
+        block[63] = (uint8_t) (length_low);
+    }
+
+    for (t = 0; t < 16; t++) {
+        W[t]  = ((uint32_t)block[t * 4]) << 24;
+        W[t] |= ((uint32_t)block[t * 4 + 1]) << 16;
+        W[t] |= ((uint32_t)block[t * 4 + 2]) << 8;
+        W[t] |= ((uint32_t)block[t * 4 + 3]);
+    }
+}
+
+/*
+ *  SHA1MultiProcessBlocks
+ *
+ *  Description:
+ *      This helper function is SHA1ProcessMessageBlock for count
+ *      blocks loaded in W, updating the corresponding hashes in H.
+ *      The innermost loops run over the messages so that the rounds
+ *      of the different messages, which don't depend on each other,
+ *      are next to each other.  count is a template parameter so these
+ *      loops can be unrolled and the word buffers kept in registers.
+ *
+ *  Returns:
+ *      Nothing.
+ *
+ */
+template <unsigned int count>
+static void
+SHA1MultiProcessBlocks(uint32_t H[][SHA1_HASHSIZE/4], uint32_t W[][80])
+{
+    /* Constants defined in FIPS-180-2, section 4.2.1 */
+    const uint32_t K[] = {
+        0x5A827999,
+        0x6ED9EBA1,
+        0x8F1BBCDC,
+        0xCA62C1D6
+    };
+    int           t;                 /* Loop counter                */
+    unsigned int  l;                 /* Lane counter                */
+    uint32_t      temp;              /* Temporary word value        */
+    uint32_t      A[SHA1_MAX_LANES], B[SHA1_MAX_LANES], C[SHA1_MAX_LANES],
+                  D[SHA1_MAX_LANES], E[SHA1_MAX_LANES]; /* Word buffers */
+
+    for (t = 16; t < 80; t++) {
+        for (l = 0; l < count; l++) {
+            W[l][t] = SHA1CircularShift(1, W[l][t-3] ^ W[l][t-8] ^
+                                        W[l][t-14] ^ W[l][t-16]);
+        }
+    }
+
+    for (l = 0; l < count; l++) {
+        A[l] = H[l][0];
+        B[l] = H[l][1];
+        C[l] = H[l][2];
+        D[l] = H[l][3];
+        E[l] = H[l][4];
+    }
+
+    for (t = 0; t < 20; t++) {
+        for (l = 0; l < count; l++) {
+            temp = SHA1CircularShift(5, A[l]) + SHA_Ch(B[l], C[l], D[l]) +
+                E[l] + W[l][t] + K[0];
+            E[l] = D[l];
+            D[l] = C[l];
+            C[l] = SHA1CircularShift(30, B[l]);
+            B[l] = A[l];
+            A[l] = temp;
+        }
+    }
+
+    for (t = 20; t < 40; t++) {
+        for (l = 0; l < count; l++) {
+            temp = SHA1CircularShift(5, A[l]) + SHA_Parity(B[l], C[l], D[l]) +
+                E[l] + W[l][t] + K[1];
+            E[l] = D[l];
+            D[l] = C[l];
+            C[l] = SHA1CircularShift(30, B[l]);
+            B[l] = A[l];
+            A[l] = temp;
+        }
+    }
+
+    for (t = 40; t < 60; t++) {
+        for (l = 0; l < count; l++) {
+            temp = SHA1CircularShift(5, A[l]) + SHA_Maj(B[l], C[l], D[l]) +
+                E[l] + W[l][t] + K[2];
+            E[l] = D[l];
+            D[l] = C[l];
+            C[l] = SHA1CircularShift(30, B[l]);
+            B[l] = A[l];
+            A[l] = temp;
+        }
+    }
+
+    for (t = 60; t < 80; t++) {
+        for (l = 0; l < count; l++) {
+            temp = SHA1CircularShift(5, A[l]) + SHA_Parity(B[l], C[l], D[l]) +
+                E[l] + W[l][t] + K[3];
+            E[l] = D[l];
+            D[l] = C[l];
+            C[l] = SHA1CircularShift(30, B[l]);
+            B[l] = A[l];
+            A[l] = temp;
+        }
+    }
+
+    for (l = 0; l < count; l++) {
+        H[l][0] += A[l];
+        H[l][1] += B[l];
+        H[l][2] += C[l];
+        H[l][3] += D[l];
+        H[l][4] += E[l];
+    }
+}
+
+/*
+ *  SHA1MultiResult
+ *
+ *  Description:
+ *      This function computes the digests of several messages of the
+ *      same length.  The messages are padded in place of SHA1PadMessage
+ *      and their blocks are processed together, one round of every
+ *      message at a time.  As the messages have the same length they
+ *      have the same number of blocks.
+ *
+ *  Parameters:
+ *      messages: [in]
+ *          The messages to be hashed.
+ *      count: [in]
+ *          The number of messages, at most SHA1_MAX_LANES.
+ *      length: [in]
+ *          The length of each message in octets.
+ *      digests: [out]
+ *          Where the digests are returned, in the order of the messages.
+ *          They are written after all blocks are processed, so a digest
+ *          can overwrite the beginning of its message.
+ *
+ *  Returns:
+ *      sha Error Code.
+ *
+ */
+int
+SHA1MultiResult(const uint8_t* const messages[], unsigned int count,
+                unsigned int length, uint8_t* const digests[])
+{
+    uint32_t      H[SHA1_MAX_LANES][SHA1_HASHSIZE/4];
+    uint32_t      W[SHA1_MAX_LANES][80];
+    unsigned int  lane, i;
+
+    if (!messages || !digests) {
+        return (SHA_NULL);
+    }
+    if (count == 0 || count > SHA1_MAX_LANES) {
+        return (SHA_BADPARAM);
+    }
+    for (lane = 0; lane < count; ++lane) {
+        if (!messages[lane] || !digests[lane]) {
+            return (SHA_NULL);
+        }
+        H[lane][0] = 0x67452301;
+        H[lane][1] = 0xEFCDAB89;
+        H[lane][2] = 0x98BADCFE;
+        H[lane][3] = 0x10325476;
+        H[lane][4] = 0xC3D2E1F0;
+    }
+
+    /* One more octet for Pad_Byte and 8 octets for the length */
+    const unsigned int blocks = (length + 8) / SHA1_BLOCKSIZE + 1;
+    for (i = 0; i < blocks; ++i) {
+        for (lane = 0; lane < count; ++lane) {
+            SHA1MultiLoadBlock(messages[lane], length, i, i + 1 == blocks,
+                               W[lane]);
+        }
+        switch (count) {
+        case 1:
+            SHA1MultiProcessBlocks<1>(H, W);
+            break;
+        case 2:
+            SHA1MultiProcessBlocks<2>(H, W);
+            break;
+        case 3:
+            SHA1MultiProcessBlocks<3>(H, W);
+            break;
+        default:
+            SHA1MultiProcessBlocks<SHA1_MAX_LANES>(H, W);
+            break;
+        }
+    }
+
+    for (lane = 0; lane < count; ++lane) {
+        for (i = 0; i < SHA1_HASHSIZE; ++i) {
+            digests[lane][i] = H[lane][i>>2] >> 8 * (3 - (i & 0x03));
+        }
+    }
+
+    return (SHA_SUCCESS);
+}
+
 } // namespace hash
 } // namespace util
 } // namespace bundy
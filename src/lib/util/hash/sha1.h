@@ -51,13 +51,15 @@ namespace hash {
 enum {
     SHA_SUCCESS = 0,
     SHA_NULL,            /* Null pointer parameter */
-    SHA_STATEERROR       /* called Input after Result */
+    SHA_STATEERROR,      /* called Input after Result */
+    SHA_BADPARAM         /* passed a bad parameter */
 };
 
 enum {
     SHA1_HASHSIZE = 20,
     SHA1_HASHBITS = 20,
-    SHA1_BLOCKSIZE = 64
+    SHA1_BLOCKSIZE = 64,
+    SHA1_MAX_LANES = 4   /* max number of messages for SHA1MultiResult */
 };
 
 /*
@@ -85,6 +87,17 @@ extern int SHA1FinalBits(SHA1Context *, const uint8_t bits,
                          unsigned int bitcount);
 extern int SHA1Result(SHA1Context *, uint8_t Message_Digest[SHA1_HASHSIZE]);
 
+/*
+ * Compute the digests of up to SHA1_MAX_LANES messages of the same
+ * length at once.  The rounds of the independent computations are
+ * interleaved so the CPU can overlap them; this is useful when many
+ * short messages need to be hashed, such as in iterated NSEC3 hashing.
+ * Each digest may share memory with the corresponding message.
+ */
+extern int SHA1MultiResult(const uint8_t* const messages[],
+                           unsigned int count, unsigned int length,
+                           uint8_t* const digests[]);
+
 } // namespace hash
 } // namespace util
 } // namespace bundy
@@ -0,0 +1,169 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LRU_HASH_TABLE_H
+#define LRU_HASH_TABLE_H 1
+
+#include <boost/intrusive/list.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+#include <cstddef>
+#include <deque>
+
+namespace bundy {
+namespace util {
+
+/// \brief A hash table of a fixed maximum number of entries.
+///
+/// This is the common part of caches that look up entries by a key and
+/// recycle the least recently used entry once they are full.  The table
+/// itself doesn't know about the keys; the \c Entry type must provide the
+/// following public members:
+/// - \c hash_ (\c size_t): the hash value of the key, set by the table.
+/// - \c hash_hook_ and \c lru_hook_
+///   (\c boost::intrusive::list_member_hook<>).
+/// - <code>bool matches(const Key& key) const</code> for each type of key
+///   passed to \c find().  It's only called for entries of the same hash.
+///
+/// The number of buckets is the smallest power of 2 not less than the
+/// maximum number of entries, so the average length of the chains is at
+/// most 1 and a bucket can be identified by masking the hash value.
+/// Entries are allocated on demand and never freed until the table is
+/// destroyed; they are kept in a deque so their addresses don't change.
+///
+/// This class is not thread safe.
+template <typename Entry>
+class LruHashTable : boost::noncopyable {
+private:
+    typedef boost::intrusive::list<
+        Entry,
+        boost::intrusive::member_hook<
+            Entry, boost::intrusive::list_member_hook<>, &Entry::hash_hook_>,
+        boost::intrusive::constant_time_size<false> > HashBucket;
+    typedef boost::intrusive::list<
+        Entry,
+        boost::intrusive::member_hook<
+            Entry, boost::intrusive::list_member_hook<>,
+            &Entry::lru_hook_> > LRUList;
+
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The maximum number of entries; must not be 0.
+    explicit LruHashTable(size_t max_entries) :
+        max_entries_(max_entries), bucket_mask_(0)
+    {
+        size_t n_buckets = 1;
+        while (n_buckets < max_entries) {
+            n_buckets <<= 1;
+        }
+        bucket_mask_ = n_buckets - 1;
+        buckets_.reset(new HashBucket[n_buckets]);
+    }
+
+    /// \brief Destructor.
+    ~LruHashTable() {
+        lru_.clear();
+        for (size_t i = 0; i <= bucket_mask_; ++i) {
+            buckets_[i].clear();
+        }
+    }
+
+    /// \brief Find the entry matching a key.
+    ///
+    /// It doesn't change the order of the entries; call \c touch() if the
+    /// entry is used.
+    ///
+    /// \param key The key passed to \c Entry::matches().
+    /// \param hash The hash value of the key.
+    /// \return The matching entry, or NULL if there's none.
+    template <typename Key>
+    Entry* find(const Key& key, size_t hash) {
+        HashBucket& bucket = getBucket(hash);
+        for (typename HashBucket::iterator it = bucket.begin();
+             it != bucket.end(); ++it) {
+            if (it->hash_ == hash && it->matches(key)) {
+                return (&*it);
+            }
+        }
+        return (NULL);
+    }
+
+    /// \brief Make the entry the most recently used one.
+    void touch(Entry& entry) {
+        lru_.erase(lru_.iterator_to(entry));
+        lru_.push_front(entry);
+    }
+
+    /// \brief Return an entry for a new key.
+    ///
+    /// If the table isn't full a new entry is allocated; otherwise the
+    /// least recently used entry is recycled, keeping its old content.
+    /// The entry becomes the most recently used one and is found by the
+    /// given hash; the caller is responsible for setting the rest of it
+    /// so it matches the new key.
+    ///
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param hash The hash value of the new key.
+    Entry& insert(size_t hash) {
+        Entry* entry;
+        if (entries_.size() < max_entries_) {
+            entries_.push_back(Entry());
+            entry = &entries_.back();
+        } else {
+            entry = &lru_.back();
+            lru_.pop_back();
+            HashBucket& old_bucket = getBucket(entry->hash_);
+            old_bucket.erase(old_bucket.iterator_to(*entry));
+        }
+        entry->hash_ = hash;
+        lru_.push_front(*entry);
+        getBucket(hash).push_front(*entry);
+        return (*entry);
+    }
+
+    /// \brief Return the number of entries allocated so far.
+    size_t getEntryCount() const {
+        return (entries_.size());
+    }
+
+    /// \brief Return the maximum number of entries.
+    size_t getMaxEntries() const {
+        return (max_entries_);
+    }
+
+private:
+    HashBucket& getBucket(size_t hash) {
+        return (buckets_[hash & bucket_mask_]);
+    }
+
+    const size_t max_entries_;
+    size_t bucket_mask_;
+    boost::scoped_array<HashBucket> buckets_;
+    LRUList lru_;               // most recently used entry first
+    std::deque<Entry> entries_;
+};
+
+} // namespace util
+} // namespace bundy
+
+#endif // LRU_HASH_TABLE_H
+
+// Local Variables:
+// mode: c++
+// End:
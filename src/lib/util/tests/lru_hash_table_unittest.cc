@@ -0,0 +1,94 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/lru_hash_table.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using bundy::util::LruHashTable;
+
+namespace {
+
+struct TestEntry {
+    TestEntry() : hash_(0) {}
+
+    bool matches(const std::string& key) const {
+        return (key_ == key);
+    }
+
+    size_t hash_;
+    std::string key_;
+
+    boost::intrusive::list_member_hook<> hash_hook_;
+    boost::intrusive::list_member_hook<> lru_hook_;
+};
+
+typedef LruHashTable<TestEntry> TestTable;
+
+TestEntry&
+insert(TestTable& table, const std::string& key, size_t hash) {
+    TestEntry& entry = table.insert(hash);
+    entry.key_ = key;
+    return (entry);
+}
+
+TEST(LruHashTableTest, find) {
+    TestTable table(4);
+    EXPECT_EQ(4, table.getMaxEntries());
+    EXPECT_EQ(0, table.getEntryCount());
+    EXPECT_TRUE(table.find(std::string("a"), 1) == NULL);
+
+    TestEntry& a = insert(table, "a", 1);
+    EXPECT_EQ(1, a.hash_);
+    EXPECT_EQ(&a, table.find(std::string("a"), 1));
+    // The hash must match as well as the key.
+    EXPECT_TRUE(table.find(std::string("a"), 5) == NULL);
+
+    // Different keys in the same bucket, even of the same hash, are found
+    // separately.
+    TestEntry& b = insert(table, "b", 5);
+    TestEntry& c = insert(table, "c", 5);
+    EXPECT_EQ(&a, table.find(std::string("a"), 1));
+    EXPECT_EQ(&b, table.find(std::string("b"), 5));
+    EXPECT_EQ(&c, table.find(std::string("c"), 5));
+    EXPECT_EQ(3, table.getEntryCount());
+}
+
+TEST(LruHashTableTest, recycle) {
+    TestTable table(2);
+    TestEntry& a = insert(table, "a", 1);
+    insert(table, "b", 2);
+
+    // Using "a" makes "b" the least recently used one, so it's recycled,
+    // with its old content, for the new key.
+    table.touch(a);
+    TestEntry& c = table.insert(3);
+    EXPECT_EQ("b", c.key_);
+    c.key_ = "c";
+    EXPECT_EQ(2, table.getEntryCount());
+    EXPECT_TRUE(table.find(std::string("b"), 2) == NULL);
+    EXPECT_EQ(&a, table.find(std::string("a"), 1));
+    EXPECT_EQ(&c, table.find(std::string("c"), 3));
+
+    // Now "a" is the least recently used one.
+    TestEntry& d = insert(table, "d", 4);
+    EXPECT_EQ(&a, &d);
+    EXPECT_TRUE(table.find(std::string("a"), 1) == NULL);
+    EXPECT_EQ(&c, table.find(std::string("c"), 3));
+    EXPECT_EQ(&d, table.find(std::string("d"), 4));
+}
+
+}
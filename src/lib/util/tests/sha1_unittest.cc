@@ -13,6 +13,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <stdint.h>
+#include <cstring>
 #include <string>
 
 #include <util/hash/sha1.h>
@@ -103,6 +104,60 @@ TEST_F(Sha1Test, Test4) {
     }
 }
 
+// SHA1MultiResult should give the same digests as the context interface
+// for any number of messages and message lengths around block boundaries.
+TEST_F(Sha1Test, multiResult) {
+    uint8_t messages[SHA1_MAX_LANES][200];
+    for (int lane = 0; lane < SHA1_MAX_LANES; ++lane) {
+        for (size_t i = 0; i < sizeof(messages[lane]); ++i) {
+            messages[lane][i] = lane * 31 + i;
+        }
+    }
+    const uint8_t* const message_ptrs[SHA1_MAX_LANES] = {
+        messages[0], messages[1], messages[2], messages[3]
+    };
+    uint8_t digests[SHA1_MAX_LANES][SHA1_HASHSIZE];
+    uint8_t* const digest_ptrs[SHA1_MAX_LANES] = {
+        digests[0], digests[1], digests[2], digests[3]
+    };
+
+    for (unsigned int length = 0; length < sizeof(messages[0]); ++length) {
+        for (unsigned int count = 1; count <= SHA1_MAX_LANES; ++count) {
+            EXPECT_EQ(0, SHA1MultiResult(message_ptrs, count, length,
+                                         digest_ptrs));
+            for (unsigned int lane = 0; lane < count; ++lane) {
+                SHA1Context sha;
+                uint8_t expected[SHA1_HASHSIZE];
+                EXPECT_EQ(0, SHA1Reset(&sha));
+                EXPECT_EQ(0, SHA1Input(&sha, messages[lane], length));
+                EXPECT_EQ(0, SHA1Result(&sha, expected));
+                EXPECT_EQ(0, memcmp(expected, digests[lane], SHA1_HASHSIZE))
+                    << "length " << length << ", count " << count;
+            }
+        }
+    }
+
+    EXPECT_EQ(SHA_BADPARAM, SHA1MultiResult(message_ptrs, 0, 1,
+                                            digest_ptrs));
+    EXPECT_EQ(SHA_BADPARAM, SHA1MultiResult(message_ptrs,
+                                            SHA1_MAX_LANES + 1, 1,
+                                            digest_ptrs));
+}
+
+// The digest can be written over the message (RFC 3174 Test1).
+TEST_F(Sha1Test, multiResultInPlace) {
+    uint8_t buffer[SHA1_HASHSIZE] = { 'a', 'b', 'c' };
+    const uint8_t* const message = buffer;
+    uint8_t* const digest = buffer;
+    const uint8_t expected[SHA1_HASHSIZE] = {
+        0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+        0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d
+    };
+
+    EXPECT_EQ(0, SHA1MultiResult(&message, 1, 3, &digest));
+    EXPECT_EQ(0, memcmp(expected, buffer, SHA1_HASHSIZE));
+}
+
 } // namespace hash
 } // namespace util
 } // namespace bundy
@@ -199,6 +199,76 @@ Mutex::unlock() {
     assert(result == 0); // This should never be possible
 }
 
+class RWMutex::Impl {
+public:
+    pthread_rwlock_t rwlock;
+};
+
+RWMutex::RWMutex() :
+    impl_(NULL)
+{
+    pthread_rwlockattr_t attributes;
+    int result = pthread_rwlockattr_init(&attributes);
+    switch (result) {
+        case 0: // All 0K
+            break;
+        case ENOMEM:
+            throw std::bad_alloc();
+        default:
+            bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+
+    // By default, glibc lets new readers in while a writer is waiting,
+    // which can starve the writer under a constant read load.  (The kind
+    // constants are enum values, not macros, so we check for glibc.)
+#ifdef __GLIBC__
+    result = pthread_rwlockattr_setkind_np(
+        &attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    assert(result == 0);
+#endif
+
+    unique_ptr<Impl> impl(new Impl);
+    result = pthread_rwlock_init(&impl->rwlock, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+    switch (result) {
+        case 0: // All 0K
+            impl_ = impl.release();
+            break;
+        case ENOMEM:
+        case EAGAIN:
+            throw std::bad_alloc();
+        default:
+            bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+}
+
+RWMutex::~RWMutex() {
+    if (impl_ != NULL) {
+        const int result = pthread_rwlock_destroy(&impl_->rwlock);
+        delete impl_;
+        // We don't want to throw from the destructor, and this should
+        // only fail if the lock is still held.
+        assert(result == 0);
+    }
+}
+
+void
+RWMutex::lock(bool exclusive) {
+    assert(impl_ != NULL);
+    const int result = exclusive ? pthread_rwlock_wrlock(&impl_->rwlock) :
+        pthread_rwlock_rdlock(&impl_->rwlock);
+    if (result != 0) {
+        bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+}
+
+void
+RWMutex::unlock() {
+    assert(impl_ != NULL);
+    const int result = pthread_rwlock_unlock(&impl_->rwlock);
+    assert(result == 0); // This should never be possible
+}
+
 class CondVar::Impl {
 public:
     Impl() {
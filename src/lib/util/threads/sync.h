@@ -170,6 +170,91 @@ private:
     Impl* impl_;
 };
 
+/// \brief Readers-writer lock.
+///
+/// This is a lock that can be held by any number of readers at the same
+/// time, or by a single writer.  It's meant for data that is read very
+/// often by several threads and rarely modified: readers don't block
+/// each other, and only wait while a writer holds the lock.
+///
+/// Like \c Mutex, it's locked and unlocked by creating and destroying
+/// a locker object: \c ReaderLocker for shared access, and \c Locker for
+/// exclusive access (the name allows code templated on the mutex type to
+/// work with either this class or \c Mutex for the exclusive case).
+///
+/// A writer waiting for the lock takes precedence over new readers with
+/// glibc (elsewhere it depends on the system's default policy), so a
+/// steady flow of readers can't keep writers out forever.  As a result, a thread must not acquire a reader lock
+/// while it already holds one of the same object; that can deadlock with
+/// a waiting writer.
+///
+/// Errors are handled in the same way as in \c Mutex.
+class RWMutex : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc In case allocation of something (memory, the
+    ///     OS lock) fails.
+    /// \throw bundy::InvalidOperation Other unspecified errors.
+    RWMutex();
+
+    /// \brief Destructor.
+    ///
+    /// It is not allowed to destroy a lock which is currently held.
+    ~RWMutex();
+
+    /// \brief This holds an exclusive (writer) lock on a RWMutex.
+    class Locker : boost::noncopyable {
+    public:
+        /// \brief Constructor.
+        ///
+        /// Waits until no reader or other writer holds the lock.
+        ///
+        /// \throw bundy::InvalidOperation when OS reports error.
+        Locker(RWMutex& mutex) : mutex_(mutex) {
+            mutex_.lock(true);
+        }
+
+        /// \brief Destructor.
+        ///
+        /// Unlocks the lock.
+        ~Locker() {
+            mutex_.unlock();
+        }
+    private:
+        RWMutex& mutex_;
+    };
+
+    /// \brief This holds a shared (reader) lock on a RWMutex.
+    class ReaderLocker : boost::noncopyable {
+    public:
+        /// \brief Constructor.
+        ///
+        /// Waits only while a writer holds, or waits for, the lock.
+        ///
+        /// \throw bundy::InvalidOperation when OS reports error.
+        ReaderLocker(RWMutex& mutex) : mutex_(mutex) {
+            mutex_.lock(false);
+        }
+
+        /// \brief Destructor.
+        ///
+        /// Unlocks the lock.
+        ~ReaderLocker() {
+            mutex_.unlock();
+        }
+    private:
+        RWMutex& mutex_;
+    };
+
+private:
+    void lock(bool exclusive);
+    void unlock();
+
+    class Impl;
+    Impl* impl_;
+};
+
 /// \brief Encapsulation for a condition variable.
 ///
 /// This class provides a simple encapsulation of condition variable for
@@ -21,6 +21,7 @@
 #include <util/unittests/check_valgrind.h>
 
 #include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <unistd.h>
 #include <signal.h>
 
@@ -117,9 +118,10 @@ TEST(MutexTest,
 // atomic operation, at least on common architectures.
 const size_t iterations = 100000;
 
+template <typename MutexType>
 void
 performIncrement(volatile double* canary, volatile bool* ready_me,
-                 volatile bool* ready_other, Mutex* mutex)
+                 volatile bool* ready_other, MutexType* mutex)
 {
     // Loosely (busy) wait for the other thread so both will start
     // approximately at the same time.
@@ -127,7 +129,7 @@ performIncrement(volatile double* canary, volatile bool* ready_me,
     while (!*ready_other) {}
 
     for (size_t i = 0; i < iterations; ++i) {
-        Mutex::Locker lock(*mutex);
+        typename MutexType::Locker lock(*mutex);
         *canary += 1;
     }
 }
@@ -135,7 +137,9 @@ performIncrement(volatile double* canary, volatile bool* ready_me,
 void
 noHandler(int) {}
 
-TEST(MutexTest, swarm) {
+template <typename MutexType>
+void
+runSwarm() {
     if (!bundy::util::unittests::runningOnValgrind()) {
         // Create a timeout in case something got stuck here
         struct sigaction ignored, original;
@@ -148,14 +152,14 @@ TEST(MutexTest, swarm) {
         // This type has a low chance of being atomic itself, further raising
         // the chance of problems appearing.
         double canary = 0;
-        Mutex mutex;
+        MutexType mutex;
         // Run two parallel threads
         bool ready1 = false;
         bool ready2 = false;
-        Thread t1(boost::bind(&performIncrement, &canary, &ready1, &ready2,
-                              &mutex));
-        Thread t2(boost::bind(&performIncrement, &canary, &ready2, &ready1,
-                              &mutex));
+        Thread t1(boost::bind(&performIncrement<MutexType>, &canary,
+                              &ready1, &ready2, &mutex));
+        Thread t2(boost::bind(&performIncrement<MutexType>, &canary,
+                              &ready2, &ready1, &mutex));
         t1.wait();
         t2.wait();
         // Check it the sum is the expected value.
@@ -168,4 +172,65 @@ TEST(MutexTest, swarm) {
     }
 }
 
+TEST(MutexTest, swarm) {
+    runSwarm<Mutex>();
+}
+
+// The exclusive lock of RWMutex really locks, too.
+TEST(RWMutexTest, swarm) {
+    runSwarm<RWMutex>();
+}
+
+void
+readWhileLocked(RWMutex* mutex, bool* done) {
+    RWMutex::ReaderLocker locker(*mutex);
+    *done = true;
+}
+
+// Readers don't block each other.  If they did, this would hang.
+TEST(RWMutexTest, sharedReaders) {
+    RWMutex mutex;
+    RWMutex::ReaderLocker locker(mutex);
+    bool done = false;
+    Thread thread(boost::bind(&readWhileLocked, &mutex, &done));
+    thread.wait();
+    EXPECT_TRUE(done);
+}
+
+#ifdef __GLIBC__
+void
+writeWhileLocked(RWMutex* mutex, bool* done) {
+    RWMutex::Locker locker(*mutex);
+    *done = true;
+}
+
+void
+readAfterWriter(RWMutex* mutex, const bool* writer_done, bool* writer_first) {
+    RWMutex::ReaderLocker locker(*mutex);
+    *writer_first = *writer_done;
+}
+
+// A writer waiting for the lock keeps new readers out, so they get the
+// lock only after the writer.
+TEST(RWMutexTest, writerPreferred) {
+    RWMutex mutex;
+    bool writer_done = false;
+    bool writer_first = false;
+    boost::scoped_ptr<RWMutex::ReaderLocker> locker(
+        new RWMutex::ReaderLocker(mutex));
+    Thread writer(boost::bind(&writeWhileLocked, &mutex, &writer_done));
+    // Give the writer time to start waiting for the lock.
+    usleep(100000);
+    Thread reader(boost::bind(&readAfterWriter, &mutex, &writer_done,
+                              &writer_first));
+    usleep(100000);
+    EXPECT_FALSE(writer_done);
+    locker.reset();
+    writer.wait();
+    reader.wait();
+    EXPECT_TRUE(writer_done);
+    EXPECT_TRUE(writer_first);
+}
+#endif
+
 }
@@ -0,0 +1,402 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/indexed_by.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include "memfile_index_ubench.h"
+
+using namespace std;
+using namespace boost::multi_index;
+
+namespace {
+
+/// Number of subnets the leases are spread over.
+const uint32_t NUM_SUBNETS = 16;
+
+/// @brief Structure of the Lease4 that is kept in memory
+struct Lease4 {
+    uint32_t addr; /// IPv4 address
+    std::vector<uint8_t> hwaddr; /// hardware address
+    std::vector<uint8_t> client_id; /// client-identifier
+    uint32_t subnet_id; /// ID of the subnet the lease belongs to
+    uint32_t valid_lft; /// valid lifetime timestamp
+    time_t cltt; /// client last transmission time
+};
+
+/// Pointer to a Lease4 structure
+typedef boost::shared_ptr<Lease4> Lease4Ptr;
+
+/// @brief Returns the hardware address of the n-th client.
+std::vector<uint8_t> getHWAddr(uint32_t n) {
+    std::vector<uint8_t> hwaddr(6);
+    hwaddr[0] = 0x08;
+    hwaddr[1] = 0x00;
+    hwaddr[2] = n >> 24;
+    hwaddr[3] = n >> 16;
+    hwaddr[4] = n >> 8;
+    hwaddr[5] = n;
+    return (hwaddr);
+}
+
+/// @brief Returns the client identifier of the n-th client.
+///
+/// As most clients do, it uses the hardware type and address.
+std::vector<uint8_t> getClientId(uint32_t n) {
+    std::vector<uint8_t> client_id = getHWAddr(n);
+    client_id.insert(client_id.begin(), 1);
+    return (client_id);
+}
+
+/// @brief Returns the subnet of the n-th client.
+uint32_t getSubnetId(uint32_t n) {
+    return (1 + n % NUM_SUBNETS);
+}
+
+/// Key extractor for the (hardware address, subnet) index.
+typedef composite_key<
+    Lease4,
+    member<Lease4, std::vector<uint8_t>, &Lease4::hwaddr>,
+    member<Lease4, uint32_t, &Lease4::subnet_id>
+> HWAddrSubnetKey;
+
+/// Key extractor for the (client identifier, subnet) index.
+typedef composite_key<
+    Lease4,
+    member<Lease4, std::vector<uint8_t>, &Lease4::client_id>,
+    member<Lease4, uint32_t, &Lease4::subnet_id>
+> ClientIdSubnetKey;
+
+/// Lease container with ordered secondary indexes, as the memfile lease
+/// manager had before.
+typedef multi_index_container<
+    Lease4Ptr,
+    indexed_by<
+        ordered_unique<member<Lease4, uint32_t, &Lease4::addr> >,
+        ordered_unique<HWAddrSubnetKey>,
+        ordered_non_unique<ClientIdSubnetKey>
+    >
+> OrderedLease4Storage;
+
+/// Lease container with hashed secondary indexes, as the memfile lease
+/// manager has now.
+typedef multi_index_container<
+    Lease4Ptr,
+    indexed_by<
+        ordered_unique<member<Lease4, uint32_t, &Lease4::addr> >,
+        hashed_unique<HWAddrSubnetKey>,
+        hashed_non_unique<ClientIdSubnetKey>
+    >
+> HashedLease4Storage;
+
+}
+
+/// @brief In-memory database with secondary indexes
+///
+/// This is the interface used by the benchmark. The implementation,
+/// memfile_index_LeaseMgrImpl, is specific to the container type.
+class memfile_index_LeaseMgr {
+public:
+
+    /// @brief Destructor
+    virtual ~memfile_index_LeaseMgr() {}
+
+    /// @brief adds a lease to the container
+    ///
+    /// @param lease lease to be added
+    virtual bool addLease(const Lease4Ptr& lease) = 0;
+
+    /// @brief returns existing lease for the hardware address and subnet
+    ///
+    /// @param hwaddr hardware address of the client
+    /// @param subnet_id identifier of the subnet
+    ///
+    /// @return smart pointer to the lease (or NULL if lease is not found)
+    virtual Lease4Ptr getLease(const std::vector<uint8_t>& hwaddr,
+                               uint32_t subnet_id) = 0;
+
+    /// @brief returns existing lease for the client identifier and subnet
+    ///
+    /// @param client_id client identifier
+    /// @param subnet_id identifier of the subnet
+    ///
+    /// @return smart pointer to the lease (or NULL if lease is not found)
+    virtual Lease4Ptr getLeaseByClientId(const std::vector<uint8_t>& client_id,
+                                         uint32_t subnet_id) = 0;
+
+    /// @brief Simplified lease update.
+    ///
+    /// Searches for a lease and replaces it with a copy that has the new
+    /// client last transmission time, as the memfile lease manager does.
+    ///
+    /// @param addr IPv4 address
+    /// @param new_cltt New client last transmission time
+    ///
+    /// @return true if the lease was updated, false if it was not found
+    virtual bool updateLease(uint32_t addr, time_t new_cltt) = 0;
+
+    /// @brief Deletes a lease.
+    ///
+    /// @param addr IPv4 address of the lease to be deleted.
+    ///
+    /// @return true if deletion was successful, false if no such lease exists
+    virtual bool deleteLease(uint32_t addr) = 0;
+};
+
+namespace {
+
+/// @brief memfile_index_LeaseMgr implementation for the container type
+template<typename Storage>
+class memfile_index_LeaseMgrImpl : public memfile_index_LeaseMgr {
+public:
+
+    virtual bool addLease(const Lease4Ptr& lease) {
+        return (storage_.insert(lease).second);
+    }
+
+    virtual Lease4Ptr getLease(const std::vector<uint8_t>& hwaddr,
+                               uint32_t subnet_id) {
+        const typename Storage::template nth_index<1>::type& idx =
+            storage_.template get<1>();
+        typename Storage::template nth_index<1>::type::const_iterator x =
+            idx.find(boost::make_tuple(hwaddr, subnet_id));
+        if (x != idx.end()) {
+            return (*x);
+        }
+        return (Lease4Ptr());
+    }
+
+    virtual Lease4Ptr getLeaseByClientId(const std::vector<uint8_t>& client_id,
+                                         uint32_t subnet_id) {
+        const typename Storage::template nth_index<2>::type& idx =
+            storage_.template get<2>();
+        typename Storage::template nth_index<2>::type::const_iterator x =
+            idx.find(boost::make_tuple(client_id, subnet_id));
+        if (x != idx.end()) {
+            return (*x);
+        }
+        return (Lease4Ptr());
+    }
+
+    virtual bool updateLease(uint32_t addr, time_t new_cltt) {
+        typename Storage::iterator x = storage_.find(addr);
+        if (x == storage_.end()) {
+            return (false);
+        }
+        Lease4Ptr lease(new Lease4(**x));
+        lease->cltt = new_cltt;
+        return (storage_.replace(x, lease));
+    }
+
+    virtual bool deleteLease(uint32_t addr) {
+        return (storage_.erase(addr) > 0);
+    }
+
+private:
+
+    /// The leases.
+    Storage storage_;
+};
+
+}
+
+memfile_index_uBenchmark::memfile_index_uBenchmark(uint32_t num_iterations,
+                                                   bool hashed,
+                                                   bool verbose)
+    :uBenchmark(num_iterations, "", false, verbose), hashed_(hashed),
+     leaseMgr_(NULL) {
+}
+
+void memfile_index_uBenchmark::connect() {
+    if (hashed_) {
+        leaseMgr_ = new memfile_index_LeaseMgrImpl<HashedLease4Storage>();
+    } else {
+        leaseMgr_ = new memfile_index_LeaseMgrImpl<OrderedLease4Storage>();
+    }
+}
+
+void memfile_index_uBenchmark::disconnect() {
+    delete leaseMgr_;
+    leaseMgr_ = NULL;
+}
+
+void memfile_index_uBenchmark::createLease4Test() {
+    if (!leaseMgr_) {
+        throw "No LeaseMgr instantiated.";
+    }
+
+    uint32_t addr = BASE_ADDR4;     // Let's start with 1.0.0.0 address
+    uint32_t valid_lft = 1000;      // We can use the same value for all leases
+    time_t cltt = time(NULL);       // Timestamp
+
+    cout << "CREATE:   ";
+
+    for (uint32_t i = 0; i < num_; ++i) {
+
+        cltt++;
+
+        Lease4Ptr lease(new Lease4());
+        lease->addr = addr;
+        lease->hwaddr = getHWAddr(i);
+        lease->client_id = getClientId(i);
+        lease->subnet_id = getSubnetId(i);
+        lease->valid_lft = valid_lft;
+        lease->cltt = cltt;
+
+        if (!leaseMgr_->addLease(lease)) {
+            failure("addLease() failed");
+        } else {
+            if (verbose_) {
+                cout << ".";
+            }
+        }
+
+        addr++;
+    }
+    cout << endl;
+}
+
+void memfile_index_uBenchmark::searchLease4Test() {
+    if (!leaseMgr_) {
+        throw "No LeaseMgr instantiated.";
+    }
+
+    // The keys are generated up front, so only the searches are timed.
+    vector<uint32_t> clients(num_);
+    for (uint32_t i = 0; i < num_; i++) {
+        clients[i] = random() % int(num_ / hitratio_);
+    }
+    vector<vector<uint8_t> > hwaddrs(num_);
+    vector<vector<uint8_t> > client_ids(num_);
+    for (uint32_t i = 0; i < num_; i++) {
+        hwaddrs[i] = getHWAddr(clients[i]);
+        client_ids[i] = getClientId(clients[i]);
+    }
+
+    cout << "RETRIEVE: ";
+
+    struct timespec before = getTime();
+    for (uint32_t i = 0; i < num_; i++) {
+        Lease4Ptr lease = leaseMgr_->getLease(hwaddrs[i],
+                                              getSubnetId(clients[i]));
+        if (verbose_) {
+            cout << (lease?".":"X");
+        }
+    }
+    struct timespec after = getTime();
+
+    for (uint32_t i = 0; i < num_; i++) {
+        Lease4Ptr lease = leaseMgr_->getLeaseByClientId(client_ids[i],
+                                                        getSubnetId(clients[i]));
+        if (verbose_) {
+            cout << (lease?".":"X");
+        }
+    }
+    struct timespec end = getTime();
+
+    cout << endl;
+
+    printClock("Search leases4 by hwaddr", num_, before, after);
+    printClock("Search leases4 by client-id", num_, after, end);
+}
+
+void memfile_index_uBenchmark::updateLease4Test() {
+    if (!leaseMgr_) {
+        throw "No LeaseMgr instantiated.";
+    }
+
+    cout << "UPDATE:   ";
+
+    time_t cltt = time(NULL);
+
+    for (uint32_t i = 0; i < num_; i++) {
+
+        uint32_t x = BASE_ADDR4 + random() % num_;
+
+        if (!leaseMgr_->updateLease(x, cltt)) {
+            stringstream tmp;
+            tmp << "UPDATE failed for lease " << hex << x << dec;
+            failure(tmp.str().c_str());
+        }
+        if (verbose_) {
+            cout << ".";
+        }
+    }
+
+    cout << endl;
+}
+
+void memfile_index_uBenchmark::deleteLease4Test() {
+    if (!leaseMgr_) {
+        throw "No LeaseMgr instantiated.";
+    }
+
+    cout << "DELETE:   ";
+
+    for (uint32_t i = 0; i < num_; i++) {
+
+        uint32_t x = BASE_ADDR4 + i;
+
+        if (!leaseMgr_->deleteLease(x)) {
+            stringstream tmp;
+            tmp << "DELETE failed for lease " << hex << x << dec;
+            failure(tmp.str().c_str());
+        }
+        if (verbose_) {
+            cout << ".";
+        }
+    }
+
+    cout << endl;
+}
+
+void memfile_index_uBenchmark::printInfo() {
+    cout << "Memory db (using boost::multi_index with "
+         << (hashed_ ? "hashed" : "ordered")
+         << " hwaddr and client-id indexes)." << endl;
+}
+
+
+int main(int argc, char * const argv[]) {
+
+    uint32_t num = 2000000;
+    bool verbose = false;
+
+    // Run the same benchmark for both kinds of indexes.
+    memfile_index_uBenchmark ordered(num, false, verbose);
+    ordered.parseCmdline(argc, argv);
+    ordered.printInfo();
+    int result = ordered.run();
+    if (result != 0) {
+        return (result);
+    }
+
+    cout << endl;
+
+    memfile_index_uBenchmark hashed(num, true, verbose);
+    optind = 1;
+    hashed.parseCmdline(argc, argv);
+    hashed.printInfo();
+    result = hashed.run();
+
+    return (result);
+}
@@ -0,0 +1,84 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <stdint.h>
+#include "benchmark.h"
+
+/// an implementation of the lease containers with the secondary indexes
+/// The actual implementation is in memfile_index_ubench.cc
+class memfile_index_LeaseMgr;
+
+/// @brief Memfile secondary index micro-benchmark.
+///
+/// That is a specific backend implementation. See \ref uBenchmark class for
+/// detailed explanation of its operations. This class keeps the leases in
+/// a boost::multi_index container with the same secondary indexes as the
+/// Lease4Storage of the memfile lease manager: (hardware address, subnet)
+/// and (client identifier, subnet). Leases are searched by these keys
+/// rather than by the address, as the server does when a client sends a
+/// DHCPDISCOVER or DHCPREQUEST. The indexes are either ordered (a search
+/// compares a logarithmic number of hardware addresses or client identifiers)
+/// or hashed (a search computes one hash), so the two can be compared with
+/// a large number of leases. Nothing is written to disk.
+class memfile_index_uBenchmark: public uBenchmark {
+public:
+
+    /// @brief The sole memfile index benchmark constructor.
+    ///
+    /// @param num_iterations number of iterations
+    /// @param hashed should the secondary indexes be hashed (or ordered)?
+    /// @param verbose would you like extra logging?
+    memfile_index_uBenchmark(uint32_t num_iterations, bool hashed,
+                             bool verbose);
+
+    /// @brief Prints backend info.
+    virtual void printInfo();
+
+    /// @brief Spawns lease manager with an empty container.
+    virtual void connect();
+
+    /// @brief Deletes lease manager with all its leases.
+    virtual void disconnect();
+
+    /// @brief Creates new leases.
+    ///
+    /// See uBenchmark::createLease4Test() for detailed explanation.
+    virtual void createLease4Test();
+
+    /// @brief Searches for existing leases.
+    ///
+    /// Searches num_ times by the hardware address and subnet and then
+    /// num_ times by the client identifier and subnet, and prints the
+    /// time of each. See uBenchmark::searchLease4Test() for detailed
+    /// explanation.
+    virtual void searchLease4Test();
+
+    /// @brief Updates existing leases.
+    ///
+    /// See uBenchmark::updateLease4Test() for detailed explanation.
+    virtual void updateLease4Test();
+
+    /// @brief Deletes existing leases.
+    ///
+    /// See uBenchmark::deleteLease4Test() for detailed explanation.
+    virtual void deleteLease4Test();
+
+protected:
+
+    /// Should the secondary indexes be hashed?
+    bool hashed_;
+
+    /// Lease Manager (concrete backend implementation, based on multi_index)
+    memfile_index_LeaseMgr * leaseMgr_;
+};